@@ -0,0 +1,176 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/common/atomics.h>
+#include <aws/common/clock.h>
+#include <aws/common/mutex.h>
+#include <aws/common/thread.h>
+#include <aws/http/private/h1_connection.h>
+#include <aws/http/private/h2_connection.h>
+#include <aws/http/private/h2_stream.h>
+
+#include <stdio.h>
+
+/**
+ * One thread plays the event-loop, incrementing a field at the end of `thread_data` a fixed number of times.
+ * Meanwhile another thread plays a user thread, taking the struct's real `synced_data.lock` and writing a field
+ * in `synced_data` as fast as it can, the way the real code does.
+ * If the lock or that field share a cache line with the event-loop's field, every write on one side evicts the line
+ * from the other core, and the event-loop side slows down considerably.
+ *
+ * Only each struct's lock is initialized, otherwise only the memory layout matters here.
+ * The control case puts the event-loop's field right next to the lock and the synced field.
+ */
+
+struct false_sharing_control {
+    uint64_t thread_side;
+    uint64_t synced_side;
+    struct aws_mutex lock;
+};
+
+struct false_sharing_case {
+    const char *name;
+    volatile void *thread_side;
+    size_t thread_side_size;
+    struct aws_mutex *lock;
+    volatile size_t *synced_side;
+};
+
+struct false_sharing_writer {
+    struct aws_mutex *lock;
+    volatile size_t *synced_side;
+    struct aws_atomic_var stop;
+};
+
+static void s_increment(volatile void *field, size_t size) {
+    if (size == sizeof(uint32_t)) {
+        *(volatile uint32_t *)field += 1;
+    } else {
+        *(volatile uint64_t *)field += 1;
+    }
+}
+
+static void s_writer_thread(void *user_data) {
+    struct false_sharing_writer *writer = user_data;
+    while (!aws_atomic_load_int(&writer->stop)) {
+        for (size_t i = 0; i < 1024; ++i) {
+            aws_mutex_lock(writer->lock);
+            *writer->synced_side += 1;
+            aws_mutex_unlock(writer->lock);
+        }
+    }
+}
+
+static int s_run_case(struct aws_allocator *allocator, const struct false_sharing_case *test_case, size_t iterations) {
+    struct false_sharing_writer writer = {
+        .lock = test_case->lock,
+        .synced_side = test_case->synced_side,
+    };
+    aws_atomic_init_int(&writer.stop, 0);
+
+    struct aws_thread thread;
+    if (aws_thread_init(&thread, allocator)) {
+        return AWS_OP_ERR;
+    }
+    if (aws_thread_launch(&thread, s_writer_thread, &writer, NULL)) {
+        aws_thread_clean_up(&thread);
+        return AWS_OP_ERR;
+    }
+
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    for (size_t i = 0; i < iterations; ++i) {
+        s_increment(test_case->thread_side, test_case->thread_side_size);
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    aws_atomic_store_int(&writer.stop, 1);
+    aws_thread_join(&thread);
+    aws_thread_clean_up(&thread);
+
+    /* The lock is the closest thing the user thread writes */
+    const uintptr_t thread_side = (uintptr_t)test_case->thread_side;
+    const uintptr_t lock = (uintptr_t)test_case->lock;
+    const size_t distance = (size_t)(lock > thread_side ? lock - thread_side : thread_side - lock);
+    printf(
+        "  %-22s lock distance=%4zu bytes  %8.3f ns/write\n",
+        test_case->name,
+        distance,
+        (double)(end_ns - start_ns) / (double)iterations);
+
+    return AWS_OP_SUCCESS;
+}
+
+int httpbench_false_sharing(struct aws_allocator *allocator, size_t iterations) {
+    struct false_sharing_control *control = aws_mem_calloc(allocator, 1, sizeof(struct false_sharing_control));
+    struct aws_h1_connection *h1_connection = aws_mem_calloc(allocator, 1, sizeof(struct aws_h1_connection));
+    struct aws_h2_connection *h2_connection = aws_mem_calloc(allocator, 1, sizeof(struct aws_h2_connection));
+    struct aws_h2_stream *h2_stream = aws_mem_calloc(allocator, 1, sizeof(struct aws_h2_stream));
+
+    struct aws_mutex *locks[] = {
+        &control->lock,
+        &h1_connection->synced_data.lock,
+        &h2_connection->synced_data.lock,
+        &h2_stream->synced_data.lock,
+    };
+    size_t locks_initialized = 0;
+    int result = AWS_OP_SUCCESS;
+    for (; locks_initialized < AWS_ARRAY_SIZE(locks) && !result; ++locks_initialized) {
+        result = aws_mutex_init(locks[locks_initialized]);
+    }
+    if (result) {
+        /* The lock that failed to init doesn't need clean up */
+        --locks_initialized;
+        goto done;
+    }
+
+    const struct false_sharing_case cases[] = {
+        {
+            .name = "control (same line)",
+            .thread_side = &control->thread_side,
+            .thread_side_size = sizeof(control->thread_side),
+            .lock = &control->lock,
+            .synced_side = (volatile size_t *)&control->synced_side,
+        },
+        {
+            .name = "aws_h1_connection",
+            .thread_side = &h1_connection->thread_data.incoming_stream_timestamp_ns,
+            .thread_side_size = sizeof(h1_connection->thread_data.incoming_stream_timestamp_ns),
+            .lock = &h1_connection->synced_data.lock,
+            .synced_side = &h1_connection->synced_data.window_update_size,
+        },
+        {
+            .name = "aws_h2_connection",
+            .thread_side = &h2_connection->thread_data.abuse_counters.ping.current_count,
+            .thread_side_size = sizeof(h2_connection->thread_data.abuse_counters.ping.current_count),
+            .lock = &h2_connection->synced_data.lock,
+            .synced_side = &h2_connection->synced_data.window_update_size,
+        },
+        {
+            .name = "aws_h2_stream",
+            .thread_side = &h2_stream->thread_data.pending_body_window_update,
+            .thread_side_size = sizeof(h2_stream->thread_data.pending_body_window_update),
+            .lock = &h2_stream->synced_data.lock,
+            .synced_side = &h2_stream->synced_data.window_update_size,
+        },
+    };
+
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(cases) && !result; ++i) {
+        result = s_run_case(allocator, &cases[i], iterations);
+    }
+
+done:
+    for (size_t i = 0; i < locks_initialized; ++i) {
+        aws_mutex_clean_up(locks[i]);
+    }
+
+    aws_mem_release(allocator, h2_stream);
+    aws_mem_release(allocator, h2_connection);
+    aws_mem_release(allocator, h1_connection);
+    aws_mem_release(allocator, control);
+    return result;
+}
@@ -0,0 +1,180 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/common/clock.h>
+#include <aws/http/private/h1_decoder.h>
+
+#include <stdio.h>
+
+/**
+ * Decodes the same response head over and over, delivered to the decoder in differently sized reads.
+ *
+ * `one read` hands the decoder the whole head at once, so every line is processed straight out of the input
+ * in a single pass. `line per read` hands it one complete line at a time, so each line after the status-line
+ * goes through s_state_getline, the way every line used to. `16-byte reads` split lines across reads,
+ * so partial lines are buffered in the scratch_space before they're processed.
+ */
+
+struct h1_decode_head {
+    const char *name;
+    const char *text;
+};
+
+struct h1_decode_counts {
+    size_t headers;
+    size_t messages;
+};
+
+static int s_on_header(const struct aws_h1_decoded_header *header, void *user_data) {
+    (void)header;
+    struct h1_decode_counts *counts = user_data;
+    counts->headers++;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_on_response(int status_code, void *user_data) {
+    (void)status_code;
+    (void)user_data;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_on_body(const struct aws_byte_cursor *data, bool finished, void *user_data) {
+    (void)data;
+    (void)finished;
+    (void)user_data;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_on_done(void *user_data) {
+    struct h1_decode_counts *counts = user_data;
+    counts->messages++;
+    return AWS_OP_SUCCESS;
+}
+
+/* Returns the length of the next read. 0 means split on line endings */
+static size_t s_next_read_length(struct aws_byte_cursor remaining, size_t read_size) {
+    if (read_size != 0) {
+        return aws_min_size(read_size, remaining.len);
+    }
+
+    for (size_t i = 0; i < remaining.len; ++i) {
+        if (remaining.ptr[i] == '\n') {
+            return i + 1;
+        }
+    }
+    return remaining.len;
+}
+
+static int s_run_case(
+    struct aws_allocator *allocator,
+    const struct h1_decode_head *head,
+    const char *read_name,
+    size_t read_size,
+    size_t iterations) {
+
+    struct h1_decode_counts counts = {0};
+    struct aws_h1_decoder_params params = {
+        .alloc = allocator,
+        .scratch_space_initial_size = 256,
+        .is_decoding_requests = false,
+        .user_data = &counts,
+        .vtable =
+            {
+                .on_header = s_on_header,
+                .on_body = s_on_body,
+                .on_response = s_on_response,
+                .on_done = s_on_done,
+            },
+    };
+    struct aws_h1_decoder *decoder = aws_h1_decoder_new(&params);
+    if (!decoder) {
+        return AWS_OP_ERR;
+    }
+
+    const struct aws_byte_cursor message = aws_byte_cursor_from_c_str(head->text);
+    int result = AWS_OP_ERR;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    for (size_t i = 0; i < iterations; ++i) {
+        struct aws_byte_cursor remaining = message;
+        while (remaining.len > 0) {
+            struct aws_byte_cursor read = aws_byte_cursor_advance(&remaining, s_next_read_length(remaining, read_size));
+            while (read.len > 0) {
+                if (aws_h1_decode(decoder, &read)) {
+                    goto done;
+                }
+            }
+        }
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    if (counts.messages != iterations) {
+        fprintf(stderr, "decoded %zu messages, expected %zu\n", counts.messages, iterations);
+        aws_raise_error(AWS_ERROR_INVALID_STATE);
+        goto done;
+    }
+
+    const double elapsed_ns = (double)(end_ns - start_ns);
+    printf(
+        "  %-12s %-14s %8.1f ns/message  %6.1f ns/header  %8.1f MB/s\n",
+        head->name,
+        read_name,
+        elapsed_ns / (double)iterations,
+        elapsed_ns / (double)counts.headers,
+        (double)(message.len * iterations) * 1000.0 / elapsed_ns);
+    result = AWS_OP_SUCCESS;
+
+done:
+    aws_h1_decoder_destroy(decoder);
+    return result;
+}
+
+int httpbench_h1_decode(struct aws_allocator *allocator, size_t iterations) {
+    const struct h1_decode_head heads[] = {
+        {
+            .name = "small head",
+            .text = "HTTP/1.1 200 OK\r\n"
+                    "Date: Mon, 19 Oct 2026 00:00:00 GMT\r\n"
+                    "Content-Length: 0\r\n"
+                    "\r\n",
+        },
+        {
+            .name = "SDK head",
+            .text = "HTTP/1.1 200 OK\r\n"
+                    "Date: Mon, 19 Oct 2026 00:00:00 GMT\r\n"
+                    "Content-Type: application/x-amz-json-1.1\r\n"
+                    "Content-Length: 0\r\n"
+                    "Connection: keep-alive\r\n"
+                    "x-amzn-RequestId: 6f0c2d9e-8a4b-4f3c-9d1e-2b7a5c8e0f41\r\n"
+                    "x-amz-id-2: Yl2r5vTq8mXcB0nH3kJ6pW9sD1fG4aZ7eU2iO5yR8tL0qN3vC6xM9bK1jH4gF7dS\r\n"
+                    "x-amz-request-id: 2A8F4C6E1B3D5F70\r\n"
+                    "x-amz-version-id: 3HL4kqtJlcpXroDTDmJ-rmSpXd3dIbrHY\r\n"
+                    "ETag: \"d41d8cd98f00b204e9800998ecf8427e\"\r\n"
+                    "Last-Modified: Sun, 18 Oct 2026 23:59:59 GMT\r\n"
+                    "Cache-Control: no-cache\r\n"
+                    "Server: AmazonS3\r\n"
+                    "\r\n",
+        },
+    };
+    const struct {
+        const char *name;
+        size_t read_size;
+    } reads[] = {
+        {.name = "one read", .read_size = SIZE_MAX},
+        {.name = "line per read", .read_size = 0},
+        {.name = "16-byte reads", .read_size = 16},
+    };
+
+    for (size_t h = 0; h < AWS_ARRAY_SIZE(heads); ++h) {
+        for (size_t r = 0; r < AWS_ARRAY_SIZE(reads); ++r) {
+            if (s_run_case(allocator, &heads[h], reads[r].name, reads[r].read_size, iterations)) {
+                return AWS_OP_ERR;
+            }
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
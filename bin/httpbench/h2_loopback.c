@@ -0,0 +1,750 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/common/clock.h>
+#include <aws/http/private/connection_impl.h>
+#include <aws/http/private/h2_connection.h>
+#include <aws/http/private/h2_decoder.h>
+#include <aws/http/private/h2_frames.h>
+#include <aws/http/request_response.h>
+#include <aws/io/stream.h>
+#include <aws/testing/aws_test_harness.h>
+#include <aws/testing/io_testing_channel.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Runs a real HTTP/2 client connection against an in-memory peer, with no sockets, TLS, or kernel involved.
+ *
+ * The client aws_h2_connection is installed in a testing_channel, whose event loop is ticked by hand.
+ * aws-c-http has no HTTP/2 server connection yet, so the peer is built from the same parts one would use:
+ * an aws_h2_decoder (server mode) reads everything the client writes, and an aws_h2_frame_encoder writes
+ * the responses. The peer honors flow-control in both directions, so both ends pay their full protocol cost.
+ *
+ * Each "pump" ticks the client until it's idle, decodes what it wrote, and feeds back the peer's reply,
+ * until neither side has anything left to say.
+ */
+
+/* Cap on how much the peer encodes before handing it to the client, so a large body doesn't sit in memory */
+#define LOOPBACK_MAX_PEER_OUTPUT (4 * 1024 * 1024)
+/* Body bytes are served from a buffer of this size, over and over */
+#define LOOPBACK_BODY_CHUNK_SIZE (1024 * 1024)
+/* How much the client may upload beyond what the peer has received so far */
+#define LOOPBACK_UPLOAD_WINDOW (1024 * 1024)
+
+struct loopback_response {
+    struct aws_linked_list_node node;
+    uint32_t stream_id;
+    bool headers_sent;
+    uint64_t body_remaining; /* Bytes not yet handed to the encoder */
+    struct aws_input_stream *body_chunk;
+    int32_t stream_window_peer; /* How much DATA the client will accept on this stream */
+};
+
+struct h2_loopback {
+    struct aws_allocator *allocator;
+    struct testing_channel testing_channel;
+    struct aws_http_connection *client;
+
+    /* Peer */
+    struct aws_h2_decoder *decoder;
+    struct aws_h2_frame_encoder encoder;
+    struct aws_byte_buf client_output; /* Written by the client, not decoded yet */
+    struct aws_byte_buf peer_output;   /* Encoded by the peer, not delivered yet */
+    struct aws_linked_list responses;  /* struct loopback_response, in the order requests ended */
+    struct aws_http_headers *response_headers;
+    uint64_t response_body_length;
+    struct aws_byte_buf body_chunk_buf;
+    size_t connection_window_peer;
+    uint32_t upload_window_to_return;
+    uint64_t *received_per_stream; /* Indexed by (stream_id - 1) / 2, optional */
+    size_t received_per_stream_count;
+    uint64_t total_received;
+    bool peer_failed;
+
+    /* Client */
+    size_t streams_started;
+    size_t streams_completed;
+    size_t streams_failed;
+    uint64_t first_complete_ns;
+    /* Where the fairness benchmark wants to know, the first time total_received crosses it */
+    uint64_t snapshot_at_received;
+    double snapshot_fairness;
+    bool snapshot_taken;
+};
+
+static int s_peer_encode_frame(struct h2_loopback *loopback, struct aws_h2_frame *frame) {
+    if (!frame) {
+        return AWS_OP_ERR;
+    }
+    bool frame_complete = false;
+    int result = AWS_OP_SUCCESS;
+    while (!frame_complete && !result) {
+        result = aws_byte_buf_reserve_relative(&loopback->peer_output, g_aws_channel_max_fragment_size);
+        if (!result) {
+            result = aws_h2_encode_frame(&loopback->encoder, frame, &loopback->peer_output, &frame_complete);
+        }
+    }
+    aws_h2_frame_destroy(frame);
+    return result;
+}
+
+/* Jain's fairness index of the bytes received per stream: 1.0 when all are equal, 1/n when one stream has it all */
+static double s_fairness_index(const uint64_t *values, size_t count) {
+    double sum = 0.0;
+    double sum_of_squares = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += (double)values[i];
+        sum_of_squares += (double)values[i] * (double)values[i];
+    }
+    return sum_of_squares > 0.0 ? (sum * sum) / ((double)count * sum_of_squares) : 1.0;
+}
+
+static struct aws_h2err s_peer_on_data_i(uint32_t stream_id, struct aws_byte_cursor data, void *userdata) {
+    struct h2_loopback *loopback = userdata;
+    loopback->total_received += data.len;
+    loopback->upload_window_to_return += (uint32_t)data.len;
+
+    size_t index = (stream_id - 1) / 2;
+    if (index < loopback->received_per_stream_count) {
+        loopback->received_per_stream[index] += data.len;
+    }
+    if (loopback->snapshot_at_received && !loopback->snapshot_taken &&
+        loopback->total_received >= loopback->snapshot_at_received) {
+        loopback->snapshot_fairness =
+            s_fairness_index(loopback->received_per_stream, loopback->received_per_stream_count);
+        loopback->snapshot_taken = true;
+    }
+    return AWS_H2ERR_SUCCESS;
+}
+
+static struct aws_h2err s_peer_on_end_stream(uint32_t stream_id, void *userdata) {
+    struct h2_loopback *loopback = userdata;
+    struct loopback_response *response = aws_mem_calloc(loopback->allocator, 1, sizeof(struct loopback_response));
+    response->stream_id = stream_id;
+    response->body_remaining = loopback->response_body_length;
+    response->stream_window_peer = AWS_H2_WINDOW_UPDATE_MAX;
+    aws_linked_list_push_back(&loopback->responses, &response->node);
+    return AWS_H2ERR_SUCCESS;
+}
+
+static struct aws_h2err s_peer_on_settings(
+    const struct aws_http2_setting *settings_array,
+    size_t num_settings,
+    void *userdata) {
+    (void)settings_array;
+    (void)num_settings;
+    struct h2_loopback *loopback = userdata;
+    if (s_peer_encode_frame(loopback, aws_h2_frame_new_settings(loopback->allocator, NULL, 0, true /*ack*/))) {
+        return aws_h2err_from_last_error();
+    }
+    return AWS_H2ERR_SUCCESS;
+}
+
+static struct aws_h2err s_peer_on_window_update(uint32_t stream_id, uint32_t window_size_increment, void *userdata) {
+    struct h2_loopback *loopback = userdata;
+    if (stream_id == 0) {
+        loopback->connection_window_peer += window_size_increment;
+        return AWS_H2ERR_SUCCESS;
+    }
+    for (struct aws_linked_list_node *node = aws_linked_list_begin(&loopback->responses);
+         node != aws_linked_list_end(&loopback->responses);
+         node = aws_linked_list_next(node)) {
+        struct loopback_response *response = AWS_CONTAINER_OF(node, struct loopback_response, node);
+        if (response->stream_id == stream_id) {
+            response->stream_window_peer += (int32_t)window_size_increment;
+            break;
+        }
+    }
+    return AWS_H2ERR_SUCCESS;
+}
+
+static struct aws_h2err s_peer_on_rst_stream(uint32_t stream_id, uint32_t error_code, void *userdata) {
+    (void)stream_id;
+    (void)error_code;
+    struct h2_loopback *loopback = userdata;
+    loopback->peer_failed = true;
+    return AWS_H2ERR_SUCCESS;
+}
+
+static const struct aws_h2_decoder_vtable s_peer_decoder_vtable = {
+    .on_data_i = s_peer_on_data_i,
+    .on_end_stream = s_peer_on_end_stream,
+    .on_settings = s_peer_on_settings,
+    .on_window_update = s_peer_on_window_update,
+    .on_rst_stream = s_peer_on_rst_stream,
+};
+
+static void s_destroy_response(struct h2_loopback *loopback, struct loopback_response *response) {
+    aws_linked_list_remove(&response->node);
+    aws_input_stream_release(response->body_chunk);
+    aws_mem_release(loopback->allocator, response);
+}
+
+/* Encode as much of the pending responses as flow-control and LOOPBACK_MAX_PEER_OUTPUT allow */
+static int s_peer_serve(struct h2_loopback *loopback) {
+    if (loopback->upload_window_to_return) {
+        struct aws_h2_frame *window_update =
+            aws_h2_frame_new_window_update(loopback->allocator, 0, loopback->upload_window_to_return);
+        if (s_peer_encode_frame(loopback, window_update)) {
+            return AWS_OP_ERR;
+        }
+        loopback->upload_window_to_return = 0;
+    }
+
+    struct aws_linked_list_node *node = aws_linked_list_begin(&loopback->responses);
+    while (node != aws_linked_list_end(&loopback->responses)) {
+        struct loopback_response *response = AWS_CONTAINER_OF(node, struct loopback_response, node);
+        node = aws_linked_list_next(node);
+
+        if (!response->headers_sent) {
+            struct aws_h2_frame *headers = aws_h2_frame_new_headers(
+                loopback->allocator,
+                response->stream_id,
+                loopback->response_headers,
+                response->body_remaining == 0 /*end_stream*/,
+                0 /*pad_length*/,
+                NULL /*optional_priority*/);
+            if (s_peer_encode_frame(loopback, headers)) {
+                return AWS_OP_ERR;
+            }
+            response->headers_sent = true;
+        }
+
+        while (response->body_remaining || response->body_chunk) {
+            if (loopback->connection_window_peer == 0 || loopback->peer_output.len >= LOOPBACK_MAX_PEER_OUTPUT) {
+                return AWS_OP_SUCCESS;
+            }
+            if (response->stream_window_peer <= 0) {
+                break;
+            }
+            if (!response->body_chunk) {
+                struct aws_byte_cursor chunk = aws_byte_cursor_from_array(
+                    loopback->body_chunk_buf.buffer,
+                    (size_t)aws_min_u64(response->body_remaining, loopback->body_chunk_buf.len));
+                response->body_chunk = aws_input_stream_new_from_cursor(loopback->allocator, &chunk);
+                if (!response->body_chunk) {
+                    return AWS_OP_ERR;
+                }
+                response->body_remaining -= chunk.len;
+            }
+
+            if (aws_byte_buf_reserve_relative(&loopback->peer_output, g_aws_channel_max_fragment_size)) {
+                return AWS_OP_ERR;
+            }
+            bool body_complete = false;
+            bool body_stalled = false;
+            if (aws_h2_encode_data_frame(
+                    &loopback->encoder,
+                    response->stream_id,
+                    response->body_chunk,
+                    response->body_remaining == 0 /*body_ends_stream*/,
+                    0 /*pad_length*/,
+                    &response->stream_window_peer,
+                    &loopback->connection_window_peer,
+                    &loopback->peer_output,
+                    &body_complete,
+                    &body_stalled)) {
+                return AWS_OP_ERR;
+            }
+            if (body_complete) {
+                aws_input_stream_release(response->body_chunk);
+                response->body_chunk = NULL;
+            }
+        }
+
+        if (response->headers_sent && !response->body_remaining && !response->body_chunk) {
+            s_destroy_response(loopback, response);
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
+
+/* Tick both ends until neither has anything more to send */
+static int s_pump(struct h2_loopback *loopback) {
+    struct aws_linked_list *written = testing_channel_get_written_message_queue(&loopback->testing_channel);
+    while (true) {
+        testing_channel_drain_queued_tasks(&loopback->testing_channel);
+        bool progress = false;
+
+        while (!aws_linked_list_empty(written)) {
+            struct aws_linked_list_node *node = aws_linked_list_pop_front(written);
+            struct aws_io_message *msg = AWS_CONTAINER_OF(node, struct aws_io_message, queueing_handle);
+            int err = aws_byte_buf_append_dynamic(&loopback->client_output, &msg->message_data);
+            aws_mem_release(msg->allocator, msg);
+            if (err) {
+                return AWS_OP_ERR;
+            }
+        }
+        if (loopback->client_output.len) {
+            struct aws_byte_cursor input = aws_byte_cursor_from_buf(&loopback->client_output);
+            struct aws_h2err err = aws_h2_decode(loopback->decoder, &input);
+            aws_byte_buf_reset(&loopback->client_output, false);
+            if (aws_h2err_failed(err)) {
+                return aws_raise_error(err.aws_code);
+            }
+            progress = true;
+        }
+
+        if (s_peer_serve(loopback)) {
+            return AWS_OP_ERR;
+        }
+
+        struct aws_byte_cursor output = aws_byte_cursor_from_buf(&loopback->peer_output);
+        while (output.len) {
+            struct aws_byte_cursor fragment =
+                aws_byte_cursor_advance(&output, aws_min_size(output.len, g_aws_channel_max_fragment_size));
+            if (testing_channel_push_read_data(&loopback->testing_channel, fragment)) {
+                return AWS_OP_ERR;
+            }
+            progress = true;
+        }
+        aws_byte_buf_reset(&loopback->peer_output, false);
+
+        if (loopback->peer_failed || testing_channel_is_shutdown_completed(&loopback->testing_channel)) {
+            return aws_raise_error(AWS_ERROR_HTTP_PROTOCOL_ERROR);
+        }
+        if (!progress) {
+            return AWS_OP_SUCCESS;
+        }
+    }
+}
+
+static void s_h2_loopback_clean_up(struct h2_loopback *loopback) {
+    if (loopback->client) {
+        aws_http_connection_release(loopback->client);
+        testing_channel_clean_up(&loopback->testing_channel);
+    }
+    while (!aws_linked_list_empty(&loopback->responses)) {
+        struct loopback_response *response =
+            AWS_CONTAINER_OF(aws_linked_list_front(&loopback->responses), struct loopback_response, node);
+        s_destroy_response(loopback, response);
+    }
+    aws_h2_decoder_destroy(loopback->decoder);
+    aws_h2_frame_encoder_clean_up(&loopback->encoder);
+    aws_byte_buf_clean_up(&loopback->client_output);
+    aws_byte_buf_clean_up(&loopback->peer_output);
+    aws_byte_buf_clean_up(&loopback->body_chunk_buf);
+    aws_http_headers_release(loopback->response_headers);
+    aws_mem_release(loopback->allocator, loopback->received_per_stream);
+}
+
+static int s_h2_loopback_init(
+    struct h2_loopback *loopback,
+    struct aws_allocator *allocator,
+    const struct aws_http_header *response_headers,
+    size_t num_response_headers,
+    uint64_t response_body_length,
+    size_t num_tracked_streams) {
+
+    AWS_ZERO_STRUCT(*loopback);
+    loopback->allocator = allocator;
+    loopback->response_body_length = response_body_length;
+    loopback->connection_window_peer = AWS_H2_INIT_WINDOW_SIZE;
+    aws_linked_list_init(&loopback->responses);
+
+    loopback->response_headers = aws_http_headers_new(allocator);
+    if (!loopback->response_headers ||
+        aws_http_headers_add_array(loopback->response_headers, response_headers, num_response_headers)) {
+        goto error;
+    }
+    if (aws_byte_buf_init(&loopback->client_output, allocator, g_aws_channel_max_fragment_size) ||
+        aws_byte_buf_init(&loopback->peer_output, allocator, g_aws_channel_max_fragment_size) ||
+        aws_byte_buf_init(&loopback->body_chunk_buf, allocator, LOOPBACK_BODY_CHUNK_SIZE)) {
+        goto error;
+    }
+    memset(loopback->body_chunk_buf.buffer, 'b', LOOPBACK_BODY_CHUNK_SIZE);
+    loopback->body_chunk_buf.len = LOOPBACK_BODY_CHUNK_SIZE;
+    if (num_tracked_streams) {
+        loopback->received_per_stream = aws_mem_calloc(allocator, num_tracked_streams, sizeof(uint64_t));
+        loopback->received_per_stream_count = num_tracked_streams;
+    }
+
+    /* Peer */
+    if (aws_h2_frame_encoder_init(&loopback->encoder, allocator, loopback)) {
+        goto error;
+    }
+    struct aws_h2_decoder_params decoder_params = {
+        .alloc = allocator,
+        .vtable = &s_peer_decoder_vtable,
+        .userdata = loopback,
+        .logging_id = loopback,
+        .is_server = true,
+    };
+    loopback->decoder = aws_h2_decoder_new(&decoder_params);
+    if (!loopback->decoder) {
+        goto error;
+    }
+
+    /* Client */
+    struct aws_testing_channel_options channel_options = {.clock_fn = aws_high_res_clock_get_ticks};
+    if (testing_channel_init(&loopback->testing_channel, allocator, &channel_options)) {
+        goto error;
+    }
+    struct aws_http2_setting client_settings[] = {
+        {.id = AWS_HTTP2_SETTINGS_ENABLE_PUSH, .value = 0},
+        {.id = AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, .value = AWS_H2_WINDOW_UPDATE_MAX},
+    };
+    struct aws_http2_connection_options http2_options = {
+        .initial_settings_array = client_settings,
+        .num_initial_settings = AWS_ARRAY_SIZE(client_settings),
+        .max_closed_streams = AWS_HTTP2_DEFAULT_MAX_CLOSED_STREAMS,
+        /* So the connection window can be opened all the way, see s_on_response_body() */
+        .conn_manual_window_management = true,
+    };
+    loopback->client = aws_http_connection_new_http2_client(allocator, false /*manual_window*/, &http2_options);
+    if (!loopback->client) {
+        testing_channel_clean_up(&loopback->testing_channel);
+        goto error;
+    }
+    /* What http-bootstrap does in the real world */
+    struct aws_channel_slot *slot = aws_channel_slot_new(loopback->testing_channel.channel);
+    if (!slot || aws_channel_slot_insert_end(loopback->testing_channel.channel, slot) ||
+        aws_channel_slot_set_handler(slot, &loopback->client->channel_handler)) {
+        goto error;
+    }
+    loopback->client->vtable->on_channel_handler_installed(&loopback->client->channel_handler, slot);
+    aws_http2_connection_update_window(loopback->client, AWS_H2_WINDOW_UPDATE_MAX - AWS_H2_INIT_WINDOW_SIZE);
+
+    /* The peer's connection preface, and room to upload */
+    struct aws_http2_setting peer_settings[] = {
+        {.id = AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, .value = 1000},
+        {.id = AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, .value = AWS_H2_WINDOW_UPDATE_MAX},
+    };
+    if (s_peer_encode_frame(
+            loopback, aws_h2_frame_new_settings(allocator, peer_settings, AWS_ARRAY_SIZE(peer_settings), false)) ||
+        s_peer_encode_frame(loopback, aws_h2_frame_new_window_update(allocator, 0, LOOPBACK_UPLOAD_WINDOW))) {
+        goto error;
+    }
+    if (s_pump(loopback)) {
+        goto error;
+    }
+    return AWS_OP_SUCCESS;
+
+error:
+    s_h2_loopback_clean_up(loopback);
+    return AWS_OP_ERR;
+}
+
+static int s_on_response_body(struct aws_http_stream *stream, const struct aws_byte_cursor *data, void *user_data) {
+    (void)stream;
+    struct h2_loopback *loopback = user_data;
+    /* Give the window straight back, the same as conn_manual_window_management=false does,
+     * but starting from the maximum window rather than 64KiB */
+    aws_http2_connection_update_window(loopback->client, (uint32_t)data->len);
+    return AWS_OP_SUCCESS;
+}
+
+static void s_on_stream_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
+    struct h2_loopback *loopback = user_data;
+    int status = 0;
+    if (error_code || aws_http_stream_get_incoming_response_status(stream, &status) || status != 200) {
+        ++loopback->streams_failed;
+    }
+    if (loopback->streams_completed++ == 0) {
+        aws_high_res_clock_get_ticks(&loopback->first_complete_ns);
+    }
+    aws_http_stream_release(stream);
+}
+
+static int s_start_stream(
+    struct h2_loopback *loopback,
+    const struct aws_http_header *headers,
+    size_t num_headers,
+    struct aws_input_stream *body) {
+
+    struct aws_http_message *request = aws_http2_message_new_request(loopback->allocator);
+    if (!request) {
+        return AWS_OP_ERR;
+    }
+    int result = AWS_OP_ERR;
+    if (aws_http_message_add_header_array(request, headers, num_headers)) {
+        goto done;
+    }
+    aws_http_message_set_body_stream(request, body);
+
+    struct aws_http_make_request_options options = {
+        .self_size = sizeof(options),
+        .request = request,
+        .user_data = loopback,
+        .on_response_body = s_on_response_body,
+        .on_complete = s_on_stream_complete,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(loopback->client, &options);
+    if (!stream) {
+        goto done;
+    }
+    if (aws_http_stream_activate(stream)) {
+        aws_http_stream_release(stream);
+        goto done;
+    }
+    ++loopback->streams_started;
+    result = AWS_OP_SUCCESS;
+
+done:
+    aws_http_message_release(request);
+    return result;
+}
+
+static int s_check_all_succeeded(const struct h2_loopback *loopback) {
+    if (loopback->streams_failed || loopback->streams_completed != loopback->streams_started) {
+        fprintf(
+            stderr,
+            "%zu of %zu streams failed or didn't finish\n",
+            loopback->streams_failed + (loopback->streams_started - loopback->streams_completed),
+            loopback->streams_started);
+        return aws_raise_error(AWS_ERROR_HTTP_PROTOCOL_ERROR);
+    }
+    return AWS_OP_SUCCESS;
+}
+
+#define LOOPBACK_HEADER(NAME, VALUE)                                                                                   \
+    { .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(NAME), .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(VALUE), }
+
+static const struct aws_http_header s_get_request_headers[] = {
+    LOOPBACK_HEADER(":method", "GET"),
+    LOOPBACK_HEADER(":scheme", "https"),
+    LOOPBACK_HEADER(":path", "/"),
+    LOOPBACK_HEADER(":authority", "httpbench.invalid"),
+};
+
+static const struct aws_http_header s_put_request_headers[] = {
+    LOOPBACK_HEADER(":method", "PUT"),
+    LOOPBACK_HEADER(":scheme", "https"),
+    LOOPBACK_HEADER(":path", "/upload"),
+    LOOPBACK_HEADER(":authority", "httpbench.invalid"),
+};
+
+static const struct aws_http_header s_ok_response_headers[] = {
+    LOOPBACK_HEADER(":status", "200"),
+};
+
+/* Runs `iterations` small GETs, keeping up to `max_in_flight` in flight, and prints streams/sec */
+static int s_run_unary(
+    struct aws_allocator *allocator,
+    const char *name,
+    const struct aws_http_header *request_headers,
+    size_t num_request_headers,
+    const struct aws_http_header *response_headers,
+    size_t num_response_headers,
+    size_t max_in_flight,
+    size_t iterations) {
+
+    struct h2_loopback loopback;
+    if (s_h2_loopback_init(&loopback, allocator, response_headers, num_response_headers, 0, 0)) {
+        return AWS_OP_ERR;
+    }
+
+    int result = AWS_OP_SUCCESS;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    while (loopback.streams_completed < iterations && !result) {
+        while (loopback.streams_started - loopback.streams_completed < max_in_flight &&
+               loopback.streams_started < iterations && !result) {
+            result = s_start_stream(&loopback, request_headers, num_request_headers, NULL);
+        }
+        if (!result) {
+            result = s_pump(&loopback);
+        }
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    if (!result) {
+        result = s_check_all_succeeded(&loopback);
+    }
+    if (!result) {
+        const double elapsed_ns = (double)(end_ns - start_ns);
+        printf(
+            "  %-28s in-flight=%4zu  %10.0f streams/sec  %8.0f ns/stream\n",
+            name,
+            max_in_flight,
+            (double)iterations * 1e9 / elapsed_ns,
+            elapsed_ns / (double)iterations);
+    }
+
+    s_h2_loopback_clean_up(&loopback);
+    return result;
+}
+
+int httpbench_h2_unary(struct aws_allocator *allocator, size_t iterations) {
+    const size_t in_flight_counts[] = {1, 10, 100};
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(in_flight_counts); ++i) {
+        if (s_run_unary(
+                allocator,
+                "GET, headers-only response",
+                s_get_request_headers,
+                AWS_ARRAY_SIZE(s_get_request_headers),
+                s_ok_response_headers,
+                AWS_ARRAY_SIZE(s_ok_response_headers),
+                in_flight_counts[i],
+                iterations)) {
+            return AWS_OP_ERR;
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
+
+/* Header blocks shaped like an SDK talking to a cloud service: some static-table hits, many custom names */
+static const struct aws_http_header s_heavy_request_headers[] = {
+    LOOPBACK_HEADER(":method", "POST"),
+    LOOPBACK_HEADER(":scheme", "https"),
+    LOOPBACK_HEADER(":path", "/2015-03-31/functions/httpbench-function/invocations?Qualifier=live"),
+    LOOPBACK_HEADER(":authority", "lambda.us-west-2.amazonaws.com"),
+    LOOPBACK_HEADER("accept", "application/json"),
+    LOOPBACK_HEADER("accept-encoding", "gzip, deflate"),
+    LOOPBACK_HEADER("content-type", "application/x-amz-json-1.1"),
+    LOOPBACK_HEADER("user-agent", "aws-sdk-cpp/1.11.0 Linux/6.1 x86_64 GCC/12.2.0 exec-env/httpbench"),
+    LOOPBACK_HEADER("x-amz-content-sha256", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+    LOOPBACK_HEADER("x-amz-date", "20240101T000000Z"),
+    LOOPBACK_HEADER("x-amz-security-token", "IQoJb3JpZ2luX2VjEHAaCXVzLXdlc3QtMiJHMEUCIQD6examplesessiontoken"),
+    LOOPBACK_HEADER("x-amz-target", "AWSLambda.Invoke"),
+    LOOPBACK_HEADER("x-amz-user-agent", "aws-sdk-cpp/1.11.0"),
+    LOOPBACK_HEADER("amz-sdk-invocation-id", "a1b2c3d4-e5f6-7890-abcd-ef1234567890"),
+    LOOPBACK_HEADER("amz-sdk-request", "attempt=1; max=3"),
+    LOOPBACK_HEADER(
+        "authorization",
+        "AWS4-HMAC-SHA256 Credential=AKIDEXAMPLE/20240101/us-west-2/lambda/aws4_request, "
+        "SignedHeaders=content-type;host;x-amz-date;x-amz-security-token;x-amz-target, "
+        "Signature=5d672d79c15b13162d9279b0855cfba6789a8edb4c82c400e06b5924a6f2b5d7"),
+    LOOPBACK_HEADER("cache-control", "no-cache"),
+    LOOPBACK_HEADER("x-amzn-trace-id", "Root=1-5759e988-bd862e3fe1be46a994272793;Sampled=1"),
+};
+
+static const struct aws_http_header s_heavy_response_headers[] = {
+    LOOPBACK_HEADER(":status", "200"),
+    LOOPBACK_HEADER("content-type", "application/json"),
+    LOOPBACK_HEADER("date", "Mon, 01 Jan 2024 00:00:00 GMT"),
+    LOOPBACK_HEADER("x-amzn-requestid", "9f3e2a1b-7c6d-4e5f-8a9b-0c1d2e3f4a5b"),
+    LOOPBACK_HEADER("x-amzn-remapped-content-length", "0"),
+    LOOPBACK_HEADER("x-amz-executed-version", "$LATEST"),
+    LOOPBACK_HEADER("x-amzn-trace-id", "root=1-5759e988-bd862e3fe1be46a994272793;sampled=1"),
+    LOOPBACK_HEADER("x-amz-log-result", "U1RBUlQgUmVxdWVzdElkOiA5ZjNlMmExYiBWZXJzaW9uOiAkTEFURVNUCg=="),
+    LOOPBACK_HEADER("cache-control", "private, max-age=0"),
+    LOOPBACK_HEADER("vary", "accept-encoding"),
+    LOOPBACK_HEADER("strict-transport-security", "max-age=31536000; includeSubDomains"),
+    LOOPBACK_HEADER("server", "httpbench"),
+};
+
+int httpbench_h2_headers(struct aws_allocator *allocator, size_t iterations) {
+    if (s_run_unary(
+            allocator,
+            "4 request, 1 response headers",
+            s_get_request_headers,
+            AWS_ARRAY_SIZE(s_get_request_headers),
+            s_ok_response_headers,
+            AWS_ARRAY_SIZE(s_ok_response_headers),
+            100,
+            iterations)) {
+        return AWS_OP_ERR;
+    }
+    if (s_run_unary(
+            allocator,
+            "18 request, 12 response headers",
+            s_heavy_request_headers,
+            AWS_ARRAY_SIZE(s_heavy_request_headers),
+            s_heavy_response_headers,
+            AWS_ARRAY_SIZE(s_heavy_response_headers),
+            100,
+            iterations)) {
+        return AWS_OP_ERR;
+    }
+    return AWS_OP_SUCCESS;
+}
+
+/* One GET whose response body is `iterations` MiB */
+int httpbench_h2_streaming(struct aws_allocator *allocator, size_t iterations) {
+    const uint64_t body_length = (uint64_t)iterations * 1024 * 1024;
+    struct h2_loopback loopback;
+    if (s_h2_loopback_init(
+            &loopback, allocator, s_ok_response_headers, AWS_ARRAY_SIZE(s_ok_response_headers), body_length, 0)) {
+        return AWS_OP_ERR;
+    }
+
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    int result = s_start_stream(&loopback, s_get_request_headers, AWS_ARRAY_SIZE(s_get_request_headers), NULL);
+    while (!result && loopback.streams_completed == 0) {
+        result = s_pump(&loopback);
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    if (!result) {
+        result = s_check_all_succeeded(&loopback);
+    }
+    if (!result) {
+        const double elapsed_ns = (double)(end_ns - start_ns);
+        printf(
+            "  %-28s %10.1f MiB/sec  %8.3f ns/byte\n",
+            "1 stream, response body",
+            (double)iterations * 1e9 / elapsed_ns,
+            elapsed_ns / (double)body_length);
+    }
+
+    s_h2_loopback_clean_up(&loopback);
+    return result;
+}
+
+/* Many streams upload `iterations` KiB each at once, and the peer checks how evenly the client interleaves them */
+int httpbench_h2_fairness(struct aws_allocator *allocator, size_t iterations) {
+    const size_t stream_counts[] = {16, 64, 256};
+    int result = AWS_OP_SUCCESS;
+    for (size_t c = 0; c < AWS_ARRAY_SIZE(stream_counts) && !result; ++c) {
+        const size_t num_streams = stream_counts[c];
+        const size_t body_length = iterations * 1024;
+        struct h2_loopback loopback;
+        if (s_h2_loopback_init(
+                &loopback,
+                allocator,
+                s_ok_response_headers,
+                AWS_ARRAY_SIZE(s_ok_response_headers),
+                0,
+                num_streams)) {
+            return AWS_OP_ERR;
+        }
+        loopback.snapshot_at_received = (uint64_t)body_length * num_streams / 2;
+
+        uint8_t *body = aws_mem_calloc(allocator, 1, body_length);
+        uint64_t start_ns = 0;
+        uint64_t end_ns = 0;
+        aws_high_res_clock_get_ticks(&start_ns);
+        for (size_t i = 0; i < num_streams && !result; ++i) {
+            struct aws_byte_cursor body_cursor = aws_byte_cursor_from_array(body, body_length);
+            struct aws_input_stream *body_stream = aws_input_stream_new_from_cursor(allocator, &body_cursor);
+            if (!body_stream) {
+                result = AWS_OP_ERR;
+                break;
+            }
+            result = s_start_stream(
+                &loopback, s_put_request_headers, AWS_ARRAY_SIZE(s_put_request_headers), body_stream);
+            /* The request holds the body now */
+            aws_input_stream_release(body_stream);
+        }
+        while (!result && loopback.streams_completed < loopback.streams_started) {
+            result = s_pump(&loopback);
+        }
+        aws_high_res_clock_get_ticks(&end_ns);
+
+        if (!result) {
+            result = s_check_all_succeeded(&loopback);
+        }
+        if (!result) {
+            const double elapsed_ns = (double)(end_ns - start_ns);
+            printf(
+                "  streams=%4zu  %10.1f MiB/sec  fairness at halfway=%.3f  first stream done at %3.0f%% of run\n",
+                num_streams,
+                (double)loopback.total_received * 1e9 / elapsed_ns / (1024.0 * 1024.0),
+                loopback.snapshot_fairness,
+                100.0 * (double)(loopback.first_complete_ns - start_ns) / elapsed_ns);
+        }
+
+        aws_mem_release(allocator, body);
+        s_h2_loopback_clean_up(&loopback);
+    }
+    return result;
+}
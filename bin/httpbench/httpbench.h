@@ -0,0 +1,23 @@
+#ifndef AWS_HTTPBENCH_H
+#define AWS_HTTPBENCH_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/common/common.h>
+
+/* Each benchmark prints its results to stdout and returns AWS_OP_SUCCESS, or AWS_OP_ERR if it couldn't run */
+typedef int(httpbench_fn)(struct aws_allocator *allocator, size_t iterations);
+
+httpbench_fn httpbench_false_sharing;
+httpbench_fn httpbench_h1_decode;
+httpbench_fn httpbench_h2_fairness;
+httpbench_fn httpbench_h2_headers;
+httpbench_fn httpbench_h2_streaming;
+httpbench_fn httpbench_h2_unary;
+httpbench_fn httpbench_least_loaded;
+httpbench_fn httpbench_manager_contention;
+
+#endif /* AWS_HTTPBENCH_H */
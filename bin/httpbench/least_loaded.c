@@ -0,0 +1,225 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/common/clock.h>
+#include <aws/common/hash_table.h>
+#include <aws/http/private/least_loaded_heap.h>
+#include <aws/http/private/random_access_set.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/**
+ * Replays the HTTP/2 stream manager's connection picking, at thousands of connections.
+ * Every iteration starts a stream on the picked connection, and finishes a random stream that's in flight,
+ * so the number of streams in flight stays at `ideal` per connection and connections constantly cross the ideal limit.
+ *
+ * The `random sets` rows use the manager's old approach: best of two random picks from the ideal set,
+ * falling back to the nonideal set, and moving connections between the sets as they cross the ideal limit.
+ * The `least-loaded heap` rows use aws_least_loaded_heap, which always picks the least loaded connection
+ * and only changes its position as its load changes.
+ *
+ * "spread" is the difference between the most and least loaded connection at the end, lower is fairer.
+ */
+
+static const uint32_t s_ideal_streams_per_connection = 8;
+
+struct least_loaded_connection {
+    uint32_t num_streams_assigned;
+    bool is_ideal;
+    struct aws_least_loaded_heap_node node;
+};
+
+struct least_loaded_picker {
+    const char *name;
+    int (*init)(struct least_loaded_picker *picker, struct aws_allocator *allocator, size_t num_connections);
+    void (*clean_up)(struct least_loaded_picker *picker);
+    int (*add)(struct least_loaded_picker *picker, struct least_loaded_connection *connection);
+    struct least_loaded_connection *(*start_stream)(struct least_loaded_picker *picker);
+    void (*finish_stream)(struct least_loaded_picker *picker, struct least_loaded_connection *connection);
+
+    struct aws_random_access_set ideal_set;
+    struct aws_random_access_set nonideal_set;
+    struct aws_least_loaded_heap heap;
+};
+
+/* Cheap deterministic random numbers, so the picker's cost dominates */
+static uint64_t s_xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int s_sets_init(struct least_loaded_picker *picker, struct aws_allocator *allocator, size_t num_connections) {
+    if (aws_random_access_set_init(&picker->ideal_set, allocator, aws_hash_ptr, aws_ptr_eq, NULL, num_connections)) {
+        return AWS_OP_ERR;
+    }
+    if (aws_random_access_set_init(&picker->nonideal_set, allocator, aws_hash_ptr, aws_ptr_eq, NULL, num_connections)) {
+        aws_random_access_set_clean_up(&picker->ideal_set);
+        return AWS_OP_ERR;
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static void s_sets_clean_up(struct least_loaded_picker *picker) {
+    aws_random_access_set_clean_up(&picker->ideal_set);
+    aws_random_access_set_clean_up(&picker->nonideal_set);
+}
+
+static int s_sets_add(struct least_loaded_picker *picker, struct least_loaded_connection *connection) {
+    bool added = false;
+    connection->is_ideal = true;
+    return aws_random_access_set_add(&picker->ideal_set, connection, &added);
+}
+
+static struct least_loaded_connection *s_sets_best_of_two(struct aws_random_access_set *set) {
+    struct least_loaded_connection *a = NULL;
+    struct least_loaded_connection *b = NULL;
+    aws_random_access_set_random_get_ptr(set, (void **)&a);
+    aws_random_access_set_random_get_ptr(set, (void **)&b);
+    return a->num_streams_assigned > b->num_streams_assigned ? b : a;
+}
+
+static struct least_loaded_connection *s_sets_start_stream(struct least_loaded_picker *picker) {
+    struct least_loaded_connection *connection = NULL;
+    if (aws_random_access_set_get_size(&picker->ideal_set)) {
+        connection = s_sets_best_of_two(&picker->ideal_set);
+        if (++connection->num_streams_assigned >= s_ideal_streams_per_connection) {
+            bool added = false;
+            aws_random_access_set_remove(&picker->ideal_set, connection);
+            aws_random_access_set_add(&picker->nonideal_set, connection, &added);
+            connection->is_ideal = false;
+        }
+    } else {
+        connection = s_sets_best_of_two(&picker->nonideal_set);
+        ++connection->num_streams_assigned;
+    }
+    return connection;
+}
+
+static void s_sets_finish_stream(struct least_loaded_picker *picker, struct least_loaded_connection *connection) {
+    if (--connection->num_streams_assigned < s_ideal_streams_per_connection && !connection->is_ideal) {
+        bool added = false;
+        aws_random_access_set_remove(&picker->nonideal_set, connection);
+        aws_random_access_set_add(&picker->ideal_set, connection, &added);
+        connection->is_ideal = true;
+    }
+}
+
+static int s_heap_init(struct least_loaded_picker *picker, struct aws_allocator *allocator, size_t num_connections) {
+    return aws_least_loaded_heap_init(&picker->heap, allocator, num_connections);
+}
+
+static void s_heap_clean_up(struct least_loaded_picker *picker) {
+    aws_least_loaded_heap_clean_up(&picker->heap);
+}
+
+static int s_heap_add(struct least_loaded_picker *picker, struct least_loaded_connection *connection) {
+    aws_least_loaded_heap_node_init(&connection->node);
+    return aws_least_loaded_heap_add(&picker->heap, &connection->node, connection->num_streams_assigned);
+}
+
+static struct least_loaded_connection *s_heap_start_stream(struct least_loaded_picker *picker) {
+    struct least_loaded_connection *connection =
+        AWS_CONTAINER_OF(aws_least_loaded_heap_peek(&picker->heap), struct least_loaded_connection, node);
+    aws_least_loaded_heap_update(&picker->heap, &connection->node, ++connection->num_streams_assigned);
+    return connection;
+}
+
+static void s_heap_finish_stream(struct least_loaded_picker *picker, struct least_loaded_connection *connection) {
+    aws_least_loaded_heap_update(&picker->heap, &connection->node, --connection->num_streams_assigned);
+}
+
+static int s_run_case(
+    struct aws_allocator *allocator,
+    struct least_loaded_picker *picker,
+    size_t num_connections,
+    size_t iterations) {
+
+    struct least_loaded_connection *connections =
+        aws_mem_calloc(allocator, num_connections, sizeof(struct least_loaded_connection));
+    const size_t num_in_flight = num_connections * s_ideal_streams_per_connection;
+    struct least_loaded_connection **in_flight =
+        aws_mem_calloc(allocator, num_in_flight, sizeof(struct least_loaded_connection *));
+    int result = AWS_OP_ERR;
+    if (picker->init(picker, allocator, num_connections)) {
+        goto done;
+    }
+    for (size_t i = 0; i < num_connections; ++i) {
+        if (picker->add(picker, &connections[i])) {
+            goto clean_up;
+        }
+    }
+    for (size_t i = 0; i < num_in_flight; ++i) {
+        in_flight[i] = picker->start_stream(picker);
+    }
+
+    uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    for (size_t i = 0; i < iterations; ++i) {
+        size_t slot = (size_t)(s_xorshift(&random_state) % num_in_flight);
+        picker->finish_stream(picker, in_flight[slot]);
+        in_flight[slot] = picker->start_stream(picker);
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    uint32_t min_load = UINT32_MAX;
+    uint32_t max_load = 0;
+    for (size_t i = 0; i < num_connections; ++i) {
+        min_load = aws_min_u32(min_load, connections[i].num_streams_assigned);
+        max_load = aws_max_u32(max_load, connections[i].num_streams_assigned);
+    }
+    printf(
+        "  %-18s connections=%6zu  %8.1f ns/stream  spread=%" PRIu32 "\n",
+        picker->name,
+        num_connections,
+        (double)(end_ns - start_ns) / (double)iterations,
+        max_load - min_load);
+    result = AWS_OP_SUCCESS;
+
+clean_up:
+    picker->clean_up(picker);
+done:
+    aws_mem_release(allocator, in_flight);
+    aws_mem_release(allocator, connections);
+    return result;
+}
+
+int httpbench_least_loaded(struct aws_allocator *allocator, size_t iterations) {
+    struct least_loaded_picker pickers[] = {
+        {
+            .name = "random sets",
+            .init = s_sets_init,
+            .clean_up = s_sets_clean_up,
+            .add = s_sets_add,
+            .start_stream = s_sets_start_stream,
+            .finish_stream = s_sets_finish_stream,
+        },
+        {
+            .name = "least-loaded heap",
+            .init = s_heap_init,
+            .clean_up = s_heap_clean_up,
+            .add = s_heap_add,
+            .start_stream = s_heap_start_stream,
+            .finish_stream = s_heap_finish_stream,
+        },
+    };
+    const size_t connection_counts[] = {1000, 4000, 16000};
+
+    for (size_t c = 0; c < AWS_ARRAY_SIZE(connection_counts); ++c) {
+        for (size_t p = 0; p < AWS_ARRAY_SIZE(pickers); ++p) {
+            if (s_run_case(allocator, &pickers[p], connection_counts[c], iterations)) {
+                return AWS_OP_ERR;
+            }
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/http/http.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct httpbench_entry {
+    const char *name;
+    const char *description;
+    httpbench_fn *fn;
+    size_t default_iterations;
+};
+
+static const struct httpbench_entry s_benchmarks[] = {
+    {
+        .name = "false-sharing",
+        .description = "event-loop writes to thread_data while another thread writes synced_data",
+        .fn = httpbench_false_sharing,
+        .default_iterations = 50000000,
+    },
+    {
+        .name = "h1-decode",
+        .description = "HTTP/1 decoder reading response heads whole, a line at a time, and 16 bytes at a time",
+        .fn = httpbench_h1_decode,
+        .default_iterations = 1000000,
+    },
+    {
+        .name = "least-loaded",
+        .description = "HTTP/2 stream manager picking a connection for each stream, at thousands of connections",
+        .fn = httpbench_least_loaded,
+        .default_iterations = 2000000,
+    },
+    {
+        .name = "manager-contention",
+        .description = "connection manager acquire and release, from 1 thread up to one per processor",
+        .fn = httpbench_manager_contention,
+        .default_iterations = 1000000,
+    },
+    {
+        .name = "h2-unary",
+        .description = "in-memory HTTP/2 client and peer, small GETs at 1, 10 and 100 streams in flight",
+        .fn = httpbench_h2_unary,
+        .default_iterations = 100000,
+    },
+    {
+        .name = "h2-streaming",
+        .description = "in-memory HTTP/2 client and peer, one response body of [iterations] MiB",
+        .fn = httpbench_h2_streaming,
+        .default_iterations = 1024,
+    },
+    {
+        .name = "h2-headers",
+        .description = "in-memory HTTP/2 client and peer, small versus SDK-sized header blocks",
+        .fn = httpbench_h2_headers,
+        .default_iterations = 100000,
+    },
+    {
+        .name = "h2-fairness",
+        .description = "in-memory HTTP/2 client and peer, many streams each uploading [iterations] KiB at once",
+        .fn = httpbench_h2_fairness,
+        .default_iterations = 1024,
+    },
+};
+
+static void s_usage(int exit_code) {
+    fprintf(stderr, "usage: httpbench benchmark [iterations]\n");
+    fprintf(stderr, "\n Benchmarks:\n\n");
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(s_benchmarks); ++i) {
+        fprintf(stderr, "  %s: %s\n", s_benchmarks[i].name, s_benchmarks[i].description);
+    }
+    exit(exit_code);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        s_usage(1);
+    }
+
+    const struct httpbench_entry *entry = NULL;
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(s_benchmarks); ++i) {
+        if (strcmp(argv[1], s_benchmarks[i].name) == 0) {
+            entry = &s_benchmarks[i];
+            break;
+        }
+    }
+    if (!entry) {
+        fprintf(stderr, "unknown benchmark '%s'\n", argv[1]);
+        s_usage(1);
+    }
+
+    size_t iterations = entry->default_iterations;
+    if (argc == 3) {
+        iterations = (size_t)strtoull(argv[2], NULL, 10);
+        if (iterations == 0) {
+            fprintf(stderr, "iterations must be a positive integer\n");
+            s_usage(1);
+        }
+    }
+
+    struct aws_allocator *allocator = aws_default_allocator();
+    aws_http_library_init(allocator);
+
+    printf("%s (%zu iterations)\n", entry->name, iterations);
+    int result = entry->fn(allocator, iterations);
+    if (result) {
+        fprintf(stderr, "benchmark failed with error %s\n", aws_error_debug_str(aws_last_error()));
+    }
+
+    aws_http_library_clean_up();
+    return result ? 1 : 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "httpbench.h"
+
+#include <aws/common/atomics.h>
+#include <aws/common/clock.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/mutex.h>
+#include <aws/common/system_info.h>
+#include <aws/common/thread.h>
+#include <aws/http/connection_manager.h>
+#include <aws/http/private/connection_manager_system_vtable.h>
+#include <aws/io/channel_bootstrap.h>
+#include <aws/io/event_loop.h>
+#include <aws/io/host_resolver.h>
+#include <aws/io/socket.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Hammers aws_http_connection_manager_acquire_connection() and aws_http_connection_manager_release_connection()
+ * from 1 to N threads, where N is the number of processors. Connections are mocks installed through the
+ * manager's system vtable, so the cost measured is the manager's own bookkeeping, mostly under its one lock.
+ *
+ * Each thread acquires a connection, waits for it, and releases it right away. An "op" is one acquire plus release.
+ * The `pool=threads` rows always have a connection for every thread, so threads only contend on the lock.
+ * The `pool=threads/2` rows make half the acquisitions queue until another thread releases a connection.
+ *
+ * The manager's lock can't be observed from outside, so "serial ns/op" is wall time divided by total ops.
+ * Once throughput stops scaling with threads, the ops are serialized on the lock,
+ * and serial ns/op approximates how long each acquire plus release holds it.
+ * "wait" is the time from calling acquire until the connection is handed over.
+ */
+
+struct contention_connection {
+    aws_http_on_client_connection_shutdown_fn *on_shutdown;
+    void *user_data;
+};
+
+struct contention_worker {
+    struct aws_thread thread;
+    struct aws_http_connection_manager *manager;
+    struct aws_atomic_var *start;
+    size_t ops;
+    uint64_t *waits_ns;
+    uint64_t acquired_ns;
+    struct aws_atomic_var acquired; /* struct aws_http_connection *, set by the acquisition callback */
+};
+
+static struct {
+    struct aws_allocator *allocator;
+    struct aws_mutex lock;
+    struct aws_condition_variable signal;
+    bool manager_shutdown_complete;
+    struct aws_array_list connections; /* struct contention_connection *, protected by lock */
+} s_contention;
+
+static int s_mock_client_connect(const struct aws_http_client_connection_options *options) {
+    struct contention_connection *connection =
+        aws_mem_calloc(s_contention.allocator, 1, sizeof(struct contention_connection));
+    connection->on_shutdown = options->on_shutdown;
+    connection->user_data = options->user_data;
+
+    aws_mutex_lock(&s_contention.lock);
+    int err = aws_array_list_push_back(&s_contention.connections, &connection);
+    aws_mutex_unlock(&s_contention.lock);
+    if (err) {
+        aws_mem_release(s_contention.allocator, connection);
+        return AWS_OP_ERR;
+    }
+
+    options->on_setup((struct aws_http_connection *)(void *)connection, AWS_ERROR_SUCCESS, options->user_data);
+    return AWS_OP_SUCCESS;
+}
+
+static void s_mock_connection_release(struct aws_http_connection *http_connection) {
+    /* Memory is freed once the manager is gone */
+    struct contention_connection *connection = (struct contention_connection *)(void *)http_connection;
+    connection->on_shutdown(http_connection, AWS_ERROR_SUCCESS, connection->user_data);
+}
+
+static void s_mock_connection_close(struct aws_http_connection *http_connection) {
+    (void)http_connection;
+}
+
+static bool s_mock_connection_new_requests_allowed(const struct aws_http_connection *http_connection) {
+    (void)http_connection;
+    return true;
+}
+
+static bool s_mock_channel_thread_is_callers_thread(struct aws_channel *channel) {
+    (void)channel;
+    /* Hand connections over on the thread that frees them up, rather than on an event loop */
+    return true;
+}
+
+static struct aws_channel *s_mock_connection_get_channel(struct aws_http_connection *http_connection) {
+    (void)http_connection;
+    return (struct aws_channel *)1;
+}
+
+static enum aws_http_version s_mock_connection_get_version(const struct aws_http_connection *http_connection) {
+    (void)http_connection;
+    return AWS_HTTP_VERSION_1_1;
+}
+
+static struct aws_http_connection_manager_system_vtable s_mock_vtable = {
+    .aws_http_client_connect = s_mock_client_connect,
+    .aws_http_connection_close = s_mock_connection_close,
+    .aws_http_connection_release = s_mock_connection_release,
+    .aws_http_connection_new_requests_allowed = s_mock_connection_new_requests_allowed,
+    .aws_high_res_clock_get_ticks = aws_high_res_clock_get_ticks,
+    .aws_channel_thread_is_callers_thread = s_mock_channel_thread_is_callers_thread,
+    .aws_http_connection_get_channel = s_mock_connection_get_channel,
+    .aws_http_connection_get_version = s_mock_connection_get_version,
+};
+
+static void s_on_connection_acquired(struct aws_http_connection *connection, int error_code, void *user_data) {
+    struct contention_worker *worker = user_data;
+    AWS_FATAL_ASSERT(error_code == AWS_ERROR_SUCCESS && connection);
+    aws_high_res_clock_get_ticks(&worker->acquired_ns);
+    aws_atomic_store_ptr(&worker->acquired, connection);
+}
+
+static void s_worker_thread(void *user_data) {
+    struct contention_worker *worker = user_data;
+    while (!aws_atomic_load_int(worker->start)) {
+        aws_thread_yield();
+    }
+
+    for (size_t i = 0; i < worker->ops; ++i) {
+        uint64_t start_ns = 0;
+        aws_high_res_clock_get_ticks(&start_ns);
+        aws_http_connection_manager_acquire_connection(worker->manager, s_on_connection_acquired, worker);
+
+        struct aws_http_connection *connection = NULL;
+        while ((connection = aws_atomic_load_ptr(&worker->acquired)) == NULL) {
+            aws_thread_yield();
+        }
+        aws_atomic_store_ptr(&worker->acquired, NULL);
+        worker->waits_ns[i] = worker->acquired_ns - start_ns;
+
+        aws_http_connection_manager_release_connection(worker->manager, connection);
+    }
+}
+
+static void s_on_manager_shutdown_complete(void *user_data) {
+    (void)user_data;
+    aws_mutex_lock(&s_contention.lock);
+    s_contention.manager_shutdown_complete = true;
+    aws_condition_variable_notify_all(&s_contention.signal);
+    aws_mutex_unlock(&s_contention.lock);
+}
+
+static bool s_manager_shutdown_complete_pred(void *user_data) {
+    (void)user_data;
+    return s_contention.manager_shutdown_complete;
+}
+
+static int s_compare_u64(const void *a, const void *b) {
+    uint64_t value_a = *(const uint64_t *)a;
+    uint64_t value_b = *(const uint64_t *)b;
+    return value_a < value_b ? -1 : (value_a > value_b);
+}
+
+static int s_run_case(
+    struct aws_allocator *allocator,
+    struct aws_client_bootstrap *bootstrap,
+    size_t num_threads,
+    size_t pool_size,
+    size_t iterations) {
+
+    struct aws_socket_options socket_options = {
+        .type = AWS_SOCKET_STREAM,
+        .domain = AWS_SOCKET_IPV4,
+        .connect_timeout_ms = 10000,
+    };
+    struct aws_http_connection_manager_options manager_options = {
+        .bootstrap = bootstrap,
+        .initial_window_size = SIZE_MAX,
+        .socket_options = &socket_options,
+        .host = aws_byte_cursor_from_c_str("httpbench.invalid"),
+        .port = 80,
+        .max_connections = pool_size,
+        .shutdown_complete_callback = s_on_manager_shutdown_complete,
+    };
+
+    s_contention.manager_shutdown_complete = false;
+    g_aws_http_connection_manager_default_system_vtable_ptr = &s_mock_vtable;
+    struct aws_http_connection_manager *manager = aws_http_connection_manager_new(allocator, &manager_options);
+    if (!manager) {
+        return AWS_OP_ERR;
+    }
+    aws_http_connection_manager_set_system_vtable(manager, &s_mock_vtable);
+
+    const size_t ops_per_thread = aws_max_size(iterations / num_threads, 1);
+    const size_t total_ops = ops_per_thread * num_threads;
+    uint64_t *waits_ns = aws_mem_calloc(allocator, total_ops, sizeof(uint64_t));
+    struct contention_worker *workers = aws_mem_calloc(allocator, num_threads, sizeof(struct contention_worker));
+    struct aws_atomic_var start;
+    aws_atomic_init_int(&start, 0);
+
+    int result = AWS_OP_SUCCESS;
+    size_t launched = 0;
+    for (; launched < num_threads; ++launched) {
+        struct contention_worker *worker = &workers[launched];
+        worker->manager = manager;
+        worker->start = &start;
+        worker->ops = ops_per_thread;
+        worker->waits_ns = waits_ns + launched * ops_per_thread;
+        aws_atomic_init_ptr(&worker->acquired, NULL);
+        if (aws_thread_init(&worker->thread, allocator)) {
+            result = AWS_OP_ERR;
+            break;
+        }
+        if (aws_thread_launch(&worker->thread, s_worker_thread, worker, NULL)) {
+            aws_thread_clean_up(&worker->thread);
+            result = AWS_OP_ERR;
+            break;
+        }
+    }
+
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    aws_high_res_clock_get_ticks(&start_ns);
+    if (result) {
+        /* Let the threads that did launch run, so they can be joined */
+        for (size_t i = 0; i < launched; ++i) {
+            workers[i].ops = 0;
+        }
+    }
+    aws_atomic_store_int(&start, 1);
+    for (size_t i = 0; i < launched; ++i) {
+        aws_thread_join(&workers[i].thread);
+        aws_thread_clean_up(&workers[i].thread);
+    }
+    aws_high_res_clock_get_ticks(&end_ns);
+
+    if (!result) {
+        qsort(waits_ns, total_ops, sizeof(uint64_t), s_compare_u64);
+        const double elapsed_ns = (double)(end_ns - start_ns);
+        printf(
+            "  threads=%3zu pool=%3zu  %11.0f ops/sec  %8.1f serial ns/op  wait p50=%8" PRIu64 " ns  p99=%8" PRIu64
+            " ns\n",
+            num_threads,
+            pool_size,
+            (double)total_ops * 1e9 / elapsed_ns,
+            elapsed_ns / (double)total_ops,
+            waits_ns[total_ops / 2],
+            waits_ns[(size_t)((double)(total_ops - 1) * 0.99)]);
+    }
+
+    /* All connections are idle again, so the manager releases them and finishes shutting down.
+     * That may happen before release returns, and the callback takes the lock. */
+    aws_http_connection_manager_release(manager);
+    aws_mutex_lock(&s_contention.lock);
+    aws_condition_variable_wait_pred(&s_contention.signal, &s_contention.lock, s_manager_shutdown_complete_pred, NULL);
+    for (size_t i = 0; i < aws_array_list_length(&s_contention.connections); ++i) {
+        struct contention_connection *connection = NULL;
+        aws_array_list_get_at(&s_contention.connections, &connection, i);
+        aws_mem_release(allocator, connection);
+    }
+    aws_array_list_clear(&s_contention.connections);
+    aws_mutex_unlock(&s_contention.lock);
+
+    aws_mem_release(allocator, workers);
+    aws_mem_release(allocator, waits_ns);
+    return result;
+}
+
+int httpbench_manager_contention(struct aws_allocator *allocator, size_t iterations) {
+    s_contention.allocator = allocator;
+    aws_mutex_init(&s_contention.lock);
+    aws_condition_variable_init(&s_contention.signal);
+    aws_array_list_init_dynamic(&s_contention.connections, allocator, 64, sizeof(struct contention_connection *));
+
+    int result = AWS_OP_ERR;
+    struct aws_event_loop_group *el_group = aws_event_loop_group_new_default(allocator, 1, NULL);
+    struct aws_host_resolver *resolver = NULL;
+    struct aws_client_bootstrap *bootstrap = NULL;
+    if (!el_group) {
+        goto done;
+    }
+
+    struct aws_host_resolver_default_options resolver_options = {
+        .el_group = el_group,
+        .max_entries = 8,
+    };
+    resolver = aws_host_resolver_new_default(allocator, &resolver_options);
+    if (!resolver) {
+        goto done;
+    }
+
+    struct aws_client_bootstrap_options bootstrap_options = {
+        .event_loop_group = el_group,
+        .host_resolver = resolver,
+    };
+    bootstrap = aws_client_bootstrap_new(allocator, &bootstrap_options);
+    if (!bootstrap) {
+        goto done;
+    }
+
+    const size_t max_threads = aws_max_size(aws_system_info_processor_count(), 1);
+    result = AWS_OP_SUCCESS;
+    for (size_t threads = 1; !result; threads *= 2) {
+        threads = aws_min_size(threads, max_threads);
+        result = s_run_case(allocator, bootstrap, threads, threads, iterations);
+        if (!result && threads > 1) {
+            result = s_run_case(allocator, bootstrap, threads, threads / 2, iterations);
+        }
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+done:
+    aws_client_bootstrap_release(bootstrap);
+    aws_host_resolver_release(resolver);
+    aws_event_loop_group_release(el_group);
+    aws_array_list_clean_up(&s_contention.connections);
+    aws_condition_variable_clean_up(&s_contention.signal);
+    aws_mutex_clean_up(&s_contention.lock);
+    return result;
+}
@@ -0,0 +1,1135 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/http/connection_manager.h>
+#include <aws/http/http2_stream_manager.h>
+#include <aws/http/private/connection_manager_system_vtable.h>
+#include <aws/http/private/http2_stream_manager_system_vtable.h>
+#include <aws/http/request_response.h>
+
+#include <aws/common/array_list.h>
+#include <aws/common/clock.h>
+#include <aws/common/command_line_parser.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/mutex.h>
+#include <aws/common/priority_queue.h>
+
+#include <aws/io/channel.h>
+#include <aws/io/channel_bootstrap.h>
+#include <aws/io/event_loop.h>
+#include <aws/io/host_resolver.h>
+#include <aws/io/socket.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#    pragma warning(disable : 4996) /* Disable warnings about fopen() being insecure */
+#    pragma warning(disable : 4204) /* Declared initializers */
+#endif
+
+/**
+ * poolsim replays a request trace against the real aws_http_connection_manager, on a virtual clock.
+ *
+ * The manager's system vtable is replaced so that connecting, closing, and reading the clock are all simulated.
+ * Connection setup takes a synthetic latency and may fail, and each request holds its connection for its service
+ * time. Events are processed in virtual time order, so a run is deterministic for a given trace and seed,
+ * and takes as long as the manager's own logic, not as long as the trace.
+ *
+ * With --http2, requests go through the real aws_http2_stream_manager instead, on top of its own connection manager.
+ * The stream manager's system vtable is replaced too, so its streams are simulated, and the channel tasks it schedules
+ * to make requests run as events at the current virtual time. Each request holds a stream for its service time.
+ *
+ * The manager culls idle connections from a task on a real event loop. That event loop has its own copy of the
+ * virtual clock, which only catches up while the simulator waits for the event loop to run whatever became due.
+ * So culling never runs concurrently with the simulator's own event processing.
+ */
+
+struct poolsim_request {
+    uint64_t arrival_ns;
+    uint64_t service_ns;
+    uint64_t acquired_ns;
+    bool is_prewarm;
+};
+
+struct poolsim_connection {
+    uint64_t created_ns;
+    size_t requests_served;
+    size_t open_streams;
+    size_t peak_open_streams;
+    bool is_connected;
+    bool is_released;
+    bool is_closed;
+    aws_http_on_client_connection_shutdown_fn *on_shutdown;
+    aws_http2_on_change_settings_complete_fn *on_initial_settings_completed;
+    void *user_data;
+};
+
+/* A simulated HTTP/2 stream, handed to the stream manager as an aws_http_stream */
+struct poolsim_stream {
+    struct poolsim_connection *connection;
+    struct aws_http_make_request_options options;
+};
+
+enum poolsim_event_type {
+    POOLSIM_EVENT_CONNECT_DONE,
+    POOLSIM_EVENT_REQUEST_ARRIVAL,
+    POOLSIM_EVENT_REQUEST_DONE,
+    POOLSIM_EVENT_CHANNEL_TASK,
+    POOLSIM_EVENT_SAMPLE,
+};
+
+struct poolsim_event {
+    uint64_t time_ns;
+    uint64_t sequence; /* Break ties in the order events were scheduled */
+    enum poolsim_event_type type;
+    struct poolsim_request *request;
+    struct poolsim_connection *connection;
+    struct poolsim_stream *stream;
+    struct aws_channel_task *channel_task;
+    aws_http_on_client_connection_setup_fn *on_setup;
+    void *user_data;
+};
+
+struct poolsim_ctx {
+    struct aws_allocator *allocator;
+
+    /* Options */
+    const char *trace_file;
+    double rate_per_sec;
+    uint64_t duration_ms;
+    uint64_t service_ms;
+    size_t max_connections;
+    uint64_t idle_ms;
+    size_t prewarm;
+    uint64_t connect_ms;
+    uint64_t connect_jitter_ms;
+    double connect_failure_rate;
+    size_t max_requests_per_connection;
+    uint64_t sample_ms;
+    uint64_t seed;
+    bool http2;
+    uint32_t max_concurrent_streams;
+    size_t ideal_streams;
+
+    /* Simulation */
+    struct aws_mutex clock_lock;
+    uint64_t now_ns;
+    uint64_t event_loop_now_ns;
+    uint64_t random_state;
+    uint64_t next_sequence;
+    struct aws_priority_queue events;
+    struct aws_array_list requests;    /* struct poolsim_request */
+    struct aws_array_list connections; /* struct poolsim_connection * */
+    size_t outstanding_count;          /* Requests not done yet, and connects not finished yet */
+    uint64_t last_activity_ns;
+
+    struct aws_event_loop_group *event_loop_group;
+    struct aws_host_resolver *host_resolver;
+    struct aws_client_bootstrap *bootstrap;
+    struct aws_http_connection_manager *manager;
+    struct aws_http2_stream_manager *stream_manager;
+    struct aws_http_message *request_message;
+
+    struct aws_mutex sync_lock;
+    struct aws_condition_variable sync_signal;
+    bool event_loop_synced;
+    bool manager_shutdown_complete;
+
+    /* Results */
+    size_t open_connections;
+    size_t connects;
+    size_t connect_failures;
+    size_t closed_connections;
+    uint64_t total_connection_lifetime_ns;
+    size_t acquisition_failures;
+    struct aws_array_list acquisition_waits_ns; /* uint64_t */
+};
+
+static struct poolsim_ctx s_ctx;
+
+static void s_usage(int exit_code) {
+    fprintf(stderr, "usage: poolsim [options]\n");
+    fprintf(stderr, "\n Traffic (a trace file, or a synthetic load):\n\n");
+    fprintf(stderr, "      --trace FILE: lines of \"arrival_ms service_ms\", sorted or not.\n");
+    fprintf(stderr, "      --rate FLOAT: synthetic requests per second. Default is 100.\n");
+    fprintf(stderr, "      --duration INT: synthetic load duration in milliseconds. Default is 60000.\n");
+    fprintf(stderr, "      --service INT: mean synthetic service time in milliseconds. Default is 50.\n");
+    fprintf(stderr, "\n Pool policy:\n\n");
+    fprintf(stderr, "      --max-connections INT: connection manager max_connections. Default is 16.\n");
+    fprintf(stderr, "      --idle INT: max_connection_idle_in_milliseconds, 0 to never cull. Default is 0.\n");
+    fprintf(stderr, "      --prewarm INT: connections to acquire and release before traffic starts.\n");
+    fprintf(stderr, "\n Simulated network and server:\n\n");
+    fprintf(stderr, "      --connect INT: connection setup latency in milliseconds. Default is 20.\n");
+    fprintf(stderr, "      --connect-jitter INT: up to this many extra milliseconds of setup latency.\n");
+    fprintf(stderr, "      --connect-failure-rate FLOAT: fraction of connection attempts that fail.\n");
+    fprintf(stderr, "      --max-requests-per-connection INT: server closes a connection after this many.\n");
+    fprintf(stderr, "\n HTTP/2:\n\n");
+    fprintf(stderr, "      --http2: simulate aws_http2_stream_manager instead of the connection manager.\n");
+    fprintf(stderr, "      --max-concurrent-streams INT: server's SETTINGS_MAX_CONCURRENT_STREAMS. Default is 100.\n");
+    fprintf(stderr, "      --ideal-streams INT: ideal_concurrent_streams_per_connection, 0 for no limit.\n");
+    fprintf(stderr, "\n Output:\n\n");
+    fprintf(stderr, "      --sample INT: pool size sampling interval in milliseconds. Default is 1000.\n");
+    fprintf(stderr, "      --seed INT: random seed. Default is 1.\n");
+    fprintf(stderr, "  -h, --help\n");
+    fprintf(stderr, "            Display this message and quit.\n");
+    exit(exit_code);
+}
+
+static struct aws_cli_option s_long_options[] = {
+    {"trace", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 't'},
+    {"rate", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'r'},
+    {"duration", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'd'},
+    {"service", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 's'},
+    {"max-connections", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'm'},
+    {"idle", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'i'},
+    {"prewarm", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'p'},
+    {"connect", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'c'},
+    {"connect-jitter", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'j'},
+    {"connect-failure-rate", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'f'},
+    {"max-requests-per-connection", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'q'},
+    {"http2", AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 'H'},
+    {"max-concurrent-streams", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'M'},
+    {"ideal-streams", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'I'},
+    {"sample", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'S'},
+    {"seed", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'x'},
+    {"help", AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 'h'},
+    /* Per getopt(3) the last element of the array has to be filled with all zeros */
+    {NULL, AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 0},
+};
+
+static void s_parse_options(int argc, char **argv, struct poolsim_ctx *ctx) {
+    while (true) {
+        int option_index = 0;
+        int c = aws_cli_getopt_long(argc, argv, "t:r:d:s:m:i:p:c:j:f:q:HM:I:S:x:h", s_long_options, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 0:
+                /* getopt_long() returns 0 if an option.flag is non-null */
+                break;
+            case 't':
+                ctx->trace_file = aws_cli_optarg;
+                break;
+            case 'r':
+                ctx->rate_per_sec = atof(aws_cli_optarg);
+                break;
+            case 'd':
+                ctx->duration_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 's':
+                ctx->service_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'm':
+                ctx->max_connections = (size_t)strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'i':
+                ctx->idle_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'p':
+                ctx->prewarm = (size_t)strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'c':
+                ctx->connect_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'j':
+                ctx->connect_jitter_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'f':
+                ctx->connect_failure_rate = atof(aws_cli_optarg);
+                break;
+            case 'q':
+                ctx->max_requests_per_connection = (size_t)strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'H':
+                ctx->http2 = true;
+                break;
+            case 'M':
+                ctx->max_concurrent_streams = (uint32_t)strtoul(aws_cli_optarg, NULL, 10);
+                break;
+            case 'I':
+                ctx->ideal_streams = (size_t)strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'S':
+                ctx->sample_ms = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'x':
+                ctx->seed = strtoull(aws_cli_optarg, NULL, 10);
+                break;
+            case 'h':
+                s_usage(0);
+                break;
+            default:
+                fprintf(stderr, "Unknown option\n");
+                s_usage(1);
+        }
+    }
+
+    if (ctx->max_connections == 0 || ctx->sample_ms == 0) {
+        fprintf(stderr, "--max-connections and --sample must be positive\n");
+        s_usage(1);
+    }
+    if (!ctx->trace_file && (ctx->rate_per_sec <= 0.0 || ctx->duration_ms == 0)) {
+        fprintf(stderr, "--rate and --duration must be positive\n");
+        s_usage(1);
+    }
+    if (ctx->http2 && (ctx->idle_ms || ctx->prewarm)) {
+        /* The stream manager has neither, its connection manager never culls and is never pre-warmed */
+        fprintf(stderr, "--idle and --prewarm don't apply to --http2\n");
+        s_usage(1);
+    }
+    if (ctx->http2 && ctx->max_concurrent_streams == 0) {
+        fprintf(stderr, "--max-concurrent-streams must be positive\n");
+        s_usage(1);
+    }
+}
+
+static uint64_t s_ms_to_ns(uint64_t ms) {
+    return aws_timestamp_convert(ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+}
+
+static double s_ns_to_ms(uint64_t ns) {
+    return (double)ns / 1000000.0;
+}
+
+/* Deterministic random numbers, so runs can be compared */
+static uint64_t s_random(void) {
+    uint64_t x = s_ctx.random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    s_ctx.random_state = x;
+    return x;
+}
+
+/* Uniform in [0, 1) */
+static double s_random_unit(void) {
+    return (double)(s_random() >> 11) / (double)(1ULL << 53);
+}
+
+/*****************************************************************************************************************
+ * Virtual clock and event queue
+ ****************************************************************************************************************/
+
+static int s_get_virtual_time(uint64_t *timestamp) {
+    aws_mutex_lock(&s_ctx.clock_lock);
+    *timestamp = s_ctx.now_ns;
+    aws_mutex_unlock(&s_ctx.clock_lock);
+    return AWS_OP_SUCCESS;
+}
+
+/* The event loop's clock, read from the event loop thread */
+static int s_get_event_loop_time(uint64_t *timestamp) {
+    aws_mutex_lock(&s_ctx.clock_lock);
+    *timestamp = s_ctx.event_loop_now_ns;
+    aws_mutex_unlock(&s_ctx.clock_lock);
+    return AWS_OP_SUCCESS;
+}
+
+static void s_set_virtual_time(uint64_t timestamp) {
+    aws_mutex_lock(&s_ctx.clock_lock);
+    s_ctx.now_ns = timestamp;
+    aws_mutex_unlock(&s_ctx.clock_lock);
+}
+
+static uint64_t s_now(void) {
+    uint64_t now = 0;
+    s_get_virtual_time(&now);
+    return now;
+}
+
+static int s_compare_events(const void *a, const void *b) {
+    const struct poolsim_event *event_a = a;
+    const struct poolsim_event *event_b = b;
+    if (event_a->time_ns != event_b->time_ns) {
+        return event_a->time_ns < event_b->time_ns ? -1 : 1;
+    }
+    return event_a->sequence < event_b->sequence ? -1 : (event_a->sequence > event_b->sequence);
+}
+
+static void s_schedule_event(struct poolsim_event *event) {
+    event->sequence = s_ctx.next_sequence++;
+    if (event->type != POOLSIM_EVENT_SAMPLE) {
+        ++s_ctx.outstanding_count;
+    }
+    AWS_FATAL_ASSERT(aws_priority_queue_push(&s_ctx.events, event) == AWS_OP_SUCCESS);
+}
+
+static void s_event_loop_sync_second_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)status;
+    struct aws_allocator *allocator = arg;
+    aws_mem_release(allocator, task);
+
+    aws_mutex_lock(&s_ctx.sync_lock);
+    s_ctx.event_loop_synced = true;
+    aws_condition_variable_notify_all(&s_ctx.sync_signal);
+    aws_mutex_unlock(&s_ctx.sync_lock);
+}
+
+static void s_event_loop_sync_first_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)status;
+    struct aws_allocator *allocator = arg;
+    /* Tasks that are due now may run after this one in the same pass. Anything scheduled from here runs on a
+     * later pass, after all of them. */
+    aws_task_init(task, s_event_loop_sync_second_task, allocator, "poolsim_event_loop_sync");
+    aws_event_loop_schedule_task_now(aws_event_loop_group_get_loop_at(s_ctx.event_loop_group, 0), task);
+}
+
+static bool s_event_loop_synced_pred(void *user_data) {
+    (void)user_data;
+    return s_ctx.event_loop_synced;
+}
+
+/* Wait for the event loop to run every task that's due at the current virtual time (ex: culling idle connections) */
+static void s_sync_event_loop(void) {
+    if (s_ctx.idle_ms == 0) {
+        /* Culling is the only thing the manager does from the event loop */
+        return;
+    }
+
+    struct aws_task *task = aws_mem_calloc(s_ctx.allocator, 1, sizeof(struct aws_task));
+    aws_task_init(task, s_event_loop_sync_first_task, s_ctx.allocator, "poolsim_event_loop_sync");
+
+    aws_mutex_lock(&s_ctx.clock_lock);
+    s_ctx.event_loop_now_ns = s_ctx.now_ns;
+    const uint64_t now = s_ctx.now_ns;
+    aws_mutex_unlock(&s_ctx.clock_lock);
+
+    aws_mutex_lock(&s_ctx.sync_lock);
+    s_ctx.event_loop_synced = false;
+    aws_event_loop_schedule_task_future(aws_event_loop_group_get_loop_at(s_ctx.event_loop_group, 0), task, now);
+    aws_condition_variable_wait_pred(&s_ctx.sync_signal, &s_ctx.sync_lock, s_event_loop_synced_pred, NULL);
+    aws_mutex_unlock(&s_ctx.sync_lock);
+}
+
+/*****************************************************************************************************************
+ * Simulated system, installed as the connection manager's system vtable
+ ****************************************************************************************************************/
+
+static int s_sim_client_connect(const struct aws_http_client_connection_options *options) {
+    struct poolsim_connection *connection = aws_mem_calloc(s_ctx.allocator, 1, sizeof(struct poolsim_connection));
+    connection->on_shutdown = options->on_shutdown;
+    if (options->http2_options) {
+        connection->on_initial_settings_completed = options->http2_options->on_initial_settings_completed;
+    }
+    connection->user_data = options->user_data;
+    aws_array_list_push_back(&s_ctx.connections, &connection);
+    ++s_ctx.connects;
+
+    uint64_t latency_ms = s_ctx.connect_ms;
+    if (s_ctx.connect_jitter_ms) {
+        latency_ms += s_random() % (s_ctx.connect_jitter_ms + 1);
+    }
+
+    struct poolsim_event event = {
+        .time_ns = s_now() + s_ms_to_ns(latency_ms),
+        .type = POOLSIM_EVENT_CONNECT_DONE,
+        .connection = connection,
+        .on_setup = options->on_setup,
+        .user_data = options->user_data,
+    };
+    s_schedule_event(&event);
+    return AWS_OP_SUCCESS;
+}
+
+/* The manager releases a connection it won't use again. A real connection would shut down and then report it. */
+static void s_sim_connection_release(struct aws_http_connection *http_connection) {
+    struct poolsim_connection *connection = (struct poolsim_connection *)(void *)http_connection;
+    connection->is_closed = true;
+    connection->is_released = true;
+    AWS_FATAL_ASSERT(s_ctx.open_connections > 0);
+    --s_ctx.open_connections;
+    ++s_ctx.closed_connections;
+    s_ctx.total_connection_lifetime_ns += s_now() - connection->created_ns;
+    connection->on_shutdown(http_connection, AWS_ERROR_SUCCESS, connection->user_data);
+}
+
+static void s_sim_connection_close(struct aws_http_connection *http_connection) {
+    struct poolsim_connection *connection = (struct poolsim_connection *)(void *)http_connection;
+    connection->is_closed = true;
+}
+
+static bool s_sim_connection_new_requests_allowed(const struct aws_http_connection *http_connection) {
+    const struct poolsim_connection *connection = (const struct poolsim_connection *)(const void *)http_connection;
+    return !connection->is_closed;
+}
+
+static bool s_sim_channel_thread_is_callers_thread(struct aws_channel *channel) {
+    (void)channel;
+    /* So the manager completes acquisitions immediately, instead of scheduling them on the connection's channel */
+    return true;
+}
+
+static struct aws_channel *s_sim_connection_get_channel(struct aws_http_connection *http_connection) {
+    (void)http_connection;
+    return (struct aws_channel *)1;
+}
+
+static enum aws_http_version s_sim_connection_get_version(const struct aws_http_connection *http_connection) {
+    (void)http_connection;
+    return s_ctx.http2 ? AWS_HTTP_VERSION_2 : AWS_HTTP_VERSION_1_1;
+}
+
+static struct aws_http_connection_manager_system_vtable s_sim_vtable = {
+    .aws_http_client_connect = s_sim_client_connect,
+    .aws_http_connection_close = s_sim_connection_close,
+    .aws_http_connection_release = s_sim_connection_release,
+    .aws_http_connection_new_requests_allowed = s_sim_connection_new_requests_allowed,
+    .aws_high_res_clock_get_ticks = s_get_virtual_time,
+    .aws_channel_thread_is_callers_thread = s_sim_channel_thread_is_callers_thread,
+    .aws_http_connection_get_channel = s_sim_connection_get_channel,
+    .aws_http_connection_get_version = s_sim_connection_get_version,
+};
+
+/*****************************************************************************************************************
+ * Simulated HTTP/2 streams and channels, installed as the stream manager's system vtable
+ ****************************************************************************************************************/
+
+static struct aws_http_stream *s_sim_make_request(
+    struct aws_http_connection *http_connection,
+    const struct aws_http_make_request_options *options) {
+    struct poolsim_connection *connection = (struct poolsim_connection *)(void *)http_connection;
+    if (connection->is_closed) {
+        aws_raise_error(AWS_ERROR_HTTP_CONNECTION_CLOSED);
+        return NULL;
+    }
+    struct poolsim_stream *stream = aws_mem_calloc(s_ctx.allocator, 1, sizeof(struct poolsim_stream));
+    stream->connection = connection;
+    stream->options = *options;
+    return (struct aws_http_stream *)(void *)stream;
+}
+
+static int s_sim_stream_activate(struct aws_http_stream *http_stream) {
+    struct poolsim_stream *stream = (struct poolsim_stream *)(void *)http_stream;
+    struct poolsim_connection *connection = stream->connection;
+    ++connection->open_streams;
+    connection->peak_open_streams = aws_max_size(connection->peak_open_streams, connection->open_streams);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_sim_stream_get_incoming_response_status(const struct aws_http_stream *http_stream, int *out_status) {
+    (void)http_stream;
+    *out_status = 200;
+    return AWS_OP_SUCCESS;
+}
+
+static void s_sim_connection_get_remote_settings(
+    const struct aws_http_connection *http_connection,
+    struct aws_http2_setting out_settings[AWS_HTTP2_SETTINGS_COUNT]) {
+    (void)http_connection;
+    for (int i = 0; i < AWS_HTTP2_SETTINGS_COUNT; ++i) {
+        /* The setting id equals to the index plus one */
+        out_settings[i].id = (enum aws_http2_settings_id)(i + 1);
+        out_settings[i].value = 0;
+    }
+    out_settings[AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS - 1].value = s_ctx.max_concurrent_streams;
+}
+
+static int s_sim_connection_ping(
+    struct aws_http_connection *http_connection,
+    const struct aws_byte_cursor *optional_opaque_data,
+    aws_http2_on_ping_complete_fn *on_completed,
+    void *user_data) {
+    (void)http_connection;
+    (void)optional_opaque_data;
+    (void)on_completed;
+    (void)user_data;
+    /* poolsim never configures connection_ping_period_ms */
+    return aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);
+}
+
+static void s_sim_channel_schedule_task_future(
+    struct aws_channel *channel,
+    struct aws_channel_task *task,
+    uint64_t run_at_nanos) {
+    (void)channel;
+    struct poolsim_event event = {
+        .time_ns = aws_max_u64(run_at_nanos, s_now()),
+        .type = POOLSIM_EVENT_CHANNEL_TASK,
+        .channel_task = task,
+    };
+    s_schedule_event(&event);
+}
+
+static void s_sim_channel_schedule_task_now(struct aws_channel *channel, struct aws_channel_task *task) {
+    s_sim_channel_schedule_task_future(channel, task, s_now());
+}
+
+static int s_sim_channel_current_clock_time(struct aws_channel *channel, uint64_t *time_nanos) {
+    (void)channel;
+    return s_get_virtual_time(time_nanos);
+}
+
+static struct aws_http2_stream_manager_system_vtable s_sim_stream_manager_vtable = {
+    .aws_http_connection_make_request = s_sim_make_request,
+    .aws_http_stream_activate = s_sim_stream_activate,
+    .aws_http_stream_get_incoming_response_status = s_sim_stream_get_incoming_response_status,
+    .aws_http2_connection_get_remote_settings = s_sim_connection_get_remote_settings,
+    .aws_http2_connection_ping = s_sim_connection_ping,
+    .aws_http_connection_new_requests_allowed = s_sim_connection_new_requests_allowed,
+    .aws_http_connection_stop_new_requests = s_sim_connection_close,
+    .aws_http_connection_close = s_sim_connection_close,
+    .aws_http_connection_get_version = s_sim_connection_get_version,
+    .aws_http_connection_get_channel = s_sim_connection_get_channel,
+    .aws_channel_thread_is_callers_thread = s_sim_channel_thread_is_callers_thread,
+    .aws_channel_schedule_task_now = s_sim_channel_schedule_task_now,
+    .aws_channel_schedule_task_future = s_sim_channel_schedule_task_future,
+    .aws_channel_current_clock_time = s_sim_channel_current_clock_time,
+    .aws_high_res_clock_get_ticks = s_get_virtual_time,
+};
+
+/*****************************************************************************************************************
+ * Traffic
+ ****************************************************************************************************************/
+
+static void s_on_connection_acquired(struct aws_http_connection *http_connection, int error_code, void *user_data) {
+    struct poolsim_request *request = user_data;
+    if (error_code) {
+        if (!request->is_prewarm) {
+            ++s_ctx.acquisition_failures;
+        }
+        --s_ctx.outstanding_count;
+        return;
+    }
+
+    request->acquired_ns = s_now();
+    if (request->is_prewarm) {
+        /* Pre-warming only wants the connection to exist, give it right back */
+        --s_ctx.outstanding_count;
+        aws_http_connection_manager_release_connection(s_ctx.manager, http_connection);
+        return;
+    }
+
+    uint64_t wait_ns = request->acquired_ns - request->arrival_ns;
+    aws_array_list_push_back(&s_ctx.acquisition_waits_ns, &wait_ns);
+
+    struct poolsim_event event = {
+        .time_ns = request->acquired_ns + request->service_ns,
+        .type = POOLSIM_EVENT_REQUEST_DONE,
+        .request = request,
+        .connection = (struct poolsim_connection *)(void *)http_connection,
+    };
+    /* The arrival event's count carries over to the done event */
+    s_schedule_event(&event);
+    --s_ctx.outstanding_count;
+}
+
+static void s_on_stream_acquired(struct aws_http_stream *http_stream, int error_code, void *user_data) {
+    struct poolsim_request *request = user_data;
+    if (error_code) {
+        ++s_ctx.acquisition_failures;
+        --s_ctx.outstanding_count;
+        return;
+    }
+
+    request->acquired_ns = s_now();
+    uint64_t wait_ns = request->acquired_ns - request->arrival_ns;
+    aws_array_list_push_back(&s_ctx.acquisition_waits_ns, &wait_ns);
+
+    struct poolsim_event event = {
+        .time_ns = request->acquired_ns + request->service_ns,
+        .type = POOLSIM_EVENT_REQUEST_DONE,
+        .request = request,
+        .stream = (struct poolsim_stream *)(void *)http_stream,
+    };
+    s_schedule_event(&event);
+    --s_ctx.outstanding_count;
+}
+
+static void s_acquire_connection(struct poolsim_request *request) {
+    /* Count the acquisition as outstanding until its callback fires */
+    ++s_ctx.outstanding_count;
+    if (s_ctx.http2) {
+        struct aws_http_make_request_options request_options = {
+            .self_size = sizeof(request_options),
+            .request = s_ctx.request_message,
+        };
+        struct aws_http2_stream_manager_acquire_stream_options acquire_options = {
+            .options = &request_options,
+            .callback = s_on_stream_acquired,
+            .user_data = request,
+        };
+        aws_http2_stream_manager_acquire_stream(s_ctx.stream_manager, &acquire_options);
+        return;
+    }
+    aws_http_connection_manager_acquire_connection(s_ctx.manager, s_on_connection_acquired, request);
+}
+
+/* The server is done with a stream. It completes, and the stream manager then lets go of it. */
+static void s_complete_stream(struct poolsim_stream *stream) {
+    struct poolsim_connection *connection = stream->connection;
+    AWS_FATAL_ASSERT(connection->open_streams > 0);
+    --connection->open_streams;
+    ++connection->requests_served;
+    if (s_ctx.max_requests_per_connection && connection->requests_served >= s_ctx.max_requests_per_connection) {
+        /* Server closes the connection, the stream manager finds out when this stream completes */
+        connection->is_closed = true;
+    }
+    struct aws_http_stream *http_stream = (struct aws_http_stream *)(void *)stream;
+    if (stream->options.on_complete) {
+        stream->options.on_complete(http_stream, AWS_ERROR_SUCCESS, stream->options.user_data);
+    }
+    if (stream->options.on_destroy) {
+        stream->options.on_destroy(stream->options.user_data);
+    }
+    aws_mem_release(s_ctx.allocator, stream);
+}
+
+static void s_handle_event(struct poolsim_event *event) {
+    switch (event->type) {
+        case POOLSIM_EVENT_CONNECT_DONE: {
+            struct poolsim_connection *connection = event->connection;
+            if (s_random_unit() < s_ctx.connect_failure_rate) {
+                ++s_ctx.connect_failures;
+                connection->is_closed = true;
+                event->on_setup(NULL, AWS_IO_SOCKET_TIMEOUT, event->user_data);
+            } else {
+                struct aws_http_connection *http_connection = (struct aws_http_connection *)(void *)connection;
+                connection->created_ns = s_now();
+                connection->is_connected = true;
+                ++s_ctx.open_connections;
+                event->on_setup(http_connection, AWS_ERROR_SUCCESS, event->user_data);
+                if (connection->on_initial_settings_completed) {
+                    /* An HTTP/2 connection is only handed out once the server's settings arrive, with no delay here */
+                    connection->on_initial_settings_completed(http_connection, AWS_ERROR_SUCCESS, event->user_data);
+                }
+            }
+            break;
+        }
+        case POOLSIM_EVENT_REQUEST_ARRIVAL:
+            s_acquire_connection(event->request);
+            break;
+        case POOLSIM_EVENT_REQUEST_DONE: {
+            if (event->stream) {
+                s_complete_stream(event->stream);
+                break;
+            }
+            struct poolsim_connection *connection = event->connection;
+            ++connection->requests_served;
+            if (s_ctx.max_requests_per_connection &&
+                connection->requests_served >= s_ctx.max_requests_per_connection) {
+                /* Server closes the connection, the manager finds out when it's released */
+                connection->is_closed = true;
+            }
+            aws_http_connection_manager_release_connection(
+                s_ctx.manager, (struct aws_http_connection *)(void *)connection);
+            break;
+        }
+        case POOLSIM_EVENT_CHANNEL_TASK: {
+            struct aws_channel_task *task = event->channel_task;
+            task->task_fn(task, task->arg, AWS_TASK_STATUS_RUN_READY);
+            break;
+        }
+        case POOLSIM_EVENT_SAMPLE:
+            break;
+    }
+}
+
+static void s_print_sample(void) {
+    struct aws_http_manager_metrics metrics;
+    if (!s_ctx.http2) {
+        aws_http_connection_manager_fetch_metrics(s_ctx.manager, &metrics);
+        printf(
+            "%.0f,%zu,%zu,%zu,%zu\n",
+            s_ns_to_ms(s_now()),
+            s_ctx.open_connections,
+            metrics.available_concurrency,
+            metrics.leased_concurrency,
+            metrics.pending_concurrency_acquires);
+        return;
+    }
+
+    aws_http2_stream_manager_fetch_metrics(s_ctx.stream_manager, &metrics);
+    /* How evenly the open streams are spread over the open connections */
+    size_t min_streams = 0;
+    size_t max_streams = 0;
+    bool any_open = false;
+    for (size_t i = 0; i < aws_array_list_length(&s_ctx.connections); ++i) {
+        struct poolsim_connection *connection = NULL;
+        aws_array_list_get_at(&s_ctx.connections, &connection, i);
+        if (!connection->is_connected || connection->is_released) {
+            continue;
+        }
+        min_streams = any_open ? aws_min_size(min_streams, connection->open_streams) : connection->open_streams;
+        max_streams = aws_max_size(max_streams, connection->open_streams);
+        any_open = true;
+    }
+    printf(
+        "%.0f,%zu,%zu,%zu,%zu,%zu,%zu\n",
+        s_ns_to_ms(s_now()),
+        s_ctx.open_connections,
+        metrics.available_concurrency,
+        metrics.leased_concurrency,
+        metrics.pending_concurrency_acquires,
+        min_streams,
+        max_streams);
+}
+
+static int s_compare_requests(const void *a, const void *b) {
+    const struct poolsim_request *request_a = a;
+    const struct poolsim_request *request_b = b;
+    return request_a->arrival_ns < request_b->arrival_ns ? -1 : (request_a->arrival_ns > request_b->arrival_ns);
+}
+
+static int s_load_trace(void) {
+    FILE *file = fopen(s_ctx.trace_file, "r");
+    if (!file) {
+        fprintf(stderr, "unable to open trace file %s\n", s_ctx.trace_file);
+        return AWS_OP_ERR;
+    }
+
+    char line[256];
+    size_t line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        ++line_number;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+            continue;
+        }
+        double arrival_ms = 0.0;
+        double service_ms = 0.0;
+        if (sscanf(line, "%lf %lf", &arrival_ms, &service_ms) != 2 || arrival_ms < 0.0 || service_ms < 0.0) {
+            fprintf(stderr, "%s:%zu: expected \"arrival_ms service_ms\"\n", s_ctx.trace_file, line_number);
+            fclose(file);
+            return AWS_OP_ERR;
+        }
+        struct poolsim_request request = {
+            .arrival_ns = (uint64_t)(arrival_ms * 1000000.0),
+            .service_ns = (uint64_t)(service_ms * 1000000.0),
+        };
+        aws_array_list_push_back(&s_ctx.requests, &request);
+    }
+    fclose(file);
+    return AWS_OP_SUCCESS;
+}
+
+/* Arrivals spread uniformly at random over the duration make a Poisson process, given the count */
+static void s_generate_traffic(void) {
+    const size_t count = (size_t)(s_ctx.rate_per_sec * (double)s_ctx.duration_ms / 1000.0);
+    const uint64_t duration_ns = s_ms_to_ns(s_ctx.duration_ms);
+    const uint64_t service_ns = s_ms_to_ns(s_ctx.service_ms);
+    for (size_t i = 0; i < count; ++i) {
+        struct poolsim_request request = {
+            .arrival_ns = s_random() % duration_ns,
+            /* Uniform in [service/2, service*3/2] */
+            .service_ns = service_ns / 2 + (service_ns ? s_random() % (service_ns + 1) : 0),
+        };
+        aws_array_list_push_back(&s_ctx.requests, &request);
+    }
+}
+
+static int s_compare_u64(const void *a, const void *b) {
+    uint64_t value_a = *(const uint64_t *)a;
+    uint64_t value_b = *(const uint64_t *)b;
+    return value_a < value_b ? -1 : (value_a > value_b);
+}
+
+static double s_percentile_ms(const uint64_t *sorted, size_t count, double percentile) {
+    if (count == 0) {
+        return 0.0;
+    }
+    size_t index = (size_t)(percentile * (double)(count - 1));
+    return s_ns_to_ms(sorted[index]);
+}
+
+static void s_print_report(void) {
+    size_t count = aws_array_list_length(&s_ctx.acquisition_waits_ns);
+    uint64_t *waits = s_ctx.acquisition_waits_ns.data;
+    if (count) {
+        qsort(waits, count, sizeof(uint64_t), s_compare_u64);
+    }
+    uint64_t total_wait_ns = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total_wait_ns += waits[i];
+    }
+
+    printf("\n# acquisition wait (ms)\n");
+    printf(
+        "requests=%zu failed=%zu mean=%.3f p50=%.3f p90=%.3f p99=%.3f max=%.3f\n",
+        count,
+        s_ctx.acquisition_failures,
+        count ? s_ns_to_ms(total_wait_ns) / (double)count : 0.0,
+        s_percentile_ms(waits, count, 0.50),
+        s_percentile_ms(waits, count, 0.90),
+        s_percentile_ms(waits, count, 0.99),
+        count ? s_ns_to_ms(waits[count - 1]) : 0.0);
+
+    printf("\n# connection churn\n");
+    printf(
+        "connects=%zu connect_failures=%zu closed=%zu open_at_end=%zu mean_lifetime_ms=%.1f "
+        "requests_per_connection=%.1f\n",
+        s_ctx.connects,
+        s_ctx.connect_failures,
+        s_ctx.closed_connections,
+        s_ctx.open_connections,
+        s_ctx.closed_connections ? s_ns_to_ms(s_ctx.total_connection_lifetime_ns) / (double)s_ctx.closed_connections
+                                 : 0.0,
+        s_ctx.connects > s_ctx.connect_failures ? (double)count / (double)(s_ctx.connects - s_ctx.connect_failures)
+                                                : 0.0);
+
+    if (!s_ctx.http2) {
+        return;
+    }
+    size_t connected = 0;
+    size_t total_peak = 0;
+    size_t max_peak = 0;
+    size_t max_served = 0;
+    for (size_t i = 0; i < aws_array_list_length(&s_ctx.connections); ++i) {
+        struct poolsim_connection *connection = NULL;
+        aws_array_list_get_at(&s_ctx.connections, &connection, i);
+        if (!connection->is_connected) {
+            continue;
+        }
+        ++connected;
+        total_peak += connection->peak_open_streams;
+        max_peak = aws_max_size(max_peak, connection->peak_open_streams);
+        max_served = aws_max_size(max_served, connection->requests_served);
+    }
+    printf("\n# stream load per connection\n");
+    printf(
+        "max_concurrent_streams=%" PRIu32 " peak_streams_mean=%.1f peak_streams_max=%zu requests_max=%zu\n",
+        s_ctx.max_concurrent_streams,
+        connected ? (double)total_peak / (double)connected : 0.0,
+        max_peak,
+        max_served);
+}
+
+/*****************************************************************************************************************
+ * Setup and teardown
+ ****************************************************************************************************************/
+
+static struct aws_event_loop *s_new_event_loop(
+    struct aws_allocator *alloc,
+    const struct aws_event_loop_options *options,
+    void *new_loop_user_data) {
+    (void)new_loop_user_data;
+
+    return aws_event_loop_new_default(alloc, options->clock);
+}
+
+static void s_on_manager_shutdown_complete(void *user_data) {
+    (void)user_data;
+    aws_mutex_lock(&s_ctx.sync_lock);
+    s_ctx.manager_shutdown_complete = true;
+    aws_condition_variable_notify_all(&s_ctx.sync_signal);
+    aws_mutex_unlock(&s_ctx.sync_lock);
+}
+
+static bool s_manager_shutdown_complete_pred(void *user_data) {
+    (void)user_data;
+    return s_ctx.manager_shutdown_complete;
+}
+
+static int s_setup(void) {
+    s_ctx.event_loop_group =
+        aws_event_loop_group_new(s_ctx.allocator, s_get_event_loop_time, 1, s_new_event_loop, NULL, NULL);
+    if (!s_ctx.event_loop_group) {
+        return AWS_OP_ERR;
+    }
+
+    struct aws_host_resolver_default_options resolver_options = {
+        .el_group = s_ctx.event_loop_group,
+        .max_entries = 8,
+    };
+    s_ctx.host_resolver = aws_host_resolver_new_default(s_ctx.allocator, &resolver_options);
+    if (!s_ctx.host_resolver) {
+        return AWS_OP_ERR;
+    }
+
+    struct aws_client_bootstrap_options bootstrap_options = {
+        .event_loop_group = s_ctx.event_loop_group,
+        .host_resolver = s_ctx.host_resolver,
+    };
+    s_ctx.bootstrap = aws_client_bootstrap_new(s_ctx.allocator, &bootstrap_options);
+    if (!s_ctx.bootstrap) {
+        return AWS_OP_ERR;
+    }
+
+    struct aws_socket_options socket_options = {
+        .type = AWS_SOCKET_STREAM,
+        .domain = AWS_SOCKET_IPV4,
+        .connect_timeout_ms = 10000,
+    };
+
+    struct aws_http_connection_manager_options manager_options = {
+        .bootstrap = s_ctx.bootstrap,
+        .initial_window_size = SIZE_MAX,
+        .socket_options = &socket_options,
+        .host = aws_byte_cursor_from_c_str("poolsim.invalid"),
+        .port = 80,
+        .max_connections = s_ctx.max_connections,
+        .max_connection_idle_in_milliseconds = s_ctx.idle_ms,
+        .shutdown_complete_callback = s_on_manager_shutdown_complete,
+    };
+
+    /* The manager reads the clock while it's being created, so the vtable must be in place before that */
+    g_aws_http_connection_manager_default_system_vtable_ptr = &s_sim_vtable;
+
+    if (s_ctx.http2) {
+        s_ctx.request_message = aws_http2_message_new_request(s_ctx.allocator);
+        if (!s_ctx.request_message) {
+            return AWS_OP_ERR;
+        }
+        struct aws_http2_stream_manager_options stream_manager_options = {
+            .bootstrap = s_ctx.bootstrap,
+            .socket_options = &socket_options,
+            .host = aws_byte_cursor_from_c_str("poolsim.invalid"),
+            .port = 80,
+            .http2_prior_knowledge = true,
+            .max_connections = s_ctx.max_connections,
+            .ideal_concurrent_streams_per_connection = s_ctx.ideal_streams,
+            .shutdown_complete_callback = s_on_manager_shutdown_complete,
+        };
+        /* Its connection manager is created along with it, and picks up the default vtable above */
+        g_aws_http2_stream_manager_default_system_vtable_ptr = &s_sim_stream_manager_vtable;
+        s_ctx.stream_manager = aws_http2_stream_manager_new(s_ctx.allocator, &stream_manager_options);
+        if (!s_ctx.stream_manager) {
+            return AWS_OP_ERR;
+        }
+        aws_http2_stream_manager_set_system_vtable(s_ctx.stream_manager, &s_sim_stream_manager_vtable);
+        return AWS_OP_SUCCESS;
+    }
+
+    s_ctx.manager = aws_http_connection_manager_new(s_ctx.allocator, &manager_options);
+    if (!s_ctx.manager) {
+        return AWS_OP_ERR;
+    }
+    aws_http_connection_manager_set_system_vtable(s_ctx.manager, &s_sim_vtable);
+    return AWS_OP_SUCCESS;
+}
+
+static void s_teardown(void) {
+    if (s_ctx.stream_manager) {
+        aws_http2_stream_manager_release(s_ctx.stream_manager);
+        aws_mutex_lock(&s_ctx.sync_lock);
+        aws_condition_variable_wait_pred(&s_ctx.sync_signal, &s_ctx.sync_lock, s_manager_shutdown_complete_pred, NULL);
+        aws_mutex_unlock(&s_ctx.sync_lock);
+    }
+    aws_http_message_release(s_ctx.request_message);
+    if (s_ctx.manager) {
+        /* The manager may finish shutting down before release returns, and the callback takes the lock */
+        aws_http_connection_manager_release(s_ctx.manager);
+        aws_mutex_lock(&s_ctx.sync_lock);
+        aws_condition_variable_wait_pred(&s_ctx.sync_signal, &s_ctx.sync_lock, s_manager_shutdown_complete_pred, NULL);
+        aws_mutex_unlock(&s_ctx.sync_lock);
+    }
+    aws_client_bootstrap_release(s_ctx.bootstrap);
+    aws_host_resolver_release(s_ctx.host_resolver);
+    aws_event_loop_group_release(s_ctx.event_loop_group);
+
+    for (size_t i = 0; i < aws_array_list_length(&s_ctx.connections); ++i) {
+        struct poolsim_connection *connection = NULL;
+        aws_array_list_get_at(&s_ctx.connections, &connection, i);
+        aws_mem_release(s_ctx.allocator, connection);
+    }
+    aws_array_list_clean_up(&s_ctx.connections);
+    aws_array_list_clean_up(&s_ctx.requests);
+    aws_array_list_clean_up(&s_ctx.acquisition_waits_ns);
+    aws_priority_queue_clean_up(&s_ctx.events);
+    aws_condition_variable_clean_up(&s_ctx.sync_signal);
+    aws_mutex_clean_up(&s_ctx.sync_lock);
+    aws_mutex_clean_up(&s_ctx.clock_lock);
+}
+
+static void s_run(void) {
+    /* Requests are sorted by arrival, so prewarm requests come first, at time zero */
+    const size_t request_count = aws_array_list_length(&s_ctx.requests);
+    for (size_t i = 0; i < request_count; ++i) {
+        struct poolsim_request *request = NULL;
+        aws_array_list_get_at_ptr(&s_ctx.requests, (void **)&request, i);
+        struct poolsim_event event = {
+            .time_ns = request->arrival_ns,
+            .type = POOLSIM_EVENT_REQUEST_ARRIVAL,
+            .request = request,
+        };
+        s_schedule_event(&event);
+    }
+
+    struct poolsim_event sample = {.type = POOLSIM_EVENT_SAMPLE};
+    s_schedule_event(&sample);
+
+    if (s_ctx.http2) {
+        printf("# pool size\ntime_ms,open,available_streams,open_streams,pending,min_streams,max_streams\n");
+    } else {
+        printf("# pool size\ntime_ms,open,idle,leased,pending\n");
+    }
+    const uint64_t sample_ns = s_ms_to_ns(s_ctx.sample_ms);
+    struct poolsim_event event;
+    while (aws_priority_queue_pop(&s_ctx.events, &event) == AWS_OP_SUCCESS) {
+        if (event.time_ns > s_now()) {
+            s_set_virtual_time(event.time_ns);
+            s_sync_event_loop();
+        }
+
+        if (event.type == POOLSIM_EVENT_SAMPLE) {
+            s_print_sample();
+            /* Keep sampling while there's traffic, and after it for as long as culling could still shrink the pool */
+            if (s_ctx.outstanding_count > 0 || s_now() < s_ctx.last_activity_ns + s_ms_to_ns(s_ctx.idle_ms)) {
+                event.time_ns += sample_ns;
+                s_schedule_event(&event);
+            }
+            continue;
+        }
+
+        --s_ctx.outstanding_count;
+        s_handle_event(&event);
+        s_ctx.last_activity_ns = s_now();
+    }
+}
+
+int main(int argc, char **argv) {
+    struct aws_allocator *allocator = aws_default_allocator();
+    aws_http_library_init(allocator);
+
+    AWS_ZERO_STRUCT(s_ctx);
+    s_ctx.allocator = allocator;
+    s_ctx.rate_per_sec = 100.0;
+    s_ctx.duration_ms = 60000;
+    s_ctx.service_ms = 50;
+    s_ctx.max_connections = 16;
+    s_ctx.connect_ms = 20;
+    s_ctx.sample_ms = 1000;
+    s_ctx.seed = 1;
+    s_ctx.max_concurrent_streams = 100;
+    s_parse_options(argc, argv, &s_ctx);
+    s_ctx.random_state = s_ctx.seed ? s_ctx.seed : 1;
+
+    aws_mutex_init(&s_ctx.clock_lock);
+    aws_mutex_init(&s_ctx.sync_lock);
+    aws_condition_variable_init(&s_ctx.sync_signal);
+    aws_priority_queue_init_dynamic(&s_ctx.events, allocator, 1024, sizeof(struct poolsim_event), s_compare_events);
+    aws_array_list_init_dynamic(&s_ctx.requests, allocator, 1024, sizeof(struct poolsim_request));
+    aws_array_list_init_dynamic(&s_ctx.connections, allocator, 64, sizeof(struct poolsim_connection *));
+    aws_array_list_init_dynamic(&s_ctx.acquisition_waits_ns, allocator, 1024, sizeof(uint64_t));
+
+    int result = AWS_OP_SUCCESS;
+    if (s_ctx.trace_file) {
+        result = s_load_trace();
+    } else {
+        s_generate_traffic();
+    }
+    for (size_t i = 0; i < s_ctx.prewarm && !result; ++i) {
+        struct poolsim_request request = {.is_prewarm = true};
+        aws_array_list_push_back(&s_ctx.requests, &request);
+    }
+    /* The requests don't move once the simulation starts, since events point at them */
+    aws_array_list_sort(&s_ctx.requests, s_compare_requests);
+
+    if (!result) {
+        result = s_setup();
+        if (result) {
+            fprintf(stderr, "setup failed with error %s\n", aws_error_debug_str(aws_last_error()));
+        }
+    }
+    if (!result) {
+        s_run();
+        s_print_report();
+    }
+
+    s_teardown();
+    aws_http_library_clean_up();
+    return result ? 1 : 0;
+}
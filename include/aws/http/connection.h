@@ -15,6 +15,8 @@ struct aws_socket_options;
 struct aws_socket_endpoint;
 struct aws_tls_connection_options;
 struct aws_http2_setting;
+struct aws_http_memory_budget;
+struct aws_http_rate_limiter;
 struct proxy_env_var_settings;
 
 /**
@@ -163,6 +165,79 @@ struct aws_http1_connection_options {
      * A capacity that is too big may waste memory without helping throughput.
      */
     size_t read_buffer_capacity;
+
+    /**
+     * Optional.
+     * If non-zero, once the connection has gone this many milliseconds without reading or writing,
+     * buffers that only grow with traffic (ex: the decoder's scratch space) are released.
+     * They are re-grown on demand when traffic resumes.
+     * Useful when holding many mostly-idle connections.
+     * The connection's current footprint is reported in `aws_crt_statistics_http1_channel.resident_bytes`.
+     */
+    uint64_t idle_trim_ms;
+
+    /**
+     * Optional.
+     * Budget that the read buffer charges its unprocessed bytes to. The connection acquires a hold on it.
+     * The read window only re-opens as far as the budget has room, so the peer can't send more than it can buffer.
+     * Ignored if `manual_window_management` is false, since data is never buffered then.
+     * See `aws_http_memory_budget`.
+     */
+    struct aws_http_memory_budget *memory_budget;
+
+    /**
+     * Optional.
+     * Caps how fast the connection writes. The connection acquires a hold on it.
+     * Every byte written counts, headers included.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *send_rate_limiter;
+
+    /**
+     * Optional.
+     * Caps how fast the connection reads, by pacing how fast its read window re-opens.
+     * The connection acquires a hold on it.
+     * Ignored if `manual_window_management` is false, since the window never closes then.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
+    /**
+     * Optional.
+     * If non-zero, the max size in bytes of each incoming header-block (the headers, or the trailers).
+     * Each field counts its length plus 32 bytes, as with HTTP/2's SETTINGS_MAX_HEADER_LIST_SIZE.
+     * A header-block that goes over is rejected as soon as it does, without buffering the rest,
+     * and the connection closes with AWS_ERROR_HTTP_HEADERS_TOO_LARGE.
+     */
+    size_t max_header_list_size;
+};
+
+/**
+ * Thresholds for detecting a misbehaving HTTP/2 peer.
+ * Each counter tracks how often the peer did something within a sliding window of `window_ms`.
+ * If a counter exceeds its threshold, the connection sends GOAWAY(ENHANCE_YOUR_CALM) and shuts down.
+ * A threshold of zero disables that counter.
+ * See AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT for the defaults.
+ */
+struct aws_http2_abuse_limits {
+    /* Length of the sliding window, in milliseconds. Zero uses the default. */
+    uint64_t window_ms;
+
+    /* Max RST_STREAM frames received per window (defends against "rapid reset").
+     * Only servers count these by default. A client counts them only if abuse_limits are passed explicitly. */
+    uint32_t max_rst_stream_frames;
+
+    /* Max CONTINUATION frames received per window (defends against CONTINUATION floods). */
+    uint32_t max_continuation_frames;
+
+    /* Max DATA frames carrying no data, and no END_STREAM, received per window. */
+    uint32_t max_empty_data_frames;
+
+    /* Max SETTINGS frames (excluding ACKs) received per window. */
+    uint32_t max_settings_frames;
+
+    /* Max PING frames (excluding ACKs) received per window. */
+    uint32_t max_ping_frames;
 };
 
 /**
@@ -238,6 +313,53 @@ struct aws_http2_connection_options {
      * But, the client will always automatically update the window for padding even for manual window update.
      */
     bool conn_manual_window_management;
+
+    /**
+     * Optional.
+     * Thresholds for detecting a misbehaving peer.
+     * If NULL, AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT is used, except that clients don't count RST_STREAM frames.
+     * See `aws_http2_abuse_limits`.
+     */
+    const struct aws_http2_abuse_limits *abuse_limits;
+
+    /**
+     * Optional.
+     * If non-zero, once the connection has gone this many milliseconds without reading or writing,
+     * buffers that only grow with traffic are released: HPACK scratch space, spare HPACK dynamic table
+     * capacity, and the decoder's cookie and SETTINGS buffers.
+     * They are re-grown on demand when traffic resumes.
+     * Useful when holding many mostly-idle connections.
+     * The connection's current footprint is reported in `aws_crt_statistics_http2_channel.resident_bytes`.
+     */
+    uint64_t idle_trim_ms;
+
+    /**
+     * Optional.
+     * Budget that received messages kept alive by retained body data are charged to.
+     * The connection acquires a hold on it.
+     * With a budget, the connection window starts at its initial 65,535 bytes instead of being opened to the max,
+     * and automatic WINDOW_UPDATE frames are sent no further than the budget has room, delaying the rest.
+     * Only applies if `conn_manual_window_management` is false.
+     * See `aws_http_memory_budget`.
+     */
+    struct aws_http_memory_budget *memory_budget;
+
+    /**
+     * Optional.
+     * Caps how fast the connection sends DATA, across all its streams. The connection acquires a hold on it.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *send_rate_limiter;
+
+    /**
+     * Optional.
+     * Caps how fast the connection receives DATA, across all its streams, by pacing connection WINDOW_UPDATE frames.
+     * The connection acquires a hold on it.
+     * The connection window is only opened as far as the limiter's burst size, instead of to the max.
+     * Only applies if `conn_manual_window_management` is false.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *receive_rate_limiter;
 };
 
 /**
@@ -378,6 +500,21 @@ struct aws_http_client_connection_options {
      */
     bool prior_knowledge_http2;
 
+    /**
+     * Optional.
+     * When true, try to upgrade a cleartext connection from HTTP/1.1 to HTTP/2 (RFC7540 3.2).
+     * Before setup completes, an "OPTIONS *" request is sent as HTTP/1.1 with "Upgrade: h2c"
+     * and an "HTTP2-Settings" header carrying the initial settings from `http2_options`.
+     * If the server responds "101 Switching Protocols", the connection continues as HTTP/2,
+     * with the response to that request arriving on stream 1 (and discarded).
+     * Otherwise, the connection stays HTTP/1.1.
+     * Check aws_http_connection_get_version() in the on_setup callback to see which was used.
+     * Ignored if `prior_knowledge_http2` is true.
+     * When TLS is set and this is true, the connection will fail to be established,
+     * as the h2c upgrade only works for cleartext TCP. Use ALPN instead.
+     */
+    bool http2_cleartext_upgrade;
+
     /**
      * Optional.
      * Pointer to the hash map containing the ALPN string to protocol to use.
@@ -428,6 +565,9 @@ enum aws_http2_settings_id {
     AWS_HTTP2_SETTINGS_MAX_FRAME_SIZE = 0x5,
     AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE = 0x6,
     AWS_HTTP2_SETTINGS_END_RANGE, /* End of known values */
+    /* RFC-8441 3. Outside the range above, so it's not part of the AWS_HTTP2_SETTINGS_COUNT arrays filled by
+     * aws_http2_connection_get_local_settings() and aws_http2_connection_get_remote_settings() */
+    AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL = 0x8,
 };
 
 /* A HTTP/2 setting and its value, used in SETTINGS frame */
@@ -441,6 +581,20 @@ struct aws_http2_setting {
  */
 #define AWS_HTTP2_DEFAULT_MAX_CLOSED_STREAMS (32)
 
+/**
+ * HTTP/2: Default thresholds for detecting a misbehaving peer.
+ * These are generous enough that a well-behaved peer never comes close.
+ */
+#define AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT                                                                            \
+    {                                                                                                                  \
+        .window_ms = 10000,                                                                                            \
+        .max_rst_stream_frames = 5000,                                                                                 \
+        .max_continuation_frames = 5000,                                                                               \
+        .max_empty_data_frames = 5000,                                                                                 \
+        .max_settings_frames = 500,                                                                                    \
+        .max_ping_frames = 500,                                                                                        \
+    }
+
 /**
  * HTTP/2: The size of payload for HTTP/2 PING frame.
  */
@@ -15,6 +15,8 @@ AWS_PUSH_SANE_WARNING_LEVEL
 struct aws_client_bootstrap;
 struct aws_http_connection;
 struct aws_http_connection_manager;
+struct aws_http_memory_budget;
+struct aws_http_rate_limiter;
 struct aws_socket_options;
 struct aws_tls_connection_options;
 struct proxy_env_var_settings;
@@ -27,6 +29,18 @@ typedef void(aws_http_connection_manager_on_connection_setup_fn)(
 
 typedef void(aws_http_connection_manager_shutdown_complete_fn)(void *user_data);
 
+/**
+ * State of a connection manager's circuit breaker. See `aws_http_connection_manager_circuit_breaker_options`.
+ */
+enum aws_http_circuit_breaker_state {
+    /* Connecting normally. Also the state of managers without a circuit breaker. */
+    AWS_HTTP_CIRCUIT_BREAKER_CLOSED,
+    /* The endpoint is failing. No new connections are attempted. */
+    AWS_HTTP_CIRCUIT_BREAKER_OPEN,
+    /* The open timeout has passed. A single probe connection is allowed, to see if the endpoint recovered. */
+    AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN,
+};
+
 /**
  * Metrics for logging and debugging purpose.
  */
@@ -44,8 +58,133 @@ struct aws_http_manager_metrics {
     size_t pending_concurrency_acquires;
     /* The number of connections (http/1.1) or streams (for h2 via. stream manager) currently vended to user. */
     size_t leased_concurrency;
+    /* The current adaptive concurrency limit, or 0 if the manager has no `concurrency_limit_options`. */
+    size_t concurrency_limit;
+    /* The state of the manager's circuit breaker, or AWS_HTTP_CIRCUIT_BREAKER_CLOSED if it has none. */
+    enum aws_http_circuit_breaker_state circuit_breaker_state;
+};
+
+/**
+ * Options for adaptive concurrency limiting, where a manager adjusts how many requests it lets be in flight
+ * to its origin based on the latency it observes.
+ *
+ * The manager tracks the lowest latency it has seen, as a "no load" baseline.
+ * While latency stays within `rtt_tolerance` times the baseline, the limit grows.
+ * Once latency rises past that, the origin is assumed to be queueing requests, and the limit shrinks
+ * in proportion, so the client backs off before its requests start timing out.
+ * Failures also shrink the limit.
+ *
+ * Acquisitions over the limit wait in the manager's queue, or fail with AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED
+ * if `fail_fast` is set.
+ *
+ * The connection manager can't see the requests made on its connections, so it measures latency from when
+ * a connection is vended until it's released. It works best when each acquisition is used for one request
+ * and released promptly: a connection held idle, or used for several requests, looks like a slow origin
+ * and shrinks the limit.
+ * The HTTP/2 stream manager measures latency from when a stream is made until it completes.
+ */
+struct aws_http_concurrency_limit_options {
+    /**
+     * Optional.
+     * The limit to start with. If zero is specified (the default) then AWS_HTTP_CONCURRENCY_LIMIT_DEFAULT_INITIAL
+     * is used.
+     */
+    size_t initial_limit;
+
+    /**
+     * Optional.
+     * The limit never shrinks below this. If zero is specified (the default) then 1 is used.
+     */
+    size_t min_limit;
+
+    /**
+     * Optional.
+     * The limit never grows past this. If zero is specified (the default) then the most the manager could ever
+     * have in flight is used (ex: `max_connections` for the connection manager).
+     */
+    size_t max_limit;
+
+    /**
+     * Optional.
+     * How far each sample moves the limit towards the value that sample suggests, from 0 (exclusive) to 1.
+     * If zero is specified (the default) then 0.2 is used.
+     */
+    double smoothing;
+
+    /**
+     * Optional.
+     * How many times the no-load latency is tolerated before the limit shrinks. Must be at least 1.
+     * If zero is specified (the default) then 2 is used.
+     */
+    double rtt_tolerance;
+
+    /**
+     * If true, acquisitions that would have to wait for the limit fail immediately
+     * with AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED, instead of queueing.
+     */
+    bool fail_fast;
+};
+
+#define AWS_HTTP_CONCURRENCY_LIMIT_DEFAULT_INITIAL 20
+
+/**
+ * A connection manager may be shared by many tenants (ex: the customers of a multi-tenant service).
+ * Acquisitions tagged with a tenant (see aws_http_connection_manager_acquire_connection_for_tenant())
+ * are queued per tenant, and connections are handed out with weighted fair queuing across the tenants waiting,
+ * rather than first come first served. So one tenant flooding the manager can't starve the others.
+ *
+ * Untagged acquisitions share a default tenant, with weight 1 and no cap.
+ */
+struct aws_http_connection_manager_tenant_options {
+    /**
+     * Optional.
+     * The tenant's share of connections, relative to other tenants that are waiting.
+     * A tenant with weight 3 is handed 3 connections for every 1 handed to a tenant with weight 1.
+     * If zero is specified (the default) then 1 is used.
+     */
+    uint32_t weight;
+
+    /**
+     * Optional.
+     * Max number of connections the tenant may have leased at once. Acquisitions past this wait,
+     * even if other connections are idle.
+     * If zero is specified (the default) then there is no cap, besides the manager's `max_connections`.
+     */
+    size_t max_leased_connections;
+};
+
+/**
+ * Options for a connection manager's circuit breaker, which stops the manager from spending sockets and time
+ * on an endpoint that's down.
+ *
+ * After `failure_threshold` consecutive failed connects (including TLS negotiation and, for HTTP/2,
+ * the initial settings exchange), the breaker opens. While open, no new connections are attempted,
+ * and acquisitions that can't be served by an already open connection fail immediately
+ * with AWS_ERROR_HTTP_CIRCUIT_BREAKER_OPEN.
+ *
+ * Once `open_timeout_ms` has passed, the breaker is half-open: a single acquisition is let through to probe
+ * the endpoint with a new connection. If the probe connects, the breaker closes. If it fails, the breaker opens
+ * again for another `open_timeout_ms`.
+ */
+struct aws_http_connection_manager_circuit_breaker_options {
+    /**
+     * Optional.
+     * Number of consecutive connect failures that opens the breaker.
+     * If zero is specified (the default) then AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_FAILURE_THRESHOLD is used.
+     */
+    size_t failure_threshold;
+
+    /**
+     * Optional.
+     * How long the breaker stays open before letting a probe through.
+     * If zero is specified (the default) then AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_OPEN_TIMEOUT_MS is used.
+     */
+    uint64_t open_timeout_ms;
 };
 
+#define AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_FAILURE_THRESHOLD 5
+#define AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_OPEN_TIMEOUT_MS 5000
+
 /*
  * Connection manager configuration struct.
  *
@@ -74,10 +213,19 @@ struct aws_http_connection_manager_options {
      * Specify whether you have prior knowledge that cleartext (HTTP) connections are HTTP/2 (RFC-7540 3.4).
      * If false, then cleartext connections are treated as HTTP/1.1.
      * It is illegal to set this true when secure connections are being used.
-     * Note that upgrading from HTTP/1.1 to HTTP/2 is not supported (RFC-7540 3.2).
+     * To upgrade from HTTP/1.1 to HTTP/2 instead, see `http2_cleartext_upgrade`.
      */
     bool http2_prior_knowledge;
 
+    /**
+     * Specify whether cleartext (HTTP) connections should try to upgrade from HTTP/1.1 to HTTP/2 (RFC-7540 3.2).
+     * The manager remembers the outcome for its host: once an upgrade succeeds, further connections
+     * use prior knowledge of HTTP/2. Once the server declines, further connections stay HTTP/1.1 without asking.
+     * Ignored if `http2_prior_knowledge` is true.
+     * It is illegal to set this true when secure connections are being used.
+     */
+    bool http2_cleartext_upgrade;
+
     const struct aws_http_connection_monitoring_options *monitoring_options;
     struct aws_byte_cursor host;
     uint32_t port;
@@ -91,6 +239,40 @@ struct aws_http_connection_manager_options {
     size_t max_closed_streams;
     bool http2_conn_manual_window_management;
 
+    /**
+     * Optional.
+     * Budget shared by all of the manager's connections, bounding the data they buffer in total.
+     * The manager acquires a hold on it.
+     * See `aws_http1_connection_options.memory_budget`, `aws_http2_connection_options.memory_budget`,
+     * and `aws_http_memory_budget`.
+     */
+    struct aws_http_memory_budget *memory_budget;
+
+    /**
+     * Optional.
+     * Limiters shared by all of the manager's connections, capping their combined send and receive rates.
+     * The manager acquires a hold on each.
+     * See `aws_http1_connection_options.send_rate_limiter`, `aws_http2_connection_options.send_rate_limiter`,
+     * and `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
+    /**
+     * Optional.
+     * If set, the manager adapts how many connections it vends at once to the latency of its origin.
+     * See `aws_http_concurrency_limit_options`.
+     */
+    const struct aws_http_concurrency_limit_options *concurrency_limit_options;
+
+    /**
+     * Optional.
+     * If set, the manager stops connecting to its endpoint after repeated failures, and fails acquisitions fast
+     * until a probe connection succeeds.
+     * See `aws_http_connection_manager_circuit_breaker_options`.
+     */
+    const struct aws_http_connection_manager_circuit_breaker_options *circuit_breaker_options;
+
     /* Proxy configuration for http connection */
     const struct aws_http_proxy_options *proxy_options;
 
@@ -186,6 +368,35 @@ void aws_http_connection_manager_acquire_connection(
     aws_http_connection_manager_on_connection_setup_fn *callback,
     void *user_data);
 
+/*
+ * Requests a connection from the manager on behalf of a tenant.
+ * Behaves like aws_http_connection_manager_acquire_connection(), but the acquisition is queued
+ * and capped according to the tenant's options. See `aws_http_connection_manager_tenant_options`.
+ *
+ * `tenant_id` is any byte string identifying the tenant, it's copied.
+ * An empty `tenant_id` is the default tenant, same as aws_http_connection_manager_acquire_connection().
+ * A tenant whose options have never been set uses the defaults.
+ */
+AWS_HTTP_API
+void aws_http_connection_manager_acquire_connection_for_tenant(
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id,
+    aws_http_connection_manager_on_connection_setup_fn *callback,
+    void *user_data);
+
+/*
+ * Sets a tenant's weight and cap. May be called at any time, and takes effect immediately for acquisitions
+ * already waiting. Lowering a cap doesn't take back connections already leased.
+ * Pass NULL options to return the tenant to the defaults.
+ *
+ * The default tenant, for untagged acquisitions, can't be configured: `tenant_id` must not be empty.
+ */
+AWS_HTTP_API
+int aws_http_connection_manager_set_tenant_options(
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id,
+    const struct aws_http_connection_manager_tenant_options *options);
+
 /*
  * Returns a connection back to the manager.  All acquired connections must
  * eventually be released back to the manager in order to avoid a resource leak.
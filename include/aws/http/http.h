@@ -60,6 +60,11 @@ enum aws_http_errors {
     AWS_ERROR_HTTP_MANUAL_WRITE_NOT_ENABLED,
     AWS_ERROR_HTTP_MANUAL_WRITE_HAS_COMPLETED,
     AWS_ERROR_HTTP_RESPONSE_FIRST_BYTE_TIMEOUT,
+    AWS_ERROR_HTTP_EXTENDED_CONNECT_NOT_ENABLED,
+    AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED,
+    AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED,
+    AWS_ERROR_HTTP_CIRCUIT_BREAKER_OPEN,
+    AWS_ERROR_HTTP_HEADERS_TOO_LARGE,
 
     AWS_ERROR_HTTP_END_RANGE = AWS_ERROR_ENUM_END_RANGE(AWS_C_HTTP_PACKAGE_ID)
 };
@@ -152,6 +157,7 @@ AWS_HTTP_API extern const struct aws_byte_cursor aws_http_header_scheme;
 AWS_HTTP_API extern const struct aws_byte_cursor aws_http_header_authority;
 AWS_HTTP_API extern const struct aws_byte_cursor aws_http_header_path;
 AWS_HTTP_API extern const struct aws_byte_cursor aws_http_header_status;
+AWS_HTTP_API extern const struct aws_byte_cursor aws_http_header_protocol;
 
 AWS_HTTP_API extern const struct aws_byte_cursor aws_http_scheme_http;
 AWS_HTTP_API extern const struct aws_byte_cursor aws_http_scheme_https;
@@ -21,6 +21,7 @@ struct aws_http2_setting;
 struct aws_http_make_request_options;
 struct aws_http_stream;
 struct aws_http_manager_metrics;
+struct aws_http_concurrency_limit_options;
 
 /**
  * Always invoked asynchronously when the stream was created, successfully or not.
@@ -96,6 +97,14 @@ struct aws_http2_stream_manager_options {
     /* Connection monitor for the underlying connections made */
     const struct aws_http_connection_monitoring_options *monitoring_options;
 
+    /**
+     * Optional.
+     * If set, the manager adapts how many streams it has open at once, across all its connections,
+     * to the latency of its origin.
+     * See `aws_http_concurrency_limit_options`.
+     */
+    const struct aws_http_concurrency_limit_options *concurrency_limit_options;
+
     /* Optional. Proxy configuration for underlying http connection */
     const struct aws_http_proxy_options *proxy_options;
     const struct proxy_env_var_settings *proxy_ev_settings;
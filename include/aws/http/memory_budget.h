@@ -0,0 +1,128 @@
+#ifndef AWS_HTTP_MEMORY_BUDGET_H
+#define AWS_HTTP_MEMORY_BUDGET_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/http.h>
+
+AWS_PUSH_SANE_WARNING_LEVEL
+
+/**
+ * A budget of bytes that connections charge for data they buffer on the peer's behalf.
+ * Share one budget between many connections (ex: every connection of a server, or of a connection manager)
+ * to bound their combined buffering.
+ *
+ * Only data that's actually buffered is charged:
+ * - HTTP/1 connections with manual window management charge the unprocessed bytes in their read buffer.
+ * - HTTP/2 connections charge the received messages kept alive by retained body data.
+ * An open flow-control window isn't charged, but it's never opened past the budget's remaining room.
+ *
+ * When the budget runs low, connections apply backpressure instead of buffering more:
+ * - HTTP/1 connections with manual window management re-open their read window no further than the budget has room.
+ * - HTTP/2 connections with automatic connection window management delay WINDOW_UPDATE frames the same way.
+ * - New client requests fail with AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED while the budget is exhausted.
+ * - New incoming streams are refused while the budget is exhausted. HTTP/2 server connections reset them with
+ *   RST_STREAM(REFUSED_STREAM). HTTP/1 can't refuse a single request, so HTTP/1 server connections close
+ *   with AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED before the next request reaches the user.
+ * A connection that was held back asks again every `retry_interval_ms`, so throughput degrades
+ * as the budget runs low, rather than memory growing without bound.
+ * Data already in flight when the budget runs out is still accepted, so the budget may be briefly exceeded.
+ *
+ * Reservations may be made from any thread.
+ */
+struct aws_http_memory_budget;
+
+struct aws_http_memory_budget_options {
+    /**
+     * Required.
+     * Max number of bytes that may be reserved, across every user of the budget.
+     */
+    size_t max_bytes;
+
+    /**
+     * Optional.
+     * How long a connection that was denied its reservation waits before asking again.
+     * If zero is specified (the default) then AWS_HTTP_MEMORY_BUDGET_DEFAULT_RETRY_INTERVAL_MS is used.
+     */
+    uint64_t retry_interval_ms;
+};
+
+#define AWS_HTTP_MEMORY_BUDGET_DEFAULT_RETRY_INTERVAL_MS 50
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Create a new memory budget.
+ * Returns NULL and raises an error on failure.
+ * The budget is ref-counted, call aws_http_memory_budget_release() when you're done with it.
+ */
+AWS_HTTP_API
+struct aws_http_memory_budget *aws_http_memory_budget_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_memory_budget_options *options);
+
+/**
+ * Acquire a hold on the budget, preventing it from being destroyed.
+ * Each connection given the budget acquires its own hold.
+ * Returns the budget, for convenience.
+ */
+AWS_HTTP_API
+struct aws_http_memory_budget *aws_http_memory_budget_acquire(struct aws_http_memory_budget *budget);
+
+/**
+ * Release a hold on the budget.
+ * The budget is destroyed once all holds are released.
+ * Always returns NULL.
+ */
+AWS_HTTP_API
+struct aws_http_memory_budget *aws_http_memory_budget_release(struct aws_http_memory_budget *budget);
+
+/**
+ * Reserve up to `size` bytes.
+ * Returns the number of bytes actually reserved, which is less than `size` if the budget is running low,
+ * and zero if it's exhausted.
+ * Every reserved byte must eventually be returned via aws_http_memory_budget_unreserve().
+ */
+AWS_HTTP_API
+size_t aws_http_memory_budget_reserve(struct aws_http_memory_budget *budget, size_t size);
+
+/**
+ * Reserve exactly `size` bytes, even if that takes the budget past its max.
+ * For memory that's already committed and can't be refused (ex: data that already arrived from the peer).
+ */
+AWS_HTTP_API
+void aws_http_memory_budget_reserve_forced(struct aws_http_memory_budget *budget, size_t size);
+
+/**
+ * Return `size` previously reserved bytes to the budget.
+ */
+AWS_HTTP_API
+void aws_http_memory_budget_unreserve(struct aws_http_memory_budget *budget, size_t size);
+
+/**
+ * Get the number of bytes currently reserved.
+ * May exceed max_bytes, due to forced reservations.
+ */
+AWS_HTTP_API
+size_t aws_http_memory_budget_get_reserved(const struct aws_http_memory_budget *budget);
+
+/**
+ * Get the number of bytes that may still be reserved.
+ * Zero if the budget is exhausted.
+ */
+AWS_HTTP_API
+size_t aws_http_memory_budget_get_available(const struct aws_http_memory_budget *budget);
+
+/**
+ * Returns true if there are no bytes left to reserve.
+ */
+AWS_HTTP_API
+bool aws_http_memory_budget_is_exhausted(const struct aws_http_memory_budget *budget);
+
+AWS_EXTERN_C_END
+AWS_POP_SANE_WARNING_LEVEL
+
+#endif /* AWS_HTTP_MEMORY_BUDGET_H */
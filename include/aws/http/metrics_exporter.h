@@ -0,0 +1,142 @@
+#ifndef AWS_HTTP_METRICS_EXPORTER_H
+#define AWS_HTTP_METRICS_EXPORTER_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/http.h>
+
+AWS_PUSH_SANE_WARNING_LEVEL
+
+struct aws_array_list;
+struct aws_byte_buf;
+struct aws_http_connection_manager;
+struct aws_http_stream_metrics;
+struct aws_http2_stream_manager;
+
+/**
+ * Collects the library's numbers in one place and renders them as OpenMetrics (Prometheus) text on demand.
+ *
+ * Sources:
+ * - Connection managers and HTTP/2 stream managers that are added to the exporter.
+ *   Their aws_http_manager_metrics are fetched at render time, as gauges.
+ * - Connection statistics: use aws_http_metrics_exporter_on_statistics() as the `statistics_observer_fn`
+ *   in aws_http_connection_monitoring_options, with the exporter as `statistics_observer_user_data`.
+ * - Stream metrics: call aws_http_metrics_exporter_record_stream() from your `on_metrics` callback.
+ *
+ * Recording never takes a lock. Each recording thread is given its own shard of atomic counters and histograms,
+ * on its own cache lines, and rendering sums the shards.
+ * Counters and histogram sums are 64-bit on every platform. Where size_t is 32-bit, atomics can't hold them,
+ * so each shard has a lock instead, which is only contended when threads share a shard.
+ * So counts are exact, but a render that runs concurrently with recording may see some of a sample and not the rest.
+ *
+ * All functions may be called from any thread.
+ */
+struct aws_http_metrics_exporter;
+
+struct aws_http_metrics_exporter_options {
+    /**
+     * Optional.
+     * Prefix for every metric's name.
+     * If empty (the default) then "aws_http" is used.
+     */
+    struct aws_byte_cursor prefix;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Create a new metrics exporter.
+ * Returns NULL and raises an error on failure.
+ * The exporter is ref-counted, call aws_http_metrics_exporter_release() when you're done with it.
+ */
+AWS_HTTP_API
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_metrics_exporter_options *options);
+
+/**
+ * Acquire a hold on the exporter, preventing it from being destroyed.
+ * Returns the exporter, for convenience.
+ */
+AWS_HTTP_API
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_acquire(struct aws_http_metrics_exporter *exporter);
+
+/**
+ * Release a hold on the exporter.
+ * The exporter is destroyed once all holds are released.
+ * Always returns NULL.
+ */
+AWS_HTTP_API
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_release(struct aws_http_metrics_exporter *exporter);
+
+/**
+ * Report a connection manager's metrics, labeled with `name`, every time the exporter renders.
+ * The exporter holds a reference to the manager until it's removed, so remove it before expecting it to shut down.
+ */
+AWS_HTTP_API
+int aws_http_metrics_exporter_add_connection_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor name);
+
+/**
+ * Stop reporting a connection manager, and release the exporter's reference to it.
+ * Does nothing if the manager was never added.
+ */
+AWS_HTTP_API
+void aws_http_metrics_exporter_remove_connection_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http_connection_manager *manager);
+
+/**
+ * Report an HTTP/2 stream manager's metrics, labeled with `name`, every time the exporter renders.
+ * The exporter holds a reference to the manager until it's removed.
+ */
+AWS_HTTP_API
+int aws_http_metrics_exporter_add_stream_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http2_stream_manager *manager,
+    struct aws_byte_cursor name);
+
+/**
+ * Stop reporting an HTTP/2 stream manager, and release the exporter's reference to it.
+ * Does nothing if the manager was never added.
+ */
+AWS_HTTP_API
+void aws_http_metrics_exporter_remove_stream_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http2_stream_manager *manager);
+
+/**
+ * An aws_http_statistics_observer_fn. Pass the exporter as its user_data.
+ * Records the HTTP/1, HTTP/2 and websocket channel statistics in `stats_list`, ignoring the rest.
+ */
+AWS_HTTP_API
+void aws_http_metrics_exporter_on_statistics(
+    size_t connection_nonce,
+    const struct aws_array_list *stats_list,
+    void *user_data);
+
+/**
+ * Record a finished stream, with its metrics and the error code it completed with.
+ */
+AWS_HTTP_API
+void aws_http_metrics_exporter_record_stream(
+    struct aws_http_metrics_exporter *exporter,
+    const struct aws_http_stream_metrics *metrics,
+    int error_code);
+
+/**
+ * Append every metric to `output` as OpenMetrics text, ending with "# EOF\n".
+ * `output` grows as needed.
+ */
+AWS_HTTP_API
+int aws_http_metrics_exporter_render(struct aws_http_metrics_exporter *exporter, struct aws_byte_buf *output);
+
+AWS_EXTERN_C_END
+AWS_POP_SANE_WARNING_LEVEL
+
+#endif /* AWS_HTTP_METRICS_EXPORTER_H */
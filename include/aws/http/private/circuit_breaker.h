@@ -0,0 +1,72 @@
+#ifndef AWS_HTTP_CIRCUIT_BREAKER_H
+#define AWS_HTTP_CIRCUIT_BREAKER_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/connection_manager.h>
+
+/**
+ * The algorithm behind `aws_http_connection_manager_circuit_breaker_options`.
+ *
+ * Consecutive connect failures open the breaker. Once the open timeout passes, the next connect check moves it
+ * to half-open, and a single probe connect is allowed. The probe's result closes the breaker, or opens it again.
+ *
+ * Not thread-safe. The manager embeds one and uses it under its lock.
+ */
+struct aws_http_circuit_breaker {
+    size_t failure_threshold;
+    uint64_t open_timeout_ns;
+
+    enum aws_http_circuit_breaker_state state;
+    size_t consecutive_failures;
+
+    /* When the breaker last opened. Only meaningful while open. */
+    uint64_t opened_timestamp_ns;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initialize the breaker, closed. Zeroed options get the defaults.
+ */
+AWS_HTTP_API
+void aws_http_circuit_breaker_init(
+    struct aws_http_circuit_breaker *breaker,
+    const struct aws_http_connection_manager_circuit_breaker_options *options);
+
+/**
+ * Returns the breaker's state, which is half-open if it's open and the open timeout has passed.
+ * Doesn't modify the breaker.
+ */
+AWS_HTTP_API
+enum aws_http_circuit_breaker_state aws_http_circuit_breaker_get_state(
+    const struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns);
+
+/**
+ * Returns how many more connects may be started, given `connects_in_flight` already started.
+ * SIZE_MAX when closed, 0 when open, and 1 when half-open until the probe is in flight.
+ * This is where the breaker actually moves from open to half-open.
+ */
+AWS_HTTP_API
+size_t aws_http_circuit_breaker_get_connect_allowance(
+    struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns,
+    size_t connects_in_flight);
+
+/**
+ * Record the result of a connect.
+ * A success closes the breaker. A failure opens it, if the threshold is reached or it was half-open.
+ */
+AWS_HTTP_API
+void aws_http_circuit_breaker_on_connect_result(
+    struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns,
+    bool success);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_HTTP_CIRCUIT_BREAKER_H */
@@ -0,0 +1,68 @@
+#ifndef AWS_HTTP_CONCURRENCY_LIMITER_H
+#define AWS_HTTP_CONCURRENCY_LIMITER_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/connection_manager.h>
+
+/**
+ * The algorithm behind `aws_http_concurrency_limit_options`.
+ *
+ * Each completed request is a sample of its round trip time. The limit moves towards
+ * `limit * gradient + sqrt(limit)`, where gradient is `rtt_tolerance * no_load_rtt / rtt`, clamped to [0.5, 1].
+ * So the limit grows by a small queue allowance while latency is near the baseline,
+ * and shrinks once the origin starts queueing.
+ *
+ * Not thread-safe. Managers embed one and use it under their lock.
+ */
+struct aws_http_concurrency_limiter {
+    double limit;
+    size_t min_limit;
+    size_t max_limit;
+    double smoothing;
+    double rtt_tolerance;
+    bool fail_fast;
+
+    /* Lowest RTT seen, drifting slowly upwards so the baseline can follow an origin that got slower for good.
+     * 0 until the first sample. */
+    uint64_t no_load_rtt_ns;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Validate the options and initialize the limiter.
+ * `default_max_limit` is used if the options don't set `max_limit`. It's the most the manager could ever have
+ * in flight.
+ * Raises AWS_ERROR_INVALID_ARGUMENT if the options are invalid.
+ */
+AWS_HTTP_API
+int aws_http_concurrency_limiter_init(
+    struct aws_http_concurrency_limiter *limiter,
+    const struct aws_http_concurrency_limit_options *options,
+    size_t default_max_limit);
+
+/**
+ * Returns the current limit on requests in flight. Always at least 1.
+ */
+AWS_HTTP_API
+size_t aws_http_concurrency_limiter_get_limit(const struct aws_http_concurrency_limiter *limiter);
+
+/**
+ * Update the limit with a completed request.
+ * `in_flight` is how many requests were in flight when this one completed, including itself.
+ * `dropped` is true if the request failed, rather than completed, in which case `rtt_ns` is ignored.
+ */
+AWS_HTTP_API
+void aws_http_concurrency_limiter_on_sample(
+    struct aws_http_concurrency_limiter *limiter,
+    uint64_t rtt_ns,
+    size_t in_flight,
+    bool dropped);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_HTTP_CONCURRENCY_LIMITER_H */
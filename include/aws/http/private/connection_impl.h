@@ -117,6 +117,13 @@ struct aws_http_connection {
     struct aws_http_connection_client_data *client_data;
     struct aws_http_connection_server_data *server_data;
 
+    /* Optional. Buffered data is reserved from here. The connection holds a reference */
+    struct aws_http_memory_budget *memory_budget;
+
+    /* Optional. Pace writes and window updates. The connection holds a reference to each */
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
     bool stream_manual_window_management;
 };
 
@@ -137,8 +144,15 @@ struct aws_http_client_bootstrap {
 
     struct aws_http1_connection_options http1_options;
     struct aws_http2_connection_options http2_options; /* allocated with bootstrap */
+    struct aws_http2_abuse_limits http2_abuse_limits;  /* storage for http2_options.abuse_limits */
     struct aws_hash_table *alpn_string_map;            /* allocated with bootstrap */
     struct aws_http_connection *connection;
+
+    /* h2c upgrade (RFC-7540 3.2). Request is NULL unless the upgrade is being attempted. */
+    struct aws_http_message *h2c_upgrade_request;
+    /* The HTTP/1.1 connection the upgrade was attempted on.
+     * Once upgraded, it stays in the channel as a pass-through handler, and the reference is held until shutdown. */
+    struct aws_http_connection *h2c_http1_connection;
 };
 
 AWS_EXTERN_C_BEGIN
@@ -153,6 +167,17 @@ int aws_http_client_connect_internal(
     const struct aws_http_client_connection_options *options,
     aws_http_proxy_request_transform_fn *proxy_request_transform);
 
+/**
+ * Create the HTTP/1.1 request that asks a cleartext server to upgrade to HTTP/2 (RFC-7540 3.2).
+ * The HTTP2-Settings header carries the base64url encoding of http2_options' initial settings.
+ * Exposed for tests.
+ */
+AWS_HTTP_API
+struct aws_http_message *aws_http_client_new_h2c_upgrade_request(
+    struct aws_allocator *alloc,
+    struct aws_byte_cursor host_name,
+    const struct aws_http2_connection_options *http2_options);
+
 /**
  * Internal API for adding a reference to a connection
  */
@@ -15,6 +15,8 @@
 #    pragma warning(disable : 4214) /* nonstandard extension used: bit field types other than int */
 #endif
 
+struct aws_io_message;
+
 struct aws_h1_connection {
     struct aws_http_connection base;
 
@@ -30,7 +32,9 @@ struct aws_h1_connection {
      *
      * If there is no data available to write (waiting for user to add more streams or chunks),
      * then the task stops being active. The task is made active again when the user
-     * adds more outgoing data. */
+     * adds more outgoing data.
+     *
+     * If a send rate limiter allows nothing, the task stays active and is scheduled for when it will. */
     struct aws_channel_task outgoing_stream_task;
 
     /* Task that removes items from `synced_data` and does their on-thread work.
@@ -45,6 +49,17 @@ struct aws_h1_connection {
      */
     struct aws_channel_task cross_thread_work_task;
 
+    /* Task that periodically checks whether the connection has gone idle, and if so, releases memory
+     * that only grows with traffic. Only scheduled if `idle_trim_ns` is non-zero. */
+    struct aws_channel_task idle_trim_task;
+    uint64_t idle_trim_ns;
+
+    /* Task that asks `base.memory_budget` again, after the read window couldn't be fully re-opened */
+    struct aws_channel_task memory_budget_retry_task;
+
+    /* Task that re-opens the read window once the receive rate limiters allow, after they held it back */
+    struct aws_channel_task receive_rate_limit_task;
+
     /* Only the event-loop thread may touch this data */
     struct {
         /* List of streams being worked on. */
@@ -61,6 +76,10 @@ struct aws_h1_connection {
         struct aws_h1_stream *incoming_stream;
         struct aws_h1_decoder *incoming_stream_decoder;
 
+        /* Body data decoded from the current aws_io_message, gathered for the incoming stream's
+         * on_incoming_body_vectored callback. Flushed before the message is released. */
+        struct aws_array_list incoming_body_slices; /* aws_byte_cursor */
+
         /* Used to encode requests and responses */
         struct aws_h1_encoder encoder;
 
@@ -72,6 +91,7 @@ struct aws_h1_connection {
          * The `aws_io_message.copy_mark` is used to track progress on partially processed messages.
          * `pending_bytes` is the sum of all unprocessed bytes across all queued messages.
          * `capacity` is the limit for how many unprocessed bytes we'd like in the queue.
+         * If there's a `base.memory_budget`, exactly `pending_bytes` are reserved from it.
          */
         struct {
             struct aws_linked_list messages;
@@ -91,6 +111,11 @@ struct aws_h1_connection {
         /* Only used by tests. Sum of window_increments issued by this slot. Resets each time it's queried */
         size_t recent_window_increments;
 
+        /* Bumped whenever a message is read or written.
+         * The idle trim task trims once this goes a whole idle_trim_ns period without changing. */
+        uint64_t activity_count;
+        uint64_t activity_count_at_last_idle_check;
+
         struct aws_crt_statistics_http1_channel stats;
 
         uint64_t outgoing_stream_timestamp_ns;
@@ -112,8 +137,17 @@ struct aws_h1_connection {
         bool is_outgoing_stream_task_active : 1;
 
         bool is_processing_read_messages : 1;
+
+        /* True once trimmed by the idle trim task, until activity resumes */
+        bool is_idle_trimmed : 1;
+
+        bool is_memory_budget_retry_scheduled : 1;
+
+        bool is_receive_rate_limit_task_scheduled : 1;
     } thread_data;
 
+    AWS_HTTP_CACHE_LINE_PADDING(synced_data_padding);
+
     /* Any thread may touch this data, but the lock must be held */
     struct {
         struct aws_mutex lock;
@@ -169,6 +203,13 @@ struct aws_http_connection *aws_http_connection_new_http1_1_client(
 AWS_HTTP_API
 struct aws_h1_window_stats aws_h1_connection_window_stats(struct aws_http_connection *connection_base);
 
+/**
+ * After switching protocols, a message too big for the downstream window is forwarded as slices that point into
+ * its data. Returns the message whose data a forwarded slice points into, or NULL if `message` is not a slice.
+ */
+AWS_HTTP_API
+const struct aws_io_message *aws_h1_read_message_slice_get_original(const struct aws_io_message *message);
+
 AWS_EXTERN_C_END
 
 /* DO NOT export functions below. They're only used by other .c files in this library */
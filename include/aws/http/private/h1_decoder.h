@@ -59,6 +59,9 @@ struct aws_h1_decoder_params {
     size_t scratch_space_initial_size;
     /* Set false if decoding responses */
     bool is_decoding_requests;
+    /* Max size of each header-block (the headers, or the trailers). Each field counts its length plus 32 bytes.
+     * Going over fails decoding with AWS_ERROR_HTTP_HEADERS_TOO_LARGE. 0 for no limit. */
+    size_t max_header_list_size;
     void *user_data;
     struct aws_h1_decoder_vtable vtable;
 };
@@ -74,6 +77,12 @@ AWS_HTTP_API int aws_h1_decode(struct aws_h1_decoder *decoder, struct aws_byte_c
 AWS_HTTP_API void aws_h1_decoder_set_logging_id(struct aws_h1_decoder *decoder, const void *id);
 AWS_HTTP_API void aws_h1_decoder_set_body_headers_ignored(struct aws_h1_decoder *decoder, bool body_headers_ignored);
 
+/* Release the scratch_space if it isn't holding a partial line. It is re-grown as needed by later decoding. */
+AWS_HTTP_API void aws_h1_decoder_trim(struct aws_h1_decoder *decoder);
+
+/* Returns the approximate number of heap bytes held by the decoder */
+AWS_HTTP_API size_t aws_h1_decoder_get_resident_bytes(const struct aws_h1_decoder *decoder);
+
 /* RFC-7230 section 4.2 Message Format */
 #define AWS_HTTP_TRANSFER_ENCODING_CHUNKED (1 << 0)
 #define AWS_HTTP_TRANSFER_ENCODING_GZIP (1 << 1)
@@ -52,6 +52,10 @@ struct aws_h1_stream {
      * See RFC-7230 Section 6: Connection Management. */
     bool is_final_stream;
 
+    /* If true, the outgoing body is an asynchronous source. When it has no data ready, the connection stops
+     * trying to write until aws_http_stream_notify_body_ready() is called, instead of polling every tick. */
+    bool use_body_ready_notifications;
+
     /* Buffer for incoming data that needs to stick around. */
     struct aws_byte_buf incoming_storage_buf;
 
@@ -105,6 +109,9 @@ struct aws_h1_stream {
 
         /* Whether the chunked trailer has already been sent */
         bool has_added_trailer : 1;
+
+        /* Whether user called aws_http_stream_notify_body_ready() since the cross-thread work task last ran */
+        bool has_body_ready_notification : 1;
     } synced_data;
 };
 
@@ -18,6 +18,17 @@
 struct aws_h2_decoder;
 struct aws_h2_stream;
 
+/**
+ * Approximate sliding-window counter, used to notice a peer that floods us with cheap frames.
+ * Counts are kept for the current and previous fixed windows, and the previous window's count is
+ * weighted by how much of it still overlaps the sliding window. Cheap enough to bump on every frame.
+ */
+struct aws_h2_abuse_counter {
+    uint64_t window_start_ns;
+    uint32_t current_count;
+    uint32_t previous_count;
+};
+
 struct aws_h2_connection {
     struct aws_http_connection base;
 
@@ -26,9 +37,22 @@ struct aws_h2_connection {
 
     struct aws_channel_task cross_thread_work_task;
     struct aws_channel_task outgoing_frames_task;
+    struct aws_channel_task idle_trim_task;
+
+    /* Task that asks `base.memory_budget` again, after a WINDOW_UPDATE had to be delayed */
+    struct aws_channel_task memory_budget_retry_task;
+
+    /* Task that gives streams and WINDOW_UPDATEs held back by rate limiters another try */
+    struct aws_channel_task rate_limit_task;
 
     bool conn_manual_window_management;
 
+    /* How long the connection must go without reading or writing before it's trimmed. Zero if disabled. */
+    uint64_t idle_trim_ns;
+
+    /* Thresholds for detecting a misbehaving peer. window_ms is never zero. */
+    struct aws_http2_abuse_limits abuse_limits;
+
     /* Only the event-loop thread may touch this data */
     struct {
         struct aws_h2_decoder *decoder;
@@ -41,9 +65,9 @@ struct aws_h2_connection {
         bool is_outgoing_frames_task_active;
 
         /* Settings received from peer, which restricts the message to send */
-        uint32_t settings_peer[AWS_HTTP2_SETTINGS_END_RANGE];
+        uint32_t settings_peer[AWS_H2_SETTINGS_END_RANGE];
         /* Local settings to send/sent to peer, which affects the decoding */
-        uint32_t settings_self[AWS_HTTP2_SETTINGS_END_RANGE];
+        uint32_t settings_self[AWS_H2_SETTINGS_END_RANGE];
 
         /* List using aws_h2_pending_settings.node
          * Contains settings waiting to be ACKed by peer and applied */
@@ -73,12 +97,26 @@ struct aws_h2_connection {
 
         /* List using aws_h2_stream.node.
          * Contains all streams that are open, but are only sending data when notified, rather than polling
-         * for it (e.g. event streams)
+         * for it (e.g. event streams, or asynchronous bodies waiting for aws_http_stream_notify_body_ready())
          * Streams are moved to the outgoing_streams_list until they send pending data, then are moved back
          * to this list to sleep until more data comes in
          */
         struct aws_linked_list waiting_streams_list;
 
+        /* List using aws_h2_stream.node.
+         * Contains all streams with DATA frames to send, and cannot send now due to a send rate limiter.
+         * Moved back to outgoing_streams_list when the rate_limit_task runs */
+        struct aws_linked_list rate_limited_streams_list;
+
+        /* List using aws_h2_stream.rate_limit_node.
+         * Contains streams owing a WINDOW_UPDATE that their receive rate limiter held back */
+        struct aws_linked_list rate_limited_window_streams_list;
+
+        /* List using aws_h2_stream.pending_body_node.
+         * Contains streams with body data gathered from the aws_io_message being processed,
+         * for delivery to their on_incoming_body_vectored callback once the whole message is decoded. */
+        struct aws_linked_list pending_body_streams_list;
+
         /* List using aws_h2_frame.node.
          * Queues all frames (except DATA frames) for connection to send.
          * When queue is empty, then we send DATA frames from the outgoing_streams_list */
@@ -99,6 +137,22 @@ struct aws_h2_connection {
          * connection */
         size_t window_size_self;
 
+        /* Connection WINDOW_UPDATE owed to the peer, but delayed until the memory budget has room
+         * and the receive rate limiter allows it */
+        size_t window_update_deferred;
+        bool is_memory_budget_retry_scheduled;
+        bool is_rate_limit_task_scheduled;
+
+        /* The aws_io_message being decoded, and the retained body wrapping it, if any stream's
+         * on_incoming_body_retained callback was given data from it. Both NULL between messages. */
+        struct aws_io_message *incoming_message;
+        struct aws_h2_retained_message *incoming_retained_message;
+
+        /* Body data held by retained messages, and how much connection WINDOW_UPDATE is withheld to cover it.
+         * Never more is withheld than is retained. */
+        size_t retained_body_bytes;
+        size_t window_update_withheld;
+
         /* Highest self-initiated stream-id that peer might have processed.
          * Defaults to max stream-id, may be lowered when GOAWAY frame received. */
         uint32_t goaway_received_last_stream_id;
@@ -126,8 +180,25 @@ struct aws_h2_connection {
         /* Timestamp when connection has data to receive, which is when there is an active stream */
         uint64_t incoming_timestamp_ns;
 
+        /* Bumped whenever a message is read or written.
+         * The idle trim task trims once this goes a whole idle_trim_ns period without changing. */
+        uint64_t activity_count;
+        uint64_t activity_count_at_last_idle_check;
+        bool is_idle_trimmed;
+
+        /* Counters checked against abuse_limits as frames arrive */
+        struct {
+            struct aws_h2_abuse_counter rst_stream;
+            struct aws_h2_abuse_counter continuation;
+            struct aws_h2_abuse_counter empty_data;
+            struct aws_h2_abuse_counter settings;
+            struct aws_h2_abuse_counter ping;
+        } abuse_counters;
+
     } thread_data;
 
+    AWS_HTTP_CACHE_LINE_PADDING(synced_data_padding);
+
     /* Any thread may touch this data, but the lock must be held (unless it's an atomic) */
     struct {
         struct aws_mutex lock;
@@ -173,9 +244,9 @@ struct aws_h2_connection {
         uint32_t goaway_received_http2_error_code;
 
         /* For checking settings received from peer from outside the event-loop thread. */
-        uint32_t settings_peer[AWS_HTTP2_SETTINGS_END_RANGE];
+        uint32_t settings_peer[AWS_H2_SETTINGS_END_RANGE];
         /* For checking local settings to send/sent to peer from outside the event-loop thread. */
-        uint32_t settings_self[AWS_HTTP2_SETTINGS_END_RANGE];
+        uint32_t settings_self[AWS_H2_SETTINGS_END_RANGE];
     } synced_data;
 };
 
@@ -220,12 +291,18 @@ enum aws_h2_data_encode_status {
     AWS_H2_DATA_ENCODE_ONGOING,
     AWS_H2_DATA_ENCODE_ONGOING_BODY_STREAM_STALLED, /* stalled reading from body stream */
     AWS_H2_DATA_ENCODE_ONGOING_WAITING_FOR_WRITES,  /* waiting for next manual write */
+    AWS_H2_DATA_ENCODE_ONGOING_WAITING_FOR_BODY,    /* waiting for aws_http_stream_notify_body_ready() */
     AWS_H2_DATA_ENCODE_ONGOING_WINDOW_STALLED,      /* stalled due to reduced window size */
+    AWS_H2_DATA_ENCODE_ONGOING_RATE_LIMITED,        /* stalled until a send rate limiter allows more */
 };
 
 /* When window size is too small to fit the possible padding into it, we stop sending data and wait for WINDOW_UPDATE */
 #define AWS_H2_MIN_WINDOW_SIZE (256)
 
+/* Longest the rate_limit_task sleeps. Streams on different limiters share the task,
+ * so this keeps one stream's long wait from holding up another whose limiter refills sooner */
+#define AWS_H2_RATE_LIMIT_MAX_WAIT_NS (10 * 1000 * 1000)
+
 /* Private functions called from tests... */
 
 AWS_EXTERN_C_BEGIN
@@ -254,6 +331,32 @@ AWS_EXTERN_C_END
  */
 void aws_h2_connection_enqueue_outgoing_frame(struct aws_h2_connection *connection, struct aws_h2_frame *frame);
 
+/**
+ * Invoked when a stream gathers body data for its vectored callback.
+ * The connection calls aws_h2_stream_flush_pending_body() before the aws_io_message
+ * the data points into is released, or sooner if the stream's trailing headers or END_STREAM arrive.
+ */
+void aws_h2_connection_on_stream_pending_body(struct aws_h2_connection *connection, struct aws_h2_stream *stream);
+
+/**
+ * Invoked when a stream delivers `data_len` bytes of body data via on_incoming_body_retained.
+ * Returns the retained body for the aws_io_message being decoded, creating it on first use.
+ * The connection holds a reference until it's done with the message.
+ * Returns NULL and raises an error on failure.
+ */
+struct aws_http_retained_body *aws_h2_connection_retain_incoming_body(
+    struct aws_h2_connection *connection,
+    size_t data_len);
+
+/**
+ * Invoked when a stream's receive rate limiter holds back some of its WINDOW_UPDATE.
+ * The connection calls aws_h2_stream_send_deferred_window_update() again after `wait_ns`, or sooner.
+ */
+void aws_h2_connection_on_stream_window_update_deferred(
+    struct aws_h2_connection *connection,
+    struct aws_h2_stream *stream,
+    uint64_t wait_ns);
+
 /**
  * Invoked immediately after a stream enters the CLOSED state.
  * The connection will remove the stream from its "active" datastructures,
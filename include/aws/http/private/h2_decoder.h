@@ -48,6 +48,10 @@ struct aws_h2_decoder_vtable {
         void *userdata);
     struct aws_h2err (*on_push_promise_end)(uint32_t stream_id, bool malformed, void *userdata);
 
+    /* Called once for each CONTINUATION frame, before its header-block fragment is decoded.
+     * This is the one callback that may occur between the _begin() and _end() of a header-block. */
+    struct aws_h2err (*on_continuation)(uint32_t stream_id, void *userdata);
+
     /* For DATA frame: _begin() is called, then 0+ _i() calls, then _end().
      * No other decoder callbacks will occur in this time */
     struct aws_h2err (*on_data_begin)(
@@ -112,9 +116,19 @@ AWS_HTTP_API void aws_h2_decoder_destroy(struct aws_h2_decoder *decoder);
 /* If failed aws_h2err returned, it is a Connection Error */
 AWS_HTTP_API struct aws_h2err aws_h2_decode(struct aws_h2_decoder *decoder, struct aws_byte_cursor *data);
 
+/**
+ * Release memory that isn't needed while the connection is idle.
+ * Buffers that are in use are left alone, everything released is re-grown as needed by later decoding.
+ */
+AWS_HTTP_API int aws_h2_decoder_trim(struct aws_h2_decoder *decoder);
+
+/* Returns the approximate number of heap bytes held by the decoder */
+AWS_HTTP_API size_t aws_h2_decoder_get_resident_bytes(const struct aws_h2_decoder *decoder);
+
 AWS_HTTP_API void aws_h2_decoder_set_setting_header_table_size(struct aws_h2_decoder *decoder, uint32_t data);
 AWS_HTTP_API void aws_h2_decoder_set_setting_enable_push(struct aws_h2_decoder *decoder, uint32_t data);
 AWS_HTTP_API void aws_h2_decoder_set_setting_max_frame_size(struct aws_h2_decoder *decoder, uint32_t data);
+AWS_HTTP_API void aws_h2_decoder_set_setting_max_header_list_size(struct aws_h2_decoder *decoder, uint32_t data);
 
 AWS_EXTERN_C_END
 
@@ -60,12 +60,16 @@ struct aws_h2err {
 #define AWS_H2_FRAME_PREFIX_SIZE (9)
 #define AWS_H2_INIT_WINDOW_SIZE (65535) /* Defined initial window size */
 
+/* End of the setting ids tracked internally. This goes past the public AWS_HTTP2_SETTINGS_END_RANGE,
+ * which stays put so the public fixed-size settings arrays keep their size. */
+#define AWS_H2_SETTINGS_END_RANGE (AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL + 1)
+
 /* Legal min(inclusive) and max(inclusive) for each setting */
-extern const uint32_t aws_h2_settings_bounds[AWS_HTTP2_SETTINGS_END_RANGE][2];
+extern const uint32_t aws_h2_settings_bounds[AWS_H2_SETTINGS_END_RANGE][2];
 
 /* Initial values for settings RFC-7540 6.5.2 */
 AWS_HTTP_API
-extern const uint32_t aws_h2_settings_initial[AWS_HTTP2_SETTINGS_END_RANGE];
+extern const uint32_t aws_h2_settings_initial[AWS_H2_SETTINGS_END_RANGE];
 
 /* This magic string must be the very first thing a client sends to the server.
  * See RFC-7540 3.5 - HTTP/2 Connection Preface.
@@ -141,6 +145,13 @@ const char *aws_h2_frame_type_to_str(enum aws_h2_frame_type type);
 AWS_HTTP_API
 const char *aws_http2_error_code_to_str(enum aws_http2_error_code h2_error_code);
 
+/**
+ * Returns true if this is the id of a setting we know about.
+ * Known ids are not contiguous, so check this before indexing settings arrays with an id from the peer.
+ */
+AWS_HTTP_API
+bool aws_h2_settings_id_is_known(uint32_t id);
+
 /**
  * Specify which HTTP/2 error-code will be sent to the peer in a GOAWAY or RST_STREAM frame.
  *
@@ -184,6 +195,14 @@ int aws_h2_frame_encoder_init(
 AWS_HTTP_API
 void aws_h2_frame_encoder_clean_up(struct aws_h2_frame_encoder *encoder);
 
+/* Release memory that isn't needed while the connection is idle. Re-grown as needed by later encoding. */
+AWS_HTTP_API
+int aws_h2_frame_encoder_trim(struct aws_h2_frame_encoder *encoder);
+
+/* Returns the approximate number of heap bytes held by the encoder (not counting the struct itself) */
+AWS_HTTP_API
+size_t aws_h2_frame_encoder_get_resident_bytes(const struct aws_h2_frame_encoder *encoder);
+
 /**
  * Attempt to encode frame into output buffer.
  * AWS_OP_ERR is returned if encoder encounters an unrecoverable error.
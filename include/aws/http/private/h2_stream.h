@@ -74,7 +74,13 @@ struct aws_h2_stream {
     struct aws_http_stream base;
 
     struct aws_linked_list_node node;
-    struct aws_channel_task cross_thread_work_task;
+
+    /* Node in the connection's list of streams with pending body (see aws_h2_stream_flush_pending_body()) */
+    struct aws_linked_list_node pending_body_node;
+
+    /* Node in the connection's list of streams owing a rate limited WINDOW_UPDATE
+     * (see aws_h2_stream_send_deferred_window_update()) */
+    struct aws_linked_list_node rate_limit_node;
 
     /* Only the event-loop thread may touch this data */
     struct {
@@ -100,8 +106,35 @@ struct aws_h2_stream {
          * asleep. When stream needs to be awaken, moving the stream back to the outgoing_streams_list and set this bool
          * to false */
         bool waiting_for_writes;
+        /* Indicates that the stream is currently in the waiting_streams_list because its body had no data ready.
+         * It sleeps there until the user calls aws_http_stream_notify_body_ready() */
+        bool waiting_for_body_ready;
+
+        /* Only used if on_incoming_body_vectored is set.
+         * Body data decoded from the current aws_io_message, delivered all at once when the connection
+         * flushes it, which is always before the message is released. */
+        struct aws_array_list pending_body_slices; /* aws_byte_cursor */
+        /* Automatic WINDOW_UPDATE owed for the DATA frames above, sent as a single frame when flushed */
+        uint32_t pending_body_window_update;
+
+        /* WINDOW_UPDATE owed to the peer, but delayed until `base.receive_rate_limiter` allows it */
+        size_t window_update_deferred;
     } thread_data;
 
+    /* The fields between thread_data and synced_data are set once, or only written when work is handed between
+     * threads. They keep the event-loop's fields and synced_data.lock more than a cache line apart on 64-bit
+     * platforms, without padding every stream (see httpbench's false-sharing benchmark). */
+    bool manual_write;
+    bool use_body_ready_notifications;
+
+    /* Store the sent reset HTTP/2 error code, set to -1, if none has sent so far */
+    int64_t sent_reset_error_code;
+
+    /* Store the received reset HTTP/2 error code, set to -1, if none has received so far */
+    int64_t received_reset_error_code;
+
+    struct aws_channel_task cross_thread_work_task;
+
     /* Any thread may touch this data, but the lock must be held (unless it's an atomic) */
     struct {
         struct aws_mutex lock;
@@ -116,6 +149,8 @@ struct aws_h2_stream {
         struct aws_h2err reset_error;
         bool reset_called;
         bool manual_write_ended;
+        /* Set by aws_http_stream_notify_body_ready(), cleared when cross-thread work task runs */
+        bool body_ready_notified;
 
         /* Simplified stream state. */
         enum aws_h2_stream_api_state api_state;
@@ -123,13 +158,6 @@ struct aws_h2_stream {
         /* any data streams sent manually via aws_http2_stream_write_data */
         struct aws_linked_list pending_write_list; /* aws_h2_stream_pending_data */
     } synced_data;
-    bool manual_write;
-
-    /* Store the sent reset HTTP/2 error code, set to -1, if none has sent so far */
-    int64_t sent_reset_error_code;
-
-    /* Store the received reset HTTP/2 error code, set to -1, if none has received so far */
-    int64_t received_reset_error_code;
 };
 
 const char *aws_h2_stream_state_to_str(enum aws_h2_stream_state state);
@@ -145,6 +173,9 @@ struct aws_h2err aws_h2_stream_window_size_change(struct aws_h2_stream *stream,
 /* Connection is ready to send frames from stream now */
 int aws_h2_stream_on_activated(struct aws_h2_stream *stream, enum aws_h2_stream_body_state *body_state);
 
+/* Stream is the HTTP/1.1 request that carried an h2c upgrade (RFC-7540 3.2). It has nothing more to send. */
+void aws_h2_stream_on_activated_by_upgrade(struct aws_h2_stream *stream);
+
 /* Completes stream for one reason or another, clean up any pending writes/resources. */
 void aws_h2_stream_complete(struct aws_h2_stream *stream, int error_code);
 
@@ -178,6 +209,14 @@ struct aws_h2err aws_h2_stream_on_decoder_data_begin(
     uint32_t total_padding_bytes,
     bool end_stream);
 struct aws_h2err aws_h2_stream_on_decoder_data_i(struct aws_h2_stream *stream, struct aws_byte_cursor data);
+
+/* Deliver gathered body data via on_incoming_body_vectored, and send one WINDOW_UPDATE to cover all of it.
+ * Stream may complete itself during this call. */
+struct aws_h2err aws_h2_stream_flush_pending_body(struct aws_h2_stream *stream);
+
+/* Send as much of the WINDOW_UPDATE that the stream's receive rate limiter held back as it now allows.
+ * If some is still held back, the stream tells the connection when to try again. */
+int aws_h2_stream_send_deferred_window_update(struct aws_h2_stream *stream);
 struct aws_h2err aws_h2_stream_on_decoder_window_update(
     struct aws_h2_stream *stream,
     uint32_t window_size_increment,
@@ -187,4 +226,10 @@ struct aws_h2err aws_h2_stream_on_decoder_rst_stream(struct aws_h2_stream *strea
 
 int aws_h2_stream_activate(struct aws_http_stream *stream);
 
+/**
+ * Activate a client stream as stream 1, for the HTTP/1.1 request whose "Upgrade: h2c" was accepted.
+ * Must be called from the connection's thread, immediately after the connection's handler is installed.
+ */
+int aws_h2_stream_activate_upgraded(struct aws_http_stream *stream);
+
 #endif /* AWS_HTTP_H2_STREAM_H */
@@ -8,6 +8,7 @@
 #include <aws/http/request_response.h>
 
 #include <aws/common/hash_table.h>
+#include <aws/common/lru_cache.h>
 #include <aws/compression/huffman.h>
 
 /**
@@ -72,6 +73,10 @@ struct aws_hpack_context {
         struct aws_hash_table reverse_lookup;
         /* aws_byte_cursor * -> size_t */
         struct aws_hash_table reverse_lookup_name_only;
+
+        /* Bumped whenever entries are inserted or evicted, or the max size changes.
+         * Anything encoded against the table is only valid while this is unchanged. */
+        uint64_t generation;
     } dynamic_table;
 };
 
@@ -91,6 +96,11 @@ struct aws_hpack_encoder {
         size_t smallest_value;
         bool pending;
     } dynamic_table_size_update;
+
+    /* Header-blocks of immutable aws_http_headers, memoized so they can be re-sent as a memcpy.
+     * aws_http_headers * -> struct aws_hpack_memoized_header_block *.
+     * NULL until the first one is memoized. */
+    struct aws_cache *memoized_header_blocks;
 };
 
 /**
@@ -151,6 +161,8 @@ struct aws_hpack_decoder {
                 enum aws_http_header_compression compression;
                 uint64_t name_index;
                 size_t name_length;
+                /* Set if the name string references the input directly, rather than scratch */
+                struct aws_byte_cursor name_in_place;
             } literal;
 
             struct {
@@ -160,17 +172,14 @@ struct aws_hpack_decoder {
 
         enum aws_hpack_decode_type type;
 
-        /* Scratch holds header name and value while decoding */
+        /* Scratch holds header name and value while decoding,
+         * unless they can be referenced directly in the input (see aws_hpack_decode()) */
         struct aws_byte_buf scratch;
     } progress_entry;
 };
 
 AWS_EXTERN_C_BEGIN
 
-/* Library-level init and shutdown */
-void aws_hpack_static_table_init(struct aws_allocator *allocator);
-void aws_hpack_static_table_clean_up(void);
-
 AWS_HTTP_API
 void aws_hpack_context_init(
     struct aws_hpack_context *aws_hpack_context,
@@ -205,6 +214,17 @@ size_t aws_hpack_find_index(
 AWS_HTTP_API
 int aws_hpack_insert_header(struct aws_hpack_context *context, const struct aws_http_header *header);
 
+/**
+ * Release spare capacity in the dynamic table's storage, keeping every entry.
+ * Storage is re-grown as needed by later inserts.
+ */
+AWS_HTTP_API
+int aws_hpack_context_trim(struct aws_hpack_context *context);
+
+/* Returns the approximate number of heap bytes held by the dynamic table */
+AWS_HTTP_API
+size_t aws_hpack_context_get_resident_bytes(const struct aws_hpack_context *context);
+
 /**
  * Set the max size of the dynamic table (in octets). The size of each header is name.len + value.len + 32 [4.1].
  */
@@ -223,6 +243,13 @@ void aws_hpack_encoder_clean_up(struct aws_hpack_encoder *encoder);
 AWS_HTTP_API
 void aws_hpack_encoder_update_max_table_size(struct aws_hpack_encoder *encoder, uint32_t new_max_size);
 
+/* Release memory that isn't needed while idle, including memoized header-blocks. See aws_hpack_context_trim() */
+AWS_HTTP_API
+int aws_hpack_encoder_trim(struct aws_hpack_encoder *encoder);
+
+AWS_HTTP_API
+size_t aws_hpack_encoder_get_resident_bytes(const struct aws_hpack_encoder *encoder);
+
 AWS_HTTP_API
 void aws_hpack_encoder_set_huffman_mode(struct aws_hpack_encoder *encoder, enum aws_hpack_huffman_mode mode);
 
@@ -230,6 +257,9 @@ void aws_hpack_encoder_set_huffman_mode(struct aws_hpack_encoder *encoder, enum
  * Encode header-block into the output.
  * This function will mutate hpack, so an error means hpack can no longer be used.
  * Note that output will be dynamically resized if it's too short.
+ *
+ * If the headers are immutable (see aws_http_headers_set_immutable()), the encoded header-fields are memoized,
+ * and re-used for as long as the dynamic table is in the same state they were encoded against.
  */
 AWS_HTTP_API
 int aws_hpack_encode_header_block(
@@ -237,12 +267,31 @@ int aws_hpack_encode_header_block(
     const struct aws_http_headers *headers,
     struct aws_byte_buf *output);
 
+/**
+ * Returns an upper bound on the length of the header-block that aws_hpack_encode_header_block() would encode next.
+ * This doesn't mutate hpack. Use it to size the output, so encoding never needs to grow it.
+ */
+AWS_HTTP_API
+size_t aws_hpack_get_encoded_header_block_max_length(
+    struct aws_hpack_encoder *encoder,
+    const struct aws_http_headers *headers);
+
 AWS_HTTP_API
 void aws_hpack_decoder_init(struct aws_hpack_decoder *decoder, struct aws_allocator *allocator, const void *log_id);
 
 AWS_HTTP_API
 void aws_hpack_decoder_clean_up(struct aws_hpack_decoder *decoder);
 
+/**
+ * Release memory that isn't needed while idle: the scratch buffer (if no entry is in progress)
+ * and spare dynamic table capacity. Both are re-grown as needed.
+ */
+AWS_HTTP_API
+int aws_hpack_decoder_trim(struct aws_hpack_decoder *decoder);
+
+AWS_HTTP_API
+size_t aws_hpack_decoder_get_resident_bytes(const struct aws_hpack_decoder *decoder);
+
 /* Call this after sending SETTINGS_HEADER_TABLE_SIZE and receiving ACK from the peer.
  * The hpack-decoder remembers all size updates, and makes sure that the peer
  * sends the appropriate Dynamic Table Size Updates in the next header block we receive. */
@@ -254,6 +303,10 @@ void aws_hpack_decoder_update_max_table_size(struct aws_hpack_decoder *decoder,
  * If result->type is ONGOING, then call decode() again with more data to resume decoding.
  * Otherwise, type is either a HEADER_FIELD or a DYNAMIC_TABLE_RESIZE.
  *
+ * A HEADER_FIELD's strings are only valid until decode() is called again, or the memory behind to_decode
+ * is released, whichever comes first. Strings that aren't Huffman-encoded, and arrived whole in this call,
+ * reference to_decode directly rather than being copied.
+ *
  * If an error occurs, the decoder is broken and decode() must not be called again.
  */
 AWS_HTTP_API
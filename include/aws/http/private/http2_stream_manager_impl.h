@@ -9,7 +9,9 @@
 #include <aws/common/mutex.h>
 #include <aws/common/ref_count.h>
 #include <aws/http/http2_stream_manager.h>
-#include <aws/http/private/random_access_set.h>
+#include <aws/http/private/concurrency_limiter.h>
+#include <aws/http/private/http2_stream_manager_system_vtable.h>
+#include <aws/http/private/least_loaded_heap.h>
 
 enum aws_h2_sm_state_type {
     AWS_H2SMST_READY,
@@ -32,6 +34,9 @@ struct aws_h2_sm_connection {
                                                      or failed to be created from the connection. */
     uint32_t max_concurrent_streams; /* lower bound between user configured and the other side */
 
+    /* Position in the stream manager's available_connections heap, keyed by num_streams_assigned */
+    struct aws_least_loaded_heap_node available_node;
+
     /* task to send ping periodically from connection thread. */
     struct aws_ref_count ref_count;
     struct aws_channel_task ping_task;
@@ -55,6 +60,8 @@ struct aws_h2_sm_pending_stream_acquisition {
                                                list. */
     struct aws_http_message *request;
     struct aws_channel_task make_request_task;
+    /* When the request was made, for timing it. Only set if the manager has a concurrency limit. */
+    uint64_t make_request_timestamp_ns;
     aws_http2_stream_manager_on_stream_acquired_fn *callback;
     void *user_data;
 };
@@ -92,11 +99,14 @@ struct aws_http2_stream_manager {
      */
     struct aws_ref_count internal_ref_count;
     struct aws_client_bootstrap *bootstrap;
+    const struct aws_http2_stream_manager_system_vtable *system_vtable;
 
     /* Configurations */
     size_t max_connections;
     /* Connection will be closed if 5xx response received from server. */
     bool close_connection_on_server_error;
+    /* If true, synced_data.concurrency_limiter caps the streams in flight */
+    bool concurrency_limit_enabled;
 
     uint64_t connection_ping_period_ns;
     uint64_t connection_ping_timeout_ns;
@@ -129,19 +139,15 @@ struct aws_http2_stream_manager {
         enum aws_h2_sm_state_type state;
 
         /**
-         * A set of all connections that meet all requirement to use. Note: there will be connections not in this set,
-         * but hold by the stream manager, which can be tracked by the streams created on it. Set of `struct
-         * aws_h2_sm_connection *`
-         */
-        struct aws_random_access_set ideal_available_set;
-        /**
-         * A set of all available connections that exceed the soft limits set by users. Note: there will be connections
-         * not in this set, but hold by the stream manager, which can be tracked by the streams created. Set of `struct
-         * aws_h2_sm_connection *`
+         * A min-heap of all available connections, keyed by the number of streams assigned, so the least loaded
+         * connection is always at the top. Connections stay in the heap whether they are below or above the ideal
+         * limit, only their position changes. Note: there will be connections not in this heap, but hold by the
+         * stream manager, which can be tracked by the streams created on it. Heap of `struct aws_h2_sm_connection *`
+         * via their `available_node`.
          */
-        struct aws_random_access_set nonideal_available_set;
-        /* We don't mantain set for connections that is full or "dead" (Cannot make any new streams). We have streams
-         * opening from the connection tracking them */
+        struct aws_least_loaded_heap available_connections;
+        /* We don't mantain connections that is full or "dead" (Cannot make any new streams) in the heap. We have
+         * streams opening from the connection tracking them */
 
         /**
          * The set of all incomplete stream acquisition requests (haven't decide what connection to make the request
@@ -167,6 +173,12 @@ struct aws_http2_stream_manager {
          */
         size_t internal_refcount_stats[AWS_SMCT_COUNT];
 
+        /**
+         * Adaptive limit on streams in flight (AWS_SMCT_OPEN_STREAM + AWS_SMCT_PENDING_MAKE_REQUESTS), across all
+         * connections. Only used when concurrency_limit_enabled.
+         */
+        struct aws_http_concurrency_limiter concurrency_limiter;
+
         bool finish_pending_stream_acquisitions_task_scheduled;
     } synced_data;
 };
@@ -0,0 +1,68 @@
+#ifndef AWS_HTTP2_STREAM_MANAGER_SYSTEM_VTABLE_H
+#define AWS_HTTP2_STREAM_MANAGER_SYSTEM_VTABLE_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/http.h>
+
+#include <aws/http/connection.h>
+#include <aws/http/request_response.h>
+
+struct aws_channel;
+struct aws_channel_task;
+struct aws_http2_stream_manager;
+
+/* vtable of functions that aws_http2_stream_manager uses to interact with its connections, their streams and their
+ * channels. The connections themselves come from the underlying connection manager, which has its own vtable.
+ * tests and simulators override the vtable to mock those systems */
+struct aws_http2_stream_manager_system_vtable {
+    /*
+     * Downstream http functions
+     */
+    struct aws_http_stream *(*aws_http_connection_make_request)(
+        struct aws_http_connection *client_connection,
+        const struct aws_http_make_request_options *options);
+    int (*aws_http_stream_activate)(struct aws_http_stream *stream);
+    int (*aws_http_stream_get_incoming_response_status)(const struct aws_http_stream *stream, int *out_status);
+    void (*aws_http2_connection_get_remote_settings)(
+        const struct aws_http_connection *http2_connection,
+        struct aws_http2_setting out_settings[AWS_HTTP2_SETTINGS_COUNT]);
+    int (*aws_http2_connection_ping)(
+        struct aws_http_connection *http2_connection,
+        const struct aws_byte_cursor *optional_opaque_data,
+        aws_http2_on_ping_complete_fn *on_completed,
+        void *user_data);
+    bool (*aws_http_connection_new_requests_allowed)(const struct aws_http_connection *connection);
+    void (*aws_http_connection_stop_new_requests)(struct aws_http_connection *connection);
+    void (*aws_http_connection_close)(struct aws_http_connection *connection);
+    enum aws_http_version (*aws_http_connection_get_version)(const struct aws_http_connection *connection);
+    struct aws_channel *(*aws_http_connection_get_channel)(struct aws_http_connection *connection);
+
+    /*
+     * Downstream channel and clock functions
+     */
+    bool (*aws_channel_thread_is_callers_thread)(struct aws_channel *channel);
+    void (*aws_channel_schedule_task_now)(struct aws_channel *channel, struct aws_channel_task *task);
+    void (*aws_channel_schedule_task_future)(
+        struct aws_channel *channel,
+        struct aws_channel_task *task,
+        uint64_t run_at_nanos);
+    int (*aws_channel_current_clock_time)(struct aws_channel *channel, uint64_t *time_nanos);
+    int (*aws_high_res_clock_get_ticks)(uint64_t *timestamp);
+};
+
+AWS_HTTP_API
+bool aws_http2_stream_manager_system_vtable_is_valid(const struct aws_http2_stream_manager_system_vtable *table);
+
+AWS_HTTP_API
+void aws_http2_stream_manager_set_system_vtable(
+    struct aws_http2_stream_manager *stream_manager,
+    const struct aws_http2_stream_manager_system_vtable *system_vtable);
+
+AWS_HTTP_API
+extern const struct aws_http2_stream_manager_system_vtable *g_aws_http2_stream_manager_default_system_vtable_ptr;
+
+#endif /* AWS_HTTP2_STREAM_MANAGER_SYSTEM_VTABLE_H */
@@ -8,6 +8,18 @@
 
 #include <aws/http/http.h>
 
+/* Assumed size of a CPU cache line */
+#define AWS_HTTP_CACHE_LINE_SIZE 64
+
+/**
+ * Declares a struct member that only exists to keep its neighbors on separate cache lines.
+ * Used once per connection, between data written by the event-loop thread and data written by other threads
+ * under lock, so writers on one side don't keep invalidating the lines the other side is working on (false sharing).
+ * Streams aren't padded, there can be thousands of them and the cost adds up (see httpbench false-sharing).
+ * Padding is used rather than alignment, because member alignment isn't portable C99.
+ */
+#define AWS_HTTP_CACHE_LINE_PADDING(NAME) uint8_t NAME[AWS_HTTP_CACHE_LINE_SIZE]
+
 /**
  * Methods that affect internal processing.
  * This is NOT a definitive list of methods.
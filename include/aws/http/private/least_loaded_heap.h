@@ -0,0 +1,104 @@
+#ifndef AWS_HTTP_LEAST_LOADED_HEAP_H
+#define AWS_HTTP_LEAST_LOADED_HEAP_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/common/array_list.h>
+#include <aws/http/http.h>
+
+/**
+ * An indexed min-heap, for picking the least loaded of many items (ex: connections keyed by assigned streams).
+ *
+ * Each item embeds an aws_least_loaded_heap_node, which remembers the item's position in the heap.
+ * So the least loaded item is found in constant time, and an item's load can be changed,
+ * or the item removed, in O(log n) without searching or hashing.
+ *
+ * Not thread-safe.
+ */
+struct aws_least_loaded_heap {
+    struct aws_array_list nodes; /* Array of `struct aws_least_loaded_heap_node *`, in heap order */
+};
+
+/**
+ * Embed this in the item stored in the heap. Use AWS_CONTAINER_OF() to get back to the item.
+ */
+struct aws_least_loaded_heap_node {
+    /* Position in the heap's array. AWS_LEAST_LOADED_HEAP_NOT_IN_HEAP when the node isn't in a heap. */
+    size_t index;
+    uint64_t load;
+};
+
+#define AWS_LEAST_LOADED_HEAP_NOT_IN_HEAP SIZE_MAX
+
+AWS_EXTERN_C_BEGIN
+
+AWS_HTTP_API
+int aws_least_loaded_heap_init(
+    struct aws_least_loaded_heap *heap,
+    struct aws_allocator *allocator,
+    size_t initial_item_allocation);
+
+AWS_HTTP_API
+void aws_least_loaded_heap_clean_up(struct aws_least_loaded_heap *heap);
+
+/**
+ * Initialize a node, so it's known to not be in any heap.
+ */
+AWS_HTTP_API
+void aws_least_loaded_heap_node_init(struct aws_least_loaded_heap_node *node);
+
+/**
+ * Returns true if the node is currently in a heap.
+ */
+AWS_HTTP_API
+bool aws_least_loaded_heap_node_is_in_heap(const struct aws_least_loaded_heap_node *node);
+
+/**
+ * Add the node to the heap, with the given load. The node must not already be in a heap.
+ * Only fails if memory can't be allocated.
+ */
+AWS_HTTP_API
+int aws_least_loaded_heap_add(
+    struct aws_least_loaded_heap *heap,
+    struct aws_least_loaded_heap_node *node,
+    uint64_t load);
+
+/**
+ * Remove the node from the heap. Does nothing if the node isn't in the heap.
+ */
+AWS_HTTP_API
+void aws_least_loaded_heap_remove(struct aws_least_loaded_heap *heap, struct aws_least_loaded_heap_node *node);
+
+/**
+ * Change the load of a node that's in the heap, and restore its position.
+ */
+AWS_HTTP_API
+void aws_least_loaded_heap_update(
+    struct aws_least_loaded_heap *heap,
+    struct aws_least_loaded_heap_node *node,
+    uint64_t load);
+
+/**
+ * Returns the node with the least load, or NULL if the heap is empty.
+ * If several nodes tie for least load, any of them may be returned.
+ */
+AWS_HTTP_API
+struct aws_least_loaded_heap_node *aws_least_loaded_heap_peek(const struct aws_least_loaded_heap *heap);
+
+AWS_HTTP_API
+size_t aws_least_loaded_heap_get_size(const struct aws_least_loaded_heap *heap);
+
+/**
+ * Get the node currently at this position in the heap. Positions change as the heap changes.
+ * Helpful for iterating through the whole heap.
+ */
+AWS_HTTP_API
+struct aws_least_loaded_heap_node *aws_least_loaded_heap_get_index(
+    const struct aws_least_loaded_heap *heap,
+    size_t index);
+
+AWS_EXTERN_C_END
+#endif /* AWS_HTTP_LEAST_LOADED_HEAP_H */
@@ -0,0 +1,26 @@
+#ifndef AWS_HTTP_MEMORY_BUDGET_IMPL_H
+#define AWS_HTTP_MEMORY_BUDGET_IMPL_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/memory_budget.h>
+
+#include <aws/common/atomics.h>
+#include <aws/common/ref_count.h>
+
+struct aws_http_memory_budget {
+    struct aws_allocator *alloc;
+    struct aws_ref_count ref_count;
+    size_t max_bytes;
+
+    /* How long a connection waits to ask again, after being denied */
+    uint64_t retry_interval_ns;
+
+    /* Bytes currently reserved. Atomic, since connections on every event-loop share the budget */
+    struct aws_atomic_var reserved;
+};
+
+#endif /* AWS_HTTP_MEMORY_BUDGET_IMPL_H */
@@ -0,0 +1,70 @@
+#ifndef AWS_HTTP_RATE_LIMITER_IMPL_H
+#define AWS_HTTP_RATE_LIMITER_IMPL_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/rate_limiter.h>
+
+#include <aws/common/mutex.h>
+#include <aws/common/ref_count.h>
+
+/* Connections won't send, or open a window, in smaller pieces than this (or the burst size, if that's smaller).
+ * Otherwise a limited connection would dribble out a tiny frame every time a few tokens accrued. */
+#define AWS_HTTP_RATE_LIMITER_MIN_GRANT 1024
+
+struct aws_http_rate_limiter {
+    struct aws_allocator *alloc;
+    struct aws_ref_count ref_count;
+    uint64_t bytes_per_second;
+    size_t burst_bytes;
+
+    /* Connections on every event-loop may share the limiter. The lock is only held for a little arithmetic. */
+    struct aws_mutex lock;
+    struct {
+        size_t tokens;
+
+        /* Time that `tokens` are accurate as of. Lags behind the clock by less than one token's worth of time,
+         * so fractional tokens aren't lost */
+        uint64_t refill_timestamp_ns;
+    } synced_data;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Take up to `max_bytes` from both limiters, either of which may be NULL.
+ * Returns the amount that both granted, giving any excess back to the one that granted more.
+ */
+AWS_HTTP_API
+size_t aws_http_rate_limiter_take_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    uint64_t now_ns,
+    size_t min_bytes,
+    size_t max_bytes);
+
+/**
+ * Give `bytes` back to both limiters, either of which may be NULL.
+ */
+AWS_HTTP_API
+void aws_http_rate_limiter_give_back_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    size_t bytes);
+
+/**
+ * Returns how long until both limiters, either of which may be NULL, have `bytes` tokens available.
+ */
+AWS_HTTP_API
+uint64_t aws_http_rate_limiter_time_until_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    uint64_t now_ns,
+    size_t bytes);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_HTTP_RATE_LIMITER_IMPL_H */
@@ -18,6 +18,7 @@ struct aws_http_stream_vtable {
     void (*update_window)(struct aws_http_stream *stream, size_t increment_size);
     int (*activate)(struct aws_http_stream *stream);
     void (*cancel)(struct aws_http_stream *stream, int error_code);
+    int (*notify_body_ready)(struct aws_http_stream *stream);
 
     int (*http1_write_chunk)(struct aws_http_stream *http1_stream, const struct aws_http1_chunk_options *options);
     int (*http1_add_trailer)(struct aws_http_stream *http1_stream, const struct aws_http_headers *trailing_headers);
@@ -30,6 +31,15 @@ struct aws_http_stream_vtable {
         const struct aws_http2_stream_write_data_options *options);
 };
 
+/**
+ * Base class for retained bodies.
+ * The connection that read the data implements on_zero_refs, which frees the buffer.
+ */
+struct aws_http_retained_body {
+    struct aws_atomic_var refcount;
+    void (*on_zero_refs)(struct aws_http_retained_body *retained_body);
+};
+
 /**
  * Base class for streams.
  * There are specific implementations for each HTTP version.
@@ -45,6 +55,8 @@ struct aws_http_stream {
     aws_http_on_incoming_headers_fn *on_incoming_headers;
     aws_http_on_incoming_header_block_done_fn *on_incoming_header_block_done;
     aws_http_on_incoming_body_fn *on_incoming_body;
+    aws_http_on_incoming_body_vectored_fn *on_incoming_body_vectored;
+    aws_http_on_incoming_body_retained_fn *on_incoming_body_retained;
     aws_http_on_stream_metrics_fn *on_metrics;
     aws_http_on_stream_complete_fn *on_complete;
     aws_http_on_stream_destroy_fn *on_destroy;
@@ -53,6 +65,10 @@ struct aws_http_stream {
     enum aws_http_method request_method;
     struct aws_http_stream_metrics metrics;
 
+    /* Optional. Pace this stream on top of any connection limiters. The stream holds a reference to each */
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
     union {
         struct aws_http_stream_client_data {
             int response_status;
@@ -10,7 +10,9 @@
 
 struct aws_http_client_connection_options;
 struct aws_http_connection;
+struct aws_http_headers;
 struct aws_http_make_request_options;
+struct aws_string;
 
 /* RFC-6455 Section 5.2 Base Framing Protocol
  * Payload length:  7 bits, 7+16 bits, or 7+64 bits
@@ -65,6 +67,9 @@ struct aws_websocket_handler_options {
 
     bool is_server;
     bool manual_window_update;
+
+    /* If non-zero, release idle memory after this long without reading or writing */
+    uint64_t idle_trim_ms;
 };
 
 struct aws_websocket_client_bootstrap_system_vtable {
@@ -103,6 +108,17 @@ uint64_t aws_websocket_frame_encoded_size(const struct aws_websocket_frame *fram
 AWS_HTTP_API
 struct aws_websocket *aws_websocket_handler_new(const struct aws_websocket_handler_options *options);
 
+/**
+ * Validate the handshake response's "Sec-WebSocket-Protocol" against the request's
+ * comma-separated list of protocols (NULL if none were requested).
+ * Raises AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE if the server picked a protocol that wasn't requested.
+ */
+AWS_HTTP_API
+int aws_websocket_validate_sec_websocket_protocol(
+    const void *log_id,
+    const struct aws_string *requested_protocols,
+    const struct aws_http_headers *response_headers);
+
 /**
  * Override the functions that websocket bootstrap uses to interact with external systems.
  * Used for unit testing.
@@ -0,0 +1,111 @@
+#ifndef AWS_HTTP_RATE_LIMITER_H
+#define AWS_HTTP_RATE_LIMITER_H
+
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/http.h>
+
+AWS_PUSH_SANE_WARNING_LEVEL
+
+/**
+ * A token bucket that caps how fast data is sent or received, in bytes per second.
+ * Tokens accrue at `bytes_per_second`, up to `burst_bytes`, and every byte sent or received costs one token.
+ *
+ * A limiter may be set on a connection, to cap the connection as a whole,
+ * or on a request, to cap that one stream. If both are set, data moves only as fast as the stricter allows.
+ * Share one limiter between many streams or connections to cap their combined rate
+ * (ex: one limiter per tenant, or one for all background transfers).
+ *
+ * Sending: a connection writes no faster than its limiters allow.
+ * HTTP/1 counts every byte it writes. HTTP/2 counts DATA frame payloads.
+ *
+ * Receiving: the limiter paces flow-control window updates, so the peer can't send faster than the limit.
+ * - HTTP/1 requires `manual_window_management`, since there's no window to pace otherwise.
+ * - HTTP/2 connection limits require automatic connection window management
+ *   (`conn_manual_window_management` false). Stream limits work with automatic or manual stream windows.
+ *
+ * Tokens may be taken from any thread.
+ */
+struct aws_http_rate_limiter;
+
+struct aws_http_rate_limiter_options {
+    /**
+     * Required.
+     * Rate at which tokens accrue, in bytes per second.
+     */
+    uint64_t bytes_per_second;
+
+    /**
+     * Optional.
+     * Max number of tokens the bucket holds, which is the most that can be sent or received at full speed
+     * after the limiter has gone unused for a while.
+     * If zero is specified (the default) then 100ms worth of `bytes_per_second` is used,
+     * but no less than AWS_HTTP_RATE_LIMITER_MIN_DEFAULT_BURST.
+     */
+    size_t burst_bytes;
+};
+
+#define AWS_HTTP_RATE_LIMITER_MIN_DEFAULT_BURST (16 * 1024)
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Create a new rate limiter. Its bucket starts full.
+ * Returns NULL and raises an error on failure.
+ * The limiter is ref-counted, call aws_http_rate_limiter_release() when you're done with it.
+ */
+AWS_HTTP_API
+struct aws_http_rate_limiter *aws_http_rate_limiter_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_rate_limiter_options *options);
+
+/**
+ * Acquire a hold on the limiter, preventing it from being destroyed.
+ * Each connection and stream given the limiter acquires its own hold.
+ * Returns the limiter, for convenience.
+ */
+AWS_HTTP_API
+struct aws_http_rate_limiter *aws_http_rate_limiter_acquire(struct aws_http_rate_limiter *limiter);
+
+/**
+ * Release a hold on the limiter.
+ * The limiter is destroyed once all holds are released.
+ * Always returns NULL.
+ */
+AWS_HTTP_API
+struct aws_http_rate_limiter *aws_http_rate_limiter_release(struct aws_http_rate_limiter *limiter);
+
+/**
+ * Take up to `max_bytes` tokens.
+ * Returns the number of tokens taken, which is zero if fewer than `min_bytes` are available.
+ * `min_bytes` is capped at the burst size, so it can always be satisfied eventually.
+ * `now_ns` is the current time, from the same clock as every other user of the limiter
+ * (ex: aws_high_res_clock_get_ticks(), which is what event-loops use).
+ */
+AWS_HTTP_API
+size_t aws_http_rate_limiter_take(
+    struct aws_http_rate_limiter *limiter,
+    uint64_t now_ns,
+    size_t min_bytes,
+    size_t max_bytes);
+
+/**
+ * Return tokens that were taken but not used. The bucket never holds more than the burst size.
+ */
+AWS_HTTP_API
+void aws_http_rate_limiter_give_back(struct aws_http_rate_limiter *limiter, size_t bytes);
+
+/**
+ * Returns how many nanoseconds from `now_ns` until `bytes` tokens are available, or zero if they're available now.
+ * `bytes` is capped at the burst size.
+ */
+AWS_HTTP_API
+uint64_t aws_http_rate_limiter_time_until(struct aws_http_rate_limiter *limiter, uint64_t now_ns, size_t bytes);
+
+AWS_EXTERN_C_END
+AWS_POP_SANE_WARNING_LEVEL
+
+#endif /* AWS_HTTP_RATE_LIMITER_H */
@@ -13,6 +13,7 @@
 AWS_PUSH_SANE_WARNING_LEVEL
 
 struct aws_http_connection;
+struct aws_http_rate_limiter;
 struct aws_input_stream;
 
 /**
@@ -83,6 +84,13 @@ struct aws_http_header {
  */
 struct aws_http_headers;
 
+/**
+ * A reference to the buffer that incoming body data was read into.
+ * Holding one keeps the data valid after the body callback returns, without copying it.
+ * See `aws_http_on_incoming_body_retained_fn`.
+ */
+struct aws_http_retained_body;
+
 /**
  * Header block type.
  * INFORMATIONAL: Header block for 1xx informational (interim) responses.
@@ -179,6 +187,51 @@ typedef int(aws_http_on_incoming_header_block_done_fn)(
 typedef int(
     aws_http_on_incoming_body_fn)(struct aws_http_stream *stream, const struct aws_byte_cursor *data, void *user_data);
 
+/**
+ * Vectored alternative to `aws_http_on_incoming_body_fn`.
+ * Called with every piece of body data decoded from one read of the socket,
+ * rather than once per HTTP/1 chunk or HTTP/2 DATA frame.
+ * Slices are in the order they were received and are never empty.
+ * The data must be copied immediately if you wish to preserve it.
+ * This is always invoked on the HTTP connection's event-loop thread.
+ *
+ * Window management is the same as for `aws_http_on_incoming_body_fn`:
+ * if the connection is using manual_window_management then the window size has
+ * shrunk by the total amount of body data in all slices.
+ *
+ * Return AWS_OP_SUCCESS to continue processing the stream.
+ * Return aws_raise_error(E) to indicate failure and cancel the stream.
+ * The error you raise will be reflected in the error_code passed to the on_complete callback.
+ */
+typedef int(aws_http_on_incoming_body_vectored_fn)(
+    struct aws_http_stream *stream,
+    const struct aws_byte_cursor *slices,
+    size_t num_slices,
+    void *user_data);
+
+/**
+ * Zero-copy alternative to `aws_http_on_incoming_body_fn`. Only supported by HTTP/2.
+ * Called once per DATA frame, like `aws_http_on_incoming_body_fn`.
+ * `data` points into the buffer that `retained_body` refers to. It is only valid during the callback,
+ * unless you call aws_http_retained_body_acquire(). Then it stays valid until you call
+ * aws_http_retained_body_release(), which may be done from any thread.
+ * Several slices, even from different streams, may share one retained body.
+ * This is always invoked on the HTTP connection's event-loop thread.
+ *
+ * Window management is the same as for `aws_http_on_incoming_body_fn`,
+ * except that while body data is retained, the connection withholds that much from its automatic WINDOW_UPDATEs.
+ * So a peer can't keep sending faster than retained data is released.
+ *
+ * Return AWS_OP_SUCCESS to continue processing the stream.
+ * Return aws_raise_error(E) to indicate failure and cancel the stream.
+ * The error you raise will be reflected in the error_code passed to the on_complete callback.
+ */
+typedef int(aws_http_on_incoming_body_retained_fn)(
+    struct aws_http_stream *stream,
+    struct aws_http_retained_body *retained_body,
+    const struct aws_byte_cursor *data,
+    void *user_data);
+
 /**
  * Invoked when request has been completely read.
  * This is always invoked on the HTTP connection's event-loop thread.
@@ -315,6 +368,51 @@ struct aws_http_make_request_options {
      * TODO: Only supported in HTTP/1.1 now, support it in HTTP/2
      */
     uint64_t response_first_byte_timeout_ms;
+
+    /**
+     * Optional (ignored if false).
+     * Set true if the request's body is an asynchronous source, which may have no data ready when it is read
+     * (ex: data is still being produced on another thread).
+     * When a read produces no data, the stream is parked and costs nothing until the user calls
+     * aws_http_stream_notify_body_ready().
+     * If false, a body stream that produces no data is polled again on the next event-loop tick.
+     */
+    bool use_body_ready_notifications;
+
+    /**
+     * Invoked with all body data decoded from one read of the socket, instead of once per chunk or DATA frame.
+     * Optional.
+     * If set, on_response_body is not invoked.
+     * Useful when the response arrives in many tiny chunks or frames.
+     * See `aws_http_on_incoming_body_vectored_fn`.
+     */
+    aws_http_on_incoming_body_vectored_fn *on_response_body_vectored;
+
+    /**
+     * Invoked with body data that can be kept after the callback returns, without copying it.
+     * Optional. Only supported by HTTP/2. HTTP/1 ignores it and invokes on_response_body or
+     * on_response_body_vectored instead. On HTTP/2, if set, neither of those is invoked.
+     * Useful when the data is handed to an asynchronous sink (ex: a file write, or another socket).
+     * See `aws_http_on_incoming_body_retained_fn`.
+     */
+    aws_http_on_incoming_body_retained_fn *on_response_body_retained;
+
+    /**
+     * Optional.
+     * Caps how fast this request is sent. The stream acquires a hold on it.
+     * Applies on top of any limiter on the connection.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *send_rate_limiter;
+
+    /**
+     * Optional.
+     * Caps how fast this response is received, by pacing window updates. The stream acquires a hold on it.
+     * Applies on top of any limiter on the connection.
+     * HTTP/1 requires the connection to use manual window management.
+     * See `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *receive_rate_limiter;
 };
 
 struct aws_http_request_handler_options {
@@ -651,6 +749,24 @@ int aws_http_headers_erase_index(struct aws_http_headers *headers, size_t index)
 AWS_HTTP_API
 void aws_http_headers_clear(struct aws_http_headers *headers);
 
+/**
+ * Mark the headers immutable. This can't be undone.
+ * Any further attempt to modify them fails with AWS_ERROR_INVALID_STATE (aws_http_headers_clear() does nothing).
+ * Do this before sharing the headers with other threads.
+ *
+ * HTTP/2 connections memoize the HPACK encoding of immutable headers.
+ * A set of headers that's sent over and over (ex: the same response headers, shared by many messages)
+ * then costs a memcpy to encode, instead of a table lookup and Huffman encoding per header.
+ */
+AWS_HTTP_API
+void aws_http_headers_set_immutable(struct aws_http_headers *headers);
+
+/**
+ * Returns whether aws_http_headers_set_immutable() has been called on these headers.
+ */
+AWS_HTTP_API
+bool aws_http_headers_is_immutable(const struct aws_http_headers *headers);
+
 /**
  * Get the `:method` value (HTTP/2 headers only).
  */
@@ -1108,6 +1224,30 @@ int aws_http_stream_send_response(struct aws_http_stream *stream, struct aws_htt
 AWS_HTTP_API
 void aws_http_stream_update_window(struct aws_http_stream *stream, size_t increment_size);
 
+/**
+ * Wake a stream that was parked because its body had no data ready.
+ * Only valid for streams made with `use_body_ready_notifications` set true.
+ * Call this whenever the body (or the data of a chunk or manual write) can produce more data, or has reached its end.
+ * This may be called from any thread. It does nothing if the stream is not active.
+ */
+AWS_HTTP_API
+int aws_http_stream_notify_body_ready(struct aws_http_stream *stream);
+
+/**
+ * Keep the buffer behind a retained body alive, along with any body data pointing into it.
+ * Only call this during an `aws_http_on_incoming_body_retained_fn`, or while already holding a reference.
+ */
+AWS_HTTP_API
+struct aws_http_retained_body *aws_http_retained_body_acquire(struct aws_http_retained_body *retained_body);
+
+/**
+ * Release a reference acquired by aws_http_retained_body_acquire(). This may be called from any thread.
+ * Once the last reference is released, the buffer is freed on the connection's event-loop thread,
+ * and the connection stops withholding flow-control window for it.
+ */
+AWS_HTTP_API
+void aws_http_retained_body_release(struct aws_http_retained_body *retained_body);
+
 /**
  * Gets the HTTP/2 id associated with a stream.  Even h1 streams have an id (using the same allocation procedure
  * as http/2) for easier tracking purposes. For client streams, this will only be non-zero after a successful call
@@ -10,6 +10,7 @@
 
 AWS_PUSH_SANE_WARNING_LEVEL
 
+struct aws_http2_abuse_limits;
 struct aws_http_connection;
 struct aws_server_bootstrap;
 struct aws_socket_options;
@@ -106,6 +107,47 @@ struct aws_http_server_options {
      * reaches 0, no further data will be received.
      **/
     bool manual_window_management;
+
+    /**
+     * Optional.
+     * If non-zero, incoming connections release buffers that only grow with traffic
+     * once they've gone this many milliseconds without reading or writing.
+     * See `aws_http1_connection_options.idle_trim_ms` and `aws_http2_connection_options.idle_trim_ms`.
+     */
+    uint64_t idle_trim_ms;
+
+    /**
+     * Optional.
+     * Budget shared by all incoming connections, bounding the data they buffer in total.
+     * The server acquires a hold on it.
+     * See `aws_http1_connection_options.memory_budget` and `aws_http_memory_budget`.
+     */
+    struct aws_http_memory_budget *memory_budget;
+
+    /**
+     * Optional.
+     * Limiters shared by all incoming connections, capping their combined send and receive rates.
+     * The server acquires a hold on each.
+     * See `aws_http1_connection_options.send_rate_limiter` and `aws_http_rate_limiter`.
+     */
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
+    /**
+     * Optional.
+     * If non-zero, the max size in bytes of each header-block that incoming connections accept.
+     * HTTP/1 connections close when a request goes over, see `aws_http1_connection_options.max_header_list_size`.
+     * HTTP/2 connections advertise it as SETTINGS_MAX_HEADER_LIST_SIZE, and reset streams that go over.
+     */
+    uint32_t max_header_list_size;
+
+    /**
+     * Optional.
+     * Thresholds for detecting HTTP/2 clients that flood incoming connections with frames.
+     * The server copies them. If NULL, AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT is used.
+     * See `aws_http2_connection_options.abuse_limits` and `aws_http2_abuse_limits`.
+     */
+    const struct aws_http2_abuse_limits *abuse_limits;
 };
 
 /**
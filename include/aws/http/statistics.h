@@ -15,11 +15,16 @@ AWS_PUSH_SANE_WARNING_LEVEL
 enum aws_crt_http_statistics_category {
     AWSCRT_STAT_CAT_HTTP1_CHANNEL = AWS_CRT_STATISTICS_CATEGORY_BEGIN_RANGE(AWS_C_HTTP_PACKAGE_ID),
     AWSCRT_STAT_CAT_HTTP2_CHANNEL,
+    AWSCRT_STAT_CAT_WEBSOCKET_CHANNEL,
 };
 
 /**
  * A statistics struct for http handlers.  Tracks the actual amount of time that incoming and outgoing requests are
  * waiting for their IO to complete.
+ *
+ * Note: `resident_bytes` was appended to this struct and to `aws_crt_statistics_http2_channel`, which changes their
+ * size. The structs are only allocated by the connection and handed to statistics handlers by pointer, so the
+ * offsets of existing fields are unchanged. Code that copies them by value must be rebuilt against this header.
  */
 struct aws_crt_statistics_http1_channel {
     aws_crt_statistics_category_t category;
@@ -29,6 +34,9 @@ struct aws_crt_statistics_http1_channel {
 
     uint32_t current_outgoing_stream_id;
     uint32_t current_incoming_stream_id;
+
+    /* Approximate heap bytes held by the connection at the time of report */
+    uint64_t resident_bytes;
 };
 
 struct aws_crt_statistics_http2_channel {
@@ -39,6 +47,16 @@ struct aws_crt_statistics_http2_channel {
 
     /* True if during the time of report, there has ever been no active streams on the connection */
     bool was_inactive;
+
+    /* Approximate heap bytes held by the connection (not counting its streams) at the time of report */
+    uint64_t resident_bytes;
+};
+
+struct aws_crt_statistics_websocket_channel {
+    aws_crt_statistics_category_t category;
+
+    /* Approximate heap bytes held by the websocket at the time of report */
+    uint64_t resident_bytes;
 };
 
 AWS_EXTERN_C_BEGIN
@@ -72,6 +90,11 @@ void aws_crt_statistics_http2_channel_init(struct aws_crt_statistics_http2_chann
 AWS_HTTP_API
 void aws_crt_statistics_http2_channel_reset(struct aws_crt_statistics_http2_channel *stats);
 
+AWS_HTTP_API
+void aws_crt_statistics_websocket_channel_init(struct aws_crt_statistics_websocket_channel *stats);
+AWS_HTTP_API
+void aws_crt_statistics_websocket_channel_reset(struct aws_crt_statistics_websocket_channel *stats);
+
 AWS_EXTERN_C_END
 AWS_POP_SANE_WARNING_LEVEL
 
@@ -9,6 +9,8 @@
 
 AWS_PUSH_SANE_WARNING_LEVEL
 
+struct aws_http2_stream_manager;
+struct aws_http_connection;
 struct aws_http_header;
 struct aws_http_message;
 
@@ -288,6 +290,124 @@ struct aws_websocket_client_connection_options {
      * Host resolution override that allows the user to override DNS behavior for this particular connection.
      */
     const struct aws_host_resolution_config *host_resolution_config;
+
+    /**
+     * Optional.
+     * If non-zero, once the websocket has gone this many milliseconds without reading or writing,
+     * buffers that only grow with traffic are released. They are re-grown on demand when traffic resumes.
+     * Useful when holding many mostly-idle websockets.
+     * The websocket's current footprint is reported in `aws_crt_statistics_websocket_channel.resident_bytes`.
+     */
+    uint64_t idle_trim_ms;
+};
+
+/**
+ * Options for creating a websocket client connection as a stream on an existing HTTP/2 connection,
+ * via the extended CONNECT method (RFC-8441).
+ * Many websockets may share one HTTP/2 connection this way, instead of each having its own socket.
+ */
+struct aws_websocket_client_http2_options {
+    /**
+     * Required.
+     * Must outlive the connection.
+     */
+    struct aws_allocator *allocator;
+
+    /**
+     * HTTP/2 connection to open the websocket's stream on.
+     * Exactly one of `http2_connection` or `http2_stream_manager` must be set.
+     *
+     * The server must have sent SETTINGS_ENABLE_CONNECT_PROTOCOL=1 before the stream activates,
+     * or setup fails with AWS_ERROR_HTTP_EXTENDED_CONNECT_NOT_ENABLED.
+     * Wait for the connection's `on_initial_settings_completed` callback before using it.
+     */
+    struct aws_http_connection *http2_connection;
+
+    /**
+     * HTTP/2 stream manager to acquire the websocket's stream from.
+     * Exactly one of `http2_connection` or `http2_stream_manager` must be set.
+     */
+    struct aws_http2_stream_manager *http2_stream_manager;
+
+    /**
+     * Required.
+     * The request will be kept alive via ref-counting until the handshake completes.
+     * Suggestion: create via aws_http2_message_new_websocket_handshake_request()
+     *
+     * The request MUST be an HTTP/2 request with the following pseudo-headers (replace values in []):
+     *
+     * :method: CONNECT
+     * :protocol: websocket
+     * :scheme: [https]
+     * :path: [/chat]
+     * :authority: [server.example.com]
+     *
+     * and the following header:
+     *
+     * sec-websocket-version: 13
+     */
+    struct aws_http_message *handshake_request;
+
+    /**
+     * Initial size of the websocket's read window.
+     * Ignored unless `manual_window_management` is true.
+     */
+    size_t initial_window_size;
+
+    /**
+     * User data for callbacks.
+     * Optional.
+     */
+    void *user_data;
+
+    /**
+     * Called when connect completes.
+     * Required.
+     * See `aws_websocket_client_connection_options.on_connection_setup`.
+     */
+    aws_websocket_on_connection_setup_fn *on_connection_setup;
+
+    /**
+     * Called when connection has finished shutting down.
+     * Optional.
+     * Shutting down the websocket only ends its stream, the HTTP/2 connection stays open.
+     */
+    aws_websocket_on_connection_shutdown_fn *on_connection_shutdown;
+
+    /**
+     * Called when each new frame arrives.
+     * Optional.
+     */
+    aws_websocket_on_incoming_frame_begin_fn *on_incoming_frame_begin;
+
+    /**
+     * Called repeatedly as payload data arrives.
+     * Optional.
+     */
+    aws_websocket_on_incoming_frame_payload_fn *on_incoming_frame_payload;
+
+    /**
+     * Called when done processing an incoming frame.
+     * Optional.
+     */
+    aws_websocket_on_incoming_frame_complete_fn *on_incoming_frame_complete;
+
+    /**
+     * Set to true to manually manage the read window size.
+     * See `aws_websocket_client_connection_options.manual_window_management`.
+     *
+     * The stream's HTTP/2 flow-control window only follows the websocket's read window
+     * if the HTTP/2 connection was also created with `manual_window_management`.
+     * Otherwise, data the websocket can't take yet is buffered, up to the stream's initial window size.
+     * If the peer sends more than that, the stream is reset with AWS_ERROR_OVERFLOW_DETECTED.
+     */
+    bool manual_window_management;
+
+    /**
+     * Optional.
+     * See `aws_websocket_client_connection_options.idle_trim_ms`.
+     */
+    uint64_t idle_trim_ms;
 };
 
 /**
@@ -370,6 +490,14 @@ bool aws_websocket_is_data_frame(uint8_t opcode);
 AWS_HTTP_API
 int aws_websocket_client_connect(const struct aws_websocket_client_connection_options *options);
 
+/**
+ * Asynchronously establish a client websocket connection as a stream on an HTTP/2 connection (RFC-8441).
+ * The on_connection_setup callback is invoked when the operation has finished creating a connection, or failed.
+ * The websocket's callbacks are invoked on the HTTP/2 connection's event-loop thread.
+ */
+AWS_HTTP_API
+int aws_websocket_client_connect_over_http2(const struct aws_websocket_client_http2_options *options);
+
 /**
  * Increment the websocket's ref-count, preventing it from being destroyed.
  * @return Always returns the same pointer that is passed in.
@@ -486,6 +614,23 @@ struct aws_http_message *aws_http_message_new_websocket_handshake_request(
     struct aws_byte_cursor path,
     struct aws_byte_cursor host);
 
+/**
+ * Create HTTP/2 request with all required fields for a websocket extended CONNECT request (RFC-8441).
+ * The following pseudo-headers and headers are set:
+ *
+ * :method: CONNECT
+ * :protocol: websocket
+ * :scheme: https
+ * :path: <path>
+ * :authority: <authority>
+ * sec-websocket-version: 13
+ */
+AWS_HTTP_API
+struct aws_http_message *aws_http2_message_new_websocket_handshake_request(
+    struct aws_allocator *allocator,
+    struct aws_byte_cursor path,
+    struct aws_byte_cursor authority);
+
 AWS_EXTERN_C_END
 AWS_POP_SANE_WARNING_LEVEL
 
@@ -0,0 +1,82 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/circuit_breaker.h>
+
+#include <aws/common/clock.h>
+
+void aws_http_circuit_breaker_init(
+    struct aws_http_circuit_breaker *breaker,
+    const struct aws_http_connection_manager_circuit_breaker_options *options) {
+
+    AWS_PRECONDITION(breaker);
+    AWS_PRECONDITION(options);
+    AWS_ZERO_STRUCT(*breaker);
+
+    breaker->failure_threshold =
+        options->failure_threshold ? options->failure_threshold : AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_FAILURE_THRESHOLD;
+
+    uint64_t open_timeout_ms =
+        options->open_timeout_ms ? options->open_timeout_ms : AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_OPEN_TIMEOUT_MS;
+    breaker->open_timeout_ns = aws_timestamp_convert(open_timeout_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+
+    breaker->state = AWS_HTTP_CIRCUIT_BREAKER_CLOSED;
+}
+
+enum aws_http_circuit_breaker_state aws_http_circuit_breaker_get_state(
+    const struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns) {
+
+    AWS_PRECONDITION(breaker);
+
+    if (breaker->state == AWS_HTTP_CIRCUIT_BREAKER_OPEN &&
+        now_ns >= aws_add_u64_saturating(breaker->opened_timestamp_ns, breaker->open_timeout_ns)) {
+        return AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN;
+    }
+    return breaker->state;
+}
+
+size_t aws_http_circuit_breaker_get_connect_allowance(
+    struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns,
+    size_t connects_in_flight) {
+
+    AWS_PRECONDITION(breaker);
+
+    /* Commit to half-open here, so that the probe's failure opens the breaker again */
+    breaker->state = aws_http_circuit_breaker_get_state(breaker, now_ns);
+    switch (breaker->state) {
+        case AWS_HTTP_CIRCUIT_BREAKER_CLOSED:
+            return SIZE_MAX;
+        case AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN:
+            return connects_in_flight == 0 ? 1 : 0;
+        default:
+            return 0;
+    }
+}
+
+void aws_http_circuit_breaker_on_connect_result(
+    struct aws_http_circuit_breaker *breaker,
+    uint64_t now_ns,
+    bool success) {
+
+    AWS_PRECONDITION(breaker);
+
+    if (success) {
+        breaker->consecutive_failures = 0;
+        breaker->state = AWS_HTTP_CIRCUIT_BREAKER_CLOSED;
+        return;
+    }
+
+    ++breaker->consecutive_failures;
+
+    /* Connects started before the breaker opened may still fail after, that doesn't restart the timeout */
+    if (breaker->state == AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN ||
+        (breaker->state == AWS_HTTP_CIRCUIT_BREAKER_CLOSED &&
+         breaker->consecutive_failures >= breaker->failure_threshold)) {
+        breaker->state = AWS_HTTP_CIRCUIT_BREAKER_OPEN;
+        breaker->opened_timestamp_ns = now_ns;
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/concurrency_limiter.h>
+
+#define DEFAULT_SMOOTHING 0.2
+#define DEFAULT_RTT_TOLERANCE 2.0
+#define MIN_GRADIENT 0.5
+#define BACKOFF_RATIO 0.9
+
+/* The no-load baseline moves 1/2^N of the way towards each sample that's above it */
+#define NO_LOAD_RTT_DRIFT_SHIFT 12
+
+/* Integer square root, rounded down. The limit is small, so a few iterations of Newton's method is plenty */
+static size_t s_sqrt_size(size_t value) {
+    if (value < 2) {
+        return value;
+    }
+
+    size_t root = value;
+    size_t next = (root + value / root) / 2;
+    while (next < root) {
+        root = next;
+        next = (root + value / root) / 2;
+    }
+    return root;
+}
+
+static void s_clamp_limit(struct aws_http_concurrency_limiter *limiter) {
+    if (limiter->limit < (double)limiter->min_limit) {
+        limiter->limit = (double)limiter->min_limit;
+    } else if (limiter->limit > (double)limiter->max_limit) {
+        limiter->limit = (double)limiter->max_limit;
+    }
+}
+
+int aws_http_concurrency_limiter_init(
+    struct aws_http_concurrency_limiter *limiter,
+    const struct aws_http_concurrency_limit_options *options,
+    size_t default_max_limit) {
+
+    AWS_PRECONDITION(limiter);
+    AWS_PRECONDITION(options);
+    AWS_ZERO_STRUCT(*limiter);
+
+    limiter->min_limit = options->min_limit ? options->min_limit : 1;
+    limiter->max_limit = options->max_limit ? options->max_limit : aws_max_size(default_max_limit, 1);
+    if (limiter->min_limit > limiter->max_limit) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_GENERAL,
+            "static: Invalid concurrency limit options, min_limit %zu is greater than max_limit %zu.",
+            limiter->min_limit,
+            limiter->max_limit);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (options->smoothing < 0.0 || options->smoothing > 1.0) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_GENERAL, "static: Invalid concurrency limit options, smoothing must be between 0 and 1.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    limiter->smoothing = options->smoothing > 0.0 ? options->smoothing : DEFAULT_SMOOTHING;
+
+    if (options->rtt_tolerance != 0.0 && options->rtt_tolerance < 1.0) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_GENERAL, "static: Invalid concurrency limit options, rtt_tolerance must be at least 1.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    limiter->rtt_tolerance = options->rtt_tolerance != 0.0 ? options->rtt_tolerance : DEFAULT_RTT_TOLERANCE;
+
+    size_t initial_limit = options->initial_limit ? options->initial_limit : AWS_HTTP_CONCURRENCY_LIMIT_DEFAULT_INITIAL;
+    limiter->limit = (double)initial_limit;
+    s_clamp_limit(limiter);
+    limiter->fail_fast = options->fail_fast;
+    return AWS_OP_SUCCESS;
+}
+
+size_t aws_http_concurrency_limiter_get_limit(const struct aws_http_concurrency_limiter *limiter) {
+    AWS_PRECONDITION(limiter);
+    return (size_t)limiter->limit;
+}
+
+void aws_http_concurrency_limiter_on_sample(
+    struct aws_http_concurrency_limiter *limiter,
+    uint64_t rtt_ns,
+    size_t in_flight,
+    bool dropped) {
+
+    AWS_PRECONDITION(limiter);
+
+    if (dropped) {
+        limiter->limit *= BACKOFF_RATIO;
+        s_clamp_limit(limiter);
+        return;
+    }
+
+    rtt_ns = aws_max_u64(rtt_ns, 1);
+    if (limiter->no_load_rtt_ns == 0 || rtt_ns < limiter->no_load_rtt_ns) {
+        limiter->no_load_rtt_ns = rtt_ns;
+    } else {
+        limiter->no_load_rtt_ns += (rtt_ns - limiter->no_load_rtt_ns) >> NO_LOAD_RTT_DRIFT_SHIFT;
+    }
+
+    double gradient = limiter->rtt_tolerance * (double)limiter->no_load_rtt_ns / (double)rtt_ns;
+    if (gradient > 1.0) {
+        gradient = 1.0;
+    } else if (gradient < MIN_GRADIENT) {
+        gradient = MIN_GRADIENT;
+    }
+
+    /* Latency is fine, but far fewer requests are in flight than allowed. The application isn't pushing the limit,
+     * so this sample says nothing about whether the origin could take more. Don't let the limit run away. */
+    if (gradient == 1.0 && (double)in_flight * 2 < limiter->limit) {
+        return;
+    }
+
+    const double queue_allowance = (double)s_sqrt_size((size_t)limiter->limit);
+    const double new_limit = limiter->limit * gradient + queue_allowance;
+    limiter->limit = limiter->limit * (1.0 - limiter->smoothing) + new_limit * limiter->smoothing;
+    s_clamp_limit(limiter);
+}
@@ -8,13 +8,18 @@
 
 #include <aws/http/private/h1_connection.h>
 #include <aws/http/private/h2_connection.h>
+#include <aws/http/private/h2_stream.h>
 
 #include <aws/http/private/proxy_impl.h>
 
+#include <aws/common/encoding.h>
 #include <aws/common/hash_table.h>
 #include <aws/common/mutex.h>
 #include <aws/common/string.h>
+#include <aws/http/memory_budget.h>
+#include <aws/http/rate_limiter.h>
 #include <aws/http/request_response.h>
+#include <aws/http/status_code.h>
 #include <aws/io/channel_bootstrap.h>
 #include <aws/io/logging.h>
 #include <aws/io/socket.h>
@@ -38,6 +43,13 @@ void aws_http_client_bootstrap_destroy(struct aws_http_client_bootstrap *bootstr
     if (bootstrap->alpn_string_map) {
         aws_hash_table_clean_up(bootstrap->alpn_string_map);
     }
+    aws_http_message_release(bootstrap->h2c_upgrade_request);
+    aws_http_memory_budget_release(bootstrap->http1_options.memory_budget);
+    aws_http_memory_budget_release(bootstrap->http2_options.memory_budget);
+    aws_http_rate_limiter_release(bootstrap->http1_options.send_rate_limiter);
+    aws_http_rate_limiter_release(bootstrap->http1_options.receive_rate_limiter);
+    aws_http_rate_limiter_release(bootstrap->http2_options.send_rate_limiter);
+    aws_http_rate_limiter_release(bootstrap->http2_options.receive_rate_limiter);
     aws_mem_release(bootstrap->alloc, bootstrap);
 }
 
@@ -54,6 +66,14 @@ struct aws_http_server {
     bool is_using_tls;
     bool manual_window_management;
     size_t initial_window_size;
+    uint64_t idle_trim_ms;
+    struct aws_http_memory_budget *memory_budget;
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+    uint32_t max_header_list_size;
+    /* NULL, or points to abuse_limits_storage */
+    const struct aws_http2_abuse_limits *abuse_limits;
+    struct aws_http2_abuse_limits abuse_limits_storage;
     void *user_data;
     aws_http_server_on_incoming_connection_fn *on_incoming_connection;
     aws_http_server_on_destroy_fn *on_destroy_complete;
@@ -459,8 +479,27 @@ static void s_server_bootstrap_on_accept_channel_setup(
     /* TODO: expose http1/2 options to server API */
     struct aws_http1_connection_options http1_options;
     AWS_ZERO_STRUCT(http1_options);
+    http1_options.idle_trim_ms = server->idle_trim_ms;
+    http1_options.memory_budget = server->memory_budget;
+    http1_options.send_rate_limiter = server->send_rate_limiter;
+    http1_options.receive_rate_limiter = server->receive_rate_limiter;
+    http1_options.max_header_list_size = server->max_header_list_size;
     struct aws_http2_connection_options http2_options;
     AWS_ZERO_STRUCT(http2_options);
+    http2_options.idle_trim_ms = server->idle_trim_ms;
+    http2_options.memory_budget = server->memory_budget;
+    http2_options.send_rate_limiter = server->send_rate_limiter;
+    http2_options.receive_rate_limiter = server->receive_rate_limiter;
+    http2_options.abuse_limits = server->abuse_limits;
+    /* Advertise the limit, the decoder enforces it once the client acknowledges. The connection copies the array. */
+    struct aws_http2_setting max_header_list_size_setting = {
+        .id = AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE,
+        .value = server->max_header_list_size,
+    };
+    if (server->max_header_list_size > 0) {
+        http2_options.initial_settings_array = &max_header_list_size_setting;
+        http2_options.num_initial_settings = 1;
+    }
     connection = aws_http_connection_new_channel_handler(
         server->alloc,
         channel,
@@ -576,6 +615,9 @@ static void s_http_server_clean_up(struct aws_http_server *server) {
     }
     aws_hash_table_clean_up(&server->synced_data.channel_to_connection_map);
     aws_mutex_clean_up(&server->synced_data.lock);
+    aws_http_memory_budget_release(server->memory_budget);
+    aws_http_rate_limiter_release(server->send_rate_limiter);
+    aws_http_rate_limiter_release(server->receive_rate_limiter);
     aws_mem_release(server->alloc, server);
 }
 
@@ -649,6 +691,15 @@ struct aws_http_server *aws_http_server_new(const struct aws_http_server_options
     server->on_incoming_connection = options->on_incoming_connection;
     server->on_destroy_complete = options->on_destroy_complete;
     server->manual_window_management = options->manual_window_management;
+    server->idle_trim_ms = options->idle_trim_ms;
+    server->memory_budget = aws_http_memory_budget_acquire(options->memory_budget);
+    server->send_rate_limiter = aws_http_rate_limiter_acquire(options->send_rate_limiter);
+    server->receive_rate_limiter = aws_http_rate_limiter_acquire(options->receive_rate_limiter);
+    server->max_header_list_size = options->max_header_list_size;
+    if (options->abuse_limits) {
+        server->abuse_limits_storage = *options->abuse_limits;
+        server->abuse_limits = &server->abuse_limits_storage;
+    }
 
     int err = aws_mutex_init(&server->synced_data.lock);
     if (err) {
@@ -713,6 +764,9 @@ socket_error:
 hash_table_error:
     aws_mutex_clean_up(&server->synced_data.lock);
 mutex_error:
+    aws_http_memory_budget_release(server->memory_budget);
+    aws_http_rate_limiter_release(server->send_rate_limiter);
+    aws_http_rate_limiter_release(server->receive_rate_limiter);
     aws_mem_release(server->alloc, server);
     return NULL;
 }
@@ -768,6 +822,282 @@ const struct aws_socket_endpoint *aws_http_server_get_listener_endpoint(const st
     return &server->socket->local_endpoint;
 }
 
+/* The client connection is ready for use. Tell the user. */
+static void s_client_bootstrap_on_connection_ready(struct aws_http_client_bootstrap *http_bootstrap) {
+    http_bootstrap->connection->proxy_request_transform = http_bootstrap->proxy_request_transform;
+    http_bootstrap->connection->client_data->response_first_byte_timeout_ms =
+        http_bootstrap->response_first_byte_timeout_ms;
+
+    AWS_LOGF_INFO(
+        AWS_LS_HTTP_CONNECTION,
+        "id=%p: " PRInSTR " client connection established.",
+        (void *)http_bootstrap->connection,
+        AWS_BYTE_CURSOR_PRI(aws_http_version_to_str(http_bootstrap->connection->http_version)));
+
+    /* Tell user of successful connection.
+     * Then clear the on_setup callback so that we know it's been called */
+    http_bootstrap->on_setup(http_bootstrap->connection, AWS_ERROR_SUCCESS, http_bootstrap->user_data);
+    http_bootstrap->on_setup = NULL;
+}
+
+/* Create the HTTP/1.1 request that asks the server to upgrade to HTTP/2 (RFC-7540 3.2):
+ *
+ * OPTIONS * HTTP/1.1
+ * Host: server.example.com
+ * Connection: Upgrade, HTTP2-Settings
+ * Upgrade: h2c
+ * HTTP2-Settings: <base64url encoding of HTTP/2 SETTINGS payload>
+ */
+struct aws_http_message *aws_http_client_new_h2c_upgrade_request(
+    struct aws_allocator *alloc,
+    struct aws_byte_cursor host_name,
+    const struct aws_http2_connection_options *http2_options) {
+
+    struct aws_http_message *request = NULL;
+    struct aws_byte_buf settings_payload;
+    struct aws_byte_buf settings_value;
+    AWS_ZERO_STRUCT(settings_value);
+
+    /* Each setting is a 16bit id and 32bit value (RFC-7540 6.5.1) */
+    const size_t setting_size = sizeof(uint16_t) + sizeof(uint32_t);
+    if (aws_byte_buf_init(&settings_payload, alloc, http2_options->num_initial_settings * setting_size)) {
+        return NULL;
+    }
+    for (size_t i = 0; i < http2_options->num_initial_settings; ++i) {
+        const struct aws_http2_setting *setting = &http2_options->initial_settings_array[i];
+        aws_byte_buf_write_be16(&settings_payload, (uint16_t)setting->id);
+        aws_byte_buf_write_be32(&settings_payload, setting->value);
+    }
+
+    /* The value is base64url encoded, with any trailing '=' characters omitted (RFC-7540 3.2.1) */
+    struct aws_byte_cursor settings_payload_cursor = aws_byte_cursor_from_buf(&settings_payload);
+    size_t encoded_len = 0;
+    if (aws_base64_compute_encoded_len(settings_payload_cursor.len, &encoded_len)) {
+        goto error;
+    }
+    if (aws_byte_buf_init(&settings_value, alloc, encoded_len)) {
+        goto error;
+    }
+    if (aws_base64_encode(&settings_payload_cursor, &settings_value)) {
+        goto error;
+    }
+    for (size_t i = 0; i < settings_value.len; ++i) {
+        if (settings_value.buffer[i] == '+') {
+            settings_value.buffer[i] = '-';
+        } else if (settings_value.buffer[i] == '/') {
+            settings_value.buffer[i] = '_';
+        }
+    }
+    while (settings_value.len > 0 && settings_value.buffer[settings_value.len - 1] == '=') {
+        settings_value.len--;
+    }
+
+    request = aws_http_message_new_request(alloc);
+    if (!request) {
+        goto error;
+    }
+
+    if (aws_http_message_set_request_method(request, aws_http_method_options)) {
+        goto error;
+    }
+
+    if (aws_http_message_set_request_path(request, aws_byte_cursor_from_c_str("*"))) {
+        goto error;
+    }
+
+    struct aws_http_header required_headers[] = {
+        {
+            .name = aws_byte_cursor_from_c_str("Host"),
+            .value = host_name,
+        },
+        {
+            .name = aws_byte_cursor_from_c_str("Connection"),
+            .value = aws_byte_cursor_from_c_str("Upgrade, HTTP2-Settings"),
+        },
+        {
+            .name = aws_byte_cursor_from_c_str("Upgrade"),
+            .value = aws_byte_cursor_from_c_str("h2c"),
+        },
+        {
+            .name = aws_byte_cursor_from_c_str("HTTP2-Settings"),
+            .value = aws_byte_cursor_from_buf(&settings_value),
+        },
+    };
+
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(required_headers); ++i) {
+        if (aws_http_message_add_header(request, required_headers[i])) {
+            goto error;
+        }
+    }
+
+    aws_byte_buf_clean_up(&settings_payload);
+    aws_byte_buf_clean_up(&settings_value);
+    return request;
+
+error:
+    aws_byte_buf_clean_up(&settings_payload);
+    aws_byte_buf_clean_up(&settings_value);
+    aws_http_message_release(request);
+    return NULL;
+}
+
+/* Server accepted the upgrade. Install an HTTP/2 connection after the HTTP/1.1 connection,
+ * which passes all further data through. The response to the upgrade request arrives on stream 1. */
+static int s_h2c_install_http2_connection(struct aws_http_client_bootstrap *http_bootstrap) {
+    struct aws_http_connection *http1_connection = http_bootstrap->h2c_http1_connection;
+    struct aws_channel *channel = aws_http_connection_get_channel(http1_connection);
+
+    http_bootstrap->connection = aws_http_connection_new_channel_handler(
+        http_bootstrap->alloc,
+        channel,
+        false /*is_server*/,
+        false /*is_using_tls*/,
+        http_bootstrap->stream_manual_window_management,
+        true /*prior_knowledge_http2*/,
+        http_bootstrap->initial_window_size,
+        NULL /*alpn_string_map*/,
+        &http_bootstrap->http1_options,
+        &http_bootstrap->http2_options,
+        http_bootstrap->user_data);
+    if (!http_bootstrap->connection) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Failed to create HTTP/2 connection for h2c upgrade, error %d (%s).",
+            (void *)http1_connection,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        return AWS_OP_ERR;
+    }
+
+    /* Nobody is interested in the response to the upgrade request, it's simply drained */
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = http_bootstrap->h2c_upgrade_request,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(http_bootstrap->connection, &request_options);
+    if (!stream) {
+        return AWS_OP_ERR;
+    }
+
+    int err = aws_h2_stream_activate_upgraded(stream);
+    aws_http_stream_release(stream);
+    if (err) {
+        return AWS_OP_ERR;
+    }
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_CONNECTION,
+        "id=%p: Server accepted h2c upgrade, HTTP/2 connection id=%p installed after it.",
+        (void *)http1_connection,
+        (void *)http_bootstrap->connection);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_h2c_on_upgrade_response_header_block_done(
+    struct aws_http_stream *stream,
+    enum aws_http_header_block header_block,
+    void *user_data) {
+
+    struct aws_http_client_bootstrap *http_bootstrap = user_data;
+
+    int status = 0;
+    aws_http_stream_get_incoming_response_status(stream, &status);
+    if (header_block != AWS_HTTP_HEADER_BLOCK_INFORMATIONAL || status != AWS_HTTP_STATUS_CODE_101_SWITCHING_PROTOCOLS) {
+        return AWS_OP_SUCCESS;
+    }
+
+    /* Install the HTTP/2 connection now, before the HTTP/1.1 connection forwards any data that followed the 101 */
+    if (s_h2c_install_http2_connection(http_bootstrap)) {
+        return AWS_OP_ERR;
+    }
+
+    s_client_bootstrap_on_connection_ready(http_bootstrap);
+    return AWS_OP_SUCCESS;
+}
+
+/**
+ * Invoked when the upgrade request's stream completes.
+ * If the server switched protocols, the stream doesn't complete until the connection shuts down.
+ * Otherwise, this is invoked after the complete (non-101) response is received,
+ * or because the connection failed before a response could be received.
+ */
+static void s_h2c_on_upgrade_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
+    struct aws_http_client_bootstrap *http_bootstrap = user_data;
+    struct aws_http_connection *http1_connection = http_bootstrap->h2c_http1_connection;
+    aws_http_stream_release(stream);
+
+    if (!http_bootstrap->on_setup) {
+        /* Setup already completed with the upgraded connection, nothing more to do */
+        return;
+    }
+
+    if (error_code) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: h2c upgrade request failed, error %d (%s).",
+            (void *)http1_connection,
+            error_code,
+            aws_error_name(error_code));
+
+        /* Setup failure is reported once the channel finishes shutting down */
+        aws_channel_shutdown(aws_http_connection_get_channel(http1_connection), error_code);
+        return;
+    }
+
+    /* Server did not upgrade, so the connection stays HTTP/1.1 */
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_CONNECTION,
+        "id=%p: Server did not accept h2c upgrade, continuing as HTTP/1.1.",
+        (void *)http1_connection);
+
+    http_bootstrap->connection = http1_connection;
+    http_bootstrap->h2c_http1_connection = NULL;
+    s_client_bootstrap_on_connection_ready(http_bootstrap);
+}
+
+/* The HTTP/1.1 connection is set up, send the h2c upgrade request on it */
+static int s_h2c_send_upgrade_request(struct aws_http_client_bootstrap *http_bootstrap) {
+    http_bootstrap->h2c_http1_connection = http_bootstrap->connection;
+    http_bootstrap->connection = NULL;
+
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = http_bootstrap->h2c_upgrade_request,
+        .user_data = http_bootstrap,
+        .on_response_header_block_done = s_h2c_on_upgrade_response_header_block_done,
+        .on_complete = s_h2c_on_upgrade_complete,
+    };
+
+    struct aws_http_stream *stream =
+        aws_http_connection_make_request(http_bootstrap->h2c_http1_connection, &request_options);
+    if (!stream) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Failed to make h2c upgrade request, error %d (%s).",
+            (void *)http_bootstrap->h2c_http1_connection,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        return AWS_OP_ERR;
+    }
+
+    if (aws_http_stream_activate(stream)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Failed to activate h2c upgrade request, error %d (%s).",
+            (void *)http_bootstrap->h2c_http1_connection,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        aws_http_stream_release(stream);
+        return AWS_OP_ERR;
+    }
+
+    AWS_LOGF_TRACE(
+        AWS_LS_HTTP_CONNECTION,
+        "id=%p: Sent h2c upgrade request, waiting for response.",
+        (void *)http_bootstrap->h2c_http1_connection);
+    return AWS_OP_SUCCESS;
+}
+
 /* At this point, the channel bootstrapper has established a connection to the server and set up a channel.
  * Now we need to create the aws_http_connection and insert it into the channel as a channel-handler. */
 static void s_client_bootstrap_on_channel_setup(
@@ -839,21 +1169,15 @@ static void s_client_bootstrap_on_channel_setup(
         aws_channel_set_statistics_handler(channel, http_connection_monitor);
     }
 
-    http_bootstrap->connection->proxy_request_transform = http_bootstrap->proxy_request_transform;
-    http_bootstrap->connection->client_data->response_first_byte_timeout_ms =
-        http_bootstrap->response_first_byte_timeout_ms;
-
-    AWS_LOGF_INFO(
-        AWS_LS_HTTP_CONNECTION,
-        "id=%p: " PRInSTR " client connection established.",
-        (void *)http_bootstrap->connection,
-        AWS_BYTE_CURSOR_PRI(aws_http_version_to_str(http_bootstrap->connection->http_version)));
-
-    /* Tell user of successful connection.
-     * Then clear the on_setup callback so that we know it's been called */
-    http_bootstrap->on_setup(http_bootstrap->connection, AWS_ERROR_SUCCESS, http_bootstrap->user_data);
-    http_bootstrap->on_setup = NULL;
+    if (http_bootstrap->h2c_upgrade_request) {
+        /* Setup completes once the server responds to the upgrade request */
+        if (s_h2c_send_upgrade_request(http_bootstrap)) {
+            goto error;
+        }
+        return;
+    }
 
+    s_client_bootstrap_on_connection_ready(http_bootstrap);
     return;
 
 error:
@@ -902,6 +1226,14 @@ static void s_client_bootstrap_on_channel_shutdown(
         http_bootstrap->on_shutdown(http_bootstrap->connection, error_code, http_bootstrap->user_data);
     }
 
+    /* Release connections that were created during the h2c upgrade, but never given to the user */
+    if (http_bootstrap->h2c_http1_connection) {
+        aws_http_connection_release(http_bootstrap->h2c_http1_connection);
+        if (http_bootstrap->on_setup) {
+            aws_http_connection_release(http_bootstrap->connection);
+        }
+    }
+
     /* Clean up bootstrapper */
     aws_http_client_bootstrap_destroy(http_bootstrap);
 }
@@ -933,7 +1265,7 @@ int s_validate_http_client_connection_options(const struct aws_http_client_conne
     }
 
     /* http2_options cannot be NULL here, calling function adds them if they were missing */
-    if (options->http2_options->num_initial_settings > 0 && options->http2_options->initial_settings_array) {
+    if (options->http2_options->num_initial_settings > 0 && !options->http2_options->initial_settings_array) {
         AWS_LOGF_ERROR(
             AWS_LS_HTTP_CONNECTION,
             "static: Invalid connection options, h2 settings count is non-zero but settings array is null");
@@ -1081,6 +1413,12 @@ int aws_http_client_connect_internal(
     http_bootstrap->proxy_request_transform = proxy_request_transform;
     http_bootstrap->http1_options = *options.http1_options;
     http_bootstrap->http2_options = *options.http2_options;
+    aws_http_memory_budget_acquire(http_bootstrap->http1_options.memory_budget);
+    aws_http_memory_budget_acquire(http_bootstrap->http2_options.memory_budget);
+    aws_http_rate_limiter_acquire(http_bootstrap->http1_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(http_bootstrap->http1_options.receive_rate_limiter);
+    aws_http_rate_limiter_acquire(http_bootstrap->http2_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(http_bootstrap->http2_options.receive_rate_limiter);
     http_bootstrap->response_first_byte_timeout_ms = options.response_first_byte_timeout_ms;
 
     /* keep a copy of the settings array if it's not NULL */
@@ -1092,6 +1430,12 @@ int aws_http_client_connect_internal(
         http_bootstrap->http2_options.initial_settings_array = setting_array;
     }
 
+    /* keep a copy of the abuse limits if they're not NULL */
+    if (options.http2_options->abuse_limits) {
+        http_bootstrap->http2_abuse_limits = *options.http2_options->abuse_limits;
+        http_bootstrap->http2_options.abuse_limits = &http_bootstrap->http2_abuse_limits;
+    }
+
     if (options.alpn_string_map) {
         if (aws_http_alpn_map_init_copy(options.allocator, alpn_string_map, options.alpn_string_map)) {
             goto error;
@@ -1103,6 +1447,15 @@ int aws_http_client_connect_internal(
         http_bootstrap->monitoring_options = *options.monitoring_options;
     }
 
+    /* h2c upgrade doesn't apply when HTTP/2 is already known, or when requests are being forwarded by a proxy */
+    if (options.http2_cleartext_upgrade && !options.prior_knowledge_http2 && !proxy_request_transform) {
+        http_bootstrap->h2c_upgrade_request = aws_http_client_new_h2c_upgrade_request(
+            options.allocator, options.host_name, &http_bootstrap->http2_options);
+        if (!http_bootstrap->h2c_upgrade_request) {
+            goto error;
+        }
+    }
+
     AWS_LOGF_TRACE(
         AWS_LS_HTTP_CONNECTION,
         "static: attempting to initialize a new client channel to %s:%u",
@@ -1157,6 +1510,12 @@ int aws_http_client_connect(const struct aws_http_client_connection_options *opt
         return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
     }
 
+    /* Checked here, against the user's options, rather than against the options made for a proxy hop */
+    if (options->http2_cleartext_upgrade && options->tls_options) {
+        AWS_LOGF_ERROR(AWS_LS_HTTP_CONNECTION, "static: HTTP/2 cleartext upgrade only works with cleartext TCP.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
     if (options->proxy_options != NULL) {
         return aws_http_client_connect_via_proxy(options);
     } else {
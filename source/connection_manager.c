@@ -6,10 +6,15 @@
 #include <aws/http/connection_manager.h>
 
 #include <aws/http/connection.h>
+#include <aws/http/memory_budget.h>
+#include <aws/http/private/circuit_breaker.h>
+#include <aws/http/private/concurrency_limiter.h>
 #include <aws/http/private/connection_manager_system_vtable.h>
 #include <aws/http/private/connection_monitor.h>
 #include <aws/http/private/http_impl.h>
+#include <aws/http/private/least_loaded_heap.h>
 #include <aws/http/private/proxy_impl.h>
+#include <aws/http/rate_limiter.h>
 
 #include <aws/io/channel_bootstrap.h>
 #include <aws/io/event_loop.h>
@@ -39,6 +44,56 @@ struct aws_idle_connection {
     struct aws_http_connection *connection;
 };
 
+/*
+ * Virtual time a tenant with weight 1 is charged for each connection handed to it.
+ * A tenant with weight N is charged 1/N as much, so it's handed N times as many connections.
+ */
+#define AWS_HCM_TENANT_VIRTUAL_TIME_PER_LEASE ((uint64_t)1 << 20)
+
+/*
+ * A tenant sharing the manager, see `aws_http_connection_manager_tenant_options`.
+ * Untagged acquisitions belong to the manager's default_tenant.
+ * Protected by the manager's lock.
+ */
+struct aws_http_connection_manager_tenant {
+    struct aws_allocator *allocator;
+    struct aws_string *id; /* NULL for the default tenant */
+    struct aws_byte_cursor id_cursor; /* Key in the manager's tenants table */
+
+    /* This tenant's incomplete acquisitions, oldest first, as aws_http_connection_acquisition structs */
+    struct aws_linked_list pending_acquisitions;
+    size_t pending_acquisition_count;
+
+    /* Not counted for the default tenant, which has no cap */
+    size_t leased_connection_count;
+
+    uint32_t weight;
+    size_t max_leased_connections; /* 0 for no cap */
+
+    /* Tenants without options set are forgotten once they have nothing pending or leased */
+    bool has_options;
+
+    /* How many pending acquisitions could be handed a connection now, which is limited by the cap */
+    size_t servable_acquisition_count;
+
+    /*
+     * Virtual time of this tenant's next acquisition. Advances by AWS_HCM_TENANT_VIRTUAL_TIME_PER_LEASE / weight
+     * each time the tenant is handed a connection. It's the tenant's load in the manager's servable_tenants heap.
+     */
+    uint64_t virtual_time;
+    struct aws_least_loaded_heap_node servable_node;
+};
+
+/*
+ * A vended connection, tracked for its tenant's lease count and for timing the lease.
+ * Only kept for connections vended to a tagged tenant, or to anyone when concurrency limiting is on.
+ */
+struct aws_connection_lease {
+    struct aws_http_connection_manager_tenant *tenant; /* NULL for the default tenant */
+    uint64_t vended_timestamp;
+    bool is_timed;
+};
+
 /*
  * System vtable to use under normal circumstances
  */
@@ -193,9 +248,29 @@ struct aws_http_connection_manager {
     struct aws_linked_list idle_connections;
 
     /*
-     * The set of all incomplete connection acquisition requests
+     * Incomplete connection acquisition requests are queued per tenant.
+     * Untagged acquisitions are queued in the default tenant.
      */
-    struct aws_linked_list pending_acquisitions;
+    struct aws_http_connection_manager_tenant default_tenant;
+
+    /*
+     * Map from tenant id (struct aws_byte_cursor *) to each tagged tenant
+     * (struct aws_http_connection_manager_tenant *).
+     */
+    struct aws_hash_table tenants;
+
+    /*
+     * A min-heap of the tenants with servable acquisitions, keyed by virtual time. The next connection goes to the
+     * tenant at the top, which is the one furthest behind its fair share.
+     * Heap of `struct aws_http_connection_manager_tenant *` via their `servable_node`.
+     */
+    struct aws_least_loaded_heap servable_tenants;
+
+    /*
+     * Virtual time of the last connection handed out. A tenant that starts waiting again begins no earlier than this,
+     * so time spent not waiting isn't banked as credit against the tenants that were.
+     */
+    uint64_t virtual_time;
 
     /*
      * The number of all incomplete connection acquisition requests.  So
@@ -203,6 +278,12 @@ struct aws_http_connection_manager {
      */
     size_t pending_acquisition_count;
 
+    /*
+     * The sum of every tenant's servable_acquisition_count: acquisitions that may be handed a connection
+     * once there is one. Equal to pending_acquisition_count unless a tenant is at its cap.
+     */
+    size_t servable_acquisition_count;
+
     /*
      * Counts that contributes to the internal refcount.
      * When the value changes, s_connection_manager_internal_ref_increase/decrease needed.
@@ -241,15 +322,46 @@ struct aws_http_connection_manager {
      * HTTP/2 specific.
      */
     bool http2_prior_knowledge;
+    bool http2_cleartext_upgrade;
+    /*
+     * Outcome of the first h2c upgrade with this host. AWS_HTTP_VERSION_UNKNOWN until one completes.
+     * Protected by lock.
+     */
+    enum aws_http_version http2_cleartext_upgrade_version;
     struct aws_array_list *initial_settings;
     size_t max_closed_streams;
     bool http2_conn_manual_window_management;
 
+    /* Optional. Shared by every connection the manager creates */
+    struct aws_http_memory_budget *memory_budget;
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+
     /*
      * The maximum number of connections this manager should ever have at once.
      */
     size_t max_connections;
 
+    /*
+     * Optional adaptive limit on vended connections, beneath max_connections.
+     * Protected by lock.
+     */
+    bool concurrency_limit_enabled;
+    struct aws_http_concurrency_limiter concurrency_limiter;
+
+    /*
+     * Optional circuit breaker, to stop connecting to an endpoint that's down.
+     * Protected by lock.
+     */
+    bool circuit_breaker_enabled;
+    struct aws_http_circuit_breaker circuit_breaker;
+
+    /*
+     * Map from vended aws_http_connection * to its struct aws_connection_lease *.
+     * Protected by lock.
+     */
+    struct aws_hash_table connection_leases;
+
     /*
      * Lifecycle tracking for the connection manager.  Starts at 1.
      *
@@ -374,8 +486,8 @@ void aws_http_connection_manager_set_system_vtable(
 /*
  * A struct that functions as both the pending acquisition tracker and the about-to-complete data.
  *
- * The list in the connection manager (pending_acquisitions) is the set of all acquisition requests that we
- * haven't yet resolved.
+ * The lists in the connection manager's tenants (pending_acquisitions) are the set of all acquisition requests that
+ * we haven't yet resolved.
  *
  * In order to make sure we never invoke callbacks while holding the manager's lock, in a number of places
  * we build a list of one or more acquisitions to complete.  Once the lock is released
@@ -480,10 +592,201 @@ static void s_aws_http_connection_manager_complete_acquisitions(
     }
 }
 
+static void s_tenant_init(struct aws_http_connection_manager_tenant *tenant, struct aws_allocator *allocator) {
+    AWS_ZERO_STRUCT(*tenant);
+    tenant->allocator = allocator;
+    aws_linked_list_init(&tenant->pending_acquisitions);
+    tenant->weight = 1;
+    aws_least_loaded_heap_node_init(&tenant->servable_node);
+}
+
+static void s_tenant_destroy(void *value) {
+    struct aws_http_connection_manager_tenant *tenant = value;
+    AWS_FATAL_ASSERT(aws_linked_list_empty(&tenant->pending_acquisitions));
+    aws_string_destroy(tenant->id);
+    aws_mem_release(tenant->allocator, tenant);
+}
+
+/*
+ * Find the tenant, creating it if necessary. An empty id is the default tenant.
+ *
+ * Hard Requirement: Manager's lock must held somewhere in the call stack
+ */
+static struct aws_http_connection_manager_tenant *s_get_tenant(
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id) {
+
+    if (tenant_id.len == 0) {
+        return &manager->default_tenant;
+    }
+
+    struct aws_hash_element *element = NULL;
+    aws_hash_table_find(&manager->tenants, &tenant_id, &element);
+    if (element) {
+        return element->value;
+    }
+
+    struct aws_http_connection_manager_tenant *tenant =
+        aws_mem_calloc(manager->allocator, 1, sizeof(struct aws_http_connection_manager_tenant));
+    s_tenant_init(tenant, manager->allocator);
+    tenant->id = aws_string_new_from_cursor(manager->allocator, &tenant_id);
+    tenant->id_cursor = aws_byte_cursor_from_string(tenant->id);
+    if (aws_hash_table_put(&manager->tenants, &tenant->id_cursor, tenant, NULL)) {
+        s_tenant_destroy(tenant);
+        return NULL;
+    }
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_CONNECTION_MANAGER,
+        "id=%p: Tracking tenant \"" PRInSTR "\"",
+        (void *)manager,
+        AWS_BYTE_CURSOR_PRI(tenant->id_cursor));
+    return tenant;
+}
+
+/*
+ * Call after a tenant's pending, leased, or options change. Updates what's servable and the tenant's place in the
+ * servable heap. May destroy the tenant, if there's no longer any reason to remember it.
+ *
+ * Hard Requirement: Manager's lock must held somewhere in the call stack
+ */
+static void s_tenant_update(
+    struct aws_http_connection_manager *manager,
+    struct aws_http_connection_manager_tenant *tenant) {
+
+    size_t servable = tenant->pending_acquisition_count;
+    if (tenant->max_leased_connections) {
+        servable = aws_min_size(
+            servable, aws_sub_size_saturating(tenant->max_leased_connections, tenant->leased_connection_count));
+    }
+    manager->servable_acquisition_count -= tenant->servable_acquisition_count;
+    manager->servable_acquisition_count += servable;
+    tenant->servable_acquisition_count = servable;
+
+    const bool is_in_heap = aws_least_loaded_heap_node_is_in_heap(&tenant->servable_node);
+    if (servable > 0 && !is_in_heap) {
+        tenant->virtual_time = aws_max_u64(tenant->virtual_time, manager->virtual_time);
+        AWS_FATAL_ASSERT(
+            aws_least_loaded_heap_add(&manager->servable_tenants, &tenant->servable_node, tenant->virtual_time) ==
+            AWS_OP_SUCCESS);
+    } else if (servable == 0 && is_in_heap) {
+        aws_least_loaded_heap_remove(&manager->servable_tenants, &tenant->servable_node);
+    }
+
+    if (tenant != &manager->default_tenant && !tenant->has_options && tenant->pending_acquisition_count == 0 &&
+        tenant->leased_connection_count == 0) {
+        /* Destroys the tenant */
+        aws_hash_table_remove(&manager->tenants, &tenant->id_cursor, NULL, NULL);
+    }
+}
+
+/*
+ * Fail all of a tenant's pending acquisitions, including those waiting on its cap.
+ *
+ * Hard Requirement: Manager's lock must held somewhere in the call stack
+ */
+static void s_tenant_fail_pending_acquisitions(
+    struct aws_http_connection_manager *manager,
+    struct aws_http_connection_manager_tenant *tenant,
+    int error_code,
+    struct aws_linked_list *output_list) {
+
+    while (!aws_linked_list_empty(&tenant->pending_acquisitions)) {
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "id=%p: Failing pending connection acquisition due to manager shut down",
+            (void *)manager);
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(&tenant->pending_acquisitions);
+        struct aws_http_connection_acquisition *pending_acquisition =
+            AWS_CONTAINER_OF(node, struct aws_http_connection_acquisition, node);
+        pending_acquisition->connection = NULL;
+        pending_acquisition->error_code = error_code;
+        aws_linked_list_push_back(output_list, node);
+    }
+
+    tenant->pending_acquisition_count = 0;
+    manager->servable_acquisition_count -= tenant->servable_acquisition_count;
+    tenant->servable_acquisition_count = 0;
+    aws_least_loaded_heap_remove(&manager->servable_tenants, &tenant->servable_node);
+}
+
+/*
+ * Start tracking a lease, if its tenant has a lease count or the concurrency limiter needs it timed.
+ *
+ * Hard Requirement: Manager's lock must held somewhere in the call stack
+ */
+static void s_lease_start(
+    struct aws_http_connection_manager *manager,
+    struct aws_http_connection *connection,
+    struct aws_http_connection_manager_tenant *tenant) {
+
+    const bool is_default_tenant = tenant == &manager->default_tenant;
+    if (is_default_tenant && !manager->concurrency_limit_enabled) {
+        return;
+    }
+
+    struct aws_connection_lease *lease = aws_mem_calloc(manager->allocator, 1, sizeof(struct aws_connection_lease));
+    lease->tenant = is_default_tenant ? NULL : tenant;
+    lease->is_timed = manager->concurrency_limit_enabled &&
+                      !manager->system_vtable->aws_high_res_clock_get_ticks(&lease->vended_timestamp);
+    if (aws_hash_table_put(&manager->connection_leases, connection, lease, NULL)) {
+        /* This lease just won't be counted or timed */
+        aws_mem_release(manager->allocator, lease);
+        return;
+    }
+
+    if (lease->tenant) {
+        ++lease->tenant->leased_connection_count;
+    }
+}
+
 /*
- * Moves the first pending connection acquisition into a (task set) list.  Call this while holding the lock to
+ * Stop tracking a lease. Call before the connection is no longer counted as vended.
+ *
+ * Hard Requirement: Manager's lock must held somewhere in the call stack
+ */
+static void s_lease_end(struct aws_http_connection_manager *manager, struct aws_http_connection *connection) {
+    if (aws_hash_table_get_entry_count(&manager->connection_leases) == 0) {
+        return;
+    }
+
+    struct aws_hash_element removed;
+    int was_present = 0;
+    aws_hash_table_remove(&manager->connection_leases, connection, &removed, &was_present);
+    if (!was_present) {
+        return;
+    }
+
+    struct aws_connection_lease *lease = removed.value;
+    /* The manager can't see the requests made on a connection, so the sample is how long the lease was held.
+     * That's the request latency when each lease carries one request. Time the user holds a connection idle,
+     * or spends on several requests, reads as a slower origin and shrinks the limit. */
+    uint64_t now = 0;
+    if (lease->is_timed && manager->concurrency_limit_enabled &&
+        !manager->system_vtable->aws_high_res_clock_get_ticks(&now)) {
+        aws_http_concurrency_limiter_on_sample(
+            &manager->concurrency_limiter,
+            aws_sub_u64_saturating(now, lease->vended_timestamp),
+            manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION],
+            false /*dropped*/);
+    }
+
+    struct aws_http_connection_manager_tenant *tenant = lease->tenant;
+    aws_mem_release(manager->allocator, lease);
+    if (tenant) {
+        AWS_FATAL_ASSERT(tenant->leased_connection_count > 0);
+        --tenant->leased_connection_count;
+        s_tenant_update(manager, tenant);
+    }
+}
+
+/*
+ * Moves the next pending connection acquisition into a (task set) list.  Call this while holding the lock to
  * build the set of callbacks to be completed once the lock is released.
  *
+ * The next acquisition is the oldest of the servable tenant with the least virtual time.
+ * If the acquisition is successful, that tenant is charged for the connection.
+ *
  * Hard Requirement: Manager's lock must held somewhere in the call stack
  *
  * If this was a successful acquisition then connection is non-null
@@ -496,11 +799,18 @@ static void s_aws_http_connection_manager_move_front_acquisition(
     int error_code,
     struct aws_linked_list *output_list) {
 
-    AWS_FATAL_ASSERT(!aws_linked_list_empty(&manager->pending_acquisitions));
-    struct aws_linked_list_node *node = aws_linked_list_pop_front(&manager->pending_acquisitions);
+    AWS_FATAL_ASSERT(manager->servable_acquisition_count > 0);
+    struct aws_least_loaded_heap_node *tenant_node = aws_least_loaded_heap_peek(&manager->servable_tenants);
+    AWS_FATAL_ASSERT(tenant_node);
+    struct aws_http_connection_manager_tenant *tenant =
+        AWS_CONTAINER_OF(tenant_node, struct aws_http_connection_manager_tenant, servable_node);
+
+    AWS_FATAL_ASSERT(!aws_linked_list_empty(&tenant->pending_acquisitions));
+    struct aws_linked_list_node *node = aws_linked_list_pop_front(&tenant->pending_acquisitions);
 
     AWS_FATAL_ASSERT(manager->pending_acquisition_count > 0);
     --manager->pending_acquisition_count;
+    --tenant->pending_acquisition_count;
 
     if (error_code == AWS_ERROR_SUCCESS && connection == NULL) {
         AWS_LOGF_FATAL(
@@ -510,6 +820,15 @@ static void s_aws_http_connection_manager_move_front_acquisition(
         error_code = AWS_ERROR_UNKNOWN;
     }
 
+    if (error_code == AWS_ERROR_SUCCESS) {
+        manager->virtual_time = tenant->virtual_time;
+        tenant->virtual_time += aws_max_u64(AWS_HCM_TENANT_VIRTUAL_TIME_PER_LEASE / tenant->weight, 1);
+        aws_least_loaded_heap_update(&manager->servable_tenants, &tenant->servable_node, tenant->virtual_time);
+        s_lease_start(manager, connection, tenant);
+    }
+    /* Last use of tenant, this may destroy it */
+    s_tenant_update(manager, tenant);
+
     struct aws_http_connection_acquisition *pending_acquisition =
         AWS_CONTAINER_OF(node, struct aws_http_connection_acquisition, node);
     pending_acquisition->connection = connection;
@@ -584,6 +903,69 @@ static void s_connection_manager_internal_ref_decrease(
     }
 }
 
+/* Only invoked with the lock held */
+static bool s_concurrency_limit_reached(const struct aws_http_connection_manager *manager) {
+    return manager->concurrency_limit_enabled &&
+           manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] >=
+               aws_http_concurrency_limiter_get_limit(&manager->concurrency_limiter);
+}
+
+/* Only invoked with the lock held */
+static size_t s_connects_in_flight(const struct aws_http_connection_manager *manager) {
+    return manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] + manager->pending_settings_count;
+}
+
+/* Only invoked with the lock held. Returns how many more connects the circuit breaker allows, SIZE_MAX if any. */
+static size_t s_circuit_breaker_connect_allowance(struct aws_http_connection_manager *manager) {
+    if (!manager->circuit_breaker_enabled) {
+        return SIZE_MAX;
+    }
+
+    uint64_t now = 0;
+    manager->system_vtable->aws_high_res_clock_get_ticks(&now);
+    return aws_http_circuit_breaker_get_connect_allowance(
+        &manager->circuit_breaker, now, s_connects_in_flight(manager));
+}
+
+/*
+ * Only invoked with the lock held.
+ * While the breaker isn't closed, an acquisition is only admitted if something could serve it:
+ * an idle connection, a connect already in flight, or a connect the breaker still allows (the half-open probe).
+ */
+static bool s_circuit_breaker_rejects_acquisition(struct aws_http_connection_manager *manager) {
+    size_t allowance = s_circuit_breaker_connect_allowance(manager);
+    if (allowance == SIZE_MAX) {
+        return false;
+    }
+
+    return manager->pending_acquisition_count >=
+           manager->idle_connection_count + s_connects_in_flight(manager) + allowance;
+}
+
+/* Only invoked with the lock held */
+static void s_circuit_breaker_on_connect_result(struct aws_http_connection_manager *manager, bool success) {
+    if (!manager->circuit_breaker_enabled) {
+        return;
+    }
+
+    uint64_t now = 0;
+    manager->system_vtable->aws_high_res_clock_get_ticks(&now);
+    enum aws_http_circuit_breaker_state old_state = manager->circuit_breaker.state;
+    aws_http_circuit_breaker_on_connect_result(&manager->circuit_breaker, now, success);
+
+    if (manager->circuit_breaker.state == AWS_HTTP_CIRCUIT_BREAKER_OPEN && old_state != AWS_HTTP_CIRCUIT_BREAKER_OPEN) {
+        AWS_LOGF_WARN(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "id=%p: Circuit breaker opened after %zu consecutive connection failures",
+            (void *)manager,
+            manager->circuit_breaker.consecutive_failures);
+    } else if (
+        manager->circuit_breaker.state == AWS_HTTP_CIRCUIT_BREAKER_CLOSED &&
+        old_state != AWS_HTTP_CIRCUIT_BREAKER_CLOSED) {
+        AWS_LOGF_INFO(AWS_LS_HTTP_CONNECTION_MANAGER, "id=%p: Circuit breaker closed", (void *)manager);
+    }
+}
+
 /* Only invoked with the lock held */
 static void s_aws_http_connection_manager_build_transaction(struct aws_connection_management_transaction *work) {
     struct aws_http_connection_manager *manager = work->manager;
@@ -592,7 +974,8 @@ static void s_aws_http_connection_manager_build_transaction(struct aws_connectio
         /*
          * Step 1 - If there's free connections, complete acquisition requests
          */
-        while (!aws_linked_list_empty(&manager->idle_connections) > 0 && manager->pending_acquisition_count > 0) {
+        while (!aws_linked_list_empty(&manager->idle_connections) > 0 && manager->servable_acquisition_count > 0 &&
+               !s_concurrency_limit_reached(manager)) {
             AWS_FATAL_ASSERT(manager->idle_connection_count >= 1);
             /*
              * It is absolutely critical that this is pop_back and not front.  By making the idle connections
@@ -620,20 +1003,28 @@ static void s_aws_http_connection_manager_build_transaction(struct aws_connectio
         /*
          * Step 2 - if there's excess pending acquisitions and we have room to make more, make more
          */
-        if (manager->pending_acquisition_count >
+        if (manager->servable_acquisition_count >
             manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] + manager->pending_settings_count) {
             AWS_FATAL_ASSERT(
                 manager->max_connections >= manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] +
                                                 manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] +
                                                 manager->pending_settings_count);
 
-            work->new_connections = manager->pending_acquisition_count -
+            work->new_connections = manager->servable_acquisition_count -
                                     manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] -
                                     manager->pending_settings_count;
-            size_t max_new_connections =
-                manager->max_connections -
-                (manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] +
-                 manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] + manager->pending_settings_count);
+            /* Don't connect past the concurrency limit either, the connections would only sit idle */
+            size_t connection_cap = manager->max_connections;
+            if (manager->concurrency_limit_enabled) {
+                connection_cap =
+                    aws_min_size(connection_cap, aws_http_concurrency_limiter_get_limit(&manager->concurrency_limiter));
+            }
+            size_t max_new_connections = aws_sub_size_saturating(
+                connection_cap,
+                manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] +
+                    manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] + manager->pending_settings_count);
+            /* Don't spend sockets on an endpoint that's down, besides the half-open probe */
+            max_new_connections = aws_min_size(max_new_connections, s_circuit_breaker_connect_allowance(manager));
 
             if (work->new_connections > max_new_connections) {
                 work->new_connections = max_new_connections;
@@ -649,15 +1040,14 @@ static void s_aws_http_connection_manager_build_transaction(struct aws_connectio
         manager->idle_connection_count = 0;
 
         /*
-         * Move all manager pending acquisitions to the work completion list
+         * Move all manager pending acquisitions, from every tenant, to the work completion list
          */
-        while (!aws_linked_list_empty(&manager->pending_acquisitions)) {
-            AWS_LOGF_DEBUG(
-                AWS_LS_HTTP_CONNECTION_MANAGER,
-                "id=%p: Failing pending connection acquisition due to manager shut down",
-                (void *)manager);
-            s_aws_http_connection_manager_move_front_acquisition(
-                manager, NULL, AWS_ERROR_HTTP_CONNECTION_MANAGER_SHUTTING_DOWN, &work->completions);
+        s_tenant_fail_pending_acquisitions(
+            manager, &manager->default_tenant, AWS_ERROR_HTTP_CONNECTION_MANAGER_SHUTTING_DOWN, &work->completions);
+        for (struct aws_hash_iter iter = aws_hash_iter_begin(&manager->tenants); !aws_hash_iter_done(&iter);
+             aws_hash_iter_next(&iter)) {
+            s_tenant_fail_pending_acquisitions(
+                manager, iter.element.value, AWS_ERROR_HTTP_CONNECTION_MANAGER_SHUTTING_DOWN, &work->completions);
         }
 
         AWS_LOGF_INFO(
@@ -694,10 +1084,16 @@ static void s_aws_http_connection_manager_finish_destroy(struct aws_http_connect
     AWS_FATAL_ASSERT(manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] == 0);
     AWS_FATAL_ASSERT(manager->pending_acquisition_count == 0);
     AWS_FATAL_ASSERT(manager->internal_ref[AWS_HCMCT_OPEN_CONNECTION] == 0);
-    AWS_FATAL_ASSERT(aws_linked_list_empty(&manager->pending_acquisitions));
+    AWS_FATAL_ASSERT(aws_linked_list_empty(&manager->default_tenant.pending_acquisitions));
     AWS_FATAL_ASSERT(aws_linked_list_empty(&manager->idle_connections));
 
     aws_string_destroy(manager->host);
+    aws_hash_table_clean_up(&manager->connection_leases);
+    aws_hash_table_clean_up(&manager->tenants);
+    aws_least_loaded_heap_clean_up(&manager->servable_tenants);
+    aws_http_memory_budget_release(manager->memory_budget);
+    aws_http_rate_limiter_release(manager->send_rate_limiter);
+    aws_http_rate_limiter_release(manager->receive_rate_limiter);
     if (manager->initial_settings) {
         aws_array_list_clean_up(manager->initial_settings);
         aws_mem_release(manager->allocator, manager->initial_settings);
@@ -837,6 +1233,14 @@ struct aws_http_connection_manager *aws_http_connection_manager_new(
         return NULL;
     }
 
+    if (options->tls_connection_options && options->http2_cleartext_upgrade) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "Invalid options - HTTP/2 cleartext upgrade cannot be set when TLS is used");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
     if (options->socket_options->network_interface_name[0] != '\0' && options->num_network_interface_names > 0) {
         AWS_LOGF_ERROR(
             AWS_LS_HTTP_CONNECTION_MANAGER,
@@ -864,7 +1268,30 @@ struct aws_http_connection_manager *aws_http_connection_manager_new(
         (aws_simple_completion_callback *)s_aws_http_connection_manager_finish_destroy);
 
     aws_linked_list_init(&manager->idle_connections);
-    aws_linked_list_init(&manager->pending_acquisitions);
+    s_tenant_init(&manager->default_tenant, allocator);
+    if (aws_hash_table_init(
+            &manager->tenants,
+            allocator,
+            4,
+            aws_hash_byte_cursor_ptr,
+            (aws_hash_callback_eq_fn *)aws_byte_cursor_eq,
+            NULL /*destroy_key_fn*/,
+            s_tenant_destroy)) {
+        goto on_error;
+    }
+    if (aws_least_loaded_heap_init(&manager->servable_tenants, allocator, 1)) {
+        goto on_error;
+    }
+    if (aws_hash_table_init(
+            &manager->connection_leases,
+            allocator,
+            options->max_connections,
+            aws_hash_ptr,
+            aws_ptr_eq,
+            NULL /*destroy_key_fn*/,
+            NULL /*destroy_value_fn*/)) {
+        goto on_error;
+    }
 
     manager->host = aws_string_new_from_cursor(allocator, &options->host);
     if (manager->host == NULL) {
@@ -911,6 +1338,8 @@ struct aws_http_connection_manager *aws_http_connection_manager_new(
         manager->proxy_ev_settings.tls_options = manager->proxy_ev_tls_options;
     }
     manager->http2_prior_knowledge = options->http2_prior_knowledge;
+    manager->http2_cleartext_upgrade = options->http2_cleartext_upgrade && !options->http2_prior_knowledge;
+    manager->http2_cleartext_upgrade_version = AWS_HTTP_VERSION_UNKNOWN;
     if (options->num_initial_settings > 0) {
         manager->initial_settings = aws_mem_calloc(allocator, 1, sizeof(struct aws_array_list));
         aws_array_list_init_dynamic(
@@ -921,8 +1350,24 @@ struct aws_http_connection_manager *aws_http_connection_manager_new(
             options->num_initial_settings * sizeof(struct aws_http2_setting));
     }
     manager->max_closed_streams = options->max_closed_streams;
+    manager->memory_budget = aws_http_memory_budget_acquire(options->memory_budget);
+    manager->send_rate_limiter = aws_http_rate_limiter_acquire(options->send_rate_limiter);
+    manager->receive_rate_limiter = aws_http_rate_limiter_acquire(options->receive_rate_limiter);
     manager->http2_conn_manual_window_management = options->http2_conn_manual_window_management;
 
+    if (options->concurrency_limit_options) {
+        if (aws_http_concurrency_limiter_init(
+                &manager->concurrency_limiter, options->concurrency_limit_options, options->max_connections)) {
+            goto on_error;
+        }
+        manager->concurrency_limit_enabled = true;
+    }
+
+    if (options->circuit_breaker_options) {
+        aws_http_circuit_breaker_init(&manager->circuit_breaker, options->circuit_breaker_options);
+        manager->circuit_breaker_enabled = true;
+    }
+
     manager->network_interface_names_index = 0;
     if (options->num_network_interface_names > 0) {
         aws_array_list_init_dynamic(
@@ -1056,6 +1501,15 @@ static int s_aws_http_connection_manager_new_connection(struct aws_http_connecti
     options.manual_window_management = manager->enable_read_back_pressure;
     options.proxy_ev_settings = &manager->proxy_ev_settings;
     options.prior_knowledge_http2 = manager->http2_prior_knowledge;
+    if (manager->http2_cleartext_upgrade) {
+        aws_mutex_lock(&manager->lock);
+        enum aws_http_version upgrade_version = manager->http2_cleartext_upgrade_version;
+        aws_mutex_unlock(&manager->lock);
+
+        /* Only ask the host to upgrade until we know its answer */
+        options.http2_cleartext_upgrade = upgrade_version == AWS_HTTP_VERSION_UNKNOWN;
+        options.prior_knowledge_http2 = upgrade_version == AWS_HTTP_VERSION_2;
+    }
 
     struct aws_http2_connection_options h2_options;
     AWS_ZERO_STRUCT(h2_options);
@@ -1069,9 +1523,20 @@ static int s_aws_http_connection_manager_new_connection(struct aws_http_connecti
      * connection set up */
     h2_options.on_initial_settings_completed = s_aws_http_connection_manager_h2_on_initial_settings_completed;
     h2_options.on_goaway_received = s_aws_http_connection_manager_h2_on_goaway_received;
+    h2_options.memory_budget = manager->memory_budget;
+    h2_options.send_rate_limiter = manager->send_rate_limiter;
+    h2_options.receive_rate_limiter = manager->receive_rate_limiter;
 
     options.http2_options = &h2_options;
 
+    struct aws_http1_connection_options h1_options;
+    AWS_ZERO_STRUCT(h1_options);
+    h1_options.memory_budget = manager->memory_budget;
+    h1_options.send_rate_limiter = manager->send_rate_limiter;
+    h1_options.receive_rate_limiter = manager->receive_rate_limiter;
+
+    options.http1_options = &h1_options;
+
     if (aws_http_connection_monitoring_options_is_valid(&manager->monitoring_options)) {
         options.monitoring_options = &manager->monitoring_options;
     }
@@ -1171,6 +1636,9 @@ static void s_aws_http_connection_manager_execute_transaction(struct aws_connect
 
         AWS_FATAL_ASSERT(manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] >= new_connection_failures);
         s_connection_manager_internal_ref_decrease(manager, AWS_HCMCT_PENDING_CONNECTIONS, new_connection_failures);
+        for (size_t f = 0; f < new_connection_failures; ++f) {
+            s_circuit_breaker_on_connect_result(manager, false /*success*/);
+        }
 
         /*
          * Rather than failing one acquisition for each connection failure, if there's at least one
@@ -1181,7 +1649,7 @@ static void s_aws_http_connection_manager_execute_transaction(struct aws_connect
          * representative error.
          */
         size_t i = 0;
-        while (manager->pending_acquisition_count > manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS]) {
+        while (manager->servable_acquisition_count > manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS]) {
             int error = representative_error;
             if (i < aws_array_list_length(&errors)) {
                 aws_array_list_get_at(&errors, &error, i);
@@ -1212,13 +1680,12 @@ static void s_aws_http_connection_manager_execute_transaction(struct aws_connect
     s_aws_connection_management_transaction_clean_up(work);
 }
 
-void aws_http_connection_manager_acquire_connection(
+static void s_acquire_connection(
     struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id,
     aws_http_connection_manager_on_connection_setup_fn *callback,
     void *user_data) {
 
-    AWS_LOGF_DEBUG(AWS_LS_HTTP_CONNECTION_MANAGER, "id=%p: Acquire connection", (void *)manager);
-
     struct aws_http_connection_acquisition *request =
         aws_mem_calloc(manager->allocator, 1, sizeof(struct aws_http_connection_acquisition));
 
@@ -1235,8 +1702,33 @@ void aws_http_connection_manager_acquire_connection(
     /* It's a use after free crime, we don't want to handle */
     AWS_FATAL_ASSERT(manager->state == AWS_HCMST_READY);
 
-    aws_linked_list_push_back(&manager->pending_acquisitions, &request->node);
-    ++manager->pending_acquisition_count;
+    struct aws_http_connection_manager_tenant *tenant = NULL;
+    if (manager->concurrency_limit_enabled && manager->concurrency_limiter.fail_fast &&
+        manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION] + manager->pending_acquisition_count >=
+            aws_http_concurrency_limiter_get_limit(&manager->concurrency_limiter)) {
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "id=%p: Failing connection acquisition, concurrency limit of %zu reached",
+            (void *)manager,
+            aws_http_concurrency_limiter_get_limit(&manager->concurrency_limiter));
+        request->error_code = AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED;
+        aws_linked_list_push_back(&work.completions, &request->node);
+    } else if (s_circuit_breaker_rejects_acquisition(manager)) {
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "id=%p: Failing connection acquisition, circuit breaker is open",
+            (void *)manager);
+        request->error_code = AWS_ERROR_HTTP_CIRCUIT_BREAKER_OPEN;
+        aws_linked_list_push_back(&work.completions, &request->node);
+    } else if ((tenant = s_get_tenant(manager, tenant_id)) == NULL) {
+        request->error_code = aws_last_error();
+        aws_linked_list_push_back(&work.completions, &request->node);
+    } else {
+        aws_linked_list_push_back(&tenant->pending_acquisitions, &request->node);
+        ++tenant->pending_acquisition_count;
+        ++manager->pending_acquisition_count;
+        s_tenant_update(manager, tenant);
+    }
 
     s_aws_http_connection_manager_build_transaction(&work);
 
@@ -1245,6 +1737,77 @@ void aws_http_connection_manager_acquire_connection(
     s_aws_http_connection_manager_execute_transaction(&work);
 }
 
+void aws_http_connection_manager_acquire_connection(
+    struct aws_http_connection_manager *manager,
+    aws_http_connection_manager_on_connection_setup_fn *callback,
+    void *user_data) {
+
+    AWS_LOGF_DEBUG(AWS_LS_HTTP_CONNECTION_MANAGER, "id=%p: Acquire connection", (void *)manager);
+
+    s_acquire_connection(manager, (struct aws_byte_cursor){0}, callback, user_data);
+}
+
+void aws_http_connection_manager_acquire_connection_for_tenant(
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id,
+    aws_http_connection_manager_on_connection_setup_fn *callback,
+    void *user_data) {
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_CONNECTION_MANAGER,
+        "id=%p: Acquire connection for tenant \"" PRInSTR "\"",
+        (void *)manager,
+        AWS_BYTE_CURSOR_PRI(tenant_id));
+
+    s_acquire_connection(manager, tenant_id, callback, user_data);
+}
+
+int aws_http_connection_manager_set_tenant_options(
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor tenant_id,
+    const struct aws_http_connection_manager_tenant_options *options) {
+
+    if (tenant_id.len == 0) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION_MANAGER, "id=%p: Tenant options require a non-empty tenant id", (void *)manager);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct aws_connection_management_transaction work;
+    s_aws_connection_management_transaction_init(&work, manager);
+
+    aws_mutex_lock(&manager->lock);
+
+    struct aws_http_connection_manager_tenant *tenant = s_get_tenant(manager, tenant_id);
+    if (tenant == NULL) {
+        aws_mutex_unlock(&manager->lock);
+        s_aws_connection_management_transaction_clean_up(&work);
+        return AWS_OP_ERR;
+    }
+
+    tenant->has_options = options != NULL;
+    tenant->weight = (options && options->weight) ? options->weight : 1;
+    tenant->max_leased_connections = options ? options->max_leased_connections : 0;
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_CONNECTION_MANAGER,
+        "id=%p: Tenant \"" PRInSTR "\" set to weight %" PRIu32 ", max leased connections %zu",
+        (void *)manager,
+        AWS_BYTE_CURSOR_PRI(tenant_id),
+        tenant->weight,
+        tenant->max_leased_connections);
+
+    /* Raising the cap may have made acquisitions servable. This may destroy the tenant */
+    s_tenant_update(manager, tenant);
+
+    s_aws_http_connection_manager_build_transaction(&work);
+
+    aws_mutex_unlock(&manager->lock);
+
+    s_aws_http_connection_manager_execute_transaction(&work);
+    return AWS_OP_SUCCESS;
+}
+
 /* Only invoke with lock held */
 static int s_idle_connection(struct aws_http_connection_manager *manager, struct aws_http_connection *connection) {
     struct aws_idle_connection *idle_connection =
@@ -1305,6 +1868,7 @@ int aws_http_connection_manager_release_connection(
 
     result = AWS_OP_SUCCESS;
 
+    s_lease_end(manager, connection);
     s_connection_manager_internal_ref_decrease(manager, AWS_HCMCT_VENDED_CONNECTION, 1);
 
     if (!should_release_connection) {
@@ -1380,6 +1944,8 @@ static void s_cm_on_connection_ready_or_failed(
 
     bool is_shutting_down = manager->state == AWS_HCMST_SHUTTING_DOWN;
 
+    s_circuit_breaker_on_connect_result(manager, !error_code);
+
     if (!error_code) {
         if (is_shutting_down || s_idle_connection(manager, connection)) {
             /*
@@ -1393,8 +1959,16 @@ static void s_cm_on_connection_ready_or_failed(
             work->connection_to_release = connection;
         }
     } else {
+        /* A failed connect is a sign the origin is struggling, as much as a slow response */
+        if (manager->concurrency_limit_enabled) {
+            aws_http_concurrency_limiter_on_sample(
+                &manager->concurrency_limiter,
+                0 /*rtt_ns*/,
+                manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION],
+                true /*dropped*/);
+        }
         /* fail acquisition as one connection cannot be used any more */
-        while (manager->pending_acquisition_count >
+        while (manager->servable_acquisition_count >
                manager->internal_ref[AWS_HCMCT_PENDING_CONNECTIONS] + manager->pending_settings_count) {
             AWS_LOGF_DEBUG(
                 AWS_LS_HTTP_CONNECTION_MANAGER,
@@ -1473,6 +2047,17 @@ static void s_aws_http_connection_manager_on_connection_setup(
         s_connection_manager_internal_ref_increase(manager, AWS_HCMCT_OPEN_CONNECTION, 1);
     }
 
+    if (connection != NULL && manager->http2_cleartext_upgrade &&
+        manager->http2_cleartext_upgrade_version == AWS_HTTP_VERSION_UNKNOWN) {
+        /* Remember whether the host accepted the h2c upgrade */
+        manager->http2_cleartext_upgrade_version = manager->system_vtable->aws_http_connection_get_version(connection);
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION_MANAGER,
+            "id=%p: h2c upgrade resulted in " PRInSTR " connection, further connections will use it",
+            (void *)manager,
+            AWS_BYTE_CURSOR_PRI(aws_http_version_to_str(manager->http2_cleartext_upgrade_version)));
+    }
+
     if (connection != NULL &&
         manager->system_vtable->aws_http_connection_get_version(connection) == AWS_HTTP_VERSION_2) {
         /* If the manager is shutting down, we will still wait for the settings, since we don't have map for connections
@@ -1617,5 +2202,14 @@ void aws_http_connection_manager_fetch_metrics(
     out_metrics->available_concurrency = manager->idle_connection_count;
     out_metrics->pending_concurrency_acquires = manager->pending_acquisition_count;
     out_metrics->leased_concurrency = manager->internal_ref[AWS_HCMCT_VENDED_CONNECTION];
+    out_metrics->concurrency_limit = manager->concurrency_limit_enabled
+                                         ? aws_http_concurrency_limiter_get_limit(&manager->concurrency_limiter)
+                                         : 0;
+    out_metrics->circuit_breaker_state = AWS_HTTP_CIRCUIT_BREAKER_CLOSED;
+    if (manager->circuit_breaker_enabled) {
+        uint64_t now = 0;
+        manager->system_vtable->aws_high_res_clock_get_ticks(&now);
+        out_metrics->circuit_breaker_state = aws_http_circuit_breaker_get_state(&manager->circuit_breaker, now);
+    }
     AWS_FATAL_ASSERT(aws_mutex_unlock((struct aws_mutex *)(void *)&manager->lock) == AWS_OP_SUCCESS);
 }
@@ -5,10 +5,13 @@
 #include <aws/common/clock.h>
 #include <aws/common/math.h>
 #include <aws/common/mutex.h>
+#include <aws/common/ref_count.h>
 #include <aws/common/string.h>
 #include <aws/http/private/h1_connection.h>
 #include <aws/http/private/h1_decoder.h>
 #include <aws/http/private/h1_stream.h>
+#include <aws/http/private/memory_budget_impl.h>
+#include <aws/http/private/rate_limiter_impl.h>
 #include <aws/http/private/request_response_impl.h>
 #include <aws/http/status_code.h>
 #include <aws/io/event_loop.h>
@@ -67,6 +70,7 @@ static int s_decoder_on_request(
     void *user_data);
 static int s_decoder_on_response(int status_code, void *user_data);
 static int s_decoder_on_header(const struct aws_h1_decoded_header *header, void *user_data);
+static int s_flush_incoming_body_slices(struct aws_h1_connection *connection);
 static int s_decoder_on_body(const struct aws_byte_cursor *data, bool finished, void *user_data);
 static int s_decoder_on_done(void *user_data);
 static void s_reset_statistics(struct aws_channel_handler *handler);
@@ -286,6 +290,84 @@ static size_t s_calculate_stream_mode_desired_connection_window(struct aws_h1_co
     return desired_connection_window;
 }
 
+/* Open the window no further than the budget has room for, since whatever the peer sends into it may be buffered.
+ * Nothing is reserved here, the budget is only charged for bytes actually sitting in the read buffer,
+ * but the window that's already open counts against the room.
+ * If the budget lacks room for the whole increment, ask again later. Returns the amount allowed. */
+static size_t s_limit_connection_window_by_budget(struct aws_h1_connection *connection, size_t increment_size) {
+    struct aws_http_memory_budget *budget = connection->base.memory_budget;
+
+    const size_t room = aws_sub_size_saturating(
+        aws_http_memory_budget_get_available(budget), connection->thread_data.connection_window);
+    const size_t granted = aws_min_size(increment_size, room);
+
+    if (granted < increment_size && !connection->thread_data.is_memory_budget_retry_scheduled) {
+        AWS_LOGF_TRACE(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Memory budget has room for %zu of %zu byte window increment, will ask again later.",
+            (void *)&connection->base,
+            granted,
+            increment_size);
+
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+        aws_channel_schedule_task_future(
+            connection->base.channel_slot->channel,
+            &connection->memory_budget_retry_task,
+            now_ns + budget->retry_interval_ns);
+        connection->thread_data.is_memory_budget_retry_scheduled = true;
+    }
+
+    return granted;
+}
+
+/* Take as much of `increment_size` as the receive rate limiters allow.
+ * If they can't cover the whole increment, try again once they can. Returns the amount taken. */
+static size_t s_take_connection_window_from_rate_limiters(struct aws_h1_connection *connection, size_t increment_size) {
+    struct aws_http_rate_limiter *connection_limiter = connection->base.receive_rate_limiter;
+    struct aws_http_rate_limiter *stream_limiter = NULL;
+    if (!connection->thread_data.has_switched_protocols) {
+        if (!connection->base.stream_manual_window_management) {
+            /* The window never closes, so there's nothing to pace */
+            return increment_size;
+        }
+        if (connection->thread_data.incoming_stream) {
+            stream_limiter = connection->thread_data.incoming_stream->base.receive_rate_limiter;
+        }
+    }
+
+    if ((!connection_limiter && !stream_limiter) || increment_size == 0) {
+        return increment_size;
+    }
+
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    const size_t granted = aws_http_rate_limiter_take_both(
+        connection_limiter, stream_limiter, now_ns, AWS_HTTP_RATE_LIMITER_MIN_GRANT, increment_size);
+
+    if (granted < increment_size && !connection->thread_data.is_receive_rate_limit_task_scheduled) {
+        const uint64_t wait_ns = aws_http_rate_limiter_time_until_both(
+            connection_limiter,
+            stream_limiter,
+            now_ns,
+            aws_min_size(increment_size - granted, AWS_HTTP_RATE_LIMITER_MIN_GRANT));
+
+        AWS_LOGF_TRACE(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Receive rate limit allowed %zu of %zu byte window increment, will resume in %" PRIu64 "ns.",
+            (void *)&connection->base,
+            granted,
+            increment_size,
+            wait_ns);
+
+        aws_channel_schedule_task_future(
+            connection->base.channel_slot->channel, &connection->receive_rate_limit_task, now_ns + wait_ns);
+        connection->thread_data.is_receive_rate_limit_task_scheduled = true;
+    }
+
+    return granted;
+}
+
 /* Increment connection window, if necessary */
 static int s_update_connection_window(struct aws_h1_connection *connection) {
     AWS_ASSERT(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
@@ -298,7 +380,12 @@ static int s_update_connection_window(struct aws_h1_connection *connection) {
                                     ? s_calculate_midchannel_desired_connection_window(connection)
                                     : s_calculate_stream_mode_desired_connection_window(connection);
 
-    const size_t increment_size = aws_sub_size_saturating(desired_size, connection->thread_data.connection_window);
+    size_t increment_size = aws_sub_size_saturating(desired_size, connection->thread_data.connection_window);
+    if (connection->base.memory_budget) {
+        increment_size = s_limit_connection_window_by_budget(connection, increment_size);
+    }
+    increment_size = s_take_connection_window_from_rate_limiters(connection, increment_size);
+
     if (increment_size > 0) {
         /* Update local `connection_window`. See comments at variable's declaration site
          * on why we use this instead of the official `aws_channel_slot.window_size` */
@@ -1058,11 +1145,51 @@ static void s_write_outgoing_stream(struct aws_h1_connection *connection, bool f
     msg->on_completion = s_on_channel_write_complete;
     msg->user_data = connection;
 
+    /* Write no more than the send rate limiters allow. If they allow nothing, come back once they do */
+    struct aws_http_rate_limiter *connection_limiter = connection->base.send_rate_limiter;
+    struct aws_http_rate_limiter *stream_limiter = outgoing_stream->base.send_rate_limiter;
+    const bool is_rate_limited = connection_limiter || stream_limiter;
+    struct aws_byte_buf *dst = &msg->message_data;
+    struct aws_byte_buf limited_dst;
+    size_t send_allowance = 0;
+    if (is_rate_limited) {
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+        send_allowance = aws_http_rate_limiter_take_both(
+            connection_limiter, stream_limiter, now_ns, AWS_HTTP_RATE_LIMITER_MIN_GRANT, msg->message_data.capacity);
+
+        if (send_allowance == 0) {
+            const uint64_t wait_ns = aws_http_rate_limiter_time_until_both(
+                connection_limiter, stream_limiter, now_ns, AWS_HTTP_RATE_LIMITER_MIN_GRANT);
+            AWS_LOGF_TRACE(
+                AWS_LS_HTTP_CONNECTION,
+                "id=%p: Outgoing stream task is rate limited, will resume in %" PRIu64 "ns.",
+                (void *)&connection->base,
+                wait_ns);
+
+            aws_mem_release(msg->allocator, msg);
+            aws_channel_schedule_task_future(
+                connection->base.channel_slot->channel, &connection->outgoing_stream_task, now_ns + wait_ns);
+            return;
+        }
+
+        if (send_allowance < msg->message_data.capacity) {
+            limited_dst = aws_byte_buf_from_empty_array(msg->message_data.buffer, send_allowance);
+            dst = &limited_dst;
+        }
+    }
+
     /*
      * Fill message data from the outgoing stream.
      * Note that we might be resuming work on a stream from a previous run of this task.
      */
-    if (AWS_OP_SUCCESS != aws_h1_encoder_process(&connection->thread_data.encoder, &msg->message_data)) {
+    int encode_err = aws_h1_encoder_process(&connection->thread_data.encoder, dst);
+    msg->message_data.len = dst->len;
+    if (is_rate_limited) {
+        aws_http_rate_limiter_give_back_both(
+            connection_limiter, stream_limiter, send_allowance - msg->message_data.len);
+    }
+    if (encode_err) {
         /* Error sending data, abandon ship */
         goto error;
     }
@@ -1073,6 +1200,7 @@ static void s_write_outgoing_stream(struct aws_h1_connection *connection, bool f
             "id=%p: Outgoing stream task is sending message of size %zu.",
             (void *)&connection->base,
             msg->message_data.len);
+        connection->thread_data.activity_count++;
 
         if (aws_channel_slot_send_message(connection->base.channel_slot, msg, AWS_CHANNEL_DIR_WRITE)) {
             AWS_LOGF_ERROR(
@@ -1085,11 +1213,26 @@ static void s_write_outgoing_stream(struct aws_h1_connection *connection, bool f
             goto error;
         }
 
+    } else if (
+        outgoing_stream->use_body_ready_notifications &&
+        aws_h1_encoder_is_message_in_progress(&connection->thread_data.encoder)) {
+        /* If message is empty, the body isn't ready, so the body streaming function has no data to write yet.
+         * The user promised to call aws_http_stream_notify_body_ready() when there's more data,
+         * so stop the task instead of polling. It will be kicked off again by the notification. */
+        AWS_LOGF_TRACE(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Current outgoing stream %p sent no data, outgoing stream task stopped until body is ready.",
+            (void *)&connection->base,
+            (void *)&outgoing_stream->base);
+
+        aws_mem_release(msg->allocator, msg);
+
+        connection->thread_data.is_outgoing_stream_task_active = false;
     } else {
         /* If message is empty, warn that no work is being done
          * and reschedule the task to try again next tick.
          * It's likely that body isn't ready, so body streaming function has no data to write yet.
-         * If this scenario turns out to be common we should implement a "pause" feature. */
+         * Streams can opt into use_body_ready_notifications to avoid this polling. */
         AWS_LOGF_WARN(
             AWS_LS_HTTP_CONNECTION,
             "id=%p: Current outgoing stream %p sent no data, will try again next tick.",
@@ -1251,6 +1394,11 @@ static int s_decoder_on_header(const struct aws_h1_decoded_header *header, void
         }
     }
 
+    /* Body data must reach the user before the trailing headers that follow it */
+    if (s_flush_incoming_body_slices(connection)) {
+        return AWS_OP_ERR;
+    }
+
     if (incoming_stream->base.on_incoming_headers) {
         struct aws_http_header deliver = {
             .name = header->name_data,
@@ -1322,6 +1470,42 @@ static int s_mark_head_done(struct aws_h1_stream *incoming_stream) {
     return AWS_OP_SUCCESS;
 }
 
+/* Deliver any body data gathered for the incoming stream's vectored callback.
+ * This must happen before the aws_io_message the data points into is released,
+ * and before any later callbacks (trailing headers, completion) for the stream. */
+static int s_flush_incoming_body_slices(struct aws_h1_connection *connection) {
+    struct aws_array_list *slices = &connection->thread_data.incoming_body_slices;
+    size_t num_slices = aws_array_list_length(slices);
+    if (num_slices == 0) {
+        return AWS_OP_SUCCESS;
+    }
+
+    struct aws_h1_stream *incoming_stream = connection->thread_data.incoming_stream;
+    AWS_ASSERT(incoming_stream && incoming_stream->base.on_incoming_body_vectored);
+
+    AWS_LOGF_TRACE(
+        AWS_LS_HTTP_STREAM,
+        "id=%p: Delivering %zu incoming body slices.",
+        (void *)&incoming_stream->base,
+        num_slices);
+
+    int err = incoming_stream->base.on_incoming_body_vectored(
+        &incoming_stream->base, slices->data, num_slices, incoming_stream->base.user_data);
+    aws_array_list_clear(slices);
+    if (err) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_STREAM,
+            "id=%p: Incoming body callback raised error %d (%s).",
+            (void *)&incoming_stream->base,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 static int s_decoder_on_body(const struct aws_byte_cursor *data, bool finished, void *user_data) {
     (void)finished;
 
@@ -1362,7 +1546,12 @@ static int s_decoder_on_body(const struct aws_byte_cursor *data, bool finished,
         }
     }
 
-    if (incoming_stream->base.on_incoming_body) {
+    if (incoming_stream->base.on_incoming_body_vectored) {
+        /* Gather it up, the whole batch is delivered by s_flush_incoming_body_slices() */
+        if (aws_array_list_push_back(&connection->thread_data.incoming_body_slices, data)) {
+            return AWS_OP_ERR;
+        }
+    } else if (incoming_stream->base.on_incoming_body) {
         err = incoming_stream->base.on_incoming_body(&incoming_stream->base, data, incoming_stream->base.user_data);
         if (err) {
             AWS_LOGF_ERROR(
@@ -1389,6 +1578,11 @@ static int s_decoder_on_done(void *user_data) {
     if (err) {
         return AWS_OP_ERR;
     }
+
+    if (s_flush_incoming_body_slices(connection)) {
+        return AWS_OP_ERR;
+    }
+
     /* If it is a informational response, we stop here, keep waiting for new response */
     enum aws_http_header_block header_block =
         aws_h1_decoder_get_header_block(connection->thread_data.incoming_stream_decoder);
@@ -1455,6 +1649,90 @@ static int s_decoder_on_done(void *user_data) {
     return AWS_OP_SUCCESS;
 }
 
+static size_t s_get_resident_bytes(const struct aws_h1_connection *connection) {
+    return sizeof(struct aws_h1_connection) +
+           aws_h1_decoder_get_resident_bytes(connection->thread_data.incoming_stream_decoder) +
+           aws_array_list_capacity(&connection->thread_data.incoming_body_slices) * sizeof(struct aws_byte_cursor);
+}
+
+static void s_schedule_idle_trim_task(struct aws_h1_connection *connection) {
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    aws_channel_schedule_task_future(
+        connection->base.channel_slot->channel, &connection->idle_trim_task, now_ns + connection->idle_trim_ns);
+}
+
+/* Runs every idle_trim_ns. If nothing was read or written since the last run, release the memory that
+ * only grows with traffic. It's re-grown on demand once traffic resumes. */
+static void s_idle_trim_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    struct aws_h1_connection *connection = arg;
+    if (connection->thread_data.is_reading_stopped || connection->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    if (connection->thread_data.activity_count != connection->thread_data.activity_count_at_last_idle_check) {
+        connection->thread_data.activity_count_at_last_idle_check = connection->thread_data.activity_count;
+        connection->thread_data.is_idle_trimmed = false;
+
+    } else if (!connection->thread_data.is_idle_trimmed) {
+        size_t prev_resident_bytes = s_get_resident_bytes(connection);
+
+        aws_h1_decoder_trim(connection->thread_data.incoming_stream_decoder);
+
+        /* Body slices are only gathered while an aws_io_message is being processed */
+        struct aws_array_list *slices = &connection->thread_data.incoming_body_slices;
+        if (aws_array_list_length(slices) == 0 && aws_array_list_capacity(slices) > 0) {
+            aws_array_list_clean_up(slices);
+            aws_array_list_init_dynamic(slices, connection->base.alloc, 0, sizeof(struct aws_byte_cursor));
+        }
+
+        connection->thread_data.is_idle_trimmed = true;
+
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Connection is idle, trimmed resident memory from %zu to %zu bytes.",
+            (void *)&connection->base,
+            prev_resident_bytes,
+            s_get_resident_bytes(connection));
+    }
+
+    s_schedule_idle_trim_task(connection);
+}
+
+static void s_memory_budget_retry_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_h1_connection *connection = arg;
+    connection->thread_data.is_memory_budget_retry_scheduled = false;
+
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    if (s_update_connection_window(connection)) {
+        s_shutdown_due_to_error(connection, aws_last_error());
+    }
+}
+
+static void s_receive_rate_limit_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_h1_connection *connection = arg;
+    connection->thread_data.is_receive_rate_limit_task_scheduled = false;
+
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    if (s_update_connection_window(connection)) {
+        s_shutdown_due_to_error(connection, aws_last_error());
+    }
+}
+
 /* Common new() logic for server & client */
 static struct aws_h1_connection *s_connection_new(
     struct aws_allocator *alloc,
@@ -1496,7 +1774,13 @@ static struct aws_h1_connection *s_connection_new(
                 aws_max_size(clamp_min, aws_min_size(clamp_max, initial_window_size));
         }
 
-        connection->thread_data.connection_window = connection->thread_data.read_buffer.capacity;
+        if (http1_options->memory_budget) {
+            /* Window opens once the handler is installed, as far as the budget allows */
+            connection->base.memory_budget = aws_http_memory_budget_acquire(http1_options->memory_budget);
+            connection->thread_data.connection_window = 0;
+        } else {
+            connection->thread_data.connection_window = connection->thread_data.read_buffer.capacity;
+        }
     } else {
         /* No backpressure, keep connection window at SIZE_MAX */
         connection->initial_stream_window_size = SIZE_MAX;
@@ -1504,6 +1788,9 @@ static struct aws_h1_connection *s_connection_new(
         connection->thread_data.connection_window = SIZE_MAX;
     }
 
+    connection->base.send_rate_limiter = aws_http_rate_limiter_acquire(http1_options->send_rate_limiter);
+    connection->base.receive_rate_limiter = aws_http_rate_limiter_acquire(http1_options->receive_rate_limiter);
+
     aws_h1_encoder_init(&connection->thread_data.encoder, alloc);
 
     aws_channel_task_init(
@@ -1513,6 +1800,19 @@ static struct aws_h1_connection *s_connection_new(
         s_cross_thread_work_task,
         connection,
         "http1_connection_cross_thread_work");
+    aws_channel_task_init(&connection->idle_trim_task, s_idle_trim_task, connection, "http1_connection_idle_trim");
+    aws_channel_task_init(
+        &connection->memory_budget_retry_task,
+        s_memory_budget_retry_task,
+        connection,
+        "http1_connection_memory_budget_retry");
+    aws_channel_task_init(
+        &connection->receive_rate_limit_task,
+        s_receive_rate_limit_task,
+        connection,
+        "http1_connection_receive_rate_limit");
+    connection->idle_trim_ns =
+        aws_timestamp_convert(http1_options->idle_trim_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
     aws_linked_list_init(&connection->thread_data.stream_list);
     aws_linked_list_init(&connection->thread_data.read_buffer.messages);
     aws_crt_statistics_http1_channel_init(&connection->thread_data.stats);
@@ -1528,12 +1828,17 @@ static struct aws_h1_connection *s_connection_new(
         goto error_mutex;
     }
 
+    /* No memory is acquired until a stream with a vectored body callback receives data */
+    aws_array_list_init_dynamic(
+        &connection->thread_data.incoming_body_slices, alloc, 0, sizeof(struct aws_byte_cursor));
+
     aws_linked_list_init(&connection->synced_data.new_client_stream_list);
     connection->synced_data.is_open = true;
 
     struct aws_h1_decoder_params options = {
         .alloc = alloc,
         .is_decoding_requests = server,
+        .max_header_list_size = http1_options->max_header_list_size,
         .user_data = connection,
         .vtable = s_h1_decoder_vtable,
         .scratch_space_initial_size = DECODER_INITIAL_SCRATCH_SIZE,
@@ -1552,8 +1857,12 @@ static struct aws_h1_connection *s_connection_new(
     return connection;
 
 error_decoder:
+    aws_array_list_clean_up(&connection->thread_data.incoming_body_slices);
     aws_mutex_clean_up(&connection->synced_data.lock);
 error_mutex:
+    aws_http_memory_budget_release(connection->base.memory_budget);
+    aws_http_rate_limiter_release(connection->base.send_rate_limiter);
+    aws_http_rate_limiter_release(connection->base.receive_rate_limiter);
     aws_mem_release(alloc, connection);
 error_connection_alloc:
     return NULL;
@@ -1609,8 +1918,16 @@ static void s_handler_destroy(struct aws_channel_handler *handler) {
     }
 
     aws_h1_decoder_destroy(connection->thread_data.incoming_stream_decoder);
+    aws_array_list_clean_up(&connection->thread_data.incoming_body_slices);
     aws_h1_encoder_clean_up(&connection->thread_data.encoder);
     aws_mutex_clean_up(&connection->synced_data.lock);
+    if (connection->base.memory_budget) {
+        aws_http_memory_budget_unreserve(
+            connection->base.memory_budget, connection->thread_data.read_buffer.pending_bytes);
+        aws_http_memory_budget_release(connection->base.memory_budget);
+    }
+    aws_http_rate_limiter_release(connection->base.send_rate_limiter);
+    aws_http_rate_limiter_release(connection->base.receive_rate_limiter);
     aws_mem_release(connection->base.alloc, connection);
 }
 
@@ -1621,6 +1938,122 @@ static void s_handler_installed(struct aws_channel_handler *handler, struct aws_
     /* Acquire a hold on the channel to prevent its destruction until the user has
      * given the go-ahead via aws_http_connection_release() */
     aws_channel_acquire_hold(slot->channel);
+
+    if (connection->idle_trim_ns) {
+        s_schedule_idle_trim_task(connection);
+    }
+
+    /* With a memory budget, the window starts closed and opens as far as the budget allows */
+    if (connection->base.memory_budget && s_update_connection_window(connection)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Failed to open initial read window, error %d (%s). Closing connection.",
+            (void *)&connection->base,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        s_shutdown_due_to_error(connection, aws_last_error());
+    }
+}
+
+/**
+ * When the downstream window can't fit a whole switched-protocol message, the connection forwards slices
+ * of it instead of copying its data into new messages. A slice is an aws_io_message that points into the
+ * original message's data. aws_io_message has no refcount, and handlers release messages through
+ * message->allocator, so each slice carries its own allocator whose release drops a reference on the
+ * original message. The original is released once the last slice referencing it is released.
+ */
+struct aws_h1_shared_read_message {
+    struct aws_allocator *alloc;
+    struct aws_io_message *original;
+    struct aws_ref_count ref_count;
+};
+
+struct aws_h1_read_message_slice {
+    struct aws_io_message message;
+
+    /* message.allocator points here, so aws_mem_release(message.allocator, message) releases the slice */
+    struct aws_allocator slice_allocator;
+
+    struct aws_h1_shared_read_message *shared;
+};
+
+static void s_shared_read_message_destroy(void *user_data) {
+    struct aws_h1_shared_read_message *shared = user_data;
+    aws_mem_release(shared->original->allocator, shared->original);
+    aws_mem_release(shared->alloc, shared);
+}
+
+static void *s_read_message_slice_mem_acquire(struct aws_allocator *allocator, size_t size) {
+    (void)allocator;
+    (void)size;
+    /* A slice's allocator only exists so the slice can be released */
+    aws_raise_error(AWS_ERROR_INVALID_STATE);
+    return NULL;
+}
+
+static void s_read_message_slice_mem_release(struct aws_allocator *allocator, void *ptr) {
+    struct aws_h1_read_message_slice *slice = allocator->impl;
+    AWS_ASSERT(ptr == &slice->message);
+    (void)ptr;
+
+    struct aws_h1_shared_read_message *shared = slice->shared;
+    aws_mem_release(shared->alloc, slice);
+    aws_ref_count_release(&shared->ref_count);
+}
+
+static bool s_is_read_message_slice(const struct aws_io_message *message) {
+    return message->allocator->mem_release == s_read_message_slice_mem_release;
+}
+
+const struct aws_io_message *aws_h1_read_message_slice_get_original(const struct aws_io_message *message) {
+    if (!s_is_read_message_slice(message)) {
+        return NULL;
+    }
+
+    const struct aws_h1_read_message_slice *slice = message->allocator->impl;
+    return slice->shared->original;
+}
+
+/* Create a message referencing `data`, which must lie within the shared message's original data. */
+static struct aws_io_message *s_read_message_slice_new(
+    struct aws_h1_shared_read_message *shared,
+    struct aws_byte_cursor data) {
+
+    struct aws_h1_read_message_slice *slice =
+        aws_mem_calloc(shared->alloc, 1, sizeof(struct aws_h1_read_message_slice));
+    slice->slice_allocator.mem_acquire = s_read_message_slice_mem_acquire;
+    slice->slice_allocator.mem_release = s_read_message_slice_mem_release;
+    slice->slice_allocator.impl = slice;
+    slice->shared = shared;
+    aws_ref_count_acquire(&shared->ref_count);
+
+    slice->message.allocator = &slice->slice_allocator;
+    slice->message.message_type = AWS_IO_MESSAGE_APPLICATION_DATA;
+    slice->message.message_data = aws_byte_buf_from_array(data.ptr, data.len);
+    return &slice->message;
+}
+
+/* Replace a queued message with a slice covering all of its data, so further slices can share it */
+static struct aws_io_message *s_convert_queued_message_to_slice(
+    struct aws_h1_connection *connection,
+    struct aws_io_message *queued_msg) {
+
+    struct aws_h1_shared_read_message *shared =
+        aws_mem_calloc(connection->base.alloc, 1, sizeof(struct aws_h1_shared_read_message));
+    shared->alloc = connection->base.alloc;
+    shared->original = queued_msg;
+    aws_ref_count_init(&shared->ref_count, shared, s_shared_read_message_destroy);
+
+    struct aws_io_message *whole =
+        s_read_message_slice_new(shared, aws_byte_cursor_from_buf(&queued_msg->message_data));
+    whole->copy_mark = queued_msg->copy_mark;
+
+    /* The whole-message slice now holds the only reference */
+    aws_ref_count_release(&shared->ref_count);
+
+    aws_linked_list_insert_after(&queued_msg->queueing_handle, &whole->queueing_handle);
+    aws_linked_list_remove(&queued_msg->queueing_handle);
+    return whole;
 }
 
 /* Try to send the next queued aws_io_message to the downstream handler.
@@ -1663,17 +2096,24 @@ static int s_try_process_next_midchannel_read_message(struct aws_h1_connection *
 
     AWS_ASSERT(connection->thread_data.read_buffer.pending_bytes >= sending_bytes);
     connection->thread_data.read_buffer.pending_bytes -= sending_bytes;
+    if (connection->base.memory_budget) {
+        aws_http_memory_budget_unreserve(connection->base.memory_budget, sending_bytes);
+    }
 
-    /* If we can't send the whole entire queued_msg, copy its data into a new aws_io_message and send that. */
+    /* If we can't send the whole entire queued_msg, send a slice of it (no copying). */
     if (sending_bytes != queued_msg->message_data.len) {
-        sending_msg = aws_channel_acquire_message_from_pool(
-            connection->base.channel_slot->channel, AWS_IO_MESSAGE_APPLICATION_DATA, sending_bytes);
-        if (!sending_msg) {
-            goto error;
+        if (!s_is_read_message_slice(queued_msg)) {
+            queued_msg = s_convert_queued_message_to_slice(connection, queued_msg);
+            queued_msg_node = &queued_msg->queueing_handle;
         }
 
-        aws_byte_buf_write(
-            &sending_msg->message_data, queued_msg->message_data.buffer + queued_msg->copy_mark, sending_bytes);
+        struct aws_byte_cursor sending_data = aws_byte_cursor_from_buf(&queued_msg->message_data);
+        aws_byte_cursor_advance(&sending_data, queued_msg->copy_mark);
+        sending_data.len = sending_bytes;
+
+        struct aws_h1_read_message_slice *queued_slice =
+            AWS_CONTAINER_OF(queued_msg, struct aws_h1_read_message_slice, message);
+        sending_msg = s_read_message_slice_new(queued_slice->shared, sending_data);
 
         queued_msg->copy_mark += sending_bytes;
 
@@ -1684,7 +2124,8 @@ static int s_try_process_next_midchannel_read_message(struct aws_h1_connection *
             sending_bytes,
             queued_msg->message_data.len - queued_msg->copy_mark);
 
-        /* If the last of queued_msg has been copied, it can be deleted now. */
+        /* If the last of queued_msg has been sent, it can be released now.
+         * Its data lives on until the downstream handler releases the slices referencing it. */
         if (queued_msg->copy_mark == queued_msg->message_data.len) {
             aws_linked_list_remove(queued_msg_node);
             aws_mem_release(queued_msg->allocator, queued_msg);
@@ -1816,10 +2257,15 @@ static int s_handler_process_read_message(
         return aws_raise_error(AWS_ERROR_INVALID_STATE);
     }
     connection->thread_data.connection_window -= message_size;
+    connection->thread_data.activity_count++;
 
     /* Push message into queue of buffered messages */
     aws_linked_list_push_back(&connection->thread_data.read_buffer.messages, &message->queueing_handle);
     connection->thread_data.read_buffer.pending_bytes += message_size;
+    if (connection->base.memory_budget) {
+        /* The data is already here and can't be refused, the window is how the budget holds it back */
+        aws_http_memory_budget_reserve_forced(connection->base.memory_budget, message_size);
+    }
 
     /* Try to process messages in queue */
     aws_h1_connection_try_process_read_messages(connection);
@@ -1903,7 +2349,18 @@ static int s_try_process_next_stream_read_message(struct aws_h1_connection *conn
 
         } else {
             /* Server side.
-             * Invoke on-incoming-request callback. The user MUST create a new stream from this callback.
+             * Shed load rather than taking on another request to buffer. HTTP/1 can't refuse a single request,
+             * so close the connection before the user ever sees it. Nothing was processed, so the client may retry. */
+            if (connection->base.memory_budget && aws_http_memory_budget_is_exhausted(connection->base.memory_budget)) {
+                AWS_LOGF_DEBUG(
+                    AWS_LS_HTTP_CONNECTION,
+                    "id=%p: Refusing incoming request, memory budget is exhausted. Closing connection.",
+                    (void *)&connection->base);
+
+                return aws_raise_error(AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED);
+            }
+
+            /* Invoke on-incoming-request callback. The user MUST create a new stream from this callback.
              * The new stream becomes the current incoming stream */
             s_set_incoming_stream_ptr(connection, s_server_invoke_on_incoming_request(connection));
             if (!connection->thread_data.incoming_stream) {
@@ -1973,7 +2430,8 @@ static int s_try_process_next_stream_read_message(struct aws_h1_connection *conn
 
     /* As decoder runs, it invokes the internal s_decoder_X callbacks, which in turn invoke user callbacks.
      * The decoder will stop once it hits the end of the request/response OR the end of the message data. */
-    if (aws_h1_decode(connection->thread_data.incoming_stream_decoder, &message_cursor)) {
+    if (aws_h1_decode(connection->thread_data.incoming_stream_decoder, &message_cursor) ||
+        s_flush_incoming_body_slices(connection)) {
         AWS_LOGF_ERROR(
             AWS_LS_HTTP_CONNECTION,
             "id=%p: Message processing failed, error %d (%s). Closing connection.",
@@ -1981,6 +2439,7 @@ static int s_try_process_next_stream_read_message(struct aws_h1_connection *conn
             aws_last_error(),
             aws_error_name(aws_last_error()));
 
+        aws_array_list_clear(&connection->thread_data.incoming_body_slices);
         return AWS_OP_ERR;
     }
 
@@ -1989,6 +2448,9 @@ static int s_try_process_next_stream_read_message(struct aws_h1_connection *conn
 
     AWS_ASSERT(connection->thread_data.read_buffer.pending_bytes >= bytes_processed);
     connection->thread_data.read_buffer.pending_bytes -= bytes_processed;
+    if (connection->base.memory_budget) {
+        aws_http_memory_budget_unreserve(connection->base.memory_budget, bytes_processed);
+    }
 
     AWS_LOGF_TRACE(
         AWS_LS_HTTP_CONNECTION,
@@ -2025,6 +2487,7 @@ static int s_handler_process_write_message(
     }
 
     /* Pass the message right along. */
+    connection->thread_data.activity_count++;
     int err = aws_channel_slot_send_message(slot, message, AWS_CHANNEL_DIR_WRITE);
     if (err) {
         goto error;
@@ -2181,6 +2644,8 @@ static void s_gather_statistics(struct aws_channel_handler *handler, struct aws_
      * If the user lets the stream-window go to zero, there can naturally be a gap in the download. */
     s_pull_up_stats_timestamps(connection);
 
+    connection->thread_data.stats.resident_bytes = s_get_resident_bytes(connection);
+
     void *stats_base = &connection->thread_data.stats;
     aws_array_list_push_back(stats, &stats_base);
 }
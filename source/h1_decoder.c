@@ -35,6 +35,8 @@ struct aws_h1_decoder {
     uint64_t content_length;
     uint64_t chunk_processed;
     uint64_t chunk_size;
+    /* Size of the current header-block so far, counted like SETTINGS_MAX_HEADER_LIST_SIZE in HTTP/2 */
+    uint64_t header_list_size;
     bool doing_trailers;
     bool is_done;
     bool body_headers_ignored;
@@ -45,6 +47,7 @@ struct aws_h1_decoder {
     /* User callbacks and settings. */
     struct aws_h1_decoder_vtable vtable;
     bool is_decoding_requests;
+    size_t max_header_list_size;
     void *user_data;
 };
 
@@ -53,6 +56,26 @@ static int s_linestate_response(struct aws_h1_decoder *decoder, struct aws_byte_
 static int s_linestate_header(struct aws_h1_decoder *decoder, struct aws_byte_cursor input);
 static int s_linestate_chunk_size(struct aws_h1_decoder *decoder, struct aws_byte_cursor input);
 
+/* Each header field counts its length, plus the same 32 bytes of overhead that HTTP/2 uses (RFC-9113 6.5.2) */
+#define HEADER_FIELD_OVERHEAD 32
+
+static int s_check_header_list_size(struct aws_h1_decoder *decoder, size_t field_length) {
+    if (decoder->max_header_list_size == 0) {
+        return AWS_OP_SUCCESS;
+    }
+
+    if (decoder->header_list_size + field_length + HEADER_FIELD_OVERHEAD > decoder->max_header_list_size) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_STREAM,
+            "id=%p: Incoming header-block exceeds the max header list size %zu.",
+            decoder->logging_id,
+            decoder->max_header_list_size);
+        return aws_raise_error(AWS_ERROR_HTTP_HEADERS_TOO_LARGE);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 static bool s_scan_for_crlf(struct aws_h1_decoder *decoder, struct aws_byte_cursor input, size_t *bytes_processed) {
     AWS_ASSERT(input.len > 0);
 
@@ -115,6 +138,15 @@ static int s_state_getline(struct aws_h1_decoder *decoder, struct aws_byte_curso
         }
         /* Line is actually the entire scratch buffer now */
         line = aws_byte_cursor_from_buf(&decoder->scratch_space);
+
+        /* Don't keep buffering a header line that can't fit, reject it as soon as it's too big.
+         * A trailing "\r" might be part of the CRLF, so it's not counted yet. */
+        if (!found_crlf && decoder->process_line == s_linestate_header) {
+            size_t partial_length = line.len - (line.ptr[line.len - 1] == '\r' ? 1 : 0);
+            if (s_check_header_list_size(decoder, partial_length)) {
+                return AWS_OP_ERR;
+            }
+        }
     }
 
     if (AWS_LIKELY(found_crlf)) {
@@ -197,19 +229,46 @@ static int s_mark_done(struct aws_h1_decoder *decoder) {
     return decoder->vtable.on_done(decoder->user_data);
 }
 
+/* First state of every message.
+ * Complete lines of the head are processed straight out of the input, in one pass that scans each byte once,
+ * without bouncing through s_state_getline and the run_state dispatch once per line.
+ * At the first line that's split across reads, s_state_getline takes over and buffers it. */
+static int s_state_head(struct aws_h1_decoder *decoder, struct aws_byte_cursor *input) {
+    linestate_fn *start_line_fn = decoder->is_decoding_requests ? s_linestate_request : s_linestate_response;
+    s_set_line_state(decoder, start_line_fn);
+
+    /* Each linestate_fn sets the next one, until the empty line moves us on to the body (or marks us done) */
+    while (input->len > 0 && !decoder->is_done && decoder->run_state == s_state_getline &&
+           (decoder->process_line == start_line_fn || decoder->process_line == s_linestate_header)) {
+
+        /* The scratch_space is empty, so lines split exactly as they would in s_state_getline */
+        AWS_ASSERT(decoder->scratch_space.len == 0);
+        size_t line_length = 0;
+        if (!s_scan_for_crlf(decoder, *input, &line_length)) {
+            return AWS_OP_SUCCESS;
+        }
+
+        struct aws_byte_cursor line = aws_byte_cursor_advance(input, line_length);
+        line.len -= 2;
+
+        if (decoder->process_line(decoder, line)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 /* Reset state, in preparation for processing a new message */
 static void s_reset_state(struct aws_h1_decoder *decoder) {
-    if (decoder->is_decoding_requests) {
-        s_set_line_state(decoder, s_linestate_request);
-    } else {
-        s_set_line_state(decoder, s_linestate_response);
-    }
+    s_set_state(decoder, s_state_head);
 
     decoder->transfer_encoding = 0;
     decoder->content_processed = 0;
     decoder->content_length = 0;
     decoder->chunk_processed = 0;
     decoder->chunk_size = 0;
+    decoder->header_list_size = 0;
     decoder->doing_trailers = false;
     decoder->is_done = false;
     decoder->body_headers_ignored = false;
@@ -329,6 +388,7 @@ static int s_linestate_chunk_size(struct aws_h1_decoder *decoder, struct aws_byt
 
         /* Expected empty newline and end of message. */
         decoder->doing_trailers = true;
+        decoder->header_list_size = 0;
         s_set_line_state(decoder, s_linestate_header);
         return AWS_OP_SUCCESS;
     }
@@ -403,6 +463,11 @@ static int s_linestate_header(struct aws_h1_decoder *decoder, struct aws_byte_cu
         return aws_raise_error(AWS_ERROR_HTTP_PROTOCOL_ERROR);
     }
 
+    if (s_check_header_list_size(decoder, input.len)) {
+        return AWS_OP_ERR;
+    }
+    decoder->header_list_size += input.len + HEADER_FIELD_OVERHEAD;
+
     struct aws_h1_decoded_header header;
     header.name = aws_http_str_to_header_name(name);
     header.name_data = name;
@@ -698,6 +763,7 @@ struct aws_h1_decoder *aws_h1_decoder_new(struct aws_h1_decoder_params *params)
     decoder->user_data = params->user_data;
     decoder->vtable = params->vtable;
     decoder->is_decoding_requests = params->is_decoding_requests;
+    decoder->max_header_list_size = params->max_header_list_size;
 
     aws_byte_buf_init(&decoder->scratch_space, params->alloc, params->scratch_space_initial_size);
 
@@ -736,6 +802,18 @@ int aws_h1_decode(struct aws_h1_decoder *decoder, struct aws_byte_cursor *data)
     return AWS_OP_SUCCESS;
 }
 
+void aws_h1_decoder_trim(struct aws_h1_decoder *decoder) {
+    /* The scratch_space only holds data while a line is split across reads */
+    if (decoder->scratch_space.len == 0 && decoder->scratch_space.capacity > 0) {
+        aws_byte_buf_clean_up(&decoder->scratch_space);
+        aws_byte_buf_init(&decoder->scratch_space, decoder->alloc, 0);
+    }
+}
+
+size_t aws_h1_decoder_get_resident_bytes(const struct aws_h1_decoder *decoder) {
+    return sizeof(struct aws_h1_decoder) + decoder->scratch_space.capacity;
+}
+
 int aws_h1_decoder_get_encoding_flags(const struct aws_h1_decoder *decoder) {
     return decoder->transfer_encoding;
 }
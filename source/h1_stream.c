@@ -7,6 +7,7 @@
 #include <aws/http/private/h1_connection.h>
 #include <aws/http/private/h1_encoder.h>
 
+#include <aws/http/rate_limiter.h>
 #include <aws/http/status_code.h>
 #include <aws/io/logging.h>
 #include <aws/io/stream.h>
@@ -25,6 +26,8 @@ static void s_stream_destroy(struct aws_http_stream *stream_base) {
 
     aws_h1_encoder_message_clean_up(&stream->encoder_message);
     aws_byte_buf_clean_up(&stream->incoming_storage_buf);
+    aws_http_rate_limiter_release(stream->base.send_rate_limiter);
+    aws_http_rate_limiter_release(stream->base.receive_rate_limiter);
     aws_mem_release(stream->base.alloc, stream);
 }
 
@@ -66,6 +69,9 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
 
     bool has_outgoing_response = stream->synced_data.has_outgoing_response;
 
+    bool has_body_ready_notification = stream->synced_data.has_body_ready_notification;
+    stream->synced_data.has_body_ready_notification = false;
+
     uint64_t pending_window_update = stream->synced_data.pending_window_update;
     stream->synced_data.pending_window_update = 0;
 
@@ -73,7 +79,7 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
     /* END CRITICAL SECTION */
 
     /* If we have any new outgoing data, prompt the connection to try and send it. */
-    bool new_outgoing_data = found_chunks;
+    bool new_outgoing_data = found_chunks || has_body_ready_notification;
 
     /* If we JUST learned about having an outgoing response, that's a reason to try sending data */
     if (has_outgoing_response && !stream->thread_data.has_outgoing_response) {
@@ -140,6 +146,44 @@ static void s_stream_update_window(struct aws_http_stream *stream_base, size_t i
     }
 }
 
+static int s_stream_notify_body_ready(struct aws_http_stream *stream_base) {
+    struct aws_h1_stream *stream = AWS_CONTAINER_OF(stream_base, struct aws_h1_stream, base);
+
+    if (!stream->use_body_ready_notifications) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_STREAM,
+            "id=%p: Body ready notifications are not enabled. Set 'use_body_ready_notifications' to true in "
+            "'aws_http_make_request_options'",
+            (void *)stream_base);
+        return aws_raise_error(AWS_ERROR_INVALID_STATE);
+    }
+
+    bool should_schedule_task = false;
+
+    { /* BEGIN CRITICAL SECTION */
+        s_stream_lock_synced_data(stream);
+
+        /* Don't alert the connection unless the stream is active */
+        if (stream->synced_data.api_state == AWS_H1_STREAM_API_STATE_ACTIVE) {
+            stream->synced_data.has_body_ready_notification = true;
+            should_schedule_task = !stream->synced_data.is_cross_thread_work_task_scheduled;
+            stream->synced_data.is_cross_thread_work_task_scheduled = true;
+        }
+
+        s_stream_unlock_synced_data(stream);
+    } /* END CRITICAL SECTION */
+
+    if (should_schedule_task) {
+        /* Keep stream alive until task completes */
+        aws_atomic_fetch_add(&stream->base.refcount, 1);
+        AWS_LOGF_TRACE(AWS_LS_HTTP_STREAM, "id=%p: Scheduling stream cross-thread work task.", (void *)stream_base);
+        aws_channel_schedule_task_now(
+            stream->base.owning_connection->channel_slot->channel, &stream->cross_thread_work_task);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 static int s_stream_write_chunk(struct aws_http_stream *stream_base, const struct aws_http1_chunk_options *options) {
     AWS_PRECONDITION(stream_base);
     AWS_PRECONDITION(options);
@@ -330,6 +374,7 @@ static const struct aws_http_stream_vtable s_stream_vtable = {
     .update_window = s_stream_update_window,
     .activate = aws_h1_stream_activate,
     .cancel = aws_h1_stream_cancel,
+    .notify_body_ready = s_stream_notify_body_ready,
     .http1_write_chunk = s_stream_write_chunk,
     .http1_add_trailer = s_stream_add_trailer,
     .http2_reset_stream = NULL,
@@ -410,6 +455,8 @@ struct aws_h1_stream *aws_h1_stream_new_request(
     stream->base.client_data->response_status = AWS_HTTP_STATUS_CODE_UNKNOWN;
     stream->base.client_data->response_first_byte_timeout_ms = options->response_first_byte_timeout_ms;
     stream->base.on_metrics = options->on_metrics;
+    stream->use_body_ready_notifications = options->use_body_ready_notifications;
+    stream->base.on_incoming_body_vectored = options->on_response_body_vectored;
 
     /* Validate request and cache info that the encoder will eventually need */
     if (aws_h1_encoder_message_init_from_request(
@@ -428,6 +475,9 @@ struct aws_h1_stream *aws_h1_stream_new_request(
 
     stream->synced_data.using_chunked_encoding = stream->encoder_message.has_chunked_encoding_header;
 
+    stream->base.send_rate_limiter = aws_http_rate_limiter_acquire(options->send_rate_limiter);
+    stream->base.receive_rate_limiter = aws_http_rate_limiter_acquire(options->receive_rate_limiter);
+
     return stream;
 
 error:
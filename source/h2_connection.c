@@ -8,10 +8,13 @@
 
 #include <aws/http/private/h2_decoder.h>
 #include <aws/http/private/h2_stream.h>
+#include <aws/http/private/memory_budget_impl.h>
+#include <aws/http/private/rate_limiter_impl.h>
 #include <aws/http/private/strutil.h>
 
 #include <aws/common/clock.h>
 #include <aws/common/logging.h>
+#include <aws/io/event_loop.h>
 
 #ifdef _MSC_VER
 #    pragma warning(disable : 4204) /* non-constant aggregate initializer */
@@ -91,6 +94,9 @@ static void s_connection_get_remote_settings(
 
 static void s_cross_thread_work_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
 static void s_outgoing_frames_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
+static void s_idle_trim_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
+static void s_memory_budget_retry_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
+static void s_rate_limit_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
 static int s_encode_outgoing_frames_queue(struct aws_h2_connection *connection, struct aws_byte_buf *output);
 static int s_encode_data_from_outgoing_streams(struct aws_h2_connection *connection, struct aws_byte_buf *output);
 static int s_record_closed_stream(
@@ -98,6 +104,7 @@ static int s_record_closed_stream(
     uint32_t stream_id,
     enum aws_h2_stream_closed_when closed_when);
 static void s_stream_complete(struct aws_h2_connection *connection, struct aws_h2_stream *stream, int error_code);
+static struct aws_h2err s_flush_pending_body_for_stream_id(struct aws_h2_connection *connection, uint32_t stream_id);
 static void s_write_outgoing_frames(struct aws_h2_connection *connection, bool first_try);
 static void s_finish_shutdown(struct aws_h2_connection *connection);
 static void s_send_goaway(
@@ -134,6 +141,7 @@ static struct aws_h2err s_decoder_on_data_begin(
 static struct aws_h2err s_decoder_on_data_i(uint32_t stream_id, struct aws_byte_cursor data, void *userdata);
 static struct aws_h2err s_decoder_on_end_stream(uint32_t stream_id, void *userdata);
 static struct aws_h2err s_decoder_on_rst_stream(uint32_t stream_id, uint32_t h2_error_code, void *userdata);
+static struct aws_h2err s_decoder_on_continuation(uint32_t stream_id, void *userdata);
 static struct aws_h2err s_decoder_on_ping_ack(uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE], void *userdata);
 static struct aws_h2err s_decoder_on_ping(uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE], void *userdata);
 static struct aws_h2err s_decoder_on_settings(
@@ -187,6 +195,7 @@ static const struct aws_h2_decoder_vtable s_h2_decoder_vtable = {
     .on_headers_i = s_decoder_on_headers_i,
     .on_headers_end = s_decoder_on_headers_end,
     .on_push_promise_begin = s_decoder_on_push_promise,
+    .on_continuation = s_decoder_on_continuation,
     .on_data_begin = s_decoder_on_data_begin,
     .on_data_i = s_decoder_on_data_i,
     .on_end_stream = s_decoder_on_end_stream,
@@ -323,12 +332,35 @@ static struct aws_h2_connection *s_connection_new(
     connection->on_goaway_received = http2_options->on_goaway_received;
     connection->on_remote_settings_change = http2_options->on_remote_settings_change;
 
+    /* Abuse limits */
+    const struct aws_http2_abuse_limits default_abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    if (http2_options->abuse_limits) {
+        connection->abuse_limits = *http2_options->abuse_limits;
+    } else {
+        connection->abuse_limits = default_abuse_limits;
+        if (!server) {
+            /* Rapid reset is an attack on servers. A server resetting a client's streams is normal
+             * (ex: refusing streams while overloaded), so clients only count RST_STREAM if asked to */
+            connection->abuse_limits.max_rst_stream_frames = 0;
+        }
+    }
+    if (connection->abuse_limits.window_ms == 0) {
+        connection->abuse_limits.window_ms = default_abuse_limits.window_ms;
+    }
+
     aws_channel_task_init(
         &connection->cross_thread_work_task, s_cross_thread_work_task, connection, "HTTP/2 cross-thread work");
 
     aws_channel_task_init(
         &connection->outgoing_frames_task, s_outgoing_frames_task, connection, "HTTP/2 outgoing frames");
 
+    aws_channel_task_init(&connection->idle_trim_task, s_idle_trim_task, connection, "HTTP/2 idle trim");
+    aws_channel_task_init(
+        &connection->memory_budget_retry_task, s_memory_budget_retry_task, connection, "HTTP/2 memory budget retry");
+    aws_channel_task_init(&connection->rate_limit_task, s_rate_limit_task, connection, "HTTP/2 rate limit");
+    connection->idle_trim_ns =
+        aws_timestamp_convert(http2_options->idle_trim_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+
     /* 1 refcount for user */
     aws_atomic_init_int(&connection->base.refcount, 1);
     uint32_t max_stream_id = AWS_H2_STREAM_ID_MAX;
@@ -346,7 +378,10 @@ static struct aws_h2_connection *s_connection_new(
     aws_linked_list_init(&connection->thread_data.pending_ping_queue);
     aws_linked_list_init(&connection->thread_data.stalled_window_streams_list);
     aws_linked_list_init(&connection->thread_data.waiting_streams_list);
+    aws_linked_list_init(&connection->thread_data.rate_limited_streams_list);
+    aws_linked_list_init(&connection->thread_data.rate_limited_window_streams_list);
     aws_linked_list_init(&connection->thread_data.outgoing_frames_queue);
+    aws_linked_list_init(&connection->thread_data.pending_body_streams_list);
 
     if (aws_mutex_init(&connection->synced_data.lock)) {
         CONNECTION_LOGF(
@@ -384,6 +419,18 @@ static struct aws_h2_connection *s_connection_new(
     connection->thread_data.window_size_peer = AWS_H2_INIT_WINDOW_SIZE;
     connection->thread_data.window_size_self = AWS_H2_INIT_WINDOW_SIZE;
 
+    /* With a memory budget, the connection window starts at its initial size, and is only replenished as far as the
+     * budget has room. The budget is charged for retained messages, see aws_h2_connection_retain_incoming_body() */
+    if (http2_options->memory_budget && !connection->conn_manual_window_management) {
+        connection->base.memory_budget = aws_http_memory_budget_acquire(http2_options->memory_budget);
+    }
+
+    /* Likewise, a receive rate limiter paces the connection window, so the window must be automatic */
+    connection->base.send_rate_limiter = aws_http_rate_limiter_acquire(http2_options->send_rate_limiter);
+    if (!connection->conn_manual_window_management) {
+        connection->base.receive_rate_limiter = aws_http_rate_limiter_acquire(http2_options->receive_rate_limiter);
+    }
+
     connection->thread_data.goaway_received_last_stream_id = AWS_H2_STREAM_ID_MAX;
     connection->thread_data.goaway_sent_last_stream_id = AWS_H2_STREAM_ID_MAX;
 
@@ -474,6 +521,8 @@ static void s_handler_destroy(struct aws_channel_handler *handler) {
     AWS_ASSERT(aws_linked_list_empty(&connection->thread_data.waiting_streams_list));
     AWS_ASSERT(aws_linked_list_empty(&connection->thread_data.stalled_window_streams_list));
     AWS_ASSERT(aws_linked_list_empty(&connection->thread_data.outgoing_streams_list));
+    AWS_ASSERT(aws_linked_list_empty(&connection->thread_data.rate_limited_streams_list));
+    AWS_ASSERT(aws_linked_list_empty(&connection->thread_data.rate_limited_window_streams_list));
     AWS_ASSERT(aws_linked_list_empty(&connection->synced_data.pending_stream_list));
     AWS_ASSERT(aws_linked_list_empty(&connection->synced_data.pending_frame_list));
     AWS_ASSERT(aws_linked_list_empty(&connection->synced_data.pending_settings_list));
@@ -498,6 +547,9 @@ static void s_handler_destroy(struct aws_channel_handler *handler) {
     aws_hash_table_clean_up(&connection->thread_data.active_streams_map);
     aws_cache_destroy(connection->thread_data.closed_streams);
     aws_mutex_clean_up(&connection->synced_data.lock);
+    aws_http_memory_budget_release(connection->base.memory_budget);
+    aws_http_rate_limiter_release(connection->base.send_rate_limiter);
+    aws_http_rate_limiter_release(connection->base.receive_rate_limiter);
     aws_mem_release(connection->base.alloc, connection);
 }
 
@@ -646,6 +698,55 @@ static void s_outgoing_frames_task(struct aws_channel_task *task, void *arg, enu
     s_write_outgoing_frames(connection, false /*first_try*/);
 }
 
+static size_t s_get_resident_bytes(const struct aws_h2_connection *connection) {
+    return sizeof(struct aws_h2_connection) + aws_h2_decoder_get_resident_bytes(connection->thread_data.decoder) +
+           aws_h2_frame_encoder_get_resident_bytes(&connection->thread_data.encoder);
+}
+
+static void s_schedule_idle_trim_task(struct aws_h2_connection *connection) {
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    aws_channel_schedule_task_future(
+        connection->base.channel_slot->channel, &connection->idle_trim_task, now_ns + connection->idle_trim_ns);
+}
+
+/* Runs every idle_trim_ns. If nothing was read or written since the last run, release the memory that
+ * only grows with traffic. The decoder and encoder re-grow it on demand once traffic resumes. */
+static void s_idle_trim_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    struct aws_h2_connection *connection = arg;
+    if (connection->thread_data.is_reading_stopped || connection->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    if (connection->thread_data.activity_count != connection->thread_data.activity_count_at_last_idle_check) {
+        connection->thread_data.activity_count_at_last_idle_check = connection->thread_data.activity_count;
+        connection->thread_data.is_idle_trimmed = false;
+
+    } else if (!connection->thread_data.is_idle_trimmed) {
+        size_t prev_resident_bytes = s_get_resident_bytes(connection);
+
+        /* Trimming is best-effort, on failure the buffers are simply left as they were */
+        aws_h2_decoder_trim(connection->thread_data.decoder);
+        aws_h2_frame_encoder_trim(&connection->thread_data.encoder);
+        connection->thread_data.is_idle_trimmed = true;
+
+        CONNECTION_LOGF(
+            DEBUG,
+            connection,
+            "Connection is idle, trimmed resident memory from %zu to %zu bytes",
+            prev_resident_bytes,
+            s_get_resident_bytes(connection));
+    }
+
+    s_schedule_idle_trim_task(connection);
+}
+
 static void s_write_outgoing_frames(struct aws_h2_connection *connection, bool first_try) {
     AWS_PRECONDITION(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
     AWS_PRECONDITION(connection->thread_data.is_outgoing_frames_task_active);
@@ -724,6 +825,7 @@ static void s_write_outgoing_frames(struct aws_h2_connection *connection, bool f
         /* Write message to channel.
          * outgoing_frames_task will resume when message completes. */
         CONNECTION_LOGF(TRACE, connection, "Outgoing frames task sending message of size %zu", msg->message_data.len);
+        connection->thread_data.activity_count++;
 
         if (aws_channel_slot_send_message(channel_slot, msg, AWS_CHANNEL_DIR_WRITE)) {
             CONNECTION_LOGF(
@@ -806,6 +908,30 @@ static int s_encode_outgoing_frames_queue(struct aws_h2_connection *connection,
     return AWS_OP_SUCCESS;
 }
 
+/* Schedule the rate_limit_task to run after `wait_ns`, unless it's already scheduled.
+ * The wait is capped, so a task scheduled for one stream never makes another wait long. */
+static void s_schedule_rate_limit_task(struct aws_h2_connection *connection, uint64_t wait_ns) {
+    if (connection->thread_data.is_rate_limit_task_scheduled) {
+        return;
+    }
+
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    wait_ns = aws_min_u64(wait_ns, AWS_H2_RATE_LIMIT_MAX_WAIT_NS);
+    CONNECTION_LOGF(TRACE, connection, "Rate limited, will try again in %" PRIu64 "ns.", wait_ns);
+
+    aws_channel_schedule_task_future(
+        connection->base.channel_slot->channel, &connection->rate_limit_task, now_ns + wait_ns);
+    connection->thread_data.is_rate_limit_task_scheduled = true;
+}
+
+static uint64_t s_time_until_stream_may_send(struct aws_h2_connection *connection, struct aws_h2_stream *stream) {
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    return aws_http_rate_limiter_time_until_both(
+        connection->base.send_rate_limiter, stream->base.send_rate_limiter, now_ns, AWS_HTTP_RATE_LIMITER_MIN_GRANT);
+}
+
 /* Write as many DATA frames from outgoing_streams_list as possible. */
 static int s_encode_data_from_outgoing_streams(struct aws_h2_connection *connection, struct aws_byte_buf *output) {
 
@@ -880,6 +1006,10 @@ static int s_encode_data_from_outgoing_streams(struct aws_h2_connection *connect
                 stream->thread_data.waiting_for_writes = true;
                 aws_linked_list_push_back(waiting_streams_list, node);
                 break;
+            case AWS_H2_DATA_ENCODE_ONGOING_WAITING_FOR_BODY:
+                stream->thread_data.waiting_for_body_ready = true;
+                aws_linked_list_push_back(waiting_streams_list, node);
+                break;
             case AWS_H2_DATA_ENCODE_ONGOING_WINDOW_STALLED:
                 aws_linked_list_push_back(stalled_window_streams_list, node);
                 AWS_H2_STREAM_LOG(
@@ -888,6 +1018,10 @@ static int s_encode_data_from_outgoing_streams(struct aws_h2_connection *connect
                     "Peer stream's flow-control window is too small. Data frames on this stream will not be sent until "
                     "WINDOW_UPDATE. ");
                 break;
+            case AWS_H2_DATA_ENCODE_ONGOING_RATE_LIMITED:
+                aws_linked_list_push_back(&connection->thread_data.rate_limited_streams_list, node);
+                s_schedule_rate_limit_task(connection, s_time_until_stream_may_send(connection, stream));
+                break;
             default:
                 CONNECTION_LOG(ERROR, connection, "Data encode status is invalid.");
                 aws_error_code = AWS_ERROR_INVALID_STATE;
@@ -904,7 +1038,8 @@ done:
         return aws_raise_error(aws_error_code);
     }
 
-    if (aws_linked_list_empty(outgoing_streams_list)) {
+    if (aws_linked_list_empty(outgoing_streams_list) &&
+        aws_linked_list_empty(&connection->thread_data.rate_limited_streams_list)) {
         /* transition from something to write -> nothing to write */
         uint64_t now_ns = 0;
         aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
@@ -1078,13 +1213,44 @@ struct aws_h2err s_decoder_on_headers_begin(uint32_t stream_id, void *userdata)
     struct aws_h2_connection *connection = userdata;
 
     if (connection->base.server_data) {
+        /* Shed load rather than taking on another stream to buffer.
+         * REFUSED_STREAM tells the client nothing was processed, so it may retry the request. */
+        bool is_new_peer_stream =
+            (stream_id % 2) == 1 && stream_id > connection->thread_data.latest_peer_initiated_stream_id;
+        if (is_new_peer_stream && connection->base.memory_budget &&
+            aws_http_memory_budget_is_exhausted(connection->base.memory_budget)) {
+            CONNECTION_LOGF(
+                DEBUG, connection, "Refusing stream id=%" PRIu32 ", memory budget is exhausted.", stream_id);
+
+            connection->thread_data.latest_peer_initiated_stream_id = stream_id;
+            struct aws_h2_frame *rst_stream =
+                aws_h2_frame_new_rst_stream(connection->base.alloc, stream_id, AWS_HTTP2_ERR_REFUSED_STREAM);
+            if (!rst_stream) {
+                CONNECTION_LOGF(
+                    ERROR, connection, "Error creating RST_STREAM frame, %s", aws_error_name(aws_last_error()));
+                return aws_h2err_from_last_error();
+            }
+            aws_h2_connection_enqueue_outgoing_frame(connection, rst_stream);
+
+            /* The rest of the stream's frames are ignored */
+            if (s_record_closed_stream(connection, stream_id, AWS_H2_STREAM_CLOSED_WHEN_RST_STREAM_SENT)) {
+                return aws_h2err_from_last_error();
+            }
+            return AWS_H2ERR_SUCCESS;
+        }
+
         /* Server would create new request-handler stream... */
         return aws_h2err_from_aws_code(AWS_ERROR_UNIMPLEMENTED);
     }
 
+    /* Body data must reach the user before the trailing headers that follow it */
+    struct aws_h2err err = s_flush_pending_body_for_stream_id(connection, stream_id);
+    if (aws_h2err_failed(err)) {
+        return err;
+    }
+
     struct aws_h2_stream *stream;
-    struct aws_h2err err =
-        s_get_active_stream_for_incoming_frame(connection, stream_id, AWS_H2_FRAME_T_HEADERS, &stream);
+    err = s_get_active_stream_for_incoming_frame(connection, stream_id, AWS_H2_FRAME_T_HEADERS, &stream);
     if (aws_h2err_failed(err)) {
         return err;
     }
@@ -1202,6 +1368,238 @@ static int s_connection_send_update_window(struct aws_h2_connection *connection,
     return AWS_OP_SUCCESS;
 }
 
+/* Owe the peer a connection WINDOW_UPDATE of `window_size`, and send as much of what's owed as the memory budget
+ * has room for and the receive rate limiter allows. Whatever they won't allow is delayed, and we ask them again later.
+ * Nothing is reserved from the budget here, it's only charged for data that's actually retained. */
+static int s_connection_send_update_window_paced(struct aws_h2_connection *connection, uint32_t window_size) {
+    struct aws_http_memory_budget *budget = connection->base.memory_budget;
+    struct aws_http_rate_limiter *limiter = connection->base.receive_rate_limiter;
+
+    connection->thread_data.window_update_deferred += window_size;
+    size_t owed = aws_min_size(connection->thread_data.window_update_deferred, AWS_H2_WINDOW_UPDATE_MAX);
+    size_t granted = owed;
+    if (budget) {
+        /* The window that's already open may still be filled, so it counts against the room */
+        const size_t room = aws_sub_size_saturating(
+            aws_http_memory_budget_get_available(budget), connection->thread_data.window_size_self);
+        granted = aws_min_size(owed, room);
+    }
+    bool is_rate_limited = false;
+    if (limiter && granted > 0) {
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+        const size_t allowed = aws_http_rate_limiter_take(
+            limiter, now_ns, aws_min_size(granted, AWS_HTTP_RATE_LIMITER_MIN_GRANT), granted);
+        if (allowed < granted) {
+            is_rate_limited = true;
+            s_schedule_rate_limit_task(
+                connection,
+                aws_http_rate_limiter_time_until(limiter, now_ns, aws_min_size(owed, AWS_HTTP_RATE_LIMITER_MIN_GRANT)));
+        }
+        granted = allowed;
+    }
+
+    if (granted > 0) {
+        connection->thread_data.window_update_deferred -= granted;
+        if (s_connection_send_update_window(connection, (uint32_t)granted)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    if (budget && !is_rate_limited && connection->thread_data.window_update_deferred > 0 &&
+        !connection->thread_data.is_memory_budget_retry_scheduled) {
+
+        CONNECTION_LOGF(
+            TRACE,
+            connection,
+            "Memory budget has no room, delaying connection WINDOW_UPDATE of %zu.",
+            connection->thread_data.window_update_deferred);
+
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+        aws_channel_schedule_task_future(
+            connection->base.channel_slot->channel,
+            &connection->memory_budget_retry_task,
+            now_ns + budget->retry_interval_ns);
+        connection->thread_data.is_memory_budget_retry_scheduled = true;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Send an automatic connection WINDOW_UPDATE, paced if the connection has a memory budget or receive rate limiter */
+static int s_connection_send_auto_update_window(struct aws_h2_connection *connection, uint32_t window_size) {
+    if (connection->base.memory_budget || connection->base.receive_rate_limiter) {
+        return s_connection_send_update_window_paced(connection, window_size);
+    }
+    return s_connection_send_update_window(connection, window_size);
+}
+
+/* While body data is retained, hold back enough of the automatic connection WINDOW_UPDATEs to cover it.
+ * Returns what's left to send. */
+static uint32_t s_withhold_update_window_for_retained_body(struct aws_h2_connection *connection, uint32_t window_size) {
+    AWS_ASSERT(connection->thread_data.retained_body_bytes >= connection->thread_data.window_update_withheld);
+    size_t uncovered = connection->thread_data.retained_body_bytes - connection->thread_data.window_update_withheld;
+    uint32_t withhold = (uint32_t)aws_min_size(window_size, uncovered);
+    connection->thread_data.window_update_withheld += withhold;
+    return window_size - withhold;
+}
+
+static void s_memory_budget_retry_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_h2_connection *connection = arg;
+    connection->thread_data.is_memory_budget_retry_scheduled = false;
+
+    if (status != AWS_TASK_STATUS_RUN_READY || connection->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    if (s_connection_send_update_window_paced(connection, 0)) {
+        aws_h2_connection_shutdown_due_to_write_err(connection, aws_last_error());
+        return;
+    }
+
+    aws_h2_try_write_outgoing_frames(connection);
+}
+
+void aws_h2_connection_on_stream_window_update_deferred(
+    struct aws_h2_connection *connection,
+    struct aws_h2_stream *stream,
+    uint64_t wait_ns) {
+    AWS_PRECONDITION(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
+
+    if (stream->rate_limit_node.next == NULL) {
+        aws_linked_list_push_back(&connection->thread_data.rate_limited_window_streams_list, &stream->rate_limit_node);
+    }
+    s_schedule_rate_limit_task(connection, wait_ns);
+}
+
+static void s_rate_limit_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_h2_connection *connection = arg;
+    connection->thread_data.is_rate_limit_task_scheduled = false;
+
+    if (status != AWS_TASK_STATUS_RUN_READY || connection->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    /* Streams whose DATA was held back get another turn. If their limiters still say no, they'll be back */
+    while (!aws_linked_list_empty(&connection->thread_data.rate_limited_streams_list)) {
+        aws_linked_list_push_back(
+            &connection->thread_data.outgoing_streams_list,
+            aws_linked_list_pop_front(&connection->thread_data.rate_limited_streams_list));
+    }
+
+    if (connection->thread_data.window_update_deferred > 0 &&
+        s_connection_send_update_window_paced(connection, 0)) {
+        goto error;
+    }
+
+    /* Swap the list out first, since streams that are still held back re-add themselves */
+    struct aws_linked_list window_streams;
+    aws_linked_list_init(&window_streams);
+    aws_linked_list_swap_contents(&window_streams, &connection->thread_data.rate_limited_window_streams_list);
+    while (!aws_linked_list_empty(&window_streams)) {
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(&window_streams);
+        struct aws_h2_stream *stream = AWS_CONTAINER_OF(node, struct aws_h2_stream, rate_limit_node);
+        if (aws_h2_stream_send_deferred_window_update(stream)) {
+            /* Put the rest back, so they're cleaned up when the streams complete */
+            aws_linked_list_move_all_back(&connection->thread_data.rate_limited_window_streams_list, &window_streams);
+            goto error;
+        }
+    }
+
+    aws_h2_try_write_outgoing_frames(connection);
+    return;
+
+error:
+    aws_h2_connection_shutdown_due_to_write_err(connection, aws_last_error());
+}
+
+/* Count one frame of a kind that a peer could flood us with, since each costs the peer almost nothing to send.
+ * Returns ENHANCE_YOUR_CALM if the peer has exceeded the limit within the sliding window */
+static struct aws_h2err s_count_frame_against_abuse_limit(
+    struct aws_h2_connection *connection,
+    struct aws_h2_abuse_counter *counter,
+    uint32_t limit,
+    const char *frame_description) {
+
+    if (limit == 0) {
+        return AWS_H2ERR_SUCCESS;
+    }
+
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+    uint64_t window_ns =
+        aws_timestamp_convert(connection->abuse_limits.window_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+
+    /* Roll the fixed windows forward, if the current one has ended */
+    uint64_t elapsed_ns = now_ns > counter->window_start_ns ? now_ns - counter->window_start_ns : 0;
+    if (elapsed_ns >= window_ns) {
+        counter->previous_count = (elapsed_ns / window_ns == 1) ? counter->current_count : 0;
+        counter->current_count = 0;
+        counter->window_start_ns = now_ns - (elapsed_ns % window_ns);
+        elapsed_ns %= window_ns;
+    }
+
+    counter->current_count++;
+
+    /* Weight the previous window by how much of it still overlaps the sliding window */
+    uint64_t estimate = aws_mul_u64_saturating(counter->previous_count, window_ns - elapsed_ns) / window_ns;
+    estimate = aws_add_u64_saturating(estimate, counter->current_count);
+    if (estimate > limit) {
+        CONNECTION_LOGF(
+            ERROR,
+            connection,
+            "Peer sent more than %" PRIu32 " %s within %" PRIu64 " ms, treating this as abuse.",
+            limit,
+            frame_description,
+            connection->abuse_limits.window_ms);
+        return aws_h2err_from_h2_code(AWS_HTTP2_ERR_ENHANCE_YOUR_CALM);
+    }
+
+    return AWS_H2ERR_SUCCESS;
+}
+
+void aws_h2_connection_on_stream_pending_body(struct aws_h2_connection *connection, struct aws_h2_stream *stream) {
+    AWS_PRECONDITION(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
+
+    if (stream->pending_body_node.next == NULL) {
+        aws_linked_list_push_back(&connection->thread_data.pending_body_streams_list, &stream->pending_body_node);
+    }
+}
+
+/* Deliver a stream's gathered body now, because something that must come after it is about to happen.
+ * The stream may complete during this call, so look it up again afterwards if you need it. */
+static struct aws_h2err s_flush_pending_body_for_stream_id(struct aws_h2_connection *connection, uint32_t stream_id) {
+    struct aws_hash_element *found = NULL;
+    aws_hash_table_find(&connection->thread_data.active_streams_map, (void *)(size_t)stream_id, &found);
+    if (!found) {
+        return AWS_H2ERR_SUCCESS;
+    }
+
+    struct aws_h2_stream *stream = found->value;
+    if (stream->pending_body_node.next == NULL) {
+        return AWS_H2ERR_SUCCESS;
+    }
+    aws_linked_list_remove(&stream->pending_body_node);
+    return aws_h2_stream_flush_pending_body(stream);
+}
+
+/* Deliver all gathered body, called once the aws_io_message it points into is fully decoded */
+static struct aws_h2err s_flush_all_pending_bodies(struct aws_h2_connection *connection) {
+    while (!aws_linked_list_empty(&connection->thread_data.pending_body_streams_list)) {
+        struct aws_linked_list_node *node =
+            aws_linked_list_pop_front(&connection->thread_data.pending_body_streams_list);
+        struct aws_h2_stream *stream = AWS_CONTAINER_OF(node, struct aws_h2_stream, pending_body_node);
+        struct aws_h2err err = aws_h2_stream_flush_pending_body(stream);
+        if (aws_h2err_failed(err)) {
+            return err;
+        }
+    }
+    return AWS_H2ERR_SUCCESS;
+}
+
 struct aws_h2err s_decoder_on_data_begin(
     uint32_t stream_id,
     uint32_t payload_len,
@@ -1210,6 +1608,18 @@ struct aws_h2err s_decoder_on_data_begin(
     void *userdata) {
     struct aws_h2_connection *connection = userdata;
 
+    /* DATA frames that carry nothing and end nothing are only good for wasting our time */
+    if (payload_len == total_padding_bytes && !end_stream) {
+        struct aws_h2err err = s_count_frame_against_abuse_limit(
+            connection,
+            &connection->thread_data.abuse_counters.empty_data,
+            connection->abuse_limits.max_empty_data_frames,
+            "empty DATA frames");
+        if (aws_h2err_failed(err)) {
+            return err;
+        }
+    }
+
     /* A receiver that receives a flow-controlled frame MUST always account for its contribution against the connection
      * flow-control window, unless the receiver treats this as a connection error */
     if (aws_sub_size_checked(
@@ -1243,12 +1653,12 @@ struct aws_h2err s_decoder_on_data_begin(
          * so we can't expect them to manage it themselves. */
         auto_window_update = total_padding_bytes;
     } else {
-        /* Automatically update the full amount we just received */
-        auto_window_update = payload_len;
+        /* Automatically update the full amount we just received, less anything owed to retained body data */
+        auto_window_update = s_withhold_update_window_for_retained_body(connection, payload_len);
     }
 
     if (auto_window_update != 0) {
-        if (s_connection_send_update_window(connection, auto_window_update)) {
+        if (s_connection_send_auto_update_window(connection, auto_window_update)) {
             return aws_h2err_from_last_error();
         }
         CONNECTION_LOGF(
@@ -1289,11 +1699,17 @@ struct aws_h2err s_decoder_on_end_stream(uint32_t stream_id, void *userdata) {
      * isn't an actual frame type. It's a flag on DATA or HEADERS frames, and we
      * already checked the legality of those frames in their respective callbacks. */
 
+    /* Body data must reach the user before the stream completes */
+    struct aws_h2err err = s_flush_pending_body_for_stream_id(connection, stream_id);
+    if (aws_h2err_failed(err)) {
+        return err;
+    }
+
     struct aws_hash_element *found = NULL;
     aws_hash_table_find(&connection->thread_data.active_streams_map, (void *)(size_t)stream_id, &found);
     if (found) {
         struct aws_h2_stream *stream = found->value;
-        struct aws_h2err err = aws_h2_stream_on_decoder_end_stream(stream);
+        err = aws_h2_stream_on_decoder_end_stream(stream);
         if (aws_h2err_failed(err)) {
             return err;
         }
@@ -1305,10 +1721,18 @@ struct aws_h2err s_decoder_on_end_stream(uint32_t stream_id, void *userdata) {
 static struct aws_h2err s_decoder_on_rst_stream(uint32_t stream_id, uint32_t h2_error_code, void *userdata) {
     struct aws_h2_connection *connection = userdata;
 
+    struct aws_h2err err = s_count_frame_against_abuse_limit(
+        connection,
+        &connection->thread_data.abuse_counters.rst_stream,
+        connection->abuse_limits.max_rst_stream_frames,
+        "RST_STREAM frames");
+    if (aws_h2err_failed(err)) {
+        return err;
+    }
+
     /* Pass RST_STREAM to stream */
     struct aws_h2_stream *stream;
-    struct aws_h2err err =
-        s_get_active_stream_for_incoming_frame(connection, stream_id, AWS_H2_FRAME_T_RST_STREAM, &stream);
+    err = s_get_active_stream_for_incoming_frame(connection, stream_id, AWS_H2_FRAME_T_RST_STREAM, &stream);
     if (aws_h2err_failed(err)) {
         return err;
     }
@@ -1323,6 +1747,17 @@ static struct aws_h2err s_decoder_on_rst_stream(uint32_t stream_id, uint32_t h2_
     return AWS_H2ERR_SUCCESS;
 }
 
+static struct aws_h2err s_decoder_on_continuation(uint32_t stream_id, void *userdata) {
+    (void)stream_id;
+    struct aws_h2_connection *connection = userdata;
+
+    return s_count_frame_against_abuse_limit(
+        connection,
+        &connection->thread_data.abuse_counters.continuation,
+        connection->abuse_limits.max_continuation_frames,
+        "CONTINUATION frames");
+}
+
 static struct aws_h2err s_decoder_on_ping_ack(uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE], void *userdata) {
     struct aws_h2_connection *connection = userdata;
     if (aws_linked_list_empty(&connection->thread_data.pending_ping_queue)) {
@@ -1376,6 +1811,15 @@ error:
 static struct aws_h2err s_decoder_on_ping(uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE], void *userdata) {
     struct aws_h2_connection *connection = userdata;
 
+    struct aws_h2err err = s_count_frame_against_abuse_limit(
+        connection,
+        &connection->thread_data.abuse_counters.ping,
+        connection->abuse_limits.max_ping_frames,
+        "PING frames");
+    if (aws_h2err_failed(err)) {
+        return err;
+    }
+
     /* send a PING frame with the ACK flag set in response, with an identical payload. */
     struct aws_h2_frame *ping_ack_frame = aws_h2_frame_new_ping(connection->base.alloc, true, opaque_data);
     if (!ping_ack_frame) {
@@ -1393,7 +1837,15 @@ static struct aws_h2err s_decoder_on_settings(
     size_t num_settings,
     void *userdata) {
     struct aws_h2_connection *connection = userdata;
-    struct aws_h2err err;
+    struct aws_h2err err = s_count_frame_against_abuse_limit(
+        connection,
+        &connection->thread_data.abuse_counters.settings,
+        connection->abuse_limits.max_settings_frames,
+        "SETTINGS frames");
+    if (aws_h2err_failed(err)) {
+        return err;
+    }
+
     /* Once all values have been processed, the recipient MUST immediately emit a SETTINGS frame with the ACK flag
      * set.(RFC-7540 6.5.3) */
     CONNECTION_LOG(TRACE, connection, "Setting frame processing ends");
@@ -1526,6 +1978,9 @@ static struct aws_h2err s_decoder_on_settings_ack(void *userdata) {
             case AWS_HTTP2_SETTINGS_MAX_FRAME_SIZE: {
                 aws_h2_decoder_set_setting_max_frame_size(decoder, settings_array[i].value);
             } break;
+            case AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE: {
+                aws_h2_decoder_set_setting_max_header_list_size(decoder, settings_array[i].value);
+            } break;
             default:
                 break;
         }
@@ -1752,8 +2207,11 @@ static void s_handler_installed(struct aws_channel_handler *handler, struct aws_
     /* enqueue the initial settings frame here */
     aws_linked_list_push_back(&connection->thread_data.outgoing_frames_queue, &init_settings_frame->node);
 
-    /* If not manual connection window management, update the connection window to max. */
-    if (!connection->conn_manual_window_management) {
+    /* If not manual connection window management, update the connection window to max.
+     * Unless there's a memory budget or receive rate limiter, then the window stays put,
+     * and is only replenished as they allow. */
+    if (!connection->conn_manual_window_management && !connection->base.memory_budget &&
+        !connection->base.receive_rate_limiter) {
         uint32_t initial_window_update_size = AWS_H2_WINDOW_UPDATE_MAX - AWS_H2_INIT_WINDOW_SIZE;
         struct aws_h2_frame *connection_window_update_frame =
             aws_h2_frame_new_window_update(connection->base.alloc, 0 /* stream_id */, initial_window_update_size);
@@ -1764,6 +2222,10 @@ static void s_handler_installed(struct aws_channel_handler *handler, struct aws_
         connection->thread_data.window_size_self += initial_window_update_size;
     }
     aws_h2_try_write_outgoing_frames(connection);
+
+    if (connection->idle_trim_ns) {
+        s_schedule_idle_trim_task(connection);
+    }
     return;
 
 error:
@@ -1790,6 +2252,12 @@ static void s_stream_complete(struct aws_h2_connection *connection, struct aws_h
     if (stream->node.next) {
         aws_linked_list_remove(&stream->node);
     }
+    if (stream->pending_body_node.next) {
+        aws_linked_list_remove(&stream->pending_body_node);
+    }
+    if (stream->rate_limit_node.next) {
+        aws_linked_list_remove(&stream->rate_limit_node);
+    }
 
     if (aws_hash_table_get_entry_count(&connection->thread_data.active_streams_map) == 0 &&
         connection->thread_data.incoming_timestamp_ns != 0) {
@@ -2077,6 +2545,69 @@ error:
     return aws_raise_error(err);
 }
 
+int aws_h2_stream_activate_upgraded(struct aws_http_stream *stream) {
+    struct aws_h2_stream *h2_stream = AWS_CONTAINER_OF(stream, struct aws_h2_stream, base);
+
+    struct aws_http_connection *base_connection = stream->owning_connection;
+    struct aws_h2_connection *connection = AWS_CONTAINER_OF(base_connection, struct aws_h2_connection, base);
+    AWS_PRECONDITION(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
+
+    /* RFC-7540 3.2: The HTTP/1.1 request that is sent prior to upgrade is assigned a stream identifier of 1 */
+    const uint32_t upgraded_stream_id = 1;
+    int err;
+    { /* BEGIN CRITICAL SECTION */
+        s_acquire_stream_and_connection_lock(h2_stream, connection);
+
+        err = connection->synced_data.new_stream_error_code;
+        if (!err && (stream->id != 0 || base_connection->next_stream_id != upgraded_stream_id)) {
+            /* Some other stream already took stream 1 */
+            err = AWS_ERROR_INVALID_STATE;
+        }
+
+        if (!err) {
+            stream->id = aws_http_connection_get_next_stream_id(base_connection);
+            h2_stream->synced_data.api_state = AWS_H2_STREAM_API_STATE_ACTIVE;
+        }
+
+        s_release_stream_and_connection_lock(h2_stream, connection);
+    } /* END CRITICAL SECTION */
+
+    if (err) {
+        CONNECTION_LOGF(
+            ERROR,
+            connection,
+            "Failed to activate the upgraded stream id=%p, error %d (%s)",
+            (void *)stream,
+            err,
+            aws_error_name(err));
+        return aws_raise_error(err);
+    }
+
+    /* connection keeps activated stream alive until stream completes */
+    aws_atomic_fetch_add(&stream->refcount, 1);
+    stream->metrics.stream_id = stream->id;
+
+    /* Skip the cross-thread work task, we're already on the thread and the stream's HEADERS were already sent */
+    if (aws_hash_table_put(
+            &connection->thread_data.active_streams_map, (void *)(size_t)stream->id, h2_stream, NULL)) {
+        AWS_H2_STREAM_LOG(ERROR, h2_stream, "Failed inserting stream into map");
+        s_stream_complete(connection, h2_stream, aws_last_error());
+        return AWS_OP_SUCCESS;
+    }
+
+    aws_h2_stream_on_activated_by_upgrade(h2_stream);
+
+    if (aws_hash_table_get_entry_count(&connection->thread_data.active_streams_map) == 1) {
+        /* transition from nothing to read -> something to read */
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(connection->base.channel_slot->channel, &now_ns);
+        connection->thread_data.incoming_timestamp_ns = now_ns;
+    }
+
+    AWS_H2_STREAM_LOG(DEBUG, h2_stream, "Activated stream for HTTP/1.1 request that carried the h2c upgrade");
+    return AWS_OP_SUCCESS;
+}
+
 static struct aws_http_stream *s_connection_make_request(
     struct aws_http_connection *client_connection,
     const struct aws_http_make_request_options *options) {
@@ -2421,7 +2952,7 @@ static void s_get_settings_general(
     bool local) {
 
     struct aws_h2_connection *connection = AWS_CONTAINER_OF(connection_base, struct aws_h2_connection, base);
-    uint32_t synced_settings[AWS_HTTP2_SETTINGS_END_RANGE];
+    uint32_t synced_settings[AWS_H2_SETTINGS_END_RANGE];
     { /* BEGIN CRITICAL SECTION */
         s_lock_synced_data(connection);
         if (local) {
@@ -2558,6 +3089,114 @@ static int s_connection_get_received_goaway(
     return AWS_OP_SUCCESS;
 }
 
+/* An aws_io_message kept alive because retained body data points into it.
+ * Holds the channel, so the connection outlives it. */
+struct aws_h2_retained_message {
+    struct aws_http_retained_body base;
+    struct aws_h2_connection *connection;
+    struct aws_io_message *message;
+
+    /* Body data from this message given to on_incoming_body_retained callbacks */
+    size_t body_bytes;
+
+    /* The last reference may be released from any thread, but the message must be freed on the event-loop thread */
+    struct aws_task release_task;
+};
+
+/* Stop withholding connection WINDOW_UPDATE for body data that's no longer retained */
+static void s_on_retained_body_released(struct aws_h2_connection *connection, size_t body_bytes) {
+    AWS_ASSERT(connection->thread_data.retained_body_bytes >= body_bytes);
+    connection->thread_data.retained_body_bytes -= body_bytes;
+
+    if (connection->thread_data.window_update_withheld <= connection->thread_data.retained_body_bytes) {
+        return;
+    }
+
+    size_t window_update = connection->thread_data.window_update_withheld - connection->thread_data.retained_body_bytes;
+    connection->thread_data.window_update_withheld = connection->thread_data.retained_body_bytes;
+    if (connection->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    CONNECTION_LOGF(TRACE, connection, "Retained body released, updating connection window by %zu.", window_update);
+    if (s_connection_send_auto_update_window(connection, (uint32_t)window_update)) {
+        aws_h2_connection_shutdown_due_to_write_err(connection, aws_last_error());
+        return;
+    }
+
+    aws_h2_try_write_outgoing_frames(connection);
+}
+
+static void s_retained_message_destroy(struct aws_h2_retained_message *retained) {
+    struct aws_h2_connection *connection = retained->connection;
+    struct aws_channel *channel = connection->base.channel_slot->channel;
+
+    /* Return the message to the budget first, so the WINDOW_UPDATE sent below can use the room */
+    if (connection->base.memory_budget) {
+        aws_http_memory_budget_unreserve(connection->base.memory_budget, retained->message->message_data.capacity);
+    }
+    s_on_retained_body_released(connection, retained->body_bytes);
+    aws_mem_release(retained->message->allocator, retained->message);
+    aws_mem_release(connection->base.alloc, retained);
+
+    /* The connection may be destroyed once the channel is free to go */
+    aws_channel_release_hold(channel);
+}
+
+static void s_retained_message_release_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    (void)status;
+    s_retained_message_destroy(arg);
+}
+
+static void s_retained_message_on_zero_refs(struct aws_http_retained_body *retained_body) {
+    struct aws_h2_retained_message *retained = AWS_CONTAINER_OF(retained_body, struct aws_h2_retained_message, base);
+    struct aws_event_loop *event_loop = aws_channel_get_event_loop(retained->connection->base.channel_slot->channel);
+
+    if (aws_event_loop_thread_is_callers_thread(event_loop)) {
+        s_retained_message_destroy(retained);
+    } else {
+        aws_event_loop_schedule_task_now(event_loop, &retained->release_task);
+    }
+}
+
+struct aws_http_retained_body *aws_h2_connection_retain_incoming_body(
+    struct aws_h2_connection *connection,
+    size_t data_len) {
+
+    AWS_PRECONDITION(aws_channel_thread_is_callers_thread(connection->base.channel_slot->channel));
+    AWS_PRECONDITION(connection->thread_data.incoming_message);
+
+    struct aws_h2_retained_message *retained = connection->thread_data.incoming_retained_message;
+    if (!retained) {
+        retained = aws_mem_calloc(connection->base.alloc, 1, sizeof(struct aws_h2_retained_message));
+        if (!retained) {
+            return NULL;
+        }
+
+        aws_atomic_init_int(&retained->base.refcount, 1);
+        retained->base.on_zero_refs = s_retained_message_on_zero_refs;
+        retained->connection = connection;
+        retained->message = connection->thread_data.incoming_message;
+        aws_task_init(
+            &retained->release_task, s_retained_message_release_task, retained, "h2_retained_message_release");
+        aws_channel_acquire_hold(connection->base.channel_slot->channel);
+
+        /* The whole message stays in memory until every retained body pointing into it is released.
+         * It already arrived, so the budget can't refuse it, the connection window is how the budget holds back more */
+        if (connection->base.memory_budget) {
+            aws_http_memory_budget_reserve_forced(
+                connection->base.memory_budget, retained->message->message_data.capacity);
+        }
+
+        connection->thread_data.incoming_retained_message = retained;
+    }
+
+    retained->body_bytes += data_len;
+    connection->thread_data.retained_body_bytes += data_len;
+    return &retained->base;
+}
+
 static int s_handler_process_read_message(
     struct aws_channel_handler *handler,
     struct aws_channel_slot *slot,
@@ -2572,10 +3211,17 @@ static int s_handler_process_read_message(
         goto clean_up;
     }
 
+    connection->thread_data.activity_count++;
+    connection->thread_data.incoming_message = message;
+
     /* Any error that bubbles up from the decoder or its callbacks is treated as
      * a Connection Error (a GOAWAY frames is sent, and the connection is closed) */
     struct aws_byte_cursor message_cursor = aws_byte_cursor_from_buf(&message->message_data);
     struct aws_h2err err = aws_h2_decode(connection->thread_data.decoder, &message_cursor);
+    if (!aws_h2err_failed(err)) {
+        /* Vectored body callbacks get everything decoded from this message at once */
+        err = s_flush_all_pending_bodies(connection);
+    }
     if (aws_h2err_failed(err)) {
         CONNECTION_LOGF(
             ERROR,
@@ -2608,7 +3254,15 @@ shutdown:
     s_stop(connection, true /*stop_reading*/, false /*stop_writing*/, true /*schedule_shutdown*/, err.aws_code);
 
 clean_up:
-    aws_mem_release(message->allocator, message);
+    connection->thread_data.incoming_message = NULL;
+    if (connection->thread_data.incoming_retained_message) {
+        /* Streams retained body data from the message, it's freed when the last reference is released */
+        struct aws_h2_retained_message *retained = connection->thread_data.incoming_retained_message;
+        connection->thread_data.incoming_retained_message = NULL;
+        aws_http_retained_body_release(&retained->base);
+    } else {
+        aws_mem_release(message->allocator, message);
+    }
 
     /* Flush any outgoing frames that might have been queued as a result of decoder callbacks. */
     aws_h2_try_write_outgoing_frames(connection);
@@ -2846,6 +3500,8 @@ static void s_gather_statistics(struct aws_channel_handler *handler, struct aws_
         connection->thread_data.stats.was_inactive = true;
     }
 
+    connection->thread_data.stats.resident_bytes = s_get_resident_bytes(connection);
+
     void *stats_base = &connection->thread_data.stats;
     aws_array_list_push_back(stats, &stats_base);
 }
@@ -262,6 +262,9 @@ struct aws_h2_decoder {
 
         bool body_headers_forbidden;
 
+        /* Size of the header list so far, as defined by SETTINGS_MAX_HEADER_LIST_SIZE (RFC-9113 6.5.2) */
+        uint64_t header_list_size;
+
         /* Buffer up cookie header fields to concatenate separate ones */
         struct aws_byte_buf cookies;
         /* If separate cookie fields have different compression types, the concatenated cookie uses the strictest type.
@@ -275,6 +278,8 @@ struct aws_h2_decoder {
         uint32_t enable_push;
         /*  the size of the largest frame payload */
         uint32_t max_frame_size;
+        /* the size of the largest header list, per header-block */
+        uint32_t max_header_list_size;
     } settings;
 
     struct aws_array_list settings_buffer_list;
@@ -324,6 +329,7 @@ struct aws_h2_decoder *aws_h2_decoder_new(struct aws_h2_decoder_params *params)
 
     decoder->settings.enable_push = aws_h2_settings_initial[AWS_HTTP2_SETTINGS_ENABLE_PUSH];
     decoder->settings.max_frame_size = aws_h2_settings_initial[AWS_HTTP2_SETTINGS_MAX_FRAME_SIZE];
+    decoder->settings.max_header_list_size = aws_h2_settings_initial[AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE];
 
     if (aws_array_list_init_dynamic(
             &decoder->settings_buffer_list, decoder->alloc, 0, sizeof(struct aws_http2_setting))) {
@@ -369,6 +375,34 @@ void aws_h2_decoder_destroy(struct aws_h2_decoder *decoder) {
     aws_mem_release(decoder->alloc, decoder);
 }
 
+int aws_h2_decoder_trim(struct aws_h2_decoder *decoder) {
+    AWS_PRECONDITION(decoder);
+
+    /* Cookies are only buffered while a header-block is in progress */
+    if (decoder->header_block_in_progress.stream_id == 0 && decoder->header_block_in_progress.cookies.capacity > 0) {
+        aws_byte_buf_clean_up(&decoder->header_block_in_progress.cookies);
+        aws_byte_buf_init(&decoder->header_block_in_progress.cookies, decoder->alloc, 0);
+    }
+
+    /* Settings are only buffered while a SETTINGS frame is in progress */
+    if (aws_array_list_length(&decoder->settings_buffer_list) == 0 &&
+        aws_array_list_capacity(&decoder->settings_buffer_list) > 0) {
+        aws_array_list_clean_up(&decoder->settings_buffer_list);
+        aws_array_list_init_dynamic(
+            &decoder->settings_buffer_list, decoder->alloc, 0, sizeof(struct aws_http2_setting));
+    }
+
+    return aws_hpack_decoder_trim(&decoder->hpack);
+}
+
+size_t aws_h2_decoder_get_resident_bytes(const struct aws_h2_decoder *decoder) {
+    AWS_PRECONDITION(decoder);
+
+    return sizeof(struct aws_h2_decoder) + s_scratch_space_size + decoder->header_block_in_progress.cookies.capacity +
+           aws_array_list_capacity(&decoder->settings_buffer_list) * sizeof(struct aws_http2_setting) +
+           decoder->goaway_in_progress.debug_data.capacity + aws_hpack_decoder_get_resident_bytes(&decoder->hpack);
+}
+
 struct aws_h2err aws_h2_decode(struct aws_h2_decoder *decoder, struct aws_byte_cursor *data) {
     AWS_PRECONDITION(decoder);
     AWS_PRECONDITION(data);
@@ -904,7 +938,7 @@ static struct aws_h2err s_state_fn_frame_settings_i(struct aws_h2_decoder *decod
 
     /* An endpoint that receives a SETTINGS frame with any unknown or unsupported identifier MUST ignore that setting.
      * RFC-7540 6.5.2 */
-    if (id >= AWS_HTTP2_SETTINGS_BEGIN_RANGE && id < AWS_HTTP2_SETTINGS_END_RANGE) {
+    if (aws_h2_settings_id_is_known(id)) {
         /* check the value meets the settings bounds */
         if (value < aws_h2_settings_bounds[id][0] || value > aws_h2_settings_bounds[id][1]) {
             DECODER_LOGF(
@@ -1105,6 +1139,9 @@ static struct aws_h2err s_state_fn_frame_window_update(struct aws_h2_decoder *de
 static struct aws_h2err s_state_fn_frame_continuation(struct aws_h2_decoder *decoder, struct aws_byte_cursor *input) {
     (void)input;
 
+    /* Let the connection account for CONTINUATION frames, so an endless stream of them can be stopped */
+    DECODER_CALL_VTABLE_STREAM(decoder, on_continuation);
+
     /* Read the header-block fragment */
     return s_decoder_switch_state(decoder, &s_state_header_block_loop);
 }
@@ -1542,6 +1579,20 @@ static struct aws_h2err s_state_fn_header_block_entry(struct aws_h2_decoder *dec
             AWS_BYTE_CURSOR_PRI(header_field->name),
             AWS_BYTE_CURSOR_PRI(header_field->value));
 
+        /* Enforce SETTINGS_MAX_HEADER_LIST_SIZE as each field arrives, rather than once the whole block is buffered.
+         * Going over is a Stream Error, like a malformed header-block. The rest of the block still needs HPACK
+         * decoding to keep the dynamic table in sync, but no more fields are buffered or delivered. */
+        struct aws_header_block_in_progress *current_block = &decoder->header_block_in_progress;
+        current_block->header_list_size += aws_hpack_get_header_size(header_field);
+        if (!current_block->malformed && current_block->header_list_size > decoder->settings.max_header_list_size) {
+            DECODER_LOGF(
+                ERROR,
+                decoder,
+                "Header list size exceeds SETTINGS_MAX_HEADER_LIST_SIZE %" PRIu32 ", stream will be reset",
+                decoder->settings.max_header_list_size);
+            current_block->malformed = true;
+        }
+
         struct aws_h2err err = s_process_header_field(decoder, header_field);
         if (aws_h2err_failed(err)) {
             return err;
@@ -1590,3 +1641,7 @@ void aws_h2_decoder_set_setting_enable_push(struct aws_h2_decoder *decoder, uint
 void aws_h2_decoder_set_setting_max_frame_size(struct aws_h2_decoder *decoder, uint32_t data) {
     decoder->settings.max_frame_size = data;
 }
+
+void aws_h2_decoder_set_setting_max_header_list_size(struct aws_h2_decoder *decoder, uint32_t data) {
+    decoder->settings.max_header_list_size = data;
+}
@@ -26,16 +26,17 @@ const struct aws_byte_cursor aws_h2_connection_preface_client_string =
     AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
 
 /* Initial values and bounds are from RFC-7540 6.5.2 */
-const uint32_t aws_h2_settings_initial[AWS_HTTP2_SETTINGS_END_RANGE] = {
+const uint32_t aws_h2_settings_initial[AWS_H2_SETTINGS_END_RANGE] = {
     [AWS_HTTP2_SETTINGS_HEADER_TABLE_SIZE] = 4096,
     [AWS_HTTP2_SETTINGS_ENABLE_PUSH] = 1,
     [AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS] = UINT32_MAX, /* "Initially there is no limit to this value" */
     [AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE] = AWS_H2_INIT_WINDOW_SIZE,
     [AWS_HTTP2_SETTINGS_MAX_FRAME_SIZE] = 16384,
     [AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE] = UINT32_MAX, /* "The initial value of this setting is unlimited" */
+    [AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL] = 0,        /* RFC-8441 3 */
 };
 
-const uint32_t aws_h2_settings_bounds[AWS_HTTP2_SETTINGS_END_RANGE][2] = {
+const uint32_t aws_h2_settings_bounds[AWS_H2_SETTINGS_END_RANGE][2] = {
     [AWS_HTTP2_SETTINGS_HEADER_TABLE_SIZE][0] = 0,
     [AWS_HTTP2_SETTINGS_HEADER_TABLE_SIZE][1] = UINT32_MAX,
 
@@ -53,14 +54,19 @@ const uint32_t aws_h2_settings_bounds[AWS_HTTP2_SETTINGS_END_RANGE][2] = {
 
     [AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE][0] = 0,
     [AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE][1] = UINT32_MAX,
+
+    [AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL][0] = 0,
+    [AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL][1] = 1,
 };
 
+bool aws_h2_settings_id_is_known(uint32_t id) {
+    return (id >= AWS_HTTP2_SETTINGS_BEGIN_RANGE && id < AWS_HTTP2_SETTINGS_END_RANGE) ||
+           id == AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL;
+}
+
 /* Stream ids & dependencies should only write the bottom 31 bits */
 static const uint32_t s_u32_top_bit_mask = UINT32_MAX << 31;
 
-/* Bytes to initially reserve for encoding of an entire header block. Buffer will grow if necessary. */
-static const size_t s_encoded_header_block_reserve = 128; /* Value pulled from thin air */
-
 #define DEFINE_FRAME_VTABLE(NAME)                                                                                      \
     static aws_h2_frame_destroy_fn s_frame_##NAME##_destroy;                                                           \
     static aws_h2_frame_encode_fn s_frame_##NAME##_encode;                                                             \
@@ -308,6 +314,18 @@ void aws_h2_frame_encoder_clean_up(struct aws_h2_frame_encoder *encoder) {
     aws_hpack_encoder_clean_up(&encoder->hpack);
 }
 
+int aws_h2_frame_encoder_trim(struct aws_h2_frame_encoder *encoder) {
+    AWS_PRECONDITION(encoder);
+
+    return aws_hpack_encoder_trim(&encoder->hpack);
+}
+
+size_t aws_h2_frame_encoder_get_resident_bytes(const struct aws_h2_frame_encoder *encoder) {
+    AWS_PRECONDITION(encoder);
+
+    return aws_hpack_encoder_get_resident_bytes(&encoder->hpack);
+}
+
 /***********************************************************************************************************************
  * DATA
  **********************************************************************************************************************/
@@ -486,6 +504,7 @@ struct aws_h2_frame_headers {
         AWS_H2_HEADERS_STATE_COMPLETE,
     } state;
 
+    /* Only used when the header-block can't be encoded straight into the output as a single frame */
     struct aws_byte_buf whole_encoded_header_block;
     struct aws_byte_cursor header_block_cursor; /* tracks progress sending encoded header-block in fragments */
 };
@@ -529,10 +548,6 @@ static struct aws_h2_frame *s_frame_new_headers_or_push_promise(
         return NULL;
     }
 
-    if (aws_byte_buf_init(&frame->whole_encoded_header_block, allocator, s_encoded_header_block_reserve)) {
-        goto error;
-    }
-
     if (frame_type == AWS_H2_FRAME_T_HEADERS) {
         frame->end_stream = end_stream;
         if (optional_priority) {
@@ -550,10 +565,6 @@ static struct aws_h2_frame *s_frame_new_headers_or_push_promise(
     frame->pad_length = pad_length;
 
     return &frame->base;
-
-error:
-    s_frame_headers_destroy(&frame->base);
-    return NULL;
 }
 
 struct aws_h2_frame *aws_h2_frame_new_headers(
@@ -600,53 +611,182 @@ static void s_frame_headers_destroy(struct aws_h2_frame *frame_base) {
     aws_mem_release(frame->base.alloc, frame);
 }
 
-/* Encode the next frame for this header-block (or encode nothing if output buffer is too small). */
-static void s_encode_single_header_block_frame(
+/* Everything about a HEADERS, PUSH_PROMISE, or CONTINUATION frame besides its header-block fragment */
+struct aws_h2_header_block_frame_layout {
+    enum aws_h2_frame_type type;
+    uint8_t flags;
+    size_t payload_overhead; /* Amount of payload holding things other than header-block (padding, etc) */
+};
+
+/*
+ * Figure out the details of the next frame to encode.
+ * The first frame will be either HEADERS or PUSH_PROMISE.
+ * All subsequent frames will be CONTINUATION
+ */
+static void s_get_header_block_frame_layout(
+    const struct aws_h2_frame_headers *frame,
+    struct aws_h2_header_block_frame_layout *layout) {
+
+    AWS_ZERO_STRUCT(*layout);
+
+    if (frame->state == AWS_H2_HEADERS_STATE_CONTINUATION) {
+        layout->type = AWS_H2_FRAME_T_CONTINUATION;
+        return;
+    }
+
+    layout->type = frame->base.type;
+
+    if (frame->pad_length > 0) {
+        layout->flags |= AWS_H2_FRAME_F_PADDED;
+        layout->payload_overhead += 1 + frame->pad_length;
+    }
+
+    if (frame->has_priority) {
+        layout->flags |= AWS_H2_FRAME_F_PRIORITY;
+        layout->payload_overhead += s_frame_priority_settings_size;
+    }
+
+    if (frame->end_stream) {
+        layout->flags |= AWS_H2_FRAME_F_END_STREAM;
+    }
+
+    if (layout->type == AWS_H2_FRAME_T_PUSH_PROMISE) {
+        layout->payload_overhead += 4;
+    }
+}
+
+/* Write the frame prefix, and the rest of the payload that comes before the header-block fragment */
+static void s_encode_header_block_frame_start(
+    const struct aws_h2_frame_headers *frame,
+    const struct aws_h2_header_block_frame_layout *layout,
+    size_t fragment_len,
+    struct aws_byte_buf *output) {
+
+    bool writes_ok = true;
+
+    /* Write the frame prefix */
+    const size_t payload_len = fragment_len + layout->payload_overhead;
+    s_frame_prefix_encode(layout->type, frame->base.stream_id, payload_len, layout->flags, output);
+
+    /* Write pad length */
+    if (layout->flags & AWS_H2_FRAME_F_PADDED) {
+        AWS_ASSERT(layout->type != AWS_H2_FRAME_T_CONTINUATION);
+        writes_ok &= aws_byte_buf_write_u8(output, frame->pad_length);
+    }
+
+    /* Write priority */
+    if (layout->flags & AWS_H2_FRAME_F_PRIORITY) {
+        AWS_ASSERT(layout->type == AWS_H2_FRAME_T_HEADERS);
+        s_frame_priority_settings_encode(&frame->priority, output);
+    }
+
+    /* Write promised stream ID */
+    if (layout->type == AWS_H2_FRAME_T_PUSH_PROMISE) {
+        writes_ok &= aws_byte_buf_write_be32(output, frame->promised_stream_id);
+    }
+
+    AWS_ASSERT(writes_ok);
+    (void)writes_ok;
+}
+
+/* Write the rest of the payload that comes after the header-block fragment */
+static void s_encode_header_block_frame_end(
+    const struct aws_h2_frame_headers *frame,
+    const struct aws_h2_header_block_frame_layout *layout,
+    struct aws_byte_buf *output) {
+
+    /* Write padding */
+    if (layout->flags & AWS_H2_FRAME_F_PADDED) {
+        bool writes_ok = aws_byte_buf_write_u8_n(output, 0, frame->pad_length);
+        AWS_ASSERT(writes_ok);
+        (void)writes_ok;
+    }
+}
+
+static void s_log_header_block_frame(
+    const struct aws_h2_frame_headers *frame,
+    struct aws_h2_frame_encoder *encoder,
+    const struct aws_h2_header_block_frame_layout *layout) {
+
+    ENCODER_LOGF(
+        TRACE,
+        encoder,
+        "Encoding frame type=%s stream_id=%" PRIu32 "%s%s",
+        aws_h2_frame_type_to_str(layout->type),
+        frame->base.stream_id,
+        (layout->flags & AWS_H2_FRAME_F_END_HEADERS) ? " END_HEADERS" : "",
+        (layout->flags & AWS_H2_FRAME_F_END_STREAM) ? " END_STREAM" : "");
+}
+
+/* Returns whether a header-block of max_block_length is sure to fit in a single frame, given the space available */
+static bool s_header_block_fits_single_frame(
+    const struct aws_h2_frame_headers *frame,
+    const struct aws_h2_frame_encoder *encoder,
+    size_t space_available,
+    size_t max_block_length) {
+
+    struct aws_h2_header_block_frame_layout layout;
+    s_get_header_block_frame_layout(frame, &layout);
+
+    size_t max_payload;
+    if (aws_sub_size_checked(space_available, AWS_H2_FRAME_PREFIX_SIZE, &max_payload)) {
+        return false;
+    }
+    max_payload = aws_min_size(max_payload, encoder->settings.max_frame_size);
+
+    size_t max_fragment;
+    if (aws_sub_size_checked(max_payload, layout.payload_overhead, &max_fragment)) {
+        return false;
+    }
+
+    return max_block_length <= max_fragment;
+}
+
+/*
+ * HPACK-encode the header-block straight into the output, as a single HEADERS or PUSH_PROMISE frame.
+ * Only call this if s_header_block_fits_single_frame() for the space available.
+ * The frame prefix is written last, once the header-block's actual length is known.
+ */
+static int s_encode_header_block_directly(
     struct aws_h2_frame_headers *frame,
     struct aws_h2_frame_encoder *encoder,
     struct aws_byte_buf *output,
-    bool *waiting_for_more_space) {
+    size_t max_block_length) {
 
-    /*
-     * Figure out the details of the next frame to encode.
-     * The first frame will be either HEADERS or PUSH_PROMISE.
-     * All subsequent frames will be CONTINUATION
-     */
+    struct aws_h2_header_block_frame_layout layout;
+    s_get_header_block_frame_layout(frame, &layout);
+    layout.flags |= AWS_H2_FRAME_F_END_HEADERS;
 
-    enum aws_h2_frame_type frame_type;
-    uint8_t flags = 0;
-    uint8_t pad_length = 0;
-    const struct aws_h2_frame_priority_settings *priority_settings = NULL;
-    const uint32_t *promised_stream_id = NULL;
-    size_t payload_overhead = 0; /* Amount of payload holding things other than header-block (padding, etc) */
-
-    if (frame->state == AWS_H2_HEADERS_STATE_FIRST_FRAME) {
-        frame_type = frame->base.type;
-
-        if (frame->pad_length > 0) {
-            flags |= AWS_H2_FRAME_F_PADDED;
-            pad_length = frame->pad_length;
-            payload_overhead += 1 + pad_length;
-        }
+    const size_t frame_start = output->len;
+    s_encode_header_block_frame_start(frame, &layout, 0 /*fragment_len, rewritten below*/, output);
 
-        if (frame->has_priority) {
-            priority_settings = &frame->priority;
-            flags |= AWS_H2_FRAME_F_PRIORITY;
-            payload_overhead += s_frame_priority_settings_size;
-        }
+    /* This view of the output can't grow. It doesn't need to, the header-block can't exceed max_block_length */
+    struct aws_byte_buf header_block = aws_byte_buf_from_empty_array(output->buffer + output->len, max_block_length);
+    if (aws_hpack_encode_header_block(&encoder->hpack, frame->headers, &header_block)) {
+        output->len = frame_start;
+        return AWS_OP_ERR;
+    }
+    output->len += header_block.len;
 
-        if (frame->end_stream) {
-            flags |= AWS_H2_FRAME_F_END_STREAM;
-        }
+    s_encode_header_block_frame_end(frame, &layout, output);
 
-        if (frame_type == AWS_H2_FRAME_T_PUSH_PROMISE) {
-            promised_stream_id = &frame->promised_stream_id;
-            payload_overhead += 4;
-        }
+    struct aws_byte_buf prefix = aws_byte_buf_from_empty_array(output->buffer + frame_start, AWS_H2_FRAME_PREFIX_SIZE);
+    s_frame_prefix_encode(
+        layout.type, frame->base.stream_id, header_block.len + layout.payload_overhead, layout.flags, &prefix);
 
-    } else /* CONTINUATION */ {
-        frame_type = AWS_H2_FRAME_T_CONTINUATION;
-    }
+    s_log_header_block_frame(frame, encoder, &layout);
+    return AWS_OP_SUCCESS;
+}
+
+/* Encode the next frame for this header-block (or encode nothing if output buffer is too small). */
+static void s_encode_single_header_block_frame(
+    struct aws_h2_frame_headers *frame,
+    struct aws_h2_frame_encoder *encoder,
+    struct aws_byte_buf *output,
+    bool *waiting_for_more_space) {
+
+    struct aws_h2_header_block_frame_layout layout;
+    s_get_header_block_frame_layout(frame, &layout);
 
     /*
      * Figure out what size header-block fragment should go in this frame.
@@ -658,17 +798,17 @@ static void s_encode_single_header_block_frame(
     }
 
     size_t max_fragment;
-    if (aws_sub_size_checked(max_payload, payload_overhead, &max_fragment)) {
+    if (aws_sub_size_checked(max_payload, layout.payload_overhead, &max_fragment)) {
         goto handle_waiting_for_more_space;
     }
 
     const size_t fragment_len = aws_min_size(max_fragment, frame->header_block_cursor.len);
     if (fragment_len == frame->header_block_cursor.len) {
         /* This will finish the header-block */
-        flags |= AWS_H2_FRAME_F_END_HEADERS;
+        layout.flags |= AWS_H2_FRAME_F_END_HEADERS;
     } else {
         /* If we're not finishing the header-block, is it even worth trying to send this frame now? */
-        const size_t even_worth_sending_threshold = AWS_H2_FRAME_PREFIX_SIZE + payload_overhead;
+        const size_t even_worth_sending_threshold = AWS_H2_FRAME_PREFIX_SIZE + layout.payload_overhead;
         if (fragment_len < even_worth_sending_threshold) {
             goto handle_waiting_for_more_space;
         }
@@ -677,56 +817,23 @@ static void s_encode_single_header_block_frame(
     /*
      * Ok, it fits! Write the frame
      */
-    ENCODER_LOGF(
-        TRACE,
-        encoder,
-        "Encoding frame type=%s stream_id=%" PRIu32 "%s%s",
-        aws_h2_frame_type_to_str(frame_type),
-        frame->base.stream_id,
-        (flags & AWS_H2_FRAME_F_END_HEADERS) ? " END_HEADERS" : "",
-        (flags & AWS_H2_FRAME_F_END_STREAM) ? " END_STREAM" : "");
-
-    bool writes_ok = true;
-
-    /* Write the frame prefix */
-    const size_t payload_len = fragment_len + payload_overhead;
-    s_frame_prefix_encode(frame_type, frame->base.stream_id, payload_len, flags, output);
-
-    /* Write pad length */
-    if (flags & AWS_H2_FRAME_F_PADDED) {
-        AWS_ASSERT(frame_type != AWS_H2_FRAME_T_CONTINUATION);
-        writes_ok &= aws_byte_buf_write_u8(output, pad_length);
-    }
+    s_log_header_block_frame(frame, encoder, &layout);
 
-    /* Write priority */
-    if (flags & AWS_H2_FRAME_F_PRIORITY) {
-        AWS_ASSERT(frame_type == AWS_H2_FRAME_T_HEADERS);
-        s_frame_priority_settings_encode(priority_settings, output);
-    }
-
-    /* Write promised stream ID */
-    if (promised_stream_id) {
-        AWS_ASSERT(frame_type == AWS_H2_FRAME_T_PUSH_PROMISE);
-        writes_ok &= aws_byte_buf_write_be32(output, *promised_stream_id);
-    }
+    s_encode_header_block_frame_start(frame, &layout, fragment_len, output);
 
     /* Write header-block fragment */
     if (fragment_len > 0) {
         struct aws_byte_cursor fragment = aws_byte_cursor_advance(&frame->header_block_cursor, fragment_len);
-        writes_ok &= aws_byte_buf_write_from_whole_cursor(output, fragment);
-    }
-
-    /* Write padding */
-    if (flags & AWS_H2_FRAME_F_PADDED) {
-        writes_ok &= aws_byte_buf_write_u8_n(output, 0, pad_length);
+        bool writes_ok = aws_byte_buf_write_from_whole_cursor(output, fragment);
+        AWS_ASSERT(writes_ok);
+        (void)writes_ok;
     }
 
-    AWS_ASSERT(writes_ok);
-    (void)writes_ok;
+    s_encode_header_block_frame_end(frame, &layout, output);
 
     /* Success! Wrote entire frame. It's safe to change state now */
     frame->state =
-        flags & AWS_H2_FRAME_F_END_HEADERS ? AWS_H2_HEADERS_STATE_COMPLETE : AWS_H2_HEADERS_STATE_CONTINUATION;
+        layout.flags & AWS_H2_FRAME_F_END_HEADERS ? AWS_H2_HEADERS_STATE_COMPLETE : AWS_H2_HEADERS_STATE_CONTINUATION;
     *waiting_for_more_space = false;
     return;
 
@@ -748,20 +855,43 @@ static int s_frame_headers_encode(
 
     struct aws_h2_frame_headers *frame = AWS_CONTAINER_OF(frame_base, struct aws_h2_frame_headers, base);
 
-    /* Pre-encode the entire header-block into another buffer
-     * the first time we're called. */
     if (frame->state == AWS_H2_HEADERS_STATE_INIT) {
-        if (aws_hpack_encode_header_block(&encoder->hpack, frame->headers, &frame->whole_encoded_header_block)) {
+        const size_t max_block_length = aws_hpack_get_encoded_header_block_max_length(&encoder->hpack, frame->headers);
+
+        /* The common case: the header-block fits in a single frame in this message.
+         * Encode it straight into the output, no intermediate buffer or copy. */
+        if (s_header_block_fits_single_frame(frame, encoder, output->capacity - output->len, max_block_length)) {
+            if (s_encode_header_block_directly(frame, encoder, output, max_block_length)) {
+                goto hpack_error;
+            }
+            frame->state = AWS_H2_HEADERS_STATE_COMPLETE;
+            *complete = true;
+            return AWS_OP_SUCCESS;
+        }
+
+        /* It would fit in a single frame in the next message. Wait for that, rather than pre-encoding and splitting
+         * the header-block across messages. */
+        if (output->len > 0 && s_header_block_fits_single_frame(frame, encoder, output->capacity, max_block_length)) {
             ENCODER_LOGF(
-                ERROR,
+                TRACE,
                 encoder,
-                "Error doing HPACK encoding on %s of stream %" PRIu32 ": %s",
+                "Insufficient space to encode %s for stream %" PRIu32 " right now",
                 aws_h2_frame_type_to_str(frame->base.type),
-                frame->base.stream_id,
-                aws_error_name(aws_last_error()));
+                frame->base.stream_id);
+            *complete = false;
+            return AWS_OP_SUCCESS;
+        }
+
+        /* Otherwise, pre-encode the entire header-block into another buffer, to send in fragments.
+         * It's reserved at the max length up front, so it never grows. */
+        if (aws_byte_buf_init(&frame->whole_encoded_header_block, frame->base.alloc, max_block_length)) {
             goto error;
         }
 
+        if (aws_hpack_encode_header_block(&encoder->hpack, frame->headers, &frame->whole_encoded_header_block)) {
+            goto hpack_error;
+        }
+
         frame->header_block_cursor = aws_byte_cursor_from_buf(&frame->whole_encoded_header_block);
         frame->state = AWS_H2_HEADERS_STATE_FIRST_FRAME;
     }
@@ -776,6 +906,14 @@ static int s_frame_headers_encode(
     *complete = frame->state == AWS_H2_HEADERS_STATE_COMPLETE;
     return AWS_OP_SUCCESS;
 
+hpack_error:
+    ENCODER_LOGF(
+        ERROR,
+        encoder,
+        "Error doing HPACK encoding on %s of stream %" PRIu32 ": %s",
+        aws_h2_frame_type_to_str(frame->base.type),
+        frame->base.stream_id,
+        aws_error_name(aws_last_error()));
 error:
     return AWS_OP_ERR;
 }
@@ -7,6 +7,7 @@
 
 #include <aws/common/clock.h>
 #include <aws/http/private/h2_connection.h>
+#include <aws/http/private/rate_limiter_impl.h>
 #include <aws/http/private/strutil.h>
 #include <aws/http/status_code.h>
 #include <aws/io/channel.h>
@@ -32,12 +33,14 @@ static int s_stream_reset_stream_internal(
     struct aws_h2err stream_error,
     bool cancelling);
 static void s_stream_cancel(struct aws_http_stream *stream, int error_code);
+static int s_stream_notify_body_ready(struct aws_http_stream *stream_base);
 
 struct aws_http_stream_vtable s_h2_stream_vtable = {
     .destroy = s_stream_destroy,
     .update_window = s_stream_update_window,
     .activate = aws_h2_stream_activate,
     .cancel = s_stream_cancel,
+    .notify_body_ready = s_stream_notify_body_ready,
     .http1_write_chunk = NULL,
     .http2_reset_stream = s_stream_reset_stream,
     .http2_get_received_error_code = s_stream_get_received_error_code,
@@ -246,6 +249,8 @@ struct aws_h2_stream *aws_h2_stream_new_request(
     stream->base.on_incoming_headers = options->on_response_headers;
     stream->base.on_incoming_header_block_done = options->on_response_header_block_done;
     stream->base.on_incoming_body = options->on_response_body;
+    stream->base.on_incoming_body_vectored = options->on_response_body_vectored;
+    stream->base.on_incoming_body_retained = options->on_response_body_retained;
     stream->base.on_metrics = options->on_metrics;
     stream->base.on_complete = options->on_complete;
     stream->base.on_destroy = options->on_destroy;
@@ -259,6 +264,9 @@ struct aws_h2_stream *aws_h2_stream_new_request(
     stream->base.metrics.receiving_duration_ns = -1;
     aws_linked_list_init(&stream->thread_data.outgoing_writes);
     aws_linked_list_init(&stream->synced_data.pending_write_list);
+    /* No memory is acquired until body data arrives */
+    aws_array_list_init_dynamic(
+        &stream->thread_data.pending_body_slices, stream->base.alloc, 0, sizeof(struct aws_byte_cursor));
 
     /* Stream refcount starts at 1, and gets incremented again for the connection upon a call to activate() */
     aws_atomic_init_int(&stream->base.refcount, 1);
@@ -295,6 +303,7 @@ struct aws_h2_stream *aws_h2_stream_new_request(
     /* stream end is implicit if the request isn't using manual data writes */
     stream->synced_data.manual_write_ended = !options->http2_use_manual_data_writes;
     stream->manual_write = options->http2_use_manual_data_writes;
+    stream->use_body_ready_notifications = options->use_body_ready_notifications;
 
     /* if there's a request body to write, add it as the first outgoing write */
     struct aws_input_stream *body_stream = aws_http_message_get_body_stream(options->request);
@@ -317,6 +326,9 @@ struct aws_h2_stream *aws_h2_stream_new_request(
     }
     aws_channel_task_init(
         &stream->cross_thread_work_task, s_stream_cross_thread_work_task, stream, "HTTP/2 stream cross-thread work");
+
+    stream->base.send_rate_limiter = aws_http_rate_limiter_acquire(options->send_rate_limiter);
+    stream->base.receive_rate_limiter = aws_http_rate_limiter_acquire(options->receive_rate_limiter);
     return stream;
 error:
     s_stream_destroy(&stream->base);
@@ -343,6 +355,7 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
     /* Not sending window update at half closed remote state */
     bool ignore_window_update = (aws_h2_stream_get_state(stream) == AWS_H2_STREAM_STATE_HALF_CLOSED_REMOTE);
     bool reset_called;
+    bool body_ready_notified;
     size_t window_update_size;
     struct aws_h2err reset_error;
 
@@ -358,6 +371,8 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
         stream->synced_data.window_update_size = 0;
         reset_called = stream->synced_data.reset_called;
         reset_error = stream->synced_data.reset_error;
+        body_ready_notified = stream->synced_data.body_ready_notified;
+        stream->synced_data.body_ready_notified = false;
 
         /* copy out pending writes */
         aws_linked_list_swap_contents(&pending_writes, &stream->synced_data.pending_write_list);
@@ -365,16 +380,27 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
         s_unlock_synced_data(stream);
     } /* END CRITICAL SECTION */
 
-    if (window_update_size > 0 && !ignore_window_update) {
-        if (s_stream_send_update_window_frame(stream, window_update_size)) {
+    if (window_update_size > 0 && !ignore_window_update && stream->base.receive_rate_limiter) {
+        /* Paced, the window grows as the WINDOW_UPDATEs actually go out */
+        stream->thread_data.window_update_deferred =
+            aws_add_size_saturating(stream->thread_data.window_update_deferred, window_update_size);
+        if (aws_h2_stream_send_deferred_window_update(stream)) {
             /* Treat this as a connection error */
             aws_h2_connection_shutdown_due_to_write_err(connection, aws_last_error());
         }
-    }
+    } else {
+        if (window_update_size > 0 && !ignore_window_update) {
+            if (s_stream_send_update_window_frame(stream, window_update_size)) {
+                /* Treat this as a connection error */
+                aws_h2_connection_shutdown_due_to_write_err(connection, aws_last_error());
+            }
+        }
 
-    /* The largest legal value will be 2 * max window size, which is way less than INT64_MAX, so if the window_size_self
-     * overflows, remote peer will find it out. So just apply the change and ignore the possible overflow.*/
-    stream->thread_data.window_size_self += window_update_size;
+        /* The largest legal value will be 2 * max window size, which is way less than INT64_MAX, so if the
+         * window_size_self overflows, remote peer will find it out. So just apply the change and ignore the possible
+         * overflow.*/
+        stream->thread_data.window_size_self += window_update_size;
+    }
 
     if (reset_called) {
         struct aws_h2err returned_h2err = s_send_rst_and_close_stream(stream, reset_error);
@@ -383,11 +409,17 @@ static void s_stream_cross_thread_work_task(struct aws_channel_task *task, void
         }
     }
 
-    if (stream->thread_data.waiting_for_writes && !aws_linked_list_empty(&pending_writes)) {
-        /* Got more to write, move the stream back to outgoing list */
+    /* A parked stream wakes when it gets more to write, or when the body it's parked on has data ready.
+     * A manual-write stream may be parked on a write's body, and a new write must wake it too. */
+    bool is_parked = stream->thread_data.waiting_for_writes || stream->thread_data.waiting_for_body_ready;
+    bool has_new_writes = !aws_linked_list_empty(&pending_writes);
+    bool has_body_ready = stream->thread_data.waiting_for_body_ready && body_ready_notified;
+    if (is_parked && (has_new_writes || has_body_ready)) {
+        /* Move the stream back to outgoing list */
         aws_linked_list_remove(&stream->node);
         aws_linked_list_push_back(&connection->thread_data.outgoing_streams_list, &stream->node);
         stream->thread_data.waiting_for_writes = false;
+        stream->thread_data.waiting_for_body_ready = false;
     }
     /* move any pending writes to the outgoing write queue */
     aws_linked_list_move_all_back(&stream->thread_data.outgoing_writes, &pending_writes);
@@ -443,6 +475,9 @@ static void s_stream_destroy(struct aws_http_stream *stream_base) {
     AWS_H2_STREAM_LOG(DEBUG, stream, "Destroying stream");
     aws_mutex_clean_up(&stream->synced_data.lock);
     aws_http_message_release(stream->thread_data.outgoing_message);
+    aws_array_list_clean_up(&stream->thread_data.pending_body_slices);
+    aws_http_rate_limiter_release(stream->base.send_rate_limiter);
+    aws_http_rate_limiter_release(stream->base.receive_rate_limiter);
 
     aws_mem_release(stream->base.alloc, stream);
 }
@@ -458,6 +493,10 @@ void aws_h2_stream_complete(struct aws_h2_stream *stream, int error_code) {
 
     s_h2_stream_destroy_pending_writes(stream);
 
+    /* Any body data not yet delivered points into a message that's about to be released */
+    aws_array_list_clear(&stream->thread_data.pending_body_slices);
+    stream->thread_data.pending_body_window_update = 0;
+
     /* Invoke callback */
     if (stream->base.on_metrics) {
         stream->base.on_metrics(&stream->base, &stream->base.metrics, stream->base.user_data);
@@ -727,6 +766,15 @@ int aws_h2_stream_on_activated(struct aws_h2_stream *stream, enum aws_h2_stream_
 
     struct aws_http_headers *h2_headers = aws_http_message_get_headers(msg);
 
+    /* RFC-8441 3: A sender MUST NOT send a :protocol pseudo-header (extended CONNECT)
+     * unless the peer has sent SETTINGS_ENABLE_CONNECT_PROTOCOL with a value of 1 */
+    if (!connection->thread_data.settings_peer[AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL] &&
+        aws_http_headers_has(h2_headers, aws_http_header_protocol)) {
+        AWS_H2_STREAM_LOG(ERROR, stream, "Cannot send extended CONNECT, peer has not enabled the CONNECT protocol");
+        aws_raise_error(AWS_ERROR_HTTP_EXTENDED_CONNECT_NOT_ENABLED);
+        goto error;
+    }
+
     struct aws_h2_frame *headers_frame = aws_h2_frame_new_headers(
         stream->base.alloc,
         stream->base.id,
@@ -779,6 +827,27 @@ error:
     return AWS_OP_ERR;
 }
 
+void aws_h2_stream_on_activated_by_upgrade(struct aws_h2_stream *stream) {
+    AWS_PRECONDITION_ON_CHANNEL_THREAD(stream);
+
+    struct aws_h2_connection *connection = s_get_h2_connection(stream);
+
+    /* The request already went out as HTTP/1.1, including any body, so there's nothing left to send */
+    aws_high_res_clock_get_ticks((uint64_t *)&stream->base.metrics.send_start_timestamp_ns);
+    stream->base.metrics.send_end_timestamp_ns = stream->base.metrics.send_start_timestamp_ns;
+    stream->base.metrics.sending_duration_ns = 0;
+
+    /* Initialize the flow-control window size */
+    stream->thread_data.window_size_peer =
+        connection->thread_data.settings_peer[AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE];
+    stream->thread_data.window_size_self =
+        connection->thread_data.settings_self[AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE];
+
+    /* RFC-7540 3.2: Stream 1 is implicitly "half-closed" from the client toward the server */
+    stream->thread_data.state = AWS_H2_STREAM_STATE_HALF_CLOSED_LOCAL;
+    AWS_H2_STREAM_LOG(TRACE, stream, "Request sent as HTTP/1.1 before upgrade. State -> HALF_CLOSED_LOCAL");
+}
+
 int aws_h2_stream_encode_data_frame(
     struct aws_h2_stream *stream,
     struct aws_h2_frame_encoder *encoder,
@@ -805,18 +874,58 @@ int aws_h2_stream_encode_data_frame(
     bool input_stream_complete = false;
     bool input_stream_stalled = false;
     bool ends_stream = s_h2_stream_does_current_write_end_stream(stream);
-    if (aws_h2_encode_data_frame(
-            encoder,
-            stream->base.id,
-            input_stream,
-            ends_stream,
-            0 /*pad_length*/,
-            &stream->thread_data.window_size_peer,
-            &connection->thread_data.window_size_peer,
-            output,
-            &input_stream_complete,
-            &input_stream_stalled)) {
+    size_t prev_output_len = output->len;
+
+    /* If there are send rate limiters, encode against windows no larger than what they allow,
+     * then charge the real windows for what was actually sent */
+    struct aws_http_rate_limiter *connection_limiter = connection->base.send_rate_limiter;
+    struct aws_http_rate_limiter *stream_limiter = stream->base.send_rate_limiter;
+    const bool is_rate_limited = connection_limiter || stream_limiter;
+    int32_t *stream_window = &stream->thread_data.window_size_peer;
+    size_t *connection_window = &connection->thread_data.window_size_peer;
+    int32_t limited_stream_window = 0;
+    size_t limited_connection_window = 0;
+    size_t send_allowance = 0;
+    if (is_rate_limited) {
+        uint64_t now_ns = 0;
+        aws_channel_current_clock_time(stream->base.owning_connection->channel_slot->channel, &now_ns);
+        send_allowance = aws_http_rate_limiter_take_both(
+            connection_limiter,
+            stream_limiter,
+            now_ns,
+            AWS_HTTP_RATE_LIMITER_MIN_GRANT,
+            aws_min_size((size_t)*stream_window, *connection_window));
+        if (send_allowance == 0) {
+            *data_encode_status = AWS_H2_DATA_ENCODE_ONGOING_RATE_LIMITED;
+            return AWS_OP_SUCCESS;
+        }
+
+        limited_stream_window = (int32_t)send_allowance;
+        limited_connection_window = send_allowance;
+        stream_window = &limited_stream_window;
+        connection_window = &limited_connection_window;
+    }
 
+    int encode_err = aws_h2_encode_data_frame(
+        encoder,
+        stream->base.id,
+        input_stream,
+        ends_stream,
+        0 /*pad_length*/,
+        stream_window,
+        connection_window,
+        output,
+        &input_stream_complete,
+        &input_stream_stalled);
+
+    if (is_rate_limited) {
+        const size_t payload_sent = send_allowance - limited_connection_window;
+        stream->thread_data.window_size_peer -= (int32_t)payload_sent;
+        connection->thread_data.window_size_peer -= payload_sent;
+        aws_http_rate_limiter_give_back_both(connection_limiter, stream_limiter, limited_connection_window);
+    }
+
+    if (encode_err) {
         /* Failed to write DATA, treat it as a Stream Error */
         AWS_H2_STREAM_LOGF(ERROR, stream, "Error encoding stream DATA, %s", aws_error_name(aws_last_error()));
         struct aws_h2err returned_h2err = s_send_rst_and_close_stream(stream, aws_h2err_from_last_error());
@@ -861,6 +970,10 @@ int aws_h2_stream_encode_data_frame(
         if (input_stream_stalled) {
             AWS_ASSERT(!input_stream_complete);
             *data_encode_status = AWS_H2_DATA_ENCODE_ONGOING_BODY_STREAM_STALLED;
+            if (stream->use_body_ready_notifications && output->len == prev_output_len) {
+                /* body had no data ready, sleep until user notifies us instead of polling it every tick */
+                *data_encode_status = AWS_H2_DATA_ENCODE_ONGOING_WAITING_FOR_BODY;
+            }
         }
         if (stream->thread_data.window_size_peer <= AWS_H2_MIN_WINDOW_SIZE) {
             /* if body and window both stalled, we take the window stalled status, which will take the stream out
@@ -1042,6 +1155,13 @@ struct aws_h2err aws_h2_stream_on_decoder_push_promise(struct aws_h2_stream *str
 }
 
 static int s_stream_send_update_window(struct aws_h2_stream *stream, uint32_t window_size) {
+    if (stream->base.receive_rate_limiter) {
+        /* Pace it, so the peer can't send faster than the limiter allows */
+        stream->thread_data.window_update_deferred =
+            aws_add_size_saturating(stream->thread_data.window_update_deferred, window_size);
+        return aws_h2_stream_send_deferred_window_update(stream);
+    }
+
     struct aws_h2_frame *stream_window_update_frame =
         aws_h2_frame_new_window_update(stream->base.alloc, stream->base.id, window_size);
     if (!stream_window_update_frame) {
@@ -1058,6 +1178,50 @@ static int s_stream_send_update_window(struct aws_h2_stream *stream, uint32_t wi
     return AWS_OP_SUCCESS;
 }
 
+int aws_h2_stream_send_deferred_window_update(struct aws_h2_stream *stream) {
+    AWS_PRECONDITION_ON_CHANNEL_THREAD(stream);
+    AWS_PRECONDITION(stream->base.receive_rate_limiter);
+
+    if (stream->thread_data.window_update_deferred == 0 ||
+        stream->thread_data.state == AWS_H2_STREAM_STATE_CLOSED ||
+        stream->thread_data.state == AWS_H2_STREAM_STATE_HALF_CLOSED_REMOTE) {
+        /* Nothing owed, or the peer won't send any more DATA to use it */
+        stream->thread_data.window_update_deferred = 0;
+        return AWS_OP_SUCCESS;
+    }
+
+    struct aws_h2_connection *connection = s_get_h2_connection(stream);
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(stream->base.owning_connection->channel_slot->channel, &now_ns);
+
+    const size_t owed = aws_min_size(stream->thread_data.window_update_deferred, AWS_H2_WINDOW_UPDATE_MAX);
+    const size_t granted = aws_http_rate_limiter_take(
+        stream->base.receive_rate_limiter, now_ns, aws_min_size(owed, AWS_HTTP_RATE_LIMITER_MIN_GRANT), owed);
+    if (granted > 0) {
+        if (s_stream_send_update_window_frame(stream, granted)) {
+            aws_http_rate_limiter_give_back(stream->base.receive_rate_limiter, granted);
+            return AWS_OP_ERR;
+        }
+        stream->thread_data.window_size_self += granted;
+        stream->thread_data.window_update_deferred -= granted;
+    }
+
+    if (stream->thread_data.window_update_deferred > 0) {
+        const uint64_t wait_ns = aws_http_rate_limiter_time_until(
+            stream->base.receive_rate_limiter,
+            now_ns,
+            aws_min_size(stream->thread_data.window_update_deferred, AWS_HTTP_RATE_LIMITER_MIN_GRANT));
+        AWS_H2_STREAM_LOGF(
+            TRACE,
+            stream,
+            "Receive rate limit is delaying stream WINDOW_UPDATE of %zu.",
+            stream->thread_data.window_update_deferred);
+        aws_h2_connection_on_stream_window_update_deferred(connection, stream, wait_ns);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 struct aws_h2err aws_h2_stream_on_decoder_data_begin(
     struct aws_h2_stream *stream,
     uint32_t payload_len,
@@ -1124,7 +1288,12 @@ struct aws_h2err aws_h2_stream_on_decoder_data_begin(
             auto_window_update = payload_len;
         }
 
-        if (auto_window_update != 0) {
+        if (auto_window_update != 0 && stream->base.on_incoming_body_vectored &&
+            !stream->base.on_incoming_body_retained) {
+            /* Send one WINDOW_UPDATE when the gathered body is flushed, rather than one per DATA frame */
+            stream->thread_data.pending_body_window_update += auto_window_update;
+            aws_h2_connection_on_stream_pending_body(s_get_h2_connection(stream), stream);
+        } else if (auto_window_update != 0) {
             if (s_stream_send_update_window(stream, auto_window_update)) {
                 return aws_h2err_from_last_error();
             }
@@ -1146,7 +1315,29 @@ struct aws_h2err aws_h2_stream_on_decoder_data_i(struct aws_h2_stream *stream, s
     /* Not calling s_check_state_allows_frame_type() here because we already checked at start of DATA frame in
      * aws_h2_stream_on_decoder_data_begin() */
 
-    if (stream->base.on_incoming_body) {
+    if (stream->base.on_incoming_body_retained) {
+        /* Hand over a reference to the message the data points into, rather than the data alone */
+        if (data.len > 0) {
+            struct aws_http_retained_body *retained_body =
+                aws_h2_connection_retain_incoming_body(s_get_h2_connection(stream), data.len);
+            if (!retained_body) {
+                return s_send_rst_and_close_stream(stream, aws_h2err_from_last_error());
+            }
+            if (stream->base.on_incoming_body_retained(&stream->base, retained_body, &data, stream->base.user_data)) {
+                AWS_H2_STREAM_LOGF(
+                    ERROR, stream, "Incoming body callback raised error, %s", aws_error_name(aws_last_error()));
+                return s_send_rst_and_close_stream(stream, aws_h2err_from_last_error());
+            }
+        }
+    } else if (stream->base.on_incoming_body_vectored) {
+        /* Gather it up, the connection calls aws_h2_stream_flush_pending_body() when it's done with the message */
+        if (data.len > 0) {
+            if (aws_array_list_push_back(&stream->thread_data.pending_body_slices, &data)) {
+                return s_send_rst_and_close_stream(stream, aws_h2err_from_last_error());
+            }
+            aws_h2_connection_on_stream_pending_body(s_get_h2_connection(stream), stream);
+        }
+    } else if (stream->base.on_incoming_body) {
         if (stream->base.on_incoming_body(&stream->base, &data, stream->base.user_data)) {
             AWS_H2_STREAM_LOGF(
                 ERROR, stream, "Incoming body callback raised error, %s", aws_error_name(aws_last_error()));
@@ -1157,6 +1348,35 @@ struct aws_h2err aws_h2_stream_on_decoder_data_i(struct aws_h2_stream *stream, s
     return AWS_H2ERR_SUCCESS;
 }
 
+struct aws_h2err aws_h2_stream_flush_pending_body(struct aws_h2_stream *stream) {
+    AWS_PRECONDITION_ON_CHANNEL_THREAD(stream);
+
+    size_t num_slices = aws_array_list_length(&stream->thread_data.pending_body_slices);
+    if (num_slices > 0) {
+        AWS_H2_STREAM_LOGF(TRACE, stream, "Delivering %zu incoming body slices.", num_slices);
+        int err = stream->base.on_incoming_body_vectored(
+            &stream->base, stream->thread_data.pending_body_slices.data, num_slices, stream->base.user_data);
+        aws_array_list_clear(&stream->thread_data.pending_body_slices);
+        if (err) {
+            AWS_H2_STREAM_LOGF(
+                ERROR, stream, "Incoming body callback raised error, %s", aws_error_name(aws_last_error()));
+            stream->thread_data.pending_body_window_update = 0;
+            return s_send_rst_and_close_stream(stream, aws_h2err_from_last_error());
+        }
+    }
+
+    uint32_t window_update = stream->thread_data.pending_body_window_update;
+    stream->thread_data.pending_body_window_update = 0;
+    if (window_update > 0 && stream->thread_data.state != AWS_H2_STREAM_STATE_CLOSED) {
+        if (s_stream_send_update_window(stream, window_update)) {
+            return aws_h2err_from_last_error();
+        }
+        AWS_H2_STREAM_LOGF(TRACE, stream, "Automatically updating stream window by %" PRIu32 ".", window_update);
+    }
+
+    return AWS_H2ERR_SUCCESS;
+}
+
 struct aws_h2err aws_h2_stream_on_decoder_window_update(
     struct aws_h2_stream *stream,
     uint32_t window_size_increment,
@@ -1302,6 +1522,40 @@ struct aws_h2err aws_h2_stream_on_decoder_rst_stream(struct aws_h2_stream *strea
     return AWS_H2ERR_SUCCESS;
 }
 
+static int s_stream_notify_body_ready(struct aws_http_stream *stream_base) {
+    struct aws_h2_stream *stream = AWS_CONTAINER_OF(stream_base, struct aws_h2_stream, base);
+    if (!stream->use_body_ready_notifications) {
+        AWS_H2_STREAM_LOG(
+            ERROR,
+            stream,
+            "Body ready notifications are not enabled. You need to enable them by setting "
+            "'use_body_ready_notifications' to true in 'aws_http_make_request_options'");
+        return aws_raise_error(AWS_ERROR_INVALID_STATE);
+    }
+    struct aws_h2_connection *connection = s_get_h2_connection(stream);
+
+    bool schedule_cross_thread_work = false;
+    { /* BEGIN CRITICAL SECTION */
+        s_lock_synced_data(stream);
+        /* Don't alert the connection unless the stream is active */
+        if (stream->synced_data.api_state == AWS_H2_STREAM_API_STATE_ACTIVE) {
+            stream->synced_data.body_ready_notified = true;
+            schedule_cross_thread_work = !stream->synced_data.is_cross_thread_work_task_scheduled;
+            stream->synced_data.is_cross_thread_work_task_scheduled = true;
+        }
+        s_unlock_synced_data(stream);
+    } /* END CRITICAL SECTION */
+
+    if (schedule_cross_thread_work) {
+        AWS_H2_STREAM_LOG(TRACE, stream, "Scheduling stream cross-thread work task");
+        /* increment the refcount of stream to keep it alive until the task runs */
+        aws_atomic_fetch_add(&stream->base.refcount, 1);
+        aws_channel_schedule_task_now(connection->base.channel_slot->channel, &stream->cross_thread_work_task);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 static int s_stream_write_data(
     struct aws_http_stream *stream_base,
     const struct aws_http2_stream_write_data_options *options) {
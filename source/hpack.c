@@ -36,76 +36,113 @@ struct aws_http_header s_static_header_table[] = {
 };
 static const size_t s_static_header_table_size = AWS_ARRAY_SIZE(s_static_header_table);
 
-struct aws_byte_cursor s_static_header_table_name_only[] = {
-#define HEADER(_index, _name) [_index] = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(_name),
-#define HEADER_WITH_VALUE(_index, _name, _value) HEADER(_index, _name)
-
-#include <aws/http/private/hpack_header_static_table.def>
-
-#undef HEADER
-#undef HEADER_WITH_VALUE
+/**
+ * Index of each distinct name in the static table, sorted by name length, for name -> index lookup.
+ * Where a name appears more than once, this is its lowest index, and the rest follow it in the static table.
+ * Precomputed from hpack_header_static_table.def, so lookups need no initialization, allocation, or hashing.
+ */
+static const uint8_t s_static_header_names_by_length[] = {
+    21 /* age */,
+    60 /* via */,
+    33 /* date */,
+    34 /* etag */,
+    37 /* from */,
+    38 /* host */,
+    45 /* link */,
+    59 /* vary */,
+    4 /* :path */,
+    22 /* allow */,
+    50 /* range */,
+    19 /* accept */,
+    32 /* cookie */,
+    35 /* expect */,
+    54 /* server */,
+    2 /* :method */,
+    6 /* :scheme */,
+    8 /* :status */,
+    36 /* expires */,
+    51 /* referer */,
+    52 /* refresh */,
+    39 /* if-match */,
+    42 /* if-range */,
+    46 /* location */,
+    1 /* :authority */,
+    55 /* set-cookie */,
+    58 /* user-agent */,
+    53 /* retry-after */,
+    31 /* content-type */,
+    47 /* max-forwards */,
+    18 /* accept-ranges */,
+    23 /* authorization */,
+    24 /* cache-control */,
+    30 /* content-range */,
+    41 /* if-none-match */,
+    44 /* last-modified */,
+    15 /* accept-charset */,
+    28 /* content-length */,
+    16 /* accept-encoding */,
+    17 /* accept-language */,
+    26 /* content-encoding */,
+    27 /* content-language */,
+    29 /* content-location */,
+    61 /* www-authenticate */,
+    40 /* if-modified-since */,
+    57 /* transfer-encoding */,
+    48 /* proxy-authenticate */,
+    25 /* content-disposition */,
+    43 /* if-unmodified-since */,
+    49 /* proxy-authorization */,
+    56 /* strict-transport-security */,
+    20 /* access-control-allow-origin */,
 };
 
-/* aws_http_header * -> size_t */
-static struct aws_hash_table s_static_header_reverse_lookup;
-/* aws_byte_cursor * -> size_t */
-static struct aws_hash_table s_static_header_reverse_lookup_name_only;
-
-static uint64_t s_header_hash(const void *key) {
-    const struct aws_http_header *header = key;
-
-    return aws_hash_combine(aws_hash_byte_cursor_ptr(&header->name), aws_hash_byte_cursor_ptr(&header->value));
-}
-
-static bool s_header_eq(const void *a, const void *b) {
-    const struct aws_http_header *left = a;
-    const struct aws_http_header *right = b;
-
-    if (!aws_byte_cursor_eq(&left->name, &right->name)) {
-        return false;
+/* Returns lowest static table index with this name, or 0 if not found */
+static size_t s_static_table_find_name(struct aws_byte_cursor name) {
+    const size_t count = AWS_ARRAY_SIZE(s_static_header_names_by_length);
+
+    /* Binary search to the first name of the same length, then compare only names of that length */
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (s_static_header_table[s_static_header_names_by_length[mid]].name.len < name.len) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
 
-    /* If the header stored in the table doesn't have a value, then it's a match */
-    return aws_byte_cursor_eq(&left->value, &right->value);
+    for (size_t i = lo; i < count; ++i) {
+        const size_t index = s_static_header_names_by_length[i];
+        const struct aws_byte_cursor *static_name = &s_static_header_table[index].name;
+        if (static_name->len != name.len) {
+            break;
+        }
+        if (aws_byte_cursor_eq(static_name, &name)) {
+            return index;
+        }
+    }
+    return 0;
 }
 
-void aws_hpack_static_table_init(struct aws_allocator *allocator) {
-
-    int result = aws_hash_table_init(
-        &s_static_header_reverse_lookup,
-        allocator,
-        s_static_header_table_size - 1,
-        s_header_hash,
-        s_header_eq,
-        NULL,
-        NULL);
-    AWS_FATAL_ASSERT(AWS_OP_SUCCESS == result);
-
-    result = aws_hash_table_init(
-        &s_static_header_reverse_lookup_name_only,
-        allocator,
-        s_static_header_table_size - 1,
-        aws_hash_byte_cursor_ptr,
-        (aws_hash_callback_eq_fn *)aws_byte_cursor_eq,
-        NULL,
-        NULL);
-    AWS_FATAL_ASSERT(AWS_OP_SUCCESS == result);
-
-    /* Process in reverse so that name_only prefers lower indices */
-    for (size_t i = s_static_header_table_size - 1; i > 0; --i) {
-        /* the tables are created as 1-based indexing */
-        result = aws_hash_table_put(&s_static_header_reverse_lookup, &s_static_header_table[i], (void *)i, NULL);
-        AWS_FATAL_ASSERT(AWS_OP_SUCCESS == result);
-
-        result = aws_hash_table_put(
-            &s_static_header_reverse_lookup_name_only, &s_static_header_table_name_only[i], (void *)(i), NULL);
-        AWS_FATAL_ASSERT(AWS_OP_SUCCESS == result);
+/* Returns static table index with this name and value, or 0 if not found */
+static size_t s_static_table_find_header(const struct aws_http_header *header) {
+    size_t index = s_static_table_find_name(header->name);
+    if (index == 0) {
+        return 0;
     }
-}
 
-void aws_hpack_static_table_clean_up(void) {
-    aws_hash_table_clean_up(&s_static_header_reverse_lookup);
-    aws_hash_table_clean_up(&s_static_header_reverse_lookup_name_only);
+    /* Entries with the same name are adjacent */
+    for (; index < s_static_header_table_size; ++index) {
+        const struct aws_http_header *static_header = &s_static_header_table[index];
+        if (!aws_byte_cursor_eq(&static_header->name, &header->name)) {
+            break;
+        }
+        if (aws_byte_cursor_eq(&static_header->value, &header->value)) {
+            return index;
+        }
+    }
+    return 0;
 }
 
 #define HPACK_LOGF(level, hpack, text, ...)                                                                            \
@@ -220,12 +257,12 @@ size_t aws_hpack_find_index(
     struct aws_hash_element *elem = NULL;
     if (search_value) {
         /* Check name-and-value first in static table */
-        aws_hash_table_find(&s_static_header_reverse_lookup, header, &elem);
-        if (elem) {
+        size_t static_index = s_static_table_find_header(header);
+        if (static_index) {
             /* TODO: Maybe always set found_value to true? Who cares that the value is empty if they matched? */
             /* If an element was found, check if it has a value */
-            *found_value = ((const struct aws_http_header *)elem->key)->value.len;
-            return (size_t)elem->value;
+            *found_value = s_static_header_table[static_index].value.len;
+            return static_index;
         }
         /* Check name-and-value in dynamic table */
         aws_hash_table_find(&context->dynamic_table.reverse_lookup, header, &elem);
@@ -237,9 +274,9 @@ size_t aws_hpack_find_index(
     }
     /* Check the name-only table. Note, even if we search for value, when we fail in searching for name-and-value, we
      * should also check the name only table */
-    aws_hash_table_find(&s_static_header_reverse_lookup_name_only, &header->name, &elem);
-    if (elem) {
-        return (size_t)elem->value;
+    size_t static_name_index = s_static_table_find_name(header->name);
+    if (static_name_index) {
+        return static_name_index;
     }
     aws_hash_table_find(&context->dynamic_table.reverse_lookup_name_only, &header->name, &elem);
     if (elem) {
@@ -269,6 +306,7 @@ static int s_dynamic_table_shrink(struct aws_hpack_context *context, size_t max_
         /* "Remove" the header from the table */
         context->dynamic_table.size -= aws_hpack_get_header_size(back);
         context->dynamic_table.num_elements -= 1;
+        context->dynamic_table.generation++;
 
         /* Remove old header from hash tables */
         if (aws_hash_table_remove(&context->dynamic_table.reverse_lookup, back, NULL, NULL)) {
@@ -304,23 +342,25 @@ error:
  */
 static int s_dynamic_table_resize_buffer(struct aws_hpack_context *context, size_t new_max_elements) {
 
+    struct aws_http_header *new_buffer = NULL;
+
+    if (AWS_LIKELY(new_max_elements > 0)) {
+        /* Allocate the new buffer */
+        new_buffer = aws_mem_calloc(context->allocator, new_max_elements, sizeof(struct aws_http_header));
+        if (!new_buffer) {
+            return AWS_OP_ERR;
+        }
+    }
+
     /* Clear the old hash tables */
     aws_hash_table_clear(&context->dynamic_table.reverse_lookup);
     aws_hash_table_clear(&context->dynamic_table.reverse_lookup_name_only);
 
-    struct aws_http_header *new_buffer = NULL;
-
     if (AWS_UNLIKELY(new_max_elements == 0)) {
         /* If new buffer is of size 0, don't both initializing, just clean up the old one. */
         goto cleanup_old_buffer;
     }
 
-    /* Allocate the new buffer */
-    new_buffer = aws_mem_calloc(context->allocator, new_max_elements, sizeof(struct aws_http_header));
-    if (!new_buffer) {
-        return AWS_OP_ERR;
-    }
-
     /* Don't bother copying data if old buffer was of size 0 */
     if (AWS_UNLIKELY(context->dynamic_table.num_elements == 0)) {
         goto reset_dyn_table_state;
@@ -418,11 +458,11 @@ int aws_hpack_insert_header(struct aws_hpack_context *context, const struct aws_
 
     /* If we're out of space in the buffer, grow it */
     if (context->dynamic_table.num_elements == context->dynamic_table.buffer_capacity) {
-        /* If the buffer is currently of 0 size, reset it back to its initial size */
-        const size_t new_size =
-            context->dynamic_table.buffer_capacity
-                ? (size_t)(context->dynamic_table.buffer_capacity * s_hpack_dynamic_table_buffer_growth_rate)
-                : s_hpack_dynamic_table_initial_elements;
+        /* Never grow to less than the initial size. The buffer may have been trimmed down to a handful of elements
+         * (or 0), and the growth rate alone wouldn't make progress from a capacity of 1 */
+        const size_t new_size = aws_max_size(
+            (size_t)(context->dynamic_table.buffer_capacity * s_hpack_dynamic_table_buffer_growth_rate),
+            s_hpack_dynamic_table_initial_elements);
 
         if (s_dynamic_table_resize_buffer(context, new_size)) {
             goto error;
@@ -438,6 +478,7 @@ int aws_hpack_insert_header(struct aws_hpack_context *context, const struct aws_
 
     /* Increment num_elements */
     context->dynamic_table.num_elements++;
+    context->dynamic_table.generation++;
     /* Increment the size */
     context->dynamic_table.size += header_size;
 
@@ -486,6 +527,23 @@ error:
     return AWS_OP_ERR;
 }
 
+int aws_hpack_context_trim(struct aws_hpack_context *context) {
+    /* The entries themselves are shared state with the peer and must stay, only the spare slots can go.
+     * If the table is empty, the buffer is dropped entirely and re-grown on the next insert. */
+    if (context->dynamic_table.buffer_capacity == context->dynamic_table.num_elements) {
+        return AWS_OP_SUCCESS;
+    }
+
+    return s_dynamic_table_resize_buffer(context, context->dynamic_table.num_elements);
+}
+
+size_t aws_hpack_context_get_resident_bytes(const struct aws_hpack_context *context) {
+    /* Entry strings are allocated exactly, so their footprint is the table size minus the 32 bytes of
+     * per-entry overhead that RFC-7541 4.1 counts. Hash table storage isn't included. */
+    return context->dynamic_table.buffer_capacity * sizeof(struct aws_http_header) + context->dynamic_table.size -
+           context->dynamic_table.num_elements * 32;
+}
+
 int aws_hpack_resize_dynamic_table(struct aws_hpack_context *context, size_t new_max_size) {
 
     /* Nothing to see here! */
@@ -517,6 +575,7 @@ int aws_hpack_resize_dynamic_table(struct aws_hpack_context *context, size_t new
 
     /* Update the max size */
     context->dynamic_table.max_size = new_max_size;
+    context->dynamic_table.generation++;
 
     return AWS_OP_SUCCESS;
 
@@ -33,6 +33,23 @@ void aws_hpack_decoder_clean_up(struct aws_hpack_decoder *decoder) {
     AWS_ZERO_STRUCT(*decoder);
 }
 
+int aws_hpack_decoder_trim(struct aws_hpack_decoder *decoder) {
+    /* Scratch can only go between entries, while it's not holding a partially decoded name or value */
+    if (decoder->progress_entry.state == HPACK_ENTRY_STATE_INIT &&
+        decoder->progress_entry.scratch.capacity > s_hpack_decoder_scratch_initial_size) {
+
+        struct aws_allocator *allocator = decoder->progress_entry.scratch.allocator;
+        aws_byte_buf_clean_up(&decoder->progress_entry.scratch);
+        aws_byte_buf_init(&decoder->progress_entry.scratch, allocator, 0);
+    }
+
+    return aws_hpack_context_trim(&decoder->context);
+}
+
+size_t aws_hpack_decoder_get_resident_bytes(const struct aws_hpack_decoder *decoder) {
+    return decoder->progress_entry.scratch.capacity + aws_hpack_context_get_resident_bytes(&decoder->context);
+}
+
 static const struct aws_http_header *s_get_header_u64(const struct aws_hpack_decoder *decoder, uint64_t index) {
     if (index > SIZE_MAX) {
         HPACK_LOG(ERROR, decoder, "Header index is absurdly large");
@@ -130,6 +147,81 @@ handle_complete:
     return AWS_OP_SUCCESS;
 }
 
+/* Decode the string's Huffman bit and length. Once complete, the string is in the VALUE state. */
+static int s_decode_string_length(
+    struct aws_hpack_decoder *decoder,
+    struct aws_byte_cursor *to_decode,
+    bool *complete) {
+
+    struct hpack_progress_string *progress = &decoder->progress_string;
+    *complete = false;
+
+    if (progress->state == HPACK_STRING_STATE_INIT) {
+        if (to_decode->len == 0) {
+            return AWS_OP_SUCCESS;
+        }
+
+        /* Do init stuff */
+        progress->state = HPACK_STRING_STATE_LENGTH;
+        progress->use_huffman = *to_decode->ptr >> 7;
+        aws_huffman_decoder_reset(&decoder->huffman_decoder);
+    }
+
+    AWS_ASSERT(progress->state == HPACK_STRING_STATE_LENGTH);
+    if (aws_hpack_decode_integer(decoder, to_decode, 7, &progress->length, complete)) {
+        return AWS_OP_ERR;
+    }
+
+    if (!*complete) {
+        return AWS_OP_SUCCESS;
+    }
+
+    if (progress->length > SIZE_MAX) {
+        return aws_raise_error(AWS_ERROR_OVERFLOW_DETECTED);
+    }
+
+    progress->state = HPACK_STRING_STATE_VALUE;
+    return AWS_OP_SUCCESS;
+}
+
+/*
+ * Try to decode a string without copying it.
+ * If the string isn't Huffman-encoded, and all its data is in to_decode once the length is known,
+ * *out_string references it right there in to_decode's memory.
+ * Otherwise *out_in_place is false, and the string must be finished with aws_hpack_decode_string().
+ * The decision is made when the length finishes decoding. Once data goes into an output buffer, the rest follows.
+ */
+static int s_try_decode_string_in_place(
+    struct aws_hpack_decoder *decoder,
+    struct aws_byte_cursor *to_decode,
+    struct aws_byte_cursor *out_string,
+    bool *out_in_place) {
+
+    struct hpack_progress_string *progress = &decoder->progress_string;
+    *out_in_place = false;
+
+    if (progress->state == HPACK_STRING_STATE_VALUE) {
+        return AWS_OP_SUCCESS;
+    }
+
+    bool length_complete = false;
+    if (s_decode_string_length(decoder, to_decode, &length_complete)) {
+        return AWS_OP_ERR;
+    }
+
+    if (!length_complete) {
+        return AWS_OP_SUCCESS;
+    }
+
+    if (progress->length == 0 || (!progress->use_huffman && progress->length <= to_decode->len)) {
+        *out_string = aws_byte_cursor_advance(to_decode, (size_t)progress->length);
+        *out_in_place = true;
+        AWS_ZERO_STRUCT(decoder->progress_string);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 int aws_hpack_decode_string(
     struct aws_hpack_decoder *decoder,
     struct aws_byte_cursor *to_decode,
@@ -145,17 +237,10 @@ int aws_hpack_decode_string(
 
     while (to_decode->len) {
         switch (progress->state) {
-            case HPACK_STRING_STATE_INIT: {
-                /* Do init stuff */
-                progress->state = HPACK_STRING_STATE_LENGTH;
-                progress->use_huffman = *to_decode->ptr >> 7;
-                aws_huffman_decoder_reset(&decoder->huffman_decoder);
-                /* fallthrough, since we didn't consume any data */
-            }
-            /* FALLTHRU */
+            case HPACK_STRING_STATE_INIT:
             case HPACK_STRING_STATE_LENGTH: {
                 bool length_complete = false;
-                if (aws_hpack_decode_integer(decoder, to_decode, 7, &progress->length, &length_complete)) {
+                if (s_decode_string_length(decoder, to_decode, &length_complete)) {
                     return AWS_OP_ERR;
                 }
 
@@ -166,12 +251,6 @@ int aws_hpack_decode_string(
                 if (progress->length == 0) {
                     goto handle_complete;
                 }
-
-                if (progress->length > SIZE_MAX) {
-                    return aws_raise_error(AWS_ERROR_OVERFLOW_DETECTED);
-                }
-
-                progress->state = HPACK_STRING_STATE_VALUE;
             } break;
 
             case HPACK_STRING_STATE_VALUE: {
@@ -226,6 +305,23 @@ handle_complete:
     return AWS_OP_SUCCESS;
 }
 
+/* A literal's name may reference the input, which is only valid during this aws_hpack_decode() call.
+ * Copy it to scratch if the entry can't finish in this call, or the value must decode into scratch after it. */
+static int s_save_literal_name_to_scratch(struct aws_hpack_decoder *decoder) {
+    struct hpack_progress_literal *literal = &decoder->progress_entry.u.literal;
+    if (literal->name_in_place.len == 0) {
+        return AWS_OP_SUCCESS;
+    }
+
+    AWS_ASSERT(decoder->progress_entry.scratch.len == 0);
+    if (aws_byte_buf_append_dynamic(&decoder->progress_entry.scratch, &literal->name_in_place)) {
+        return AWS_OP_ERR;
+    }
+
+    AWS_ZERO_STRUCT(literal->name_in_place);
+    return AWS_OP_SUCCESS;
+}
+
 /* Implements RFC-7541 Section 6 - Binary Format */
 int aws_hpack_decode(
     struct aws_hpack_decoder *decoder,
@@ -351,6 +447,20 @@ int aws_hpack_decode(
 
             /* We only end up in this state if header-name is encoded as string. */
             case HPACK_ENTRY_STATE_LITERAL_NAME_STRING: {
+                struct hpack_progress_literal *literal = &decoder->progress_entry.u.literal;
+
+                /* Avoid copying the name if possible */
+                bool name_in_place = false;
+                if (s_try_decode_string_in_place(decoder, to_decode, &literal->name_in_place, &name_in_place)) {
+                    return AWS_OP_ERR;
+                }
+
+                if (name_in_place) {
+                    literal->name_length = literal->name_in_place.len;
+                    decoder->progress_entry.state = HPACK_ENTRY_STATE_LITERAL_VALUE_STRING;
+                    break;
+                }
+
                 bool string_complete = false;
                 if (aws_hpack_decode_string(decoder, to_decode, &decoder->progress_entry.scratch, &string_complete)) {
                     return AWS_OP_ERR;
@@ -362,30 +472,53 @@ int aws_hpack_decode(
 
                 /* Done decoding name string! Move on to decoding the value string.
                  * Value will also decode into the scratch, so save where name ends. */
-                decoder->progress_entry.u.literal.name_length = decoder->progress_entry.scratch.len;
+                literal->name_length = decoder->progress_entry.scratch.len;
                 decoder->progress_entry.state = HPACK_ENTRY_STATE_LITERAL_VALUE_STRING;
             } break;
 
             /* Final state for "literal" entries.
              * Decode the header-value string, then deliver the results. */
             case HPACK_ENTRY_STATE_LITERAL_VALUE_STRING: {
-                bool string_complete = false;
-                if (aws_hpack_decode_string(decoder, to_decode, &decoder->progress_entry.scratch, &string_complete)) {
+                struct hpack_progress_literal *literal = &decoder->progress_entry.u.literal;
+
+                struct aws_http_header header;
+                header.compression = literal->compression;
+
+                /* Avoid copying the value if possible */
+                bool value_in_place = false;
+                if (s_try_decode_string_in_place(decoder, to_decode, &header.value, &value_in_place)) {
                     return AWS_OP_ERR;
                 }
 
-                if (!string_complete) {
-                    break;
+                if (value_in_place) {
+                    /* Name is either still in place too, or it's the only thing in scratch */
+                    if (literal->name_in_place.len > 0) {
+                        header.name = literal->name_in_place;
+                    } else {
+                        header.name = aws_byte_cursor_from_buf(&decoder->progress_entry.scratch);
+                    }
+                } else {
+                    /* Value decodes into scratch, right after the name */
+                    if (s_save_literal_name_to_scratch(decoder)) {
+                        return AWS_OP_ERR;
+                    }
+
+                    bool string_complete = false;
+                    if (aws_hpack_decode_string(
+                            decoder, to_decode, &decoder->progress_entry.scratch, &string_complete)) {
+                        return AWS_OP_ERR;
+                    }
+
+                    if (!string_complete) {
+                        break;
+                    }
+
+                    /* Name and value are packed one after the other in scratch */
+                    header.value = aws_byte_cursor_from_buf(&decoder->progress_entry.scratch);
+                    header.name = aws_byte_cursor_advance(&header.value, literal->name_length);
                 }
 
                 /* Done decoding value string. Done decoding entry. */
-                struct hpack_progress_literal *literal = &decoder->progress_entry.u.literal;
-
-                /* Set up a header with name and value (which are packed one after the other in scratch) */
-                struct aws_http_header header;
-                header.value = aws_byte_cursor_from_buf(&decoder->progress_entry.scratch);
-                header.name = aws_byte_cursor_advance(&header.value, literal->name_length);
-                header.compression = literal->compression;
 
                 /* Save to table if necessary */
                 if (literal->compression == AWS_HTTP_HEADER_COMPRESSION_USE_CACHE) {
@@ -436,6 +569,14 @@ int aws_hpack_decode(
     }
 
     AWS_ASSERT(to_decode->len == 0);
+
+    /* The input is going away, make sure nothing still references it */
+    if (decoder->progress_entry.state == HPACK_ENTRY_STATE_LITERAL_VALUE_STRING) {
+        if (s_save_literal_name_to_scratch(decoder)) {
+            return AWS_OP_ERR;
+        }
+    }
+
     result->type = AWS_HPACK_DECODE_T_ONGOING;
     return AWS_OP_SUCCESS;
 
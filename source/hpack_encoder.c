@@ -10,6 +10,26 @@
 
 struct aws_huffman_symbol_coder *hpack_get_coder(void);
 
+/* Max number of immutable header-blocks to memoize per encoder, least recently used are evicted past this */
+static const size_t s_hpack_max_memoized_header_blocks = 16;
+
+struct aws_hpack_memoized_header_block {
+    struct aws_allocator *allocator;
+    /* Hold a reference, so the pointer used as the cache key can't be freed and re-used by some other headers */
+    struct aws_http_headers *headers;
+    /* State the header-fields were encoded against */
+    uint64_t dynamic_table_generation;
+    enum aws_hpack_huffman_mode huffman_mode;
+    struct aws_byte_buf encoded;
+};
+
+static void s_memoized_header_block_destroy(void *value) {
+    struct aws_hpack_memoized_header_block *memo = value;
+    aws_http_headers_release(memo->headers);
+    aws_byte_buf_clean_up(&memo->encoded);
+    aws_mem_release(memo->allocator, memo);
+}
+
 void aws_hpack_encoder_init(struct aws_hpack_encoder *encoder, struct aws_allocator *allocator, const void *log_id) {
 
     AWS_ZERO_STRUCT(*encoder);
@@ -25,10 +45,24 @@ void aws_hpack_encoder_init(struct aws_hpack_encoder *encoder, struct aws_alloca
 }
 
 void aws_hpack_encoder_clean_up(struct aws_hpack_encoder *encoder) {
+    if (encoder->memoized_header_blocks) {
+        aws_cache_destroy(encoder->memoized_header_blocks);
+    }
     aws_hpack_context_clean_up(&encoder->context);
     AWS_ZERO_STRUCT(*encoder);
 }
 
+int aws_hpack_encoder_trim(struct aws_hpack_encoder *encoder) {
+    if (encoder->memoized_header_blocks) {
+        aws_cache_clear(encoder->memoized_header_blocks);
+    }
+    return aws_hpack_context_trim(&encoder->context);
+}
+
+size_t aws_hpack_encoder_get_resident_bytes(const struct aws_hpack_encoder *encoder) {
+    return aws_hpack_context_get_resident_bytes(&encoder->context);
+}
+
 void aws_hpack_encoder_set_huffman_mode(struct aws_hpack_encoder *encoder, enum aws_hpack_huffman_mode mode) {
     encoder->huffman_mode = mode;
 }
@@ -359,6 +393,158 @@ error:
     return AWS_OP_ERR;
 }
 
+static int s_encode_header_fields(
+    struct aws_hpack_encoder *encoder,
+    const struct aws_http_headers *headers,
+    struct aws_byte_buf *output) {
+
+    const size_t num_headers = aws_http_headers_count(headers);
+    for (size_t i = 0; i < num_headers; ++i) {
+        struct aws_http_header header;
+        aws_http_headers_get_index(headers, i, &header);
+        if (s_encode_header_field(encoder, &header, output)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Remember how these immutable headers encoded. Failure isn't an error, it just means no memo next time. */
+static void s_memoize_header_fields(
+    struct aws_hpack_encoder *encoder,
+    const struct aws_http_headers *headers,
+    struct aws_byte_cursor encoded) {
+
+    struct aws_allocator *allocator = encoder->context.allocator;
+
+    if (!encoder->memoized_header_blocks) {
+        encoder->memoized_header_blocks = aws_cache_new_lru(
+            allocator,
+            aws_hash_ptr,
+            aws_ptr_eq,
+            NULL /*destroy_key_fn*/,
+            s_memoized_header_block_destroy,
+            s_hpack_max_memoized_header_blocks);
+        if (!encoder->memoized_header_blocks) {
+            return;
+        }
+    }
+
+    struct aws_hpack_memoized_header_block *memo =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_hpack_memoized_header_block));
+    memo->allocator = allocator;
+    memo->dynamic_table_generation = encoder->context.dynamic_table.generation;
+    memo->huffman_mode = encoder->huffman_mode;
+    if (aws_byte_buf_init_copy_from_cursor(&memo->encoded, allocator, encoded)) {
+        aws_mem_release(allocator, memo);
+        return;
+    }
+
+    /* The API only takes const headers, but the reference we acquire is ours to release */
+    memo->headers = (struct aws_http_headers *)headers;
+    aws_http_headers_acquire(memo->headers);
+
+    /* Replaces (and destroys) any previous memo for these headers */
+    if (aws_cache_put(encoder->memoized_header_blocks, memo->headers, memo)) {
+        s_memoized_header_block_destroy(memo);
+    }
+}
+
+static int s_encode_immutable_header_fields(
+    struct aws_hpack_encoder *encoder,
+    const struct aws_http_headers *headers,
+    struct aws_byte_buf *output) {
+
+    const uint64_t generation = encoder->context.dynamic_table.generation;
+
+    struct aws_hpack_memoized_header_block *memo = NULL;
+    if (encoder->memoized_header_blocks) {
+        aws_cache_find(encoder->memoized_header_blocks, headers, (void **)&memo);
+    }
+
+    /* Same headers, against the same dynamic table, encode to the same bytes */
+    if (memo && memo->dynamic_table_generation == generation && memo->huffman_mode == encoder->huffman_mode) {
+        HPACK_LOGF(TRACE, encoder, "Encoding %zu bytes of memoized header-fields", memo->encoded.len);
+        struct aws_byte_cursor encoded = aws_byte_cursor_from_buf(&memo->encoded);
+        return aws_byte_buf_append_dynamic(output, &encoded);
+    }
+
+    const size_t original_len = output->len;
+    if (s_encode_header_fields(encoder, headers, output)) {
+        return AWS_OP_ERR;
+    }
+
+    /* If encoding changed the dynamic table (ex: inserted new entries), encoding again won't give the same bytes.
+     * Don't memoize until it settles, typically the next time these headers are sent. */
+    if (encoder->context.dynamic_table.generation == generation) {
+        struct aws_byte_cursor encoded = {
+            .ptr = output->buffer + original_len,
+            .len = output->len - original_len,
+        };
+        s_memoize_header_fields(encoder, headers, encoded);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Returns the number of bytes aws_hpack_encode_integer() would write */
+static size_t s_get_encoded_integer_length(uint64_t integer, uint8_t prefix_size) {
+    const uint8_t prefix_mask = s_masked_right_bits_u8(prefix_size);
+    if (integer < prefix_mask) {
+        return 1;
+    }
+
+    integer -= prefix_mask;
+    size_t length = 1;
+    do {
+        ++length;
+        integer >>= 7;
+    } while (integer);
+    return length;
+}
+
+/* Returns the most bytes aws_hpack_encode_string() could write */
+static size_t s_get_encoded_string_max_length(struct aws_hpack_encoder *encoder, struct aws_byte_cursor to_encode) {
+    size_t str_length = to_encode.len;
+    if (encoder->huffman_mode == AWS_HPACK_HUFFMAN_ALWAYS) {
+        /* Huffman is only used by the other modes when it's smaller */
+        str_length = aws_huffman_get_encoded_length(&encoder->huffman_encoder, to_encode);
+    }
+    return s_get_encoded_integer_length(str_length, 7) + str_length;
+}
+
+size_t aws_hpack_get_encoded_header_block_max_length(
+    struct aws_hpack_encoder *encoder,
+    const struct aws_http_headers *headers) {
+
+    size_t max_length = 0;
+
+    if (encoder->dynamic_table_size_update.pending) {
+        /* Up to 2 Dynamic Table Size Updates, with 5-bit prefixes */
+        max_length += s_get_encoded_integer_length(encoder->dynamic_table_size_update.smallest_value, 5);
+        max_length += s_get_encoded_integer_length(encoder->dynamic_table_size_update.latest_value, 5);
+    }
+
+    /* Indices never exceed the static table (61 entries), plus what's in the dynamic table,
+     * plus what this header-block might insert. Assume the smallest prefix (4-bit) to be safe. */
+    const size_t num_headers = aws_http_headers_count(headers);
+    const size_t max_index = 62 + aws_hpack_get_dynamic_table_num_elements(&encoder->context) + num_headers;
+    const size_t index_length = s_get_encoded_integer_length(max_index, 4);
+
+    for (size_t i = 0; i < num_headers; ++i) {
+        struct aws_http_header header;
+        aws_http_headers_get_index(headers, i, &header);
+
+        /* The name is either an index, or a 0 index followed by a literal string */
+        size_t name_length = aws_max_size(index_length, 1 + s_get_encoded_string_max_length(encoder, header.name));
+        max_length = aws_add_size_saturating(max_length, name_length);
+        max_length = aws_add_size_saturating(max_length, s_get_encoded_string_max_length(encoder, header.value));
+    }
+
+    return max_length;
+}
+
 int aws_hpack_encode_header_block(
     struct aws_hpack_encoder *encoder,
     const struct aws_http_headers *headers,
@@ -405,14 +591,9 @@ int aws_hpack_encode_header_block(
         encoder->dynamic_table_size_update.smallest_value = SIZE_MAX;
     }
 
-    const size_t num_headers = aws_http_headers_count(headers);
-    for (size_t i = 0; i < num_headers; ++i) {
-        struct aws_http_header header;
-        aws_http_headers_get_index(headers, i, &header);
-        if (s_encode_header_field(encoder, &header, output)) {
-            return AWS_OP_ERR;
-        }
+    if (aws_http_headers_is_immutable(headers)) {
+        return s_encode_immutable_header_fields(encoder, headers, output);
     }
 
-    return AWS_OP_SUCCESS;
+    return s_encode_header_fields(encoder, headers, output);
 }
@@ -3,9 +3,8 @@
  * SPDX-License-Identifier: Apache-2.0.
  */
 
-#include <aws/common/hash_table.h>
+#include <aws/common/thread.h>
 #include <aws/compression/compression.h>
-#include <aws/http/private/hpack.h>
 #include <aws/http/private/http_impl.h>
 #include <aws/http/status_code.h>
 #include <aws/io/logging.h>
@@ -151,6 +150,21 @@ static struct aws_error_info s_errors[] = {
     AWS_DEFINE_ERROR_INFO_HTTP(
         AWS_ERROR_HTTP_RESPONSE_FIRST_BYTE_TIMEOUT,
         "The server does not begin responding within the configuration after a request is fully sent."),
+    AWS_DEFINE_ERROR_INFO_HTTP(
+        AWS_ERROR_HTTP_EXTENDED_CONNECT_NOT_ENABLED,
+        "Extended CONNECT failed because the HTTP/2 server has not enabled SETTINGS_ENABLE_CONNECT_PROTOCOL."),
+    AWS_DEFINE_ERROR_INFO_HTTP(
+        AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED,
+        "Request rejected because the connection's memory budget is exhausted. Try again later."),
+    AWS_DEFINE_ERROR_INFO_HTTP(
+        AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED,
+        "Acquisition rejected because the manager's adaptive concurrency limit is reached. Try again later."),
+    AWS_DEFINE_ERROR_INFO_HTTP(
+        AWS_ERROR_HTTP_CIRCUIT_BREAKER_OPEN,
+        "Acquisition rejected because the manager's circuit breaker is open after repeated connection failures."),
+    AWS_DEFINE_ERROR_INFO_HTTP(
+        AWS_ERROR_HTTP_HEADERS_TOO_LARGE,
+        "Incoming headers exceed the configured max header list size."),
 };
 /* clang-format on */
 
@@ -181,90 +195,59 @@ static struct aws_log_subject_info_list s_log_subject_list = {
     .count = AWS_ARRAY_SIZE(s_log_subject_infos),
 };
 
-struct aws_enum_value {
-    struct aws_allocator *allocator;
+/* Maps a name to an enum value */
+struct aws_str_to_enum {
+    struct aws_byte_cursor str;
     int value;
 };
 
-static void s_destroy_enum_value(void *value) {
-    struct aws_enum_value *enum_value = value;
-    aws_mem_release(enum_value->allocator, enum_value);
-}
+#define STR_TO_ENUM(_str, _value) {.str = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(_str), .value = (_value)}
 
 /**
- * Given array of aws_byte_cursors, init hashtable where...
- * Key is aws_byte_cursor* (pointing into cursor from array) and comparisons are case-insensitive.
- * Value is the array index cast to a void*.
+ * Given array of aws_str_to_enum sorted by string length, get value for key.
+ * Binary search to the first entry of the same length, then compare only entries of that length.
+ * The tables are constant, so lookups need no initialization, allocation, or hashing.
+ * Returns -1 if key not found.
  */
-static void s_init_str_to_enum_hash_table(
-    struct aws_hash_table *table,
-    struct aws_allocator *alloc,
-    struct aws_byte_cursor *str_array,
-    int start_index,
-    int end_index,
+static int s_find_in_str_to_enum_table(
+    const struct aws_str_to_enum *table,
+    size_t table_len,
+    struct aws_byte_cursor key,
     bool ignore_case) {
 
-    int err = aws_hash_table_init(
-        table,
-        alloc,
-        end_index - start_index,
-        ignore_case ? aws_hash_byte_cursor_ptr_ignore_case : aws_hash_byte_cursor_ptr,
-        (aws_hash_callback_eq_fn *)(ignore_case ? aws_byte_cursor_eq_ignore_case : aws_byte_cursor_eq),
-        NULL,
-        s_destroy_enum_value);
-    AWS_FATAL_ASSERT(!err);
-
-    for (int i = start_index; i < end_index; ++i) {
-        int was_created = 0;
-        struct aws_enum_value *enum_value = aws_mem_calloc(alloc, 1, sizeof(struct aws_enum_value));
-        AWS_FATAL_ASSERT(enum_value);
-        enum_value->allocator = alloc;
-        enum_value->value = i;
-
-        AWS_FATAL_ASSERT(str_array[i].ptr && "Missing enum string");
-        err = aws_hash_table_put(table, &str_array[i], (void *)enum_value, &was_created);
-        AWS_FATAL_ASSERT(!err && was_created);
+    size_t lo = 0;
+    size_t hi = table_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table[mid].str.len < key.len) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
-}
 
-/**
- * Given key, get value from table initialized by s_init_str_to_enum_hash_table().
- * Returns -1 if key not found.
- */
-static int s_find_in_str_to_enum_hash_table(const struct aws_hash_table *table, struct aws_byte_cursor *key) {
-    struct aws_hash_element *elem;
-    aws_hash_table_find(table, key, &elem);
-    if (elem) {
-        struct aws_enum_value *enum_value = elem->value;
-        return enum_value->value;
+    for (size_t i = lo; i < table_len && table[i].str.len == key.len; ++i) {
+        bool eq = ignore_case ? aws_byte_cursor_eq_ignore_case(&table[i].str, &key)
+                              : aws_byte_cursor_eq(&table[i].str, &key);
+        if (eq) {
+            return table[i].value;
+        }
     }
     return -1;
 }
 
 /* METHODS */
-static struct aws_hash_table s_method_str_to_enum;                         /* for string -> enum lookup */
-static struct aws_byte_cursor s_method_enum_to_str[AWS_HTTP_METHOD_COUNT]; /* for enum -> string lookup */
-
-static void s_methods_init(struct aws_allocator *alloc) {
-    s_method_enum_to_str[AWS_HTTP_METHOD_GET] = aws_http_method_get;
-    s_method_enum_to_str[AWS_HTTP_METHOD_HEAD] = aws_http_method_head;
-    s_method_enum_to_str[AWS_HTTP_METHOD_CONNECT] = aws_http_method_connect;
-
-    s_init_str_to_enum_hash_table(
-        &s_method_str_to_enum,
-        alloc,
-        s_method_enum_to_str,
-        AWS_HTTP_METHOD_UNKNOWN + 1,
-        AWS_HTTP_METHOD_COUNT,
-        false /* DO NOT ignore case of method */);
-}
-
-static void s_methods_clean_up(void) {
-    aws_hash_table_clean_up(&s_method_str_to_enum);
-}
+/* for string -> enum lookup, sorted by length */
+static const struct aws_str_to_enum s_method_str_to_enum[] = {
+    STR_TO_ENUM("GET", AWS_HTTP_METHOD_GET),
+    STR_TO_ENUM("HEAD", AWS_HTTP_METHOD_HEAD),
+    STR_TO_ENUM("CONNECT", AWS_HTTP_METHOD_CONNECT),
+};
+AWS_STATIC_ASSERT(AWS_ARRAY_SIZE(s_method_str_to_enum) == AWS_HTTP_METHOD_COUNT - 1);
 
 enum aws_http_method aws_http_str_to_method(struct aws_byte_cursor cursor) {
-    int method = s_find_in_str_to_enum_hash_table(&s_method_str_to_enum, &cursor);
+    int method = s_find_in_str_to_enum_table(
+        s_method_str_to_enum, AWS_ARRAY_SIZE(s_method_str_to_enum), cursor, false /* DO NOT ignore case of method */);
     if (method >= 0) {
         return (enum aws_http_method)method;
     }
@@ -272,17 +255,13 @@ enum aws_http_method aws_http_str_to_method(struct aws_byte_cursor cursor) {
 }
 
 /* VERSIONS */
-static struct aws_byte_cursor s_version_enum_to_str[AWS_HTTP_HEADER_COUNT]; /* for enum -> string lookup */
-
-static void s_versions_init(struct aws_allocator *alloc) {
-    (void)alloc;
-    s_version_enum_to_str[AWS_HTTP_VERSION_UNKNOWN] = aws_byte_cursor_from_c_str("Unknown");
-    s_version_enum_to_str[AWS_HTTP_VERSION_1_0] = aws_byte_cursor_from_c_str("HTTP/1.0");
-    s_version_enum_to_str[AWS_HTTP_VERSION_1_1] = aws_byte_cursor_from_c_str("HTTP/1.1");
-    s_version_enum_to_str[AWS_HTTP_VERSION_2] = aws_byte_cursor_from_c_str("HTTP/2");
-}
-
-static void s_versions_clean_up(void) {}
+/* for enum -> string lookup */
+static const struct aws_byte_cursor s_version_enum_to_str[AWS_HTTP_VERSION_COUNT] = {
+    [AWS_HTTP_VERSION_UNKNOWN] = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("Unknown"),
+    [AWS_HTTP_VERSION_1_0] = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("HTTP/1.0"),
+    [AWS_HTTP_VERSION_1_1] = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("HTTP/1.1"),
+    [AWS_HTTP_VERSION_2] = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("HTTP/2"),
+};
 
 struct aws_byte_cursor aws_http_version_to_str(enum aws_http_version version) {
     if ((int)version < AWS_HTTP_VERSION_UNKNOWN || (int)version >= AWS_HTTP_VERSION_COUNT) {
@@ -293,71 +272,49 @@ struct aws_byte_cursor aws_http_version_to_str(enum aws_http_version version) {
 }
 
 /* HEADERS */
-static struct aws_hash_table s_header_str_to_enum;           /* for case-insensitive string -> enum lookup */
-static struct aws_hash_table s_lowercase_header_str_to_enum; /* for case-sensitive string -> enum lookup */
-static struct aws_byte_cursor s_header_enum_to_str[AWS_HTTP_HEADER_COUNT]; /* for enum -> string lookup */
-
-static void s_headers_init(struct aws_allocator *alloc) {
-    s_header_enum_to_str[AWS_HTTP_HEADER_METHOD] = aws_byte_cursor_from_c_str(":method");
-    s_header_enum_to_str[AWS_HTTP_HEADER_SCHEME] = aws_byte_cursor_from_c_str(":scheme");
-    s_header_enum_to_str[AWS_HTTP_HEADER_AUTHORITY] = aws_byte_cursor_from_c_str(":authority");
-    s_header_enum_to_str[AWS_HTTP_HEADER_PATH] = aws_byte_cursor_from_c_str(":path");
-    s_header_enum_to_str[AWS_HTTP_HEADER_STATUS] = aws_byte_cursor_from_c_str(":status");
-    s_header_enum_to_str[AWS_HTTP_HEADER_COOKIE] = aws_byte_cursor_from_c_str("cookie");
-    s_header_enum_to_str[AWS_HTTP_HEADER_SET_COOKIE] = aws_byte_cursor_from_c_str("set-cookie");
-    s_header_enum_to_str[AWS_HTTP_HEADER_HOST] = aws_byte_cursor_from_c_str("host");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CONNECTION] = aws_byte_cursor_from_c_str("connection");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CONTENT_LENGTH] = aws_byte_cursor_from_c_str("content-length");
-    s_header_enum_to_str[AWS_HTTP_HEADER_EXPECT] = aws_byte_cursor_from_c_str("expect");
-    s_header_enum_to_str[AWS_HTTP_HEADER_TRANSFER_ENCODING] = aws_byte_cursor_from_c_str("transfer-encoding");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CACHE_CONTROL] = aws_byte_cursor_from_c_str("cache-control");
-    s_header_enum_to_str[AWS_HTTP_HEADER_MAX_FORWARDS] = aws_byte_cursor_from_c_str("max-forwards");
-    s_header_enum_to_str[AWS_HTTP_HEADER_PRAGMA] = aws_byte_cursor_from_c_str("pragma");
-    s_header_enum_to_str[AWS_HTTP_HEADER_RANGE] = aws_byte_cursor_from_c_str("range");
-    s_header_enum_to_str[AWS_HTTP_HEADER_TE] = aws_byte_cursor_from_c_str("te");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CONTENT_ENCODING] = aws_byte_cursor_from_c_str("content-encoding");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CONTENT_TYPE] = aws_byte_cursor_from_c_str("content-type");
-    s_header_enum_to_str[AWS_HTTP_HEADER_CONTENT_RANGE] = aws_byte_cursor_from_c_str("content-range");
-    s_header_enum_to_str[AWS_HTTP_HEADER_TRAILER] = aws_byte_cursor_from_c_str("trailer");
-    s_header_enum_to_str[AWS_HTTP_HEADER_WWW_AUTHENTICATE] = aws_byte_cursor_from_c_str("www-authenticate");
-    s_header_enum_to_str[AWS_HTTP_HEADER_AUTHORIZATION] = aws_byte_cursor_from_c_str("authorization");
-    s_header_enum_to_str[AWS_HTTP_HEADER_PROXY_AUTHENTICATE] = aws_byte_cursor_from_c_str("proxy-authenticate");
-    s_header_enum_to_str[AWS_HTTP_HEADER_PROXY_AUTHORIZATION] = aws_byte_cursor_from_c_str("proxy-authorization");
-    s_header_enum_to_str[AWS_HTTP_HEADER_AGE] = aws_byte_cursor_from_c_str("age");
-    s_header_enum_to_str[AWS_HTTP_HEADER_EXPIRES] = aws_byte_cursor_from_c_str("expires");
-    s_header_enum_to_str[AWS_HTTP_HEADER_DATE] = aws_byte_cursor_from_c_str("date");
-    s_header_enum_to_str[AWS_HTTP_HEADER_LOCATION] = aws_byte_cursor_from_c_str("location");
-    s_header_enum_to_str[AWS_HTTP_HEADER_RETRY_AFTER] = aws_byte_cursor_from_c_str("retry-after");
-    s_header_enum_to_str[AWS_HTTP_HEADER_VARY] = aws_byte_cursor_from_c_str("vary");
-    s_header_enum_to_str[AWS_HTTP_HEADER_WARNING] = aws_byte_cursor_from_c_str("warning");
-    s_header_enum_to_str[AWS_HTTP_HEADER_UPGRADE] = aws_byte_cursor_from_c_str("upgrade");
-    s_header_enum_to_str[AWS_HTTP_HEADER_KEEP_ALIVE] = aws_byte_cursor_from_c_str("keep-alive");
-    s_header_enum_to_str[AWS_HTTP_HEADER_PROXY_CONNECTION] = aws_byte_cursor_from_c_str("proxy-connection");
-
-    s_init_str_to_enum_hash_table(
-        &s_header_str_to_enum,
-        alloc,
-        s_header_enum_to_str,
-        AWS_HTTP_HEADER_UNKNOWN + 1,
-        AWS_HTTP_HEADER_COUNT,
-        true /* ignore case */);
-
-    s_init_str_to_enum_hash_table(
-        &s_lowercase_header_str_to_enum,
-        alloc,
-        s_header_enum_to_str,
-        AWS_HTTP_HEADER_UNKNOWN + 1,
-        AWS_HTTP_HEADER_COUNT,
-        false /* ignore case */);
-}
-
-static void s_headers_clean_up(void) {
-    aws_hash_table_clean_up(&s_header_str_to_enum);
-    aws_hash_table_clean_up(&s_lowercase_header_str_to_enum);
-}
+/* for string -> enum lookup, sorted by length. Names are lowercase. */
+static const struct aws_str_to_enum s_header_str_to_enum[] = {
+    STR_TO_ENUM("te", AWS_HTTP_HEADER_TE),
+    STR_TO_ENUM("age", AWS_HTTP_HEADER_AGE),
+    STR_TO_ENUM("host", AWS_HTTP_HEADER_HOST),
+    STR_TO_ENUM("date", AWS_HTTP_HEADER_DATE),
+    STR_TO_ENUM("vary", AWS_HTTP_HEADER_VARY),
+    STR_TO_ENUM(":path", AWS_HTTP_HEADER_PATH),
+    STR_TO_ENUM("range", AWS_HTTP_HEADER_RANGE),
+    STR_TO_ENUM("cookie", AWS_HTTP_HEADER_COOKIE),
+    STR_TO_ENUM("expect", AWS_HTTP_HEADER_EXPECT),
+    STR_TO_ENUM("pragma", AWS_HTTP_HEADER_PRAGMA),
+    STR_TO_ENUM(":method", AWS_HTTP_HEADER_METHOD),
+    STR_TO_ENUM(":scheme", AWS_HTTP_HEADER_SCHEME),
+    STR_TO_ENUM(":status", AWS_HTTP_HEADER_STATUS),
+    STR_TO_ENUM("trailer", AWS_HTTP_HEADER_TRAILER),
+    STR_TO_ENUM("expires", AWS_HTTP_HEADER_EXPIRES),
+    STR_TO_ENUM("warning", AWS_HTTP_HEADER_WARNING),
+    STR_TO_ENUM("upgrade", AWS_HTTP_HEADER_UPGRADE),
+    STR_TO_ENUM("location", AWS_HTTP_HEADER_LOCATION),
+    STR_TO_ENUM(":authority", AWS_HTTP_HEADER_AUTHORITY),
+    STR_TO_ENUM("set-cookie", AWS_HTTP_HEADER_SET_COOKIE),
+    STR_TO_ENUM("connection", AWS_HTTP_HEADER_CONNECTION),
+    STR_TO_ENUM("keep-alive", AWS_HTTP_HEADER_KEEP_ALIVE),
+    STR_TO_ENUM("retry-after", AWS_HTTP_HEADER_RETRY_AFTER),
+    STR_TO_ENUM("content-type", AWS_HTTP_HEADER_CONTENT_TYPE),
+    STR_TO_ENUM("max-forwards", AWS_HTTP_HEADER_MAX_FORWARDS),
+    STR_TO_ENUM("cache-control", AWS_HTTP_HEADER_CACHE_CONTROL),
+    STR_TO_ENUM("authorization", AWS_HTTP_HEADER_AUTHORIZATION),
+    STR_TO_ENUM("content-range", AWS_HTTP_HEADER_CONTENT_RANGE),
+    STR_TO_ENUM("content-length", AWS_HTTP_HEADER_CONTENT_LENGTH),
+    STR_TO_ENUM("content-encoding", AWS_HTTP_HEADER_CONTENT_ENCODING),
+    STR_TO_ENUM("www-authenticate", AWS_HTTP_HEADER_WWW_AUTHENTICATE),
+    STR_TO_ENUM("proxy-connection", AWS_HTTP_HEADER_PROXY_CONNECTION),
+    STR_TO_ENUM("transfer-encoding", AWS_HTTP_HEADER_TRANSFER_ENCODING),
+    STR_TO_ENUM("proxy-authenticate", AWS_HTTP_HEADER_PROXY_AUTHENTICATE),
+    STR_TO_ENUM("proxy-authorization", AWS_HTTP_HEADER_PROXY_AUTHORIZATION),
+};
+AWS_STATIC_ASSERT(AWS_ARRAY_SIZE(s_header_str_to_enum) == AWS_HTTP_HEADER_COUNT - 1);
 
 enum aws_http_header_name aws_http_str_to_header_name(struct aws_byte_cursor cursor) {
-    int header = s_find_in_str_to_enum_hash_table(&s_header_str_to_enum, &cursor);
+    int header = s_find_in_str_to_enum_table(
+        s_header_str_to_enum, AWS_ARRAY_SIZE(s_header_str_to_enum), cursor, true /* ignore case */);
     if (header >= 0) {
         return (enum aws_http_header_name)header;
     }
@@ -365,7 +322,8 @@ enum aws_http_header_name aws_http_str_to_header_name(struct aws_byte_cursor cur
 }
 
 enum aws_http_header_name aws_http_lowercase_str_to_header_name(struct aws_byte_cursor cursor) {
-    int header = s_find_in_str_to_enum_hash_table(&s_lowercase_header_str_to_enum, &cursor);
+    int header = s_find_in_str_to_enum_table(
+        s_header_str_to_enum, AWS_ARRAY_SIZE(s_header_str_to_enum), cursor, false /* ignore case */);
     if (header >= 0) {
         return (enum aws_http_header_name)header;
     }
@@ -517,10 +475,6 @@ void aws_http_library_init(struct aws_allocator *alloc) {
     aws_compression_library_init(alloc);
     aws_register_error_info(&s_error_list);
     aws_register_log_subject_info_list(&s_log_subject_list);
-    s_methods_init(alloc);
-    s_headers_init(alloc);
-    s_versions_init(alloc);
-    aws_hpack_static_table_init(alloc);
 }
 
 void aws_http_library_clean_up(void) {
@@ -532,10 +486,6 @@ void aws_http_library_clean_up(void) {
     aws_thread_join_all_managed();
     aws_unregister_error_info(&s_error_list);
     aws_unregister_log_subject_info_list(&s_log_subject_list);
-    s_methods_clean_up();
-    s_headers_clean_up();
-    s_versions_clean_up();
-    aws_hpack_static_table_clean_up();
     aws_compression_library_clean_up();
     aws_io_library_clean_up();
 }
@@ -563,6 +513,7 @@ const struct aws_byte_cursor aws_http_header_scheme = AWS_BYTE_CUR_INIT_FROM_STR
 const struct aws_byte_cursor aws_http_header_authority = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":authority");
 const struct aws_byte_cursor aws_http_header_path = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":path");
 const struct aws_byte_cursor aws_http_header_status = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":status");
+const struct aws_byte_cursor aws_http_header_protocol = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":protocol");
 
 const struct aws_byte_cursor aws_http_scheme_http = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("http");
 const struct aws_byte_cursor aws_http_scheme_https = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("https");
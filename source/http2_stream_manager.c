@@ -5,7 +5,6 @@
 
 #include <aws/common/array_list.h>
 #include <aws/common/clock.h>
-#include <aws/common/hash_table.h>
 #include <aws/common/logging.h>
 #include <aws/http/connection.h>
 #include <aws/http/connection_manager.h>
@@ -35,6 +34,49 @@
 /* 3 seconds */
 static const size_t s_default_ping_timeout_ms = 3000;
 
+/*
+ * System vtable to use under normal circumstances
+ */
+static struct aws_http2_stream_manager_system_vtable s_default_system_vtable = {
+    .aws_http_connection_make_request = aws_http_connection_make_request,
+    .aws_http_stream_activate = aws_http_stream_activate,
+    .aws_http_stream_get_incoming_response_status = aws_http_stream_get_incoming_response_status,
+    .aws_http2_connection_get_remote_settings = aws_http2_connection_get_remote_settings,
+    .aws_http2_connection_ping = aws_http2_connection_ping,
+    .aws_http_connection_new_requests_allowed = aws_http_connection_new_requests_allowed,
+    .aws_http_connection_stop_new_requests = aws_http_connection_stop_new_requests,
+    .aws_http_connection_close = aws_http_connection_close,
+    .aws_http_connection_get_version = aws_http_connection_get_version,
+    .aws_http_connection_get_channel = aws_http_connection_get_channel,
+    .aws_channel_thread_is_callers_thread = aws_channel_thread_is_callers_thread,
+    .aws_channel_schedule_task_now = aws_channel_schedule_task_now,
+    .aws_channel_schedule_task_future = aws_channel_schedule_task_future,
+    .aws_channel_current_clock_time = aws_channel_current_clock_time,
+    .aws_high_res_clock_get_ticks = aws_high_res_clock_get_ticks,
+};
+
+const struct aws_http2_stream_manager_system_vtable *g_aws_http2_stream_manager_default_system_vtable_ptr =
+    &s_default_system_vtable;
+
+bool aws_http2_stream_manager_system_vtable_is_valid(const struct aws_http2_stream_manager_system_vtable *table) {
+    return table->aws_http_connection_make_request && table->aws_http_stream_activate &&
+           table->aws_http_stream_get_incoming_response_status && table->aws_http2_connection_get_remote_settings &&
+           table->aws_http2_connection_ping && table->aws_http_connection_new_requests_allowed &&
+           table->aws_http_connection_stop_new_requests && table->aws_http_connection_close &&
+           table->aws_http_connection_get_version && table->aws_http_connection_get_channel &&
+           table->aws_channel_thread_is_callers_thread && table->aws_channel_schedule_task_now &&
+           table->aws_channel_schedule_task_future && table->aws_channel_current_clock_time &&
+           table->aws_high_res_clock_get_ticks;
+}
+
+void aws_http2_stream_manager_set_system_vtable(
+    struct aws_http2_stream_manager *stream_manager,
+    const struct aws_http2_stream_manager_system_vtable *system_vtable) {
+    AWS_FATAL_ASSERT(aws_http2_stream_manager_system_vtable_is_valid(system_vtable));
+
+    stream_manager->system_vtable = system_vtable;
+}
+
 static void s_stream_manager_start_destroy(struct aws_http2_stream_manager *stream_manager);
 static void s_aws_http2_stream_manager_build_transaction_synced(struct aws_http2_stream_management_transaction *work);
 static void s_aws_http2_stream_manager_execute_transaction(struct aws_http2_stream_management_transaction *work);
@@ -131,18 +173,30 @@ static void s_aws_stream_management_transaction_clean_up(struct aws_http2_stream
     aws_ref_count_release(&work->stream_manager->internal_ref_count);
 }
 
-static struct aws_h2_sm_connection *s_get_best_sm_connection_from_set(struct aws_random_access_set *set) {
-    /* Use the best two algorithm */
-    int errored = AWS_ERROR_SUCCESS;
-    struct aws_h2_sm_connection *sm_connection_a = NULL;
-    errored = aws_random_access_set_random_get_ptr(set, (void **)&sm_connection_a);
-    struct aws_h2_sm_connection *sm_connection_b = NULL;
-    errored |= aws_random_access_set_random_get_ptr(set, (void **)&sm_connection_b);
-    struct aws_h2_sm_connection *chosen_connection =
-        sm_connection_a->num_streams_assigned > sm_connection_b->num_streams_assigned ? sm_connection_b
-                                                                                      : sm_connection_a;
-    return errored == AWS_ERROR_SUCCESS ? chosen_connection : NULL;
-    (void)errored;
+/* Streams made, or about to be made, and not completed yet */
+/* *_synced should only be called with LOCK HELD or from another synced function */
+static size_t s_get_streams_in_flight_synced(const struct aws_http2_stream_manager *stream_manager) {
+    return stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_OPEN_STREAM] +
+           stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_MAKE_REQUESTS];
+}
+
+/* How many more streams the concurrency limit allows in flight */
+/* *_synced should only be called with LOCK HELD or from another synced function */
+static size_t s_get_concurrency_limit_room_synced(const struct aws_http2_stream_manager *stream_manager) {
+    if (!stream_manager->concurrency_limit_enabled) {
+        return SIZE_MAX;
+    }
+    return aws_sub_size_saturating(
+        aws_http_concurrency_limiter_get_limit(&stream_manager->synced_data.concurrency_limiter),
+        s_get_streams_in_flight_synced(stream_manager));
+}
+
+/* *_synced should only be called with LOCK HELD or from another synced function */
+static struct aws_h2_sm_connection *s_get_least_loaded_sm_connection_synced(
+    struct aws_http2_stream_manager *stream_manager) {
+    struct aws_least_loaded_heap_node *node =
+        aws_least_loaded_heap_peek(&stream_manager->synced_data.available_connections);
+    return node ? AWS_CONTAINER_OF(node, struct aws_h2_sm_connection, available_node) : NULL;
 }
 
 /* helper function for building the transaction: Try to assign connection for a pending stream acquisition */
@@ -152,95 +206,63 @@ static void s_sm_try_assign_connection_to_pending_stream_acquisition_synced(
     struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition) {
 
     AWS_ASSERT(pending_stream_acquisition->sm_connection == NULL);
-    int errored = 0;
-    if (aws_random_access_set_get_size(&stream_manager->synced_data.ideal_available_set)) {
-        /**
-         * Try assigning to connection from ideal set
-         */
-        struct aws_h2_sm_connection *chosen_connection =
-            s_get_best_sm_connection_from_set(&stream_manager->synced_data.ideal_available_set);
-        AWS_ASSERT(chosen_connection);
-        pending_stream_acquisition->sm_connection = chosen_connection;
-        chosen_connection->num_streams_assigned++;
+    struct aws_h2_sm_connection *chosen_connection = s_get_least_loaded_sm_connection_synced(stream_manager);
+    if (!chosen_connection) {
+        return;
+    }
+    /**
+     * The least loaded connection is ideal if any connection is.
+     *
+     * Note that we do not assign to nonideal connections until we're holding all the connections we can ever
+     * possibly get. This way, we don't overfill the first connections we get our hands on.
+     */
+    if (chosen_connection->state != AWS_H2SMCST_IDEAL &&
+        stream_manager->synced_data.holding_connections_count != stream_manager->max_connections) {
+        return;
+    }
+
+    pending_stream_acquisition->sm_connection = chosen_connection;
+    chosen_connection->num_streams_assigned++;
 
+    STREAM_MANAGER_LOGF(
+        DEBUG,
+        stream_manager,
+        "Picking connection:%p for acquisition:%p. Streams assigned to the connection=%" PRIu32 "",
+        (void *)chosen_connection->connection,
+        (void *)pending_stream_acquisition,
+        chosen_connection->num_streams_assigned);
+    /* Check if connection is still available or ideal, and update it if it's not */
+    if (chosen_connection->num_streams_assigned >= chosen_connection->max_concurrent_streams) {
+        /* It becomes not available for new streams any more, remove it from the heap, but still alive (streams
+         * created will track the lifetime) */
+        chosen_connection->state = AWS_H2SMCST_FULL;
+        aws_least_loaded_heap_remove(
+            &stream_manager->synced_data.available_connections, &chosen_connection->available_node);
         STREAM_MANAGER_LOGF(
             DEBUG,
             stream_manager,
-            "Picking connection:%p for acquisition:%p. Streams assigned to the connection=%" PRIu32 "",
+            "connection:%p reaches max concurrent streams limits. "
+            "Connection max limits=%" PRIu32 ". Moving it out of available connections.",
             (void *)chosen_connection->connection,
-            (void *)pending_stream_acquisition,
-            chosen_connection->num_streams_assigned);
-        /* Check if connection is still available or ideal, and move it if it's not */
-        if (chosen_connection->num_streams_assigned >= chosen_connection->max_concurrent_streams) {
-            /* It becomes not available for new streams any more, remove it from the set, but still alive (streams
-             * created will track the lifetime) */
-            chosen_connection->state = AWS_H2SMCST_FULL;
-            errored |=
-                aws_random_access_set_remove(&stream_manager->synced_data.ideal_available_set, chosen_connection);
-            STREAM_MANAGER_LOGF(
-                DEBUG,
-                stream_manager,
-                "connection:%p reaches max concurrent streams limits. "
-                "Connection max limits=%" PRIu32 ". Moving it out of available connections.",
-                (void *)chosen_connection->connection,
-                chosen_connection->max_concurrent_streams);
-        } else if (chosen_connection->num_streams_assigned >= stream_manager->ideal_concurrent_streams_per_connection) {
-            /* It meets the ideal limit, but still available for new streams, move it to the nonidea-available set */
-            errored |=
-                aws_random_access_set_remove(&stream_manager->synced_data.ideal_available_set, chosen_connection);
-            bool added = false;
-            errored |= aws_random_access_set_add(
-                &stream_manager->synced_data.nonideal_available_set, chosen_connection, &added);
-            errored |= !added;
-            chosen_connection->state = AWS_H2SMCST_NEARLY_FULL;
-            STREAM_MANAGER_LOGF(
-                DEBUG,
-                stream_manager,
-                "connection:%p reaches ideal concurrent streams limits. Ideal limits=%zu. Moving it to nonlimited set.",
-                (void *)chosen_connection->connection,
-                stream_manager->ideal_concurrent_streams_per_connection);
-        }
-    } else if (stream_manager->synced_data.holding_connections_count == stream_manager->max_connections) {
-        /**
-         * Try assigning to connection from nonideal available set.
-         *
-         * Note that we do not assign to nonideal connections until we're holding all the connections we can ever
-         * possibly get. This way, we don't overfill the first connections we get our hands on.
-         */
-
-        if (aws_random_access_set_get_size(&stream_manager->synced_data.nonideal_available_set)) {
-            struct aws_h2_sm_connection *chosen_connection =
-                s_get_best_sm_connection_from_set(&stream_manager->synced_data.nonideal_available_set);
-            AWS_ASSERT(chosen_connection);
-            pending_stream_acquisition->sm_connection = chosen_connection;
-            chosen_connection->num_streams_assigned++;
+            chosen_connection->max_concurrent_streams);
+        return;
+    }
 
-            STREAM_MANAGER_LOGF(
-                DEBUG,
-                stream_manager,
-                "Picking connection:%p for acquisition:%p. Streams assigned to the connection=%" PRIu32 "",
-                (void *)chosen_connection->connection,
-                (void *)pending_stream_acquisition,
-                chosen_connection->num_streams_assigned);
-
-            if (chosen_connection->num_streams_assigned >= chosen_connection->max_concurrent_streams) {
-                /* It becomes not available for new streams any more, remove it from the set, but still alive (streams
-                 * created will track the lifetime) */
-                chosen_connection->state = AWS_H2SMCST_FULL;
-                errored |= aws_random_access_set_remove(
-                    &stream_manager->synced_data.nonideal_available_set, chosen_connection);
-                STREAM_MANAGER_LOGF(
-                    DEBUG,
-                    stream_manager,
-                    "connection %p reaches max concurrent streams limits. "
-                    "Connection max limits=%" PRIu32 ". Moving it out of available connections.",
-                    (void *)chosen_connection->connection,
-                    chosen_connection->max_concurrent_streams);
-            }
-        }
+    aws_least_loaded_heap_update(
+        &stream_manager->synced_data.available_connections,
+        &chosen_connection->available_node,
+        chosen_connection->num_streams_assigned);
+    if (chosen_connection->state == AWS_H2SMCST_IDEAL &&
+        chosen_connection->num_streams_assigned >= stream_manager->ideal_concurrent_streams_per_connection) {
+        /* It meets the ideal limit, but still available for new streams */
+        chosen_connection->state = AWS_H2SMCST_NEARLY_FULL;
+        STREAM_MANAGER_LOGF(
+            DEBUG,
+            stream_manager,
+            "connection:%p reaches ideal concurrent streams limits. Ideal limits=%zu. Marking it nonideal.",
+            (void *)chosen_connection->connection,
+            stream_manager->ideal_concurrent_streams_per_connection);
     }
-    AWS_ASSERT(errored == 0 && "random access set went wrong");
-    (void)errored;
 }
 
 /* NOTE: never invoke with lock held */
@@ -300,13 +322,14 @@ static void s_finish_pending_stream_acquisitions_task(struct aws_task *task, voi
 /* helper function for building the transaction: how many new connections we should request */
 static void s_check_new_connections_needed_synced(struct aws_http2_stream_management_transaction *work) {
     struct aws_http2_stream_manager *stream_manager = work->stream_manager;
+    /* Acquisitions held back by the concurrency limit don't need a connection yet */
+    size_t pending_acquisitions = aws_min_size(
+        stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_ACQUISITION],
+        s_get_concurrency_limit_room_synced(stream_manager));
     /* The ideal new connection we need to fit all the pending stream acquisitions */
-    size_t ideal_new_connection_count =
-        stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_ACQUISITION] /
-        stream_manager->ideal_concurrent_streams_per_connection;
+    size_t ideal_new_connection_count = pending_acquisitions / stream_manager->ideal_concurrent_streams_per_connection;
     /* Rounding up */
-    if (stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_ACQUISITION] %
-        stream_manager->ideal_concurrent_streams_per_connection) {
+    if (pending_acquisitions % stream_manager->ideal_concurrent_streams_per_connection) {
         ++ideal_new_connection_count;
     }
     /* The ideal new connections sub the number of connections we are acquiring to avoid the async acquiring */
@@ -345,6 +368,14 @@ static void s_aws_http2_stream_manager_build_transaction_synced(struct aws_http2
 
         /* Steps 1: Pending acquisitions of stream */
         while (!aws_linked_list_empty(&stream_manager->synced_data.pending_stream_acquisitions)) {
+            if (s_get_concurrency_limit_room_synced(stream_manager) == 0) {
+                STREAM_MANAGER_LOGF(
+                    DEBUG,
+                    stream_manager,
+                    "concurrency limit of %zu streams reached, acquisitions wait for streams to complete.",
+                    aws_http_concurrency_limiter_get_limit(&stream_manager->synced_data.concurrency_limiter));
+                break;
+            }
             struct aws_linked_list_node *node =
                 aws_linked_list_pop_front(&stream_manager->synced_data.pending_stream_acquisitions);
             struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition =
@@ -403,13 +434,17 @@ static void s_on_ping_complete(
 
     (void)http2_connection;
     struct aws_h2_sm_connection *sm_connection = user_data;
+    const struct aws_http2_stream_manager_system_vtable *vtable = NULL;
     if (error_code) {
         goto done;
     }
     if (!sm_connection->connection) {
         goto done;
     }
-    AWS_ASSERT(aws_channel_thread_is_callers_thread(aws_http_connection_get_channel(sm_connection->connection)));
+    vtable = sm_connection->stream_manager->system_vtable;
+    AWS_ASSERT(vtable->aws_channel_thread_is_callers_thread(
+        vtable->aws_http_connection_get_channel(sm_connection->connection)));
+    (void)vtable;
     STREAM_MANAGER_LOGF(
         TRACE,
         sm_connection->stream_manager,
@@ -427,6 +462,7 @@ static void s_connection_ping_timeout_task(struct aws_channel_task *task, void *
     (void)task;
     (void)status;
     struct aws_h2_sm_connection *sm_connection = arg;
+    const struct aws_http2_stream_manager_system_vtable *vtable = NULL;
     if (status != AWS_TASK_STATUS_RUN_READY) {
         goto done;
     }
@@ -434,7 +470,9 @@ static void s_connection_ping_timeout_task(struct aws_channel_task *task, void *
         /* The connection has been released before timeout happens, just release the refcount */
         goto done;
     }
-    AWS_ASSERT(aws_channel_thread_is_callers_thread(aws_http_connection_get_channel(sm_connection->connection)));
+    vtable = sm_connection->stream_manager->system_vtable;
+    AWS_ASSERT(vtable->aws_channel_thread_is_callers_thread(
+        vtable->aws_http_connection_get_channel(sm_connection->connection)));
     if (!sm_connection->thread_data.ping_received) {
         /* Timeout happened */
         STREAM_MANAGER_LOGF(
@@ -443,12 +481,12 @@ static void s_connection_ping_timeout_task(struct aws_channel_task *task, void *
             "ping timeout detected for connection: %p, closing connection.",
             (void *)sm_connection->connection);
 
-        aws_http_connection_close(sm_connection->connection);
+        vtable->aws_http_connection_close(sm_connection->connection);
     } else {
-        struct aws_channel *channel = aws_http_connection_get_channel(sm_connection->connection);
+        struct aws_channel *channel = vtable->aws_http_connection_get_channel(sm_connection->connection);
         /* acquire a refcount for next set of tasks to run */
         aws_ref_count_acquire(&sm_connection->ref_count);
-        aws_channel_schedule_task_future(
+        vtable->aws_channel_schedule_task_future(
             channel, &sm_connection->ping_task, sm_connection->thread_data.next_ping_task_time);
     }
 done:
@@ -469,19 +507,21 @@ static void s_connection_ping_task(struct aws_channel_task *task, void *arg, enu
         aws_ref_count_release(&sm_connection->ref_count);
         return;
     }
-    AWS_ASSERT(aws_channel_thread_is_callers_thread(aws_http_connection_get_channel(sm_connection->connection)));
+    const struct aws_http2_stream_manager_system_vtable *vtable = sm_connection->stream_manager->system_vtable;
+    AWS_ASSERT(vtable->aws_channel_thread_is_callers_thread(
+        vtable->aws_http_connection_get_channel(sm_connection->connection)));
 
     STREAM_MANAGER_LOGF(
         TRACE, sm_connection->stream_manager, "Sending PING for connection: %p.", (void *)sm_connection->connection);
-    aws_http2_connection_ping(sm_connection->connection, NULL, s_on_ping_complete, sm_connection);
+    vtable->aws_http2_connection_ping(sm_connection->connection, NULL, s_on_ping_complete, sm_connection);
     /* Acquire refcount for PING complete to be invoked. */
     aws_ref_count_acquire(&sm_connection->ref_count);
     sm_connection->thread_data.ping_received = false;
 
     /* schedule timeout task */
-    struct aws_channel *channel = aws_http_connection_get_channel(sm_connection->connection);
+    struct aws_channel *channel = vtable->aws_http_connection_get_channel(sm_connection->connection);
     uint64_t current_time = 0;
-    aws_channel_current_clock_time(channel, &current_time);
+    vtable->aws_channel_current_clock_time(channel, &current_time);
     sm_connection->thread_data.next_ping_task_time =
         current_time + sm_connection->stream_manager->connection_ping_period_ns;
     uint64_t timeout_time = current_time + sm_connection->stream_manager->connection_ping_timeout_ns;
@@ -491,7 +531,7 @@ static void s_connection_ping_task(struct aws_channel_task *task, void *arg, enu
         sm_connection,
         "Stream manager connection ping timeout task");
     /* keep the refcount for timeout task to run */
-    aws_channel_schedule_task_future(channel, &sm_connection->ping_timeout_task, timeout_time);
+    vtable->aws_channel_schedule_task_future(channel, &sm_connection->ping_timeout_task, timeout_time);
 }
 
 static void s_sm_connection_destroy(void *user_data) {
@@ -502,30 +542,32 @@ static void s_sm_connection_destroy(void *user_data) {
 static struct aws_h2_sm_connection *s_sm_connection_new(
     struct aws_http2_stream_manager *stream_manager,
     struct aws_http_connection *connection) {
+    const struct aws_http2_stream_manager_system_vtable *vtable = stream_manager->system_vtable;
     struct aws_h2_sm_connection *sm_connection =
         aws_mem_calloc(stream_manager->allocator, 1, sizeof(struct aws_h2_sm_connection));
     sm_connection->allocator = stream_manager->allocator;
     /* Max concurrent stream reached, we need to update the max for the sm_connection */
     struct aws_http2_setting out_settings[AWS_HTTP2_SETTINGS_COUNT];
     /* The setting id equals to the index plus one. */
-    aws_http2_connection_get_remote_settings(connection, out_settings);
+    vtable->aws_http2_connection_get_remote_settings(connection, out_settings);
     uint32_t remote_max_con_streams = out_settings[AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS - 1].value;
     sm_connection->max_concurrent_streams =
         aws_min_u32((uint32_t)stream_manager->max_concurrent_streams_per_connection, remote_max_con_streams);
     sm_connection->connection = connection;
     sm_connection->stream_manager = stream_manager;
     sm_connection->state = AWS_H2SMCST_IDEAL;
+    aws_least_loaded_heap_node_init(&sm_connection->available_node);
     aws_ref_count_init(&sm_connection->ref_count, sm_connection, s_sm_connection_destroy);
     if (stream_manager->connection_ping_period_ns) {
-        struct aws_channel *channel = aws_http_connection_get_channel(connection);
+        struct aws_channel *channel = vtable->aws_http_connection_get_channel(connection);
         uint64_t schedule_time = 0;
-        aws_channel_current_clock_time(channel, &schedule_time);
+        vtable->aws_channel_current_clock_time(channel, &schedule_time);
         schedule_time += stream_manager->connection_ping_period_ns;
         aws_channel_task_init(
             &sm_connection->ping_task, s_connection_ping_task, sm_connection, "Stream manager connection ping task");
         /* Keep a refcount on sm_connection for the task to run. */
         aws_ref_count_acquire(&sm_connection->ref_count);
-        aws_channel_schedule_task_future(channel, &sm_connection->ping_task, schedule_time);
+        vtable->aws_channel_schedule_task_future(channel, &sm_connection->ping_task, schedule_time);
     }
     return sm_connection;
 }
@@ -534,7 +576,10 @@ static void s_sm_connection_release_connection(struct aws_h2_sm_connection *sm_c
     AWS_ASSERT(sm_connection->num_streams_assigned == 0);
     if (sm_connection->connection) {
         /* Should only be invoked from the connection thread. */
-        AWS_ASSERT(aws_channel_thread_is_callers_thread(aws_http_connection_get_channel(sm_connection->connection)));
+        const struct aws_http2_stream_manager_system_vtable *vtable = sm_connection->stream_manager->system_vtable;
+        AWS_ASSERT(vtable->aws_channel_thread_is_callers_thread(
+            vtable->aws_http_connection_get_channel(sm_connection->connection)));
+        (void)vtable;
         int error = aws_http_connection_manager_release_connection(
             sm_connection->stream_manager->connection_manager, sm_connection->connection);
         AWS_ASSERT(!error);
@@ -586,7 +631,7 @@ static void s_sm_on_connection_acquired(struct aws_http_connection *connection,
                 aws_error_str(error_code));
             s_sm_on_connection_acquired_failed_synced(stream_manager, &stream_acquisitions_to_fail);
             stream_fail_error_code = AWS_ERROR_HTTP_STREAM_MANAGER_CONNECTION_ACQUIRE_FAILURE;
-        } else if (aws_http_connection_get_version(connection) != AWS_HTTP_VERSION_2) {
+        } else if (stream_manager->system_vtable->aws_http_connection_get_version(connection) != AWS_HTTP_VERSION_2) {
             STREAM_MANAGER_LOGF(
                 ERROR,
                 stream_manager,
@@ -613,10 +658,10 @@ static void s_sm_on_connection_acquired(struct aws_http_connection *connection,
             should_release_connection = true;
         } else {
             struct aws_h2_sm_connection *sm_connection = s_sm_connection_new(stream_manager, connection);
-            bool added = false;
-            re_error |=
-                aws_random_access_set_add(&stream_manager->synced_data.ideal_available_set, sm_connection, &added);
-            re_error |= !added;
+            re_error |= aws_least_loaded_heap_add(
+                &stream_manager->synced_data.available_connections,
+                &sm_connection->available_node,
+                sm_connection->num_streams_assigned);
             ++stream_manager->synced_data.holding_connections_count;
         }
         s_aws_http2_stream_manager_build_transaction_synced(&work);
@@ -654,7 +699,7 @@ static int s_on_incoming_headers(
     if (stream_manager->close_connection_on_server_error) {
         /* Check status code if stream completed successfully. */
         int status_code = 0;
-        aws_http_stream_get_incoming_response_status(stream, &status_code);
+        stream_manager->system_vtable->aws_http_stream_get_incoming_response_status(stream, &status_code);
         AWS_ASSERT(status_code != 0); /* The get status should not fail */
         switch (status_code) {
             case AWS_HTTP_STATUS_CODE_500_INTERNAL_SERVER_ERROR:
@@ -670,7 +715,7 @@ static int s_on_incoming_headers(
                         (void *)sm_connection->connection,
                         status_code,
                         (void *)stream);
-                    aws_http_connection_stop_new_requests(sm_connection->connection);
+                    stream_manager->system_vtable->aws_http_connection_stop_new_requests(sm_connection->connection);
                     sm_connection->thread_data.stopped_new_requests = true;
                 }
                 break;
@@ -717,43 +762,28 @@ static void s_update_sm_connection_set_on_stream_finishes_synced(
      * - figure out where I should be
      * - if they're different, remove from where I am, put where should be
      */
-    if (sm_connection->state == AWS_H2SMCST_NEARLY_FULL && cur_num < ideal_num) {
-        /* this connection is back from soft limited to ideal */
-        bool exist = false;
-        (void)exist;
-        AWS_ASSERT(
-            aws_random_access_set_exist(&stream_manager->synced_data.nonideal_available_set, sm_connection, &exist) ==
-                AWS_OP_SUCCESS &&
-            exist);
-        re_error |= aws_random_access_set_remove(&stream_manager->synced_data.nonideal_available_set, sm_connection);
-        bool added = false;
-        re_error |= aws_random_access_set_add(&stream_manager->synced_data.ideal_available_set, sm_connection, &added);
-        re_error |= !added;
-        sm_connection->state = AWS_H2SMCST_IDEAL;
-    } else if (sm_connection->state == AWS_H2SMCST_FULL && cur_num < max_num) {
-        /* this connection is back from full */
-        STREAM_MANAGER_LOGF(
-            DEBUG,
-            stream_manager,
-            "connection:%p back to available, assigned stream=%zu, max concurrent streams=%" PRIu32 "",
-            (void *)sm_connection->connection,
-            cur_num,
-            sm_connection->max_concurrent_streams);
-        bool added = false;
-        if (cur_num >= ideal_num) {
-            sm_connection->state = AWS_H2SMCST_NEARLY_FULL;
+    if (sm_connection->state == AWS_H2SMCST_FULL) {
+        if (cur_num < max_num) {
+            /* this connection is back from full */
             STREAM_MANAGER_LOGF(
-                TRACE, stream_manager, "connection:%p added to soft limited set", (void *)sm_connection->connection);
-            re_error |=
-                aws_random_access_set_add(&stream_manager->synced_data.nonideal_available_set, sm_connection, &added);
-        } else {
+                DEBUG,
+                stream_manager,
+                "connection:%p back to available, assigned stream=%zu, max concurrent streams=%" PRIu32 "",
+                (void *)sm_connection->connection,
+                cur_num,
+                sm_connection->max_concurrent_streams);
+            sm_connection->state = cur_num >= ideal_num ? AWS_H2SMCST_NEARLY_FULL : AWS_H2SMCST_IDEAL;
+            re_error |= aws_least_loaded_heap_add(
+                &stream_manager->synced_data.available_connections, &sm_connection->available_node, cur_num);
+        }
+    } else if (aws_least_loaded_heap_node_is_in_heap(&sm_connection->available_node)) {
+        /* Still available, the connection just moves towards the top of the heap */
+        aws_least_loaded_heap_update(
+            &stream_manager->synced_data.available_connections, &sm_connection->available_node, cur_num);
+        if (sm_connection->state == AWS_H2SMCST_NEARLY_FULL && cur_num < ideal_num) {
+            /* this connection is back from soft limited to ideal */
             sm_connection->state = AWS_H2SMCST_IDEAL;
-            STREAM_MANAGER_LOGF(
-                TRACE, stream_manager, "connection:%p added to ideal set", (void *)sm_connection->connection);
-            re_error |=
-                aws_random_access_set_add(&stream_manager->synced_data.ideal_available_set, sm_connection, &added);
         }
-        re_error |= !added;
     }
     AWS_ASSERT(re_error == AWS_OP_SUCCESS);
     (void)re_error;
@@ -763,7 +793,8 @@ static void s_sm_connection_on_scheduled_stream_finishes(
     struct aws_h2_sm_connection *sm_connection,
     struct aws_http2_stream_manager *stream_manager) {
     /* Reach the max current will still allow new requests, but the new stream will complete with error */
-    bool connection_available = aws_http_connection_new_requests_allowed(sm_connection->connection);
+    bool connection_available =
+        stream_manager->system_vtable->aws_http_connection_new_requests_allowed(sm_connection->connection);
     struct aws_http2_stream_management_transaction work;
     s_aws_stream_management_transaction_init(&work, stream_manager);
     { /* BEGIN CRITICAL SECTION */
@@ -772,8 +803,8 @@ static void s_sm_connection_on_scheduled_stream_finishes(
         --sm_connection->num_streams_assigned;
         if (!connection_available) {
             /* It might be removed already, but, it's fine */
-            aws_random_access_set_remove(&stream_manager->synced_data.ideal_available_set, sm_connection);
-            aws_random_access_set_remove(&stream_manager->synced_data.nonideal_available_set, sm_connection);
+            aws_least_loaded_heap_remove(
+                &stream_manager->synced_data.available_connections, &sm_connection->available_node);
         } else {
             s_update_sm_connection_set_on_stream_finishes_synced(sm_connection, stream_manager);
         }
@@ -782,7 +813,8 @@ static void s_sm_connection_on_scheduled_stream_finishes(
          * sm_connection */
         if (sm_connection->num_streams_assigned == 0) {
             /* It might be removed already, but, it's fine */
-            aws_random_access_set_remove(&stream_manager->synced_data.ideal_available_set, sm_connection);
+            aws_least_loaded_heap_remove(
+                &stream_manager->synced_data.available_connections, &sm_connection->available_node);
             work.sm_connection_to_release = sm_connection;
             --stream_manager->synced_data.holding_connections_count;
             /* After we release one connection back, we should check if we need more connections */
@@ -796,10 +828,34 @@ static void s_sm_connection_on_scheduled_stream_finishes(
     s_aws_http2_stream_manager_execute_transaction(&work);
 }
 
+/* Feed a completed stream's round trip time to the concurrency limiter */
+static void s_sm_concurrency_limit_on_stream_complete(
+    struct aws_http2_stream_manager *stream_manager,
+    const struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition,
+    int error_code) {
+
+    uint64_t now = 0;
+    if (stream_manager->system_vtable->aws_high_res_clock_get_ticks(&now)) {
+        return;
+    }
+    { /* BEGIN CRITICAL SECTION */
+        s_lock_synced_data(stream_manager);
+        aws_http_concurrency_limiter_on_sample(
+            &stream_manager->synced_data.concurrency_limiter,
+            aws_sub_u64_saturating(now, pending_stream_acquisition->make_request_timestamp_ns),
+            s_get_streams_in_flight_synced(stream_manager),
+            error_code != AWS_ERROR_SUCCESS /*dropped*/);
+        s_unlock_synced_data(stream_manager);
+    } /* END CRITICAL SECTION */
+}
+
 static void s_on_stream_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
     struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition = user_data;
     struct aws_h2_sm_connection *sm_connection = pending_stream_acquisition->sm_connection;
     struct aws_http2_stream_manager *stream_manager = sm_connection->stream_manager;
+    if (stream_manager->concurrency_limit_enabled) {
+        s_sm_concurrency_limit_on_stream_complete(stream_manager, pending_stream_acquisition, error_code);
+    }
     if (pending_stream_acquisition->options.on_complete) {
         pending_stream_acquisition->options.on_complete(
             stream, error_code, pending_stream_acquisition->options.user_data);
@@ -876,7 +932,12 @@ static void s_make_request_task(struct aws_channel_task *task, void *arg, enum a
     /* TODO: we could put the pending acquisition back to the list if the connection is not available for new request.
      */
 
-    struct aws_http_stream *stream = aws_http_connection_make_request(sm_connection->connection, &request_options);
+    if (stream_manager->concurrency_limit_enabled) {
+        stream_manager->system_vtable->aws_high_res_clock_get_ticks(
+            &pending_stream_acquisition->make_request_timestamp_ns);
+    }
+    struct aws_http_stream *stream =
+        stream_manager->system_vtable->aws_http_connection_make_request(sm_connection->connection, &request_options);
     if (!stream) {
         error_code = aws_last_error();
         STREAM_MANAGER_LOGF(
@@ -889,7 +950,7 @@ static void s_make_request_task(struct aws_channel_task *task, void *arg, enum a
         goto error;
     }
     /* Since we're in the connection's thread, this should be safe, there won't be any other callbacks to the user */
-    if (aws_http_stream_activate(stream)) {
+    if (stream_manager->system_vtable->aws_http_stream_activate(stream)) {
         /* Activate failed, the on_completed callback will NOT be invoked from HTTP, but we already told user about
          * the stream. Invoke the user completed callback here */
         error_code = aws_last_error();
@@ -960,14 +1021,15 @@ static void s_aws_http2_stream_manager_execute_transaction(struct aws_http2_stre
          * - The callback will happen asynced even the stream failed to be created
          * - We can make sure we will not break the settings
          */
-        struct aws_channel *channel =
-            aws_http_connection_get_channel(pending_stream_acquisition->sm_connection->connection);
+        struct aws_channel *channel = stream_manager->system_vtable->aws_http_connection_get_channel(
+            pending_stream_acquisition->sm_connection->connection);
         aws_channel_task_init(
             &pending_stream_acquisition->make_request_task,
             s_make_request_task,
             pending_stream_acquisition,
             "Stream manager make request task");
-        aws_channel_schedule_task_now(channel, &pending_stream_acquisition->make_request_task);
+        stream_manager->system_vtable->aws_channel_schedule_task_now(
+            channel, &pending_stream_acquisition->make_request_task);
     }
 
     /* Step 3: Acquire connections if needed */
@@ -995,8 +1057,7 @@ void s_stream_manager_destroy_final(struct aws_http2_stream_manager *stream_mana
     AWS_FATAL_ASSERT(stream_manager->connection_manager == NULL);
     AWS_FATAL_ASSERT(aws_linked_list_empty(&stream_manager->synced_data.pending_stream_acquisitions));
     aws_mutex_clean_up(&stream_manager->synced_data.lock);
-    aws_random_access_set_clean_up(&stream_manager->synced_data.ideal_available_set);
-    aws_random_access_set_clean_up(&stream_manager->synced_data.nonideal_available_set);
+    aws_least_loaded_heap_clean_up(&stream_manager->synced_data.available_connections);
     aws_client_bootstrap_release(stream_manager->bootstrap);
 
     if (stream_manager->shutdown_complete_callback) {
@@ -1018,9 +1079,8 @@ void s_stream_manager_on_cm_shutdown_complete(void *user_data) {
 
 static void s_stream_manager_start_destroy(struct aws_http2_stream_manager *stream_manager) {
     STREAM_MANAGER_LOG(TRACE, stream_manager, "Stream Manager reaches the condition to destroy, start to destroy");
-    /* If there is no outstanding streams, the connections set should be empty. */
-    AWS_ASSERT(aws_random_access_set_get_size(&stream_manager->synced_data.ideal_available_set) == 0);
-    AWS_ASSERT(aws_random_access_set_get_size(&stream_manager->synced_data.nonideal_available_set) == 0);
+    /* If there is no outstanding streams, the connections heap should be empty. */
+    AWS_ASSERT(aws_least_loaded_heap_get_size(&stream_manager->synced_data.available_connections) == 0);
     AWS_ASSERT(stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_CONNECTIONS_ACQUIRING] == 0);
     AWS_ASSERT(stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_OPEN_STREAM] == 0);
     AWS_ASSERT(stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_MAKE_REQUESTS] == 0);
@@ -1067,27 +1127,13 @@ struct aws_http2_stream_manager *aws_http2_stream_manager_new(
     struct aws_http2_stream_manager *stream_manager =
         aws_mem_calloc(allocator, 1, sizeof(struct aws_http2_stream_manager));
     stream_manager->allocator = allocator;
+    stream_manager->system_vtable = g_aws_http2_stream_manager_default_system_vtable_ptr;
     aws_linked_list_init(&stream_manager->synced_data.pending_stream_acquisitions);
 
     if (aws_mutex_init(&stream_manager->synced_data.lock)) {
         goto on_error;
     }
-    if (aws_random_access_set_init(
-            &stream_manager->synced_data.ideal_available_set,
-            allocator,
-            aws_hash_ptr,
-            aws_ptr_eq,
-            NULL /* destroy function */,
-            2)) {
-        goto on_error;
-    }
-    if (aws_random_access_set_init(
-            &stream_manager->synced_data.nonideal_available_set,
-            allocator,
-            aws_hash_ptr,
-            aws_ptr_eq,
-            NULL /* destroy function */,
-            2)) {
+    if (aws_least_loaded_heap_init(&stream_manager->synced_data.available_connections, allocator, 2)) {
         goto on_error;
     }
     aws_ref_count_init(
@@ -1119,6 +1165,19 @@ struct aws_http2_stream_manager *aws_http2_stream_manager_new(
         }
     }
 
+    if (options->concurrency_limit_options) {
+        size_t max_streams_per_connection = options->max_concurrent_streams_per_connection
+                                                ? options->max_concurrent_streams_per_connection
+                                                : UINT32_MAX;
+        if (aws_http_concurrency_limiter_init(
+                &stream_manager->synced_data.concurrency_limiter,
+                options->concurrency_limit_options,
+                aws_mul_size_saturating(options->max_connections, max_streams_per_connection))) {
+            goto on_error;
+        }
+        stream_manager->concurrency_limit_enabled = true;
+    }
+
     stream_manager->bootstrap = aws_client_bootstrap_acquire(options->bootstrap);
     struct aws_http_connection_manager_options cm_options = {
         .bootstrap = options->bootstrap,
@@ -1176,6 +1235,51 @@ struct aws_http2_stream_manager *aws_http2_stream_manager_release(struct aws_htt
     return NULL;
 }
 
+struct aws_h2_sm_reject_acquisition_task {
+    struct aws_task task;
+    struct aws_http2_stream_manager *stream_manager;
+    struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition;
+};
+
+/* Fails an acquisition that the concurrency limit rejected. Runs on an event loop, as the callback must be async. */
+static void s_reject_pending_stream_acquisition_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    (void)status;
+    struct aws_h2_sm_reject_acquisition_task *reject_task = arg;
+    struct aws_http2_stream_manager *stream_manager = reject_task->stream_manager;
+    struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition = reject_task->pending_stream_acquisition;
+
+    STREAM_MANAGER_LOGF(
+        DEBUG,
+        stream_manager,
+        "acquisition:%p failed as the concurrency limit is reached.",
+        (void *)pending_stream_acquisition);
+    if (pending_stream_acquisition->callback) {
+        pending_stream_acquisition->callback(
+            NULL, AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED, pending_stream_acquisition->user_data);
+    }
+    s_pending_stream_acquisition_destroy(pending_stream_acquisition);
+    aws_mem_release(stream_manager->allocator, reject_task);
+    /* May be the last thing keeping the stream manager alive */
+    aws_ref_count_release(&stream_manager->internal_ref_count);
+}
+
+/* NOTE: never invoke with lock held */
+static void s_schedule_reject_pending_stream_acquisition(
+    struct aws_http2_stream_manager *stream_manager,
+    struct aws_h2_sm_pending_stream_acquisition *pending_stream_acquisition) {
+
+    struct aws_h2_sm_reject_acquisition_task *reject_task =
+        aws_mem_calloc(stream_manager->allocator, 1, sizeof(struct aws_h2_sm_reject_acquisition_task));
+    reject_task->stream_manager = stream_manager;
+    reject_task->pending_stream_acquisition = pending_stream_acquisition;
+    aws_task_init(
+        &reject_task->task, s_reject_pending_stream_acquisition_task, reject_task, "sm_reject_stream_acquisition");
+    aws_ref_count_acquire(&stream_manager->internal_ref_count);
+    aws_event_loop_schedule_task_now(
+        aws_event_loop_group_get_next_loop(stream_manager->bootstrap->event_loop_group), &reject_task->task);
+}
+
 void aws_http2_stream_manager_acquire_stream(
     struct aws_http2_stream_manager *stream_manager,
     const struct aws_http2_stream_manager_acquire_stream_options *acquire_stream_option) {
@@ -1192,25 +1296,35 @@ void aws_http2_stream_manager_acquire_stream(
     STREAM_MANAGER_LOGF(
         TRACE, stream_manager, "Stream Manager creates acquisition:%p for user", (void *)pending_stream_acquisition);
     s_aws_stream_management_transaction_init(&work, stream_manager);
+    bool rejected = false;
     { /* BEGIN CRITICAL SECTION */
         s_lock_synced_data(stream_manager);
         /* it's use after free crime */
         AWS_FATAL_ASSERT(stream_manager->synced_data.state != AWS_H2SMST_DESTROYING);
-        aws_linked_list_push_back(
-            &stream_manager->synced_data.pending_stream_acquisitions, &pending_stream_acquisition->node);
-        s_sm_count_increase_synced(stream_manager, AWS_SMCT_PENDING_ACQUISITION, 1);
-        s_aws_http2_stream_manager_build_transaction_synced(&work);
+        if (stream_manager->concurrency_limit_enabled && stream_manager->synced_data.concurrency_limiter.fail_fast &&
+            s_get_concurrency_limit_room_synced(stream_manager) <=
+                stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_ACQUISITION]) {
+            rejected = true;
+        } else {
+            aws_linked_list_push_back(
+                &stream_manager->synced_data.pending_stream_acquisitions, &pending_stream_acquisition->node);
+            s_sm_count_increase_synced(stream_manager, AWS_SMCT_PENDING_ACQUISITION, 1);
+            s_aws_http2_stream_manager_build_transaction_synced(&work);
+        }
         s_unlock_synced_data(stream_manager);
     } /* END CRITICAL SECTION */
+    if (rejected) {
+        s_schedule_reject_pending_stream_acquisition(stream_manager, pending_stream_acquisition);
+    }
     s_aws_http2_stream_manager_execute_transaction(&work);
 }
 
-static size_t s_get_available_streams_num_from_connection_set(const struct aws_random_access_set *set) {
+static size_t s_get_available_streams_num_from_connection_heap(const struct aws_least_loaded_heap *heap) {
     size_t all_available_streams_num = 0;
-    size_t ideal_connection_num = aws_random_access_set_get_size(set);
-    for (size_t i = 0; i < ideal_connection_num; i++) {
-        struct aws_h2_sm_connection *sm_connection = NULL;
-        AWS_FATAL_ASSERT(aws_random_access_set_random_get_ptr_index(set, (void **)&sm_connection, i) == AWS_OP_SUCCESS);
+    size_t available_connection_num = aws_least_loaded_heap_get_size(heap);
+    for (size_t i = 0; i < available_connection_num; i++) {
+        struct aws_h2_sm_connection *sm_connection =
+            AWS_CONTAINER_OF(aws_least_loaded_heap_get_index(heap, i), struct aws_h2_sm_connection, available_node);
         uint32_t available_streams = sm_connection->max_concurrent_streams - sm_connection->num_streams_assigned;
         all_available_streams_num += (size_t)available_streams;
     }
@@ -1224,15 +1338,16 @@ void aws_http2_stream_manager_fetch_metrics(
     AWS_PRECONDITION(out_metrics);
     { /* BEGIN CRITICAL SECTION */
         s_lock_synced_data((struct aws_http2_stream_manager *)(void *)stream_manager);
-        size_t all_available_streams_num = 0;
-        all_available_streams_num +=
-            s_get_available_streams_num_from_connection_set(&stream_manager->synced_data.ideal_available_set);
-        all_available_streams_num +=
-            s_get_available_streams_num_from_connection_set(&stream_manager->synced_data.nonideal_available_set);
+        size_t all_available_streams_num =
+            s_get_available_streams_num_from_connection_heap(&stream_manager->synced_data.available_connections);
         out_metrics->pending_concurrency_acquires =
             stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_PENDING_ACQUISITION];
         out_metrics->available_concurrency = all_available_streams_num;
         out_metrics->leased_concurrency = stream_manager->synced_data.internal_refcount_stats[AWS_SMCT_OPEN_STREAM];
+        out_metrics->concurrency_limit =
+            stream_manager->concurrency_limit_enabled
+                ? aws_http_concurrency_limiter_get_limit(&stream_manager->synced_data.concurrency_limiter)
+                : 0;
         s_unlock_synced_data((struct aws_http2_stream_manager *)(void *)stream_manager);
     } /* END CRITICAL SECTION */
 }
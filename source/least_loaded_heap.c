@@ -0,0 +1,174 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/least_loaded_heap.h>
+
+static struct aws_least_loaded_heap_node *s_node_at(const struct aws_least_loaded_heap *heap, size_t index) {
+    struct aws_least_loaded_heap_node *node = NULL;
+    int err = aws_array_list_get_at(&heap->nodes, &node, index);
+    AWS_ASSERT(!err);
+    (void)err;
+    return node;
+}
+
+static void s_set_node_at(struct aws_least_loaded_heap *heap, size_t index, struct aws_least_loaded_heap_node *node) {
+    int err = aws_array_list_set_at(&heap->nodes, &node, index);
+    AWS_ASSERT(!err);
+    (void)err;
+    node->index = index;
+}
+
+/* Move node towards the root until its parent is no more loaded. Returns true if it moved. */
+static bool s_sift_up(struct aws_least_loaded_heap *heap, struct aws_least_loaded_heap_node *node) {
+    size_t index = node->index;
+    while (index > 0) {
+        size_t parent_index = (index - 1) / 2;
+        struct aws_least_loaded_heap_node *parent = s_node_at(heap, parent_index);
+        if (parent->load <= node->load) {
+            break;
+        }
+        s_set_node_at(heap, index, parent);
+        index = parent_index;
+    }
+
+    bool moved = index != node->index;
+    s_set_node_at(heap, index, node);
+    return moved;
+}
+
+/* Move node towards the leaves until neither child is less loaded */
+static void s_sift_down(struct aws_least_loaded_heap *heap, struct aws_least_loaded_heap_node *node) {
+    const size_t size = aws_array_list_length(&heap->nodes);
+    size_t index = node->index;
+    while (true) {
+        size_t child_index = index * 2 + 1;
+        if (child_index >= size) {
+            break;
+        }
+        struct aws_least_loaded_heap_node *child = s_node_at(heap, child_index);
+        if (child_index + 1 < size) {
+            struct aws_least_loaded_heap_node *right = s_node_at(heap, child_index + 1);
+            if (right->load < child->load) {
+                child = right;
+                ++child_index;
+            }
+        }
+        if (node->load <= child->load) {
+            break;
+        }
+        s_set_node_at(heap, index, child);
+        index = child_index;
+    }
+
+    s_set_node_at(heap, index, node);
+}
+
+int aws_least_loaded_heap_init(
+    struct aws_least_loaded_heap *heap,
+    struct aws_allocator *allocator,
+    size_t initial_item_allocation) {
+    AWS_FATAL_PRECONDITION(heap);
+    AWS_FATAL_PRECONDITION(allocator);
+
+    return aws_array_list_init_dynamic(
+        &heap->nodes, allocator, initial_item_allocation, sizeof(struct aws_least_loaded_heap_node *));
+}
+
+void aws_least_loaded_heap_clean_up(struct aws_least_loaded_heap *heap) {
+    if (!heap) {
+        return;
+    }
+    aws_array_list_clean_up(&heap->nodes);
+}
+
+void aws_least_loaded_heap_node_init(struct aws_least_loaded_heap_node *node) {
+    AWS_PRECONDITION(node);
+    node->index = AWS_LEAST_LOADED_HEAP_NOT_IN_HEAP;
+    node->load = 0;
+}
+
+bool aws_least_loaded_heap_node_is_in_heap(const struct aws_least_loaded_heap_node *node) {
+    AWS_PRECONDITION(node);
+    return node->index != AWS_LEAST_LOADED_HEAP_NOT_IN_HEAP;
+}
+
+int aws_least_loaded_heap_add(
+    struct aws_least_loaded_heap *heap,
+    struct aws_least_loaded_heap_node *node,
+    uint64_t load) {
+    AWS_PRECONDITION(heap);
+    AWS_PRECONDITION(node);
+    AWS_PRECONDITION(!aws_least_loaded_heap_node_is_in_heap(node));
+
+    if (aws_array_list_push_back(&heap->nodes, &node)) {
+        return AWS_OP_ERR;
+    }
+    node->index = aws_array_list_length(&heap->nodes) - 1;
+    node->load = load;
+    s_sift_up(heap, node);
+    return AWS_OP_SUCCESS;
+}
+
+void aws_least_loaded_heap_remove(struct aws_least_loaded_heap *heap, struct aws_least_loaded_heap_node *node) {
+    AWS_PRECONDITION(heap);
+    AWS_PRECONDITION(node);
+    if (!aws_least_loaded_heap_node_is_in_heap(node)) {
+        return;
+    }
+
+    const size_t last_index = aws_array_list_length(&heap->nodes) - 1;
+    AWS_ASSERT(node->index <= last_index && s_node_at(heap, node->index) == node);
+    struct aws_least_loaded_heap_node *last = s_node_at(heap, last_index);
+    aws_array_list_pop_back(&heap->nodes);
+
+    if (last != node) {
+        /* Fill the hole with the last node, then restore its position */
+        last->index = node->index;
+        if (!s_sift_up(heap, last)) {
+            s_sift_down(heap, last);
+        }
+    }
+    node->index = AWS_LEAST_LOADED_HEAP_NOT_IN_HEAP;
+}
+
+void aws_least_loaded_heap_update(
+    struct aws_least_loaded_heap *heap,
+    struct aws_least_loaded_heap_node *node,
+    uint64_t load) {
+    AWS_PRECONDITION(heap);
+    AWS_PRECONDITION(node);
+    AWS_PRECONDITION(aws_least_loaded_heap_node_is_in_heap(node));
+
+    const uint64_t prev_load = node->load;
+    node->load = load;
+    if (load < prev_load) {
+        s_sift_up(heap, node);
+    } else if (load > prev_load) {
+        s_sift_down(heap, node);
+    }
+}
+
+struct aws_least_loaded_heap_node *aws_least_loaded_heap_peek(const struct aws_least_loaded_heap *heap) {
+    AWS_PRECONDITION(heap);
+    if (aws_array_list_length(&heap->nodes) == 0) {
+        return NULL;
+    }
+    return s_node_at(heap, 0);
+}
+
+size_t aws_least_loaded_heap_get_size(const struct aws_least_loaded_heap *heap) {
+    AWS_PRECONDITION(heap);
+    return aws_array_list_length(&heap->nodes);
+}
+
+struct aws_least_loaded_heap_node *aws_least_loaded_heap_get_index(
+    const struct aws_least_loaded_heap *heap,
+    size_t index) {
+    AWS_PRECONDITION(heap);
+    if (index >= aws_array_list_length(&heap->nodes)) {
+        return NULL;
+    }
+    return s_node_at(heap, index);
+}
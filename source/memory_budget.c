@@ -0,0 +1,112 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/memory_budget_impl.h>
+
+#include <aws/common/clock.h>
+
+#include <inttypes.h>
+
+static void s_memory_budget_destroy(void *user_data) {
+    struct aws_http_memory_budget *budget = user_data;
+
+    AWS_LOGF_DEBUG(AWS_LS_HTTP_GENERAL, "id=%p: Destroying memory budget.", (void *)budget);
+    AWS_ASSERT(aws_atomic_load_int(&budget->reserved) == 0 && "Some reservation was never returned");
+
+    aws_mem_release(budget->alloc, budget);
+}
+
+struct aws_http_memory_budget *aws_http_memory_budget_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_memory_budget_options *options) {
+
+    AWS_PRECONDITION(allocator);
+    AWS_PRECONDITION(options);
+
+    if (options->max_bytes == 0) {
+        AWS_LOGF_ERROR(AWS_LS_HTTP_GENERAL, "static: Cannot create memory budget, max_bytes must be non-zero.");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    struct aws_http_memory_budget *budget = aws_mem_calloc(allocator, 1, sizeof(struct aws_http_memory_budget));
+    budget->alloc = allocator;
+    aws_ref_count_init(&budget->ref_count, budget, s_memory_budget_destroy);
+    budget->max_bytes = options->max_bytes;
+
+    uint64_t retry_interval_ms = options->retry_interval_ms ? options->retry_interval_ms
+                                                            : AWS_HTTP_MEMORY_BUDGET_DEFAULT_RETRY_INTERVAL_MS;
+    budget->retry_interval_ns =
+        aws_timestamp_convert(retry_interval_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+
+    aws_atomic_init_int(&budget->reserved, 0);
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_GENERAL,
+        "id=%p: Created memory budget of %zu bytes, retry interval %" PRIu64 "ms.",
+        (void *)budget,
+        budget->max_bytes,
+        retry_interval_ms);
+
+    return budget;
+}
+
+struct aws_http_memory_budget *aws_http_memory_budget_acquire(struct aws_http_memory_budget *budget) {
+    if (budget) {
+        aws_ref_count_acquire(&budget->ref_count);
+    }
+    return budget;
+}
+
+struct aws_http_memory_budget *aws_http_memory_budget_release(struct aws_http_memory_budget *budget) {
+    if (budget) {
+        aws_ref_count_release(&budget->ref_count);
+    }
+    return NULL;
+}
+
+size_t aws_http_memory_budget_reserve(struct aws_http_memory_budget *budget, size_t size) {
+    AWS_PRECONDITION(budget);
+
+    size_t reserved = aws_atomic_load_int(&budget->reserved);
+    while (true) {
+        size_t available = aws_sub_size_saturating(budget->max_bytes, reserved);
+        size_t granted = aws_min_size(size, available);
+        if (granted == 0) {
+            return 0;
+        }
+
+        /* On failure, `reserved` is updated to the current value and we try again */
+        if (aws_atomic_compare_exchange_int(&budget->reserved, &reserved, reserved + granted)) {
+            return granted;
+        }
+    }
+}
+
+void aws_http_memory_budget_reserve_forced(struct aws_http_memory_budget *budget, size_t size) {
+    AWS_PRECONDITION(budget);
+    aws_atomic_fetch_add(&budget->reserved, size);
+}
+
+void aws_http_memory_budget_unreserve(struct aws_http_memory_budget *budget, size_t size) {
+    AWS_PRECONDITION(budget);
+    size_t prev = aws_atomic_fetch_sub(&budget->reserved, size);
+    AWS_FATAL_ASSERT(prev >= size && "Returned more bytes than were reserved");
+    (void)prev;
+}
+
+size_t aws_http_memory_budget_get_reserved(const struct aws_http_memory_budget *budget) {
+    AWS_PRECONDITION(budget);
+    return aws_atomic_load_int(&budget->reserved);
+}
+
+size_t aws_http_memory_budget_get_available(const struct aws_http_memory_budget *budget) {
+    AWS_PRECONDITION(budget);
+    return aws_sub_size_saturating(budget->max_bytes, aws_http_memory_budget_get_reserved(budget));
+}
+
+bool aws_http_memory_budget_is_exhausted(const struct aws_http_memory_budget *budget) {
+    return aws_http_memory_budget_get_reserved(budget) >= budget->max_bytes;
+}
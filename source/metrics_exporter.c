@@ -0,0 +1,844 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/metrics_exporter.h>
+
+#include <aws/common/array_list.h>
+#include <aws/common/atomics.h>
+#include <aws/common/mutex.h>
+#include <aws/common/ref_count.h>
+#include <aws/common/string.h>
+#include <aws/common/thread.h>
+#include <aws/http/connection_manager.h>
+#include <aws/http/http2_stream_manager.h>
+#include <aws/http/private/http_impl.h>
+#include <aws/http/request_response.h>
+#include <aws/http/statistics.h>
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#    pragma warning(disable : 4996) /* Disable warnings about vsnprintf() being insecure */
+#endif
+
+/* Recording threads are spread across this many shards. Threads beyond that share. */
+#define METRICS_SHARD_COUNT 16
+#define METRICS_MAX_BUCKETS 16
+/* Keeps every rendered line within s_appendf()'s buffer */
+#define METRICS_MAX_PREFIX_LEN 64
+
+/* Counters and histograms accumulate 64-bit values, so byte counts and duration sums don't wrap.
+ * Atomics are only as wide as size_t, so where that's narrower, each shard has a lock instead. */
+#if SIZE_MAX >= UINT64_MAX
+#    define METRICS_ATOMIC_VALUES 1
+#endif
+
+enum metrics_counter {
+    METRICS_COUNTER_STREAMS,
+    METRICS_COUNTER_STREAM_ERRORS,
+    METRICS_COUNTER_SAMPLES_H1,
+    METRICS_COUNTER_SAMPLES_H2,
+    METRICS_COUNTER_SAMPLES_WEBSOCKET,
+    METRICS_COUNTER_OUTGOING_PENDING_MS_H1,
+    METRICS_COUNTER_OUTGOING_PENDING_MS_H2,
+    METRICS_COUNTER_INCOMING_PENDING_MS_H1,
+    METRICS_COUNTER_INCOMING_PENDING_MS_H2,
+    METRICS_COUNTER_INACTIVE_SAMPLES_H2,
+    METRICS_COUNTER_COUNT,
+};
+
+enum metrics_histogram {
+    METRICS_HISTOGRAM_STREAM_SEND_DURATION,
+    METRICS_HISTOGRAM_STREAM_RECEIVE_DURATION,
+    METRICS_HISTOGRAM_RESIDENT_BYTES_H1,
+    METRICS_HISTOGRAM_RESIDENT_BYTES_H2,
+    METRICS_HISTOGRAM_RESIDENT_BYTES_WEBSOCKET,
+    METRICS_HISTOGRAM_COUNT,
+};
+
+/* Entries with the same name must be adjacent, so they're rendered as one metric family */
+struct metrics_counter_info {
+    const char *name;
+    const char *labels;
+    const char *help;
+    uint64_t divisor; /* Recorded units per rendered unit */
+};
+
+static const struct metrics_counter_info s_counter_info[METRICS_COUNTER_COUNT] = {
+    [METRICS_COUNTER_STREAMS] = {"streams", "", "Streams completed.", 1},
+    [METRICS_COUNTER_STREAM_ERRORS] = {"stream_errors", "", "Streams completed with an error.", 1},
+    [METRICS_COUNTER_SAMPLES_H1] =
+        {"connection_statistics_samples", "{protocol=\"http1\"}", "Connection statistics samples recorded.", 1},
+    [METRICS_COUNTER_SAMPLES_H2] = {"connection_statistics_samples", "{protocol=\"http2\"}", NULL, 1},
+    [METRICS_COUNTER_SAMPLES_WEBSOCKET] = {"connection_statistics_samples", "{protocol=\"websocket\"}", NULL, 1},
+    [METRICS_COUNTER_OUTGOING_PENDING_MS_H1] =
+        {"connection_outgoing_stream_pending_seconds",
+         "{protocol=\"http1\"}",
+         "Time connections spent with an outgoing stream in progress.",
+         1000},
+    [METRICS_COUNTER_OUTGOING_PENDING_MS_H2] =
+        {"connection_outgoing_stream_pending_seconds", "{protocol=\"http2\"}", NULL, 1000},
+    [METRICS_COUNTER_INCOMING_PENDING_MS_H1] =
+        {"connection_incoming_stream_pending_seconds",
+         "{protocol=\"http1\"}",
+         "Time connections spent with an incoming stream in progress.",
+         1000},
+    [METRICS_COUNTER_INCOMING_PENDING_MS_H2] =
+        {"connection_incoming_stream_pending_seconds", "{protocol=\"http2\"}", NULL, 1000},
+    [METRICS_COUNTER_INACTIVE_SAMPLES_H2] =
+        {"connection_inactive_samples",
+         "{protocol=\"http2\"}",
+         "Statistics samples during which a connection had no active streams at some point.",
+         1},
+};
+
+static const uint64_t s_duration_bounds_ns[] = {
+    1000000,
+    2500000,
+    5000000,
+    10000000,
+    25000000,
+    50000000,
+    100000000,
+    250000000,
+    500000000,
+    1000000000,
+    2500000000,
+    5000000000,
+    10000000000,
+};
+
+static const uint64_t s_resident_bytes_bounds[] = {
+    1024,
+    4 * 1024,
+    16 * 1024,
+    64 * 1024,
+    256 * 1024,
+    1024 * 1024,
+    4 * 1024 * 1024,
+    16 * 1024 * 1024,
+};
+
+struct metrics_histogram_info {
+    const char *name;
+    const char *label; /* Extra label, rendered before `le` */
+    const char *help;
+    const uint64_t *bounds; /* Upper bounds, in recorded units. A final +Inf bucket is implied */
+    size_t bound_count;
+    double divisor;          /* Recorded units per rendered unit */
+    uint64_t sum_resolution; /* Recorded units per unit of the stored sum, so the sum doesn't overflow */
+};
+
+static const struct metrics_histogram_info s_histogram_info[METRICS_HISTOGRAM_COUNT] = {
+    [METRICS_HISTOGRAM_STREAM_SEND_DURATION] =
+        {"stream_send_duration_seconds",
+         "",
+         "Time from a stream starting to send until it finished sending.",
+         s_duration_bounds_ns,
+         AWS_ARRAY_SIZE(s_duration_bounds_ns),
+         1e9,
+         1000},
+    [METRICS_HISTOGRAM_STREAM_RECEIVE_DURATION] =
+        {"stream_receive_duration_seconds",
+         "",
+         "Time from a stream starting to receive until it finished receiving.",
+         s_duration_bounds_ns,
+         AWS_ARRAY_SIZE(s_duration_bounds_ns),
+         1e9,
+         1000},
+    [METRICS_HISTOGRAM_RESIDENT_BYTES_H1] =
+        {"connection_resident_bytes",
+         "protocol=\"http1\",",
+         "Approximate heap bytes held by a connection, per statistics sample.",
+         s_resident_bytes_bounds,
+         AWS_ARRAY_SIZE(s_resident_bytes_bounds),
+         1,
+         1},
+    [METRICS_HISTOGRAM_RESIDENT_BYTES_H2] =
+        {"connection_resident_bytes",
+         "protocol=\"http2\",",
+         NULL,
+         s_resident_bytes_bounds,
+         AWS_ARRAY_SIZE(s_resident_bytes_bounds),
+         1,
+         1},
+    [METRICS_HISTOGRAM_RESIDENT_BYTES_WEBSOCKET] =
+        {"connection_resident_bytes",
+         "protocol=\"websocket\",",
+         NULL,
+         s_resident_bytes_bounds,
+         AWS_ARRAY_SIZE(s_resident_bytes_bounds),
+         1,
+         1},
+};
+
+/* A 64-bit value, only touched through s_value_add() and s_value_load() */
+struct metrics_value {
+#ifdef METRICS_ATOMIC_VALUES
+    struct aws_atomic_var atomic;
+#else
+    uint64_t plain;
+#endif
+};
+
+struct metrics_histogram_shard {
+    struct metrics_value buckets[METRICS_MAX_BUCKETS];
+    struct metrics_value sum;
+};
+
+struct metrics_shard {
+#ifndef METRICS_ATOMIC_VALUES
+    /* Held around every access to the values below */
+    struct aws_mutex lock;
+#endif
+    struct metrics_value counters[METRICS_COUNTER_COUNT];
+    struct metrics_histogram_shard histograms[METRICS_HISTOGRAM_COUNT];
+    /* So neighboring shards, written by different threads, never share a cache line */
+    AWS_HTTP_CACHE_LINE_PADDING(padding);
+};
+
+struct metrics_manager_entry {
+    struct aws_string *name;
+    struct aws_http_connection_manager *connection_manager;
+    struct aws_http2_stream_manager *stream_manager;
+};
+
+struct aws_http_metrics_exporter {
+    struct aws_allocator *alloc;
+    struct aws_ref_count ref_count;
+    struct aws_string *prefix;
+
+    struct metrics_shard shards[METRICS_SHARD_COUNT];
+
+    /* Only taken to add, remove, or render managers. Never while recording. */
+    struct aws_mutex managers_lock;
+    struct aws_array_list managers; /* struct metrics_manager_entry */
+};
+
+/* 0 until this thread first records a metric, then its slot + 1 */
+static AWS_THREAD_LOCAL size_t tl_shard_slot = 0;
+static struct aws_atomic_var s_next_shard_slot = AWS_ATOMIC_INIT_INT(0);
+
+static struct metrics_shard *s_get_shard(struct aws_http_metrics_exporter *exporter) {
+    if (tl_shard_slot == 0) {
+        tl_shard_slot = aws_atomic_fetch_add(&s_next_shard_slot, 1) + 1;
+    }
+    return &exporter->shards[(tl_shard_slot - 1) % METRICS_SHARD_COUNT];
+}
+
+static void s_shard_lock(struct metrics_shard *shard) {
+#ifdef METRICS_ATOMIC_VALUES
+    (void)shard;
+#else
+    aws_mutex_lock(&shard->lock);
+#endif
+}
+
+static void s_shard_unlock(struct metrics_shard *shard) {
+#ifdef METRICS_ATOMIC_VALUES
+    (void)shard;
+#else
+    aws_mutex_unlock(&shard->lock);
+#endif
+}
+
+/* Call between s_shard_lock() and s_shard_unlock() */
+static void s_value_add(struct metrics_value *var, uint64_t value) {
+#ifdef METRICS_ATOMIC_VALUES
+    aws_atomic_fetch_add_explicit(&var->atomic, (size_t)value, aws_memory_order_relaxed);
+#else
+    var->plain += value;
+#endif
+}
+
+/* Call between s_shard_lock() and s_shard_unlock() */
+static uint64_t s_value_load(const struct metrics_value *var) {
+#ifdef METRICS_ATOMIC_VALUES
+    return aws_atomic_load_int_explicit(&var->atomic, aws_memory_order_relaxed);
+#else
+    return var->plain;
+#endif
+}
+
+static void s_counter_add(struct metrics_shard *shard, enum metrics_counter counter, uint64_t value) {
+    s_shard_lock(shard);
+    s_value_add(&shard->counters[counter], value);
+    s_shard_unlock(shard);
+}
+
+static void s_histogram_record(struct metrics_shard *shard, enum metrics_histogram histogram, uint64_t value) {
+    const struct metrics_histogram_info *info = &s_histogram_info[histogram];
+    size_t bucket = 0;
+    while (bucket < info->bound_count && value > info->bounds[bucket]) {
+        ++bucket;
+    }
+    struct metrics_histogram_shard *histogram_shard = &shard->histograms[histogram];
+    s_shard_lock(shard);
+    s_value_add(&histogram_shard->buckets[bucket], 1);
+    s_value_add(&histogram_shard->sum, value / info->sum_resolution);
+    s_shard_unlock(shard);
+}
+
+static bool s_is_valid_prefix(struct aws_byte_cursor prefix) {
+    if (prefix.len > METRICS_MAX_PREFIX_LEN) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.len; ++i) {
+        uint8_t c = prefix.ptr[i];
+        bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' ||
+                     (i > 0 && c >= '0' && c <= '9');
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void s_remove_manager_at(struct aws_http_metrics_exporter *exporter, size_t index) {
+    struct metrics_manager_entry entry;
+    aws_array_list_get_at(&exporter->managers, &entry, index);
+    aws_array_list_erase(&exporter->managers, index);
+    aws_string_destroy(entry.name);
+    if (entry.connection_manager) {
+        aws_http_connection_manager_release(entry.connection_manager);
+    }
+    aws_http2_stream_manager_release(entry.stream_manager);
+}
+
+static void s_metrics_exporter_destroy(void *user_data) {
+    struct aws_http_metrics_exporter *exporter = user_data;
+
+    AWS_LOGF_DEBUG(AWS_LS_HTTP_GENERAL, "id=%p: Destroying metrics exporter.", (void *)exporter);
+
+    while (aws_array_list_length(&exporter->managers) > 0) {
+        s_remove_manager_at(exporter, aws_array_list_length(&exporter->managers) - 1);
+    }
+    aws_array_list_clean_up(&exporter->managers);
+    aws_mutex_clean_up(&exporter->managers_lock);
+#ifndef METRICS_ATOMIC_VALUES
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        aws_mutex_clean_up(&exporter->shards[s].lock);
+    }
+#endif
+    aws_string_destroy(exporter->prefix);
+    aws_mem_release(exporter->alloc, exporter);
+}
+
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_metrics_exporter_options *options) {
+
+    AWS_PRECONDITION(allocator);
+    AWS_PRECONDITION(options);
+
+    struct aws_byte_cursor prefix = options->prefix.len ? options->prefix : aws_byte_cursor_from_c_str("aws_http");
+    if (!s_is_valid_prefix(prefix)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_GENERAL,
+            "static: Cannot create metrics exporter, prefix \"" PRInSTR "\" is not a valid metric name.",
+            AWS_BYTE_CURSOR_PRI(prefix));
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    struct aws_http_metrics_exporter *exporter =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_http_metrics_exporter));
+    exporter->alloc = allocator;
+    aws_ref_count_init(&exporter->ref_count, exporter, s_metrics_exporter_destroy);
+
+    exporter->prefix = aws_string_new_from_cursor(allocator, &prefix);
+    if (!exporter->prefix) {
+        goto error;
+    }
+    if (aws_mutex_init(&exporter->managers_lock)) {
+        goto error;
+    }
+    if (aws_array_list_init_dynamic(&exporter->managers, allocator, 4, sizeof(struct metrics_manager_entry))) {
+        aws_mutex_clean_up(&exporter->managers_lock);
+        goto error;
+    }
+
+#ifdef METRICS_ATOMIC_VALUES
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        struct metrics_shard *shard = &exporter->shards[s];
+        for (size_t c = 0; c < METRICS_COUNTER_COUNT; ++c) {
+            aws_atomic_init_int(&shard->counters[c].atomic, 0);
+        }
+        for (size_t h = 0; h < METRICS_HISTOGRAM_COUNT; ++h) {
+            for (size_t b = 0; b < METRICS_MAX_BUCKETS; ++b) {
+                aws_atomic_init_int(&shard->histograms[h].buckets[b].atomic, 0);
+            }
+            aws_atomic_init_int(&shard->histograms[h].sum.atomic, 0);
+        }
+    }
+#else
+    /* The values are already zeroed by calloc */
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        if (aws_mutex_init(&exporter->shards[s].lock)) {
+            while (s > 0) {
+                aws_mutex_clean_up(&exporter->shards[--s].lock);
+            }
+            aws_array_list_clean_up(&exporter->managers);
+            aws_mutex_clean_up(&exporter->managers_lock);
+            goto error;
+        }
+    }
+#endif
+
+    AWS_LOGF_DEBUG(AWS_LS_HTTP_GENERAL, "id=%p: Created metrics exporter.", (void *)exporter);
+    return exporter;
+
+error:
+    aws_string_destroy(exporter->prefix);
+    aws_mem_release(allocator, exporter);
+    return NULL;
+}
+
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_acquire(struct aws_http_metrics_exporter *exporter) {
+    if (exporter) {
+        aws_ref_count_acquire(&exporter->ref_count);
+    }
+    return exporter;
+}
+
+struct aws_http_metrics_exporter *aws_http_metrics_exporter_release(struct aws_http_metrics_exporter *exporter) {
+    if (exporter) {
+        aws_ref_count_release(&exporter->ref_count);
+    }
+    return NULL;
+}
+
+static int s_add_manager(struct aws_http_metrics_exporter *exporter, struct metrics_manager_entry *entry) {
+    aws_mutex_lock(&exporter->managers_lock);
+    int result = aws_array_list_push_back(&exporter->managers, entry);
+    aws_mutex_unlock(&exporter->managers_lock);
+    return result;
+}
+
+int aws_http_metrics_exporter_add_connection_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http_connection_manager *manager,
+    struct aws_byte_cursor name) {
+
+    AWS_PRECONDITION(exporter);
+    AWS_PRECONDITION(manager);
+
+    struct metrics_manager_entry entry = {
+        .name = aws_string_new_from_cursor(exporter->alloc, &name),
+        .connection_manager = manager,
+    };
+    if (!entry.name) {
+        return AWS_OP_ERR;
+    }
+    aws_http_connection_manager_acquire(manager);
+    if (s_add_manager(exporter, &entry)) {
+        aws_http_connection_manager_release(manager);
+        aws_string_destroy(entry.name);
+        return AWS_OP_ERR;
+    }
+    return AWS_OP_SUCCESS;
+}
+
+int aws_http_metrics_exporter_add_stream_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http2_stream_manager *manager,
+    struct aws_byte_cursor name) {
+
+    AWS_PRECONDITION(exporter);
+    AWS_PRECONDITION(manager);
+
+    struct metrics_manager_entry entry = {
+        .name = aws_string_new_from_cursor(exporter->alloc, &name),
+        .stream_manager = manager,
+    };
+    if (!entry.name) {
+        return AWS_OP_ERR;
+    }
+    aws_http2_stream_manager_acquire(manager);
+    if (s_add_manager(exporter, &entry)) {
+        aws_http2_stream_manager_release(manager);
+        aws_string_destroy(entry.name);
+        return AWS_OP_ERR;
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static void s_remove_manager(struct aws_http_metrics_exporter *exporter, const void *manager) {
+    aws_mutex_lock(&exporter->managers_lock);
+    for (size_t i = 0; i < aws_array_list_length(&exporter->managers); ++i) {
+        struct metrics_manager_entry *entry = NULL;
+        aws_array_list_get_at_ptr(&exporter->managers, (void **)&entry, i);
+        if ((const void *)entry->connection_manager == manager || (const void *)entry->stream_manager == manager) {
+            s_remove_manager_at(exporter, i);
+            break;
+        }
+    }
+    aws_mutex_unlock(&exporter->managers_lock);
+}
+
+void aws_http_metrics_exporter_remove_connection_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http_connection_manager *manager) {
+    AWS_PRECONDITION(exporter);
+    s_remove_manager(exporter, manager);
+}
+
+void aws_http_metrics_exporter_remove_stream_manager(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_http2_stream_manager *manager) {
+    AWS_PRECONDITION(exporter);
+    s_remove_manager(exporter, manager);
+}
+
+void aws_http_metrics_exporter_on_statistics(
+    size_t connection_nonce,
+    const struct aws_array_list *stats_list,
+    void *user_data) {
+
+    (void)connection_nonce;
+    struct aws_http_metrics_exporter *exporter = user_data;
+    AWS_PRECONDITION(exporter);
+    AWS_PRECONDITION(stats_list);
+    struct metrics_shard *shard = s_get_shard(exporter);
+
+    for (size_t i = 0; i < aws_array_list_length(stats_list); ++i) {
+        struct aws_crt_statistics_base *stats_base = NULL;
+        if (aws_array_list_get_at(stats_list, &stats_base, i)) {
+            continue;
+        }
+
+        switch (stats_base->category) {
+            case AWSCRT_STAT_CAT_HTTP1_CHANNEL: {
+                struct aws_crt_statistics_http1_channel *stats = (void *)stats_base;
+                s_counter_add(shard, METRICS_COUNTER_SAMPLES_H1, 1);
+                s_counter_add(shard, METRICS_COUNTER_OUTGOING_PENDING_MS_H1, stats->pending_outgoing_stream_ms);
+                s_counter_add(shard, METRICS_COUNTER_INCOMING_PENDING_MS_H1, stats->pending_incoming_stream_ms);
+                s_histogram_record(shard, METRICS_HISTOGRAM_RESIDENT_BYTES_H1, stats->resident_bytes);
+                break;
+            }
+            case AWSCRT_STAT_CAT_HTTP2_CHANNEL: {
+                struct aws_crt_statistics_http2_channel *stats = (void *)stats_base;
+                s_counter_add(shard, METRICS_COUNTER_SAMPLES_H2, 1);
+                s_counter_add(shard, METRICS_COUNTER_OUTGOING_PENDING_MS_H2, stats->pending_outgoing_stream_ms);
+                s_counter_add(shard, METRICS_COUNTER_INCOMING_PENDING_MS_H2, stats->pending_incoming_stream_ms);
+                if (stats->was_inactive) {
+                    s_counter_add(shard, METRICS_COUNTER_INACTIVE_SAMPLES_H2, 1);
+                }
+                s_histogram_record(shard, METRICS_HISTOGRAM_RESIDENT_BYTES_H2, stats->resident_bytes);
+                break;
+            }
+            case AWSCRT_STAT_CAT_WEBSOCKET_CHANNEL: {
+                struct aws_crt_statistics_websocket_channel *stats = (void *)stats_base;
+                s_counter_add(shard, METRICS_COUNTER_SAMPLES_WEBSOCKET, 1);
+                s_histogram_record(shard, METRICS_HISTOGRAM_RESIDENT_BYTES_WEBSOCKET, stats->resident_bytes);
+                break;
+            }
+            default:
+                /* Socket and TLS statistics aren't ours to report */
+                break;
+        }
+    }
+}
+
+void aws_http_metrics_exporter_record_stream(
+    struct aws_http_metrics_exporter *exporter,
+    const struct aws_http_stream_metrics *metrics,
+    int error_code) {
+
+    AWS_PRECONDITION(exporter);
+    AWS_PRECONDITION(metrics);
+    struct metrics_shard *shard = s_get_shard(exporter);
+
+    s_counter_add(shard, METRICS_COUNTER_STREAMS, 1);
+    if (error_code) {
+        s_counter_add(shard, METRICS_COUNTER_STREAM_ERRORS, 1);
+    }
+    /* -1 means the stream never got that far */
+    if (metrics->sending_duration_ns >= 0) {
+        s_histogram_record(shard, METRICS_HISTOGRAM_STREAM_SEND_DURATION, (uint64_t)metrics->sending_duration_ns);
+    }
+    if (metrics->receiving_duration_ns >= 0) {
+        s_histogram_record(
+            shard, METRICS_HISTOGRAM_STREAM_RECEIVE_DURATION, (uint64_t)metrics->receiving_duration_ns);
+    }
+}
+
+/*****************************************************************************************************************
+ * Rendering
+ ****************************************************************************************************************/
+
+static int s_appendf(struct aws_byte_buf *output, const char *format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    AWS_FATAL_ASSERT(len >= 0 && (size_t)len < sizeof(text));
+
+    struct aws_byte_cursor cursor = aws_byte_cursor_from_array(text, (size_t)len);
+    return aws_byte_buf_append_dynamic(output, &cursor);
+}
+
+/* Label values must escape backslash, double-quote, and line feed */
+static int s_append_label_value(struct aws_byte_buf *output, const struct aws_string *value) {
+    const uint8_t *bytes = aws_string_bytes(value);
+    for (size_t i = 0; i < value->len; ++i) {
+        int err = AWS_OP_SUCCESS;
+        switch (bytes[i]) {
+            case '\\':
+                err = s_appendf(output, "\\\\");
+                break;
+            case '"':
+                err = s_appendf(output, "\\\"");
+                break;
+            case '\n':
+                err = s_appendf(output, "\\n");
+                break;
+            default:
+                err = aws_byte_buf_append_byte_dynamic(output, bytes[i]);
+                break;
+        }
+        if (err) {
+            return AWS_OP_ERR;
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static int s_append_family_header(
+    struct aws_http_metrics_exporter *exporter,
+    struct aws_byte_buf *output,
+    const char *name,
+    const char *type,
+    const char *help) {
+
+    const char *prefix = aws_string_c_str(exporter->prefix);
+    if (s_appendf(output, "# TYPE %s_%s %s\n", prefix, name, type)) {
+        return AWS_OP_ERR;
+    }
+    return s_appendf(output, "# HELP %s_%s %s\n", prefix, name, help);
+}
+
+static uint64_t s_load(struct metrics_shard *shard, const struct metrics_value *var) {
+    s_shard_lock(shard);
+    uint64_t value = s_value_load(var);
+    s_shard_unlock(shard);
+    return value;
+}
+
+static uint64_t s_sum_counter(struct aws_http_metrics_exporter *exporter, size_t counter) {
+    uint64_t sum = 0;
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        struct metrics_shard *shard = &exporter->shards[s];
+        sum += s_load(shard, &shard->counters[counter]);
+    }
+    return sum;
+}
+
+static uint64_t s_sum_bucket(struct aws_http_metrics_exporter *exporter, size_t histogram, size_t bucket) {
+    uint64_t sum = 0;
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        struct metrics_shard *shard = &exporter->shards[s];
+        sum += s_load(shard, &shard->histograms[histogram].buckets[bucket]);
+    }
+    return sum;
+}
+
+static uint64_t s_sum_histogram_sum(struct aws_http_metrics_exporter *exporter, size_t histogram) {
+    uint64_t sum = 0;
+    for (size_t s = 0; s < METRICS_SHARD_COUNT; ++s) {
+        struct metrics_shard *shard = &exporter->shards[s];
+        sum += s_load(shard, &shard->histograms[histogram].sum);
+    }
+    return sum;
+}
+
+static int s_render_counters(struct aws_http_metrics_exporter *exporter, struct aws_byte_buf *output) {
+    const char *prefix = aws_string_c_str(exporter->prefix);
+    for (size_t c = 0; c < METRICS_COUNTER_COUNT; ++c) {
+        const struct metrics_counter_info *info = &s_counter_info[c];
+        if (info->help && s_append_family_header(exporter, output, info->name, "counter", info->help)) {
+            return AWS_OP_ERR;
+        }
+
+        uint64_t value = s_sum_counter(exporter, c);
+        int err = info->divisor == 1
+                      ? s_appendf(output, "%s_%s_total%s %" PRIu64 "\n", prefix, info->name, info->labels, value)
+                      : s_appendf(
+                            output,
+                            "%s_%s_total%s %.3f\n",
+                            prefix,
+                            info->name,
+                            info->labels,
+                            (double)value / (double)info->divisor);
+        if (err) {
+            return AWS_OP_ERR;
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static int s_render_histograms(struct aws_http_metrics_exporter *exporter, struct aws_byte_buf *output) {
+    const char *prefix = aws_string_c_str(exporter->prefix);
+    for (size_t h = 0; h < METRICS_HISTOGRAM_COUNT; ++h) {
+        const struct metrics_histogram_info *info = &s_histogram_info[h];
+        if (info->help && s_append_family_header(exporter, output, info->name, "histogram", info->help)) {
+            return AWS_OP_ERR;
+        }
+
+        /* Buckets are cumulative: each counts every sample at or below its bound */
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b <= info->bound_count; ++b) {
+            cumulative += s_sum_bucket(exporter, h, b);
+            int err = b < info->bound_count ? s_appendf(
+                                                  output,
+                                                  "%s_%s_bucket{%sle=\"%.10g\"} %" PRIu64 "\n",
+                                                  prefix,
+                                                  info->name,
+                                                  info->label,
+                                                  (double)info->bounds[b] / info->divisor,
+                                                  cumulative)
+                                            : s_appendf(
+                                                  output,
+                                                  "%s_%s_bucket{%sle=\"+Inf\"} %" PRIu64 "\n",
+                                                  prefix,
+                                                  info->name,
+                                                  info->label,
+                                                  cumulative);
+            if (err) {
+                return AWS_OP_ERR;
+            }
+        }
+
+        /* The extra label ends in a comma, so it can be followed by `le`. Drop it when it's the only label. */
+        const size_t label_len = strlen(info->label);
+        const int label_print_len = label_len ? (int)label_len - 1 : 0;
+        const char *open = label_len ? "{" : "";
+        const char *close = label_len ? "}" : "";
+        uint64_t sum = s_sum_histogram_sum(exporter, h);
+        if (s_appendf(
+                output,
+                "%s_%s_count%s%.*s%s %" PRIu64 "\n",
+                prefix,
+                info->name,
+                open,
+                label_print_len,
+                info->label,
+                close,
+                cumulative) ||
+            s_appendf(
+                output,
+                "%s_%s_sum%s%.*s%s %.9g\n",
+                prefix,
+                info->name,
+                open,
+                label_print_len,
+                info->label,
+                close,
+                (double)sum * (double)info->sum_resolution / info->divisor)) {
+            return AWS_OP_ERR;
+        }
+    }
+    return AWS_OP_SUCCESS;
+}
+
+enum metrics_manager_gauge {
+    METRICS_MANAGER_GAUGE_AVAILABLE,
+    METRICS_MANAGER_GAUGE_PENDING,
+    METRICS_MANAGER_GAUGE_LEASED,
+    METRICS_MANAGER_GAUGE_CONCURRENCY_LIMIT,
+    METRICS_MANAGER_GAUGE_CIRCUIT_BREAKER_STATE,
+    METRICS_MANAGER_GAUGE_COUNT,
+};
+
+static const struct {
+    const char *name;
+    const char *help;
+} s_manager_gauge_info[METRICS_MANAGER_GAUGE_COUNT] = {
+    [METRICS_MANAGER_GAUGE_AVAILABLE] = {"manager_available_concurrency", "Idle connections or streams, ready to use."},
+    [METRICS_MANAGER_GAUGE_PENDING] = {"manager_pending_acquires", "Acquisitions waiting for a connection or stream."},
+    [METRICS_MANAGER_GAUGE_LEASED] = {"manager_leased_concurrency", "Connections or streams in use."},
+    [METRICS_MANAGER_GAUGE_CONCURRENCY_LIMIT] =
+        {"manager_concurrency_limit", "Adaptive limit on connections or streams in use, 0 if none."},
+    [METRICS_MANAGER_GAUGE_CIRCUIT_BREAKER_STATE] =
+        {"manager_circuit_breaker_state", "Circuit breaker state: 0 closed, 1 open, 2 half-open."},
+};
+
+static size_t s_manager_gauge_value(const struct aws_http_manager_metrics *metrics, enum metrics_manager_gauge gauge) {
+    switch (gauge) {
+        case METRICS_MANAGER_GAUGE_AVAILABLE:
+            return metrics->available_concurrency;
+        case METRICS_MANAGER_GAUGE_PENDING:
+            return metrics->pending_concurrency_acquires;
+        case METRICS_MANAGER_GAUGE_LEASED:
+            return metrics->leased_concurrency;
+        case METRICS_MANAGER_GAUGE_CONCURRENCY_LIMIT:
+            return metrics->concurrency_limit;
+        default:
+            return (size_t)metrics->circuit_breaker_state;
+    }
+}
+
+static int s_render_managers(struct aws_http_metrics_exporter *exporter, struct aws_byte_buf *output) {
+    const char *prefix = aws_string_c_str(exporter->prefix);
+    int result = AWS_OP_SUCCESS;
+
+    aws_mutex_lock(&exporter->managers_lock);
+    const size_t count = aws_array_list_length(&exporter->managers);
+    if (count == 0) {
+        goto done;
+    }
+
+    /* Fetch each manager once, so the gauges of one manager are consistent with each other */
+    struct aws_http_manager_metrics *metrics =
+        aws_mem_calloc(exporter->alloc, count, sizeof(struct aws_http_manager_metrics));
+    for (size_t i = 0; i < count; ++i) {
+        struct metrics_manager_entry *entry = NULL;
+        aws_array_list_get_at_ptr(&exporter->managers, (void **)&entry, i);
+        if (entry->connection_manager) {
+            aws_http_connection_manager_fetch_metrics(entry->connection_manager, &metrics[i]);
+        } else {
+            aws_http2_stream_manager_fetch_metrics(entry->stream_manager, &metrics[i]);
+        }
+    }
+
+    for (size_t g = 0; g < METRICS_MANAGER_GAUGE_COUNT && !result; ++g) {
+        result = s_append_family_header(
+            exporter, output, s_manager_gauge_info[g].name, "gauge", s_manager_gauge_info[g].help);
+        for (size_t i = 0; i < count && !result; ++i) {
+            struct metrics_manager_entry *entry = NULL;
+            aws_array_list_get_at_ptr(&exporter->managers, (void **)&entry, i);
+            size_t value = s_manager_gauge_value(&metrics[i], (enum metrics_manager_gauge)g);
+            if (s_appendf(output, "%s_%s{manager=\"", prefix, s_manager_gauge_info[g].name) ||
+                s_append_label_value(output, entry->name) ||
+                s_appendf(
+                    output,
+                    "\",type=\"%s\"} %zu\n",
+                    entry->connection_manager ? "connection" : "http2_stream",
+                    value)) {
+                result = AWS_OP_ERR;
+            }
+        }
+    }
+    aws_mem_release(exporter->alloc, metrics);
+
+done:
+    aws_mutex_unlock(&exporter->managers_lock);
+    return result;
+}
+
+int aws_http_metrics_exporter_render(struct aws_http_metrics_exporter *exporter, struct aws_byte_buf *output) {
+    AWS_PRECONDITION(exporter);
+    AWS_PRECONDITION(output);
+
+    if (s_render_counters(exporter, output) || s_render_histograms(exporter, output) ||
+        s_render_managers(exporter, output)) {
+        return AWS_OP_ERR;
+    }
+    return s_appendf(output, "# EOF\n");
+}
@@ -10,8 +10,10 @@
 #include <aws/common/hash_table.h>
 #include <aws/common/string.h>
 #include <aws/http/connection_manager.h>
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/connection_impl.h>
 #include <aws/http/proxy.h>
+#include <aws/http/rate_limiter.h>
 #include <aws/http/request_response.h>
 #include <aws/io/channel.h>
 #include <aws/io/logging.h>
@@ -77,6 +79,13 @@ void aws_http_proxy_user_data_destroy(struct aws_http_proxy_user_data *user_data
 
     aws_client_bootstrap_release(user_data->original_bootstrap);
 
+    aws_http_memory_budget_release(user_data->original_http1_options.memory_budget);
+    aws_http_memory_budget_release(user_data->original_http2_options.memory_budget);
+    aws_http_rate_limiter_release(user_data->original_http1_options.send_rate_limiter);
+    aws_http_rate_limiter_release(user_data->original_http1_options.receive_rate_limiter);
+    aws_http_rate_limiter_release(user_data->original_http2_options.send_rate_limiter);
+    aws_http_rate_limiter_release(user_data->original_http2_options.receive_rate_limiter);
+
     aws_mem_release(user_data->allocator, user_data);
 }
 
@@ -180,6 +189,12 @@ struct aws_http_proxy_user_data *aws_http_proxy_user_data_new(
     user_data->original_user_data = options.user_data;
     user_data->original_http1_options = *options.http1_options;
     user_data->original_http2_options = *options.http2_options;
+    aws_http_memory_budget_acquire(user_data->original_http1_options.memory_budget);
+    aws_http_memory_budget_acquire(user_data->original_http2_options.memory_budget);
+    aws_http_rate_limiter_acquire(user_data->original_http1_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http1_options.receive_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http2_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http2_options.receive_rate_limiter);
 
     /* keep a copy of the settings array if it's not NULL */
     if (options.http2_options->num_initial_settings > 0) {
@@ -271,6 +286,12 @@ struct aws_http_proxy_user_data *aws_http_proxy_user_data_new_reset_clone(
     user_data->original_user_data = old_user_data->original_user_data;
     user_data->original_http1_options = old_user_data->original_http1_options;
     user_data->original_http2_options = old_user_data->original_http2_options;
+    aws_http_memory_budget_acquire(user_data->original_http1_options.memory_budget);
+    aws_http_memory_budget_acquire(user_data->original_http2_options.memory_budget);
+    aws_http_rate_limiter_acquire(user_data->original_http1_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http1_options.receive_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http2_options.send_rate_limiter);
+    aws_http_rate_limiter_acquire(user_data->original_http2_options.receive_rate_limiter);
 
     /* keep a copy of the settings array if it's not NULL */
     if (old_user_data->original_http2_options.num_initial_settings > 0) {
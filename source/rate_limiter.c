@@ -0,0 +1,220 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/rate_limiter_impl.h>
+
+#include <aws/common/clock.h>
+
+#include <inttypes.h>
+
+#define NS_PER_SEC 1000000000ULL
+
+/* Time for `bytes` tokens to accrue, rounded up */
+static uint64_t s_bytes_to_ns(const struct aws_http_rate_limiter *limiter, uint64_t bytes) {
+    uint64_t product = aws_mul_u64_saturating(bytes, NS_PER_SEC);
+    return aws_add_u64_saturating(product, limiter->bytes_per_second - 1) / limiter->bytes_per_second;
+}
+
+/* Tokens that accrue in `ns`, rounded down */
+static uint64_t s_ns_to_bytes(const struct aws_http_rate_limiter *limiter, uint64_t ns) {
+    return aws_mul_u64_saturating(ns, limiter->bytes_per_second) / NS_PER_SEC;
+}
+
+/* Add whatever tokens have accrued since the last refill. Lock must be held. */
+static void s_refill_synced(struct aws_http_rate_limiter *limiter, uint64_t now_ns) {
+    uint64_t *refill_timestamp_ns = &limiter->synced_data.refill_timestamp_ns;
+    if (now_ns <= *refill_timestamp_ns) {
+        /* Another thread read the clock a moment after us, but took the lock first */
+        return;
+    }
+
+    const size_t missing = limiter->burst_bytes - limiter->synced_data.tokens;
+    const uint64_t accrued = s_ns_to_bytes(limiter, now_ns - *refill_timestamp_ns);
+    if (accrued >= missing) {
+        limiter->synced_data.tokens = limiter->burst_bytes;
+        *refill_timestamp_ns = now_ns;
+        return;
+    }
+
+    /* Only advance as far as the whole tokens account for, so the fraction of a token left over isn't lost */
+    limiter->synced_data.tokens += (size_t)accrued;
+    *refill_timestamp_ns += s_bytes_to_ns(limiter, accrued);
+}
+
+static void s_rate_limiter_destroy(void *user_data) {
+    struct aws_http_rate_limiter *limiter = user_data;
+
+    AWS_LOGF_DEBUG(AWS_LS_HTTP_GENERAL, "id=%p: Destroying rate limiter.", (void *)limiter);
+
+    aws_mutex_clean_up(&limiter->lock);
+    aws_mem_release(limiter->alloc, limiter);
+}
+
+struct aws_http_rate_limiter *aws_http_rate_limiter_new(
+    struct aws_allocator *allocator,
+    const struct aws_http_rate_limiter_options *options) {
+
+    AWS_PRECONDITION(allocator);
+    AWS_PRECONDITION(options);
+
+    if (options->bytes_per_second == 0) {
+        AWS_LOGF_ERROR(AWS_LS_HTTP_GENERAL, "static: Cannot create rate limiter, bytes_per_second must be non-zero.");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    struct aws_http_rate_limiter *limiter = aws_mem_calloc(allocator, 1, sizeof(struct aws_http_rate_limiter));
+    limiter->alloc = allocator;
+    aws_ref_count_init(&limiter->ref_count, limiter, s_rate_limiter_destroy);
+    limiter->bytes_per_second = options->bytes_per_second;
+
+    if (options->burst_bytes) {
+        limiter->burst_bytes = options->burst_bytes;
+    } else {
+        uint64_t default_burst = aws_max_u64(options->bytes_per_second / 10, AWS_HTTP_RATE_LIMITER_MIN_DEFAULT_BURST);
+        limiter->burst_bytes = (size_t)aws_min_u64(default_burst, SIZE_MAX);
+    }
+
+    if (aws_mutex_init(&limiter->lock)) {
+        aws_mem_release(allocator, limiter);
+        return NULL;
+    }
+
+    /* Bucket starts full */
+    limiter->synced_data.tokens = limiter->burst_bytes;
+
+    AWS_LOGF_DEBUG(
+        AWS_LS_HTTP_GENERAL,
+        "id=%p: Created rate limiter of %" PRIu64 " bytes per second, burst %zu bytes.",
+        (void *)limiter,
+        limiter->bytes_per_second,
+        limiter->burst_bytes);
+
+    return limiter;
+}
+
+struct aws_http_rate_limiter *aws_http_rate_limiter_acquire(struct aws_http_rate_limiter *limiter) {
+    if (limiter) {
+        aws_ref_count_acquire(&limiter->ref_count);
+    }
+    return limiter;
+}
+
+struct aws_http_rate_limiter *aws_http_rate_limiter_release(struct aws_http_rate_limiter *limiter) {
+    if (limiter) {
+        aws_ref_count_release(&limiter->ref_count);
+    }
+    return NULL;
+}
+
+size_t aws_http_rate_limiter_take(
+    struct aws_http_rate_limiter *limiter,
+    uint64_t now_ns,
+    size_t min_bytes,
+    size_t max_bytes) {
+
+    AWS_PRECONDITION(limiter);
+    min_bytes = aws_min_size(min_bytes, aws_min_size(max_bytes, limiter->burst_bytes));
+
+    size_t granted = 0;
+    { /* BEGIN CRITICAL SECTION */
+        aws_mutex_lock(&limiter->lock);
+        s_refill_synced(limiter, now_ns);
+        if (limiter->synced_data.tokens >= min_bytes) {
+            granted = aws_min_size(limiter->synced_data.tokens, max_bytes);
+            limiter->synced_data.tokens -= granted;
+        }
+        aws_mutex_unlock(&limiter->lock);
+    } /* END CRITICAL SECTION */
+
+    return granted;
+}
+
+void aws_http_rate_limiter_give_back(struct aws_http_rate_limiter *limiter, size_t bytes) {
+    AWS_PRECONDITION(limiter);
+
+    { /* BEGIN CRITICAL SECTION */
+        aws_mutex_lock(&limiter->lock);
+        limiter->synced_data.tokens =
+            aws_min_size(aws_add_size_saturating(limiter->synced_data.tokens, bytes), limiter->burst_bytes);
+        aws_mutex_unlock(&limiter->lock);
+    } /* END CRITICAL SECTION */
+}
+
+uint64_t aws_http_rate_limiter_time_until(struct aws_http_rate_limiter *limiter, uint64_t now_ns, size_t bytes) {
+    AWS_PRECONDITION(limiter);
+    bytes = aws_min_size(bytes, limiter->burst_bytes);
+
+    uint64_t wait_ns = 0;
+    { /* BEGIN CRITICAL SECTION */
+        aws_mutex_lock(&limiter->lock);
+        s_refill_synced(limiter, now_ns);
+        if (limiter->synced_data.tokens < bytes) {
+            /* Part of the next token may have already accrued since the refill timestamp */
+            uint64_t since_refill_ns = aws_sub_u64_saturating(now_ns, limiter->synced_data.refill_timestamp_ns);
+            wait_ns = aws_sub_u64_saturating(
+                s_bytes_to_ns(limiter, bytes - limiter->synced_data.tokens), since_refill_ns);
+
+            /* Never claim "now" while the tokens aren't there, or a caller could spin */
+            wait_ns = aws_max_u64(wait_ns, 1);
+        }
+        aws_mutex_unlock(&limiter->lock);
+    } /* END CRITICAL SECTION */
+
+    return wait_ns;
+}
+
+size_t aws_http_rate_limiter_take_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    uint64_t now_ns,
+    size_t min_bytes,
+    size_t max_bytes) {
+
+    if (!a || !b) {
+        struct aws_http_rate_limiter *only = a ? a : b;
+        return only ? aws_http_rate_limiter_take(only, now_ns, min_bytes, max_bytes) : max_bytes;
+    }
+
+    const size_t granted_a = aws_http_rate_limiter_take(a, now_ns, min_bytes, max_bytes);
+    if (granted_a == 0) {
+        return 0;
+    }
+
+    const size_t granted_b = aws_http_rate_limiter_take(b, now_ns, min_bytes, granted_a);
+    if (granted_b < granted_a) {
+        aws_http_rate_limiter_give_back(a, granted_a - granted_b);
+    }
+    return granted_b;
+}
+
+void aws_http_rate_limiter_give_back_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    size_t bytes) {
+
+    if (a) {
+        aws_http_rate_limiter_give_back(a, bytes);
+    }
+    if (b) {
+        aws_http_rate_limiter_give_back(b, bytes);
+    }
+}
+
+uint64_t aws_http_rate_limiter_time_until_both(
+    struct aws_http_rate_limiter *a,
+    struct aws_http_rate_limiter *b,
+    uint64_t now_ns,
+    size_t bytes) {
+
+    uint64_t wait_ns = 0;
+    if (a) {
+        wait_ns = aws_http_rate_limiter_time_until(a, now_ns, bytes);
+    }
+    if (b) {
+        wait_ns = aws_max_u64(wait_ns, aws_http_rate_limiter_time_until(b, now_ns, bytes));
+    }
+    return wait_ns;
+}
@@ -6,6 +6,7 @@
 #include <aws/common/array_list.h>
 #include <aws/common/mutex.h>
 #include <aws/common/string.h>
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/connection_impl.h>
 #include <aws/http/private/request_response_impl.h>
 #include <aws/http/private/strutil.h>
@@ -42,6 +43,7 @@ struct aws_http_headers {
     struct aws_allocator *alloc;
     struct aws_array_list array_list; /* Contains aws_http_header */
     struct aws_atomic_var refcount;
+    bool immutable;
 };
 
 struct aws_http_headers *aws_http_headers_new(struct aws_allocator *allocator) {
@@ -68,6 +70,8 @@ alloc_failed:
     return NULL;
 }
 
+static void s_http_headers_clear(struct aws_http_headers *headers);
+
 void aws_http_headers_release(struct aws_http_headers *headers) {
     AWS_PRECONDITION(!headers || headers->alloc);
     if (!headers) {
@@ -76,7 +80,7 @@ void aws_http_headers_release(struct aws_http_headers *headers) {
 
     size_t prev_refcount = aws_atomic_fetch_sub(&headers->refcount, 1);
     if (prev_refcount == 1) {
-        aws_http_headers_clear(headers);
+        s_http_headers_clear(headers);
         aws_array_list_clean_up(&headers->array_list);
         aws_mem_release(headers->alloc, headers);
     } else {
@@ -89,6 +93,21 @@ void aws_http_headers_acquire(struct aws_http_headers *headers) {
     aws_atomic_fetch_add(&headers->refcount, 1);
 }
 
+void aws_http_headers_set_immutable(struct aws_http_headers *headers) {
+    AWS_PRECONDITION(headers);
+    headers->immutable = true;
+}
+
+bool aws_http_headers_is_immutable(const struct aws_http_headers *headers) {
+    AWS_PRECONDITION(headers);
+    return headers->immutable;
+}
+
+static int s_raise_headers_immutable(void) {
+    AWS_LOGF_ERROR(AWS_LS_HTTP_GENERAL, "static: Cannot modify headers, they are immutable.");
+    return aws_raise_error(AWS_ERROR_INVALID_STATE);
+}
+
 static int s_http_headers_add_header_impl(
     struct aws_http_headers *headers,
     const struct aws_http_header *header_orig,
@@ -98,6 +117,10 @@ static int s_http_headers_add_header_impl(
     AWS_PRECONDITION(header_orig);
     AWS_PRECONDITION(aws_byte_cursor_is_valid(&header_orig->name) && aws_byte_cursor_is_valid(&header_orig->value));
 
+    if (headers->immutable) {
+        return s_raise_headers_immutable();
+    }
+
     struct aws_http_header header_copy = *header_orig;
 
     if (header_copy.name.len == 0) {
@@ -157,9 +180,7 @@ int aws_http_headers_add(struct aws_http_headers *headers, struct aws_byte_curso
     return aws_http_headers_add_header(headers, &header);
 }
 
-void aws_http_headers_clear(struct aws_http_headers *headers) {
-    AWS_PRECONDITION(headers);
-
+static void s_http_headers_clear(struct aws_http_headers *headers) {
     struct aws_http_header *header = NULL;
     const size_t count = aws_http_headers_count(headers);
     for (size_t i = 0; i < count; ++i) {
@@ -173,6 +194,17 @@ void aws_http_headers_clear(struct aws_http_headers *headers) {
     aws_array_list_clear(&headers->array_list);
 }
 
+void aws_http_headers_clear(struct aws_http_headers *headers) {
+    AWS_PRECONDITION(headers);
+
+    if (headers->immutable) {
+        s_raise_headers_immutable();
+        return;
+    }
+
+    s_http_headers_clear(headers);
+}
+
 /* Does not check index */
 static void s_http_headers_erase_index(struct aws_http_headers *headers, size_t index) {
     struct aws_http_header *header = NULL;
@@ -188,6 +220,10 @@ static void s_http_headers_erase_index(struct aws_http_headers *headers, size_t
 int aws_http_headers_erase_index(struct aws_http_headers *headers, size_t index) {
     AWS_PRECONDITION(headers);
 
+    if (headers->immutable) {
+        return s_raise_headers_immutable();
+    }
+
     if (index >= aws_http_headers_count(headers)) {
         return aws_raise_error(AWS_ERROR_INVALID_INDEX);
     }
@@ -202,6 +238,11 @@ static int s_http_headers_erase(
     struct aws_byte_cursor name,
     size_t start_index,
     size_t end_index) {
+
+    if (headers->immutable) {
+        return s_raise_headers_immutable();
+    }
+
     bool erased_any = false;
     struct aws_http_header *header = NULL;
 
@@ -240,6 +281,10 @@ int aws_http_headers_erase_value(
     AWS_PRECONDITION(headers);
     AWS_PRECONDITION(aws_byte_cursor_is_valid(&name) && aws_byte_cursor_is_valid(&value));
 
+    if (headers->immutable) {
+        return s_raise_headers_immutable();
+    }
+
     struct aws_http_header *header = NULL;
     const size_t count = aws_http_headers_count(headers);
     for (size_t i = 0; i < count; ++i) {
@@ -889,6 +934,16 @@ struct aws_http_stream *aws_http_connection_make_request(
         return NULL;
     }
 
+    /* Shed load rather than taking on more data to buffer */
+    if (client_connection->memory_budget && aws_http_memory_budget_is_exhausted(client_connection->memory_budget)) {
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_CONNECTION,
+            "id=%p: Cannot create client request, memory budget is exhausted.",
+            (void *)client_connection);
+        aws_raise_error(AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED);
+        return NULL;
+    }
+
     /* Connection owns stream, and must outlive stream */
     aws_http_connection_acquire(client_connection);
 
@@ -1197,6 +1252,36 @@ void aws_http_stream_update_window(struct aws_http_stream *stream, size_t increm
     stream->vtable->update_window(stream, increment_size);
 }
 
+int aws_http_stream_notify_body_ready(struct aws_http_stream *stream) {
+    AWS_PRECONDITION(stream);
+    AWS_PRECONDITION(stream->vtable);
+    AWS_PRECONDITION(stream->vtable->notify_body_ready);
+
+    return stream->vtable->notify_body_ready(stream);
+}
+
+struct aws_http_retained_body *aws_http_retained_body_acquire(struct aws_http_retained_body *retained_body) {
+    AWS_PRECONDITION(retained_body);
+
+    size_t prev_refcount = aws_atomic_fetch_add(&retained_body->refcount, 1);
+    AWS_ASSERT(prev_refcount != 0);
+    (void)prev_refcount;
+    return retained_body;
+}
+
+void aws_http_retained_body_release(struct aws_http_retained_body *retained_body) {
+    if (!retained_body) {
+        return;
+    }
+
+    size_t prev_refcount = aws_atomic_fetch_sub(&retained_body->refcount, 1);
+    if (prev_refcount == 1) {
+        retained_body->on_zero_refs(retained_body);
+    } else {
+        AWS_ASSERT(prev_refcount != 0);
+    }
+}
+
 uint32_t aws_http_stream_get_id(const struct aws_http_stream *stream) {
     return stream->id;
 }
@@ -21,6 +21,7 @@ void aws_crt_statistics_http1_channel_reset(struct aws_crt_statistics_http1_chan
     stats->pending_incoming_stream_ms = 0;
     stats->current_outgoing_stream_id = 0;
     stats->current_incoming_stream_id = 0;
+    stats->resident_bytes = 0;
 }
 
 void aws_crt_statistics_http2_channel_init(struct aws_crt_statistics_http2_channel *stats) {
@@ -32,4 +33,14 @@ void aws_crt_statistics_http2_channel_reset(struct aws_crt_statistics_http2_chan
     stats->pending_outgoing_stream_ms = 0;
     stats->pending_incoming_stream_ms = 0;
     stats->was_inactive = false;
+    stats->resident_bytes = 0;
+}
+
+void aws_crt_statistics_websocket_channel_init(struct aws_crt_statistics_websocket_channel *stats) {
+    AWS_ZERO_STRUCT(*stats);
+    stats->category = AWSCRT_STAT_CAT_WEBSOCKET_CHANNEL;
+}
+
+void aws_crt_statistics_websocket_channel_reset(struct aws_crt_statistics_websocket_channel *stats) {
+    stats->resident_bytes = 0;
 }
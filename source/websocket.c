@@ -10,9 +10,11 @@
 #include <aws/common/encoding.h>
 #include <aws/common/mutex.h>
 #include <aws/common/ref_count.h>
+#include <aws/http/private/http_impl.h>
 #include <aws/http/private/websocket_decoder.h>
 #include <aws/http/private/websocket_encoder.h>
 #include <aws/http/request_response.h>
+#include <aws/http/statistics.h>
 #include <aws/io/channel.h>
 #include <aws/io/logging.h>
 
@@ -47,6 +49,8 @@ struct aws_websocket {
     struct aws_channel_task increment_read_window_task;
     struct aws_channel_task waiting_on_payload_stream_task;
     struct aws_channel_task close_timeout_task;
+    struct aws_channel_task idle_trim_task;
+    uint64_t idle_trim_ns;
     bool is_server;
 
     /* Data that should only be accessed from the websocket's channel thread. */
@@ -110,8 +114,17 @@ struct aws_websocket {
         /* True if this websocket is being used as a dumb mid-channel handler.
          * The websocket will no longer respond to its public API or invoke callbacks. */
         bool is_midchannel_handler;
+
+        /* Bumped whenever an aws_io_message is read or written. Compared by the idle trim task */
+        uint64_t activity_count;
+        uint64_t activity_count_at_last_idle_check;
+        bool is_idle_trimmed;
+
+        struct aws_crt_statistics_websocket_channel stats;
     } thread_data;
 
+    AWS_HTTP_CACHE_LINE_PADDING(synced_data_padding);
+
     /* Data that may be touched from any thread (lock must be held). */
     struct {
         struct aws_mutex lock;
@@ -159,6 +172,8 @@ static int s_handler_shutdown(
 
 static size_t s_handler_initial_window_size(struct aws_channel_handler *handler);
 static size_t s_handler_message_overhead(struct aws_channel_handler *handler);
+static void s_handler_reset_statistics(struct aws_channel_handler *handler);
+static void s_handler_gather_statistics(struct aws_channel_handler *handler, struct aws_array_list *stats);
 static void s_handler_destroy(struct aws_channel_handler *handler);
 static void s_websocket_on_refcount_zero(void *user_data);
 
@@ -189,6 +204,8 @@ static void s_increment_read_window_task(struct aws_channel_task *task, void *ar
 static void s_shutdown_channel_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
 static void s_waiting_on_payload_stream_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
 static void s_close_timeout_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
+static void s_idle_trim_task(struct aws_channel_task *task, void *arg, enum aws_task_status status);
+static void s_schedule_idle_trim_task(struct aws_websocket *websocket);
 static void s_schedule_channel_shutdown(struct aws_websocket *websocket, int error_code);
 static void s_shutdown_due_to_write_err(struct aws_websocket *websocket, int error_code);
 static void s_shutdown_due_to_read_err(struct aws_websocket *websocket, int error_code);
@@ -203,6 +220,8 @@ static struct aws_channel_handler_vtable s_channel_handler_vtable = {
     .initial_window_size = s_handler_initial_window_size,
     .message_overhead = s_handler_message_overhead,
     .destroy = s_handler_destroy,
+    .reset_statistics = s_handler_reset_statistics,
+    .gather_statistics = s_handler_gather_statistics,
 };
 
 const char *aws_websocket_opcode_str(uint8_t opcode) {
@@ -297,10 +316,14 @@ struct aws_websocket *aws_websocket_handler_new(const struct aws_websocket_handl
         websocket,
         "websocket_waiting_on_payload_stream");
     aws_channel_task_init(&websocket->close_timeout_task, s_close_timeout_task, websocket, "websocket_close_timeout");
+    aws_channel_task_init(&websocket->idle_trim_task, s_idle_trim_task, websocket, "websocket_idle_trim");
+    websocket->idle_trim_ns =
+        aws_timestamp_convert(options->idle_trim_ms, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
 
     aws_linked_list_init(&websocket->thread_data.outgoing_frame_list);
     aws_linked_list_init(&websocket->thread_data.write_completion_frames);
     aws_byte_buf_init(&websocket->thread_data.incoming_ping_payload, websocket->alloc, 0);
+    aws_crt_statistics_websocket_channel_init(&websocket->thread_data.stats);
 
     aws_websocket_encoder_init(&websocket->thread_data.encoder, s_encoder_stream_outgoing_payload, websocket);
 
@@ -325,6 +348,10 @@ struct aws_websocket *aws_websocket_handler_new(const struct aws_websocket_handl
         goto error;
     }
 
+    if (websocket->idle_trim_ns) {
+        s_schedule_idle_trim_task(websocket);
+    }
+
     /* Ensure websocket (and the rest of the channel) can't be destroyed until aws_websocket_release() is called */
     aws_channel_acquire_hold(options->channel);
 
@@ -705,6 +732,7 @@ static void s_try_write_outgoing_frames(struct aws_websocket *websocket) {
         io_msg->message_data.len);
 
     websocket->thread_data.is_waiting_for_write_completion = true;
+    websocket->thread_data.activity_count++;
     err = aws_channel_slot_send_message(websocket->channel_slot, io_msg, AWS_CHANNEL_DIR_WRITE);
     if (err) {
         websocket->thread_data.is_waiting_for_write_completion = false;
@@ -1209,6 +1237,7 @@ static int s_handler_process_read_message(
      * We start off assuming we'll re-open the window by the whole amount,
      * but this number will go down if we process any payload data that ought to shrink the window */
     websocket->thread_data.incoming_message_window_update = message->message_data.len;
+    websocket->thread_data.activity_count++;
 
     AWS_LOGF_TRACE(
         AWS_LS_HTTP_WEBSOCKET,
@@ -1557,6 +1586,70 @@ static size_t s_handler_message_overhead(struct aws_channel_handler *handler) {
     return AWS_WEBSOCKET_MAX_FRAME_OVERHEAD;
 }
 
+static size_t s_get_resident_bytes(const struct aws_websocket *websocket) {
+    return sizeof(struct aws_websocket) + websocket->thread_data.incoming_ping_payload.capacity;
+}
+
+static void s_handler_reset_statistics(struct aws_channel_handler *handler) {
+    struct aws_websocket *websocket = handler->impl;
+    aws_crt_statistics_websocket_channel_reset(&websocket->thread_data.stats);
+}
+
+static void s_handler_gather_statistics(struct aws_channel_handler *handler, struct aws_array_list *stats) {
+    struct aws_websocket *websocket = handler->impl;
+    websocket->thread_data.stats.resident_bytes = s_get_resident_bytes(websocket);
+
+    void *stats_base = &websocket->thread_data.stats;
+    aws_array_list_push_back(stats, &stats_base);
+}
+
+static void s_schedule_idle_trim_task(struct aws_websocket *websocket) {
+    uint64_t now_ns = 0;
+    aws_channel_current_clock_time(websocket->channel_slot->channel, &now_ns);
+    aws_channel_schedule_task_future(
+        websocket->channel_slot->channel, &websocket->idle_trim_task, now_ns + websocket->idle_trim_ns);
+}
+
+/* Runs every idle_trim_ns. If nothing was read or written since the last run, release the memory that
+ * only grows with traffic. It's re-grown on demand once traffic resumes. */
+static void s_idle_trim_task(struct aws_channel_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    struct aws_websocket *websocket = arg;
+    if (websocket->thread_data.is_reading_stopped || websocket->thread_data.is_writing_stopped) {
+        return;
+    }
+
+    if (websocket->thread_data.activity_count != websocket->thread_data.activity_count_at_last_idle_check) {
+        websocket->thread_data.activity_count_at_last_idle_check = websocket->thread_data.activity_count;
+        websocket->thread_data.is_idle_trimmed = false;
+
+    } else if (!websocket->thread_data.is_idle_trimmed) {
+        size_t prev_resident_bytes = s_get_resident_bytes(websocket);
+
+        /* PING payload must survive until the frame completes, since the PONG echoes it */
+        if (websocket->thread_data.current_incoming_frame == NULL) {
+            aws_byte_buf_clean_up(&websocket->thread_data.incoming_ping_payload);
+            aws_byte_buf_init(&websocket->thread_data.incoming_ping_payload, websocket->alloc, 0);
+        }
+
+        websocket->thread_data.is_idle_trimmed = true;
+
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_WEBSOCKET,
+            "id=%p: Websocket is idle, trimmed resident memory from %zu to %zu bytes.",
+            (void *)websocket,
+            prev_resident_bytes,
+            s_get_resident_bytes(websocket));
+    }
+
+    s_schedule_idle_trim_task(websocket);
+}
+
 static int s_handler_increment_read_window(
     struct aws_channel_handler *handler,
     struct aws_channel_slot *slot,
@@ -1788,3 +1881,37 @@ error:
     aws_http_message_destroy(request);
     return NULL;
 }
+
+struct aws_http_message *aws_http2_message_new_websocket_handshake_request(
+    struct aws_allocator *allocator,
+    struct aws_byte_cursor path,
+    struct aws_byte_cursor authority) {
+
+    AWS_PRECONDITION(allocator);
+    AWS_PRECONDITION(aws_byte_cursor_is_valid(&path));
+    AWS_PRECONDITION(aws_byte_cursor_is_valid(&authority));
+
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    if (!request) {
+        goto error;
+    }
+
+    /* RFC-8441 4: extended CONNECT, with the :protocol pseudo-header set to "websocket".
+     * There is no Sec-WebSocket-Key/Accept exchange over HTTP/2 */
+    struct aws_http_headers *h2_headers = aws_http_message_get_headers(request);
+    if (aws_http2_headers_set_request_method(h2_headers, aws_http_method_connect) ||
+        aws_http_headers_add(h2_headers, aws_http_header_protocol, aws_byte_cursor_from_c_str("websocket")) ||
+        aws_http2_headers_set_request_scheme(h2_headers, aws_http_scheme_https) ||
+        aws_http2_headers_set_request_path(h2_headers, path) ||
+        aws_http2_headers_set_request_authority(h2_headers, authority) ||
+        aws_http_headers_add(
+            h2_headers, aws_byte_cursor_from_c_str("sec-websocket-version"), aws_byte_cursor_from_c_str("13"))) {
+        goto error;
+    }
+
+    return request;
+
+error:
+    aws_http_message_release(request);
+    return NULL;
+}
@@ -57,6 +57,7 @@ struct aws_websocket_client_bootstrap {
     struct aws_allocator *alloc;
     size_t initial_window_size;
     bool manual_window_update;
+    uint64_t idle_trim_ms;
     void *user_data;
     /* Setup callback will be set NULL once it's invoked.
      * This is used to determine whether setup or shutdown should be invoked
@@ -170,6 +171,7 @@ int aws_websocket_client_connect(const struct aws_websocket_client_connection_op
     ws_bootstrap->alloc = options->allocator;
     ws_bootstrap->initial_window_size = options->initial_window_size;
     ws_bootstrap->manual_window_update = options->manual_window_management;
+    ws_bootstrap->idle_trim_ms = options->idle_trim_ms;
     ws_bootstrap->user_data = options->user_data;
     ws_bootstrap->websocket_setup_callback = options->on_connection_setup;
     ws_bootstrap->websocket_shutdown_callback = options->on_connection_shutdown;
@@ -198,6 +200,12 @@ int aws_websocket_client_connect(const struct aws_websocket_client_connection_op
     http_options.tls_options = options->tls_options;
     http_options.proxy_options = options->proxy_options;
 
+    /* Once upgraded, the HTTP/1 connection stays in the channel beneath the websocket, so it trims too */
+    struct aws_http1_connection_options http1_options;
+    AWS_ZERO_STRUCT(http1_options);
+    http1_options.idle_trim_ms = options->idle_trim_ms;
+    http_options.http1_options = &http1_options;
+
     if (options->manual_window_management) {
         http_options.manual_window_management = true;
 
@@ -598,17 +606,20 @@ static int s_ws_bootstrap_validate_header(
     return AWS_OP_SUCCESS;
 }
 
-static int s_ws_bootstrap_validate_sec_websocket_protocol(const struct aws_websocket_client_bootstrap *ws_bootstrap) {
+int aws_websocket_validate_sec_websocket_protocol(
+    const void *log_id,
+    const struct aws_string *requested_protocols,
+    const struct aws_http_headers *response_headers) {
+
     /* First handle the easy case:
      * If client requested no protocols, then the response should not pick any */
-    if (ws_bootstrap->expected_sec_websocket_protocols == NULL) {
-        if (aws_http_headers_has(
-                ws_bootstrap->response_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Protocol"))) {
+    if (requested_protocols == NULL) {
+        if (aws_http_headers_has(response_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Protocol"))) {
 
             AWS_LOGF_ERROR(
                 AWS_LS_HTTP_WEBSOCKET_SETUP,
                 "id=%p: Response has 'Sec-WebSocket-Protocol' header, no protocol was requested",
-                (void *)ws_bootstrap);
+                log_id);
             return aws_raise_error(AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE);
         } else {
             return AWS_OP_SUCCESS;
@@ -618,16 +629,13 @@ static int s_ws_bootstrap_validate_sec_websocket_protocol(const struct aws_webso
     /* Check that server has picked one of the protocols listed in the request */
     struct aws_byte_cursor response_protocol;
     if (aws_http_headers_get(
-            ws_bootstrap->response_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Protocol"), &response_protocol)) {
+            response_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Protocol"), &response_protocol)) {
         AWS_LOGF_ERROR(
-            AWS_LS_HTTP_WEBSOCKET_SETUP,
-            "id=%p: Response lacks required 'Sec-WebSocket-Protocol' header",
-            (void *)ws_bootstrap);
+            AWS_LS_HTTP_WEBSOCKET_SETUP, "id=%p: Response lacks required 'Sec-WebSocket-Protocol' header", log_id);
         return aws_raise_error(AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE);
     }
 
-    struct aws_byte_cursor request_protocols =
-        aws_byte_cursor_from_string(ws_bootstrap->expected_sec_websocket_protocols);
+    struct aws_byte_cursor request_protocols = aws_byte_cursor_from_string(requested_protocols);
     struct aws_byte_cursor request_protocol_i;
     AWS_ZERO_STRUCT(request_protocol_i);
     while (aws_byte_cursor_next_split(&request_protocols, ',', &request_protocol_i)) {
@@ -637,7 +645,7 @@ static int s_ws_bootstrap_validate_sec_websocket_protocol(const struct aws_webso
             AWS_LOGF_DEBUG(
                 AWS_LS_HTTP_WEBSOCKET_SETUP,
                 "id=%p: Server selected Sec-WebSocket-Protocol: " PRInSTR,
-                (void *)ws_bootstrap,
+                log_id,
                 AWS_BYTE_CURSOR_PRI(response_protocol));
             return AWS_OP_SUCCESS;
         }
@@ -647,7 +655,7 @@ static int s_ws_bootstrap_validate_sec_websocket_protocol(const struct aws_webso
         AWS_LS_HTTP_WEBSOCKET_SETUP,
         "id=%p: Response 'Sec-WebSocket-Protocol' header has wrong value. Received '" PRInSTR
         "'. Expected one of '" PRInSTR "'",
-        (void *)ws_bootstrap,
+        log_id,
         AWS_BYTE_CURSOR_PRI(response_protocol),
         AWS_BYTE_CURSOR_PRI(request_protocols));
     return aws_raise_error(AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE);
@@ -713,7 +721,8 @@ static int s_ws_bootstrap_validate_response_and_install_websocket_handler(
      *      not present in the client's handshake (the server has indicated a
      *      subprotocol not requested by the client), the client MUST _Fail
      *      the WebSocket Connection_. */
-    if (s_ws_bootstrap_validate_sec_websocket_protocol(ws_bootstrap)) {
+    if (aws_websocket_validate_sec_websocket_protocol(
+            ws_bootstrap, ws_bootstrap->expected_sec_websocket_protocols, ws_bootstrap->response_headers)) {
         goto error;
     }
 
@@ -731,6 +740,7 @@ static int s_ws_bootstrap_validate_response_and_install_websocket_handler(
         .on_incoming_frame_complete = ws_bootstrap->websocket_frame_complete_callback,
         .is_server = false,
         .manual_window_update = ws_bootstrap->manual_window_update,
+        .idle_trim_ms = ws_bootstrap->idle_trim_ms,
     };
 
     ws_bootstrap->websocket = s_system_vtable->aws_websocket_handler_new(&ws_options);
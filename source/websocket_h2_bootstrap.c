@@ -0,0 +1,999 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/common/logging.h>
+#include <aws/common/ref_count.h>
+#include <aws/common/string.h>
+#include <aws/http/connection.h>
+#include <aws/http/http2_stream_manager.h>
+#include <aws/http/private/connection_impl.h>
+#include <aws/http/private/http_impl.h>
+#include <aws/http/private/websocket_impl.h>
+#include <aws/http/request_response.h>
+#include <aws/http/status_code.h>
+#include <aws/io/channel.h>
+#include <aws/io/stream.h>
+
+#include <inttypes.h>
+
+#ifdef _MSC_VER
+#    pragma warning(disable : 4204) /* non-constant aggregate initializer */
+#endif
+
+/**
+ * The websocket HTTP/2 bootstrap runs a websocket as a stream on an HTTP/2 connection (RFC-8441).
+ *
+ * It sends the extended CONNECT request. If the server accepts it, a new channel is created on the
+ * HTTP/2 connection's event-loop. The bootstrap is the first handler in that channel, and carries bytes
+ * between the channel and the stream's DATA frames. The regular websocket handler is installed after it,
+ * so websocket framing works exactly as it does over a socket.
+ *
+ * The bootstrap is responsible for firing the on_connection_setup and on_connection_shutdown callbacks.
+ * It's ref-counted: the stream holds a reference until it completes,
+ * and the channel holds a reference until it destroys its handlers.
+ */
+struct aws_websocket_h2_bootstrap {
+    struct aws_allocator *alloc;
+    struct aws_ref_count ref_count;
+
+    /* Settings copied in from aws_websocket_client_http2_options */
+    size_t initial_window_size;
+    bool manual_window_update;
+    uint64_t idle_trim_ms;
+    void *user_data;
+    /* Setup callback will be set NULL once it's invoked. */
+    aws_websocket_on_connection_setup_fn *websocket_setup_callback;
+    aws_websocket_on_connection_shutdown_fn *websocket_shutdown_callback;
+    aws_websocket_on_incoming_frame_begin_fn *websocket_frame_begin_callback;
+    aws_websocket_on_incoming_frame_payload_fn *websocket_frame_payload_callback;
+    aws_websocket_on_incoming_frame_complete_fn *websocket_frame_complete_callback;
+
+    /* Handshake request data */
+    struct aws_http_message *handshake_request;
+
+    /* Comma-separated values from the request's "Sec-WebSocket-Protocol" (or NULL if none)  */
+    struct aws_string *expected_sec_websocket_protocols;
+
+    /* Handshake response data */
+    int response_status;
+    struct aws_http_headers *response_headers;
+    bool got_full_response_headers;
+    struct aws_byte_buf response_body;
+    bool got_full_response_body;
+
+    int setup_error_code;
+    struct aws_websocket *websocket;
+
+    /* Set NULL once the stream completes */
+    struct aws_http_stream *stream;
+
+    /* Channel that the websocket runs in. Set NULL once it's shut down (or failed setup) */
+    struct aws_channel *channel;
+
+    /* Set once the bootstrap is installed as the channel's first handler */
+    struct aws_channel_slot *slot;
+    struct aws_channel_handler handler;
+
+    /* DATA received on the stream that didn't fit in the websocket's read window, and hasn't been sent along the
+     * channel yet. The stream's window is only updated as data is sent along, so with manual window management
+     * this never exceeds the stream's flow-control window. Without it, the peer isn't held back, so the buffer is
+     * capped at the stream's initial window size and the stream is reset if that's exceeded. */
+    struct aws_byte_buf pending_read_data;
+    size_t pending_read_data_sent;
+    bool is_sending_read_data;
+
+    /* Number of stream writes in flight. Write-direction shutdown can't complete until they're done. */
+    size_t pending_write_count;
+    bool is_waiting_on_writes_to_finish_shutdown;
+    int shutdown_error_code;
+    bool shutdown_free_scarce_resources_immediately;
+};
+
+/* A channel message being carried by DATA frames of the stream */
+struct aws_websocket_h2_write {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap;
+    /* NULL for the empty write that ends the stream */
+    struct aws_io_message *message;
+    struct aws_input_stream *data;
+};
+
+static void s_ws_h2_bootstrap_on_refcount_zero(void *user_data);
+static void s_ws_h2_bootstrap_invoke_setup_callback(struct aws_websocket_h2_bootstrap *ws_bootstrap, int error_code);
+static int s_ws_h2_bootstrap_on_handshake_response_headers(
+    struct aws_http_stream *stream,
+    enum aws_http_header_block header_block,
+    const struct aws_http_header *header_array,
+    size_t num_headers,
+    void *user_data);
+static int s_ws_h2_bootstrap_on_handshake_response_header_block_done(
+    struct aws_http_stream *stream,
+    enum aws_http_header_block header_block,
+    void *user_data);
+static int s_ws_h2_bootstrap_on_response_body(
+    struct aws_http_stream *stream,
+    const struct aws_byte_cursor *data,
+    void *user_data);
+static void s_ws_h2_bootstrap_on_stream_complete(struct aws_http_stream *stream, int error_code, void *user_data);
+static void s_ws_h2_bootstrap_on_stream_acquired(struct aws_http_stream *stream, int error_code, void *user_data);
+static void s_ws_h2_bootstrap_on_channel_setup(struct aws_channel *channel, int error_code, void *user_data);
+static void s_ws_h2_bootstrap_on_channel_shutdown(struct aws_channel *channel, int error_code, void *user_data);
+static int s_ws_h2_bootstrap_send_read_data(
+    struct aws_websocket_h2_bootstrap *ws_bootstrap,
+    struct aws_byte_cursor *data);
+static void s_ws_h2_bootstrap_send_pending_read_data(struct aws_websocket_h2_bootstrap *ws_bootstrap);
+static int s_ws_h2_bootstrap_write(struct aws_websocket_h2_bootstrap *ws_bootstrap, struct aws_io_message *message);
+
+static int s_handler_process_read_message(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    struct aws_io_message *message);
+static int s_handler_process_write_message(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    struct aws_io_message *message);
+static int s_handler_increment_read_window(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    size_t size);
+static int s_handler_shutdown(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    enum aws_channel_direction dir,
+    int error_code,
+    bool free_scarce_resources_immediately);
+static size_t s_handler_initial_window_size(struct aws_channel_handler *handler);
+static size_t s_handler_message_overhead(struct aws_channel_handler *handler);
+static void s_handler_destroy(struct aws_channel_handler *handler);
+
+static struct aws_channel_handler_vtable s_channel_handler_vtable = {
+    .process_read_message = s_handler_process_read_message,
+    .process_write_message = s_handler_process_write_message,
+    .increment_read_window = s_handler_increment_read_window,
+    .shutdown = s_handler_shutdown,
+    .initial_window_size = s_handler_initial_window_size,
+    .message_overhead = s_handler_message_overhead,
+    .destroy = s_handler_destroy,
+};
+
+int aws_websocket_client_connect_over_http2(const struct aws_websocket_client_http2_options *options) {
+    aws_http_fatal_assert_library_initialized();
+    AWS_ASSERT(options);
+
+    /* Validate options */
+    if (!options->allocator || !options->handshake_request || !options->on_connection_setup ||
+        (options->http2_connection == NULL) == (options->http2_stream_manager == NULL)) {
+
+        AWS_LOGF_ERROR(AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: Missing required websocket HTTP/2 options.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (options->http2_connection && aws_http_connection_get_version(options->http2_connection) != AWS_HTTP_VERSION_2) {
+        AWS_LOGF_ERROR(AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: Websocket connection must be HTTP/2.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (aws_http_message_get_protocol_version(options->handshake_request) != AWS_HTTP_VERSION_2) {
+        AWS_LOGF_ERROR(AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: Websocket request must be an HTTP/2 message.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    const struct aws_http_headers *request_headers = aws_http_message_get_const_headers(options->handshake_request);
+    struct aws_byte_cursor method;
+    if (aws_http2_headers_get_request_method(request_headers, &method) ||
+        aws_http_str_to_method(method) != AWS_HTTP_METHOD_CONNECT) {
+
+        AWS_LOGF_ERROR(AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: Websocket request must have method be 'CONNECT'.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct aws_byte_cursor protocol;
+    if (aws_http_headers_get(request_headers, aws_http_header_protocol, &protocol) ||
+        !aws_byte_cursor_eq_c_str_ignore_case(&protocol, "websocket")) {
+
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: Websocket request must have ':protocol' be 'websocket'.");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* Extensions are not currently supported */
+    if (aws_http_headers_has(request_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Extensions"))) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP, "id=static: 'Sec-WebSocket-Extensions' are not currently supported");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* Create bootstrap */
+    struct aws_websocket_h2_bootstrap *ws_bootstrap =
+        aws_mem_calloc(options->allocator, 1, sizeof(struct aws_websocket_h2_bootstrap));
+
+    ws_bootstrap->alloc = options->allocator;
+    aws_ref_count_init(&ws_bootstrap->ref_count, ws_bootstrap, s_ws_h2_bootstrap_on_refcount_zero);
+    ws_bootstrap->initial_window_size = options->initial_window_size;
+    ws_bootstrap->manual_window_update = options->manual_window_management;
+    ws_bootstrap->idle_trim_ms = options->idle_trim_ms;
+    ws_bootstrap->user_data = options->user_data;
+    ws_bootstrap->websocket_setup_callback = options->on_connection_setup;
+    ws_bootstrap->websocket_shutdown_callback = options->on_connection_shutdown;
+    ws_bootstrap->websocket_frame_begin_callback = options->on_incoming_frame_begin;
+    ws_bootstrap->websocket_frame_payload_callback = options->on_incoming_frame_payload;
+    ws_bootstrap->websocket_frame_complete_callback = options->on_incoming_frame_complete;
+    ws_bootstrap->handshake_request = aws_http_message_acquire(options->handshake_request);
+    ws_bootstrap->expected_sec_websocket_protocols =
+        aws_http_headers_get_all(request_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Protocol"));
+    ws_bootstrap->response_status = AWS_HTTP_STATUS_CODE_UNKNOWN;
+    ws_bootstrap->response_headers = aws_http_headers_new(ws_bootstrap->alloc);
+    aws_byte_buf_init(&ws_bootstrap->response_body, ws_bootstrap->alloc, 0);
+    aws_byte_buf_init(&ws_bootstrap->pending_read_data, ws_bootstrap->alloc, 0);
+
+    ws_bootstrap->handler.vtable = &s_channel_handler_vtable;
+    ws_bootstrap->handler.alloc = ws_bootstrap->alloc;
+    ws_bootstrap->handler.impl = ws_bootstrap;
+
+    /* The websocket's bytes are sent as DATA frames, via manual writes */
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = ws_bootstrap->handshake_request,
+        .user_data = ws_bootstrap,
+        .on_response_headers = s_ws_h2_bootstrap_on_handshake_response_headers,
+        .on_response_header_block_done = s_ws_h2_bootstrap_on_handshake_response_header_block_done,
+        .on_response_body = s_ws_h2_bootstrap_on_response_body,
+        .on_complete = s_ws_h2_bootstrap_on_stream_complete,
+        .http2_use_manual_data_writes = true,
+    };
+
+    if (options->http2_stream_manager) {
+        struct aws_http2_stream_manager_acquire_stream_options acquire_options = {
+            .callback = s_ws_h2_bootstrap_on_stream_acquired,
+            .user_data = ws_bootstrap,
+            .options = &request_options,
+        };
+        aws_http2_stream_manager_acquire_stream(options->http2_stream_manager, &acquire_options);
+
+    } else {
+        ws_bootstrap->stream = aws_http_connection_make_request(options->http2_connection, &request_options);
+        if (!ws_bootstrap->stream) {
+            AWS_LOGF_ERROR(
+                AWS_LS_HTTP_WEBSOCKET_SETUP,
+                "id=%p: Failed to make websocket extended CONNECT request, error %d (%s).",
+                (void *)ws_bootstrap,
+                aws_last_error(),
+                aws_error_name(aws_last_error()));
+            goto error;
+        }
+
+        if (aws_http_stream_activate(ws_bootstrap->stream)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_HTTP_WEBSOCKET_SETUP,
+                "id=%p: Failed to activate websocket extended CONNECT request, error %d (%s).",
+                (void *)ws_bootstrap,
+                aws_last_error(),
+                aws_error_name(aws_last_error()));
+            goto error;
+        }
+    }
+
+    /* Success! (so far) */
+    AWS_LOGF_TRACE(
+        AWS_LS_HTTP_WEBSOCKET_SETUP, "id=%p: Websocket setup begun over HTTP/2 stream.", (void *)ws_bootstrap);
+
+    return AWS_OP_SUCCESS;
+
+error:
+    aws_http_stream_release(ws_bootstrap->stream);
+    ws_bootstrap->stream = NULL;
+    aws_ref_count_release(&ws_bootstrap->ref_count);
+    return AWS_OP_ERR;
+}
+
+static void s_ws_h2_bootstrap_on_refcount_zero(void *user_data) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+    AWS_ASSERT(!ws_bootstrap->stream);
+    AWS_ASSERT(!ws_bootstrap->channel);
+
+    aws_http_message_release(ws_bootstrap->handshake_request);
+    aws_string_destroy(ws_bootstrap->expected_sec_websocket_protocols);
+    aws_http_headers_release(ws_bootstrap->response_headers);
+    aws_byte_buf_clean_up(&ws_bootstrap->response_body);
+    aws_byte_buf_clean_up(&ws_bootstrap->pending_read_data);
+
+    aws_mem_release(ws_bootstrap->alloc, ws_bootstrap);
+}
+
+static void s_ws_h2_bootstrap_invoke_setup_callback(struct aws_websocket_h2_bootstrap *ws_bootstrap, int error_code) {
+
+    /* sanity check: websocket XOR error_code is set. both cannot be set. both cannot be unset */
+    AWS_FATAL_ASSERT((error_code != 0) ^ (ws_bootstrap->websocket != NULL));
+
+    if (error_code) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Websocket setup failed, error %d (%s).",
+            (void *)ws_bootstrap,
+            error_code,
+            aws_error_name(error_code));
+    }
+
+    /* Report things about the response, if we received them */
+    int *response_status_ptr = NULL;
+    struct aws_http_header *response_header_array = NULL;
+    size_t num_response_headers = 0;
+    struct aws_byte_cursor *response_body_ptr = NULL;
+    struct aws_byte_cursor response_body_cursor = {.len = 0};
+
+    if (ws_bootstrap->got_full_response_headers) {
+        response_status_ptr = &ws_bootstrap->response_status;
+
+        num_response_headers = aws_http_headers_count(ws_bootstrap->response_headers);
+
+        response_header_array =
+            aws_mem_calloc(ws_bootstrap->alloc, aws_max_size(1, num_response_headers), sizeof(struct aws_http_header));
+
+        for (size_t i = 0; i < num_response_headers; ++i) {
+            aws_http_headers_get_index(ws_bootstrap->response_headers, i, &response_header_array[i]);
+        }
+
+        if (ws_bootstrap->got_full_response_body) {
+            response_body_cursor = aws_byte_cursor_from_buf(&ws_bootstrap->response_body);
+            response_body_ptr = &response_body_cursor;
+        }
+    }
+
+    struct aws_websocket_on_connection_setup_data setup_data = {
+        .error_code = error_code,
+        .websocket = ws_bootstrap->websocket,
+        .handshake_response_status = response_status_ptr,
+        .handshake_response_header_array = response_header_array,
+        .num_handshake_response_headers = num_response_headers,
+        .handshake_response_body = response_body_ptr,
+    };
+
+    ws_bootstrap->websocket_setup_callback(&setup_data, ws_bootstrap->user_data);
+
+    /* Clear setup callback so that we know that it's been invoked. */
+    ws_bootstrap->websocket_setup_callback = NULL;
+
+    if (response_header_array) {
+        aws_mem_release(ws_bootstrap->alloc, response_header_array);
+    }
+}
+
+/* Invoked when the stream manager has acquired (and activated) the stream, or failed to */
+static void s_ws_h2_bootstrap_on_stream_acquired(struct aws_http_stream *stream, int error_code, void *user_data) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    if (error_code) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Failed to acquire HTTP/2 stream for websocket, error %d (%s).",
+            (void *)ws_bootstrap,
+            error_code,
+            aws_error_name(error_code));
+
+        /* The stream's callbacks will never fire, so the stream's reference is released here */
+        s_ws_h2_bootstrap_invoke_setup_callback(ws_bootstrap, error_code);
+        aws_ref_count_release(&ws_bootstrap->ref_count);
+        return;
+    }
+
+    ws_bootstrap->stream = stream;
+}
+
+/* Invoked repeatedly as handshake response headers arrive */
+static int s_ws_h2_bootstrap_on_handshake_response_headers(
+    struct aws_http_stream *stream,
+    enum aws_http_header_block header_block,
+    const struct aws_http_header *header_array,
+    size_t num_headers,
+    void *user_data) {
+
+    (void)stream;
+    (void)header_block;
+
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    /* Trailing headers after the websocket is running are of no interest */
+    if (!ws_bootstrap->websocket_setup_callback) {
+        return AWS_OP_SUCCESS;
+    }
+
+    /* Deep-copy headers into ws_bootstrap */
+    aws_http_headers_add_array(ws_bootstrap->response_headers, header_array, num_headers);
+
+    /* Don't report a partially-received response */
+    ws_bootstrap->got_full_response_headers = false;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* OK, we've got all the headers for the 200 response.
+ * Validate the handshake response, and create the channel which the websocket will run in.
+ * Setup continues once the channel is set up. */
+static int s_ws_h2_bootstrap_validate_response_and_create_channel(
+    struct aws_websocket_h2_bootstrap *ws_bootstrap,
+    struct aws_http_stream *stream) {
+
+    /* RFC-8441 4: Unlike RFC-6455 there's no Sec-WebSocket-Accept to check,
+     * but extensions and sub-protocols are negotiated the same way */
+    if (aws_http_headers_has(ws_bootstrap->response_headers, aws_byte_cursor_from_c_str("Sec-WebSocket-Extensions"))) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Response has 'Sec-WebSocket-Extensions' header, but client does not support extensions.",
+            (void *)ws_bootstrap);
+        aws_raise_error(AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE);
+        goto error;
+    }
+
+    if (aws_websocket_validate_sec_websocket_protocol(
+            ws_bootstrap, ws_bootstrap->expected_sec_websocket_protocols, ws_bootstrap->response_headers)) {
+        goto error;
+    }
+
+    /* The channel shares the HTTP/2 connection's event-loop, so the stream and the websocket
+     * are only ever touched from that one thread */
+    struct aws_channel *http_channel = aws_http_connection_get_channel(aws_http_stream_get_connection(stream));
+    struct aws_channel_options channel_options = {
+        .event_loop = aws_channel_get_event_loop(http_channel),
+        .on_setup_completed = s_ws_h2_bootstrap_on_channel_setup,
+        .on_shutdown_completed = s_ws_h2_bootstrap_on_channel_shutdown,
+        .setup_user_data = ws_bootstrap,
+        .shutdown_user_data = ws_bootstrap,
+        .enable_read_back_pressure = ws_bootstrap->manual_window_update,
+    };
+
+    ws_bootstrap->channel = aws_channel_new(ws_bootstrap->alloc, &channel_options);
+    if (!ws_bootstrap->channel) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Failed to create channel for websocket, error %d (%s)",
+            (void *)ws_bootstrap,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        goto error;
+    }
+
+    AWS_LOGF_TRACE(
+        AWS_LS_HTTP_WEBSOCKET_SETUP,
+        "id=%p: Extended CONNECT accepted, creating channel=%p for websocket.",
+        (void *)ws_bootstrap,
+        (void *)ws_bootstrap->channel);
+
+    return AWS_OP_SUCCESS;
+
+error:
+    ws_bootstrap->setup_error_code = aws_last_error();
+    /* Returning error resets the stream, setup failure is reported when it completes */
+    return AWS_OP_ERR;
+}
+
+/**
+ * Invoked each time we reach the end of a block of response headers.
+ * RFC-8441 5: a 200 response means the websocket is established,
+ * and the rest of the stream carries websocket frames.
+ */
+static int s_ws_h2_bootstrap_on_handshake_response_header_block_done(
+    struct aws_http_stream *stream,
+    enum aws_http_header_block header_block,
+    void *user_data) {
+
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    if (!ws_bootstrap->websocket_setup_callback) {
+        return AWS_OP_SUCCESS;
+    }
+
+    /* Get status code from stream */
+    aws_http_stream_get_incoming_response_status(stream, &ws_bootstrap->response_status);
+
+    ws_bootstrap->got_full_response_headers = true;
+
+    if (header_block == AWS_HTTP_HEADER_BLOCK_INFORMATIONAL) {
+        /* Another response should come eventually. Just ignore the headers from this one... */
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Server sent interim response with status code %d",
+            (void *)ws_bootstrap,
+            ws_bootstrap->response_status);
+
+        aws_http_headers_clear(ws_bootstrap->response_headers);
+        ws_bootstrap->got_full_response_headers = false;
+        return AWS_OP_SUCCESS;
+    }
+
+    if (header_block == AWS_HTTP_HEADER_BLOCK_MAIN && ws_bootstrap->response_status == AWS_HTTP_STATUS_CODE_200_OK) {
+        return s_ws_h2_bootstrap_validate_response_and_create_channel(ws_bootstrap, stream);
+    }
+
+    /* The handshake did not succeed. Keep the stream going.
+     * We'll report failed setup to the user after we've received the complete response */
+    ws_bootstrap->setup_error_code = AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE;
+
+    /* Nothing will be written, so end our side of the stream, or it can't complete */
+    return s_ws_h2_bootstrap_write(ws_bootstrap, NULL /*message*/);
+}
+
+/**
+ * Invoked as DATA arrives on the stream.
+ * Before the handshake succeeds, this is the body of a failed response.
+ * After, it's websocket frames, which are passed along the channel.
+ */
+static int s_ws_h2_bootstrap_on_response_body(
+    struct aws_http_stream *stream,
+    const struct aws_byte_cursor *data,
+    void *user_data) {
+
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    if (!ws_bootstrap->channel) {
+        if (ws_bootstrap->websocket_setup_callback) {
+            aws_byte_buf_append_dynamic(&ws_bootstrap->response_body, data);
+
+            /* If we're managing the read window, keep it open so that we receive the whole response */
+            if (ws_bootstrap->manual_window_update) {
+                aws_http_stream_update_window(stream, data->len);
+            }
+        }
+
+        /* Otherwise the websocket has already shut down, and the data is dropped */
+        return AWS_OP_SUCCESS;
+    }
+
+    /* Send along as much as the websocket's read window allows, straight from the DATA frame */
+    struct aws_byte_cursor remaining = *data;
+    if (ws_bootstrap->pending_read_data.len == 0 && !ws_bootstrap->is_sending_read_data) {
+        ws_bootstrap->is_sending_read_data = true;
+        int err = s_ws_h2_bootstrap_send_read_data(ws_bootstrap, &remaining);
+        ws_bootstrap->is_sending_read_data = false;
+        if (err) {
+            return AWS_OP_SUCCESS;
+        }
+    }
+
+    if (remaining.len == 0) {
+        return AWS_OP_SUCCESS;
+    }
+
+    /* Data can arrive before the channel is set up, or faster than the websocket's read window allows.
+     * Hold onto it until it can be sent along. */
+    size_t unsent_len = ws_bootstrap->pending_read_data.len - ws_bootstrap->pending_read_data_sent;
+    if (!aws_http_stream_get_connection(stream)->stream_manual_window_management) {
+        struct aws_http2_setting local_settings[AWS_HTTP2_SETTINGS_COUNT];
+        aws_http2_connection_get_local_settings(aws_http_stream_get_connection(stream), local_settings);
+        uint32_t max_pending = local_settings[AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE - 1].value;
+        if (unsent_len + remaining.len > max_pending) {
+            AWS_LOGF_ERROR(
+                AWS_LS_HTTP_WEBSOCKET,
+                "id=%p: Peer sent more than %" PRIu32
+                " bytes the websocket couldn't take. The HTTP/2 connection needs manual window management "
+                "for its flow-control window to follow the websocket's read window.",
+                (void *)ws_bootstrap->websocket,
+                max_pending);
+            return aws_raise_error(AWS_ERROR_OVERFLOW_DETECTED);
+        }
+    }
+
+    /* Drop what's already been sent, rather than letting the buffer grow */
+    if (ws_bootstrap->pending_read_data_sent > 0) {
+        memmove(
+            ws_bootstrap->pending_read_data.buffer,
+            ws_bootstrap->pending_read_data.buffer + ws_bootstrap->pending_read_data_sent,
+            unsent_len);
+        ws_bootstrap->pending_read_data.len = unsent_len;
+        ws_bootstrap->pending_read_data_sent = 0;
+    }
+
+    aws_byte_buf_append_dynamic(&ws_bootstrap->pending_read_data, &remaining);
+    s_ws_h2_bootstrap_send_pending_read_data(ws_bootstrap);
+    return AWS_OP_SUCCESS;
+}
+
+/**
+ * Invoked when the stream completes.
+ *
+ * If the websocket is running, then the stream was reset, the connection was lost,
+ * or both sides ended the stream after the websocket shut down.
+ *
+ * Otherwise, the handshake failed and we report that now,
+ * unless the channel is still being set up, in which case failure is reported from there.
+ */
+static void s_ws_h2_bootstrap_on_stream_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    /* Only report the body if we received a complete response */
+    if (error_code == 0) {
+        ws_bootstrap->got_full_response_body = true;
+    }
+
+    ws_bootstrap->stream = NULL;
+
+    if (ws_bootstrap->channel) {
+        if (ws_bootstrap->slot) {
+            aws_channel_shutdown(
+                ws_bootstrap->channel, error_code ? error_code : AWS_ERROR_HTTP_STREAM_HAS_COMPLETED);
+        } else if (!ws_bootstrap->setup_error_code) {
+            /* Channel setup is still in progress, it will fail when it sees the stream is gone */
+            ws_bootstrap->setup_error_code = error_code ? error_code : AWS_ERROR_HTTP_STREAM_HAS_COMPLETED;
+        }
+
+    } else if (ws_bootstrap->websocket_setup_callback) {
+        /* If there's already a setup_error_code, use that */
+        if (ws_bootstrap->setup_error_code) {
+            error_code = ws_bootstrap->setup_error_code;
+        }
+
+        /* Ensure non-zero error_code is passed */
+        if (!error_code) {
+            error_code = AWS_ERROR_UNKNOWN;
+        }
+
+        s_ws_h2_bootstrap_invoke_setup_callback(ws_bootstrap, error_code);
+    }
+
+    /* Done with stream, let it be cleaned up */
+    aws_http_stream_release(stream);
+    aws_ref_count_release(&ws_bootstrap->ref_count);
+}
+
+/* Channel is set up. Install ourselves as the first handler, then the websocket handler after us. */
+static void s_ws_h2_bootstrap_on_channel_setup(struct aws_channel *channel, int error_code, void *user_data) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+    AWS_ASSERT(channel == ws_bootstrap->channel);
+
+    /* The stream may have failed while the channel was being set up */
+    if (!error_code && ws_bootstrap->setup_error_code) {
+        error_code = ws_bootstrap->setup_error_code;
+    }
+
+    if (error_code) {
+        /* The channel never ran, so it won't shut down. Clean it up now. */
+        aws_channel_destroy(channel);
+        ws_bootstrap->channel = NULL;
+
+        if (ws_bootstrap->stream) {
+            /* Failure is reported when the stream completes */
+            ws_bootstrap->setup_error_code = error_code;
+            aws_http_stream_cancel(ws_bootstrap->stream, error_code);
+        } else {
+            s_ws_h2_bootstrap_invoke_setup_callback(ws_bootstrap, error_code);
+        }
+        return;
+    }
+
+    struct aws_channel_slot *slot = aws_channel_slot_new(channel);
+    if (!slot) {
+        goto error;
+    }
+
+    if (aws_channel_slot_insert_end(channel, slot)) {
+        goto error;
+    }
+
+    if (aws_channel_slot_set_handler(slot, &ws_bootstrap->handler)) {
+        goto error;
+    }
+
+    /* The channel's reference is released when it destroys its handlers */
+    aws_ref_count_acquire(&ws_bootstrap->ref_count);
+    ws_bootstrap->slot = slot;
+
+    struct aws_websocket_handler_options ws_options = {
+        .allocator = ws_bootstrap->alloc,
+        .channel = channel,
+        .initial_window_size = ws_bootstrap->initial_window_size,
+        .user_data = ws_bootstrap->user_data,
+        .on_incoming_frame_begin = ws_bootstrap->websocket_frame_begin_callback,
+        .on_incoming_frame_payload = ws_bootstrap->websocket_frame_payload_callback,
+        .on_incoming_frame_complete = ws_bootstrap->websocket_frame_complete_callback,
+        .is_server = false,
+        .manual_window_update = ws_bootstrap->manual_window_update,
+        .idle_trim_ms = ws_bootstrap->idle_trim_ms,
+    };
+
+    ws_bootstrap->websocket = aws_websocket_handler_new(&ws_options);
+    if (!ws_bootstrap->websocket) {
+        AWS_LOGF_ERROR(
+            AWS_LS_HTTP_WEBSOCKET_SETUP,
+            "id=%p: Failed to create websocket handler, error %d (%s)",
+            (void *)ws_bootstrap,
+            aws_last_error(),
+            aws_error_name(aws_last_error()));
+        goto error;
+    }
+
+    /* Success! Setup complete! */
+    AWS_LOGF_TRACE(/* Log for tracing setup id to websocket id.  */
+                   AWS_LS_HTTP_WEBSOCKET_SETUP,
+                   "id=%p: Setup success, created websocket=%p",
+                   (void *)ws_bootstrap,
+                   (void *)ws_bootstrap->websocket);
+
+    AWS_LOGF_DEBUG(/* Debug log about creation of websocket. */
+                   AWS_LS_HTTP_WEBSOCKET,
+                   "id=%p: Websocket client connection established over HTTP/2 stream.",
+                   (void *)ws_bootstrap->websocket);
+
+    s_ws_h2_bootstrap_invoke_setup_callback(ws_bootstrap, 0 /*error_code*/);
+
+    /* Send along any data that arrived while the channel was being set up */
+    s_ws_h2_bootstrap_send_pending_read_data(ws_bootstrap);
+    return;
+
+error:
+    /* Failure is reported when channel shutdown completes */
+    ws_bootstrap->setup_error_code = aws_last_error();
+    aws_channel_shutdown(channel, ws_bootstrap->setup_error_code);
+}
+
+static void s_ws_h2_bootstrap_on_channel_shutdown(struct aws_channel *channel, int error_code, void *user_data) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = user_data;
+
+    /* Inform user that connection has completely shut down.
+     * If setup callback still hasn't fired, invoke it now and indicate failure.
+     * Otherwise, invoke shutdown callback. */
+    if (ws_bootstrap->websocket_setup_callback) {
+        AWS_ASSERT(!ws_bootstrap->websocket);
+
+        if (ws_bootstrap->setup_error_code) {
+            error_code = ws_bootstrap->setup_error_code;
+        }
+
+        if (!error_code) {
+            error_code = AWS_ERROR_UNKNOWN;
+        }
+
+        s_ws_h2_bootstrap_invoke_setup_callback(ws_bootstrap, error_code);
+
+    } else if (ws_bootstrap->websocket_shutdown_callback) {
+        AWS_ASSERT(ws_bootstrap->websocket);
+
+        AWS_LOGF_DEBUG(
+            AWS_LS_HTTP_WEBSOCKET,
+            "id=%p: Websocket client connection over HTTP/2 stream shut down with error %d (%s).",
+            (void *)ws_bootstrap->websocket,
+            error_code,
+            aws_error_name(error_code));
+
+        ws_bootstrap->websocket_shutdown_callback(ws_bootstrap->websocket, error_code, ws_bootstrap->user_data);
+    }
+
+    /* The channel's memory isn't reclaimed until the user releases the websocket too */
+    ws_bootstrap->channel = NULL;
+    ws_bootstrap->slot = NULL;
+    aws_channel_destroy(channel);
+}
+
+/**
+ * Send data received on the stream along the channel, as much as the websocket's read window allows.
+ * The cursor is advanced past whatever was sent. On failure, the channel is shut down.
+ */
+static int s_ws_h2_bootstrap_send_read_data(
+    struct aws_websocket_h2_bootstrap *ws_bootstrap,
+    struct aws_byte_cursor *data) {
+
+    AWS_ASSERT(ws_bootstrap->is_sending_read_data);
+
+    if (!ws_bootstrap->slot || !ws_bootstrap->websocket) {
+        return AWS_OP_SUCCESS;
+    }
+
+    while (ws_bootstrap->slot && data->len > 0) {
+        size_t window = aws_channel_slot_downstream_read_window(ws_bootstrap->slot);
+        if (window == 0) {
+            break;
+        }
+
+        struct aws_io_message *msg = aws_channel_acquire_message_from_pool(
+            ws_bootstrap->channel, AWS_IO_MESSAGE_APPLICATION_DATA, aws_min_size(data->len, window));
+        if (!msg) {
+            goto error;
+        }
+
+        size_t sending_bytes = aws_min_size(aws_min_size(data->len, window), msg->message_data.capacity);
+        struct aws_byte_cursor sending_data = aws_byte_cursor_advance(data, sending_bytes);
+        aws_byte_buf_write_from_whole_cursor(&msg->message_data, sending_data);
+
+        if (aws_channel_slot_send_message(ws_bootstrap->slot, msg, AWS_CHANNEL_DIR_READ)) {
+            aws_mem_release(msg->allocator, msg);
+            goto error;
+        }
+
+        /* The websocket has the data now, so the peer may send more */
+        if (ws_bootstrap->stream) {
+            aws_http_stream_update_window(ws_bootstrap->stream, sending_bytes);
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+
+error:
+    AWS_LOGF_ERROR(
+        AWS_LS_HTTP_WEBSOCKET,
+        "id=%p: Failed to send message in read direction, error %d (%s).",
+        (void *)ws_bootstrap->websocket,
+        aws_last_error(),
+        aws_error_name(aws_last_error()));
+
+    aws_channel_shutdown(ws_bootstrap->channel, aws_last_error());
+    return AWS_OP_ERR;
+}
+
+/* Send along data that was held because it arrived before the websocket could take it */
+static void s_ws_h2_bootstrap_send_pending_read_data(struct aws_websocket_h2_bootstrap *ws_bootstrap) {
+    /* Sending a message can result in the window being incremented, which lands us here again */
+    if (ws_bootstrap->is_sending_read_data) {
+        return;
+    }
+
+    struct aws_byte_cursor unsent = aws_byte_cursor_from_buf(&ws_bootstrap->pending_read_data);
+    aws_byte_cursor_advance(&unsent, ws_bootstrap->pending_read_data_sent);
+    if (unsent.len == 0) {
+        return;
+    }
+
+    ws_bootstrap->is_sending_read_data = true;
+    size_t unsent_len = unsent.len;
+    int err = s_ws_h2_bootstrap_send_read_data(ws_bootstrap, &unsent);
+    ws_bootstrap->pending_read_data_sent += unsent_len - unsent.len;
+    ws_bootstrap->is_sending_read_data = false;
+
+    if (!err && ws_bootstrap->pending_read_data_sent == ws_bootstrap->pending_read_data.len) {
+        aws_byte_buf_reset(&ws_bootstrap->pending_read_data, false /*zero_contents*/);
+        ws_bootstrap->pending_read_data_sent = 0;
+    }
+}
+
+static void s_ws_h2_bootstrap_on_write_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
+    (void)stream;
+    struct aws_websocket_h2_write *write = user_data;
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = write->ws_bootstrap;
+
+    if (write->message) {
+        if (write->message->on_completion) {
+            write->message->on_completion(
+                write->message->owning_channel, write->message, error_code, write->message->user_data);
+        }
+        aws_mem_release(write->message->allocator, write->message);
+    }
+    aws_input_stream_release(write->data);
+    aws_mem_release(ws_bootstrap->alloc, write);
+
+    AWS_ASSERT(ws_bootstrap->pending_write_count > 0);
+    ws_bootstrap->pending_write_count--;
+
+    if (ws_bootstrap->pending_write_count == 0 && ws_bootstrap->is_waiting_on_writes_to_finish_shutdown) {
+        ws_bootstrap->is_waiting_on_writes_to_finish_shutdown = false;
+        aws_channel_slot_on_handler_shutdown_complete(
+            ws_bootstrap->slot,
+            AWS_CHANNEL_DIR_WRITE,
+            ws_bootstrap->shutdown_error_code,
+            ws_bootstrap->shutdown_free_scarce_resources_immediately);
+    }
+}
+
+/* Write the message's data to the stream (or end the stream, if message is NULL) */
+static int s_ws_h2_bootstrap_write(struct aws_websocket_h2_bootstrap *ws_bootstrap, struct aws_io_message *message) {
+    if (!ws_bootstrap->stream) {
+        return aws_raise_error(AWS_ERROR_HTTP_STREAM_HAS_COMPLETED);
+    }
+
+    struct aws_byte_cursor data = {.len = 0};
+    if (message) {
+        data = aws_byte_cursor_from_buf(&message->message_data);
+    }
+
+    struct aws_websocket_h2_write *write =
+        aws_mem_calloc(ws_bootstrap->alloc, 1, sizeof(struct aws_websocket_h2_write));
+    write->ws_bootstrap = ws_bootstrap;
+    write->message = message;
+    write->data = aws_input_stream_new_from_cursor(ws_bootstrap->alloc, &data);
+    if (!write->data) {
+        goto error;
+    }
+
+    struct aws_http2_stream_write_data_options write_options = {
+        .data = write->data,
+        .end_stream = message == NULL,
+        .on_complete = s_ws_h2_bootstrap_on_write_complete,
+        .user_data = write,
+    };
+
+    if (aws_http2_stream_write_data(ws_bootstrap->stream, &write_options)) {
+        goto error;
+    }
+
+    ws_bootstrap->pending_write_count++;
+    return AWS_OP_SUCCESS;
+
+error:
+    aws_input_stream_release(write->data);
+    aws_mem_release(ws_bootstrap->alloc, write);
+    return AWS_OP_ERR;
+}
+
+static int s_handler_process_read_message(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    struct aws_io_message *message) {
+
+    (void)handler;
+    (void)slot;
+    (void)message;
+
+    /* This is the first handler in the channel, nothing is upstream of it */
+    AWS_ASSERT(false);
+    return aws_raise_error(AWS_ERROR_INVALID_STATE);
+}
+
+static int s_handler_process_write_message(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    struct aws_io_message *message) {
+
+    (void)slot;
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = handler->impl;
+
+    /* On success, the message is released once the write completes */
+    return s_ws_h2_bootstrap_write(ws_bootstrap, message);
+}
+
+static int s_handler_increment_read_window(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    size_t size) {
+
+    (void)slot;
+    (void)size;
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = handler->impl;
+
+    s_ws_h2_bootstrap_send_pending_read_data(ws_bootstrap);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_handler_shutdown(
+    struct aws_channel_handler *handler,
+    struct aws_channel_slot *slot,
+    enum aws_channel_direction dir,
+    int error_code,
+    bool free_scarce_resources_immediately) {
+
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = handler->impl;
+
+    if (dir == AWS_CHANNEL_DIR_WRITE && ws_bootstrap->stream) {
+        /* RFC-8441 5: An orderly close ends the stream, anything else resets it */
+        bool ended_stream = false;
+        if (!error_code && !free_scarce_resources_immediately) {
+            ended_stream = s_ws_h2_bootstrap_write(ws_bootstrap, NULL /*message*/) == AWS_OP_SUCCESS;
+        }
+
+        if (!ended_stream) {
+            aws_http_stream_cancel(ws_bootstrap->stream, error_code ? error_code : AWS_ERROR_HTTP_CONNECTION_CLOSED);
+        }
+
+        /* Don't finish shutdown until outstanding writes are done with their messages */
+        if (ws_bootstrap->pending_write_count > 0) {
+            ws_bootstrap->is_waiting_on_writes_to_finish_shutdown = true;
+            ws_bootstrap->shutdown_error_code = error_code;
+            ws_bootstrap->shutdown_free_scarce_resources_immediately = free_scarce_resources_immediately;
+            return AWS_OP_SUCCESS;
+        }
+    }
+
+    return aws_channel_slot_on_handler_shutdown_complete(slot, dir, error_code, free_scarce_resources_immediately);
+}
+
+static size_t s_handler_initial_window_size(struct aws_channel_handler *handler) {
+    (void)handler;
+    /* Nothing is upstream of this handler */
+    return SIZE_MAX;
+}
+
+static size_t s_handler_message_overhead(struct aws_channel_handler *handler) {
+    (void)handler;
+    return 0;
+}
+
+static void s_handler_destroy(struct aws_channel_handler *handler) {
+    struct aws_websocket_h2_bootstrap *ws_bootstrap = handler->impl;
+    aws_ref_count_release(&ws_bootstrap->ref_count);
+}
@@ -352,7 +352,7 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
                         uint32_t value = 0;
                         aws_byte_cursor_read_be16(&input, &id);
                         aws_byte_cursor_read_be32(&input, &value);
-                        if (id >= AWS_HTTP2_SETTINGS_BEGIN_RANGE && id < AWS_HTTP2_SETTINGS_END_RANGE) {
+                        if (aws_h2_settings_id_is_known(id)) {
                             value = aws_max_u32(value, aws_h2_settings_bounds[id][0]);
                             value = aws_min_u32(value, aws_h2_settings_bounds[id][1]);
                         }
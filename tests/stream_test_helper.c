@@ -115,8 +115,46 @@ static int s_on_body(struct aws_http_stream *stream, const struct aws_byte_curso
     struct client_stream_tester *tester = user_data;
     ASSERT_FALSE(tester->complete);
     ASSERT_SUCCESS(aws_byte_buf_append_dynamic(&tester->response_body, data));
+    tester->num_body_callbacks++;
     return AWS_OP_SUCCESS;
 }
+
+static int s_on_body_vectored(
+    struct aws_http_stream *stream,
+    const struct aws_byte_cursor *slices,
+    size_t num_slices,
+    void *user_data) {
+    (void)stream;
+    struct client_stream_tester *tester = user_data;
+    ASSERT_FALSE(tester->complete);
+    /* Body must arrive before any trailing headers */
+    ASSERT_UINT_EQUALS(0, aws_http_headers_count(tester->response_trailer));
+    ASSERT_TRUE(num_slices > 0);
+    for (size_t i = 0; i < num_slices; ++i) {
+        ASSERT_TRUE(slices[i].len > 0);
+        ASSERT_SUCCESS(aws_byte_buf_append_dynamic(&tester->response_body, &slices[i]));
+    }
+    tester->num_body_callbacks++;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_on_body_retained(
+    struct aws_http_stream *stream,
+    struct aws_http_retained_body *retained_body,
+    const struct aws_byte_cursor *data,
+    void *user_data) {
+    (void)stream;
+    struct client_stream_tester *tester = user_data;
+    ASSERT_FALSE(tester->complete);
+    ASSERT_TRUE(data->len > 0);
+    ASSERT_TRUE(tester->num_retained_slices < AWS_ARRAY_SIZE(tester->retained_slices));
+    tester->retained_bodies[tester->num_retained_slices] = aws_http_retained_body_acquire(retained_body);
+    tester->retained_slices[tester->num_retained_slices] = *data;
+    tester->num_retained_slices++;
+    tester->num_body_callbacks++;
+    return AWS_OP_SUCCESS;
+}
+
 static void s_on_metrics(
     struct aws_http_stream *stream,
     const struct aws_http_stream_metrics *metrics,
@@ -197,10 +235,15 @@ int client_stream_tester_init(
         .user_data = tester,
         .on_response_headers = s_on_headers,
         .on_response_header_block_done = s_on_header_block_done,
-        .on_response_body = s_on_body,
+        .on_response_body = options->use_vectored_body ? NULL : s_on_body,
+        .on_response_body_vectored = options->use_vectored_body ? s_on_body_vectored : NULL,
+        .on_response_body_retained = options->use_retained_body ? s_on_body_retained : NULL,
         .on_metrics = s_on_metrics,
         .on_complete = s_on_complete,
         .on_destroy = s_on_destroy,
+        .use_body_ready_notifications = options->use_body_ready_notifications,
+        .send_rate_limiter = options->send_rate_limiter,
+        .receive_rate_limiter = options->receive_rate_limiter,
     };
     tester->stream = aws_http_connection_make_request(options->connection, &request_options);
     ASSERT_NOT_NULL(tester->stream);
@@ -209,7 +252,20 @@ int client_stream_tester_init(
     return AWS_OP_SUCCESS;
 }
 
+int client_stream_tester_release_retained_body(struct client_stream_tester *tester) {
+    for (size_t i = 0; i < tester->num_retained_slices; ++i) {
+        ASSERT_SUCCESS(aws_byte_buf_append_dynamic(&tester->response_body, &tester->retained_slices[i]));
+        aws_http_retained_body_release(tester->retained_bodies[i]);
+    }
+    tester->num_retained_slices = 0;
+    return AWS_OP_SUCCESS;
+}
+
 void client_stream_tester_clean_up(struct client_stream_tester *tester) {
+    for (size_t i = 0; i < tester->num_retained_slices; ++i) {
+        aws_http_retained_body_release(tester->retained_bodies[i]);
+    }
+
     for (size_t i = 0; i < tester->num_info_responses; ++i) {
         aws_http_message_release(tester->info_responses[i]);
     }
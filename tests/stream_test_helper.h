@@ -37,6 +37,13 @@ struct client_stream_tester {
     bool response_trailer_done;
 
     struct aws_byte_buf response_body;
+    /* Number of times a body callback (vectored or not) was invoked */
+    size_t num_body_callbacks;
+
+    /* Body received via on_response_body_retained, held uncopied until client_stream_tester_release_retained_body() */
+    struct aws_http_retained_body *retained_bodies[8];
+    struct aws_byte_cursor retained_slices[8];
+    size_t num_retained_slices;
 
     bool complete;
     int on_complete_error_code;
@@ -51,6 +58,13 @@ struct client_stream_tester {
 struct client_stream_tester_options {
     struct aws_http_message *request;
     struct aws_http_connection *connection;
+    bool use_body_ready_notifications;
+    /* Receive body via on_response_body_vectored instead of on_response_body */
+    bool use_vectored_body;
+    /* Receive body via on_response_body_retained instead of on_response_body */
+    bool use_retained_body;
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
 };
 
 int client_stream_tester_init(
@@ -60,4 +74,7 @@ int client_stream_tester_init(
 
 void client_stream_tester_clean_up(struct client_stream_tester *tester);
 
+/* Copy any retained body slices into response_body, then release them */
+int client_stream_tester_release_retained_body(struct client_stream_tester *tester);
+
 #endif /* AWS_HTTP_STREAM_TEST_HELPER_H */
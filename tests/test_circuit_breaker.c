@@ -0,0 +1,83 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/circuit_breaker.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#define MS_TO_NS(ms) ((uint64_t)(ms) * 1000000)
+
+/* Only consecutive failures count, and reaching the threshold stops all connects */
+static int s_circuit_breaker_opens_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_circuit_breaker breaker;
+
+    /* Defaults */
+    struct aws_http_connection_manager_circuit_breaker_options options = {0};
+    aws_http_circuit_breaker_init(&breaker, &options);
+    ASSERT_UINT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_FAILURE_THRESHOLD, breaker.failure_threshold);
+    ASSERT_UINT_EQUALS(MS_TO_NS(AWS_HTTP_CIRCUIT_BREAKER_DEFAULT_OPEN_TIMEOUT_MS), breaker.open_timeout_ns);
+
+    options.failure_threshold = 3;
+    aws_http_circuit_breaker_init(&breaker, &options);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_CLOSED, aws_http_circuit_breaker_get_state(&breaker, 0));
+    ASSERT_UINT_EQUALS(SIZE_MAX, aws_http_circuit_breaker_get_connect_allowance(&breaker, 0, 10));
+
+    /* A success in between resets the count */
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, false);
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, false);
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, true);
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, false);
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, false);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_CLOSED, aws_http_circuit_breaker_get_state(&breaker, 0));
+
+    aws_http_circuit_breaker_on_connect_result(&breaker, MS_TO_NS(10), false);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_OPEN, aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(10)));
+    ASSERT_UINT_EQUALS(0, aws_http_circuit_breaker_get_connect_allowance(&breaker, MS_TO_NS(10), 0));
+
+    /* Stragglers failing after it opened don't push the timeout back */
+    aws_http_circuit_breaker_on_connect_result(&breaker, MS_TO_NS(1000), false);
+    ASSERT_INT_EQUALS(
+        AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN,
+        aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(10) + breaker.open_timeout_ns));
+    /* Only a connect check commits to half-open, a state query doesn't */
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_OPEN, breaker.state);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(circuit_breaker_opens_test, s_circuit_breaker_opens_test_fn)
+
+/* Half-open allows a single probe, whose result decides what's next */
+static int s_circuit_breaker_half_open_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_circuit_breaker breaker;
+    struct aws_http_connection_manager_circuit_breaker_options options = {
+        .failure_threshold = 1,
+        .open_timeout_ms = 100,
+    };
+    aws_http_circuit_breaker_init(&breaker, &options);
+
+    aws_http_circuit_breaker_on_connect_result(&breaker, 0, false);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_OPEN, aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(99)));
+
+    ASSERT_UINT_EQUALS(1, aws_http_circuit_breaker_get_connect_allowance(&breaker, MS_TO_NS(100), 0));
+    ASSERT_UINT_EQUALS(0, aws_http_circuit_breaker_get_connect_allowance(&breaker, MS_TO_NS(100), 1));
+
+    /* The probe fails, so it's open for another timeout */
+    aws_http_circuit_breaker_on_connect_result(&breaker, MS_TO_NS(150), false);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_OPEN, aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(200)));
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN, aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(250)));
+
+    /* The probe succeeds */
+    aws_http_circuit_breaker_on_connect_result(&breaker, MS_TO_NS(260), true);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_CLOSED, aws_http_circuit_breaker_get_state(&breaker, MS_TO_NS(260)));
+    ASSERT_UINT_EQUALS(SIZE_MAX, aws_http_circuit_breaker_get_connect_allowance(&breaker, MS_TO_NS(260), 5));
+    ASSERT_UINT_EQUALS(0, breaker.consecutive_failures);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(circuit_breaker_half_open_test, s_circuit_breaker_half_open_test_fn)
@@ -0,0 +1,133 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/concurrency_limiter.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#define MS_TO_NS(ms) ((uint64_t)(ms) * 1000000)
+
+static int s_concurrency_limiter_init_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_concurrency_limiter limiter;
+
+    /* Defaults */
+    struct aws_http_concurrency_limit_options options = {0};
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+    ASSERT_UINT_EQUALS(AWS_HTTP_CONCURRENCY_LIMIT_DEFAULT_INITIAL, aws_http_concurrency_limiter_get_limit(&limiter));
+    ASSERT_UINT_EQUALS(1, limiter.min_limit);
+    ASSERT_UINT_EQUALS(100, limiter.max_limit);
+    ASSERT_FALSE(limiter.fail_fast);
+
+    /* Initial limit is clamped to the manager's max */
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 5));
+    ASSERT_UINT_EQUALS(5, aws_http_concurrency_limiter_get_limit(&limiter));
+
+    /* And to the min */
+    options.initial_limit = 2;
+    options.min_limit = 4;
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+    ASSERT_UINT_EQUALS(4, aws_http_concurrency_limiter_get_limit(&limiter));
+
+    /* Invalid options */
+    options.max_limit = 3;
+    ASSERT_FAILS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+
+    struct aws_http_concurrency_limit_options bad_smoothing = {.smoothing = 1.5};
+    ASSERT_FAILS(aws_http_concurrency_limiter_init(&limiter, &bad_smoothing, 100));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+
+    struct aws_http_concurrency_limit_options bad_tolerance = {.rtt_tolerance = 0.5};
+    ASSERT_FAILS(aws_http_concurrency_limiter_init(&limiter, &bad_tolerance, 100));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(concurrency_limiter_init_test, s_concurrency_limiter_init_test_fn)
+
+/* While latency stays at the baseline and the limit is in use, the limit grows up to the max */
+static int s_concurrency_limiter_grows_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_concurrency_limiter limiter;
+    struct aws_http_concurrency_limit_options options = {.initial_limit = 10, .max_limit = 50};
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+
+    size_t previous = aws_http_concurrency_limiter_get_limit(&limiter);
+    for (int i = 0; i < 20; ++i) {
+        size_t limit = aws_http_concurrency_limiter_get_limit(&limiter);
+        aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(10), limit, false);
+        ASSERT_TRUE(aws_http_concurrency_limiter_get_limit(&limiter) >= previous);
+        previous = aws_http_concurrency_limiter_get_limit(&limiter);
+    }
+    ASSERT_TRUE(previous > 10);
+
+    for (int i = 0; i < 1000; ++i) {
+        aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(10), 50, false);
+    }
+    ASSERT_UINT_EQUALS(50, aws_http_concurrency_limiter_get_limit(&limiter));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(concurrency_limiter_grows_test, s_concurrency_limiter_grows_test_fn)
+
+/* Latency within the tolerance doesn't shrink the limit, but latency past it does, down to the min */
+static int s_concurrency_limiter_shrinks_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_concurrency_limiter limiter;
+    struct aws_http_concurrency_limit_options options = {.initial_limit = 40, .min_limit = 5};
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+
+    /* Establish the baseline, then double it, which is within the default tolerance */
+    aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(10), 40, false);
+    size_t limit = aws_http_concurrency_limiter_get_limit(&limiter);
+    aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(20), limit, false);
+    ASSERT_TRUE(aws_http_concurrency_limiter_get_limit(&limiter) >= limit);
+
+    /* 10x the baseline, the origin is queueing */
+    for (int i = 0; i < 10; ++i) {
+        limit = aws_http_concurrency_limiter_get_limit(&limiter);
+        aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(100), limit, false);
+        ASSERT_TRUE(aws_http_concurrency_limiter_get_limit(&limiter) < limit);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(1000), 40, false);
+    }
+    ASSERT_UINT_EQUALS(5, aws_http_concurrency_limiter_get_limit(&limiter));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(concurrency_limiter_shrinks_test, s_concurrency_limiter_shrinks_test_fn)
+
+/* Failures back off, and an application that isn't using the limit can't grow it */
+static int s_concurrency_limiter_drops_and_app_limited_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_http_concurrency_limiter limiter;
+    struct aws_http_concurrency_limit_options options = {.initial_limit = 20};
+    ASSERT_SUCCESS(aws_http_concurrency_limiter_init(&limiter, &options, 100));
+
+    aws_http_concurrency_limiter_on_sample(&limiter, 0, 20, true);
+    ASSERT_UINT_EQUALS(18, aws_http_concurrency_limiter_get_limit(&limiter));
+
+    /* Only 2 of 18 in use */
+    for (int i = 0; i < 100; ++i) {
+        aws_http_concurrency_limiter_on_sample(&limiter, MS_TO_NS(10), 2, false);
+    }
+    ASSERT_UINT_EQUALS(18, aws_http_concurrency_limiter_get_limit(&limiter));
+
+    /* Backs off all the way to the min */
+    for (int i = 0; i < 100; ++i) {
+        aws_http_concurrency_limiter_on_sample(&limiter, 0, 18, true);
+    }
+    ASSERT_UINT_EQUALS(1, aws_http_concurrency_limiter_get_limit(&limiter));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(concurrency_limiter_drops_and_app_limited_test, s_concurrency_limiter_drops_and_app_limited_test_fn)
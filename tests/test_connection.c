@@ -4,8 +4,10 @@
  */
 
 #include <aws/http/connection.h>
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/connection_impl.h>
 #include <aws/http/proxy.h>
+#include <aws/http/request_response.h>
 #include <aws/http/server.h>
 
 #include <aws/common/clock.h>
@@ -45,6 +47,9 @@ struct tester_options {
     bool no_connection; /* don't connect server to client */
     bool pin_event_loop;
     bool use_tcp; /* otherwise uses domain sockets */
+    bool server_manual_window_management;
+    struct aws_http_memory_budget *server_memory_budget;
+    const struct aws_http2_abuse_limits *server_abuse_limits;
 };
 
 /* Singleton used by tests in this file */
@@ -80,6 +85,15 @@ struct tester {
 
     enum aws_http_version connection_version;
 
+    /* Set by client requests' on_complete callback */
+    int client_stream_complete_num;
+    int wait_client_stream_complete_num;
+    int client_stream_error_code;
+
+    /* Set by the client's HTTP/2 on_goaway_received callback */
+    bool goaway_received;
+    uint32_t goaway_error_code;
+
     /* Tls context */
     struct aws_tls_ctx_options server_ctx_options;
     struct aws_tls_ctx_options client_ctx_options;
@@ -363,6 +377,9 @@ static int s_tester_init(struct tester *tester, const struct tester_options *opt
     server_options.server_user_data = tester;
     server_options.on_incoming_connection = s_tester_on_server_connection_setup;
     server_options.on_destroy_complete = s_tester_http_server_on_destroy;
+    server_options.manual_window_management = options->server_manual_window_management;
+    server_options.memory_budget = options->server_memory_budget;
+    server_options.abuse_limits = options->server_abuse_limits;
     if (options->tls) {
         ASSERT_SUCCESS(s_tls_server_opt_tester_init(
             tester, options->server_alpn_list ? options->server_alpn_list : "h2;http/1.1"));
@@ -601,6 +618,252 @@ static int s_test_connection_h2_prior_knowledge(struct aws_allocator *allocator,
 }
 AWS_TEST_CASE(connection_h2_prior_knowledge, s_test_connection_h2_prior_knowledge);
 
+/* The server hands its memory budget to every incoming connection, HTTP/1 and HTTP/2 alike */
+static int s_test_connection_server_memory_budget(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = 1024 * 1024,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
+
+    struct tester_options options = {
+        .alloc = allocator,
+        .no_connection = true,
+        .server_manual_window_management = true,
+        .server_memory_budget = budget,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, &options));
+
+    /* The server holds its own reference */
+    aws_http_memory_budget_release(budget);
+
+    /* Connect over HTTP/1.1, then HTTP/2 */
+    struct aws_http_client_connection_options client_options = AWS_HTTP_CLIENT_CONNECTION_OPTIONS_INIT;
+    s_client_connection_options_init_tester(&client_options, &tester);
+    tester.client_options = client_options;
+
+    tester.server_connection_num = 0;
+    tester.client_connection_num = 0;
+    ASSERT_SUCCESS(aws_http_client_connect(&tester.client_options));
+    tester.wait_client_connection_num = 1;
+    tester.wait_server_connection_num = 1;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_setup_pred));
+
+    tester.client_options.prior_knowledge_http2 = true;
+    ASSERT_SUCCESS(aws_http_client_connect(&tester.client_options));
+    tester.wait_client_connection_num = 2;
+    tester.wait_server_connection_num = 2;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_setup_pred));
+
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_1_1, aws_http_connection_get_version(tester.server_connections[0]));
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_2, aws_http_connection_get_version(tester.server_connections[1]));
+    ASSERT_PTR_EQUALS(budget, tester.server_connections[0]->memory_budget);
+    ASSERT_PTR_EQUALS(budget, tester.server_connections[1]->memory_budget);
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+
+    /* clean up */
+    release_all_client_connections(&tester);
+    release_all_server_connections(&tester);
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_shutdown_pred));
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(connection_server_memory_budget, s_test_connection_server_memory_budget);
+
+static void s_tester_on_client_stream_complete(struct aws_http_stream *stream, int error_code, void *user_data) {
+    (void)stream;
+    struct tester *tester = user_data;
+    AWS_FATAL_ASSERT(aws_mutex_lock(&tester->wait_lock) == AWS_OP_SUCCESS);
+    tester->client_stream_complete_num++;
+    tester->client_stream_error_code = error_code;
+    AWS_FATAL_ASSERT(aws_mutex_unlock(&tester->wait_lock) == AWS_OP_SUCCESS);
+    aws_condition_variable_notify_one(&tester->wait_cvar);
+}
+
+static bool s_tester_client_stream_complete_pred(void *user_data) {
+    struct tester *tester = user_data;
+    return tester->client_stream_complete_num == tester->wait_client_stream_complete_num;
+}
+
+/* Make a GET request on a client connection, and wait for it to complete */
+static int s_tester_make_request_and_wait(struct tester *tester, struct aws_http_connection *client_connection) {
+    struct aws_http_message *request = aws_http_message_new_request(tester->alloc);
+    ASSERT_NOT_NULL(request);
+    ASSERT_SUCCESS(aws_http_message_set_request_method(request, aws_http_method_get));
+    ASSERT_SUCCESS(aws_http_message_set_request_path(request, aws_byte_cursor_from_c_str("/")));
+    struct aws_http_header host = {
+        .name = aws_byte_cursor_from_c_str("Host"),
+        .value = aws_byte_cursor_from_c_str("localhost"),
+    };
+    ASSERT_SUCCESS(aws_http_message_add_header(request, host));
+
+    struct aws_http_make_request_options options = {
+        .self_size = sizeof(options),
+        .request = request,
+        .user_data = tester,
+        .on_complete = s_tester_on_client_stream_complete,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(client_connection, &options);
+    ASSERT_NOT_NULL(stream);
+    tester->wait_client_stream_complete_num++;
+    ASSERT_SUCCESS(aws_http_stream_activate(stream));
+    ASSERT_SUCCESS(s_tester_wait(tester, s_tester_client_stream_complete_pred));
+
+    if (aws_http_connection_get_version(client_connection) == AWS_HTTP_VERSION_2) {
+        uint32_t reset_error_code = 0;
+        ASSERT_SUCCESS(aws_http2_stream_get_received_reset_error_code(stream, &reset_error_code));
+        ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_REFUSED_STREAM, reset_error_code);
+    }
+
+    aws_http_stream_release(stream);
+    aws_http_message_release(request);
+    return AWS_OP_SUCCESS;
+}
+
+/* While the server's memory budget is exhausted, incoming connections refuse new streams */
+static int s_test_connection_server_memory_budget_refuses_streams(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = 1024 * 1024,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
+
+    struct tester_options options = {
+        .alloc = allocator,
+        .no_connection = true,
+        .server_manual_window_management = true,
+        .server_memory_budget = budget,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, &options));
+
+    /* Connect over HTTP/2, then HTTP/1.1 */
+    struct aws_http_client_connection_options client_options = AWS_HTTP_CLIENT_CONNECTION_OPTIONS_INIT;
+    s_client_connection_options_init_tester(&client_options, &tester);
+    client_options.prior_knowledge_http2 = true;
+    tester.client_options = client_options;
+
+    tester.server_connection_num = 0;
+    tester.client_connection_num = 0;
+    ASSERT_SUCCESS(aws_http_client_connect(&tester.client_options));
+    tester.wait_client_connection_num = 1;
+    tester.wait_server_connection_num = 1;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_setup_pred));
+
+    tester.client_options.prior_knowledge_http2 = false;
+    ASSERT_SUCCESS(aws_http_client_connect(&tester.client_options));
+    tester.wait_client_connection_num = 2;
+    tester.wait_server_connection_num = 2;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_setup_pred));
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_2, aws_http_connection_get_version(tester.client_connections[0]));
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_1_1, aws_http_connection_get_version(tester.client_connections[1]));
+
+    /* Something else uses up the whole budget. The connections' windows are already open. */
+    size_t exhausting_bytes = aws_http_memory_budget_reserve(budget, SIZE_MAX);
+    ASSERT_TRUE(aws_http_memory_budget_is_exhausted(budget));
+
+    /* HTTP/2 refuses just the stream, and the connection stays open */
+    ASSERT_SUCCESS(s_tester_make_request_and_wait(&tester, tester.client_connections[0]));
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_RST_STREAM_RECEIVED, tester.client_stream_error_code);
+    ASSERT_TRUE(aws_http_connection_is_open(tester.client_connections[0]));
+
+    /* HTTP/1 closes the connection instead */
+    ASSERT_SUCCESS(s_tester_make_request_and_wait(&tester, tester.client_connections[1]));
+    ASSERT_TRUE(tester.client_stream_error_code != AWS_ERROR_SUCCESS);
+    tester.wait_client_connection_is_shutdown = 1;
+    tester.wait_server_connection_is_shutdown = 1;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_shutdown_pred));
+    ASSERT_TRUE(aws_http_connection_is_open(tester.client_connections[0]));
+
+    aws_http_memory_budget_unreserve(budget, exhausting_bytes);
+
+    /* clean up */
+    release_all_client_connections(&tester);
+    release_all_server_connections(&tester);
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_shutdown_pred));
+
+    aws_http_memory_budget_release(budget);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(connection_server_memory_budget_refuses_streams, s_test_connection_server_memory_budget_refuses_streams);
+
+static void s_tester_on_client_goaway_received(
+    struct aws_http_connection *http2_connection,
+    uint32_t last_stream_id,
+    uint32_t http2_error_code,
+    struct aws_byte_cursor debug_data,
+    void *user_data) {
+
+    (void)http2_connection;
+    (void)last_stream_id;
+    (void)debug_data;
+    struct tester *tester = user_data;
+    AWS_FATAL_ASSERT(aws_mutex_lock(&tester->wait_lock) == AWS_OP_SUCCESS);
+    tester->goaway_received = true;
+    tester->goaway_error_code = http2_error_code;
+    AWS_FATAL_ASSERT(aws_mutex_unlock(&tester->wait_lock) == AWS_OP_SUCCESS);
+}
+
+/* The server's abuse limits apply to every incoming HTTP/2 connection, instead of the defaults */
+static int s_test_connection_server_abuse_limits(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_ping_frames = 2;
+
+    struct tester_options options = {
+        .alloc = allocator,
+        .no_connection = true,
+        .server_abuse_limits = &abuse_limits,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, &options));
+
+    /* The server copied the limits */
+    abuse_limits.max_ping_frames = 0;
+
+    struct aws_http2_connection_options http2_options = {
+        .on_goaway_received = s_tester_on_client_goaway_received,
+    };
+    struct aws_http_client_connection_options client_options = AWS_HTTP_CLIENT_CONNECTION_OPTIONS_INIT;
+    s_client_connection_options_init_tester(&client_options, &tester);
+    client_options.prior_knowledge_http2 = true;
+    client_options.http2_options = &http2_options;
+    tester.client_options = client_options;
+
+    tester.server_connection_num = 0;
+    tester.client_connection_num = 0;
+    ASSERT_SUCCESS(aws_http_client_connect(&tester.client_options));
+    tester.wait_client_connection_num = 1;
+    tester.wait_server_connection_num = 1;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_setup_pred));
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_2, tester.connection_version);
+
+    /* One PING more than the server allows, far fewer than the default limit */
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_SUCCESS(aws_http2_connection_ping(tester.client_connections[0], NULL, NULL, NULL));
+    }
+
+    /* The server sends GOAWAY(ENHANCE_YOUR_CALM) and closes, so both sides shut down */
+    tester.wait_client_connection_is_shutdown = 1;
+    tester.wait_server_connection_is_shutdown = 1;
+    ASSERT_SUCCESS(s_tester_wait(&tester, s_tester_connection_shutdown_pred));
+    ASSERT_TRUE(tester.goaway_received);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_ENHANCE_YOUR_CALM, tester.goaway_error_code);
+
+    /* clean up */
+    release_all_client_connections(&tester);
+    release_all_server_connections(&tester);
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(connection_server_abuse_limits, s_test_connection_server_abuse_limits);
+
 static int s_test_connection_h2_prior_knowledge_not_work_with_tls(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
     struct tester_options options = {
@@ -630,6 +893,35 @@ static int s_test_connection_h2_prior_knowledge_not_work_with_tls(struct aws_all
 }
 AWS_TEST_CASE(connection_h2_prior_knowledge_not_work_with_tls, s_test_connection_h2_prior_knowledge_not_work_with_tls);
 
+static int s_test_connection_h2c_upgrade_not_work_with_tls(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct tester_options options = {
+        .alloc = allocator,
+        .no_connection = true,
+        .tls = true,
+        .server_alpn_list = "http/1.1",
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, &options));
+
+    /* Connect with h2c upgrade */
+    struct aws_http_client_connection_options client_options = AWS_HTTP_CLIENT_CONNECTION_OPTIONS_INIT;
+    s_client_connection_options_init_tester(&client_options, &tester);
+    ASSERT_SUCCESS(s_tls_client_opt_tester_init(&tester, "http/1.1", aws_byte_cursor_from_c_str("localhost")));
+    client_options.tls_options = &tester.client_tls_connection_options;
+    client_options.http2_cleartext_upgrade = true;
+    tester.client_options = client_options;
+
+    tester.server_connection_num = 0;
+    tester.client_connection_num = 0;
+    /* h2c upgrade only works with cleartext TCP */
+    ASSERT_FAILS(aws_http_client_connect(&tester.client_options));
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(connection_h2c_upgrade_not_work_with_tls, s_test_connection_h2c_upgrade_not_work_with_tls);
+
 static void s_on_tester_negotiation_result(
     struct aws_channel_handler *handler,
     struct aws_channel_slot *slot,
@@ -16,6 +16,7 @@
 #include <aws/common/uuid.h>
 #include <aws/http/connection.h>
 #include <aws/http/connection_manager.h>
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/connection_manager_system_vtable.h>
 #include <aws/http/proxy.h>
 #include <aws/http/server.h>
@@ -60,6 +61,10 @@ struct cm_tester_options {
     bool self_lib_init;
     const struct aws_byte_cursor *verify_network_interface_names_array;
     size_t num_network_interface_names;
+    const struct aws_http_connection_manager_circuit_breaker_options *circuit_breaker_options;
+    const struct aws_http_concurrency_limit_options *concurrency_limit_options;
+    bool http2_cleartext_upgrade;
+    struct aws_http_memory_budget *memory_budget;
 };
 
 struct cm_tester {
@@ -83,6 +88,7 @@ struct cm_tester {
 
     struct aws_array_list connections;
     size_t connection_errors;
+    int last_error_code;
     size_t connection_releases;
 
     size_t wait_for_connection_count;
@@ -101,6 +107,14 @@ struct cm_tester {
     bool proxy_request_complete;
     bool proxy_request_successful;
     bool self_lib_init;
+
+    /* how many connection attempts asked for an h2c upgrade, or used HTTP/2 prior knowledge */
+    size_t h2c_upgrade_attempt_count;
+    size_t prior_knowledge_attempt_count;
+
+    /* how many connection attempts were given the manager's memory budget, for both HTTP/1 and HTTP/2 */
+    struct aws_http_memory_budget *verify_memory_budget;
+    size_t memory_budget_attempt_count;
 };
 
 static struct cm_tester s_tester;
@@ -225,6 +239,10 @@ static int s_cm_tester_init(struct cm_tester_options *options) {
         .num_initial_settings = options->num_initial_settings,
         .network_interface_names_array = options->verify_network_interface_names_array,
         .num_network_interface_names = options->num_network_interface_names,
+        .circuit_breaker_options = options->circuit_breaker_options,
+        .concurrency_limit_options = options->concurrency_limit_options,
+        .http2_cleartext_upgrade = options->http2_cleartext_upgrade,
+        .memory_budget = options->memory_budget,
     };
 
     if (options->mock_table) {
@@ -240,6 +258,7 @@ static int s_cm_tester_init(struct cm_tester_options *options) {
     }
 
     tester->mock_table = options->mock_table;
+    tester->verify_memory_budget = options->memory_budget;
     tester->verify_network_interface_names_array = options->verify_network_interface_names_array;
     tester->num_network_interface_names = options->num_network_interface_names;
 
@@ -335,7 +354,6 @@ release:
 }
 
 static void s_on_acquire_connection(struct aws_http_connection *connection, int error_code, void *user_data) {
-    (void)error_code;
     (void)user_data;
 
     struct cm_tester *tester = &s_tester;
@@ -344,6 +362,7 @@ static void s_on_acquire_connection(struct aws_http_connection *connection, int
 
     if (connection == NULL) {
         ++tester->connection_errors;
+        tester->last_error_code = error_code;
     } else {
         aws_array_list_push_back(&tester->connections, &connection);
     }
@@ -748,6 +767,12 @@ static int s_aws_http_connection_manager_create_connection_sync_mock(
 
     ASSERT_SUCCESS(aws_mutex_lock(&tester->lock));
     tester->release_connection_fn = options->on_shutdown;
+    tester->h2c_upgrade_attempt_count += options->http2_cleartext_upgrade ? 1 : 0;
+    tester->prior_knowledge_attempt_count += options->prior_knowledge_http2 ? 1 : 0;
+    if (tester->verify_memory_budget && options->http1_options->memory_budget == tester->verify_memory_budget &&
+        options->http2_options->memory_budget == tester->verify_memory_budget) {
+        tester->memory_budget_attempt_count++;
+    }
     ASSERT_SUCCESS(aws_mutex_unlock(&tester->lock));
 
     /* Verify that any proxy options have been propagated to the connection attempt */
@@ -908,6 +933,78 @@ AWS_TEST_CASE(
     test_connection_manager_acquire_release_mix_synchronous,
     s_test_connection_manager_acquire_release_mix_synchronous);
 
+static int s_test_connection_manager_h2c_upgrade_remembers_version(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 5,
+        .mock_table = &s_synchronous_mocks,
+        .http2_cleartext_upgrade = true,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+    s_add_mock_connections(3, AWS_NCRT_SUCCESS, false);
+
+    /* The first connection asks the host to upgrade, and the mock host declines by staying HTTP/1.1 */
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(1));
+    ASSERT_UINT_EQUALS(1, s_tester.h2c_upgrade_attempt_count);
+
+    /* Further connections to the host don't ask again */
+    s_acquire_connections(2);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    ASSERT_UINT_EQUALS(1, s_tester.h2c_upgrade_attempt_count);
+    ASSERT_UINT_EQUALS(0, s_tester.prior_knowledge_attempt_count);
+
+    ASSERT_SUCCESS(s_release_connections(3, false));
+    ASSERT_UINT_EQUALS(0, s_tester.connection_errors);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(
+    test_connection_manager_h2c_upgrade_remembers_version,
+    s_test_connection_manager_h2c_upgrade_remembers_version);
+
+/* Every connection the manager makes shares its memory budget, which it keeps alive on its own */
+static int s_test_connection_manager_memory_budget(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = 1024,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 5,
+        .mock_table = &s_synchronous_mocks,
+        .memory_budget = budget,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+
+    /* The manager holds its own reference */
+    aws_http_memory_budget_release(budget);
+
+    s_add_mock_connections(2, AWS_NCRT_SUCCESS, false);
+    s_acquire_connections(2);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(2));
+    ASSERT_UINT_EQUALS(2, s_tester.memory_budget_attempt_count);
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+
+    ASSERT_SUCCESS(s_release_connections(2, false));
+    ASSERT_UINT_EQUALS(0, s_tester.connection_errors);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(test_connection_manager_memory_budget, s_test_connection_manager_memory_budget);
+
 static int s_test_connection_manager_connect_callback_failure(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
 
@@ -958,6 +1055,146 @@ static int s_test_connection_manager_connect_immediate_failure(struct aws_alloca
 }
 AWS_TEST_CASE(test_connection_manager_connect_immediate_failure, s_test_connection_manager_connect_immediate_failure);
 
+static void s_acquire_tenant_connections(const char *tenant_id, size_t count) {
+    struct cm_tester *tester = &s_tester;
+
+    for (size_t i = 0; i < count; ++i) {
+        aws_http_connection_manager_acquire_connection_for_tenant(
+            tester->connection_manager, aws_byte_cursor_from_c_str(tenant_id), s_on_acquire_connection, tester);
+    }
+}
+
+static int s_set_tenant_options(const char *tenant_id, uint32_t weight, size_t max_leased_connections) {
+    struct aws_http_connection_manager_tenant_options tenant_options = {
+        .weight = weight,
+        .max_leased_connections = max_leased_connections,
+    };
+    return aws_http_connection_manager_set_tenant_options(
+        s_tester.connection_manager, aws_byte_cursor_from_c_str(tenant_id), &tenant_options);
+}
+
+/* A tenant at its cap waits, while other tenants are still served. Raising the cap takes effect immediately. */
+static int s_test_connection_manager_tenant_cap(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 2,
+        .mock_table = &s_synchronous_mocks,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+
+    s_add_mock_connections(2, AWS_NCRT_SUCCESS, false);
+
+    /* The default tenant can't be configured */
+    ASSERT_FAILS(s_set_tenant_options("", 1, 1));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+
+    ASSERT_SUCCESS(s_set_tenant_options("a", 1, 1));
+    s_acquire_tenant_connections("a", 3);
+    s_acquire_tenant_connections("b", 1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(2));
+
+    struct aws_http_manager_metrics metrics;
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(2, metrics.leased_concurrency);
+    ASSERT_UINT_EQUALS(2, metrics.pending_concurrency_acquires);
+
+    /* b's connection goes idle rather than to "a", which is still at its cap */
+    ASSERT_SUCCESS(s_release_connections(1, false));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(1, metrics.available_concurrency);
+    ASSERT_UINT_EQUALS(2, metrics.pending_concurrency_acquires);
+
+    ASSERT_SUCCESS(s_set_tenant_options("a", 1, 3));
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(2, metrics.leased_concurrency);
+    ASSERT_UINT_EQUALS(1, metrics.pending_concurrency_acquires);
+
+    ASSERT_SUCCESS(s_release_connections(1, false));
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(0, metrics.pending_concurrency_acquires);
+
+    ASSERT_TRUE(s_tester.connection_errors == 0);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(test_connection_manager_tenant_cap, s_test_connection_manager_tenant_cap);
+
+struct tenant_order_tester {
+    char served[8];
+    size_t served_count;
+};
+
+static struct tenant_order_tester s_tenant_order;
+
+static void s_on_acquire_tenant_connection(struct aws_http_connection *connection, int error_code, void *user_data) {
+    const char *tenant_id = user_data;
+
+    AWS_FATAL_ASSERT(aws_mutex_lock(&s_tester.lock) == AWS_OP_SUCCESS);
+    if (connection && s_tenant_order.served_count < AWS_ARRAY_SIZE(s_tenant_order.served)) {
+        s_tenant_order.served[s_tenant_order.served_count++] = tenant_id[0];
+    }
+    AWS_FATAL_ASSERT(aws_mutex_unlock(&s_tester.lock) == AWS_OP_SUCCESS);
+
+    s_on_acquire_connection(connection, error_code, &s_tester);
+}
+
+/* Waiting tenants are served in proportion to their weights, not in the order they asked */
+static int s_test_connection_manager_tenant_weighted_fairness(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 1,
+        .mock_table = &s_synchronous_mocks,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+    AWS_ZERO_STRUCT(s_tenant_order);
+
+    s_add_mock_connections(1, AWS_NCRT_SUCCESS, false);
+
+    /* Hold the only connection while the tenants queue up */
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(1));
+
+    ASSERT_SUCCESS(s_set_tenant_options("a", 1, 0));
+    ASSERT_SUCCESS(s_set_tenant_options("b", 3, 0));
+    for (size_t i = 0; i < 4; ++i) {
+        aws_http_connection_manager_acquire_connection_for_tenant(
+            s_tester.connection_manager, aws_byte_cursor_from_c_str("a"), s_on_acquire_tenant_connection, "a");
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        aws_http_connection_manager_acquire_connection_for_tenant(
+            s_tester.connection_manager, aws_byte_cursor_from_c_str("b"), s_on_acquire_tenant_connection, "b");
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_SUCCESS(s_release_connections(1, false));
+        ASSERT_SUCCESS(s_wait_on_connection_reply_count(i + 2));
+    }
+
+    ASSERT_UINT_EQUALS(8, s_tenant_order.served_count);
+    size_t a_count = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        a_count += s_tenant_order.served[i] == 'a';
+    }
+    ASSERT_UINT_EQUALS(1, a_count);
+
+    ASSERT_TRUE(s_tester.connection_errors == 0);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(test_connection_manager_tenant_weighted_fairness, s_test_connection_manager_tenant_weighted_fairness);
+
 static int s_test_connection_manager_proxy_setup_shutdown(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
 
@@ -1246,6 +1483,172 @@ static int s_test_connection_manager_idle_culling_refcount(struct aws_allocator
 
 AWS_TEST_CASE(test_connection_manager_idle_culling_refcount, s_test_connection_manager_idle_culling_refcount);
 
+static int s_test_connection_manager_circuit_breaker(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_connection_manager_circuit_breaker_options breaker_options = {
+        .failure_threshold = 2,
+        .open_timeout_ms = 1000,
+    };
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 5,
+        .mock_table = &s_idle_mocks,
+        .starting_mock_time = 0,
+        .circuit_breaker_options = &breaker_options,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+
+    s_add_mock_connections(2, AWS_NCRT_ERROR_VIA_CALLBACK, false);
+    s_add_mock_connections(1, AWS_NCRT_SUCCESS, false);
+
+    struct aws_http_manager_metrics metrics;
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_CLOSED, metrics.circuit_breaker_state);
+
+    /* Consecutive failures open the breaker */
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(1));
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(2));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_OPEN, metrics.circuit_breaker_state);
+
+    /* While open, acquisitions fail without a connection attempt */
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    ASSERT_UINT_EQUALS(3, s_tester.connection_errors);
+    ASSERT_UINT_EQUALS(2, aws_atomic_load_int(&s_tester.next_connection_id));
+
+    /* After the timeout, a probe goes through, and its success closes the breaker */
+    uint64_t one_sec_in_nanos = aws_timestamp_convert(1, AWS_TIMESTAMP_SECS, AWS_TIMESTAMP_NANOS, NULL);
+    s_tester_set_mock_time(one_sec_in_nanos);
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_HALF_OPEN, metrics.circuit_breaker_state);
+
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(4));
+    ASSERT_UINT_EQUALS(3, s_tester.connection_errors);
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_INT_EQUALS(AWS_HTTP_CIRCUIT_BREAKER_CLOSED, metrics.circuit_breaker_state);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(test_connection_manager_circuit_breaker, s_test_connection_manager_circuit_breaker);
+
+static int s_test_connection_manager_concurrency_limit(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    /* Full smoothing, so each sample sets the limit outright */
+    struct aws_http_concurrency_limit_options limit_options = {
+        .initial_limit = 2,
+        .max_limit = 4,
+        .smoothing = 1.0,
+    };
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 4,
+        .mock_table = &s_idle_mocks,
+        .starting_mock_time = 0,
+        .concurrency_limit_options = &limit_options,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+
+    s_add_mock_connections(4, AWS_NCRT_SUCCESS, false);
+
+    /* The third acquisition waits for the limit, and no connection is made for it */
+    s_acquire_connections(3);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(2));
+    ASSERT_UINT_EQUALS(2, aws_atomic_load_int(&s_tester.next_connection_id));
+
+    struct aws_http_manager_metrics metrics;
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(2, metrics.concurrency_limit);
+    ASSERT_UINT_EQUALS(2, metrics.leased_concurrency);
+    ASSERT_UINT_EQUALS(1, metrics.pending_concurrency_acquires);
+
+    /* The first lease sets the no-load baseline, so the limit grows by its queue allowance, sqrt(2) rounded down.
+     * The released connection goes to the waiting acquisition. */
+    uint64_t one_ms_in_nanos = aws_timestamp_convert(1, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL);
+    s_tester_set_mock_time(one_ms_in_nanos);
+    ASSERT_SUCCESS(s_release_connections(1, false));
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(3, metrics.concurrency_limit);
+    ASSERT_UINT_EQUALS(2, metrics.leased_concurrency);
+    ASSERT_UINT_EQUALS(0, metrics.pending_concurrency_acquires);
+    ASSERT_UINT_EQUALS(2, aws_atomic_load_int(&s_tester.next_connection_id));
+
+    /* Leases 100 times the baseline halve the limit, plus the queue allowance: 3 -> 2.5 -> 2.25 */
+    s_tester_set_mock_time(101 * one_ms_in_nanos);
+    ASSERT_SUCCESS(s_release_connections(2, false));
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(2, metrics.concurrency_limit);
+    ASSERT_UINT_EQUALS(0, metrics.leased_concurrency);
+    ASSERT_UINT_EQUALS(0, s_tester.connection_errors);
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(test_connection_manager_concurrency_limit, s_test_connection_manager_concurrency_limit);
+
+static int s_test_connection_manager_concurrency_limit_fail_fast(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_concurrency_limit_options limit_options = {
+        .initial_limit = 1,
+        .max_limit = 1,
+        .fail_fast = true,
+    };
+
+    struct cm_tester_options options = {
+        .allocator = allocator,
+        .max_connections = 2,
+        .mock_table = &s_idle_mocks,
+        .starting_mock_time = 0,
+        .concurrency_limit_options = &limit_options,
+    };
+
+    ASSERT_SUCCESS(s_cm_tester_init(&options));
+
+    s_add_mock_connections(2, AWS_NCRT_SUCCESS, false);
+
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(1));
+
+    /* At the limit, an acquisition fails instead of queueing, without a connection attempt */
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(2));
+    ASSERT_UINT_EQUALS(1, s_tester.connection_errors);
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED, s_tester.last_error_code);
+    ASSERT_UINT_EQUALS(1, aws_atomic_load_int(&s_tester.next_connection_id));
+
+    struct aws_http_manager_metrics metrics;
+    aws_http_connection_manager_fetch_metrics(s_tester.connection_manager, &metrics);
+    ASSERT_UINT_EQUALS(0, metrics.pending_concurrency_acquires);
+
+    /* Once the lease ends there's room again, and the idle connection is reused */
+    ASSERT_SUCCESS(s_release_connections(1, false));
+    s_acquire_connections(1);
+    ASSERT_SUCCESS(s_wait_on_connection_reply_count(3));
+    ASSERT_UINT_EQUALS(1, s_tester.connection_errors);
+    ASSERT_UINT_EQUALS(1, aws_atomic_load_int(&s_tester.next_connection_id));
+
+    ASSERT_SUCCESS(s_cm_tester_clean_up());
+
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(
+    test_connection_manager_concurrency_limit_fail_fast,
+    s_test_connection_manager_concurrency_limit_fail_fast);
+
 /**
  * Proxy integration tests. Maybe we should move this to another file. But let's do it later. Someday.
  * AWS_TEST_HTTP_PROXY_HOST - host address of the proxy to use for tests that make open connections to the proxy
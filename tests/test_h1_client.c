@@ -5,8 +5,11 @@
 
 #include "stream_test_helper.h"
 #include <aws/common/uuid.h>
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/h1_connection.h>
+#include <aws/http/rate_limiter.h>
 #include <aws/http/request_response.h>
+#include <aws/http/statistics.h>
 #include <aws/http/status_code.h>
 #include <aws/io/logging.h>
 #include <aws/io/stream.h>
@@ -94,6 +97,10 @@ struct tester_options {
     bool manual_window_management;
     size_t initial_stream_window_size;
     size_t read_buffer_capacity;
+    struct aws_http_memory_budget *memory_budget;
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
+    uint64_t idle_trim_ms;
 };
 
 static int s_tester_init_ex(struct tester *tester, struct aws_allocator *alloc, const struct tester_options *options) {
@@ -116,6 +123,10 @@ static int s_tester_init_ex(struct tester *tester, struct aws_allocator *alloc,
     struct aws_http1_connection_options http1_options;
     AWS_ZERO_STRUCT(http1_options);
     http1_options.read_buffer_capacity = options->read_buffer_capacity;
+    http1_options.memory_budget = options->memory_budget;
+    http1_options.send_rate_limiter = options->send_rate_limiter;
+    http1_options.receive_rate_limiter = options->receive_rate_limiter;
+    http1_options.idle_trim_ms = options->idle_trim_ms;
 
     tester->connection = aws_http_connection_new_http1_1_client(
         alloc, options->manual_window_management, options->initial_stream_window_size, &http1_options);
@@ -1951,6 +1962,58 @@ H1_CLIENT_TEST_CASE(h1_client_response_get_body) {
     return AWS_OP_SUCCESS;
 }
 
+/* Many small chunks arriving in one read should be delivered by a single vectored body callback */
+H1_CLIENT_TEST_CASE(h1_client_response_get_chunked_body_vectored) {
+    (void)ctx;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    /* send request */
+    struct aws_http_message *request = s_new_default_get_request(allocator);
+
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = tester.connection,
+        .use_vectored_body = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
+
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    aws_http_message_destroy(request);
+
+    /* send response */
+    ASSERT_SUCCESS(testing_channel_push_read_str(
+        &tester.testing_channel,
+        "HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "5\r\n"
+        "Call \r\n"
+        "2\r\n"
+        "Mo\r\n"
+        "2\r\n"
+        "mo\r\n"
+        "0\r\n"
+        "Momo: Call\r\n"
+        "\r\n"));
+
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    /* check result */
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_INT_EQUALS(200, stream_tester.response_status);
+    ASSERT_TRUE(aws_byte_buf_eq_c_str(&stream_tester.response_body, "Call Momo"));
+    ASSERT_UINT_EQUALS(1, stream_tester.num_body_callbacks);
+    ASSERT_UINT_EQUALS(1, aws_http_headers_count(stream_tester.response_trailer));
+
+    /* clean up */
+    client_stream_tester_clean_up(&stream_tester);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
 static int s_test_expected_no_body_response(struct aws_allocator *allocator, int status_int, bool head_request) {
 
     struct tester tester;
@@ -2360,6 +2423,76 @@ H1_CLIENT_TEST_CASE(h1_client_response_arrives_before_request_done_sending_is_ok
     return AWS_OP_SUCCESS;
 }
 
+/* A body using body-ready notifications should stop the outgoing stream task when it has no data,
+ * instead of being polled every tick */
+H1_CLIENT_TEST_CASE(h1_client_request_send_body_waits_for_body_ready_notification) {
+    (void)ctx;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    /* set up request whose body won't send immediately.
+     * It won't send data the first time it's read (along with the head), nor the second time (alone) */
+    struct slow_body_sender body_sender;
+    AWS_ZERO_STRUCT(body_sender);
+    s_slow_body_sender_init(&body_sender);
+    body_sender.delay_ticks = 2;
+    body_sender.bytes_per_tick = 0;
+    struct aws_input_stream *body_stream = &body_sender.base;
+
+    struct aws_http_header headers[] = {
+        {
+            .name = aws_byte_cursor_from_c_str("Content-Length"),
+            .value = aws_byte_cursor_from_c_str("16"),
+        },
+    };
+
+    struct aws_http_message *request = aws_http_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+    ASSERT_SUCCESS(aws_http_message_set_request_method(request, aws_byte_cursor_from_c_str("PUT")));
+    ASSERT_SUCCESS(aws_http_message_set_request_path(request, aws_byte_cursor_from_c_str("/plan.txt")));
+    ASSERT_SUCCESS(aws_http_message_add_header_array(request, headers, AWS_ARRAY_SIZE(headers)));
+    aws_http_message_set_body_stream(request, body_stream);
+
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = tester.connection,
+        .use_body_ready_notifications = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
+
+    /* Draining the task queue would never finish if the stalled body was polled every tick */
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    ASSERT_UINT_EQUALS(0, body_sender.delay_ticks);
+    ASSERT_UINT_EQUALS(16, body_sender.cursor.len);
+    ASSERT_SUCCESS(testing_channel_check_written_messages_str(
+        &tester.testing_channel,
+        allocator,
+        "PUT /plan.txt HTTP/1.1\r\n"
+        "Content-Length: 16\r\n"
+        "\r\n"));
+
+    /* Notify that body is ready, and the rest of the request should be sent */
+    ASSERT_SUCCESS(aws_http_stream_notify_body_ready(stream_tester.stream));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    ASSERT_SUCCESS(testing_channel_check_written_messages_str(&tester.testing_channel, allocator, "write more tests"));
+
+    /* send response */
+    ASSERT_SUCCESS(testing_channel_push_read_str(&tester.testing_channel, "HTTP/1.1 200 OK\r\n\r\n"));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_INT_EQUALS(200, stream_tester.response_status);
+
+    /* clean up */
+    aws_http_message_destroy(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_input_stream_release(body_stream);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
 /* It should be fine to receive a response before the request has finished sending */
 H1_CLIENT_TEST_CASE(h1_client_response_arrives_before_request_chunks_done_sending_is_ok) {
     (void)ctx;
@@ -3020,6 +3153,412 @@ H1_CLIENT_TEST_CASE(h1_client_connection_window_with_buffer) {
     return AWS_OP_SUCCESS;
 }
 
+/* The memory budget is only charged for unprocessed bytes in the read buffer, and the window never opens
+ * past the room left in the budget */
+H1_CLIENT_TEST_CASE(h1_client_connection_window_with_memory_budget) {
+    (void)ctx;
+
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = 100,
+        .retry_interval_ms = 1,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
+
+    /* Something else is using some of the budget */
+    ASSERT_UINT_EQUALS(40, aws_http_memory_budget_reserve(budget, 40));
+
+    /* The stream window only covers the response head, so the body sits in the read buffer until it's opened */
+    const char *response_head = "HTTP/1.1 200 OK\r\n"
+                                "Content-Length: 60\r\n"
+                                "\r\n";
+    struct tester_options tester_opts = {
+        .manual_window_management = true,
+        .initial_stream_window_size = strlen(response_head),
+        .read_buffer_capacity = 100,
+        .memory_budget = budget,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init_ex(&tester, allocator, &tester_opts));
+
+    /* Window only opens as far as the budget has room, but an open window isn't charged */
+    struct aws_h1_window_stats window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(60, window_stats.connection_window);
+    ASSERT_UINT_EQUALS(40, aws_http_memory_budget_get_reserved(budget));
+
+    /* Asking again doesn't open the window any further while it's still open */
+    aws_thread_current_sleep(aws_timestamp_convert(2, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(60, window_stats.connection_window);
+
+    /* Requests are fine while the budget has room */
+    struct aws_http_message *request = s_new_default_get_request(allocator);
+    struct client_stream_tester stream_tester;
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, &tester, request));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    /* The head is processed, the rest of the data is buffered and charged to the budget */
+    char body[60];
+    memset(body, 'b', sizeof(body));
+    struct aws_byte_buf first_read;
+    ASSERT_SUCCESS(aws_byte_buf_init(&first_read, allocator, 60));
+    ASSERT_TRUE(aws_byte_buf_write_from_whole_cursor(&first_read, aws_byte_cursor_from_c_str(response_head)));
+    ASSERT_TRUE(aws_byte_buf_write(&first_read, (const uint8_t *)body, 60 - strlen(response_head)));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&tester.testing_channel, aws_byte_cursor_from_buf(&first_read)));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    const size_t first_body_len = 60 - strlen(response_head);
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(first_body_len, window_stats.buffer_pending_bytes);
+    ASSERT_UINT_EQUALS(40 + first_body_len, aws_http_memory_budget_get_reserved(budget));
+    ASSERT_UINT_EQUALS(100 - (40 + first_body_len), window_stats.connection_window);
+
+    /* Filling the window exhausts the budget, so the window stays shut and new requests are refused */
+    ASSERT_SUCCESS(testing_channel_push_read_data(
+        &tester.testing_channel, aws_byte_cursor_from_array(body, window_stats.connection_window)));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(0, window_stats.connection_window);
+    ASSERT_UINT_EQUALS(60, window_stats.buffer_pending_bytes);
+    ASSERT_UINT_EQUALS(100, aws_http_memory_budget_get_reserved(budget));
+    ASSERT_TRUE(aws_http_memory_budget_is_exhausted(budget));
+
+    struct aws_http_make_request_options opt = {
+        .self_size = sizeof(opt),
+        .request = request,
+    };
+    ASSERT_NULL(aws_http_connection_make_request(tester.connection, &opt));
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED, aws_last_error());
+
+    /* Processing the buffered body returns it to the budget, and the window re-opens as far as there's room */
+    aws_http_stream_update_window(stream_tester.stream, 60);
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_SUCCESS(stream_tester.on_complete_error_code);
+    ASSERT_UINT_EQUALS(60, stream_tester.response_body.len);
+
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(0, window_stats.buffer_pending_bytes);
+    ASSERT_UINT_EQUALS(40, aws_http_memory_budget_get_reserved(budget));
+    ASSERT_UINT_EQUALS(60, window_stats.connection_window);
+
+    /* Once the rest of the budget frees up, the connection asks again and the window opens the rest of the way */
+    aws_http_memory_budget_unreserve(budget, 40);
+    aws_thread_current_sleep(aws_timestamp_convert(2, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(100, window_stats.connection_window);
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&first_read);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_message_release(request);
+    aws_http_memory_budget_release(budget);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
+/* With a send rate limiter, the request goes out no faster than the limiter allows */
+H1_CLIENT_TEST_CASE(h1_client_request_send_with_rate_limiter) {
+    (void)ctx;
+
+    /* 100 bytes every 10ms, never more than 100 at once */
+    struct aws_http_rate_limiter_options limiter_options = {
+        .bytes_per_second = 10000,
+        .burst_bytes = 100,
+    };
+    struct aws_http_rate_limiter *limiter = aws_http_rate_limiter_new(allocator, &limiter_options);
+    ASSERT_NOT_NULL(limiter);
+
+    struct tester_options tester_opts = {
+        .send_rate_limiter = limiter,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init_ex(&tester, allocator, &tester_opts));
+
+    char body_data[1000];
+    memset(body_data, 'z', sizeof(body_data));
+    struct aws_byte_cursor body = aws_byte_cursor_from_array(body_data, sizeof(body_data));
+    struct aws_input_stream *body_stream = aws_input_stream_new_from_cursor(allocator, &body);
+
+    struct aws_http_header headers[] = {
+        {
+            .name = aws_byte_cursor_from_c_str("Content-Length"),
+            .value = aws_byte_cursor_from_c_str("1000"),
+        },
+    };
+    struct aws_http_message *request = aws_http_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+    ASSERT_SUCCESS(aws_http_message_set_request_method(request, aws_byte_cursor_from_c_str("PUT")));
+    ASSERT_SUCCESS(aws_http_message_set_request_path(request, aws_byte_cursor_from_c_str("/paced.txt")));
+    ASSERT_SUCCESS(aws_http_message_add_header_array(request, headers, AWS_ARRAY_SIZE(headers)));
+    aws_http_message_set_body_stream(request, body_stream);
+
+    struct aws_http_make_request_options opt = {
+        .self_size = sizeof(opt),
+        .request = request,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(tester.connection, &opt);
+    ASSERT_NOT_NULL(stream);
+    ASSERT_SUCCESS(aws_http_stream_activate(stream));
+
+    const char *expected_head = "PUT /paced.txt HTTP/1.1\r\n"
+                                "Content-Length: 1000\r\n"
+                                "\r\n";
+    struct aws_byte_buf expected;
+    ASSERT_SUCCESS(aws_byte_buf_init(&expected, allocator, strlen(expected_head) + body.len));
+    ASSERT_TRUE(aws_byte_buf_write_from_whole_cursor(&expected, aws_byte_cursor_from_c_str(expected_head)));
+    ASSERT_TRUE(aws_byte_buf_write_from_whole_cursor(&expected, body));
+
+    /* The full bucket is spent right away, then the rest trickles out as it refills */
+    struct aws_byte_buf written;
+    ASSERT_SUCCESS(aws_byte_buf_init(&written, allocator, expected.len));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    size_t drains = 1;
+    while (true) {
+        struct aws_linked_list *written_msgs = testing_channel_get_written_message_queue(&tester.testing_channel);
+        for (struct aws_linked_list_node *node = aws_linked_list_begin(written_msgs);
+             node != aws_linked_list_end(written_msgs);
+             node = aws_linked_list_next(node)) {
+            struct aws_io_message *msg = AWS_CONTAINER_OF(node, struct aws_io_message, queueing_handle);
+            ASSERT_TRUE(msg->message_data.len <= limiter_options.burst_bytes);
+        }
+        ASSERT_SUCCESS(testing_channel_drain_written_messages(&tester.testing_channel, &written));
+
+        if (drains == 1) {
+            ASSERT_UINT_EQUALS(limiter_options.burst_bytes, written.len);
+        }
+        if (written.len == expected.len) {
+            break;
+        }
+
+        ASSERT_TRUE(drains < 10000);
+        aws_thread_current_sleep(aws_timestamp_convert(1, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&tester.testing_channel);
+        ++drains;
+    }
+    ASSERT_BIN_ARRAYS_EQUALS(expected.buffer, expected.len, written.buffer, written.len);
+
+    /* clean up */
+    aws_byte_buf_clean_up(&written);
+    aws_byte_buf_clean_up(&expected);
+    aws_input_stream_release(body_stream);
+    aws_http_message_release(request);
+    aws_http_stream_release(stream);
+    aws_http_rate_limiter_release(limiter);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
+/* With a receive rate limiter, the read window re-opens no faster than the limiter allows */
+H1_CLIENT_TEST_CASE(h1_client_response_receive_with_rate_limiter) {
+    (void)ctx;
+
+    /* 100 bytes every 100ms, never more than 100 at once */
+    struct aws_http_rate_limiter_options limiter_options = {
+        .bytes_per_second = 1000,
+        .burst_bytes = 100,
+    };
+    struct aws_http_rate_limiter *limiter = aws_http_rate_limiter_new(allocator, &limiter_options);
+    ASSERT_NOT_NULL(limiter);
+
+    struct tester_options tester_opts = {
+        .manual_window_management = true,
+        .initial_stream_window_size = SIZE_MAX,
+        .read_buffer_capacity = 300,
+        .receive_rate_limiter = limiter,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init_ex(&tester, allocator, &tester_opts));
+
+    /* The initial window isn't paced */
+    struct aws_h1_window_stats window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(300, window_stats.connection_window);
+
+    struct aws_http_message *request = s_new_default_get_request(allocator);
+    struct client_stream_tester stream_tester;
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, &tester, request));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    /* Response fills the whole window */
+    const char *response_head = "HTTP/1.1 200 OK\r\n"
+                                "Content-Length: 260\r\n"
+                                "\r\n";
+    char body[260];
+    memset(body, 'b', sizeof(body));
+    struct aws_byte_buf response;
+    ASSERT_SUCCESS(aws_byte_buf_init(&response, allocator, 300));
+    ASSERT_TRUE(aws_byte_buf_write_from_whole_cursor(&response, aws_byte_cursor_from_c_str(response_head)));
+    ASSERT_TRUE(aws_byte_buf_write(&response, (const uint8_t *)body, sizeof(body)));
+    ASSERT_UINT_EQUALS(300, response.len);
+
+    uint64_t start_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start_ns));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&tester.testing_channel, aws_byte_cursor_from_buf(&response)));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_SUCCESS(stream_tester.on_complete_error_code);
+    ASSERT_UINT_EQUALS(sizeof(body), stream_tester.response_body.len);
+
+    /* The full bucket re-opens part of the window right away, the rest opens as it refills */
+    window_stats = aws_h1_connection_window_stats(tester.connection);
+    ASSERT_UINT_EQUALS(limiter_options.burst_bytes, window_stats.connection_window);
+
+    size_t drains = 0;
+    size_t prev_window = window_stats.connection_window;
+    while (window_stats.connection_window < 300) {
+        ASSERT_TRUE(drains < 10000);
+        aws_thread_current_sleep(aws_timestamp_convert(1, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&tester.testing_channel);
+        ++drains;
+
+        window_stats = aws_h1_connection_window_stats(tester.connection);
+        ASSERT_TRUE(window_stats.connection_window - prev_window <= limiter_options.burst_bytes);
+        prev_window = window_stats.connection_window;
+    }
+    ASSERT_UINT_EQUALS(300, window_stats.connection_window);
+
+    /* That took two more refills, at 100ms each */
+    uint64_t end_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end_ns));
+    ASSERT_TRUE(end_ns - start_ns >= aws_timestamp_convert(200, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&response);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_message_release(request);
+    aws_http_rate_limiter_release(limiter);
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
+/* Gather the connection's statistics, the way a channel's statistics handler would */
+static int s_get_resident_bytes(struct tester *tester, uint64_t *out_resident_bytes) {
+    struct aws_array_list stats_list;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&stats_list, tester->alloc, 1, sizeof(void *)));
+
+    struct aws_channel_handler *handler = &tester->connection->channel_handler;
+    handler->vtable->gather_statistics(handler, &stats_list);
+    ASSERT_UINT_EQUALS(1, aws_array_list_length(&stats_list));
+
+    struct aws_crt_statistics_http1_channel *stats = NULL;
+    ASSERT_SUCCESS(aws_array_list_get_at(&stats_list, &stats, 0));
+    ASSERT_INT_EQUALS(AWSCRT_STAT_CAT_HTTP1_CHANNEL, stats->category);
+    *out_resident_bytes = stats->resident_bytes;
+
+    aws_array_list_clean_up(&stats_list);
+    return AWS_OP_SUCCESS;
+}
+
+/* The idle trim task only trims after a whole period without traffic, so it can take up to 2 periods */
+static int s_wait_for_idle_trim(struct tester *tester, uint64_t untrimmed_bytes) {
+    uint64_t resident_bytes = untrimmed_bytes;
+    for (size_t i = 0; i < 200 && resident_bytes >= untrimmed_bytes; ++i) {
+        aws_thread_current_sleep(aws_timestamp_convert(10, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&tester->testing_channel);
+        ASSERT_SUCCESS(s_get_resident_bytes(tester, &resident_bytes));
+    }
+    ASSERT_TRUE(resident_bytes < untrimmed_bytes);
+    return AWS_OP_SUCCESS;
+}
+
+/* Send a GET and respond with a header that's split across reads, so the decoder buffers it in its scratch space */
+static int s_send_request_with_split_response_header(struct tester *tester, const char *header_value) {
+    struct aws_http_message *request = s_new_default_get_request(tester->alloc);
+    struct client_stream_tester stream_tester;
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, tester, request));
+    testing_channel_drain_queued_tasks(&tester->testing_channel);
+
+    char response_head[1024];
+    snprintf(
+        response_head,
+        sizeof(response_head),
+        "HTTP/1.1 200 OK\r\n"
+        "x-long-header: %s\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n",
+        header_value);
+    struct aws_byte_cursor response = aws_byte_cursor_from_c_str(response_head);
+    struct aws_byte_cursor first_read = aws_byte_cursor_advance(&response, strlen("HTTP/1.1 200 OK\r\nx-long"));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&tester->testing_channel, first_read));
+    testing_channel_drain_queued_tasks(&tester->testing_channel);
+    ASSERT_SUCCESS(testing_channel_push_read_data(&tester->testing_channel, response));
+    testing_channel_drain_queued_tasks(&tester->testing_channel);
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_SUCCESS(stream_tester.on_complete_error_code);
+    ASSERT_SUCCESS(s_check_header(stream_tester.response_headers, 0, "x-long-header", header_value));
+
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_message_release(request);
+    return AWS_OP_SUCCESS;
+}
+
+/* An idle connection releases its decoder's scratch space, and re-grows it when traffic resumes */
+H1_CLIENT_TEST_CASE(h1_client_idle_trim) {
+    (void)ctx;
+
+    /* Long enough that the connection can't go idle while a request is being processed */
+    struct tester_options tester_opts = {
+        .idle_trim_ms = 50,
+    };
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init_ex(&tester, allocator, &tester_opts));
+
+    /* A header longer than the initial scratch space makes it grow */
+    char header_value[600];
+    memset(header_value, 'v', sizeof(header_value) - 1);
+    header_value[sizeof(header_value) - 1] = '\0';
+
+    ASSERT_SUCCESS(s_send_request_with_split_response_header(&tester, header_value));
+    uint64_t untrimmed_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&tester, &untrimmed_bytes));
+    ASSERT_TRUE(untrimmed_bytes > sizeof(header_value));
+
+    ASSERT_SUCCESS(s_wait_for_idle_trim(&tester, untrimmed_bytes));
+    uint64_t trimmed_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&tester, &trimmed_bytes));
+    ASSERT_TRUE(untrimmed_bytes - trimmed_bytes >= sizeof(header_value));
+
+    /* Another split header is still decoded correctly, and the scratch space grows back */
+    ASSERT_SUCCESS(s_send_request_with_split_response_header(&tester, header_value));
+    uint64_t regrown_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&tester, &regrown_bytes));
+    ASSERT_TRUE(regrown_bytes - trimmed_bytes >= sizeof(header_value));
+
+    /* And it's trimmed again once traffic stops again */
+    ASSERT_SUCCESS(s_wait_for_idle_trim(&tester, regrown_bytes));
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
+/* Without idle_trim_ms, nothing is released no matter how long the connection sits idle */
+H1_CLIENT_TEST_CASE(h1_client_idle_trim_disabled_by_default) {
+    (void)ctx;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    ASSERT_SUCCESS(s_send_request_with_split_response_header(&tester, "value"));
+    uint64_t resident_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&tester, &resident_bytes));
+
+    aws_thread_current_sleep(aws_timestamp_convert(100, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+    uint64_t later_resident_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&tester, &later_resident_bytes));
+    ASSERT_UINT_EQUALS(resident_bytes, later_resident_bytes);
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
 /* Test a connection with read_buffer_capacity < initial_window_size */
 H1_CLIENT_TEST_CASE(h1_client_connection_window_with_small_buffer) {
     (void)ctx;
@@ -4058,6 +4597,59 @@ H1_CLIENT_TEST_CASE(h1_client_midchannel_write_continues_after_shutdown_in_read_
     return AWS_OP_SUCCESS;
 }
 
+/* When the downstream window is smaller than a message, the message should be forwarded as slices that
+ * point into the original message's data, rather than as copies. */
+H1_CLIENT_TEST_CASE(h1_client_midchannel_read_with_small_downstream_window_does_not_copy) {
+    (void)ctx;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    struct protocol_switcher switcher = {
+        .tester = &tester,
+        .install_downstream_handler = true,
+        .downstream_handler_window_size = 4 /* Note tiny starting window. */,
+    };
+    ASSERT_SUCCESS(s_switch_protocols(&switcher));
+
+    const char *test_str = "inmyprotocolbytesareneverduplicated";
+    const size_t test_str_len = strlen(test_str);
+    struct aws_io_message *msg = aws_channel_acquire_message_from_pool(
+        tester.testing_channel.channel, AWS_IO_MESSAGE_APPLICATION_DATA, test_str_len);
+    ASSERT_NOT_NULL(msg);
+    ASSERT_TRUE(aws_byte_buf_write(&msg->message_data, (const uint8_t *)test_str, test_str_len));
+    const uint8_t *original_data = msg->message_data.buffer;
+    ASSERT_SUCCESS(testing_channel_push_read_message(&tester.testing_channel, msg));
+    testing_channel_drain_queued_tasks(&tester.testing_channel);
+
+    /* open window in small increments */
+    for (size_t i = 0; i < test_str_len; i += 4) {
+        ASSERT_SUCCESS(testing_channel_increment_read_window(&tester.testing_channel, 4));
+        testing_channel_drain_queued_tasks(&tester.testing_channel);
+    }
+
+    /* each message sent downstream should be a slice of the original message, covering the next part of its data */
+    size_t num_read_messages = 0;
+    size_t offset = 0;
+    struct aws_linked_list *list = testing_channel_get_read_message_queue(&tester.testing_channel);
+    struct aws_linked_list_node *node = aws_linked_list_front(list);
+    while (node != aws_linked_list_end(list)) {
+        struct aws_io_message *read_msg = AWS_CONTAINER_OF(node, struct aws_io_message, queueing_handle);
+        ASSERT_PTR_EQUALS(msg, aws_h1_read_message_slice_get_original(read_msg));
+        ASSERT_PTR_EQUALS(original_data + offset, read_msg->message_data.buffer);
+        offset += read_msg->message_data.len;
+        num_read_messages++;
+        node = aws_linked_list_next(node);
+    }
+    ASSERT_TRUE(num_read_messages > 1);
+    ASSERT_UINT_EQUALS(test_str_len, offset);
+
+    ASSERT_SUCCESS(testing_channel_check_midchannel_read_messages_str(&tester.testing_channel, allocator, test_str));
+
+    /* cleanup */
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
 static void s_on_message_write_complete_save_error_code(
     struct aws_channel *channel,
     struct aws_io_message *message,
@@ -585,6 +585,112 @@ static int s_h1_decode_messages_at_random_intervals(struct aws_allocator *alloca
     return AWS_OP_SUCCESS;
 }
 
+struct pipelined_tester {
+    size_t header_count;
+    size_t done_count;
+};
+
+static int s_pipelined_on_header(const struct aws_h1_decoded_header *header, void *user_data) {
+    (void)header;
+    struct pipelined_tester *tester = user_data;
+    tester->header_count++;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_pipelined_on_done(void *user_data) {
+    struct pipelined_tester *tester = user_data;
+    tester->done_count++;
+    return AWS_OP_SUCCESS;
+}
+
+/* Heads that arrive whole are parsed in one pass, heads split across reads go line by line.
+ * Both must produce the same callbacks, and neither may consume the next message's bytes. */
+AWS_TEST_CASE(h1_decode_pipelined_heads, s_h1_decode_pipelined_heads);
+static int s_h1_decode_pipelined_heads(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    s_test_init(allocator);
+    struct aws_byte_cursor msg = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("HTTP/1.1 100 Continue\r\n"
+                                                                       "\r\n"
+                                                                       "HTTP/1.1 200 OK\r\n"
+                                                                       "Server: some-server\r\n"
+                                                                       "Content-Length: 11\r\n"
+                                                                       "\r\n"
+                                                                       "Hello noob."
+                                                                       "HTTP/1.1 204 No Content\r\n"
+                                                                       "Server: some-server\r\n"
+                                                                       "\r\n");
+
+    /* Split point 0 decodes everything in one call, other split points land mid-head or mid-body */
+    for (size_t split = 0; split < msg.len; ++split) {
+        struct pipelined_tester tester;
+        AWS_ZERO_STRUCT(tester);
+
+        struct aws_h1_decoder_params params;
+        s_common_decoder_setup(allocator, 1024, &params, s_response, &tester);
+        params.vtable.on_header = s_pipelined_on_header;
+        params.vtable.on_done = s_pipelined_on_done;
+        struct aws_h1_decoder *decoder = aws_h1_decoder_new(&params);
+
+        struct aws_byte_cursor remaining = msg;
+        struct aws_byte_cursor chunk = aws_byte_cursor_advance(&remaining, split);
+        while (chunk.len) {
+            ASSERT_SUCCESS(aws_h1_decode(decoder, &chunk));
+        }
+        while (remaining.len) {
+            ASSERT_SUCCESS(aws_h1_decode(decoder, &remaining));
+        }
+
+        ASSERT_UINT_EQUALS(3, tester.header_count);
+        ASSERT_UINT_EQUALS(3, tester.done_count);
+
+        aws_h1_decoder_destroy(decoder);
+    }
+
+    s_test_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+/* Each field counts its length plus 32. s_typical_request has fields of 16 and 19 bytes, so it needs a limit of 99 */
+AWS_TEST_CASE(h1_decode_max_header_list_size, s_h1_decode_max_header_list_size);
+static int s_h1_decode_max_header_list_size(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    s_test_init(allocator);
+
+    struct aws_h1_decoder_params params;
+    s_common_decoder_setup(allocator, 1024, &params, s_request, NULL);
+
+    /* Exactly at the limit, whether the head arrives whole or one byte at a time */
+    params.max_header_list_size = 99;
+    struct aws_h1_decoder *decoder = aws_h1_decoder_new(&params);
+    struct aws_byte_cursor msg = s_typical_request;
+    ASSERT_SUCCESS(aws_h1_decode(decoder, &msg));
+    msg = s_typical_request;
+    while (msg.len) {
+        struct aws_byte_cursor chunk = aws_byte_cursor_advance(&msg, 1);
+        ASSERT_SUCCESS(aws_h1_decode(decoder, &chunk));
+    }
+    aws_h1_decoder_destroy(decoder);
+
+    /* One byte over */
+    params.max_header_list_size = 98;
+    decoder = aws_h1_decoder_new(&params);
+    msg = s_typical_request;
+    ASSERT_FAILS(aws_h1_decode(decoder, &msg));
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_HEADERS_TOO_LARGE, aws_last_error());
+    aws_h1_decoder_destroy(decoder);
+
+    /* A line that's already too big is rejected before its CRLF arrives */
+    params.max_header_list_size = 64;
+    decoder = aws_h1_decoder_new(&params);
+    msg = aws_byte_cursor_from_c_str("GET / HTTP/1.1\r\nX-Big: aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+    ASSERT_FAILS(aws_h1_decode(decoder, &msg));
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_HEADERS_TOO_LARGE, aws_last_error());
+    aws_h1_decoder_destroy(decoder);
+
+    s_test_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
 AWS_TEST_CASE(h1_decode_bad_requests_and_assert_failure, s_h1_decode_bad_requests_and_assert_failure);
 static int s_h1_decode_bad_requests_and_assert_failure(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
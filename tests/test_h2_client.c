@@ -5,9 +5,13 @@
 
 #include "h2_test_helper.h"
 #include "stream_test_helper.h"
+#include <aws/http/memory_budget.h>
 #include <aws/http/private/h2_connection.h>
 #include <aws/http/private/request_response_impl.h>
+#include <aws/http/rate_limiter.h>
 #include <aws/http/request_response.h>
+#include <aws/http/statistics.h>
+#include <aws/http/websocket.h>
 #include <aws/io/stream.h>
 #include <aws/testing/io_testing_channel.h>
 
@@ -82,6 +86,11 @@ static struct tester {
     struct connection_user_data user_data;
 
     bool no_conn_manual_win_management;
+    const struct aws_http2_abuse_limits *abuse_limits;
+    uint64_t idle_trim_ms;
+    struct aws_http_memory_budget *memory_budget;
+    struct aws_http_rate_limiter *send_rate_limiter;
+    struct aws_http_rate_limiter *receive_rate_limiter;
 } s_tester;
 
 static int s_tester_init(struct aws_allocator *alloc, void *ctx) {
@@ -106,6 +115,11 @@ static int s_tester_init(struct aws_allocator *alloc, void *ctx) {
         .on_goaway_received = s_on_goaway_received,
         .on_remote_settings_change = s_on_remote_settings_change,
         .conn_manual_window_management = !s_tester.no_conn_manual_win_management,
+        .abuse_limits = s_tester.abuse_limits,
+        .idle_trim_ms = s_tester.idle_trim_ms,
+        .memory_budget = s_tester.memory_budget,
+        .send_rate_limiter = s_tester.send_rate_limiter,
+        .receive_rate_limiter = s_tester.receive_rate_limiter,
     };
 
     s_tester.connection =
@@ -1495,6 +1509,205 @@ TEST_CASE(h2_client_stream_receive_data) {
     return s_tester_clean_up();
 }
 
+/* Encode a DATA frame by hand, so that several can be packed into one aws_io_message */
+static int s_write_raw_data_frame(struct aws_byte_buf *dst, uint32_t stream_id, const char *data, bool end_stream) {
+    struct aws_byte_cursor data_cursor = aws_byte_cursor_from_c_str(data);
+    ASSERT_TRUE(aws_byte_buf_write_be24(dst, (uint32_t)data_cursor.len));
+    ASSERT_TRUE(aws_byte_buf_write_u8(dst, AWS_H2_FRAME_T_DATA));
+    ASSERT_TRUE(aws_byte_buf_write_u8(dst, end_stream ? AWS_H2_FRAME_F_END_STREAM : 0));
+    ASSERT_TRUE(aws_byte_buf_write_be32(dst, stream_id));
+    ASSERT_TRUE(aws_byte_buf_write_from_whole_cursor(dst, data_cursor));
+    return AWS_OP_SUCCESS;
+}
+
+/* Several DATA frames arriving in one read should be delivered by a single vectored body callback,
+ * and covered by a single stream WINDOW_UPDATE */
+TEST_CASE(h2_client_stream_receive_data_vectored) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    /* fake peer sends connection preface */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* send request */
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = s_tester.connection,
+        .use_vectored_body = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    /* fake peer sends response headers */
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    size_t num_frames_before_body = h2_decode_tester_frame_count(&s_tester.peer.decode);
+
+    /* fake peer sends response body as 3 DATA frames in a single message */
+    struct aws_byte_buf frames;
+    ASSERT_SUCCESS(aws_byte_buf_init(&frames, allocator, 64));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "hel", false /*end_stream*/));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "lo", false /*end_stream*/));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "!", true /*end_stream*/));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&s_tester.testing_channel, aws_byte_cursor_from_buf(&frames)));
+
+    /* validate that client received complete response, via one callback */
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_INT_EQUALS(200, stream_tester.response_status);
+    ASSERT_TRUE(aws_byte_buf_eq_c_str(&stream_tester.response_body, "hello!"));
+    ASSERT_UINT_EQUALS(1, stream_tester.num_body_callbacks);
+
+    /* one stream WINDOW_UPDATE covers both DATA frames that didn't end the stream */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    size_t window_update_idx = 0;
+    struct h2_decoded_frame *stream_window_update_frame = h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_WINDOW_UPDATE, stream_id, num_frames_before_body, &window_update_idx);
+    ASSERT_NOT_NULL(stream_window_update_frame);
+    ASSERT_UINT_EQUALS(5, stream_window_update_frame->window_size_increment);
+    ASSERT_NULL(h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_WINDOW_UPDATE, stream_id, window_update_idx + 1, NULL));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&frames);
+    aws_http_headers_release(response_headers);
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
+/* Sum the increments of WINDOW_UPDATE frames for `stream_id`, starting at frame `idx` */
+static uint32_t s_sum_window_updates(uint32_t stream_id, size_t idx) {
+    uint32_t sum = 0;
+    struct h2_decoded_frame *frame;
+    while ((frame = h2_decode_tester_find_stream_frame(
+                &s_tester.peer.decode, AWS_H2_FRAME_T_WINDOW_UPDATE, stream_id, idx, &idx)) != NULL) {
+        sum += frame->window_size_increment;
+        ++idx;
+    }
+    return sum;
+}
+
+/* Sum the increments of connection WINDOW_UPDATE frames, starting at frame `idx` */
+static uint32_t s_sum_connection_window_updates(size_t idx) {
+    return s_sum_window_updates(0 /*stream_id*/, idx);
+}
+
+/* Retained body data stays valid after the messages it arrived in are processed.
+ * The connection withholds that much window from the peer until the data is released */
+TEST_CASE(h2_client_stream_receive_data_retained) {
+    /* Enable automatic window manager management */
+    s_tester.no_conn_manual_win_management = true;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    /* fake peer sends connection preface */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* send request */
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = s_tester.connection,
+        .use_retained_body = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    /* fake peer sends response headers */
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    size_t num_frames_before_body = h2_decode_tester_frame_count(&s_tester.peer.decode);
+
+    /* fake peer sends response body as 2 DATA frames in one message, then 1 more in another */
+    struct aws_byte_buf frames;
+    ASSERT_SUCCESS(aws_byte_buf_init(&frames, allocator, 64));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "hel", false /*end_stream*/));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "lo", false /*end_stream*/));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&s_tester.testing_channel, aws_byte_cursor_from_buf(&frames)));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    aws_byte_buf_reset(&frames, false);
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frames, stream_id, "!", true /*end_stream*/));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&s_tester.testing_channel, aws_byte_cursor_from_buf(&frames)));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* validate that client received complete response, and nothing was copied out */
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_UINT_EQUALS(3, stream_tester.num_body_callbacks);
+    ASSERT_UINT_EQUALS(0, stream_tester.response_body.len);
+
+    /* slices from the same message share a retained body */
+    ASSERT_UINT_EQUALS(3, stream_tester.num_retained_slices);
+    ASSERT_PTR_EQUALS(stream_tester.retained_bodies[0], stream_tester.retained_bodies[1]);
+    ASSERT_TRUE(stream_tester.retained_bodies[1] != stream_tester.retained_bodies[2]);
+
+    /* only the first DATA frame's window came back, the rest covers retained data */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_UINT_EQUALS(3, s_sum_connection_window_updates(num_frames_before_body));
+
+    /* the data is still there after its messages were processed, and releasing it gives the window back */
+    ASSERT_SUCCESS(client_stream_tester_release_retained_body(&stream_tester));
+    ASSERT_TRUE(aws_byte_buf_eq_c_str(&stream_tester.response_body, "hello!"));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_UINT_EQUALS(6, s_sum_connection_window_updates(num_frames_before_body));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&frames);
+    aws_http_headers_release(response_headers);
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
 /* A message is malformed if DATA is received before HEADERS */
 TEST_CASE(h2_client_stream_err_receive_data_before_headers) {
     ASSERT_SUCCESS(s_tester_init(allocator, ctx));
@@ -1904,6 +2117,67 @@ TEST_CASE(h2_client_stream_send_stalled_data) {
     return s_tester_clean_up();
 }
 
+/* Test that a stalled body using body-ready notifications sleeps, instead of being polled every tick */
+TEST_CASE(h2_client_stream_send_data_waits_for_body_ready_notification) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    /* get request ready
+     * the body_stream will stall and provide no data when we try to read from it */
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "POST"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+
+    const char *body_src = "hello";
+    struct aws_byte_cursor body_cursor = aws_byte_cursor_from_c_str(body_src);
+    struct aws_input_stream *request_body = aws_input_stream_new_tester(allocator, body_cursor);
+    aws_input_stream_tester_set_max_bytes_per_read(request_body, 0);
+
+    aws_http_message_set_body_stream(request, request_body);
+
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = s_tester.connection,
+        .use_body_ready_notifications = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, s_tester.alloc, &options));
+
+    /* Draining the task queue would never finish if the stalled body was polled every tick */
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_NULL(h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_DATA, 0 /*search_start_idx*/, NULL));
+
+    /* Data arriving without a notification doesn't wake the stream */
+    aws_input_stream_tester_set_max_bytes_per_read(request_body, SIZE_MAX);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_linked_list_empty(testing_channel_get_written_message_queue(&s_tester.testing_channel)));
+
+    /* Notify that body is ready, and the rest of the data should be sent */
+    ASSERT_SUCCESS(aws_http_stream_notify_body_ready(stream_tester.stream));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_SUCCESS(
+        h2_decode_tester_check_data_str_across_frames(&s_tester.peer.decode, stream_id, body_src, true /*end_stream*/));
+
+    /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_input_stream_release(request_body);
+    return s_tester_clean_up();
+}
+
 static int s_fake_peer_window_update_check(
     struct aws_allocator *alloc,
     uint32_t stream_id,
@@ -3155,80 +3429,353 @@ TEST_CASE(h2_client_stream_err_receive_rst_stream) {
     return s_tester_clean_up();
 }
 
-/* We don't fully support PUSH_PROMISE, so we automatically send RST_STREAM to reject any promised streams.
- * Why, you ask, don't we simply send SETTINGS_ENABLE_PUSH=0 in the initial SETTINGS frame and call it a day?
- * Because it's theoretically possible for a server to start sending PUSH_PROMISE frames in the initial
- * response, before sending the ACK to the initial SETTINGS. */
-TEST_CASE(h2_client_push_promise_automatically_rejected) {
+/* Extended CONNECT (RFC-8441) must not be sent until the peer enables it via SETTINGS_ENABLE_CONNECT_PROTOCOL */
+TEST_CASE(h2_client_stream_extended_connect_requires_peer_setting) {
     ASSERT_SUCCESS(s_tester_init(allocator, ctx));
 
-    /* fake peer sends connection preface */
+    /* fake peer sends connection preface, which doesn't enable the CONNECT protocol */
     ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    /* send request */
-    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    struct aws_http_message *request = aws_http2_message_new_websocket_handshake_request(
+        allocator, aws_byte_cursor_from_c_str("/chat"), aws_byte_cursor_from_c_str("example.com"));
     ASSERT_NOT_NULL(request);
 
-    struct aws_http_header request_headers_src[] = {
-        DEFINE_HEADER(":method", "GET"),
-        DEFINE_HEADER(":scheme", "https"),
-        DEFINE_HEADER(":authority", "veryblackpage.com"),
-        DEFINE_HEADER(":path", "/"),
-    };
-    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
-
+    /* send request, which should fail */
     struct client_stream_tester stream_tester;
     ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, request));
-
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
-    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
 
-    /* fake peer sends push request (PUSH_PROMISE) */
-    struct aws_http_header push_request_headers_src[] = {
-        DEFINE_HEADER(":method", "GET"),
-        DEFINE_HEADER(":scheme", "https"),
-        DEFINE_HEADER(":authority", "veryblackpage.com"),
-        DEFINE_HEADER(":path", "/style.css"),
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_EXTENDED_CONNECT_NOT_ENABLED, stream_tester.on_complete_error_code);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+    client_stream_tester_clean_up(&stream_tester);
+
+    /* fake peer enables the CONNECT protocol */
+    struct aws_http2_setting settings_array[] = {
+        {.id = AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL, .value = 1},
     };
-    struct aws_http_headers *push_request_headers = aws_http_headers_new(allocator);
-    ASSERT_SUCCESS(aws_http_headers_add_array(
-        push_request_headers, push_request_headers_src, AWS_ARRAY_SIZE(push_request_headers_src)));
+    struct aws_h2_frame *settings =
+        aws_h2_frame_new_settings(allocator, settings_array, AWS_ARRAY_SIZE(settings_array), false /*ack*/);
+    ASSERT_NOT_NULL(settings);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, settings));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    uint32_t promised_stream_id = 2;
-    struct aws_h2_frame *peer_frame =
-        aws_h2_frame_new_push_promise(allocator, stream_id, promised_stream_id, push_request_headers, 0);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    /* the public settings array keeps its size, the new setting isn't in it */
+    struct aws_http2_setting remote_settings[AWS_HTTP2_SETTINGS_COUNT];
+    aws_http2_connection_get_remote_settings(s_tester.connection, remote_settings);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, remote_settings[AWS_HTTP2_SETTINGS_COUNT - 1].id);
 
-    /* fake peer sends push response RIGHT AWAY before there's any possibility of receiving RST_STREAM */
-    struct aws_http_header push_response_headers_src[] = {
-        DEFINE_HEADER(":status", "200"),
-    };
-    struct aws_http_headers *push_response_headers = aws_http_headers_new(allocator);
-    ASSERT_SUCCESS(aws_http_headers_add_array(
-        push_response_headers, push_response_headers_src, AWS_ARRAY_SIZE(push_response_headers_src)));
+    /* send request again, which should be sent and remain open */
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, request));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    peer_frame =
-        aws_h2_frame_new_headers(allocator, promised_stream_id, push_response_headers, false /*end_stream*/, 0, NULL);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    ASSERT_FALSE(stream_tester.complete);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
 
-    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(
-        &s_tester.peer, promised_stream_id, "body {background-color: black;}", true /*end_stream*/));
+    /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
 
-    /* fake peer sends response to the initial request */
-    struct aws_http_header response_headers_src[] = {
-        DEFINE_HEADER(":status", "200"),
-    };
-    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
-    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+/* Records what a websocket bootstrapped over an HTTP/2 stream reports */
+struct h2_websocket_tester {
+    bool setup_completed;
+    int setup_error_code;
+    struct aws_websocket *websocket;
+    int response_status;
+    struct aws_byte_buf response_body;
 
-    peer_frame = aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    bool shutdown_completed;
+    int shutdown_error_code;
 
-    const char *body_src = "<html><head><link rel=\"stylesheet\" type=\"text/css\" href=\"style.css\"></head></html>";
-    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, stream_id, body_src, true /*end_stream*/));
+    struct aws_byte_buf received_payload;
+    struct aws_byte_cursor outgoing_payload;
+};
 
-    /* validate that stream completed successfully. */
+static void s_h2_websocket_on_setup(const struct aws_websocket_on_connection_setup_data *setup, void *user_data) {
+    struct h2_websocket_tester *tester = user_data;
+    tester->setup_completed = true;
+    tester->setup_error_code = setup->error_code;
+    tester->websocket = setup->websocket;
+    if (setup->handshake_response_status) {
+        tester->response_status = *setup->handshake_response_status;
+    }
+    if (setup->handshake_response_body) {
+        aws_byte_buf_append_dynamic(&tester->response_body, setup->handshake_response_body);
+    }
+}
+
+static void s_h2_websocket_on_shutdown(struct aws_websocket *websocket, int error_code, void *user_data) {
+    (void)websocket;
+    struct h2_websocket_tester *tester = user_data;
+    tester->shutdown_completed = true;
+    tester->shutdown_error_code = error_code;
+}
+
+static bool s_h2_websocket_on_incoming_frame_payload(
+    struct aws_websocket *websocket,
+    const struct aws_websocket_incoming_frame *frame,
+    struct aws_byte_cursor data,
+    void *user_data) {
+
+    (void)websocket;
+    (void)frame;
+    struct h2_websocket_tester *tester = user_data;
+    aws_byte_buf_append_dynamic(&tester->received_payload, &data);
+    return true;
+}
+
+static bool s_h2_websocket_stream_outgoing_payload(
+    struct aws_websocket *websocket,
+    struct aws_byte_buf *out_buf,
+    void *user_data) {
+
+    (void)websocket;
+    struct h2_websocket_tester *tester = user_data;
+    aws_byte_buf_write_to_capacity(out_buf, &tester->outgoing_payload);
+    return true;
+}
+
+/* Start a websocket over a new stream, with a peer that has enabled extended CONNECT.
+ * Returns once the peer has received the extended CONNECT request. */
+static int s_h2_websocket_tester_connect(struct h2_websocket_tester *tester, struct aws_allocator *allocator) {
+    AWS_ZERO_STRUCT(*tester);
+    aws_byte_buf_init(&tester->response_body, allocator, 0);
+    aws_byte_buf_init(&tester->received_payload, allocator, 0);
+
+    /* fake peer enables the CONNECT protocol in its connection preface */
+    struct aws_http2_setting settings_array[] = {
+        {.id = AWS_HTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL, .value = 1},
+    };
+    struct aws_h2_frame *settings =
+        aws_h2_frame_new_settings(allocator, settings_array, AWS_ARRAY_SIZE(settings_array), false /*ack*/);
+    ASSERT_NOT_NULL(settings);
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface(&s_tester.peer, settings));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    struct aws_http_message *request = aws_http2_message_new_websocket_handshake_request(
+        allocator, aws_byte_cursor_from_c_str("/chat"), aws_byte_cursor_from_c_str("example.com"));
+    ASSERT_NOT_NULL(request);
+
+    struct aws_websocket_client_http2_options ws_options = {
+        .allocator = allocator,
+        .http2_connection = s_tester.connection,
+        .handshake_request = request,
+        .user_data = tester,
+        .on_connection_setup = s_h2_websocket_on_setup,
+        .on_connection_shutdown = s_h2_websocket_on_shutdown,
+        .on_incoming_frame_payload = s_h2_websocket_on_incoming_frame_payload,
+    };
+    ASSERT_SUCCESS(aws_websocket_client_connect_over_http2(&ws_options));
+    aws_http_message_release(request);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* the request goes out as extended CONNECT, and the stream stays open to carry the websocket */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *request_frame = h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_HEADERS, 1 /*stream_id*/, 0 /*search_start_idx*/, NULL);
+    ASSERT_NOT_NULL(request_frame);
+    ASSERT_FALSE(request_frame->end_stream);
+    struct aws_byte_cursor protocol;
+    ASSERT_SUCCESS(aws_http_headers_get(request_frame->headers, aws_byte_cursor_from_c_str(":protocol"), &protocol));
+    ASSERT_TRUE(aws_byte_cursor_eq_c_str(&protocol, "websocket"));
+    ASSERT_FALSE(tester->setup_completed);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_h2_websocket_peer_send_response(const char *status, bool end_stream) {
+    struct aws_http_header response_headers_src[] = {
+        {
+            .name = aws_byte_cursor_from_c_str(":status"),
+            .value = aws_byte_cursor_from_c_str(status),
+        },
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(s_tester.alloc);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(s_tester.alloc, 1 /*stream_id*/, response_headers, end_stream, 0, NULL);
+    aws_http_headers_release(response_headers);
+    ASSERT_NOT_NULL(response_frame);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    return AWS_OP_SUCCESS;
+}
+
+static void s_h2_websocket_tester_clean_up(struct h2_websocket_tester *tester) {
+    aws_websocket_release(tester->websocket);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    aws_byte_buf_clean_up(&tester->response_body);
+    aws_byte_buf_clean_up(&tester->received_payload);
+}
+
+/* A 200 response to extended CONNECT sets up a websocket, which relays data both ways over the stream's DATA frames */
+TEST_CASE(h2_client_websocket_over_stream) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    struct h2_websocket_tester ws_tester;
+    ASSERT_SUCCESS(s_h2_websocket_tester_connect(&ws_tester, allocator));
+
+    ASSERT_SUCCESS(s_h2_websocket_peer_send_response("200", false /*end_stream*/));
+    ASSERT_TRUE(ws_tester.setup_completed);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, ws_tester.setup_error_code);
+    ASSERT_NOT_NULL(ws_tester.websocket);
+    ASSERT_INT_EQUALS(200, ws_tester.response_status);
+
+    /* peer sends an unmasked text frame, split across DATA frames */
+    const uint8_t server_frame[] = {0x81, 0x05, 'h', 'e', 'l', 'l', 'o'};
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame(
+        &s_tester.peer, 1 /*stream_id*/, aws_byte_cursor_from_array(server_frame, 3), false /*end_stream*/));
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame(
+        &s_tester.peer, 1 /*stream_id*/, aws_byte_cursor_from_array(server_frame + 3, 4), false /*end_stream*/));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_BIN_ARRAYS_EQUALS("hello", 5, ws_tester.received_payload.buffer, ws_tester.received_payload.len);
+
+    /* websocket sends a text frame, which the peer receives as DATA */
+    size_t frame_count = h2_decode_tester_frame_count(&s_tester.peer.decode);
+    ws_tester.outgoing_payload = aws_byte_cursor_from_c_str("hi");
+    struct aws_websocket_send_frame_options send_options = {
+        .payload_length = ws_tester.outgoing_payload.len,
+        .user_data = &ws_tester,
+        .stream_outgoing_payload = s_h2_websocket_stream_outgoing_payload,
+        .opcode = AWS_WEBSOCKET_OPCODE_TEXT,
+        .fin = true,
+    };
+    ASSERT_SUCCESS(aws_websocket_send_frame(ws_tester.websocket, &send_options));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    struct h2_decoded_frame *data_frame = h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_DATA, 1 /*stream_id*/, frame_count, NULL);
+    ASSERT_NOT_NULL(data_frame);
+    ASSERT_FALSE(data_frame->end_stream);
+    /* 2 byte header, 4 byte masking-key, 2 byte payload */
+    ASSERT_UINT_EQUALS(8, data_frame->data.len);
+    ASSERT_UINT_EQUALS(0x81, data_frame->data.buffer[0]);
+    ASSERT_UINT_EQUALS(0x82, data_frame->data.buffer[1]);
+
+    /* closing the websocket ends the stream, and the HTTP/2 connection stays open */
+    aws_websocket_close(ws_tester.websocket, false /*free_scarce_resources_immediately*/);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(ws_tester.shutdown_completed);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *latest_frame = h2_decode_tester_latest_frame(&s_tester.peer.decode);
+    ASSERT_INT_EQUALS(AWS_H2_FRAME_T_DATA, latest_frame->type);
+    ASSERT_TRUE(latest_frame->end_stream);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* clean up */
+    s_h2_websocket_tester_clean_up(&ws_tester);
+    return s_tester_clean_up();
+}
+
+/* A non-200 response to extended CONNECT fails setup, reporting the full response */
+TEST_CASE(h2_client_websocket_over_stream_rejected) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    struct h2_websocket_tester ws_tester;
+    ASSERT_SUCCESS(s_h2_websocket_tester_connect(&ws_tester, allocator));
+
+    ASSERT_SUCCESS(s_h2_websocket_peer_send_response("403", false /*end_stream*/));
+    ASSERT_FALSE(ws_tester.setup_completed);
+
+    /* the client ends its side of the stream, since it won't be carrying a websocket */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *latest_frame = h2_decode_tester_latest_frame(&s_tester.peer.decode);
+    ASSERT_INT_EQUALS(AWS_H2_FRAME_T_DATA, latest_frame->type);
+    ASSERT_TRUE(latest_frame->end_stream);
+
+    /* setup fails once the response is complete */
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, 1 /*stream_id*/, "denied", true /*end_stream*/));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(ws_tester.setup_completed);
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_WEBSOCKET_UPGRADE_FAILURE, ws_tester.setup_error_code);
+    ASSERT_NULL(ws_tester.websocket);
+    ASSERT_INT_EQUALS(403, ws_tester.response_status);
+    ASSERT_BIN_ARRAYS_EQUALS("denied", 6, ws_tester.response_body.buffer, ws_tester.response_body.len);
+    ASSERT_FALSE(ws_tester.shutdown_completed);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* clean up */
+    s_h2_websocket_tester_clean_up(&ws_tester);
+    return s_tester_clean_up();
+}
+
+/* We don't fully support PUSH_PROMISE, so we automatically send RST_STREAM to reject any promised streams.
+ * Why, you ask, don't we simply send SETTINGS_ENABLE_PUSH=0 in the initial SETTINGS frame and call it a day?
+ * Because it's theoretically possible for a server to start sending PUSH_PROMISE frames in the initial
+ * response, before sending the ACK to the initial SETTINGS. */
+TEST_CASE(h2_client_push_promise_automatically_rejected) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+
+    /* fake peer sends connection preface */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* send request */
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":authority", "veryblackpage.com"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+
+    struct client_stream_tester stream_tester;
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, request));
+
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    /* fake peer sends push request (PUSH_PROMISE) */
+    struct aws_http_header push_request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":authority", "veryblackpage.com"),
+        DEFINE_HEADER(":path", "/style.css"),
+    };
+    struct aws_http_headers *push_request_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_array(
+        push_request_headers, push_request_headers_src, AWS_ARRAY_SIZE(push_request_headers_src)));
+
+    uint32_t promised_stream_id = 2;
+    struct aws_h2_frame *peer_frame =
+        aws_h2_frame_new_push_promise(allocator, stream_id, promised_stream_id, push_request_headers, 0);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+
+    /* fake peer sends push response RIGHT AWAY before there's any possibility of receiving RST_STREAM */
+    struct aws_http_header push_response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *push_response_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_array(
+        push_response_headers, push_response_headers_src, AWS_ARRAY_SIZE(push_response_headers_src)));
+
+    peer_frame =
+        aws_h2_frame_new_headers(allocator, promised_stream_id, push_response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(
+        &s_tester.peer, promised_stream_id, "body {background-color: black;}", true /*end_stream*/));
+
+    /* fake peer sends response to the initial request */
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+
+    peer_frame = aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+
+    const char *body_src = "<html><head><link rel=\"stylesheet\" type=\"text/css\" href=\"style.css\"></head></html>";
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, stream_id, body_src, true /*end_stream*/));
+
+    /* validate that stream completed successfully. */
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
     ASSERT_TRUE(stream_tester.complete);
     ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
@@ -4134,142 +4681,871 @@ TEST_CASE(h2_client_manual_window_management_user_send_connection_window_update_
 
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    /* update the connection window to cause an overflow */
-    aws_http2_connection_update_window(s_tester.connection, INT32_MAX);
-    aws_http2_connection_update_window(s_tester.connection, INT32_MAX);
+    /* update the connection window to cause an overflow */
+    aws_http2_connection_update_window(s_tester.connection, INT32_MAX);
+    aws_http2_connection_update_window(s_tester.connection, INT32_MAX);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    /* validate that connection closed with error */
+    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
+    /* client should send GOAWAY */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *goaway =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
+    ASSERT_NOT_NULL(goaway);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_INTERNAL_ERROR, goaway->error_code);
+    ASSERT_UINT_EQUALS(0, goaway->goaway_last_stream_id);
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+struct ping_user_data {
+    uint64_t rtt_ns;
+    int error_code;
+};
+
+static void on_ping_complete(
+    struct aws_http_connection *connection,
+    uint64_t round_trip_time_ns,
+    int error_code,
+    void *user_data) {
+
+    (void)connection;
+    struct ping_user_data *data = user_data;
+    data->error_code = error_code;
+    data->rtt_ns = round_trip_time_ns;
+}
+
+/* Test the user API for PING successfully get the round trip time */
+TEST_CASE(h2_client_send_ping_successfully_receive_ack) {
+
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    struct aws_byte_cursor opaque_data = aws_byte_cursor_from_c_str("12345678");
+    struct ping_user_data data = {.rtt_ns = 0, .error_code = INT32_MAX};
+    /* client request a PING */
+    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, &opaque_data, on_ping_complete, &data));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    /* check ping frame received */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *ping_frame =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_PING, 0, NULL);
+    ASSERT_BIN_ARRAYS_EQUALS(
+        opaque_data.ptr, AWS_HTTP2_PING_DATA_SIZE, ping_frame->ping_opaque_data, AWS_HTTP2_PING_DATA_SIZE);
+    ASSERT_FALSE(ping_frame->ack);
+
+    /* fake peer send PING ACK */
+    struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, ping_frame->ping_opaque_data);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    /* check callback fired, and succeed */
+    ASSERT_INT_EQUALS(0, data.error_code);
+    ASSERT_FALSE(data.rtt_ns == 0);
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+/* Test the user request a PING, but peer never sends PING ACK back */
+TEST_CASE(h2_client_send_ping_no_ack_received) {
+
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    struct ping_user_data data = {.rtt_ns = 0, .error_code = INT32_MAX};
+    /* client request a PING */
+    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, NULL, on_ping_complete, &data));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    /* check ping frame received */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *ping_frame =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_PING, 0, NULL);
+    uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE];
+    AWS_ZERO_ARRAY(opaque_data);
+    /* Zeroed 8 bytes data received */
+    ASSERT_BIN_ARRAYS_EQUALS(
+        opaque_data, AWS_HTTP2_PING_DATA_SIZE, ping_frame->ping_opaque_data, AWS_HTTP2_PING_DATA_SIZE);
+    ASSERT_FALSE(ping_frame->ack);
+
+    /* shutdown the connection */
+    h2_fake_peer_clean_up(&s_tester.peer);
+    aws_http_connection_release(s_tester.connection);
+    ASSERT_SUCCESS(testing_channel_clean_up(&s_tester.testing_channel));
+    /* Check the callback has fired with error */
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_CONNECTION_CLOSED, data.error_code);
+    ASSERT_TRUE(data.rtt_ns == 0);
+    /* clean up */
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+/* Test the user request a PING, but peer sends an extra PING ACK */
+TEST_CASE(h2_client_conn_err_extraneous_ping_ack_received) {
+
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    struct aws_byte_cursor opaque_data = aws_byte_cursor_from_c_str("12345678");
+    /* client request a PING */
+    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, &opaque_data, NULL, NULL));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, opaque_data.ptr);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    /* fake peer send an extra PING ACK */
+    peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, opaque_data.ptr);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* validate the connection completed with error */
+    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
+    ASSERT_INT_EQUALS(
+        AWS_ERROR_HTTP_PROTOCOL_ERROR, testing_channel_get_shutdown_error_code(&s_tester.testing_channel));
+
+    /* client should send GOAWAY */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *goaway =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
+    ASSERT_NOT_NULL(goaway);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_PROTOCOL_ERROR, goaway->error_code);
+    ASSERT_UINT_EQUALS(0, goaway->goaway_last_stream_id);
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+/* Peer floods us with PINGs, which cost it nothing but make us send an ACK for each. Connection should calm it down */
+TEST_CASE(h2_client_conn_err_ping_flood) {
+
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    /* fake peer sends one more PING than the default limit allows */
+    struct aws_http2_abuse_limits default_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE] = {0};
+    for (uint32_t i = 0; i < default_limits.max_ping_frames; ++i) {
+        struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, false /*ACK*/, opaque_data);
+        ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, false /*ACK*/, opaque_data);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* validate the connection completed with error */
+    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
+    ASSERT_INT_EQUALS(
+        AWS_ERROR_HTTP_PROTOCOL_ERROR, testing_channel_get_shutdown_error_code(&s_tester.testing_channel));
+
+    /* client should send GOAWAY(ENHANCE_YOUR_CALM) */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *goaway =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
+    ASSERT_NOT_NULL(goaway);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_ENHANCE_YOUR_CALM, goaway->error_code);
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+/* Check that the connection sent GOAWAY(ENHANCE_YOUR_CALM) to a peer that exceeded an abuse limit, and shut down */
+static int s_check_connection_calmed_peer_down(void) {
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
+    ASSERT_INT_EQUALS(
+        AWS_ERROR_HTTP_PROTOCOL_ERROR, testing_channel_get_shutdown_error_code(&s_tester.testing_channel));
+
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    struct h2_decoded_frame *goaway =
+        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
+    ASSERT_NOT_NULL(goaway);
+    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_ENHANCE_YOUR_CALM, goaway->error_code);
+    return AWS_OP_SUCCESS;
+}
+
+/* Send a GET request and return its stream-tester, with the request's HEADERS already decoded by the fake peer */
+static int s_send_get_request(struct client_stream_tester *stream_tester, struct aws_http_message **out_request) {
+    struct aws_http_message *request = aws_http2_message_new_request(s_tester.alloc);
+    ASSERT_NOT_NULL(request);
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+
+    ASSERT_SUCCESS(s_stream_tester_init(stream_tester, request));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    *out_request = request;
+    return AWS_OP_SUCCESS;
+}
+
+/* Client opted in to counting RST_STREAM. Peer keeps resetting a stream, which costs it nothing ("rapid reset") */
+TEST_CASE(h2_client_conn_err_rst_stream_flood) {
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_rst_stream_frames = 10;
+    s_tester.abuse_limits = &abuse_limits;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request(&stream_tester, &request));
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    /* Client resets the stream, so that further RST_STREAM frames from the peer are ignored, but still counted */
+    ASSERT_SUCCESS(aws_http2_stream_reset(stream_tester.stream, AWS_HTTP2_ERR_CANCEL));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    for (uint32_t i = 0; i < abuse_limits.max_rst_stream_frames; ++i) {
+        struct aws_h2_frame *peer_frame = aws_h2_frame_new_rst_stream(allocator, stream_id, AWS_HTTP2_ERR_CANCEL);
+        ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    struct aws_h2_frame *peer_frame = aws_h2_frame_new_rst_stream(allocator, stream_id, AWS_HTTP2_ERR_CANCEL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    ASSERT_SUCCESS(s_check_connection_calmed_peer_down());
+
+    /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
+/* With the default limits, a client doesn't count RST_STREAM frames at all */
+TEST_CASE(h2_client_rst_stream_not_counted_by_default) {
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request(&stream_tester, &request));
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    ASSERT_SUCCESS(aws_http2_stream_reset(stream_tester.stream, AWS_HTTP2_ERR_CANCEL));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    struct aws_http2_abuse_limits default_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    for (uint32_t i = 0; i < default_limits.max_rst_stream_frames + 1; ++i) {
+        struct aws_h2_frame *peer_frame = aws_h2_frame_new_rst_stream(allocator, stream_id, AWS_HTTP2_ERR_CANCEL);
+        ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
+/* Peer never ends a header block, and keeps sending empty CONTINUATION frames */
+TEST_CASE(h2_client_conn_err_continuation_flood) {
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_continuation_frames = 10;
+    s_tester.abuse_limits = &abuse_limits;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request(&stream_tester, &request));
+    ASSERT_UINT_EQUALS(1, aws_http_stream_get_id(stream_tester.stream));
+
+    /* HEADERS for stream 1 without END_HEADERS, carrying ":status: 200" (HPACK static table index 8) */
+    const uint8_t headers_frame[] = {0x00, 0x00, 0x01, AWS_H2_FRAME_T_HEADERS, 0x00, 0x00, 0x00, 0x00, 0x01, 0x88};
+    /* CONTINUATION for stream 1, with an empty header-block fragment and no END_HEADERS */
+    const uint8_t continuation_frame[] = {0x00, 0x00, 0x00, AWS_H2_FRAME_T_CONTINUATION, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+    ASSERT_SUCCESS(testing_channel_push_read_data(
+        &s_tester.testing_channel, aws_byte_cursor_from_array(headers_frame, sizeof(headers_frame))));
+    for (uint32_t i = 0; i < abuse_limits.max_continuation_frames; ++i) {
+        ASSERT_SUCCESS(testing_channel_push_read_data(
+            &s_tester.testing_channel, aws_byte_cursor_from_array(continuation_frame, sizeof(continuation_frame))));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    ASSERT_SUCCESS(testing_channel_push_read_data(
+        &s_tester.testing_channel, aws_byte_cursor_from_array(continuation_frame, sizeof(continuation_frame))));
+    ASSERT_SUCCESS(s_check_connection_calmed_peer_down());
+
+    /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
+/* Peer sends DATA frames that carry no data and don't end the stream. DATA frames with a payload aren't counted */
+TEST_CASE(h2_client_conn_err_empty_data_flood) {
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_empty_data_frames = 10;
+    s_tester.abuse_limits = &abuse_limits;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request(&stream_tester, &request));
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+
+    for (uint32_t i = 0; i < abuse_limits.max_empty_data_frames; ++i) {
+        ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, stream_id, "", false /*end_stream*/));
+        ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, stream_id, "a", false /*end_stream*/));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    ASSERT_SUCCESS(h2_fake_peer_send_data_frame_str(&s_tester.peer, stream_id, "", false /*end_stream*/));
+    ASSERT_SUCCESS(s_check_connection_calmed_peer_down());
+
+    /* clean up */
+    aws_http_headers_release(response_headers);
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return s_tester_clean_up();
+}
+
+/* Peer keeps changing settings, making us ACK each time. The connection preface's SETTINGS count too */
+TEST_CASE(h2_client_conn_err_settings_flood) {
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_settings_frames = 5;
+    s_tester.abuse_limits = &abuse_limits;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    struct aws_http2_setting settings[] = {
+        {.id = AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, .value = 100},
+    };
+    for (uint32_t i = 1; i < abuse_limits.max_settings_frames; ++i) {
+        struct aws_h2_frame *peer_frame =
+            aws_h2_frame_new_settings(allocator, settings, AWS_ARRAY_SIZE(settings), false /*ack*/);
+        ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    struct aws_h2_frame *peer_frame =
+        aws_h2_frame_new_settings(allocator, settings, AWS_ARRAY_SIZE(settings), false /*ack*/);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    ASSERT_SUCCESS(s_check_connection_calmed_peer_down());
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+/* A limit of zero disables that counter */
+TEST_CASE(h2_client_abuse_limit_zero_disables_counter) {
+    struct aws_http2_abuse_limits abuse_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    abuse_limits.max_ping_frames = 0;
+    s_tester.abuse_limits = &abuse_limits;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+
+    /* More PINGs than the default limit allows */
+    struct aws_http2_abuse_limits default_limits = AWS_HTTP2_DEFAULT_ABUSE_LIMITS_INIT;
+    uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE] = {0};
+    for (uint32_t i = 0; i < default_limits.max_ping_frames + 1; ++i) {
+        struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, false /*ACK*/, opaque_data);
+        ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* Every PING was still ACKed */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    size_t ack_count = 0;
+    for (size_t i = 0; i < h2_decode_tester_frame_count(&s_tester.peer.decode); ++i) {
+        struct h2_decoded_frame *frame = h2_decode_tester_get_frame(&s_tester.peer.decode, i);
+        if (frame->type == AWS_H2_FRAME_T_PING && frame->ack) {
+            ++ack_count;
+        }
+    }
+    ASSERT_UINT_EQUALS(default_limits.max_ping_frames + 1, ack_count);
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
+/* Gather the connection's statistics, the way a channel's statistics handler would */
+static int s_get_resident_bytes(uint64_t *out_resident_bytes) {
+    struct aws_array_list stats_list;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&stats_list, s_tester.alloc, 1, sizeof(void *)));
+
+    struct aws_channel_handler *handler = &s_tester.connection->channel_handler;
+    handler->vtable->gather_statistics(handler, &stats_list);
+    ASSERT_UINT_EQUALS(1, aws_array_list_length(&stats_list));
+
+    struct aws_crt_statistics_http2_channel *stats = NULL;
+    ASSERT_SUCCESS(aws_array_list_get_at(&stats_list, &stats, 0));
+    ASSERT_INT_EQUALS(AWSCRT_STAT_CAT_HTTP2_CHANNEL, stats->category);
+    *out_resident_bytes = stats->resident_bytes;
+
+    aws_array_list_clean_up(&stats_list);
+    return AWS_OP_SUCCESS;
+}
+
+/* The idle trim task only trims after a whole period without traffic, so it can take up to 2 periods */
+static int s_wait_for_idle_trim(uint64_t untrimmed_bytes) {
+    uint64_t resident_bytes = untrimmed_bytes;
+    for (size_t i = 0; i < 200 && resident_bytes >= untrimmed_bytes; ++i) {
+        aws_thread_current_sleep(aws_timestamp_convert(10, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+        ASSERT_SUCCESS(s_get_resident_bytes(&resident_bytes));
+    }
+    ASSERT_TRUE(resident_bytes < untrimmed_bytes);
+    return AWS_OP_SUCCESS;
+}
+
+/* Send a GET, have the peer respond with `response_headers`, and check they're what the client received */
+static int s_send_get_request_and_respond(struct aws_http_headers *response_headers) {
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request(&stream_tester, &request));
+
+    struct aws_h2_frame *response_frame = aws_h2_frame_new_headers(
+        s_tester.alloc, aws_http_stream_get_id(stream_tester.stream), response_headers, true /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_SUCCESS(s_compare_headers(response_headers, stream_tester.response_headers));
+
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    return AWS_OP_SUCCESS;
+}
+
+/* An idle connection releases HPACK scratch space and spare table capacity, but keeps the table's entries */
+TEST_CASE(h2_client_idle_trim) {
+    /* Long enough that the connection can't go idle while a request is being processed */
+    s_tester.idle_trim_ms = 50;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* A value longer than the HPACK decoder's initial scratch space makes it grow */
+    char long_value[1000];
+    memset(long_value, 'v', sizeof(long_value) - 1);
+    long_value[sizeof(long_value) - 1] = '\0';
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+        {
+            .name = aws_byte_cursor_from_c_str("x-long-header"),
+            .value = aws_byte_cursor_from_c_str(long_value),
+        },
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(
+        aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src)));
+
+    ASSERT_SUCCESS(s_send_get_request_and_respond(response_headers));
+    uint64_t untrimmed_bytes = 0;
+    ASSERT_SUCCESS(s_get_resident_bytes(&untrimmed_bytes));
+    ASSERT_SUCCESS(s_wait_for_idle_trim(untrimmed_bytes));
+
+    /* The peer's encoder now refers to the long header by its dynamic table index,
+     * so this only decodes correctly if the trimmed table kept its entries */
+    ASSERT_SUCCESS(s_send_get_request_and_respond(response_headers));
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* clean up */
+    aws_http_headers_release(response_headers);
+    return s_tester_clean_up();
+}
+
+/* Send a GET and have the peer respond with headers but no body yet */
+static int s_send_get_request_and_start_response(
+    struct client_stream_tester *stream_tester,
+    struct aws_http_message **out_request) {
+
+    ASSERT_SUCCESS(s_send_get_request(stream_tester, out_request));
+
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(s_tester.alloc);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame = aws_h2_frame_new_headers(
+        s_tester.alloc,
+        aws_http_stream_get_id(stream_tester->stream),
+        response_headers,
+        false /*end_stream*/,
+        0,
+        NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    aws_http_headers_release(response_headers);
+    return AWS_OP_SUCCESS;
+}
+
+/* Fake peer sends one DATA frame in its own message */
+static int s_push_data_frame(uint32_t stream_id, const char *data, bool end_stream) {
+    struct aws_byte_buf frame;
+    ASSERT_SUCCESS(aws_byte_buf_init(&frame, s_tester.alloc, AWS_H2_FRAME_PREFIX_SIZE + strlen(data)));
+    ASSERT_SUCCESS(s_write_raw_data_frame(&frame, stream_id, data, end_stream));
+    ASSERT_SUCCESS(testing_channel_push_read_data(&s_tester.testing_channel, aws_byte_cursor_from_buf(&frame)));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    aws_byte_buf_clean_up(&frame);
+    return AWS_OP_SUCCESS;
+}
+
+/* With a memory budget, the connection window isn't opened to the max, and isn't charged while it's open.
+ * Automatic WINDOW_UPDATEs only go out as far as the budget has room, the rest is sent once it frees up */
+TEST_CASE(h2_client_connection_window_with_memory_budget) {
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = AWS_H2_INIT_WINDOW_SIZE,
+        .retry_interval_ms = 1,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
+
+    /* Enable automatic connection window management, which the budget applies to */
+    s_tester.no_conn_manual_win_management = true;
+    s_tester.memory_budget = budget;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_UINT_EQUALS(0, s_sum_connection_window_updates(0));
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+
+    struct client_stream_tester stream_tester;
+    struct aws_http_message *request = NULL;
+    ASSERT_SUCCESS(s_send_get_request_and_start_response(&stream_tester, &request));
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+    size_t num_frames_before_body = h2_decode_tester_frame_count(&s_tester.peer.decode);
+
+    /* Body that's handed straight to the user isn't charged, and its window comes back while there's room */
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, "hello", false /*end_stream*/));
+    ASSERT_UINT_EQUALS(5, s_sum_connection_window_updates(num_frames_before_body));
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+
+    /* Something else fills the budget, so the window isn't replenished, and new requests are refused */
+    ASSERT_UINT_EQUALS(AWS_H2_INIT_WINDOW_SIZE, aws_http_memory_budget_reserve(budget, AWS_H2_INIT_WINDOW_SIZE));
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, "world", false /*end_stream*/));
+    ASSERT_UINT_EQUALS(5, s_sum_connection_window_updates(num_frames_before_body));
+
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = request,
+    };
+    ASSERT_NULL(aws_http_connection_make_request(s_tester.connection, &request_options));
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_MEMORY_BUDGET_EXHAUSTED, aws_last_error());
+
+    /* The connection asks again later, and the delayed WINDOW_UPDATE goes out once the budget frees up */
+    aws_thread_current_sleep(aws_timestamp_convert(2, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_UINT_EQUALS(5, s_sum_connection_window_updates(num_frames_before_body));
+
+    aws_http_memory_budget_unreserve(budget, AWS_H2_INIT_WINDOW_SIZE);
+    aws_thread_current_sleep(aws_timestamp_convert(2, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
-    /* validate that connection closed with error */
-    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
-    /* client should send GOAWAY */
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
-    struct h2_decoded_frame *goaway =
-        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
-    ASSERT_NOT_NULL(goaway);
-    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_INTERNAL_ERROR, goaway->error_code);
-    ASSERT_UINT_EQUALS(0, goaway->goaway_last_stream_id);
+    ASSERT_UINT_EQUALS(10, s_sum_connection_window_updates(num_frames_before_body));
+
+    /* The window was only ever replenished, never opened past its initial size */
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, "!", true /*end_stream*/));
+    ASSERT_UINT_EQUALS(11, s_sum_connection_window_updates(num_frames_before_body));
+
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
+    ASSERT_TRUE(aws_byte_buf_eq_c_str(&stream_tester.response_body, "helloworld!"));
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
 
     /* clean up */
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_memory_budget_release(budget);
     return s_tester_clean_up();
 }
 
-struct ping_user_data {
-    uint64_t rtt_ns;
-    int error_code;
-};
+/* A message kept alive by retained body data is charged to the memory budget until the data is released */
+TEST_CASE(h2_client_retained_body_charged_to_memory_budget) {
+    struct aws_http_memory_budget_options budget_options = {
+        .max_bytes = 1024 * 1024,
+    };
+    struct aws_http_memory_budget *budget = aws_http_memory_budget_new(allocator, &budget_options);
+    ASSERT_NOT_NULL(budget);
 
-static void on_ping_complete(
-    struct aws_http_connection *connection,
-    uint64_t round_trip_time_ns,
-    int error_code,
-    void *user_data) {
+    s_tester.no_conn_manual_win_management = true;
+    s_tester.memory_budget = budget;
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    (void)connection;
-    struct ping_user_data *data = user_data;
-    data->error_code = error_code;
-    data->rtt_ns = round_trip_time_ns;
-}
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
 
-/* Test the user API for PING successfully get the round trip time */
-TEST_CASE(h2_client_send_ping_successfully_receive_ack) {
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = s_tester.connection,
+        .use_retained_body = true,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
 
-    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
-    /* get connection preface and acks out of the way */
-    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    size_t num_frames_before_body = h2_decode_tester_frame_count(&s_tester.peer.decode);
 
-    struct aws_byte_cursor opaque_data = aws_byte_cursor_from_c_str("12345678");
-    struct ping_user_data data = {.rtt_ns = 0, .error_code = INT32_MAX};
-    /* client request a PING */
-    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, &opaque_data, on_ping_complete, &data));
+    /* The whole message holding the retained data is charged, and its window is withheld */
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, "hello", true /*end_stream*/));
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_UINT_EQUALS(1, stream_tester.num_retained_slices);
+    ASSERT_TRUE(aws_http_memory_budget_get_reserved(budget) >= AWS_H2_FRAME_PREFIX_SIZE + 5);
+    ASSERT_UINT_EQUALS(0, s_sum_connection_window_updates(num_frames_before_body));
+
+    /* Releasing the data returns the message to the budget, and the window to the peer */
+    ASSERT_SUCCESS(client_stream_tester_release_retained_body(&stream_tester));
+    ASSERT_TRUE(aws_byte_buf_eq_c_str(&stream_tester.response_body, "hello"));
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
-    /* check ping frame received */
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
-    struct h2_decoded_frame *ping_frame =
-        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_PING, 0, NULL);
-    ASSERT_BIN_ARRAYS_EQUALS(
-        opaque_data.ptr, AWS_HTTP2_PING_DATA_SIZE, ping_frame->ping_opaque_data, AWS_HTTP2_PING_DATA_SIZE);
-    ASSERT_FALSE(ping_frame->ack);
+    ASSERT_UINT_EQUALS(0, aws_http_memory_budget_get_reserved(budget));
+    ASSERT_UINT_EQUALS(5, s_sum_connection_window_updates(num_frames_before_body));
 
-    /* fake peer send PING ACK */
-    struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, ping_frame->ping_opaque_data);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
-    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
-    /* check callback fired, and succeed */
-    ASSERT_INT_EQUALS(0, data.error_code);
-    ASSERT_FALSE(data.rtt_ns == 0);
     /* clean up */
+    aws_http_headers_release(response_headers);
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_memory_budget_release(budget);
     return s_tester_clean_up();
 }
 
-/* Test the user request a PING, but peer never sends PING ACK back */
-TEST_CASE(h2_client_send_ping_no_ack_received) {
+/* Largest WINDOW_UPDATE increment for `stream_id`, starting at frame `idx` */
+static uint32_t s_max_window_update(uint32_t stream_id, size_t idx) {
+    uint32_t max = 0;
+    struct h2_decoded_frame *frame;
+    while ((frame = h2_decode_tester_find_stream_frame(
+                &s_tester.peer.decode, AWS_H2_FRAME_T_WINDOW_UPDATE, stream_id, idx, &idx)) != NULL) {
+        max = aws_max_u32(max, frame->window_size_increment);
+        ++idx;
+    }
+    return max;
+}
+
+/* With a send rate limiter, DATA frames are clamped to what the limiter allows,
+ * and the stream waits for the rate_limit_task to send the rest as the bucket refills */
+TEST_CASE(h2_client_stream_send_with_rate_limiter) {
+    /* 1000 bytes every 10ms, never more than 1000 at once */
+    struct aws_http_rate_limiter_options limiter_options = {
+        .bytes_per_second = 100000,
+        .burst_bytes = 1000,
+    };
+    struct aws_http_rate_limiter *limiter = aws_http_rate_limiter_new(allocator, &limiter_options);
+    ASSERT_NOT_NULL(limiter);
 
+    s_tester.send_rate_limiter = limiter;
     ASSERT_SUCCESS(s_tester_init(allocator, ctx));
-    /* get connection preface and acks out of the way */
     ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
-    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
 
-    struct ping_user_data data = {.rtt_ns = 0, .error_code = INT32_MAX};
-    /* client request a PING */
-    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, NULL, on_ping_complete, &data));
+    char body_data[3000];
+    memset(body_data, 'z', sizeof(body_data));
+    struct aws_byte_cursor body_cursor = aws_byte_cursor_from_array(body_data, sizeof(body_data));
+    struct aws_input_stream *request_body = aws_input_stream_new_from_cursor(allocator, &body_cursor);
+
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "PUT"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/paced.txt"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+    aws_http_message_set_body_stream(request, request_body);
+
+    uint64_t start_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start_ns));
+    struct client_stream_tester stream_tester;
+    ASSERT_SUCCESS(s_stream_tester_init(&stream_tester, request));
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
-    /* check ping frame received */
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
+
+    /* The full bucket is spent right away, in one DATA frame no bigger than the bucket */
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
-    struct h2_decoded_frame *ping_frame =
-        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_PING, 0, NULL);
-    uint8_t opaque_data[AWS_HTTP2_PING_DATA_SIZE];
-    AWS_ZERO_ARRAY(opaque_data);
-    /* Zeroed 8 bytes data received */
-    ASSERT_BIN_ARRAYS_EQUALS(
-        opaque_data, AWS_HTTP2_PING_DATA_SIZE, ping_frame->ping_opaque_data, AWS_HTTP2_PING_DATA_SIZE);
-    ASSERT_FALSE(ping_frame->ack);
+    size_t data_idx = 0;
+    struct h2_decoded_frame *data_frame = h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_DATA, stream_id, 0 /*idx*/, &data_idx);
+    ASSERT_NOT_NULL(data_frame);
+    ASSERT_UINT_EQUALS(limiter_options.burst_bytes, data_frame->data_payload_len);
+    ASSERT_FALSE(data_frame->end_stream);
+    ASSERT_NULL(h2_decode_tester_find_stream_frame(
+        &s_tester.peer.decode, AWS_H2_FRAME_T_DATA, stream_id, data_idx + 1, NULL));
+
+    /* The rest trickles out as the bucket refills */
+    size_t drains = 0;
+    bool end_stream = false;
+    while (!end_stream) {
+        ASSERT_TRUE(drains < 10000);
+        aws_thread_current_sleep(aws_timestamp_convert(1, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+        ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+        ++drains;
+
+        while ((data_frame = h2_decode_tester_find_stream_frame(
+                    &s_tester.peer.decode, AWS_H2_FRAME_T_DATA, stream_id, data_idx + 1, &data_idx)) != NULL) {
+            ASSERT_TRUE(data_frame->data_payload_len <= limiter_options.burst_bytes);
+            end_stream = data_frame->end_stream;
+        }
+    }
+    ASSERT_SUCCESS(h2_decode_tester_check_data_across_frames(
+        &s_tester.peer.decode, stream_id, body_cursor, true /*expect_end_stream*/));
+
+    /* That took two more refills, at 10ms each */
+    uint64_t end_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end_ns));
+    ASSERT_TRUE(end_ns - start_ns >= aws_timestamp_convert(20, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
 
-    /* shutdown the connection */
-    h2_fake_peer_clean_up(&s_tester.peer);
-    aws_http_connection_release(s_tester.connection);
-    ASSERT_SUCCESS(testing_channel_clean_up(&s_tester.testing_channel));
-    /* Check the callback has fired with error */
-    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_CONNECTION_CLOSED, data.error_code);
-    ASSERT_TRUE(data.rtt_ns == 0);
     /* clean up */
-    aws_http_library_clean_up();
-    return AWS_OP_SUCCESS;
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_input_stream_release(request_body);
+    aws_http_rate_limiter_release(limiter);
+    return s_tester_clean_up();
 }
 
-/* Test the user request a PING, but peer sends an extra PING ACK */
-TEST_CASE(h2_client_conn_err_extraneous_ping_ack_received) {
+/* With receive rate limiters, connection and stream WINDOW_UPDATEs go out no faster than the limiters allow.
+ * What's held back is sent by the rate_limit_task as the buckets refill */
+TEST_CASE(h2_client_stream_receive_with_rate_limiter) {
+    /* 1000 bytes every 10ms, never more than 1000 at once */
+    struct aws_http_rate_limiter_options limiter_options = {
+        .bytes_per_second = 100000,
+        .burst_bytes = 1000,
+    };
+    struct aws_http_rate_limiter *connection_limiter = aws_http_rate_limiter_new(allocator, &limiter_options);
+    ASSERT_NOT_NULL(connection_limiter);
+    struct aws_http_rate_limiter *stream_limiter = aws_http_rate_limiter_new(allocator, &limiter_options);
+    ASSERT_NOT_NULL(stream_limiter);
 
+    /* Enable automatic connection window management, so the connection's WINDOW_UPDATEs are paced */
+    s_tester.no_conn_manual_win_management = true;
+    s_tester.receive_rate_limiter = connection_limiter;
     ASSERT_SUCCESS(s_tester_init(allocator, ctx));
-    /* get connection preface and acks out of the way */
     ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* The connection window isn't opened to the max, since that would let the peer send without pacing */
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_UINT_EQUALS(0, s_sum_connection_window_updates(0));
 
-    struct aws_byte_cursor opaque_data = aws_byte_cursor_from_c_str("12345678");
-    /* client request a PING */
-    ASSERT_SUCCESS(aws_http2_connection_ping(s_tester.connection, &opaque_data, NULL, NULL));
-    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
 
-    struct aws_h2_frame *peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, opaque_data.ptr);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
-    /* fake peer send an extra PING ACK */
-    peer_frame = aws_h2_frame_new_ping(allocator, true /*ACK*/, opaque_data.ptr);
-    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, peer_frame));
+    struct client_stream_tester stream_tester;
+    struct client_stream_tester_options options = {
+        .request = request,
+        .connection = s_tester.connection,
+        .receive_rate_limiter = stream_limiter,
+    };
+    ASSERT_SUCCESS(client_stream_tester_init(&stream_tester, allocator, &options));
     testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    uint32_t stream_id = aws_http_stream_get_id(stream_tester.stream);
 
-    /* validate the connection completed with error */
-    ASSERT_FALSE(aws_http_connection_is_open(s_tester.connection));
-    ASSERT_INT_EQUALS(
-        AWS_ERROR_HTTP_PROTOCOL_ERROR, testing_channel_get_shutdown_error_code(&s_tester.testing_channel));
-
-    /* client should send GOAWAY */
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, stream_id, response_headers, false /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
     ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
-    struct h2_decoded_frame *goaway =
-        h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL);
-    ASSERT_NOT_NULL(goaway);
-    ASSERT_UINT_EQUALS(AWS_HTTP2_ERR_PROTOCOL_ERROR, goaway->error_code);
-    ASSERT_UINT_EQUALS(0, goaway->goaway_last_stream_id);
+    size_t num_frames_before_body = h2_decode_tester_frame_count(&s_tester.peer.decode);
+
+    /* Peer sends 3000 bytes of body, the full buckets give back 1000 of window right away */
+    char body[3001];
+    memset(body, 'b', sizeof(body) - 1);
+    body[sizeof(body) - 1] = '\0';
+    uint64_t start_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start_ns));
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, body, false /*end_stream*/));
+    ASSERT_UINT_EQUALS(3000, stream_tester.response_body.len);
+    ASSERT_UINT_EQUALS(limiter_options.burst_bytes, s_sum_connection_window_updates(num_frames_before_body));
+    ASSERT_UINT_EQUALS(limiter_options.burst_bytes, s_sum_window_updates(stream_id, num_frames_before_body));
+
+    /* The rest goes out as the buckets refill */
+    size_t drains = 0;
+    while (s_sum_connection_window_updates(num_frames_before_body) < 3000 ||
+           s_sum_window_updates(stream_id, num_frames_before_body) < 3000) {
+        ASSERT_TRUE(drains < 10000);
+        aws_thread_current_sleep(aws_timestamp_convert(1, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+        ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+        ++drains;
+    }
+    ASSERT_UINT_EQUALS(3000, s_sum_connection_window_updates(num_frames_before_body));
+    ASSERT_UINT_EQUALS(3000, s_sum_window_updates(stream_id, num_frames_before_body));
+    ASSERT_TRUE(s_max_window_update(0 /*stream_id*/, num_frames_before_body) <= limiter_options.burst_bytes);
+    ASSERT_TRUE(s_max_window_update(stream_id, num_frames_before_body) <= limiter_options.burst_bytes);
+
+    /* That took two more refills, at 10ms each */
+    uint64_t end_ns = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end_ns));
+    ASSERT_TRUE(end_ns - start_ns >= aws_timestamp_convert(20, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+
+    /* Once the peer is done sending, nothing more is owed on the stream */
+    ASSERT_SUCCESS(s_push_data_frame(stream_id, "", true /*end_stream*/));
+    ASSERT_TRUE(stream_tester.complete);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, stream_tester.on_complete_error_code);
 
     /* clean up */
+    aws_http_headers_release(response_headers);
+    aws_http_message_release(request);
+    client_stream_tester_clean_up(&stream_tester);
+    aws_http_rate_limiter_release(stream_limiter);
+    aws_http_rate_limiter_release(connection_limiter);
     return s_tester_clean_up();
 }
 
@@ -5422,6 +6698,70 @@ TEST_CASE(h2_client_manual_data_write) {
     return s_tester_clean_up();
 }
 
+/* Test that a manual-write stream parked on a stalled write's body is woken by a new write,
+ * not only by a body-ready notification */
+TEST_CASE(h2_client_manual_data_write_wakes_stream_waiting_for_body) {
+
+    ASSERT_SUCCESS(s_tester_init(allocator, ctx));
+    /* get connection preface and acks out of the way */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "POST"),
+        DEFINE_HEADER(":scheme", "https"),
+        DEFINE_HEADER(":path", "/"),
+    };
+    aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src));
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = request,
+        .http2_use_manual_data_writes = true,
+        .use_body_ready_notifications = true,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(s_tester.connection, &request_options);
+    ASSERT_NOT_NULL(stream);
+
+    aws_http_stream_activate(stream);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    uint32_t stream_id = aws_http_stream_get_id(stream);
+
+    /* The first write's body stalls, so the stream parks waiting for it */
+    const char *body_src = "hello";
+    struct aws_input_stream *first_body = aws_input_stream_new_tester(allocator, aws_byte_cursor_from_c_str(body_src));
+    aws_input_stream_tester_set_max_bytes_per_read(first_body, 0);
+    struct aws_http2_stream_write_data_options first_write = {
+        .data = first_body,
+    };
+    ASSERT_SUCCESS(aws_http2_stream_write_data(stream, &first_write));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_NULL(h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_DATA, 0 /*search_start_idx*/, NULL));
+
+    /* The body has data now, but nobody notifies. The final write alone must wake the stream */
+    aws_input_stream_tester_set_max_bytes_per_read(first_body, SIZE_MAX);
+    struct aws_http2_stream_write_data_options last_write = {.end_stream = true};
+    ASSERT_SUCCESS(aws_http2_stream_write_data(stream, &last_write));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_SUCCESS(
+        h2_decode_tester_check_data_str_across_frames(&s_tester.peer.decode, stream_id, body_src, true /*end_stream*/));
+
+    aws_input_stream_release(first_body);
+    aws_http_message_release(request);
+    aws_http_stream_release(stream);
+
+    /* close the connection */
+    aws_http_connection_close(s_tester.connection);
+
+    /* clean up */
+    return s_tester_clean_up();
+}
+
 TEST_CASE(h2_client_manual_data_write_not_enabled) {
 
     ASSERT_SUCCESS(s_tester_init(allocator, ctx));
@@ -681,6 +681,120 @@ H2_DECODER_ON_SERVER_TEST(h2_decoder_headers_cookies) {
     return AWS_OP_SUCCESS;
 }
 
+/* Trimming releases buffers that only matter mid-frame, but keeps the HPACK dynamic table's entries */
+H2_DECODER_ON_SERVER_TEST(h2_decoder_trim) {
+    (void)allocator;
+    struct fixture *fixture = ctx;
+
+    /* clang-format off */
+    uint8_t input[] = {
+        /* SETTINGS FRAME */
+        0x00, 0x00, 12,             /* Length (24) */
+        AWS_H2_FRAME_T_SETTINGS,    /* Type (8) */
+        0x00,                       /* Flags (8) */
+        0x00, 0x00, 0x00, 0x00,     /* Reserved (1) | Stream Identifier (31) */
+        /* SETTINGS */
+        0x00, 0x03, 0x00, 0x00, 0x00, 0x64, /* MAX_CONCURRENT_STREAMS (16): 100 (32) */
+        0x00, 0x04, 0x00, 0x00, 0xFF, 0xFF, /* INITIAL_WINDOW_SIZE (16): 65535 (32) */
+
+        /* HEADERS FRAME */
+        0x00, 0x00, 17,             /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS | AWS_H2_FRAME_F_END_STREAM, /* Flags (8) */
+        0x00, 0x00, 0x00, 0x01,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x82,                       /* ":method: GET" - indexed */
+        0x60, 0x03, 'a', '=', 'b',  /* "cookie: a=b" - indexed name, uncompressed value, added to dynamic table */
+        0x7a, 0x04, 't', 'e', 's', 't', /* "user-agent: test" - indexed name, added to dynamic table */
+        0x60, 0x03, 'c', '=', 'd',  /* "cookie: c=d" - indexed name, uncompressed value, added to dynamic table */
+    };
+
+    uint8_t input_after_trim[] = {
+        /* HEADERS FRAME */
+        0x00, 0x00, 3,              /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS | AWS_H2_FRAME_F_END_STREAM, /* Flags (8) */
+        0x00, 0x00, 0x00, 0x03,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x82,                       /* ":method: GET" - indexed */
+        0xbf,                       /* "user-agent: test" - indexed from dynamic table */
+        0xbe,                       /* "cookie: c=d" - indexed from dynamic table */
+    };
+    /* clang-format on */
+
+    ASSERT_H2ERR_SUCCESS(s_decode_all(fixture, aws_byte_cursor_from_array(input, sizeof(input))));
+    struct h2_decoded_frame *frame = h2_decode_tester_latest_frame(&fixture->decode);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_HEADERS, 1 /*stream_id*/));
+    ASSERT_UINT_EQUALS(3, aws_http_headers_count(frame->headers));
+    ASSERT_SUCCESS(s_check_header(frame, 2, "cookie", "a=b; c=d", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+
+    size_t untrimmed_bytes = aws_h2_decoder_get_resident_bytes(fixture->decode.decoder);
+    ASSERT_SUCCESS(aws_h2_decoder_trim(fixture->decode.decoder));
+    ASSERT_TRUE(aws_h2_decoder_get_resident_bytes(fixture->decode.decoder) < untrimmed_bytes);
+
+    /* Trimming twice is harmless */
+    ASSERT_SUCCESS(aws_h2_decoder_trim(fixture->decode.decoder));
+
+    ASSERT_H2ERR_SUCCESS(s_decode_all(fixture, aws_byte_cursor_from_array(input_after_trim, sizeof(input_after_trim))));
+    frame = h2_decode_tester_latest_frame(&fixture->decode);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_HEADERS, 3 /*stream_id*/));
+    ASSERT_UINT_EQUALS(3, aws_http_headers_count(frame->headers));
+    ASSERT_SUCCESS(s_check_header(frame, 0, ":method", "GET", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_SUCCESS(s_check_header(frame, 1, "user-agent", "test", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_SUCCESS(s_check_header(frame, 2, "cookie", "c=d", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+
+    /* Settings still decode after their buffer was released */
+    ASSERT_H2ERR_SUCCESS(s_decode_all(fixture, aws_byte_cursor_from_array(input, 21)));
+    frame = h2_decode_tester_latest_frame(&fixture->decode);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_SETTINGS, 0 /*stream_id*/));
+    ASSERT_UINT_EQUALS(2, aws_array_list_length(&frame->settings));
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Trimming in the middle of a header-block must not lose the cookies gathered so far */
+H2_DECODER_ON_SERVER_TEST(h2_decoder_trim_mid_header_block) {
+    (void)allocator;
+    struct fixture *fixture = ctx;
+
+    /* clang-format off */
+    uint8_t headers_input[] = {
+        /* HEADERS FRAME */
+        0x00, 0x00, 0x06,           /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_STREAM,  /* Flags (8) */
+        0x00, 0x00, 0x00, 0x01,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x82,                       /* ":method: GET" - indexed */
+        0x60, 0x03, 'a', '=', 'b',  /* "cookie: a=b" - indexed name, uncompressed value */
+    };
+
+    uint8_t continuation_input[] = {
+        /* CONTINUATION FRAME */
+        0x00, 0x00, 0x05,           /* Length (24) */
+        AWS_H2_FRAME_T_CONTINUATION,/* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS, /* Flags (8) */
+        0x00, 0x00, 0x00, 0x01,     /* Reserved (1) | Stream Identifier (31) */
+        /* PAYLOAD */
+        0x60, 0x03, 'c', '=', 'd',  /* "cookie: c=d" - indexed name, uncompressed value */
+    };
+    /* clang-format on */
+
+    ASSERT_H2ERR_SUCCESS(s_decode_all(fixture, aws_byte_cursor_from_array(headers_input, sizeof(headers_input))));
+    ASSERT_SUCCESS(aws_h2_decoder_trim(fixture->decode.decoder));
+    ASSERT_H2ERR_SUCCESS(
+        s_decode_all(fixture, aws_byte_cursor_from_array(continuation_input, sizeof(continuation_input))));
+
+    struct h2_decoded_frame *frame = h2_decode_tester_latest_frame(&fixture->decode);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_HEADERS, 1 /*stream_id*/));
+    ASSERT_UINT_EQUALS(2, aws_http_headers_count(frame->headers));
+    ASSERT_SUCCESS(s_check_header(frame, 0, ":method", "GET", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_SUCCESS(s_check_header(frame, 1, "cookie", "a=b; c=d", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_TRUE(frame->end_stream);
+
+    return AWS_OP_SUCCESS;
+}
+
 /* A trailing header has no pseudo-headers, and always ends the stream */
 H2_DECODER_ON_CLIENT_TEST(h2_decoder_headers_trailer) {
     (void)allocator;
@@ -874,6 +988,56 @@ H2_DECODER_ON_CLIENT_TEST(h2_decoder_malformed_headers_illegal_name) {
     return AWS_OP_SUCCESS;
 }
 
+/* Going over SETTINGS_MAX_HEADER_LIST_SIZE is a Stream Error, like a malformed message.
+ * Fields stop being delivered as soon as it goes over, but the rest of the block must still update the dynamic table */
+H2_DECODER_ON_CLIENT_TEST(h2_decoder_headers_exceed_max_header_list_size) {
+    (void)allocator;
+    struct fixture *fixture = ctx;
+
+    /* Each field counts its name, its value, and 32 bytes */
+    aws_h2_decoder_set_setting_max_header_list_size(fixture->decode.decoder, 80);
+
+    /* clang-format off */
+    uint8_t input[] = {
+        0x00, 0x00, 27,                 /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,         /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS | AWS_H2_FRAME_F_END_STREAM, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x10,         /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x48, 0x03, '3', '0', '2',      /* ":status: 302" - indexed name, uncompressed value. Size 42 */
+        0x40, 0x01, 'x', 0x01, 'a',     /* "x: a" - literal with incremental indexing. Size 76 so far */
+        0x40, 0x05, 'x', '-', 'b', 'i', 'g', /* "x-big: 0123456789" - literal with incremental indexing */
+        0x0a, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', /* Size 123 so far, too big */
+
+        0x00, 0x00, 2,                  /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,         /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS | AWS_H2_FRAME_F_END_STREAM, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x12,         /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x88,                           /* ":status: 200" - indexed. Size 42 */
+        0xbf,                           /* "x: a" - indexed, past "x-big" in the dynamic table. Size 76 */
+    };
+    /* clang-format on */
+
+    /* Decode */
+    ASSERT_H2ERR_SUCCESS(s_decode_all(fixture, aws_byte_cursor_from_array(input, sizeof(input))));
+
+    /* Validate */
+    ASSERT_UINT_EQUALS(2, h2_decode_tester_frame_count(&fixture->decode));
+    struct h2_decoded_frame *frame = h2_decode_tester_get_frame(&fixture->decode, 0);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_HEADERS, 0x76543210 /*stream_id*/));
+    ASSERT_TRUE(frame->headers_malformed);
+    ASSERT_UINT_EQUALS(2, aws_http_headers_count(frame->headers));
+
+    frame = h2_decode_tester_get_frame(&fixture->decode, 1);
+    ASSERT_SUCCESS(h2_decoded_frame_check_finished(frame, AWS_H2_FRAME_T_HEADERS, 0x76543212 /*stream_id*/));
+    ASSERT_FALSE(frame->headers_malformed);
+    ASSERT_UINT_EQUALS(2, aws_http_headers_count(frame->headers));
+    ASSERT_SUCCESS(s_check_header(frame, 0, ":status", "200", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_SUCCESS(s_check_header(frame, 1, "x", "a", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    return AWS_OP_SUCCESS;
+}
+
 /* Message is malformed if server receives a response.
  * A malformed message is a Stream Error, not a Connection Error, so the decoder should continue */
 H2_DECODER_ON_SERVER_TEST(h2_decoder_malformed_headers_response_to_server) {
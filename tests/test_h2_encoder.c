@@ -5,6 +5,7 @@
 #include "h2_test_helper.h"
 #include <aws/testing/aws_test_harness.h>
 
+#include <aws/http/private/h2_decoder.h>
 #include <aws/http/private/h2_frames.h>
 #include <aws/io/stream.h>
 
@@ -396,6 +397,328 @@ TEST_CASE(h2_encoder_push_promise) {
     return AWS_OP_SUCCESS;
 }
 
+/* Encode the frame into as many empty messages of message_size as it takes,
+ * and check that together they hold the expected bytes */
+static int s_encode_frame_in_messages(
+    struct aws_allocator *allocator,
+    struct aws_h2_frame_encoder *encoder,
+    struct aws_h2_frame *frame,
+    size_t message_size,
+    const uint8_t *expected,
+    size_t expected_size) {
+
+    struct aws_byte_buf all_messages;
+    ASSERT_SUCCESS(aws_byte_buf_init(&all_messages, allocator, expected_size));
+    struct aws_byte_buf message;
+    ASSERT_SUCCESS(aws_byte_buf_init(&message, allocator, message_size));
+
+    bool frame_complete = false;
+    while (!frame_complete) {
+        aws_byte_buf_reset(&message, false /*zero_contents*/);
+        ASSERT_SUCCESS(aws_h2_encode_frame(encoder, frame, &message, &frame_complete));
+        /* An empty message must always make progress */
+        ASSERT_TRUE(message.len > 0);
+        struct aws_byte_cursor message_cursor = aws_byte_cursor_from_buf(&message);
+        ASSERT_SUCCESS(aws_byte_buf_append_dynamic(&all_messages, &message_cursor));
+    }
+    ASSERT_BIN_ARRAYS_EQUALS(expected, expected_size, all_messages.buffer, all_messages.len);
+
+    aws_byte_buf_clean_up(&message);
+    aws_byte_buf_clean_up(&all_messages);
+    return AWS_OP_SUCCESS;
+}
+
+/* A header with a header-block that's easy to write out by hand when huffman encoding is off:
+ * 0x00 (literal without indexing, new name), then the name and value as plain strings. 29 bytes in all. */
+static struct aws_http_headers *s_new_fill_headers(struct aws_allocator *allocator) {
+    struct aws_http_header fill = DEFINE_STATIC_HEADER("x-fill", "0123456789abcdefghij", NO_CACHE);
+    struct aws_http_headers *headers = aws_http_headers_new(allocator);
+    AWS_FATAL_ASSERT(headers);
+    AWS_FATAL_ASSERT(aws_http_headers_add_header(headers, &fill) == AWS_OP_SUCCESS);
+    return headers;
+}
+
+/* A header-block that would fit in an empty message waits for one, instead of being split across messages */
+TEST_CASE(h2_encoder_headers_waits_for_empty_message) {
+    (void)ctx;
+
+    struct aws_h2_frame_encoder encoder;
+    ASSERT_SUCCESS(aws_h2_frame_encoder_init(&encoder, allocator, NULL /*logging_id*/));
+    aws_hpack_encoder_set_huffman_mode(&encoder.hpack, AWS_HPACK_HUFFMAN_NEVER);
+
+    struct aws_http_headers *headers = s_new_fill_headers(allocator);
+    struct aws_h2_frame *frame = aws_h2_frame_new_headers(
+        allocator, 0x76543210 /*stream_id*/, headers, false /*end_stream*/, 0 /*pad_length*/, NULL /*priority*/);
+    ASSERT_NOT_NULL(frame);
+
+    /* The message already has something in it, and too little room left for the frame */
+    struct aws_byte_buf message;
+    ASSERT_SUCCESS(aws_byte_buf_init(&message, allocator, 64));
+    ASSERT_TRUE(aws_byte_buf_write_u8_n(&message, 0xAA, 30));
+
+    bool frame_complete;
+    ASSERT_SUCCESS(aws_h2_encode_frame(&encoder, frame, &message, &frame_complete));
+    ASSERT_FALSE(frame_complete);
+    ASSERT_UINT_EQUALS(30, message.len);
+
+    /* clang-format off */
+    uint8_t expected[] = {
+        0x00, 0x00, 29,             /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x10,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x00, 0x06, 'x', '-', 'f', 'i', 'l', 'l',
+        0x14, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
+    };
+    /* clang-format on */
+
+    /* The next message is empty, so the whole frame goes in it */
+    aws_byte_buf_reset(&message, false /*zero_contents*/);
+    ASSERT_SUCCESS(aws_h2_encode_frame(&encoder, frame, &message, &frame_complete));
+    ASSERT_TRUE(frame_complete);
+    ASSERT_BIN_ARRAYS_EQUALS(expected, sizeof(expected), message.buffer, message.len);
+
+    aws_byte_buf_clean_up(&message);
+    aws_h2_frame_destroy(frame);
+    aws_http_headers_release(headers);
+    aws_h2_frame_encoder_clean_up(&encoder);
+    return AWS_OP_SUCCESS;
+}
+
+/* A header-block too big for even an empty message is pre-encoded, and sent in HEADERS and CONTINUATION frames */
+TEST_CASE(h2_encoder_headers_split_across_messages) {
+    (void)ctx;
+
+    struct aws_h2_frame_encoder encoder;
+    ASSERT_SUCCESS(aws_h2_frame_encoder_init(&encoder, allocator, NULL /*logging_id*/));
+    aws_hpack_encoder_set_huffman_mode(&encoder.hpack, AWS_HPACK_HUFFMAN_NEVER);
+
+    struct aws_http_headers *headers = s_new_fill_headers(allocator);
+    struct aws_h2_frame_priority_settings priority = {
+        .stream_dependency_exclusive = true,
+        .stream_dependency = 0x01234567,
+        .weight = 9,
+    };
+    struct aws_h2_frame *frame = aws_h2_frame_new_headers(
+        allocator, 0x76543210 /*stream_id*/, headers, true /*end_stream*/, 2 /*pad_length*/, &priority);
+    ASSERT_NOT_NULL(frame);
+
+    /* clang-format off */
+    uint8_t expected[] = {
+        /* First message */
+        0x00, 0x00, 28,             /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_STREAM | AWS_H2_FRAME_F_PADDED | AWS_H2_FRAME_F_PRIORITY, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x10,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x02,                       /* Pad Length (8)                           - F_PADDED */
+        0x81, 0x23, 0x45, 0x67,     /* Exclusive (1) | Stream Dependency (31)   - F_PRIORITY*/
+        0x09,                       /* Weight (8)                               - F_PRIORITY */
+        0x00, 0x06, 'x', '-', 'f', 'i', 'l', 'l',    /* Header Block Fragment (*) */
+        0x14, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
+        0x00, 0x00,                 /* Padding (*)                              - F_PADDED */
+
+        /* Second message */
+        0x00, 0x00, 9,              /* Length (24) */
+        AWS_H2_FRAME_T_CONTINUATION,/* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x10,     /* Reserved (1) | Stream Identifier (31) */
+        /* CONTINUATION */
+        'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', /* Header Block Fragment (*) */
+    };
+    /* clang-format on */
+
+    /* Room for 20 bytes of the 29 byte header-block in the HEADERS frame */
+    ASSERT_SUCCESS(s_encode_frame_in_messages(allocator, &encoder, frame, 37, expected, sizeof(expected)));
+
+    aws_h2_frame_destroy(frame);
+    aws_http_headers_release(headers);
+    aws_h2_frame_encoder_clean_up(&encoder);
+    return AWS_OP_SUCCESS;
+}
+
+TEST_CASE(h2_encoder_push_promise_split_across_messages) {
+    (void)ctx;
+
+    struct aws_h2_frame_encoder encoder;
+    ASSERT_SUCCESS(aws_h2_frame_encoder_init(&encoder, allocator, NULL /*logging_id*/));
+    aws_hpack_encoder_set_huffman_mode(&encoder.hpack, AWS_HPACK_HUFFMAN_NEVER);
+
+    struct aws_http_headers *headers = s_new_fill_headers(allocator);
+    struct aws_h2_frame *frame = aws_h2_frame_new_push_promise(
+        allocator, 0x00000001 /*stream_id*/, 0x76543210 /*promised_stream_id*/, headers, 2 /*pad_length*/);
+    ASSERT_NOT_NULL(frame);
+
+    /* clang-format off */
+    uint8_t expected[] = {
+        /* First message */
+        0x00, 0x00, 27,             /* Length (24) */
+        AWS_H2_FRAME_T_PUSH_PROMISE,/* Type (8) */
+        AWS_H2_FRAME_F_PADDED,      /* Flags (8) */
+        0x00, 0x00, 0x00, 0x01,     /* Reserved (1) | Stream Identifier (31) */
+        /* PUSH_PROMISE */
+        0x02,                       /* Pad Length (8)                           | F_PADDED */
+        0x76, 0x54, 0x32, 0x10,     /* Reserved (1) | Promised Stream ID (31) */
+        0x00, 0x06, 'x', '-', 'f', 'i', 'l', 'l',    /* Header Block Fragment (*) */
+        0x14, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
+        0x00, 0x00,                 /* Padding (*)                              | F_PADDED*/
+
+        /* Second message */
+        0x00, 0x00, 9,              /* Length (24) */
+        AWS_H2_FRAME_T_CONTINUATION,/* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS, /* Flags (8) */
+        0x00, 0x00, 0x00, 0x01,     /* Reserved (1) | Stream Identifier (31) */
+        /* CONTINUATION */
+        'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', /* Header Block Fragment (*) */
+    };
+    /* clang-format on */
+
+    /* Room for 20 bytes of the 29 byte header-block in the PUSH_PROMISE frame */
+    ASSERT_SUCCESS(s_encode_frame_in_messages(allocator, &encoder, frame, 36, expected, sizeof(expected)));
+
+    aws_h2_frame_destroy(frame);
+    aws_http_headers_release(headers);
+    aws_h2_frame_encoder_clean_up(&encoder);
+    return AWS_OP_SUCCESS;
+}
+
+/* A pending dynamic table size update goes at the start of the header-block, and counts towards the space needed */
+TEST_CASE(h2_encoder_headers_with_table_size_update) {
+    (void)ctx;
+
+    struct aws_h2_frame_encoder encoder;
+    ASSERT_SUCCESS(aws_h2_frame_encoder_init(&encoder, allocator, NULL /*logging_id*/));
+    aws_hpack_encoder_set_huffman_mode(&encoder.hpack, AWS_HPACK_HUFFMAN_NEVER);
+    aws_hpack_encoder_update_max_table_size(&encoder.hpack, 0);
+    aws_hpack_encoder_update_max_table_size(&encoder.hpack, 4096);
+
+    struct aws_http_headers *headers = s_new_fill_headers(allocator);
+    struct aws_h2_frame *frame = aws_h2_frame_new_headers(
+        allocator, 0x76543210 /*stream_id*/, headers, false /*end_stream*/, 0 /*pad_length*/, NULL /*priority*/);
+    ASSERT_NOT_NULL(frame);
+
+    /* clang-format off */
+    uint8_t expected[] = {
+        0x00, 0x00, 33,             /* Length (24) */
+        AWS_H2_FRAME_T_HEADERS,     /* Type (8) */
+        AWS_H2_FRAME_F_END_HEADERS, /* Flags (8) */
+        0x76, 0x54, 0x32, 0x10,     /* Reserved (1) | Stream Identifier (31) */
+        /* HEADERS */
+        0x20,                       /* Dynamic Table Size Update: 0 */
+        0x3f, 0xe1, 0x1f,           /* Dynamic Table Size Update: 4096 */
+        0x00, 0x06, 'x', '-', 'f', 'i', 'l', 'l',
+        0x14, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
+    };
+    /* clang-format on */
+
+    /* With huffman off, the max length is exact, so a message with just enough room takes the whole frame */
+    ASSERT_SUCCESS(
+        s_encode_frame_in_messages(allocator, &encoder, frame, sizeof(expected), expected, sizeof(expected)));
+
+    aws_h2_frame_destroy(frame);
+    aws_http_headers_release(headers);
+    aws_h2_frame_encoder_clean_up(&encoder);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_check_decoded_headers(const struct h2_decoded_frame *frame, const struct aws_http_headers *expected) {
+    ASSERT_UINT_EQUALS(aws_http_headers_count(expected), aws_http_headers_count(frame->headers));
+    for (size_t i = 0; i < aws_http_headers_count(expected); ++i) {
+        struct aws_http_header expected_header;
+        ASSERT_SUCCESS(aws_http_headers_get_index(expected, i, &expected_header));
+        struct aws_http_header header;
+        ASSERT_SUCCESS(aws_http_headers_get_index(frame->headers, i, &header));
+        ASSERT_BIN_ARRAYS_EQUALS(expected_header.name.ptr, expected_header.name.len, header.name.ptr, header.name.len);
+        ASSERT_BIN_ARRAYS_EQUALS(
+            expected_header.value.ptr, expected_header.value.len, header.value.ptr, header.value.len);
+    }
+    return AWS_OP_SUCCESS;
+}
+
+/* Each huffman mode encodes straight into a message with just the room the max length asks for,
+ * and also when split across small messages. Both must decode back to the same headers. */
+TEST_CASE(h2_encoder_headers_huffman_modes) {
+    (void)ctx;
+
+    struct aws_http_header headers_array[] = {
+        DEFINE_STATIC_HEADER(":status", "200", USE_CACHE),
+        DEFINE_STATIC_HEADER("content-type", "text/html", USE_CACHE),
+        /* Every one of these has a huffman code longer than 8 bits, so huffman makes the value bigger */
+        DEFINE_STATIC_HEADER("x-symbols", "{}<>^`|~", USE_CACHE),
+        DEFINE_STATIC_HEADER("x-secret", "hunter2", NO_FORWARD_CACHE),
+        DEFINE_STATIC_HEADER("x-empty", "", NO_CACHE),
+    };
+    struct aws_http_headers *headers = aws_http_headers_new(allocator);
+    ASSERT_NOT_NULL(headers);
+    ASSERT_SUCCESS(aws_http_headers_add_array(headers, headers_array, AWS_ARRAY_SIZE(headers_array)));
+
+    const enum aws_hpack_huffman_mode modes[] = {
+        AWS_HPACK_HUFFMAN_NEVER,
+        AWS_HPACK_HUFFMAN_SMALLEST,
+        AWS_HPACK_HUFFMAN_ALWAYS,
+    };
+    for (size_t mode_i = 0; mode_i < AWS_ARRAY_SIZE(modes); ++mode_i) {
+        struct aws_h2_frame_encoder encoder;
+        ASSERT_SUCCESS(aws_h2_frame_encoder_init(&encoder, allocator, NULL /*logging_id*/));
+        aws_hpack_encoder_set_huffman_mode(&encoder.hpack, modes[mode_i]);
+
+        struct h2_decode_tester decode;
+        struct h2_decode_tester_options decode_options = {
+            .alloc = allocator,
+            .skip_connection_preface = true,
+        };
+        ASSERT_SUCCESS(h2_decode_tester_init(&decode, &decode_options));
+
+        struct aws_byte_buf message;
+        AWS_ZERO_STRUCT(message);
+
+        /* First directly, into a message with just enough room. Dynamic table entries get inserted. */
+        const size_t max_block_length = aws_hpack_get_encoded_header_block_max_length(&encoder.hpack, headers);
+        ASSERT_SUCCESS(aws_byte_buf_init(&message, allocator, AWS_H2_FRAME_PREFIX_SIZE + max_block_length));
+        struct aws_h2_frame *frame = aws_h2_frame_new_headers(
+            allocator, 1 /*stream_id*/, headers, true /*end_stream*/, 0 /*pad_length*/, NULL /*priority*/);
+        ASSERT_NOT_NULL(frame);
+        bool frame_complete;
+        ASSERT_SUCCESS(aws_h2_encode_frame(&encoder, frame, &message, &frame_complete));
+        ASSERT_TRUE(frame_complete);
+        aws_h2_frame_destroy(frame);
+
+        struct aws_byte_cursor message_cursor = aws_byte_cursor_from_buf(&message);
+        ASSERT_H2ERR_SUCCESS(aws_h2_decode(decode.decoder, &message_cursor));
+        aws_byte_buf_clean_up(&message);
+
+        /* Then split into HEADERS and CONTINUATION frames, using the dynamic table entries */
+        ASSERT_SUCCESS(aws_byte_buf_init(&message, allocator, AWS_H2_FRAME_PREFIX_SIZE + 10));
+        frame = aws_h2_frame_new_headers(
+            allocator, 3 /*stream_id*/, headers, true /*end_stream*/, 0 /*pad_length*/, NULL /*priority*/);
+        ASSERT_NOT_NULL(frame);
+        frame_complete = false;
+        while (!frame_complete) {
+            aws_byte_buf_reset(&message, false /*zero_contents*/);
+            ASSERT_SUCCESS(aws_h2_encode_frame(&encoder, frame, &message, &frame_complete));
+            message_cursor = aws_byte_cursor_from_buf(&message);
+            ASSERT_H2ERR_SUCCESS(aws_h2_decode(decode.decoder, &message_cursor));
+        }
+        aws_h2_frame_destroy(frame);
+        aws_byte_buf_clean_up(&message);
+
+        ASSERT_UINT_EQUALS(2, h2_decode_tester_frame_count(&decode));
+        for (size_t i = 0; i < 2; ++i) {
+            struct h2_decoded_frame *decoded = h2_decode_tester_get_frame(&decode, i);
+            ASSERT_SUCCESS(h2_decoded_frame_check_finished(decoded, AWS_H2_FRAME_T_HEADERS, (uint32_t)(i * 2 + 1)));
+            ASSERT_TRUE(decoded->end_stream);
+            ASSERT_SUCCESS(s_check_decoded_headers(decoded, headers));
+        }
+
+        h2_decode_tester_clean_up(&decode);
+        aws_h2_frame_encoder_clean_up(&encoder);
+    }
+
+    aws_http_headers_release(headers);
+    return AWS_OP_SUCCESS;
+}
+
 TEST_CASE(h2_encoder_ping) {
     (void)ctx;
 
@@ -0,0 +1,307 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "h2_test_helper.h"
+
+#include <aws/http/connection.h>
+#include <aws/http/private/connection_impl.h>
+#include <aws/http/request_response.h>
+
+#include <aws/common/clock.h>
+#include <aws/io/channel_bootstrap.h>
+#include <aws/io/socket.h>
+#include <aws/testing/aws_test_harness.h>
+#include <aws/testing/io_testing_channel.h>
+
+#define DEFINE_HEADER(NAME, VALUE)                                                                                     \
+    {                                                                                                                  \
+        .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(NAME),                                                           \
+        .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(VALUE),                                                         \
+    }
+
+/* Drives a real client bootstrap over a testing channel, standing in for the socket */
+struct h2c_tester {
+    struct aws_allocator *alloc;
+    struct testing_channel testing_channel;
+    struct h2_fake_peer peer;
+
+    /* from the bootstrap, invoked once the testing channel finishes shutting down */
+    aws_client_bootstrap_on_channel_event_fn *on_bootstrap_channel_shutdown;
+    void *bootstrap_user_data;
+
+    struct aws_http_connection *connection;
+    int setup_error_code;
+    bool setup_completed;
+    bool shutdown_completed;
+};
+
+static struct h2c_tester s_tester;
+
+static void s_on_testing_channel_shutdown(int error_code, void *user_data) {
+    struct h2c_tester *tester = user_data;
+    tester->on_bootstrap_channel_shutdown(
+        NULL /*bootstrap*/, error_code, tester->testing_channel.channel, tester->bootstrap_user_data);
+}
+
+static int s_mock_new_socket_channel(struct aws_socket_channel_bootstrap_options *channel_options) {
+    struct h2c_tester *tester = &s_tester;
+
+    struct aws_testing_channel_options testing_channel_options = {.clock_fn = aws_high_res_clock_get_ticks};
+    ASSERT_SUCCESS(testing_channel_init(&tester->testing_channel, tester->alloc, &testing_channel_options));
+    tester->testing_channel.channel_shutdown = s_on_testing_channel_shutdown;
+    tester->testing_channel.channel_shutdown_user_data = tester;
+    tester->on_bootstrap_channel_shutdown = channel_options->shutdown_callback;
+    tester->bootstrap_user_data = channel_options->user_data;
+
+    /* The "socket" is connected, let the bootstrap set up its connection */
+    channel_options->setup_callback(
+        channel_options->bootstrap, AWS_ERROR_SUCCESS, tester->testing_channel.channel, channel_options->user_data);
+    return AWS_OP_SUCCESS;
+}
+
+static struct aws_http_connection_system_vtable s_h2c_mock_system_vtable = {
+    .aws_client_bootstrap_new_socket_channel = s_mock_new_socket_channel,
+};
+
+static void s_on_connection_setup(struct aws_http_connection *connection, int error_code, void *user_data) {
+    struct h2c_tester *tester = user_data;
+    AWS_FATAL_ASSERT(!tester->setup_completed);
+    tester->connection = connection;
+    tester->setup_error_code = error_code;
+    tester->setup_completed = true;
+}
+
+static void s_on_connection_shutdown(struct aws_http_connection *connection, int error_code, void *user_data) {
+    (void)error_code;
+    struct h2c_tester *tester = user_data;
+    AWS_FATAL_ASSERT(connection == tester->connection);
+    tester->shutdown_completed = true;
+}
+
+/* Connect with h2c upgrade, and check that the upgrade request is the first thing written */
+static int s_tester_init(struct aws_allocator *alloc) {
+    aws_http_library_init(alloc);
+    AWS_ZERO_STRUCT(s_tester);
+    s_tester.alloc = alloc;
+
+    aws_http_connection_set_system_vtable(&s_h2c_mock_system_vtable);
+
+    struct aws_socket_options socket_options = {
+        .type = AWS_SOCKET_STREAM,
+        .domain = AWS_SOCKET_IPV4,
+    };
+
+    struct aws_http_client_connection_options options = AWS_HTTP_CLIENT_CONNECTION_OPTIONS_INIT;
+    options.allocator = alloc;
+    options.host_name = aws_byte_cursor_from_c_str("example.com");
+    options.port = 80;
+    options.socket_options = &socket_options;
+    options.http2_cleartext_upgrade = true;
+    options.on_setup = s_on_connection_setup;
+    options.on_shutdown = s_on_connection_shutdown;
+    options.user_data = &s_tester;
+    ASSERT_SUCCESS(aws_http_client_connect(&options));
+
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* Setup doesn't complete until the server answers the upgrade request */
+    ASSERT_FALSE(s_tester.setup_completed);
+
+    struct aws_byte_buf written;
+    ASSERT_SUCCESS(aws_byte_buf_init(&written, alloc, 256));
+    ASSERT_SUCCESS(testing_channel_drain_written_messages(&s_tester.testing_channel, &written));
+    struct aws_byte_cursor written_cursor = aws_byte_cursor_from_buf(&written);
+    struct aws_byte_cursor expected_request_line = aws_byte_cursor_from_c_str("OPTIONS * HTTP/1.1\r\n");
+    ASSERT_TRUE(aws_byte_cursor_starts_with(&written_cursor, &expected_request_line));
+    aws_byte_buf_clean_up(&written);
+
+    struct h2_fake_peer_options peer_options = {
+        .alloc = alloc,
+        .testing_channel = &s_tester.testing_channel,
+        .is_server = true,
+    };
+    ASSERT_SUCCESS(h2_fake_peer_init(&s_tester.peer, &peer_options));
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_tester_clean_up(void) {
+    if (s_tester.connection) {
+        aws_http_connection_release(s_tester.connection);
+    }
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    h2_fake_peer_clean_up(&s_tester.peer);
+    ASSERT_SUCCESS(testing_channel_clean_up(&s_tester.testing_channel));
+
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_h2c_upgrade_request_settings_encoding(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    aws_http_library_init(allocator);
+
+    /* The payload of these settings encodes to "AAMAAABkAAQA+++/" in regular base64 */
+    struct aws_http2_setting settings_array[] = {
+        {.id = AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, .value = 100},
+        {.id = AWS_HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, .value = 0xFBEFBF},
+    };
+    struct aws_http2_connection_options http2_options = {
+        .initial_settings_array = settings_array,
+        .num_initial_settings = AWS_ARRAY_SIZE(settings_array),
+    };
+
+    struct aws_http_message *request =
+        aws_http_client_new_h2c_upgrade_request(allocator, aws_byte_cursor_from_c_str("example.com"), &http2_options);
+    ASSERT_NOT_NULL(request);
+
+    struct aws_byte_cursor method;
+    ASSERT_SUCCESS(aws_http_message_get_request_method(request, &method));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(method, "OPTIONS");
+    struct aws_byte_cursor path;
+    ASSERT_SUCCESS(aws_http_message_get_request_path(request, &path));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(path, "*");
+
+    struct aws_http_headers *headers = aws_http_message_get_headers(request);
+    struct aws_byte_cursor value;
+    ASSERT_SUCCESS(aws_http_headers_get(headers, aws_byte_cursor_from_c_str("Host"), &value));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(value, "example.com");
+    ASSERT_SUCCESS(aws_http_headers_get(headers, aws_byte_cursor_from_c_str("Connection"), &value));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(value, "Upgrade, HTTP2-Settings");
+    ASSERT_SUCCESS(aws_http_headers_get(headers, aws_byte_cursor_from_c_str("Upgrade"), &value));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(value, "h2c");
+
+    /* base64url swaps '+' and '/' for '-' and '_' */
+    ASSERT_SUCCESS(aws_http_headers_get(headers, aws_byte_cursor_from_c_str("HTTP2-Settings"), &value));
+    ASSERT_CURSOR_VALUE_CSTRING_EQUALS(value, "AAMAAABkAAQA---_");
+
+    aws_http_message_release(request);
+
+    /* No settings is an empty value */
+    AWS_ZERO_STRUCT(http2_options);
+    request =
+        aws_http_client_new_h2c_upgrade_request(allocator, aws_byte_cursor_from_c_str("example.com"), &http2_options);
+    ASSERT_NOT_NULL(request);
+    headers = aws_http_message_get_headers(request);
+    ASSERT_SUCCESS(aws_http_headers_get(headers, aws_byte_cursor_from_c_str("HTTP2-Settings"), &value));
+    ASSERT_UINT_EQUALS(0, value.len);
+    aws_http_message_release(request);
+
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(h2c_upgrade_request_settings_encoding, s_test_h2c_upgrade_request_settings_encoding);
+
+/* Server switches protocols: setup completes with an HTTP/2 connection, and the response to the upgrade request
+ * arrives on stream 1 */
+static int s_test_h2c_upgrade_accepted(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    ASSERT_SUCCESS(s_tester_init(allocator));
+
+    ASSERT_SUCCESS(testing_channel_push_read_str(
+        &s_tester.testing_channel,
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Connection: Upgrade\r\n"
+        "Upgrade: h2c\r\n"
+        "\r\n"));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    ASSERT_TRUE(s_tester.setup_completed);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, s_tester.setup_error_code);
+    ASSERT_NOT_NULL(s_tester.connection);
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_2, aws_http_connection_get_version(s_tester.connection));
+
+    /* The server's preface and its response on stream 1 flow through the HTTP/1.1 connection */
+    ASSERT_SUCCESS(h2_fake_peer_send_connection_preface_default_settings(&s_tester.peer));
+    struct aws_http_header response_headers_src[] = {
+        DEFINE_HEADER(":status", "200"),
+    };
+    struct aws_http_headers *response_headers = aws_http_headers_new(allocator);
+    aws_http_headers_add_array(response_headers, response_headers_src, AWS_ARRAY_SIZE(response_headers_src));
+    struct aws_h2_frame *response_frame =
+        aws_h2_frame_new_headers(allocator, 1 /*stream_id*/, response_headers, true /*end_stream*/, 0, NULL);
+    ASSERT_SUCCESS(h2_fake_peer_send_frame(&s_tester.peer, response_frame));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    /* Client sent its preface, and didn't treat the response on stream 1 as a protocol error */
+    ASSERT_SUCCESS(h2_fake_peer_decode_messages_from_testing_channel(&s_tester.peer));
+    ASSERT_NOT_NULL(h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_SETTINGS, 0, NULL));
+    ASSERT_NULL(h2_decode_tester_find_frame(&s_tester.peer.decode, AWS_H2_FRAME_T_GOAWAY, 0, NULL));
+    ASSERT_TRUE(aws_http_connection_is_open(s_tester.connection));
+
+    /* Stream 1 was taken by the upgrade, so the first new request goes on stream 3 */
+    struct aws_http_header request_headers_src[] = {
+        DEFINE_HEADER(":method", "GET"),
+        DEFINE_HEADER(":scheme", "http"),
+        DEFINE_HEADER(":path", "/"),
+        DEFINE_HEADER(":authority", "example.com"),
+    };
+    struct aws_http_message *request = aws_http2_message_new_request(allocator);
+    ASSERT_SUCCESS(
+        aws_http_message_add_header_array(request, request_headers_src, AWS_ARRAY_SIZE(request_headers_src)));
+    struct aws_http_make_request_options request_options = {
+        .self_size = sizeof(request_options),
+        .request = request,
+    };
+    struct aws_http_stream *stream = aws_http_connection_make_request(s_tester.connection, &request_options);
+    ASSERT_NOT_NULL(stream);
+    ASSERT_SUCCESS(aws_http_stream_activate(stream));
+    ASSERT_UINT_EQUALS(3, aws_http_stream_get_id(stream));
+
+    aws_http_connection_close(s_tester.connection);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(s_tester.shutdown_completed);
+
+    aws_http_stream_release(stream);
+    aws_http_message_release(request);
+    aws_http_headers_release(response_headers);
+
+    return s_tester_clean_up();
+}
+AWS_TEST_CASE(h2c_upgrade_accepted, s_test_h2c_upgrade_accepted);
+
+/* Server ignores the upgrade: setup completes with the HTTP/1.1 connection once the response is done */
+static int s_test_h2c_upgrade_declined(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    ASSERT_SUCCESS(s_tester_init(allocator));
+
+    ASSERT_SUCCESS(testing_channel_push_read_str(
+        &s_tester.testing_channel,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n"));
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    ASSERT_TRUE(s_tester.setup_completed);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, s_tester.setup_error_code);
+    ASSERT_NOT_NULL(s_tester.connection);
+    ASSERT_INT_EQUALS(AWS_HTTP_VERSION_1_1, aws_http_connection_get_version(s_tester.connection));
+    ASSERT_TRUE(aws_http_connection_new_requests_allowed(s_tester.connection));
+
+    aws_http_connection_close(s_tester.connection);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+    ASSERT_TRUE(s_tester.shutdown_completed);
+
+    return s_tester_clean_up();
+}
+AWS_TEST_CASE(h2c_upgrade_declined, s_test_h2c_upgrade_declined);
+
+/* Connection fails before the server responds: setup fails */
+static int s_test_h2c_upgrade_connection_lost(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    ASSERT_SUCCESS(s_tester_init(allocator));
+
+    aws_channel_shutdown(s_tester.testing_channel.channel, AWS_IO_SOCKET_CLOSED);
+    testing_channel_drain_queued_tasks(&s_tester.testing_channel);
+
+    ASSERT_TRUE(s_tester.setup_completed);
+    ASSERT_NULL(s_tester.connection);
+    ASSERT_TRUE(s_tester.setup_error_code != AWS_ERROR_SUCCESS);
+    ASSERT_FALSE(s_tester.shutdown_completed);
+
+    return s_tester_clean_up();
+}
+AWS_TEST_CASE(h2c_upgrade_connection_lost, s_test_h2c_upgrade_connection_lost);
@@ -579,6 +579,42 @@ static int test_hpack_static_table_get(struct aws_allocator *allocator, void *ct
     return AWS_OP_SUCCESS;
 }
 
+/* Every static table entry must be found at its own index (or the first index with its name, if searching name-only) */
+AWS_TEST_CASE(hpack_static_table_find_all, test_hpack_static_table_find_all)
+static int test_hpack_static_table_find_all(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+    struct aws_hpack_context context;
+    aws_hpack_context_init(&context, allocator, AWS_LS_HTTP_GENERAL, NULL);
+    ASSERT_SUCCESS(aws_hpack_resize_dynamic_table(&context, 0));
+
+    bool found_value = false;
+    size_t first_index_with_name = 0;
+    for (size_t index = 1; index <= 61; ++index) {
+        const struct aws_http_header *static_header = aws_hpack_get_header(&context, index);
+        ASSERT_NOT_NULL(static_header);
+
+        ASSERT_UINT_EQUALS(index, aws_hpack_find_index(&context, static_header, true, &found_value));
+        ASSERT_UINT_EQUALS(static_header->value.len > 0, found_value);
+
+        if (first_index_with_name == 0 ||
+            !aws_byte_cursor_eq(&static_header->name, &aws_hpack_get_header(&context, first_index_with_name)->name)) {
+            first_index_with_name = index;
+        }
+        ASSERT_UINT_EQUALS(first_index_with_name, aws_hpack_find_index(&context, static_header, false, &found_value));
+        ASSERT_FALSE(found_value);
+    }
+
+    /* Same length as a static name, but not a static name */
+    DEFINE_STATIC_HEADER(s_not_static, "dat3", "");
+    ASSERT_UINT_EQUALS(0, aws_hpack_find_index(&context, &s_not_static, true, &found_value));
+
+    aws_hpack_context_clean_up(&context);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
 AWS_TEST_CASE(hpack_dynamic_table_find, test_hpack_dynamic_table_find)
 static int test_hpack_dynamic_table_find(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
@@ -691,6 +727,53 @@ static int test_hpack_dynamic_table_get(struct aws_allocator *allocator, void *c
     return AWS_OP_SUCCESS;
 }
 
+AWS_TEST_CASE(hpack_dynamic_table_trim, test_hpack_dynamic_table_trim)
+static int test_hpack_dynamic_table_trim(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+    struct aws_hpack_context context;
+    aws_hpack_context_init(&context, allocator, AWS_LS_HTTP_GENERAL, NULL);
+
+    const struct aws_http_header *found = NULL;
+
+    DEFINE_STATIC_HEADER(s_herp, "herp", "derp");
+    DEFINE_STATIC_HEADER(s_fizz, "fizz", "buzz");
+
+    /* Trimming an empty table is fine */
+    ASSERT_SUCCESS(aws_hpack_context_trim(&context));
+    ASSERT_UINT_EQUALS(0, aws_hpack_context_get_resident_bytes(&context));
+
+    ASSERT_SUCCESS(aws_hpack_insert_header(&context, &s_herp));
+    size_t untrimmed_bytes = aws_hpack_context_get_resident_bytes(&context);
+
+    /* Trimming releases spare slots, but the entries are shared state with the peer and must remain */
+    ASSERT_SUCCESS(aws_hpack_context_trim(&context));
+    ASSERT_TRUE(aws_hpack_context_get_resident_bytes(&context) < untrimmed_bytes);
+    found = aws_hpack_get_header(&context, 62);
+    ASSERT_NOT_NULL(found);
+    ASSERT_TRUE(aws_byte_cursor_eq(&s_herp.name, &found->name));
+    ASSERT_TRUE(aws_byte_cursor_eq(&s_herp.value, &found->value));
+
+    /* Table re-grows on demand */
+    ASSERT_SUCCESS(aws_hpack_insert_header(&context, &s_fizz));
+    ASSERT_SUCCESS(aws_hpack_insert_header(&context, &s_herp));
+    found = aws_hpack_get_header(&context, 62);
+    ASSERT_NOT_NULL(found);
+    ASSERT_TRUE(aws_byte_cursor_eq(&s_herp.name, &found->name));
+    found = aws_hpack_get_header(&context, 63);
+    ASSERT_NOT_NULL(found);
+    ASSERT_TRUE(aws_byte_cursor_eq(&s_fizz.name, &found->name));
+    found = aws_hpack_get_header(&context, 64);
+    ASSERT_NOT_NULL(found);
+    ASSERT_TRUE(aws_byte_cursor_eq(&s_herp.name, &found->name));
+    ASSERT_UINT_EQUALS(3, aws_hpack_get_dynamic_table_num_elements(&context));
+
+    aws_hpack_context_clean_up(&context);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
 static int s_check_header(
     const struct aws_http_header *header_field,
     const char *name,
@@ -875,3 +958,280 @@ static int test_hpack_dynamic_table_size_update_from_setting(struct aws_allocato
     aws_http_library_clean_up();
     return AWS_OP_SUCCESS;
 }
+
+/* Encode the same header-block with both encoders, and check the outputs match */
+static int s_encode_in_lockstep(
+    struct aws_hpack_encoder *encoder_a,
+    const struct aws_http_headers *headers_a,
+    struct aws_hpack_encoder *encoder_b,
+    const struct aws_http_headers *headers_b,
+    struct aws_byte_buf *output_a,
+    struct aws_byte_buf *output_b) {
+
+    aws_byte_buf_reset(output_a, false);
+    aws_byte_buf_reset(output_b, false);
+    ASSERT_SUCCESS(aws_hpack_encode_header_block(encoder_a, headers_a, output_a));
+    ASSERT_SUCCESS(aws_hpack_encode_header_block(encoder_b, headers_b, output_b));
+    ASSERT_BIN_ARRAYS_EQUALS(output_b->buffer, output_b->len, output_a->buffer, output_a->len);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(hpack_encode_memoized_header_block, test_hpack_encode_memoized_header_block)
+static int test_hpack_encode_memoized_header_block(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+
+    /* One encoder gets immutable headers, the other gets a mutable copy. Their outputs must always match. */
+    struct aws_hpack_encoder memo_encoder;
+    aws_hpack_encoder_init(&memo_encoder, allocator, NULL);
+    struct aws_hpack_encoder plain_encoder;
+    aws_hpack_encoder_init(&plain_encoder, allocator, NULL);
+
+    DEFINE_STATIC_HEADER(s_status, ":status", "200");
+    DEFINE_STATIC_HEADER(s_content_type, "content-type", "application/json");
+    DEFINE_STATIC_HEADER(s_server, "server", "herp-derp");
+    DEFINE_STATIC_HEADER(s_fizz, "fizz", "buzz");
+    const struct aws_http_header group[] = {s_status, s_content_type, s_server};
+
+    struct aws_http_headers *immutable_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_array(immutable_headers, group, AWS_ARRAY_SIZE(group)));
+    aws_http_headers_set_immutable(immutable_headers);
+
+    struct aws_http_headers *mutable_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_array(mutable_headers, group, AWS_ARRAY_SIZE(group)));
+
+    struct aws_http_headers *other_headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_header(other_headers, &s_fizz));
+
+    struct aws_byte_buf memo_output;
+    ASSERT_SUCCESS(aws_byte_buf_init(&memo_output, allocator, 64));
+    struct aws_byte_buf plain_output;
+    ASSERT_SUCCESS(aws_byte_buf_init(&plain_output, allocator, 64));
+
+    /* First time, entries are inserted into the dynamic table, so the result can't be re-used */
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+    ASSERT_NULL(memo_encoder.memoized_header_blocks);
+
+    /* Second time, everything is indexed and the table doesn't change, so it's memoized */
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+    ASSERT_NOT_NULL(memo_encoder.memoized_header_blocks);
+    ASSERT_UINT_EQUALS(1, aws_cache_get_element_count(memo_encoder.memoized_header_blocks));
+
+    /* Third time comes from the memo */
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+
+    /* Inserting a new entry shifts the dynamic table indices, so the memo is stale */
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, other_headers, &plain_encoder, other_headers, &memo_output, &plain_output));
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+
+    /* So does changing the huffman mode */
+    aws_hpack_encoder_set_huffman_mode(&memo_encoder, AWS_HPACK_HUFFMAN_NEVER);
+    aws_hpack_encoder_set_huffman_mode(&plain_encoder, AWS_HPACK_HUFFMAN_NEVER);
+    ASSERT_SUCCESS(s_encode_in_lockstep(
+        &memo_encoder, immutable_headers, &plain_encoder, mutable_headers, &memo_output, &plain_output));
+
+    /* The memo holds a reference, the headers stay alive until the encoder is done with them */
+    aws_http_headers_release(immutable_headers);
+    ASSERT_SUCCESS(aws_hpack_encoder_trim(&memo_encoder));
+    ASSERT_UINT_EQUALS(0, aws_cache_get_element_count(memo_encoder.memoized_header_blocks));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&memo_output);
+    aws_byte_buf_clean_up(&plain_output);
+    aws_http_headers_release(mutable_headers);
+    aws_http_headers_release(other_headers);
+    aws_hpack_encoder_clean_up(&memo_encoder);
+    aws_hpack_encoder_clean_up(&plain_encoder);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+/* The max length must cover what's actually encoded, with every huffman mode, as the dynamic table fills up */
+AWS_TEST_CASE(hpack_encode_header_block_max_length, test_hpack_encode_header_block_max_length)
+static int test_hpack_encode_header_block_max_length(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+
+    const struct aws_http_header headers_array[] = {
+        /* fully indexed from the static table */
+        {
+            .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":method"),
+            .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("GET"),
+        },
+        /* name from the static table */
+        {
+            .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(":path"),
+            .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("/index.html"),
+        },
+        /* new name, and huffman makes the value bigger */
+        {
+            .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("x-symbols"),
+            .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("{}<>^`|~"),
+        },
+        {
+            .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("x-secret"),
+            .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("hunter2"),
+            .compression = AWS_HTTP_HEADER_COMPRESSION_NO_FORWARD_CACHE,
+        },
+        {
+            .name = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL("x-empty"),
+            .value = AWS_BYTE_CUR_INIT_FROM_STRING_LITERAL(""),
+            .compression = AWS_HTTP_HEADER_COMPRESSION_NO_CACHE,
+        },
+    };
+    struct aws_http_headers *headers = aws_http_headers_new(allocator);
+    ASSERT_SUCCESS(aws_http_headers_add_array(headers, headers_array, AWS_ARRAY_SIZE(headers_array)));
+
+    struct aws_byte_buf output;
+    ASSERT_SUCCESS(aws_byte_buf_init(&output, allocator, 64));
+
+    const enum aws_hpack_huffman_mode modes[] = {
+        AWS_HPACK_HUFFMAN_NEVER,
+        AWS_HPACK_HUFFMAN_SMALLEST,
+        AWS_HPACK_HUFFMAN_ALWAYS,
+    };
+    size_t first_encoded_len[AWS_ARRAY_SIZE(modes)];
+    for (size_t mode_i = 0; mode_i < AWS_ARRAY_SIZE(modes); ++mode_i) {
+        struct aws_hpack_encoder encoder;
+        aws_hpack_encoder_init(&encoder, allocator, NULL);
+        aws_hpack_encoder_set_huffman_mode(&encoder, modes[mode_i]);
+
+        /* The first time inserts into the dynamic table, after that it's indexed */
+        for (size_t i = 0; i < 3; ++i) {
+            const size_t num_entries = aws_hpack_get_dynamic_table_num_elements(&encoder.context);
+            const size_t max_length = aws_hpack_get_encoded_header_block_max_length(&encoder, headers);
+            /* It doesn't touch the encoder's state */
+            ASSERT_UINT_EQUALS(num_entries, aws_hpack_get_dynamic_table_num_elements(&encoder.context));
+
+            aws_byte_buf_reset(&output, false);
+            ASSERT_SUCCESS(aws_hpack_encode_header_block(&encoder, headers, &output));
+            ASSERT_TRUE(output.len <= max_length);
+            if (i == 0) {
+                first_encoded_len[mode_i] = output.len;
+            }
+        }
+        aws_hpack_encoder_clean_up(&encoder);
+    }
+
+    /* Huffman helps some strings and hurts others. Check the modes really did differ. */
+    ASSERT_TRUE(first_encoded_len[0] != first_encoded_len[2]);
+    ASSERT_TRUE(first_encoded_len[1] < first_encoded_len[0]);
+    ASSERT_TRUE(first_encoded_len[1] < first_encoded_len[2]);
+
+    /* clean up */
+    aws_byte_buf_clean_up(&output);
+    aws_http_headers_release(headers);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+/* A pending dynamic table size update is part of the next header-block, so the max length covers it too */
+AWS_TEST_CASE(hpack_encode_max_length_with_table_size_update, test_hpack_encode_max_length_with_table_size_update)
+static int test_hpack_encode_max_length_with_table_size_update(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+    struct aws_hpack_encoder encoder;
+    aws_hpack_encoder_init(&encoder, allocator, NULL);
+
+    struct aws_http_headers *headers = aws_http_headers_new(allocator);
+    DEFINE_STATIC_HEADER(header, ":method", "GET");
+    ASSERT_SUCCESS(aws_http_headers_add_header(headers, &header));
+
+    const size_t max_length_without_update = aws_hpack_get_encoded_header_block_max_length(&encoder, headers);
+
+    /* Same updates as hpack_dynamic_table_size_update_from_setting, which encode to 4 bytes */
+    aws_hpack_encoder_update_max_table_size(&encoder, 10);
+    aws_hpack_encoder_update_max_table_size(&encoder, 0);
+    aws_hpack_encoder_update_max_table_size(&encoder, 1337);
+    const size_t max_length = aws_hpack_get_encoded_header_block_max_length(&encoder, headers);
+    ASSERT_UINT_EQUALS(max_length_without_update + 4, max_length);
+
+    struct aws_byte_buf output;
+    ASSERT_SUCCESS(aws_byte_buf_init(&output, allocator, max_length));
+    ASSERT_SUCCESS(aws_hpack_encode_header_block(&encoder, headers, &output));
+    ASSERT_UINT_EQUALS(5, output.len);
+    ASSERT_TRUE(output.len <= max_length);
+
+    /* Once sent, the update isn't pending anymore */
+    ASSERT_UINT_EQUALS(max_length_without_update, aws_hpack_get_encoded_header_block_max_length(&encoder, headers));
+
+    /* clean up */
+    aws_byte_buf_clean_up(&output);
+    aws_http_headers_release(headers);
+    aws_hpack_encoder_clean_up(&encoder);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
+
+static bool s_cursor_is_within(struct aws_byte_cursor cursor, const uint8_t *array, size_t len) {
+    return cursor.ptr >= array && cursor.ptr + cursor.len <= array + len;
+}
+
+AWS_TEST_CASE(hpack_decode_literal_in_place, test_hpack_decode_literal_in_place)
+static int test_hpack_decode_literal_in_place(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    aws_http_library_init(allocator);
+    struct aws_hpack_decoder decoder;
+    aws_hpack_decoder_init(&decoder, allocator, NULL);
+
+    /* clang-format off */
+    uint8_t input[] = {
+        0x40, 0x03, 'f', 'o', 'o', 0x03, 'b', 'a', 'r', /* "foo: bar" - new name, stored to dynamic table */
+        0x00, 0x01, 'a', 0x81, 0x1f,                    /* "a: a" - new name, huffman-compressed value */
+        0x0f, 0x2f, 0x03, 'x', 'y', 'z',                /* "foo: xyz" - indexed name (from dynamic table) */
+    };
+    /* clang-format on */
+    struct aws_hpack_decode_result result;
+    struct aws_byte_cursor input_cursor = aws_byte_cursor_from_array(input, sizeof(input));
+
+    /* Plain strings, whole in the input, reference the input directly */
+    ASSERT_SUCCESS(aws_hpack_decode(&decoder, &input_cursor, &result));
+    ASSERT_TRUE(result.type == AWS_HPACK_DECODE_T_HEADER_FIELD);
+    ASSERT_SUCCESS(s_check_header(&result.data.header_field, "foo", "bar", AWS_HTTP_HEADER_COMPRESSION_USE_CACHE));
+    ASSERT_TRUE(s_cursor_is_within(result.data.header_field.name, input, sizeof(input)));
+    ASSERT_TRUE(s_cursor_is_within(result.data.header_field.value, input, sizeof(input)));
+
+    /* Huffman strings must be decoded into scratch. The name comes along, since it's packed in front */
+    ASSERT_SUCCESS(aws_hpack_decode(&decoder, &input_cursor, &result));
+    ASSERT_TRUE(result.type == AWS_HPACK_DECODE_T_HEADER_FIELD);
+    ASSERT_SUCCESS(s_check_header(&result.data.header_field, "a", "a", AWS_HTTP_HEADER_COMPRESSION_NO_CACHE));
+    ASSERT_FALSE(s_cursor_is_within(result.data.header_field.name, input, sizeof(input)));
+    ASSERT_FALSE(s_cursor_is_within(result.data.header_field.value, input, sizeof(input)));
+
+    /* Indexed names are always copied, the value needn't be */
+    ASSERT_SUCCESS(aws_hpack_decode(&decoder, &input_cursor, &result));
+    ASSERT_TRUE(result.type == AWS_HPACK_DECODE_T_HEADER_FIELD);
+    ASSERT_SUCCESS(s_check_header(&result.data.header_field, "foo", "xyz", AWS_HTTP_HEADER_COMPRESSION_NO_CACHE));
+    ASSERT_TRUE(s_cursor_is_within(result.data.header_field.value, input, sizeof(input)));
+    ASSERT_UINT_EQUALS(0, input_cursor.len);
+
+    /* A name decoded in place must survive the input going away, if the value arrives in a later call */
+    uint8_t first_half[] = {0x00, 0x03, 'b', 'a', 'z'};
+    uint8_t second_half[] = {0x03, 'q', 'u', 'x'};
+    struct aws_byte_cursor first_cursor = aws_byte_cursor_from_array(first_half, sizeof(first_half));
+    ASSERT_SUCCESS(aws_hpack_decode(&decoder, &first_cursor, &result));
+    ASSERT_TRUE(result.type == AWS_HPACK_DECODE_T_ONGOING);
+    memset(first_half, 0, sizeof(first_half));
+
+    struct aws_byte_cursor second_cursor = aws_byte_cursor_from_array(second_half, sizeof(second_half));
+    ASSERT_SUCCESS(aws_hpack_decode(&decoder, &second_cursor, &result));
+    ASSERT_TRUE(result.type == AWS_HPACK_DECODE_T_HEADER_FIELD);
+    ASSERT_SUCCESS(s_check_header(&result.data.header_field, "baz", "qux", AWS_HTTP_HEADER_COMPRESSION_NO_CACHE));
+    ASSERT_TRUE(s_cursor_is_within(result.data.header_field.value, second_half, sizeof(second_half)));
+
+    /* Clean up */
+    aws_hpack_decoder_clean_up(&decoder);
+    aws_http_library_clean_up();
+    return AWS_OP_SUCCESS;
+}
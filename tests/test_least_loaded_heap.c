@@ -0,0 +1,164 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/private/least_loaded_heap.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+struct test_item {
+    int id;
+    struct aws_least_loaded_heap_node node;
+};
+
+static struct test_item *s_peek_item(const struct aws_least_loaded_heap *heap) {
+    struct aws_least_loaded_heap_node *node = aws_least_loaded_heap_peek(heap);
+    return node ? AWS_CONTAINER_OF(node, struct test_item, node) : NULL;
+}
+
+/* Check that every node knows its own position, and that no node is less loaded than its parent */
+static int s_check_heap(const struct aws_least_loaded_heap *heap) {
+    size_t size = aws_least_loaded_heap_get_size(heap);
+    for (size_t i = 0; i < size; ++i) {
+        struct aws_least_loaded_heap_node *node = aws_least_loaded_heap_get_index(heap, i);
+        ASSERT_NOT_NULL(node);
+        ASSERT_UINT_EQUALS(i, node->index);
+        if (i > 0) {
+            ASSERT_TRUE(aws_least_loaded_heap_get_index(heap, (i - 1) / 2)->load <= node->load);
+        }
+    }
+    ASSERT_NULL(aws_least_loaded_heap_get_index(heap, size));
+    return AWS_OP_SUCCESS;
+}
+
+static int s_least_loaded_heap_sanitize_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_least_loaded_heap heap;
+    ASSERT_SUCCESS(aws_least_loaded_heap_init(&heap, allocator, 0));
+    ASSERT_UINT_EQUALS(0, aws_least_loaded_heap_get_size(&heap));
+    ASSERT_NULL(aws_least_loaded_heap_peek(&heap));
+
+    /* Removing a node that isn't in the heap does nothing */
+    struct test_item item;
+    aws_least_loaded_heap_node_init(&item.node);
+    ASSERT_FALSE(aws_least_loaded_heap_node_is_in_heap(&item.node));
+    aws_least_loaded_heap_remove(&heap, &item.node);
+    ASSERT_UINT_EQUALS(0, aws_least_loaded_heap_get_size(&heap));
+
+    aws_least_loaded_heap_clean_up(&heap);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(least_loaded_heap_sanitize_test, s_least_loaded_heap_sanitize_fn)
+
+static int s_least_loaded_heap_peek_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_least_loaded_heap heap;
+    /* With only 1 initial element. */
+    ASSERT_SUCCESS(aws_least_loaded_heap_init(&heap, allocator, 1));
+
+    const uint64_t loads[] = {5, 3, 9, 1, 7};
+    struct test_item items[AWS_ARRAY_SIZE(loads)];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(loads); ++i) {
+        items[i].id = (int)i;
+        aws_least_loaded_heap_node_init(&items[i].node);
+        ASSERT_SUCCESS(aws_least_loaded_heap_add(&heap, &items[i].node, loads[i]));
+        ASSERT_TRUE(aws_least_loaded_heap_node_is_in_heap(&items[i].node));
+        ASSERT_SUCCESS(s_check_heap(&heap));
+    }
+    ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(loads), aws_least_loaded_heap_get_size(&heap));
+    ASSERT_PTR_EQUALS(&items[3], s_peek_item(&heap));
+
+    aws_least_loaded_heap_clean_up(&heap);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(least_loaded_heap_peek_test, s_least_loaded_heap_peek_fn)
+
+static int s_least_loaded_heap_update_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_least_loaded_heap heap;
+    ASSERT_SUCCESS(aws_least_loaded_heap_init(&heap, allocator, 4));
+
+    struct test_item items[4];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(items); ++i) {
+        items[i].id = (int)i;
+        aws_least_loaded_heap_node_init(&items[i].node);
+        ASSERT_SUCCESS(aws_least_loaded_heap_add(&heap, &items[i].node, i * 10));
+    }
+    ASSERT_PTR_EQUALS(&items[0], s_peek_item(&heap));
+
+    /* Make the least loaded item the most loaded */
+    aws_least_loaded_heap_update(&heap, &items[0].node, 100);
+    ASSERT_SUCCESS(s_check_heap(&heap));
+    ASSERT_PTR_EQUALS(&items[1], s_peek_item(&heap));
+
+    /* Make the most loaded item the least loaded */
+    aws_least_loaded_heap_update(&heap, &items[0].node, 0);
+    ASSERT_SUCCESS(s_check_heap(&heap));
+    ASSERT_PTR_EQUALS(&items[0], s_peek_item(&heap));
+
+    /* Updating to the same load changes nothing */
+    aws_least_loaded_heap_update(&heap, &items[2].node, 20);
+    ASSERT_SUCCESS(s_check_heap(&heap));
+    ASSERT_UINT_EQUALS(4, aws_least_loaded_heap_get_size(&heap));
+
+    aws_least_loaded_heap_clean_up(&heap);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(least_loaded_heap_update_test, s_least_loaded_heap_update_fn)
+
+static int s_least_loaded_heap_remove_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_least_loaded_heap heap;
+    ASSERT_SUCCESS(aws_least_loaded_heap_init(&heap, allocator, 0));
+
+    struct test_item items[8];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(items); ++i) {
+        items[i].id = (int)i;
+        aws_least_loaded_heap_node_init(&items[i].node);
+        ASSERT_SUCCESS(aws_least_loaded_heap_add(&heap, &items[i].node, (i * 5) % 8));
+    }
+
+    /* Remove from the middle, the top, and the end */
+    aws_least_loaded_heap_remove(&heap, &items[3].node);
+    ASSERT_FALSE(aws_least_loaded_heap_node_is_in_heap(&items[3].node));
+    ASSERT_SUCCESS(s_check_heap(&heap));
+
+    struct test_item *top = s_peek_item(&heap);
+    aws_least_loaded_heap_remove(&heap, &top->node);
+    ASSERT_SUCCESS(s_check_heap(&heap));
+
+    struct aws_least_loaded_heap_node *last =
+        aws_least_loaded_heap_get_index(&heap, aws_least_loaded_heap_get_size(&heap) - 1);
+    aws_least_loaded_heap_remove(&heap, last);
+    ASSERT_SUCCESS(s_check_heap(&heap));
+    ASSERT_UINT_EQUALS(5, aws_least_loaded_heap_get_size(&heap));
+
+    /* Removing again does nothing, and a removed node can be added back */
+    aws_least_loaded_heap_remove(&heap, &items[3].node);
+    ASSERT_UINT_EQUALS(5, aws_least_loaded_heap_get_size(&heap));
+    ASSERT_SUCCESS(aws_least_loaded_heap_add(&heap, &items[3].node, 0));
+    ASSERT_SUCCESS(s_check_heap(&heap));
+    ASSERT_PTR_EQUALS(&items[3], s_peek_item(&heap));
+
+    /* Drain it, always getting the least loaded */
+    uint64_t prev_load = 0;
+    while ((top = s_peek_item(&heap)) != NULL) {
+        ASSERT_TRUE(top->node.load >= prev_load);
+        prev_load = top->node.load;
+        aws_least_loaded_heap_remove(&heap, &top->node);
+        ASSERT_SUCCESS(s_check_heap(&heap));
+    }
+
+    aws_least_loaded_heap_clean_up(&heap);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(least_loaded_heap_remove_test, s_least_loaded_heap_remove_fn)
@@ -328,6 +328,46 @@ TEST_CASE(headers_clear) {
     return AWS_OP_SUCCESS;
 }
 
+TEST_CASE(headers_immutable) {
+    (void)ctx;
+    struct aws_http_headers *headers = aws_http_headers_new(allocator);
+    ASSERT_NOT_NULL(headers);
+
+    const struct aws_http_header src_headers[] = {
+        s_make_header("Host", "example.com"),
+        s_make_header("Cookie", "a=1"),
+    };
+    ASSERT_SUCCESS(aws_http_headers_add_array(headers, src_headers, AWS_ARRAY_SIZE(src_headers)));
+    ASSERT_FALSE(aws_http_headers_is_immutable(headers));
+
+    aws_http_headers_set_immutable(headers);
+    ASSERT_TRUE(aws_http_headers_is_immutable(headers));
+
+    /* Every modification fails */
+    ASSERT_FAILS(aws_http_headers_add_header(headers, &src_headers[0]));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+    ASSERT_FAILS(aws_http_headers_set(headers, src_headers[0].name, src_headers[0].value));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+    ASSERT_FAILS(aws_http_headers_erase(headers, src_headers[0].name));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+    ASSERT_FAILS(aws_http_headers_erase_value(headers, src_headers[0].name, src_headers[0].value));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+    ASSERT_FAILS(aws_http_headers_erase_index(headers, 0));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+    aws_http_headers_clear(headers);
+
+    /* Nothing changed */
+    ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(src_headers), aws_http_headers_count(headers));
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(src_headers); ++i) {
+        struct aws_http_header header;
+        ASSERT_SUCCESS(aws_http_headers_get_index(headers, i, &header));
+        ASSERT_SUCCESS(s_check_headers_eq(src_headers[i], header));
+    }
+
+    aws_http_headers_release(headers);
+    return AWS_OP_SUCCESS;
+}
+
 TEST_CASE(headers_get_all) {
     (void)ctx;
 
@@ -0,0 +1,248 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/metrics_exporter.h>
+
+#include <aws/common/array_list.h>
+#include <aws/common/thread.h>
+#include <aws/http/request_response.h>
+#include <aws/http/statistics.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <string.h>
+
+/* Render the exporter and check that every expected line is present, as a whole line */
+static int s_check_render(
+    struct aws_allocator *allocator,
+    struct aws_http_metrics_exporter *exporter,
+    const char **expected_lines,
+    size_t count) {
+    struct aws_byte_buf output;
+    ASSERT_SUCCESS(aws_byte_buf_init(&output, allocator, 64));
+    ASSERT_SUCCESS(aws_http_metrics_exporter_render(exporter, &output));
+
+    struct aws_byte_cursor eof = aws_byte_cursor_from_c_str("# EOF\n");
+    ASSERT_TRUE(output.len >= eof.len);
+    ASSERT_BIN_ARRAYS_EQUALS(eof.ptr, eof.len, output.buffer + output.len - eof.len, eof.len);
+
+    /* Search for "\n<line>\n", so one line can't match the middle of another */
+    struct aws_byte_buf text;
+    ASSERT_SUCCESS(aws_byte_buf_init(&text, allocator, output.len + 2));
+    aws_byte_buf_write_u8(&text, '\n');
+    aws_byte_buf_write_from_whole_buffer(&text, output);
+    aws_byte_buf_write_u8(&text, '\0');
+
+    for (size_t i = 0; i < count; ++i) {
+        char needle[256];
+        snprintf(needle, sizeof(needle), "\n%s\n", expected_lines[i]);
+        if (strstr((const char *)text.buffer, needle) == NULL) {
+            FAIL("Missing line \"%s\" in:\n%s", expected_lines[i], (const char *)text.buffer);
+        }
+    }
+
+    aws_byte_buf_clean_up(&text);
+    aws_byte_buf_clean_up(&output);
+    return AWS_OP_SUCCESS;
+}
+
+static struct aws_http_stream_metrics s_stream_metrics(int64_t sending_duration_ns, int64_t receiving_duration_ns) {
+    struct aws_http_stream_metrics metrics = {
+        .send_start_timestamp_ns = -1,
+        .send_end_timestamp_ns = -1,
+        .sending_duration_ns = sending_duration_ns,
+        .receive_start_timestamp_ns = -1,
+        .receive_end_timestamp_ns = -1,
+        .receiving_duration_ns = receiving_duration_ns,
+        .stream_id = 1,
+    };
+    return metrics;
+}
+
+static int s_metrics_exporter_empty_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_metrics_exporter_options options;
+    AWS_ZERO_STRUCT(options);
+    struct aws_http_metrics_exporter *exporter = aws_http_metrics_exporter_new(allocator, &options);
+    ASSERT_NOT_NULL(exporter);
+
+    const char *expected[] = {
+        "# TYPE aws_http_streams counter",
+        "aws_http_streams_total 0",
+        "aws_http_connection_outgoing_stream_pending_seconds_total{protocol=\"http2\"} 0.000",
+        "# TYPE aws_http_stream_send_duration_seconds histogram",
+        "aws_http_stream_send_duration_seconds_bucket{le=\"+Inf\"} 0",
+        "aws_http_stream_send_duration_seconds_count 0",
+        "aws_http_connection_resident_bytes_count{protocol=\"websocket\"} 0",
+    };
+    ASSERT_SUCCESS(s_check_render(allocator, exporter, expected, AWS_ARRAY_SIZE(expected)));
+
+    aws_http_metrics_exporter_release(exporter);
+
+    /* Metric names can't start with a digit */
+    options.prefix = aws_byte_cursor_from_c_str("1http");
+    ASSERT_NULL(aws_http_metrics_exporter_new(allocator, &options));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(metrics_exporter_empty, s_metrics_exporter_empty_fn)
+
+static int s_metrics_exporter_records_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_metrics_exporter_options options = {
+        .prefix = aws_byte_cursor_from_c_str("my_app"),
+    };
+    struct aws_http_metrics_exporter *exporter = aws_http_metrics_exporter_new(allocator, &options);
+    ASSERT_NOT_NULL(exporter);
+
+    /* 2ms and 20ms sends, one stream that never received, one that failed */
+    struct aws_http_stream_metrics metrics = s_stream_metrics(2000000, 3000000);
+    aws_http_metrics_exporter_record_stream(exporter, &metrics, AWS_ERROR_SUCCESS);
+    metrics = s_stream_metrics(20000000, -1);
+    aws_http_metrics_exporter_record_stream(exporter, &metrics, AWS_ERROR_HTTP_CONNECTION_CLOSED);
+
+    struct aws_crt_statistics_http1_channel h1_stats = {
+        .category = AWSCRT_STAT_CAT_HTTP1_CHANNEL,
+        .pending_outgoing_stream_ms = 1500,
+        .pending_incoming_stream_ms = 250,
+        .resident_bytes = 2000,
+    };
+    struct aws_crt_statistics_http2_channel h2_stats = {
+        .category = AWSCRT_STAT_CAT_HTTP2_CHANNEL,
+        .pending_outgoing_stream_ms = 10,
+        .was_inactive = true,
+        .resident_bytes = 100 * 1024 * 1024,
+    };
+    struct aws_array_list stats_list;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&stats_list, allocator, 2, sizeof(struct aws_crt_statistics_base *)));
+    struct aws_crt_statistics_base *stats_ptr = (void *)&h1_stats;
+    ASSERT_SUCCESS(aws_array_list_push_back(&stats_list, &stats_ptr));
+    stats_ptr = (void *)&h2_stats;
+    ASSERT_SUCCESS(aws_array_list_push_back(&stats_list, &stats_ptr));
+    aws_http_metrics_exporter_on_statistics(1, &stats_list, exporter);
+    aws_array_list_clean_up(&stats_list);
+
+    const char *expected[] = {
+        "my_app_streams_total 2",
+        "my_app_stream_errors_total 1",
+        "my_app_connection_statistics_samples_total{protocol=\"http1\"} 1",
+        "my_app_connection_statistics_samples_total{protocol=\"http2\"} 1",
+        "my_app_connection_statistics_samples_total{protocol=\"websocket\"} 0",
+        "my_app_connection_outgoing_stream_pending_seconds_total{protocol=\"http1\"} 1.500",
+        "my_app_connection_incoming_stream_pending_seconds_total{protocol=\"http1\"} 0.250",
+        "my_app_connection_inactive_samples_total{protocol=\"http2\"} 1",
+        "my_app_stream_send_duration_seconds_bucket{le=\"0.001\"} 0",
+        "my_app_stream_send_duration_seconds_bucket{le=\"0.0025\"} 1",
+        "my_app_stream_send_duration_seconds_bucket{le=\"0.01\"} 1",
+        "my_app_stream_send_duration_seconds_bucket{le=\"0.025\"} 2",
+        "my_app_stream_send_duration_seconds_bucket{le=\"+Inf\"} 2",
+        "my_app_stream_send_duration_seconds_count 2",
+        "my_app_stream_send_duration_seconds_sum 0.022",
+        "my_app_stream_receive_duration_seconds_count 1",
+        "my_app_connection_resident_bytes_bucket{protocol=\"http1\",le=\"1024\"} 0",
+        "my_app_connection_resident_bytes_bucket{protocol=\"http1\",le=\"4096\"} 1",
+        "my_app_connection_resident_bytes_sum{protocol=\"http1\"} 2000",
+        "my_app_connection_resident_bytes_bucket{protocol=\"http2\",le=\"16777216\"} 0",
+        "my_app_connection_resident_bytes_bucket{protocol=\"http2\",le=\"+Inf\"} 1",
+    };
+    ASSERT_SUCCESS(s_check_render(allocator, exporter, expected, AWS_ARRAY_SIZE(expected)));
+
+    aws_http_metrics_exporter_release(exporter);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(metrics_exporter_records, s_metrics_exporter_records_fn)
+
+/* Counters and sums are 64-bit, so they don't wrap past 4 GiB even where size_t is 32-bit */
+static int s_metrics_exporter_large_values_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_metrics_exporter_options options;
+    AWS_ZERO_STRUCT(options);
+    struct aws_http_metrics_exporter *exporter = aws_http_metrics_exporter_new(allocator, &options);
+    ASSERT_NOT_NULL(exporter);
+
+    /* 3 streams that each spent 2 hours sending: 21600000000us in the sum */
+    struct aws_http_stream_metrics metrics = s_stream_metrics(INT64_C(7200000000000), -1);
+    for (size_t i = 0; i < 3; ++i) {
+        aws_http_metrics_exporter_record_stream(exporter, &metrics, AWS_ERROR_SUCCESS);
+    }
+
+    /* 2 samples that each add 2500000000ms */
+    struct aws_crt_statistics_http1_channel h1_stats = {
+        .category = AWSCRT_STAT_CAT_HTTP1_CHANNEL,
+        .pending_outgoing_stream_ms = UINT64_C(2500000000),
+    };
+    struct aws_array_list stats_list;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&stats_list, allocator, 1, sizeof(struct aws_crt_statistics_base *)));
+    struct aws_crt_statistics_base *stats_ptr = (void *)&h1_stats;
+    ASSERT_SUCCESS(aws_array_list_push_back(&stats_list, &stats_ptr));
+    aws_http_metrics_exporter_on_statistics(1, &stats_list, exporter);
+    aws_http_metrics_exporter_on_statistics(1, &stats_list, exporter);
+    aws_array_list_clean_up(&stats_list);
+
+    const char *expected[] = {
+        "aws_http_stream_send_duration_seconds_count 3",
+        "aws_http_stream_send_duration_seconds_sum 21600",
+        "aws_http_connection_outgoing_stream_pending_seconds_total{protocol=\"http1\"} 5000000.000",
+    };
+    ASSERT_SUCCESS(s_check_render(allocator, exporter, expected, AWS_ARRAY_SIZE(expected)));
+
+    aws_http_metrics_exporter_release(exporter);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(metrics_exporter_large_values, s_metrics_exporter_large_values_fn)
+
+enum {
+    RECORDING_THREAD_COUNT = 24, /* More threads than shards, so some share */
+    RECORDINGS_PER_THREAD = 10000,
+};
+
+static void s_record_streams(void *user_data) {
+    struct aws_http_metrics_exporter *exporter = user_data;
+    struct aws_http_stream_metrics metrics = s_stream_metrics(1000, -1);
+    for (size_t i = 0; i < RECORDINGS_PER_THREAD; ++i) {
+        aws_http_metrics_exporter_record_stream(exporter, &metrics, AWS_ERROR_SUCCESS);
+    }
+}
+
+/* Recording from many threads at once must not lose counts */
+static int s_metrics_exporter_multithreaded_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_metrics_exporter_options options;
+    AWS_ZERO_STRUCT(options);
+    struct aws_http_metrics_exporter *exporter = aws_http_metrics_exporter_new(allocator, &options);
+    ASSERT_NOT_NULL(exporter);
+
+    struct aws_thread threads[RECORDING_THREAD_COUNT];
+    for (size_t i = 0; i < RECORDING_THREAD_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_init(&threads[i], allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i], s_record_streams, exporter, NULL));
+    }
+    for (size_t i = 0; i < RECORDING_THREAD_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i]));
+        aws_thread_clean_up(&threads[i]);
+    }
+
+    char streams_line[64];
+    snprintf(
+        streams_line,
+        sizeof(streams_line),
+        "aws_http_streams_total %d",
+        RECORDING_THREAD_COUNT * RECORDINGS_PER_THREAD);
+    char count_line[64];
+    snprintf(
+        count_line,
+        sizeof(count_line),
+        "aws_http_stream_send_duration_seconds_count %d",
+        RECORDING_THREAD_COUNT * RECORDINGS_PER_THREAD);
+    const char *expected[] = {streams_line, count_line};
+    ASSERT_SUCCESS(s_check_render(allocator, exporter, expected, AWS_ARRAY_SIZE(expected)));
+
+    aws_http_metrics_exporter_release(exporter);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(metrics_exporter_multithreaded, s_metrics_exporter_multithreaded_fn)
@@ -0,0 +1,149 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include <aws/http/rate_limiter.h>
+
+#include <aws/http/private/rate_limiter_impl.h>
+#include <aws/testing/aws_test_harness.h>
+
+#define MS_TO_NS(ms) ((uint64_t)(ms) * 1000000)
+
+static struct aws_http_rate_limiter *s_new_limiter(
+    struct aws_allocator *allocator,
+    uint64_t bytes_per_second,
+    size_t burst_bytes) {
+
+    struct aws_http_rate_limiter_options options = {
+        .bytes_per_second = bytes_per_second,
+        .burst_bytes = burst_bytes,
+    };
+    return aws_http_rate_limiter_new(allocator, &options);
+}
+
+static int s_rate_limiter_new_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    /* bytes_per_second is required */
+    ASSERT_NULL(s_new_limiter(allocator, 0, 100));
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+
+    /* Default burst is 100ms worth, but no less than the minimum */
+    struct aws_http_rate_limiter *limiter = s_new_limiter(allocator, 10 * 1024 * 1024, 0);
+    ASSERT_NOT_NULL(limiter);
+    ASSERT_UINT_EQUALS(1024 * 1024, aws_http_rate_limiter_take(limiter, 0, 0, SIZE_MAX));
+    aws_http_rate_limiter_release(limiter);
+
+    limiter = s_new_limiter(allocator, 1000, 0);
+    ASSERT_NOT_NULL(limiter);
+    ASSERT_UINT_EQUALS(AWS_HTTP_RATE_LIMITER_MIN_DEFAULT_BURST, aws_http_rate_limiter_take(limiter, 0, 0, SIZE_MAX));
+
+    /* Holds are counted */
+    ASSERT_PTR_EQUALS(limiter, aws_http_rate_limiter_acquire(limiter));
+    ASSERT_NULL(aws_http_rate_limiter_release(limiter));
+    ASSERT_NULL(aws_http_rate_limiter_release(limiter));
+
+    /* NULL is fine */
+    ASSERT_NULL(aws_http_rate_limiter_acquire(NULL));
+    ASSERT_NULL(aws_http_rate_limiter_release(NULL));
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(rate_limiter_new_test, s_rate_limiter_new_test_fn)
+
+static int s_rate_limiter_take_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    /* 1 byte per millisecond */
+    struct aws_http_rate_limiter *limiter = s_new_limiter(allocator, 1000, 100);
+    ASSERT_NOT_NULL(limiter);
+
+    /* Bucket starts full */
+    ASSERT_UINT_EQUALS(30, aws_http_rate_limiter_take(limiter, 0, 1, 30));
+    ASSERT_UINT_EQUALS(70, aws_http_rate_limiter_take(limiter, 0, 1, 1000));
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take(limiter, 0, 1, 1000));
+
+    /* Refills with time, and fractions of a token aren't lost between refills */
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take(limiter, MS_TO_NS(10), 20, 1000));
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take(limiter, MS_TO_NS(10) + 500000, 20, 1000));
+    ASSERT_UINT_EQUALS(20, aws_http_rate_limiter_take(limiter, MS_TO_NS(20), 20, 1000));
+
+    /* Never refills past the burst size */
+    ASSERT_UINT_EQUALS(100, aws_http_rate_limiter_take(limiter, MS_TO_NS(10000), 1, 1000));
+
+    /* Min is capped at the burst size, so it can be satisfied */
+    ASSERT_UINT_EQUALS(100, aws_http_rate_limiter_take(limiter, MS_TO_NS(20000), 5000, 5000));
+
+    /* A clock that's behind what the limiter saw doesn't add or remove tokens */
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take(limiter, MS_TO_NS(19000), 1, 1000));
+
+    /* Tokens given back can be taken again, up to the burst size */
+    aws_http_rate_limiter_give_back(limiter, 40);
+    aws_http_rate_limiter_give_back(limiter, 1000);
+    ASSERT_UINT_EQUALS(100, aws_http_rate_limiter_take(limiter, MS_TO_NS(20000), 1, 1000));
+
+    aws_http_rate_limiter_release(limiter);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(rate_limiter_take_test, s_rate_limiter_take_test_fn)
+
+static int s_rate_limiter_time_until_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    /* 1 byte per millisecond */
+    struct aws_http_rate_limiter *limiter = s_new_limiter(allocator, 1000, 100);
+    ASSERT_NOT_NULL(limiter);
+
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_time_until(limiter, 0, 100));
+    ASSERT_UINT_EQUALS(100, aws_http_rate_limiter_take(limiter, 0, 1, 100));
+
+    ASSERT_UINT_EQUALS(MS_TO_NS(10), aws_http_rate_limiter_time_until(limiter, 0, 10));
+
+    /* Part of the next token has already accrued */
+    ASSERT_UINT_EQUALS(MS_TO_NS(10) - 500000, aws_http_rate_limiter_time_until(limiter, 500000, 10));
+
+    /* Capped at the burst size */
+    ASSERT_UINT_EQUALS(MS_TO_NS(100), aws_http_rate_limiter_time_until(limiter, 0, 5000));
+
+    /* And it's right */
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take(limiter, MS_TO_NS(10) - 1, 10, 10));
+    ASSERT_UINT_EQUALS(10, aws_http_rate_limiter_take(limiter, MS_TO_NS(10), 10, 10));
+
+    aws_http_rate_limiter_release(limiter);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(rate_limiter_time_until_test, s_rate_limiter_time_until_test_fn)
+
+/* Taking from two limiters at once only takes what both allow */
+static int s_rate_limiter_take_both_test_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_http_rate_limiter *a = s_new_limiter(allocator, 1000, 100);
+    ASSERT_NOT_NULL(a);
+    struct aws_http_rate_limiter *b = s_new_limiter(allocator, 1000, 30);
+    ASSERT_NOT_NULL(b);
+
+    /* No limiters, no limit */
+    ASSERT_UINT_EQUALS(5000, aws_http_rate_limiter_take_both(NULL, NULL, 0, 1, 5000));
+
+    /* The stricter one wins, and the other gets its excess back */
+    ASSERT_UINT_EQUALS(30, aws_http_rate_limiter_take_both(a, b, 0, 1, 5000));
+    ASSERT_UINT_EQUALS(70, aws_http_rate_limiter_take(a, 0, 1, 5000));
+    aws_http_rate_limiter_give_back_both(a, b, 20);
+    ASSERT_UINT_EQUALS(20, aws_http_rate_limiter_take_both(a, NULL, 0, 1, 5000));
+
+    /* If either can't meet the min, neither gives anything */
+    ASSERT_UINT_EQUALS(20, aws_http_rate_limiter_take(b, 0, 1, 5000));
+    aws_http_rate_limiter_give_back(a, 100);
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_take_both(a, b, 0, 10, 5000));
+
+    /* Wait for whichever takes longer */
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_time_until(a, 0, 10));
+    ASSERT_UINT_EQUALS(MS_TO_NS(10), aws_http_rate_limiter_time_until_both(a, b, 0, 10));
+    ASSERT_UINT_EQUALS(0, aws_http_rate_limiter_time_until_both(NULL, NULL, 0, 10));
+
+    aws_http_rate_limiter_release(a);
+    aws_http_rate_limiter_release(b);
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(rate_limiter_take_both_test, s_rate_limiter_take_both_test_fn)
@@ -15,6 +15,7 @@
 #include <aws/http/private/h1_stream.h>
 #include <aws/http/private/h2_connection.h>
 #include <aws/http/private/http2_stream_manager_impl.h>
+#include <aws/http/private/http2_stream_manager_system_vtable.h>
 #include <aws/http/private/proxy_impl.h>
 #include <aws/http/proxy.h>
 #include <aws/http/statistics.h>
@@ -55,6 +56,7 @@ struct sm_tester_options {
     bool close_connection_on_server_error;
     size_t connection_ping_period_ms;
     size_t connection_ping_timeout_ms;
+    const struct aws_http_concurrency_limit_options *concurrency_limit_options;
 };
 
 static struct aws_logger s_logger;
@@ -290,6 +292,7 @@ static int s_tester_init(struct sm_tester_options *options) {
         .connection_ping_period_ms = options->connection_ping_period_ms,
         .connection_ping_timeout_ms = options->connection_ping_timeout_ms,
         .http2_prior_knowledge = options->prior_knowledge,
+        .concurrency_limit_options = options->concurrency_limit_options,
     };
     s_tester.stream_manager = aws_http2_stream_manager_new(alloc, &sm_options);
 
@@ -931,6 +934,98 @@ TEST_CASE(h2_sm_mock_fetch_metric) {
     return s_tester_clean_up();
 }
 
+/* Test that acquisitions past the concurrency limit wait for a stream to complete */
+TEST_CASE(h2_sm_mock_concurrency_limit) {
+    (void)ctx;
+    /* Pin the limit at 2, so the samples can't move it */
+    struct aws_http_concurrency_limit_options limit_options = {
+        .initial_limit = 2,
+        .max_limit = 2,
+    };
+    struct sm_tester_options options = {
+        .max_connections = 5,
+        .alloc = allocator,
+        .concurrency_limit_options = &limit_options,
+    };
+    ASSERT_SUCCESS(s_tester_init(&options));
+    s_override_cm_connect_function(s_aws_http_connection_manager_create_connection_sync_mock);
+    ASSERT_SUCCESS(s_sm_stream_acquiring(3));
+    ASSERT_SUCCESS(s_wait_on_fake_connection_count(1));
+    s_drain_all_fake_connection_testing_channel();
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(2));
+    ASSERT_INT_EQUALS(2, aws_array_list_length(&s_tester.streams));
+    /* The acquisition held back by the limit doesn't ask for a connection of its own */
+    ASSERT_INT_EQUALS(1, aws_array_list_length(&s_tester.fake_connections));
+
+    struct aws_http_manager_metrics out_metrics;
+    AWS_ZERO_STRUCT(out_metrics);
+    aws_http2_stream_manager_fetch_metrics(s_tester.stream_manager, &out_metrics);
+    ASSERT_UINT_EQUALS(out_metrics.concurrency_limit, 2);
+    ASSERT_UINT_EQUALS(out_metrics.leased_concurrency, 2);
+    ASSERT_UINT_EQUALS(out_metrics.pending_concurrency_acquires, 1);
+
+    /* Completing a stream makes room for the waiting acquisition */
+    struct sm_fake_connection *fake_connection = s_get_fake_connection(0);
+    s_fake_connection_complete_streams(fake_connection, 1);
+    s_drain_all_fake_connection_testing_channel();
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(3));
+    ASSERT_INT_EQUALS(0, s_tester.acquiring_stream_errors);
+    ASSERT_INT_EQUALS(1, aws_array_list_length(&s_tester.fake_connections));
+    aws_http2_stream_manager_fetch_metrics(s_tester.stream_manager, &out_metrics);
+    ASSERT_UINT_EQUALS(out_metrics.leased_concurrency, 2);
+    ASSERT_UINT_EQUALS(out_metrics.pending_concurrency_acquires, 0);
+
+    ASSERT_SUCCESS(s_complete_all_fake_connection_streams());
+
+    return s_tester_clean_up();
+}
+
+/* Test that with fail_fast, acquisitions past the concurrency limit fail asynchronously instead of waiting */
+TEST_CASE(h2_sm_mock_concurrency_limit_fail_fast) {
+    (void)ctx;
+    struct aws_http_concurrency_limit_options limit_options = {
+        .initial_limit = 1,
+        .max_limit = 1,
+        .fail_fast = true,
+    };
+    struct sm_tester_options options = {
+        .max_connections = 5,
+        .alloc = allocator,
+        .concurrency_limit_options = &limit_options,
+    };
+    ASSERT_SUCCESS(s_tester_init(&options));
+    s_override_cm_connect_function(s_aws_http_connection_manager_create_connection_sync_mock);
+    ASSERT_SUCCESS(s_sm_stream_acquiring(1));
+    ASSERT_SUCCESS(s_wait_on_fake_connection_count(1));
+    s_drain_all_fake_connection_testing_channel();
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(1));
+
+    /* The rejection is delivered from an event loop */
+    ASSERT_SUCCESS(s_sm_stream_acquiring(1));
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(2));
+    ASSERT_INT_EQUALS(1, s_tester.acquiring_stream_errors);
+    ASSERT_INT_EQUALS(AWS_ERROR_HTTP_CONCURRENCY_LIMIT_EXCEEDED, s_tester.error_code);
+
+    struct aws_http_manager_metrics out_metrics;
+    AWS_ZERO_STRUCT(out_metrics);
+    aws_http2_stream_manager_fetch_metrics(s_tester.stream_manager, &out_metrics);
+    ASSERT_UINT_EQUALS(out_metrics.leased_concurrency, 1);
+    ASSERT_UINT_EQUALS(out_metrics.pending_concurrency_acquires, 0);
+
+    /* Once the stream completes there's room again */
+    ASSERT_SUCCESS(s_complete_all_fake_connection_streams());
+    ASSERT_SUCCESS(s_sm_stream_acquiring(1));
+    s_drain_all_fake_connection_testing_channel();
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(3));
+    ASSERT_INT_EQUALS(1, s_tester.acquiring_stream_errors);
+    ASSERT_INT_EQUALS(2, aws_array_list_length(&s_tester.streams));
+    ASSERT_INT_EQUALS(1, aws_array_list_length(&s_tester.fake_connections));
+
+    ASSERT_SUCCESS(s_complete_all_fake_connection_streams());
+
+    return s_tester_clean_up();
+}
+
 /* Test that the stream completed will free the connection for more streams */
 TEST_CASE(h2_sm_mock_complete_stream) {
     (void)ctx;
@@ -1120,6 +1215,51 @@ TEST_CASE(h2_sm_mock_goaway) {
     return s_tester_clean_up();
 }
 
+static struct aws_http2_stream_manager_system_vtable s_sm_mocks;
+static size_t s_sm_mock_make_request_count;
+
+static struct aws_http_stream *s_sm_mock_make_request(
+    struct aws_http_connection *client_connection,
+    const struct aws_http_make_request_options *options) {
+    ++s_sm_mock_make_request_count;
+    return aws_http_connection_make_request(client_connection, options);
+}
+
+static void s_sm_mock_get_remote_settings(
+    const struct aws_http_connection *http2_connection,
+    struct aws_http2_setting out_settings[AWS_HTTP2_SETTINGS_COUNT]) {
+    aws_http2_connection_get_remote_settings(http2_connection, out_settings);
+    out_settings[AWS_HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS - 1].value = 2;
+}
+
+/* Test that the stream manager reaches its connections through the system vtable */
+TEST_CASE(h2_sm_mock_system_vtable) {
+    (void)ctx;
+    struct sm_tester_options options = {
+        .max_connections = 5,
+        .alloc = allocator,
+    };
+    ASSERT_SUCCESS(s_tester_init(&options));
+    s_override_cm_connect_function(s_aws_http_connection_manager_create_connection_sync_mock);
+    s_sm_mocks = *g_aws_http2_stream_manager_default_system_vtable_ptr;
+    s_sm_mocks.aws_http_connection_make_request = s_sm_mock_make_request;
+    s_sm_mocks.aws_http2_connection_get_remote_settings = s_sm_mock_get_remote_settings;
+    aws_http2_stream_manager_set_system_vtable(s_tester.stream_manager, &s_sm_mocks);
+    s_sm_mock_make_request_count = 0;
+
+    ASSERT_SUCCESS(s_sm_stream_acquiring(4));
+    /* The peer allows 100 streams, but the mocked settings only allow 2 per connection */
+    ASSERT_SUCCESS(s_wait_on_fake_connection_count(2));
+    s_drain_all_fake_connection_testing_channel();
+    ASSERT_SUCCESS(s_wait_on_streams_acquired_count(4));
+    ASSERT_INT_EQUALS(0, s_tester.acquiring_stream_errors);
+    ASSERT_UINT_EQUALS(2, aws_array_list_length(&s_tester.fake_connections));
+    ASSERT_UINT_EQUALS(4, s_sm_mock_make_request_count);
+    ASSERT_SUCCESS(s_complete_all_fake_connection_streams());
+
+    return s_tester_clean_up();
+}
+
 /* Test that PING works as expected. */
 TEST_CASE(h2_sm_connection_ping) {
     (void)ctx;
@@ -7,6 +7,7 @@
 
 #include <aws/http/private/websocket_decoder.h>
 #include <aws/http/private/websocket_encoder.h>
+#include <aws/http/statistics.h>
 #include <aws/io/logging.h>
 #include <aws/testing/io_testing_channel.h>
 
@@ -39,6 +40,7 @@ struct incoming_frame {
 
 static struct tester_options {
     bool manual_window_update;
+    uint64_t idle_trim_ms;
 } s_tester_options;
 
 struct tester {
@@ -487,6 +489,7 @@ static int s_tester_init(struct tester *tester, struct aws_allocator *alloc) {
         .on_incoming_frame_payload = s_on_incoming_frame_payload,
         .on_incoming_frame_complete = s_on_incoming_frame_complete,
         .manual_window_update = s_tester_options.manual_window_update,
+        .idle_trim_ms = s_tester_options.idle_trim_ms,
     };
     tester->websocket = aws_websocket_handler_new(&ws_options);
     ASSERT_NOT_NULL(tester->websocket);
@@ -1848,6 +1851,111 @@ TEST_CASE(websocket_handler_sends_pong_automatically) {
     return AWS_OP_SUCCESS;
 }
 
+/* Gather the websocket's statistics, the way a channel's statistics handler would.
+ * Returns a pointer to the websocket's own statistics, which stays valid until the websocket is destroyed. */
+static int s_gather_statistics(struct tester *tester, struct aws_crt_statistics_websocket_channel **out_stats) {
+    struct aws_array_list stats_list;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&stats_list, tester->alloc, 1, sizeof(void *)));
+
+    struct aws_channel_slot *websocket_slot = aws_channel_get_first_slot(tester->testing_channel.channel)->adj_right;
+    struct aws_channel_handler *handler = websocket_slot->handler;
+    handler->vtable->gather_statistics(handler, &stats_list);
+    ASSERT_UINT_EQUALS(1, aws_array_list_length(&stats_list));
+
+    ASSERT_SUCCESS(aws_array_list_get_at(&stats_list, out_stats, 0));
+    ASSERT_INT_EQUALS(AWSCRT_STAT_CAT_WEBSOCKET_CHANNEL, (*out_stats)->category);
+
+    aws_array_list_clean_up(&stats_list);
+    return AWS_OP_SUCCESS;
+}
+
+/* Read a PING, and check that the PONG written in response echoes its payload */
+static int s_read_ping_check_pong(struct tester *tester, struct aws_byte_cursor payload) {
+    struct readpush_frame read_ping = {
+        .def =
+            {
+                .opcode = AWS_WEBSOCKET_OPCODE_PING,
+                .fin = true,
+            },
+        .payload = payload,
+    };
+    s_set_readpush_frames(tester, &read_ping, 1);
+    ASSERT_SUCCESS(s_do_readpush_all(tester));
+
+    size_t prev_num_written_frames = tester->num_written_frames;
+    ASSERT_SUCCESS(s_drain_written_messages(tester));
+    ASSERT_UINT_EQUALS(prev_num_written_frames + 1, tester->num_written_frames);
+    const struct written_frame *written_frame = &tester->written_frames[prev_num_written_frames];
+    ASSERT_UINT_EQUALS(AWS_WEBSOCKET_OPCODE_PONG, written_frame->def.opcode);
+    ASSERT_TRUE(written_frame->is_complete);
+    ASSERT_BIN_ARRAYS_EQUALS(payload.ptr, payload.len, written_frame->payload.buffer, written_frame->payload.len);
+    return AWS_OP_SUCCESS;
+}
+
+TEST_CASE(websocket_handler_gather_statistics) {
+    (void)ctx;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    struct aws_crt_statistics_websocket_channel *stats = NULL;
+    ASSERT_SUCCESS(s_gather_statistics(&tester, &stats));
+    const uint64_t initial_resident_bytes = stats->resident_bytes;
+    ASSERT_TRUE(initial_resident_bytes > 0);
+
+    /* The PING payload is kept around to echo in the PONG, so it counts */
+    uint8_t payload[100];
+    memset(payload, 'p', sizeof(payload));
+    ASSERT_SUCCESS(s_read_ping_check_pong(&tester, aws_byte_cursor_from_array(payload, sizeof(payload))));
+    ASSERT_SUCCESS(s_gather_statistics(&tester, &stats));
+    ASSERT_TRUE(stats->resident_bytes >= initial_resident_bytes + sizeof(payload));
+
+    struct aws_channel_slot *websocket_slot = aws_channel_get_first_slot(tester.testing_channel.channel)->adj_right;
+    websocket_slot->handler->vtable->reset_statistics(websocket_slot->handler);
+    ASSERT_UINT_EQUALS(0, stats->resident_bytes);
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
+/* The idle trim task only trims after a whole period without traffic, so it can take up to 2 periods */
+static int s_wait_for_idle_trim(struct tester *tester, uint64_t untrimmed_bytes) {
+    struct aws_crt_statistics_websocket_channel *stats = NULL;
+    ASSERT_SUCCESS(s_gather_statistics(tester, &stats));
+    for (size_t i = 0; i < 200 && stats->resident_bytes >= untrimmed_bytes; ++i) {
+        aws_thread_current_sleep(aws_timestamp_convert(10, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL));
+        testing_channel_drain_queued_tasks(&tester->testing_channel);
+        ASSERT_SUCCESS(s_gather_statistics(tester, &stats));
+    }
+    ASSERT_TRUE(stats->resident_bytes < untrimmed_bytes);
+    return AWS_OP_SUCCESS;
+}
+
+/* An idle websocket releases its PING payload buffer, and re-grows it for the next PING */
+TEST_CASE(websocket_handler_idle_trim) {
+    (void)ctx;
+    /* Long enough that the websocket can't go idle while a frame is being processed */
+    s_tester_options.idle_trim_ms = 50;
+    struct tester tester;
+    ASSERT_SUCCESS(s_tester_init(&tester, allocator));
+
+    uint8_t payload[100];
+    memset(payload, 'p', sizeof(payload));
+    ASSERT_SUCCESS(s_read_ping_check_pong(&tester, aws_byte_cursor_from_array(payload, sizeof(payload))));
+
+    struct aws_crt_statistics_websocket_channel *stats = NULL;
+    ASSERT_SUCCESS(s_gather_statistics(&tester, &stats));
+    const uint64_t untrimmed_bytes = stats->resident_bytes;
+    ASSERT_SUCCESS(s_wait_for_idle_trim(&tester, untrimmed_bytes));
+    ASSERT_TRUE(untrimmed_bytes - stats->resident_bytes >= sizeof(payload));
+
+    /* The next PING is still echoed correctly */
+    memset(payload, 'q', sizeof(payload));
+    ASSERT_SUCCESS(s_read_ping_check_pong(&tester, aws_byte_cursor_from_array(payload, sizeof(payload))));
+
+    ASSERT_SUCCESS(s_tester_clean_up(&tester));
+    return AWS_OP_SUCCESS;
+}
+
 TEST_CASE(websocket_handler_wont_send_pong_after_close_frame) {
     (void)ctx;
     struct tester tester;